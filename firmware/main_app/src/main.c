@@ -13,12 +13,12 @@
  * program, see LICENSE.md file for more details.
  * This program is distributed WITHOUT ANY WARRANTY.
  */
+#include "types.h"
+#include "nsc.h"
+#include "trace.h"
 
 #define USART3 0x40004800
 
-typedef unsigned long  u32;
-typedef unsigned char  u8;
-
 void uart_putc(u8 c);
 void uart_puts(char *s);
 inline u32  reg_rd(u32 reg);
@@ -27,7 +27,13 @@ inline void reg_wr(u32 addr, u32 value);
 int main(void)
 {
 	volatile unsigned long v;
+	u8 nonce[16];
+	int result;
 
+	trace_mark(TRACE_ID_APP_START, 0);
+	// Random bytes from the entropy pool of the secure firmware (1 : empty)
+	result = nsc_random(nonce, sizeof(nonce));
+	trace_mark(TRACE_ID_APP_NONCE, result ? 1 : 0);
 	v = *(volatile unsigned long *)0xE000ED00;
 	(void)v;
 	v = *(volatile unsigned long *)0xE002ED00;
@@ -37,7 +43,14 @@ int main(void)
 
 	uart_puts("Hello World from non-secure app !\r\n");
 
-	while(1);
+	// Services of the secure firmware (frames, network, doors) are run by
+	// this loop once the application is started, then STOP until the next
+	// event when nothing is left to do
+	while(1)
+	{
+		nsc_poll();
+		nsc_idle();
+	}
 	return(0);
 }
 
@@ -43,7 +43,7 @@ __isr_vector:
     .long   BusFault_Handler            /* Pre-fetch or memory access fault   */
     .long   Usage_Fault                 /* Undefined instruction              */
     .long   SecureFault_Handler         /* Secure Fault                       */
-    .long   0                           /* Reserved                           */
+    .long   0                           /* Reserved (image size, see signer)  */
     .long   0                           /* Reserved                           */
     .long   0                           /* Reserved                           */
     .long   SVC_Handler                 /* SVCall Handler                     */
@@ -0,0 +1,1165 @@
+/**
+ * @file  apb.c
+ * @brief Anti-passback and occupancy tracking of credentials
+ *
+ * The area (zone) where each credential has been granted is kept into an
+ * open addressing hash table of fixed size (Robin Hood, linear probing).
+ * Credentials are mixed by an invertible function : the top APB_BITS of
+ * the result give the home slot, only the remaining bits are stored. A
+ * slot holds a 16 bits key (remainder, timer flag) and a dirty bit into
+ * SRAM3, a byte (probe distance, area) into SRAM1 : the 2^17 slots of the
+ * table take 400 kB for the largest credential store (about 80k), split so
+ * that both regions keep room for the other modules (see
+ * doc/anti_passback.md). Lookup stops on the first slot
+ * nearer to its home than the probe, insertion and removal (backward
+ * shift) move entries by one slot : all are O(1) at the loads used.
+ * A credential that is no longer into an area is removed from the table,
+ * which only holds the credentials currently tracked.
+ *
+ * Timed anti-passback uses a timer wheel : a timer is armed when a
+ * credential enters an area with a timeout, and fires one tick after the
+ * timeout. When the credential has been granted again meanwhile (dirty
+ * flag), the timer is armed again for the new area instead of releasing
+ * the credential.
+ *
+ * Each change is queued then written into a checkpoint log, in flash. The
+ * log uses the last sectors of the inactive bank (no stall of the code
+ * fetches while writing) split in two halves : when the active half is
+ * full, the other one is erased and receives a full checkpoint of the
+ * table, the changes continue after it. At boot, the half with the newest
+ * header is replayed to rebuild the table. See doc/anti_passback.md.
+ *
+ * These functions are called from the main loop only.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "apb.h"
+#include "cred.h"
+#include "driver/flash.h"
+#include "hardware.h"
+#include "log.h"
+#include "systime.h"
+
+#if (APB_REM_BITS != 15)
+#error "Entries of checkpoint records hold a remainder of 15 bits"
+#endif
+// Densest store (card numbers, 1.2 bytes per credential, see credentials.md)
+#if (APB_SNAP_MAX < ((CRED_BLK_MAX * CRED_BLK_SIZE * 5) / 6))
+#error "A checkpoint does not hold the largest credential store"
+#endif
+
+#define SLOT_MASK (APB_SLOTS - 1)
+#define REM_MASK  ((1u << APB_REM_BITS) - 1)
+/* Key : remainder and timer flag */
+#define KEY_TIMER (1u << 15)
+/* Meta : probe distance (bits 0-4) and area (bits 5-7) */
+#define META_DIST  0x1F
+#define META_EMPTY 0xFF
+#define DIST(m)    ((uint)(m) & META_DIST)
+#define ZONE(m)    ((uint)(m) >> 5)
+/* Checkpoint entries (see apb.h) */
+#define SNAP_LANES 5
+#define SNAP_DELTA 63
+#define SNAP_NONE  0xFFFFFF
+
+#define NIL 0xFFFF
+
+/* States of the checkpoint log */
+#define LOG_IDLE  0 /* Changes appended to the active half       */
+#define LOG_ERASE 1 /* Erase of the other half (one sector/poll) */
+#define LOG_SNAP  2 /* Copy of the table into the other half     */
+#define LOG_OFF   3 /* Stopped (flash error, or after handover)  */
+
+static u32  _mix(u32 x);
+static u32  _unmix(u32 x);
+static int  _find(u32 h);
+static int  _insert(u32 h, uint zone);
+static void _delete(uint slot);
+static u32  _cred(uint slot);
+static void _moved(uint from, uint to);
+static void _apply(u32 cred, uint zone);
+static void _reset(void);
+static int  _arm(u32 cred, u32 ticks);
+static void _bucket(uint b);
+static void _expire(u32 cred);
+static void _queue(u32 cred, uint zone);
+static void _log_step(void);
+static void _snap_begin(void);
+static int  _snap_step(uint count);
+static int  _snap_put(u32 entry);
+static void _snap_set(u32 entry);
+static int  _snap_flush(void);
+static void _lane(u32 cred, uint zone);
+static int  _lane_flush(u32 addr);
+static int  _header(u32 addr, u32 seq);
+static int  _erase(u32 addr);
+static int  _write(u32 addr, const u32 *qw);
+static void _replay(void);
+static void _replay_snap(const u32 *w, u32 *home);
+static u32  _addr(u32 addr);
+
+/**
+ * @brief Timer of the wheel
+ */
+typedef struct apb_timer
+{
+	u32 cred;
+	u16 next;
+	u16 rounds; // Turns of the wheel before the timer fires
+} apb_timer;
+
+apb_stats apb_stat;
+
+static u16 keys[APB_SLOTS] __attribute__((section(APB_SECT), aligned(8)));
+static u8  meta[APB_SLOTS];
+// Granted again while a timer is pending, next to the keys (SRAM3)
+static u32 dirty[APB_SLOTS / 32] __attribute__((section(APB_SECT), aligned(4)));
+static u32 occupancy[APB_ZONES];
+static u32 live;
+static u32 zone_ticks[APB_ZONES];
+
+static apb_timer timers[APB_TIMERS];
+static u16 wheel[APB_WHEEL];
+static u16 timer_free;
+static u32 wheel_now;
+
+static struct
+{
+	u32 cred[APB_QUEUE];
+	u8  zone[APB_QUEUE];
+	u32 rd, wr;
+} queue;
+
+static struct
+{
+	u32  base;    // Address of the log area
+	u32  seq;     // Sequence of the active half
+	u32  wr;      // Offset of the next record into the active half
+	u32  cursor;  // Sector (erase) or slot (checkpoint)
+	u32  snap_wr; // Offset of the next record into the checkpoint
+	u32  home;    // Home slot of the last checkpoint entry
+	u32  lane[4]; // Record being filled
+	uint lanes;
+	uint half;    // Active half
+	uint state;
+	uint resync;  // A full checkpoint is needed (lost changes, clear)
+	uint full;    // Last checkpoint was too large, changes not saved
+} ckpt;
+
+/**
+ * @brief Initialize the table and rebuild it from the checkpoint log
+ *
+ */
+void apb_init(void)
+{
+	uint i;
+
+	apb_stat.grants   = 0;
+	apb_stat.full     = 0;
+	apb_stat.expired  = 0;
+	apb_stat.no_timer = 0;
+	apb_stat.records  = 0;
+	apb_stat.replayed = 0;
+	apb_stat.checkpoints = 0;
+	apb_stat.overflow  = 0;
+	apb_stat.flash_err = 0;
+	for (i = 0; i < APB_ZONES; i++)
+		zone_ticks[i] = 0;
+	_reset();
+	wheel_now = (u32)(systime_ticks() >> APB_TICK_SHIFT);
+
+#ifdef RUN_SEC
+	// Log sectors are secure into both banks (block-based security)
+	for (i = (APB_LOG_OFFSET / FLASH_SECT_SIZE); i < (FLASH_BANK_SIZE / FLASH_SECT_SIZE); i++)
+	{
+		reg_set(FLASH_SECBB1R1(FLASH) + (4 * (i / 32)), (1u << (i % 32)));
+		reg_set(FLASH_SECBB2R1(FLASH) + (4 * (i / 32)), (1u << (i % 32)));
+	}
+#endif
+	ckpt.base  = _addr(flash_inactive(APB_LOG_OFFSET));
+	ckpt.state = LOG_IDLE;
+	ckpt.full  = 0;
+	_replay();
+	log_print(0, " * APB: %u credentials restored (%u changes)\n",
+	          live, apb_stat.replayed);
+}
+
+/**
+ * @brief Forget all credentials (global forgiveness)
+ *
+ * Timers are cancelled. The empty table is saved by a new checkpoint.
+ */
+void apb_clear(void)
+{
+	_reset();
+	ckpt.resync = 1;
+}
+
+/**
+ * @brief Set the timeout of an area (timed anti-passback)
+ *
+ * A credential is released (free) when it stays into the area longer than
+ * the timeout. When a timeout is set to an area that had none, timers are
+ * armed for the credentials already there.
+ *
+ * @param zone    Area number (0 to APB_ZONES - 1)
+ * @param seconds Timeout in seconds (up to 65535), 0 to keep credentials
+ */
+void apb_timeout(uint zone, uint seconds)
+{
+	u32  prev;
+	uint i;
+
+	if (zone >= APB_ZONES)
+		return;
+	if (seconds > 0xFFFF)
+		seconds = 0xFFFF;
+	prev = zone_ticks[zone];
+	// 2^25 cycles of the 32 MHz timer per tick : 62500 / 65536 tick per second
+	zone_ticks[zone] = ((u32)seconds * 62500) >> 16;
+	if (seconds && (zone_ticks[zone] == 0))
+		zone_ticks[zone] = 1;
+	if (prev || (zone_ticks[zone] == 0))
+		return;
+
+	for (i = 0; i < APB_SLOTS; i++)
+	{
+		if ((meta[i] == META_EMPTY) || (ZONE(meta[i]) != zone))
+			continue;
+		if (keys[i] & KEY_TIMER)
+			continue;
+		if (_arm(_cred(i), zone_ticks[zone]) == 0)
+			keys[i] |= KEY_TIMER;
+	}
+}
+
+/**
+ * @brief Record that a credential has been granted into an area
+ *
+ * @param cred Credential identifier (not 0)
+ * @param zone Area entered (0 to APB_ZONES - 1)
+ * @return integer APB_OK on success, APB_FULL if the table is full
+ */
+HOT_FCT int apb_grant(u32 cred, uint zone)
+{
+	u32  h;
+	uint old;
+	int  slot;
+
+	if ((cred == 0) || (zone >= APB_ZONES))
+		return(APB_ERR);
+	apb_stat.grants++;
+
+	h = _mix(cred);
+	slot = _find(h);
+	if (slot < 0)
+	{
+		slot = _insert(h, zone);
+		if (slot < 0)
+		{
+			apb_stat.full++;
+			return(APB_FULL);
+		}
+		occupancy[zone]++;
+		live++;
+		if (zone_ticks[zone] && (_arm(cred, zone_ticks[zone]) == 0))
+			keys[slot] |= KEY_TIMER;
+		_queue(cred, zone);
+		return(APB_OK);
+	}
+
+	old = ZONE(meta[slot]);
+	if (keys[slot] & KEY_TIMER)
+		dirty[slot >> 5] |= (1u << (slot & 31));
+	else if (zone_ticks[zone] && (_arm(cred, zone_ticks[zone]) == 0))
+		keys[slot] |= KEY_TIMER;
+	if (old == zone)
+		return(APB_OK);
+	occupancy[old]--;
+	occupancy[zone]++;
+	meta[slot] = (u8)((meta[slot] & META_DIST) | (zone << 5));
+	_queue(cred, zone);
+	return(APB_OK);
+}
+
+/**
+ * @brief Get the area of a credential
+ *
+ * @param cred Credential identifier
+ * @return uint Area number, APB_FREE if the credential is not tracked
+ */
+HOT_FCT uint apb_zone(u32 cred)
+{
+	int slot;
+
+	slot = _find(_mix(cred));
+	if (slot < 0)
+		return(APB_FREE);
+	return ZONE(meta[slot]);
+}
+
+/**
+ * @brief Check the anti-passback rule before a credential enters an area
+ *
+ * @param cred Credential identifier
+ * @param zone Area to enter
+ * @return integer Zero if allowed, -1 if the credential is already there
+ */
+HOT_FCT int apb_check(u32 cred, uint zone)
+{
+	return (apb_zone(cred) == zone) ? -1 : 0;
+}
+
+/**
+ * @brief Get the number of credentials into an area
+ *
+ * @param zone Area number
+ * @return u32 Number of credentials
+ */
+u32 apb_occupancy(uint zone)
+{
+	if (zone >= APB_ZONES)
+		return(0);
+	return(occupancy[zone]);
+}
+
+/**
+ * @brief Get the number of credentials tracked (all areas)
+ *
+ * @return u32 Number of credentials
+ */
+u32 apb_count(void)
+{
+	return(live);
+}
+
+/**
+ * @brief Process expired timers and write pending changes into the log
+ *
+ */
+void apb_poll(void)
+{
+	u32  now;
+	uint n;
+
+	now = (u32)(systime_ticks() >> APB_TICK_SHIFT);
+	for (n = 0; (wheel_now != now) && (n < APB_POLL_TICKS); n++)
+	{
+		wheel_now++;
+		_bucket(wheel_now & (APB_WHEEL - 1));
+	}
+	_log_step();
+}
+
+/**
+ * @brief Save the table for the firmware of the other bank (before a swap)
+ *
+ * After a bank swap the log is read from the bank that runs now : its log
+ * area is erased and receives a full checkpoint. The log is then stopped
+ * until reset. This takes some time and stalls the code fetches.
+ */
+void apb_handover(void)
+{
+	uint i;
+
+	ckpt.base = _addr(FLASH_BASE_NS + APB_LOG_OFFSET);
+	for (i = 0; i < APB_LOG_SECTS; i++)
+	{
+		if (_erase(ckpt.base + (i * FLASH_SECT_SIZE)) < 0)
+			return;
+	}
+	ckpt.half = 1;
+	_snap_begin();
+	while (_snap_step(APB_SLOTS) == 0)
+		;
+	if (ckpt.state == LOG_SNAP)
+		_header(ckpt.base, ckpt.seq + 1);
+	ckpt.state = LOG_OFF;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Mix the bits of a credential (invertible)
+ *
+ * @param x Credential identifier
+ * @return u32 Hash
+ */
+static inline u32 _mix(u32 x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352D;
+	x ^= x >> 15;
+	x *= 0x846CA68B;
+	x ^= x >> 16;
+	return(x);
+}
+
+/**
+ * @brief Get back a credential from its hash (inverse of _mix)
+ *
+ * @param x Hash
+ * @return u32 Credential identifier
+ */
+static u32 _unmix(u32 x)
+{
+	x ^= x >> 16;
+	x *= 0x43021123;
+	x ^= (x >> 15) ^ (x >> 30);
+	x *= 0x1D69E2A5;
+	x ^= x >> 16;
+	return(x);
+}
+
+/**
+ * @brief Search the slot of a credential
+ *
+ * @param h Hash of the credential
+ * @return integer Slot number, -1 if not found
+ */
+static inline int _find(u32 h)
+{
+	uint home = (uint)(h >> APB_REM_BITS);
+	uint rem  = (uint)(h & REM_MASK);
+	uint d, s;
+
+	for (d = 0; d <= APB_DIST_MAX; d++)
+	{
+		s = (home + d) & SLOT_MASK;
+		// An empty slot has the largest distance : test it first
+		if ((meta[s] == META_EMPTY) || (DIST(meta[s]) < d))
+			return(-1);
+		if ((DIST(meta[s]) == d) && ((keys[s] & REM_MASK) == rem))
+			return (int)s;
+	}
+	return(-1);
+}
+
+/**
+ * @brief Insert a credential (not already into the table)
+ *
+ * The new entry takes the place of the first entry nearer to its home,
+ * the following entries are shifted by one slot up to the next empty one.
+ * Nothing is changed when an entry would go beyond APB_DIST_MAX.
+ *
+ * @param h    Hash of the credential
+ * @param zone Area
+ * @return integer Slot of the new entry, -1 if the table is full
+ */
+static int _insert(u32 h, uint zone)
+{
+	uint home = (uint)(h >> APB_REM_BITS);
+	uint d, p, e, j, n, src;
+
+	for (d = 0; ; d++)
+	{
+		if (d > APB_DIST_MAX)
+			return(-1);
+		p = (home + d) & SLOT_MASK;
+		if ((meta[p] == META_EMPTY) || (DIST(meta[p]) < d))
+			break;
+	}
+	// Search the end of the cluster, all entries must accept one more slot
+	for (e = p, n = 0; meta[e] != META_EMPTY; e = (e + 1) & SLOT_MASK)
+	{
+		if ((DIST(meta[e]) >= APB_DIST_MAX) || (++n == APB_SLOTS))
+			return(-1);
+	}
+	for (j = e; j != p; j = src)
+	{
+		src = (j - 1) & SLOT_MASK;
+		keys[j] = keys[src];
+		meta[j] = (u8)(meta[src] + 1);
+		if (dirty[src >> 5] & (1u << (src & 31)))
+			dirty[j >> 5] |= (1u << (j & 31));
+		else
+			dirty[j >> 5] &= ~(1u << (j & 31));
+		_moved(src, j);
+	}
+	keys[p] = (u16)(h & REM_MASK);
+	meta[p] = (u8)((zone << 5) | d);
+	dirty[p >> 5] &= ~(1u << (p & 31));
+	return (int)p;
+}
+
+/**
+ * @brief Remove the entry of a slot (backward shift)
+ *
+ * @param slot Slot number
+ */
+static void _delete(uint slot)
+{
+	uint j, n;
+
+	for (j = slot; ; j = n)
+	{
+		n = (j + 1) & SLOT_MASK;
+		if ((meta[n] == META_EMPTY) || (DIST(meta[n]) == 0))
+			break;
+		keys[j] = keys[n];
+		meta[j] = (u8)(meta[n] - 1);
+		if (dirty[n >> 5] & (1u << (n & 31)))
+			dirty[j >> 5] |= (1u << (j & 31));
+		else
+			dirty[j >> 5] &= ~(1u << (j & 31));
+		_moved(n, j);
+	}
+	keys[j] = 0;
+	meta[j] = META_EMPTY;
+	dirty[j >> 5] &= ~(1u << (j & 31));
+}
+
+/**
+ * @brief Get the credential of a slot
+ *
+ * @param slot Slot number (not empty)
+ * @return u32 Credential identifier
+ */
+static u32 _cred(uint slot)
+{
+	u32 home;
+
+	home = (slot - DIST(meta[slot])) & SLOT_MASK;
+	return _unmix((home << APB_REM_BITS) | (keys[slot] & REM_MASK));
+}
+
+/**
+ * @brief Called when an entry is moved, while a checkpoint is in progress
+ *
+ * An entry moved from a slot not yet copied to a slot already copied
+ * would be missing from the checkpoint : it is queued as a change.
+ *
+ * @param from Previous slot
+ * @param to   New slot (entry already moved)
+ */
+static inline void _moved(uint from, uint to)
+{
+	if ((ckpt.state != LOG_SNAP) || (from < ckpt.cursor) || (to >= ckpt.cursor))
+		return;
+	_queue(_cred(to), ZONE(meta[to]));
+}
+
+/**
+ * @brief Apply a change read from the log (no timer, not queued)
+ *
+ * @param cred Credential identifier
+ * @param zone New area, APB_FREE to forget the credential
+ */
+static void _apply(u32 cred, uint zone)
+{
+	u32 h = _mix(cred);
+	int slot;
+
+	slot = _find(h);
+	if (slot >= 0)
+	{
+		occupancy[ZONE(meta[slot])]--;
+		if (zone < APB_ZONES)
+		{
+			occupancy[zone]++;
+			meta[slot] = (u8)((meta[slot] & META_DIST) | (zone << 5));
+			return;
+		}
+		live--;
+		_delete((uint)slot);
+		return;
+	}
+	if (zone >= APB_ZONES)
+		return;
+	if (_insert(h, zone) < 0)
+	{
+		apb_stat.full++;
+		return;
+	}
+	occupancy[zone]++;
+	live++;
+}
+
+/**
+ * @brief Empty the table, the timer wheel and the queue of changes
+ *
+ */
+static void _reset(void)
+{
+	uint i;
+
+	for (i = 0; i < APB_SLOTS; i++)
+	{
+		keys[i] = 0;
+		meta[i] = META_EMPTY;
+	}
+	for (i = 0; i < (APB_SLOTS / 32); i++)
+		dirty[i] = 0;
+	for (i = 0; i < APB_ZONES; i++)
+		occupancy[i] = 0;
+	live = 0;
+
+	for (i = 0; i < APB_TIMERS; i++)
+		timers[i].next = (u16)(i + 1);
+	timers[APB_TIMERS - 1].next = NIL;
+	timer_free = 0;
+	for (i = 0; i < APB_WHEEL; i++)
+		wheel[i] = NIL;
+
+	queue.rd = 0;
+	queue.wr = 0;
+}
+
+/**
+ * @brief Arm a timer for a credential
+ *
+ * @param cred  Credential identifier
+ * @param ticks Delay in ticks (not 0)
+ * @return integer Zero on success, -1 if no timer is available
+ */
+static int _arm(u32 cred, u32 ticks)
+{
+	apb_timer *t;
+	uint b, id;
+
+	if (timer_free == NIL)
+	{
+		apb_stat.no_timer++;
+		return(-1);
+	}
+	id = timer_free;
+	t  = &timers[id];
+	timer_free = t->next;
+
+	// Visited first after (ticks - 1) % APB_WHEEL + 1 ticks
+	b = (wheel_now + ticks) & (APB_WHEEL - 1);
+	t->cred   = cred;
+	t->rounds = (u16)((ticks - 1) / APB_WHEEL);
+	t->next   = wheel[b];
+	wheel[b]  = (u16)id;
+	return(0);
+}
+
+/**
+ * @brief Process the timers of one bucket of the wheel
+ *
+ * The list is detached first, so timers armed again by _expire into the
+ * same bucket are not visited twice.
+ *
+ * @param b Bucket number
+ */
+static void _bucket(uint b)
+{
+	apb_timer *t;
+	uint id, next;
+
+	id = wheel[b];
+	wheel[b] = NIL;
+	for ( ; id != NIL; id = next)
+	{
+		t = &timers[id];
+		next = t->next;
+		if (t->rounds)
+		{
+			t->rounds--;
+			t->next  = wheel[b];
+			wheel[b] = (u16)id;
+			continue;
+		}
+		t->next = timer_free;
+		timer_free = (u16)id;
+		_expire(t->cred);
+	}
+}
+
+/**
+ * @brief Timer of a credential has expired
+ *
+ * @param cred Credential identifier
+ */
+static void _expire(u32 cred)
+{
+	uint s, zone;
+	int  slot;
+
+	slot = _find(_mix(cred));
+	if (slot < 0)
+		return;
+	s = (uint)slot;
+	zone = ZONE(meta[s]);
+
+	// Granted again while the timer was pending : restart for the new area
+	if (dirty[s >> 5] & (1u << (s & 31)))
+	{
+		dirty[s >> 5] &= ~(1u << (s & 31));
+		if (zone_ticks[zone] && (_arm(cred, zone_ticks[zone]) == 0))
+			return;
+		keys[s] &= (u16)~KEY_TIMER;
+		return;
+	}
+	occupancy[zone]--;
+	live--;
+	_delete(s);
+	apb_stat.expired++;
+	_queue(cred, APB_FREE);
+}
+
+/**
+ * @brief Add a change to the queue of the log
+ *
+ * When the queue is full the change is lost, a full checkpoint is then
+ * made to save the table.
+ *
+ * @param cred Credential identifier
+ * @param zone New area, or APB_FREE
+ */
+static void _queue(u32 cred, uint zone)
+{
+	uint pos;
+
+	if ((queue.wr - queue.rd) >= APB_QUEUE)
+	{
+		if (ckpt.resync == 0)
+			apb_stat.overflow++;
+		ckpt.resync = 1;
+		return;
+	}
+	pos = queue.wr % APB_QUEUE;
+	queue.cred[pos] = cred;
+	queue.zone[pos] = (u8)zone;
+	queue.wr++;
+}
+
+/**
+ * @brief Advance the log : write queued changes, or one step of checkpoint
+ *
+ */
+static void _log_step(void)
+{
+	u32  target;
+	uint pos, n;
+
+	target = ckpt.base + ((ckpt.half ^ 1) * APB_HALF_SIZE);
+	switch (ckpt.state)
+	{
+		case LOG_IDLE:
+			if (ckpt.full)
+			{
+				// Changes are dropped until the table fits into a checkpoint
+				queue.rd = queue.wr;
+				ckpt.resync = ((live + (live >> 3)) < APB_SNAP_MAX);
+			}
+			for (n = 0; (n < 4) && (queue.rd != queue.wr) && (ckpt.resync == 0) &&
+			            (ckpt.wr < APB_HALF_SIZE); n++)
+			{
+				ckpt.lanes = 0;
+				while ((ckpt.lanes < 3) && (queue.rd != queue.wr))
+				{
+					pos = queue.rd % APB_QUEUE;
+					queue.rd++;
+					_lane(queue.cred[pos], queue.zone[pos]);
+				}
+				if (_lane_flush(ckpt.base + (ckpt.half * APB_HALF_SIZE) + ckpt.wr) < 0)
+					return;
+				ckpt.wr += FLASH_QW_SIZE;
+			}
+			if (ckpt.resync || ((ckpt.wr >= APB_HALF_SIZE) && (ckpt.full == 0)))
+			{
+				ckpt.state  = LOG_ERASE;
+				ckpt.cursor = 0;
+			}
+			break;
+
+		case LOG_ERASE:
+			if (_erase(target + (ckpt.cursor * FLASH_SECT_SIZE)) < 0)
+				return;
+			ckpt.cursor++;
+			if (ckpt.cursor < (APB_HALF_SIZE / FLASH_SECT_SIZE))
+				break;
+			// Changes made before this point are into the table
+			queue.rd = queue.wr;
+			ckpt.resync = 0;
+			_snap_begin();
+			break;
+
+		case LOG_SNAP:
+			if (_snap_step(APB_SNAP_STEP) == 0)
+				break;
+			if (ckpt.state != LOG_SNAP)
+				break;
+			if (_header(target, ckpt.seq + 1) < 0)
+				break;
+			ckpt.seq++;
+			ckpt.half ^= 1;
+			ckpt.wr    = ckpt.snap_wr;
+			ckpt.state = LOG_IDLE;
+			break;
+	}
+}
+
+/**
+ * @brief Start a checkpoint into the other half (already erased)
+ *
+ */
+static void _snap_begin(void)
+{
+	uint i;
+
+	ckpt.state   = LOG_SNAP;
+	ckpt.full    = 0;
+	ckpt.cursor  = 0;
+	ckpt.snap_wr = FLASH_QW_SIZE;
+	ckpt.home    = 0;
+	ckpt.lanes   = 0;
+	for (i = 0; i < 4; i++)
+		ckpt.lane[i] = 0;
+}
+
+/**
+ * @brief Copy a part of the table into the checkpoint
+ *
+ * Slots are copied in order, so the home slot of an entry is usually near
+ * the one of the previous entry : only the difference is saved.
+ *
+ * @param count Number of slots to copy
+ * @return integer Non-zero when the whole table has been copied
+ */
+static int _snap_step(uint count)
+{
+	u32  home;
+	uint s;
+	int  result;
+
+	for ( ; count && (ckpt.cursor < APB_SLOTS); count--)
+	{
+		s = (uint)ckpt.cursor++;
+		if ((meta[s] == META_EMPTY) || ckpt.full)
+			continue;
+		home = (s - DIST(meta[s])) & SLOT_MASK;
+		result = 0;
+		if ((home < ckpt.home) || ((home - ckpt.home) > SNAP_DELTA))
+		{
+			// Entry of area 7 : set the home slot
+			result = _snap_put((home & REM_MASK) | (7u << 15) | ((home >> 15) << 18));
+			ckpt.home = home;
+		}
+		if (result == 0)
+			result = _snap_put((keys[s] & REM_MASK) | (ZONE(meta[s]) << 15) |
+			                   ((home - ckpt.home) << 18));
+		ckpt.home = home;
+		if (result < 0)
+			return(1);
+		if (result > 0)
+			ckpt.full = 1;
+	}
+	if (ckpt.cursor < APB_SLOTS)
+		return(0);
+
+	if (_snap_flush() < 0)
+		return(1);
+	if (ckpt.full)
+	{
+		apb_stat.overflow++;
+		log_print(0, " * APB: %{WARNING%} %u credentials, checkpoint too large\n",
+		          LOG_YLW, live);
+	}
+	apb_stat.checkpoints++;
+	return(1);
+}
+
+/**
+ * @brief Add an entry to the checkpoint, write the record when complete
+ *
+ * @param entry Entry (24 bits)
+ * @return integer Zero on success, 1 if the half is full, -1 on flash error
+ */
+static int _snap_put(u32 entry)
+{
+	if ((ckpt.lanes == 0) && ((ckpt.snap_wr + FLASH_QW_SIZE) > APB_HALF_SIZE))
+		return(1);
+	_snap_set(entry);
+	if (ckpt.lanes < SNAP_LANES)
+		return(0);
+	return _snap_flush();
+}
+
+/**
+ * @brief Copy an entry into the next lane of the checkpoint record
+ *
+ * @param entry Entry (24 bits)
+ */
+static void _snap_set(u32 entry)
+{
+	uint b, k;
+
+	for (k = 0; k < 3; k++)
+	{
+		b = (ckpt.lanes * 3) + k;
+		ckpt.lane[b / 4] |= ((entry >> (8 * k)) & 0xFF) << (8 * (b % 4));
+	}
+	ckpt.lanes++;
+}
+
+/**
+ * @brief Write the checkpoint record being filled (unused entries are set)
+ *
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _snap_flush(void)
+{
+	u32  addr;
+	uint i;
+
+	if (ckpt.lanes == 0)
+		return(0);
+	while (ckpt.lanes < SNAP_LANES)
+		_snap_set(SNAP_NONE);
+	ckpt.lane[3] |= (u32)APB_SNAP_TAG << 24;
+
+	addr = ckpt.base + ((ckpt.half ^ 1) * APB_HALF_SIZE) + ckpt.snap_wr;
+	ckpt.lanes = 0;
+	if (_write(addr, ckpt.lane) < 0)
+		return(-1);
+	for (i = 0; i < 4; i++)
+		ckpt.lane[i] = 0;
+	ckpt.snap_wr += FLASH_QW_SIZE;
+	apb_stat.records++;
+	return(0);
+}
+
+/**
+ * @brief Add a change to the change record being filled
+ *
+ * @param cred Credential identifier
+ * @param zone Area, or APB_FREE
+ */
+static void _lane(u32 cred, uint zone)
+{
+	if (ckpt.lanes == 0)
+		ckpt.lane[3] = 0;
+	ckpt.lane[ckpt.lanes] = cred;
+	ckpt.lane[3] |= (u32)(zone & 0xFF) << (8 * ckpt.lanes);
+	ckpt.lanes++;
+}
+
+/**
+ * @brief Write the change record being filled, unused lanes are cleared
+ *
+ * @param addr Address of the record (quad-word)
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _lane_flush(u32 addr)
+{
+	uint i;
+
+	for (i = ckpt.lanes; i < 3; i++)
+	{
+		ckpt.lane[i] = 0;
+		ckpt.lane[3] |= (u32)0xFF << (8 * i);
+	}
+	ckpt.lane[3] = (ckpt.lane[3] & 0x00FFFFFF) | ((u32)APB_REC_TAG << 24);
+	ckpt.lanes = 0;
+	if (_write(addr, ckpt.lane) < 0)
+		return(-1);
+	apb_stat.records++;
+	return(0);
+}
+
+/**
+ * @brief Write the header of a half, this validates its content
+ *
+ * @param addr Address of the half
+ * @param seq  Sequence number
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _header(u32 addr, u32 seq)
+{
+	u32 qw[4];
+
+	qw[0] = APB_LOG_MAGIC;
+	qw[1] = seq;
+	qw[2] = ~seq;
+	qw[3] = 0;
+	return _write(addr, qw);
+}
+
+/**
+ * @brief Erase a sector of the log (if not already blank)
+ *
+ * On error the log is stopped.
+ *
+ * @param addr Address of the sector
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _erase(u32 addr)
+{
+	int  locked, result;
+	uint i;
+
+	for (i = 0; i < FLASH_SECT_SIZE; i += 4)
+		if (reg_rd(addr + i) != 0xFFFFFFFF)
+			break;
+	if (i == FLASH_SECT_SIZE)
+		return(0);
+
+	locked = flash_locked();
+	result = flash_unlock();
+	if (result == FLASH_OK)
+		result = flash_erase(addr);
+	if (locked)
+		flash_lock();
+	if (result == FLASH_OK)
+		return(0);
+	apb_stat.flash_err++;
+	ckpt.state = LOG_OFF;
+	return(-1);
+}
+
+/**
+ * @brief Program a quad-word of the log
+ *
+ * On error the log is stopped.
+ *
+ * @param addr Address of the quad-word
+ * @param qw   Pointer to the four words
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _write(u32 addr, const u32 *qw)
+{
+	int locked, result;
+
+	locked = flash_locked();
+	result = flash_unlock();
+	if (result == FLASH_OK)
+		result = flash_program(addr, qw);
+	if (locked)
+		flash_lock();
+	if (result == FLASH_OK)
+		return(0);
+	apb_stat.flash_err++;
+	ckpt.state = LOG_OFF;
+	return(-1);
+}
+
+/**
+ * @brief Rebuild the table from the newest half of the log
+ *
+ * Records are applied up to the first erased quad-word. When no valid
+ * half is found, or the log ends with a damaged record, a checkpoint is
+ * made at the next poll.
+ */
+static void _replay(void)
+{
+	u32  addr, seq, home, w[4];
+	uint half, off, i;
+	int  best = -1;
+
+	seq = 0;
+	for (half = 0; half < 2; half++)
+	{
+		addr = ckpt.base + (half * APB_HALF_SIZE);
+		w[0] = reg_rd(addr);
+		w[1] = reg_rd(addr + 4);
+		w[2] = reg_rd(addr + 8);
+		if ((w[0] != APB_LOG_MAGIC) || (w[2] != ~w[1]))
+			continue;
+		if ((best < 0) || ((s32)(w[1] - seq) > 0))
+		{
+			best = (int)half;
+			seq  = w[1];
+		}
+	}
+	if (best < 0)
+	{
+		// Nothing to replay : the first checkpoint goes into half 0
+		ckpt.half   = 1;
+		ckpt.seq    = 0;
+		ckpt.wr     = APB_HALF_SIZE;
+		ckpt.resync = 1;
+		return;
+	}
+	ckpt.half   = (uint)best;
+	ckpt.seq    = seq;
+	ckpt.resync = 0;
+
+	addr = ckpt.base + (ckpt.half * APB_HALF_SIZE);
+	home = 0;
+	for (off = FLASH_QW_SIZE; off < APB_HALF_SIZE; off += FLASH_QW_SIZE)
+	{
+		for (i = 0; i < 4; i++)
+			w[i] = reg_rd(addr + off + (4 * i));
+		if ((w[3] >> 24) == APB_SNAP_TAG)
+		{
+			_replay_snap(w, &home);
+			continue;
+		}
+		if ((w[3] >> 24) != APB_REC_TAG)
+		{
+			if ((w[0] & w[1] & w[2] & w[3]) != 0xFFFFFFFF)
+				ckpt.resync = 1;
+			break;
+		}
+		for (i = 0; i < 3; i++)
+		{
+			if (w[i] == 0)
+				continue;
+			_apply(w[i], (w[3] >> (8 * i)) & 0xFF);
+			apb_stat.replayed++;
+		}
+	}
+	ckpt.wr = off;
+}
+
+/**
+ * @brief Apply the entries of a checkpoint record
+ *
+ * @param w    Pointer to the record (four words)
+ * @param home Pointer to the home slot of the previous entry (updated)
+ */
+static void _replay_snap(const u32 *w, u32 *home)
+{
+	u32  entry;
+	uint b, e, k;
+
+	for (e = 0; e < SNAP_LANES; e++)
+	{
+		entry = 0;
+		for (k = 0; k < 3; k++)
+		{
+			b = (e * 3) + k;
+			entry |= ((w[b / 4] >> (8 * (b % 4))) & 0xFF) << (8 * k);
+		}
+		if (entry == SNAP_NONE)
+			continue;
+		if (((entry >> 15) & 7) == 7)
+		{
+			*home = (entry & REM_MASK) | (((entry >> 18) & 3) << 15);
+			continue;
+		}
+		*home = (*home + (entry >> 18)) & SLOT_MASK;
+		_apply(_unmix((*home << APB_REM_BITS) | (entry & REM_MASK)), (entry >> 15) & 7);
+		apb_stat.replayed++;
+	}
+}
+
+/**
+ * @brief Get the address to use for a sector of the log
+ *
+ * @param addr Address into the flash (any alias)
+ * @return u32 Secure alias (log sectors are secure), or the address
+ */
+static u32 _addr(u32 addr)
+{
+#ifdef RUN_SEC
+	return (addr | FLASH_BASE_S);
+#else
+	return(addr);
+#endif
+}
+/* EOF */
@@ -0,0 +1,103 @@
+/**
+ * @file  apb.h
+ * @brief Definitions and prototypes for anti-passback and occupancy tracking
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef APB_H
+#define APB_H
+#include "driver/flash.h"
+#include "pool.h"
+#include "types.h"
+
+// Table of 2^APB_BITS slots : the store holds up to about 80k credentials
+// (load 0.61), the checkpoint log up to APB_SNAP_MAX.
+// Keys and dirty bits take 272 kB of SRAM3, meta and timers 144 kB of
+// SRAM1 : check the regions with `make mem_check` when changing it
+#define APB_BITS     17
+#define APB_SLOTS    (1u << APB_BITS)
+#define APB_REM_BITS (32 - APB_BITS)
+// Longest probe sequence accepted, an insert beyond it fails (table full)
+#define APB_DIST_MAX 30
+#define APB_SECT     POOL_SRAM3 ".apb"
+
+/* Areas (zones) : a credential is into one area, or not tracked (free) */
+#define APB_ZONES 7
+#define APB_FREE  7
+
+// Timer wheel : 256 buckets of one tick (2^25 timer cycles, ~1 s)
+#define APB_WHEEL      256
+#define APB_TICK_SHIFT 25
+#define APB_TIMERS     2048
+// Ticks processed by one call of apb_poll (catch up after a long stall)
+#define APB_POLL_TICKS 8
+
+/* Checkpoint log : last sectors of the inactive bank (592 kB), two halves.
+ * A checkpoint (94715 credentials) must hold the largest credential store */
+#define APB_LOG_SECTS  74
+#define APB_LOG_SIZE   (APB_LOG_SECTS * FLASH_SECT_SIZE)
+#define APB_LOG_OFFSET (FLASH_BANK_SIZE - APB_LOG_SIZE)
+#define APB_HALF_SIZE  (APB_LOG_SIZE / 2)
+// Credentials of one full checkpoint (five per record, first is header)
+#define APB_SNAP_MAX   (((APB_HALF_SIZE / FLASH_QW_SIZE) - 1) * 5)
+// Changes waiting to be written into the log
+#define APB_QUEUE      256
+// Slots copied into the checkpoint by one call of apb_poll
+#define APB_SNAP_STEP  4096
+
+/* Records of the log (one flash quad-word each, tag into the last byte).
+ * The first quad-word of a half is its header : magic, sequence, ~sequence.
+ * - change : words 0-2 are credentials (0 for an unused lane), word 3 holds
+ *   the area of each lane (one byte each, APB_FREE to forget it)
+ * - checkpoint : five entries of 24 bits, remainder (bits 0-14), area (bits
+ *   15-17) and home slot as a difference with the previous entry (bits
+ *   18-23). An entry with area 7 sets the home slot (bits 15-16 into bits
+ *   18-19), 0xFFFFFF is an unused entry. */
+#define APB_LOG_MAGIC  0x41504231 /* "APB1" */
+#define APB_REC_TAG    0xA5
+#define APB_SNAP_TAG   0x5A
+
+/* Result of apb_grant */
+#define APB_OK    0
+#define APB_FULL -1
+#define APB_ERR  -2
+
+/**
+ * @brief Counters of the anti-passback table
+ */
+typedef struct apb_stats
+{
+	u32 grants;      // Updates (apb_grant)
+	u32 full;        // Updates refused, no slot within APB_DIST_MAX
+	u32 expired;     // Credentials released by the timer wheel
+	u32 no_timer;    // Timers not armed, pool empty (area kept until cleared)
+	u32 records;     // Records written into the log
+	u32 replayed;    // Changes applied from the log at boot
+	u32 checkpoints; // Full checkpoints written
+	u32 overflow;    // Checkpoint too large or queue full (changes not saved)
+	u32 flash_err;   // Erase or program errors (log stopped until reset)
+} apb_stats;
+
+extern apb_stats apb_stat;
+
+void apb_init    (void);
+void apb_clear   (void);
+void apb_timeout (uint zone, uint seconds);
+int  apb_grant   (u32 cred, uint zone);
+uint apb_zone    (u32 cred);
+int  apb_check   (u32 cred, uint zone);
+u32  apb_occupancy(uint zone);
+u32  apb_count   (void);
+void apb_poll    (void);
+void apb_handover(void);
+
+#endif
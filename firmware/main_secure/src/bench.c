@@ -0,0 +1,1062 @@
+/**
+ * @file  bench.c
+ * @brief Benchmark runner for the hot paths of the secure firmware
+ *
+ * This file replaces main.c into the "bench" builds (see Makefile). Each
+ * case is executed a fixed number of iterations, a few times, and the best
+ * run is reported as a CSV line on the console :
+ *
+ *   BENCH,<case>,<iterations>,<unit>,<total>,<per op>,<bus per op>
+ *
+ * On target the unit is CPU cycles (DWT CYCCNT), on the host build it is
+ * TSC ticks (or nanoseconds when TSC is not available). The last column is
+ * the number of register accesses per operation, counted by the simulated
+ * bus (host only, 0 on target) : this one does not depend on the machine.
+ * Console output is muted while a case runs, so log functions are measured
+ * without the UART transmission time.
+ * Use scripts/bench_diff.py to compare results with a baseline.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "apb.h"
+#include "crash.h"
+#include "cred.h"
+#include "driver/crc.h"
+#include "driver/eth.h"
+#include "driver/fdcan.h"
+#include "driver/spi.h"
+#include "driver/uart.h"
+#include "entropy.h"
+#include "journal.h"
+#include "log.h"
+#include "monitor.h"
+#include "pipeline.h"
+#include "pool.h"
+#include "ratelim.h"
+#include "regs.h"
+#include "sched.h"
+#include "seq.h"
+#include "systime.h"
+#include "trace.h"
+#include "uplink.h"
+#ifdef HOST
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "tsc"
+#else
+#include <time.h>
+#define BENCH_UNIT "ns"
+#endif
+#else
+#define BENCH_UNIT "cycles"
+#endif
+
+/* Number of runs of each case, the fastest one is reported */
+#define BENCH_RUNS 5
+
+typedef struct bench_case
+{
+	const char *name;
+	uint iterations;
+	void (*fct)(uint n);
+	void (*setup)(void);
+} bench_case;
+
+// Pool of the allocation benchmark
+POOL_DEFINE(pool_bench, 32, 16, POOL_SRAM3);
+
+static void _cycles_init(void);
+static u32  _cycles(void);
+static u32  _bus(void);
+static void _report(const char *name, uint n, u32 total, u32 bus);
+static void _run(const bench_case *bc);
+
+static void _b_empty(uint n);
+static void _b_log_print(uint n);
+static void _b_log_putdec(uint n);
+static void _b_log_puthex(uint n);
+static void _b_log_dump(uint n);
+static void _b_reg_rd(uint n);
+static void _b_reg_wr(uint n);
+static void _b_reg_set(uint n);
+static void _b_reg_clr(uint n);
+static void _b_rmw_fields(uint n);
+static void _b_modify_fields(uint n);
+static void _b_gpio_odr(uint n);
+static void _b_gpio_bsrr(uint n);
+static void _b_spi_xfer(uint n);
+static void _b_sched_check(uint n);
+static void _b_time_ns(uint n);
+static void _b_pool(uint n);
+static void _b_wall_ns(uint n);
+static void _b_seq_compile(uint n);
+static void _b_eth_loop(uint n);
+static void _eth_setup(void);
+static void _b_uplink_pack(uint n);
+static void _uplink_setup(void);
+static void _b_can_loop(uint n);
+static void _can_rx(const fdcan_msg *msg);
+static void _can_setup(void);
+static void _b_trace(uint n);
+static void _b_classify(uint n);
+static void _classify_setup(void);
+static void _b_nonce(uint n);
+static void _b_apb_lookup(uint n);
+static void _b_apb_miss(uint n);
+static void _b_apb_grant(uint n);
+static void _apb_fill(u32 count);
+static void _apb_setup80(void);
+static void _apb_setup90(void);
+static void _b_cred_lookup(uint n);
+static void _b_cred_apply(uint n);
+static void _cred_op(u8 *p, uint op, u32 id, u32 attr);
+static void _cred_setup(void);
+static void _b_pin_attempt(uint n);
+static void _b_pin_new(uint n);
+static void _pin_setup(void);
+static void _b_pipe_txn(uint n);
+static void _pipe_setup(void);
+static void _sched_setup(uint count);
+static void _sched_setup4(void);
+static void _sched_setup64(void);
+
+/* List of benchmarks, new hot paths should be added here */
+static const bench_case cases[] =
+{
+	{ "empty",        1000, _b_empty,         0               },
+	{ "log_print",    1000, _b_log_print,     0               },
+	{ "log_putdec",   1000, _b_log_putdec,    0               },
+	{ "log_puthex",   1000, _b_log_puthex,    0               },
+	{ "log_dump",      100, _b_log_dump,      0               },
+	{ "reg_rd",       1000, _b_reg_rd,        0               },
+	{ "reg_wr",       1000, _b_reg_wr,        0               },
+	{ "reg_set",      1000, _b_reg_set,       0               },
+	{ "reg_clr",      1000, _b_reg_clr,       0               },
+	{ "rmw_3fields",  1000, _b_rmw_fields,    0               },
+	{ "mod_3fields",  1000, _b_modify_fields, 0               },
+	{ "gpio_odr",     1000, _b_gpio_odr,      0               },
+	{ "gpio_bsrr",    1000, _b_gpio_bsrr,     0               },
+	{ "spi_xfer16",    100, _b_spi_xfer,      0               },
+	{ "sched_4",      1000, _b_sched_check,   _sched_setup4   },
+	{ "sched_64",     1000, _b_sched_check,   _sched_setup64  },
+	{ "time_ns",      1000, _b_time_ns,       0               },
+	{ "pool_alloc",   1000, _b_pool,          0               },
+	{ "wall_ns",      1000, _b_wall_ns,       0               },
+	{ "seq_compile",  1000, _b_seq_compile,   0               },
+	{ "eth_loop",      100, _b_eth_loop,      _eth_setup      },
+	{ "uplink_pack",  1000, _b_uplink_pack,   _uplink_setup   },
+	{ "can_loop",      100, _b_can_loop,      _can_setup      },
+	{ "trace_event",  1000, _b_trace,         0               },
+	{ "adc_classify", 1000, _b_classify,      _classify_setup },
+	{ "nonce16",      1000, _b_nonce,         entropy_init    },
+	{ "apb_lookup80", 1000, _b_apb_lookup,    _apb_setup80    },
+	{ "apb_grant80",  1000, _b_apb_grant,     _apb_setup80    },
+	{ "apb_lookup90", 1000, _b_apb_lookup,    _apb_setup90    },
+	{ "apb_miss90",   1000, _b_apb_miss,      _apb_setup90    },
+	{ "apb_grant90",  1000, _b_apb_grant,     _apb_setup90    },
+	{ "cred_lookup",  1000, _b_cred_lookup,   _cred_setup     },
+	{ "cred_apply8",   100, _b_cred_apply,    _cred_setup     },
+	{ "pin_attempt",  1000, _b_pin_attempt,   _pin_setup      },
+	{ "pin_new",      1000, _b_pin_new,       _pin_setup      },
+	{ "pipe_txn",     1000, _b_pipe_txn,      _pipe_setup     },
+	{ 0, 0, 0, 0 }
+};
+
+static volatile u32 bench_sink;
+
+/* Credentials into the anti-passback table (apb_* cases) */
+#define BENCH_APB_CRED(i) (((u32)(i) + 1) * 2654435761u)
+static u32 apb_fill;
+static u32 apb_idx;
+
+/* Credential store (cred_* cases) : base, then changes into the overlay */
+#define BENCH_CRED_BASE  6000
+#define BENCH_CRED_DELTA 256
+#define BENCH_CRED_ID(i) (((u32)(i) + 1) * 500009u)
+static u8  cred_ops[8 * CRED_OP_SIZE];
+static u32 cred_idx;
+
+/* Wiegand 26 frame of a known credential (pipe_txn case) */
+static u32 pipe_frame[2];
+
+/* Half-buffer of analog samples used by the adc_classify case */
+static u16 adc_samples[MON_HALF];
+
+/* Compiled schedules used by sched_* cases (one calendar of 731 days) */
+#define BENCH_CAL_WORDS 23
+#define BENCH_SCHED_MAX 64
+static u32 sched_blob[(sizeof(sched_hdr) / 4) + BENCH_CAL_WORDS +
+                      (BENCH_SCHED_MAX * SCHED_REC_WORDS)];
+
+/**
+ * @brief Entry point of the benchmark firmware
+ *
+ */
+int main(void)
+{
+	const bench_case *bc;
+
+#ifdef HOST
+	sim_init();
+#endif
+	hw_init();
+	uart_init();
+	spi_init();
+	crc_init();
+	log_init();
+	crash_init();
+	pool_init();
+	pool_create(&pool_bench);
+	trace_init();
+	_cycles_init();
+
+	log_print(0, "BENCH,case,iterations,unit,total,per_op,bus_per_op\n");
+	for (bc = cases; bc->name; bc++)
+		_run(bc);
+	log_print(0, "BENCH,end\n");
+
+#ifdef HOST
+	return(0);
+#else
+	while(1)
+		;
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Initialize the cycle counter
+ *
+ */
+static void _cycles_init(void)
+{
+#ifndef HOST
+	// DEMCR : Set TRCENA to enable DWT
+	reg_set(SCB_DEMCR, (1 << 24));
+	reg_wr (DWT_CYCCNT, 0);
+	// DWT_CTRL : Set CYCCNTENA
+	reg_set(DWT_CTRL, (1 << 0));
+#endif
+}
+
+/**
+ * @brief Read the cycle counter
+ *
+ * @return u32 Current value of the counter (wraps)
+ */
+static u32 _cycles(void)
+{
+#ifdef HOST
+#if defined(__x86_64__) || defined(__i386__)
+	return (u32)__rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u32)((u32)ts.tv_sec * 1000000000u + (u32)ts.tv_nsec);
+#endif
+#else
+	return reg_rd(DWT_CYCCNT);
+#endif
+}
+
+/**
+ * @brief Read the number of register accesses made since startup
+ *
+ * @return u32 Number of accesses (always 0 on target)
+ */
+static u32 _bus(void)
+{
+#ifdef HOST
+	return (u32)(sim_stat.rd + sim_stat.wr);
+#else
+	return(0);
+#endif
+}
+
+/**
+ * @brief Execute one benchmark case and report the fastest run
+ *
+ * @param bc Pointer to the case descriptor
+ */
+static void _run(const bench_case *bc)
+{
+	u32  best = 0xFFFFFFFF;
+	u32  bus  = 0;
+	u32  t, b;
+	uint i;
+
+	if (bc->setup)
+		bc->setup();
+
+	for (i = 0; i < BENCH_RUNS; i++)
+	{
+		log_mute(1);
+		b = _bus();
+		t = _cycles();
+		bc->fct(bc->iterations);
+		t = _cycles() - t;
+		b = _bus() - b;
+		log_mute(0);
+		if (t < best)
+			best = t;
+		bus = b;
+	}
+	_report(bc->name, bc->iterations, best, bus);
+}
+
+/**
+ * @brief Write the CSV line of a result
+ *
+ * Values per operation are written with two decimals.
+ *
+ * @param name  Name of the benchmark case
+ * @param n     Number of iterations
+ * @param total Total duration of the best run
+ * @param bus   Number of register accesses of the last run
+ */
+static void _report(const char *name, uint n, u32 total, u32 bus)
+{
+	log_print(0, "BENCH,%s,%u,%s,%u,%u.%2u,%u.%2u\n", name, n, BENCH_UNIT, total,
+	          total / n, ((total % n) * 100) / n,
+	          bus / n, ((bus % n) * 100) / n);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Benchmark cases                               */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Empty loop, used to estimate the overhead of the runner
+ */
+static void _b_empty(uint n)
+{
+	while (n--)
+		bench_sink = n;
+}
+
+/**
+ * @brief Formatted message with integer, hex and string arguments
+ */
+static void _b_log_print(uint n)
+{
+	while (n--)
+		log_print(0, "Value %d at %32x: %s\n", (int)n, 0x20001234, "bench");
+}
+
+/**
+ * @brief Decimal conversion of a 32 bits value
+ */
+static void _b_log_putdec(uint n)
+{
+	while (n--)
+		log_putdec(n * 7919, 0, 0);
+}
+
+/**
+ * @brief Hexadecimal conversion of a 32 bits value
+ */
+static void _b_log_puthex(uint n)
+{
+	while (n--)
+		log_puthex(n * 0x9E3779B9, 32);
+}
+
+/**
+ * @brief Dump of a 64 bytes buffer (with relative addresses)
+ */
+static void _b_log_dump(uint n)
+{
+	u8 buffer[64];
+	uint i;
+
+	for (i = 0; i < sizeof(buffer); i++)
+		buffer[i] = (u8)i;
+	while (n--)
+		log_dump(buffer, sizeof(buffer), 2);
+}
+
+/**
+ * @brief 32 bits register read (CRC IDR is a free scratch register)
+ */
+static void _b_reg_rd(uint n)
+{
+	while (n--)
+		bench_sink = reg_rd(CRC_IDR(CRC));
+}
+
+/**
+ * @brief 32 bits register write
+ */
+static void _b_reg_wr(uint n)
+{
+	while (n--)
+		reg_wr(CRC_IDR(CRC), n);
+}
+
+/**
+ * @brief Read-modify-write to set bits
+ */
+static void _b_reg_set(uint n)
+{
+	while (n--)
+		reg_set(CRC_IDR(CRC), (1 << 3));
+}
+
+/**
+ * @brief Read-modify-write to clear bits
+ */
+static void _b_reg_clr(uint n)
+{
+	while (n--)
+		reg_clr(CRC_IDR(CRC), (1 << 3));
+}
+
+/**
+ * @brief Update of 3 fields with one read-modify-write each
+ *
+ * PB0-PB2 output speed is written with its reset value (low speed).
+ */
+static void _b_rmw_fields(uint n)
+{
+	while (n--)
+	{
+		reg_clr(GPIO_OSPEEDR(GPIOB), (3 << 0));
+		reg_clr(GPIO_OSPEEDR(GPIOB), (3 << 2));
+		reg_clr(GPIO_OSPEEDR(GPIOB), (3 << 4));
+	}
+}
+
+/**
+ * @brief Update of the same 3 fields with the generated accessors
+ */
+static void _b_modify_fields(uint n)
+{
+	gpio_ospeedr_t r;
+
+	r = gpio_ospeedr_ospeed0(gpio_ospeedr(), 0);
+	r = gpio_ospeedr_ospeed1(r, 0);
+	r = gpio_ospeedr_ospeed2(r, 0);
+	while (n--)
+		gpio_ospeedr_modify(GPIOB, r);
+}
+
+/**
+ * @brief Set then clear an output pin (PB0, LED) with ODR read-modify-write
+ */
+static void _b_gpio_odr(uint n)
+{
+	while (n--)
+	{
+		reg_set(GPIO_ODR(GPIOB), (1 << 0));
+		reg_clr(GPIO_ODR(GPIOB), (1 << 0));
+	}
+}
+
+/**
+ * @brief Set then clear an output pin (PB0, LED) with BSRR/BRR
+ */
+static void _b_gpio_bsrr(uint n)
+{
+	while (n--)
+	{
+		gpio_set(GPIOB, (1 << 0));
+		gpio_clr(GPIOB, (1 << 0));
+	}
+}
+
+/**
+ * @brief Full-duplex SPI transfer of 16 bytes
+ */
+static void _b_spi_xfer(uint n)
+{
+	u8 tx[16], rx[16];
+	uint i;
+
+	for (i = 0; i < sizeof(tx); i++)
+		tx[i] = (u8)(0xA0 + i);
+	while (n--)
+		spi_xfer(tx, rx, sizeof(tx));
+}
+
+/**
+ * @brief Access decision for various schedules, days and times
+ */
+static void _b_sched_check(uint n)
+{
+	uint count = sched_count();
+
+	while (n--)
+		bench_sink = (u32)sched_check(n % count, 8766 + (n % 7), (n * 37) % 1440);
+}
+
+/**
+ * @brief Read the monotonic timestamp
+ */
+static void _b_time_ns(uint n)
+{
+	while (n--)
+		bench_sink = (u32)systime_ns();
+}
+
+/**
+ * @brief Allocate and release pool blocks (two blocks in use)
+ */
+static void _b_pool(uint n)
+{
+	void *a, *b;
+
+	while (n--)
+	{
+		a = pool_alloc(&pool_bench);
+		b = pool_alloc(&pool_bench);
+		pool_free(&pool_bench, a);
+		pool_free(&pool_bench, b);
+	}
+}
+
+/**
+ * @brief Read the interpolated wall-clock time
+ */
+static void _b_wall_ns(uint n)
+{
+	while (n--)
+		bench_sink = (u32)systime_wall_ns();
+}
+
+/**
+ * @brief Compile the deny sequence (3 blinks, unrolled)
+ */
+static void _b_seq_compile(uint n)
+{
+	static const seq_target target =
+	{
+		GPIO_BSRR(GPIOB), TIM_CCR1(TIM3), { (1 << 1), (1 << 5), (1 << 6) },
+		SEQ_PERIOD_US
+	};
+	static seq_node nodes[SEQ_NODES];
+
+	while (n--)
+		bench_sink = (u32)seq_compile(&seq_deny, &target, nodes, SEQ_NODES, 0x20050000);
+}
+
+/**
+ * @brief Send a frame of 3 segments and receive it back (MAC loopback)
+ *
+ * One round trip : transmit descriptors, zero-copy receive, release of
+ * the buffer and reclaim of the transmit descriptors.
+ */
+static void _b_eth_loop(uint n)
+{
+	static const u8 hdr[14] =
+	{
+		0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02, 0, 0, 0, 0, 1, 0x08, 0x00
+	};
+	static const u8 ip[28] =
+	{
+		0x45, 0, 0, 92, 0, 0, 0x40, 0, 64, 17, 0, 0,
+		192, 168, 1, 10, 192, 168, 1, 255,
+		0x17, 0x70, 0x17, 0x70, 0, 72, 0, 0
+	};
+	static u8 payload[64];
+	static const eth_seg seg[3] =
+	{
+		{ hdr, sizeof(hdr) }, { ip, sizeof(ip) }, { payload, sizeof(payload) }
+	};
+	eth_frame frame;
+
+	while (n--)
+	{
+		eth_send(seg, 3, 0, 0);
+		if (eth_recv(&frame) == 0)
+		{
+			bench_sink = frame.flags;
+			eth_release(&frame);
+		}
+		eth_poll();
+	}
+}
+
+/**
+ * @brief Encode journal records into datagrams (per record)
+ */
+static void _b_uplink_pack(uint n)
+{
+	static u8 buf[UPLINK_PAYLOAD];
+	u32 off = 1;
+
+	while (off < (n + 1))
+		bench_sink = uplink_pack(&off, n + 1, buf, UPLINK_PAYLOAD);
+}
+
+/**
+ * @brief Send two FD messages of 64 bytes on the loopback, one accepted
+ *
+ * The first one is a door command of this node, received through FIFO 0
+ * and its interrupt. The second one is for another node, rejected by the
+ * filters of the controller : it should not cost any CPU time.
+ */
+static void _b_can_loop(uint n)
+{
+	static fdcan_msg msg[2] =
+	{
+		{ FDCAN_ID_DOOR + 1, FDCAN_FD | FDCAN_BRS, 64, 0, { 0 } },
+		{ FDCAN_ID_DOOR + FDCAN_ID_DOOR_NODE + 1, FDCAN_FD | FDCAN_BRS, 64, 0, { 0 } },
+	};
+	u32  rx;
+	uint i;
+
+	while (n--)
+	{
+		rx = fdcan_stat.rx[0];
+		fdcan_send(&msg[0]);
+		fdcan_send(&msg[1]);
+		// Wait for the reception (about 300 us on the target)
+		for (i = 0; (fdcan_stat.rx[0] == rx) && (i < 100000); i++)
+			;
+	}
+}
+
+/**
+ * @brief Write events into the trace buffer (cost of one trace point)
+ */
+static void _b_trace(uint n)
+{
+	while (n--)
+		trace_mark(TRACE_ID_BENCH, n);
+}
+
+/**
+ * @brief Fill a half-buffer with noisy samples : one door open, others normal
+ *
+ */
+static void _classify_setup(void)
+{
+	u32  seed = 0x1234;
+	uint i, v;
+
+	for (i = 0; i < MON_HALF; i++)
+	{
+		seed = (seed * 1103515245) + 12345;
+		v = ((i % MON_CHANNELS) == MON_DOOR0) ? 2730 : 2048;
+		adc_samples[i] = (u16)(v + ((seed >> 16) & 0x1F) - 16);
+	}
+}
+
+/**
+ * @brief Classification of one half-buffer of analog inputs
+ *
+ */
+static void _b_classify(uint n)
+{
+	mon_batch batch;
+
+	while (n--)
+	{
+		monitor_classify(adc_samples, MON_SCANS, &batch);
+		bench_sink = batch.state[MON_DOOR0];
+	}
+}
+
+/**
+ * @brief Challenge nonces (16 bytes) from the entropy pool
+ *
+ * The pool is refilled by the RNG interrupt while it is drained, the cost
+ * of the refill (one ChaCha20 block for each 64 bytes) is included.
+ */
+static void _b_nonce(uint n)
+{
+	u8 nonce[16];
+
+	while (n--)
+	{
+		if (entropy_get(nonce, sizeof(nonce)) == 0)
+			bench_sink = nonce[0];
+	}
+}
+
+/**
+ * @brief Fill the anti-passback table with credentials into four areas
+ *
+ * @param count Number of credentials
+ */
+static void _apb_fill(u32 count)
+{
+	u32 i;
+
+	apb_clear();
+	for (i = 0; i < count; i++)
+		apb_grant(BENCH_APB_CRED(i), i & 3);
+	apb_fill = apb_count();
+	apb_idx  = 0;
+}
+
+/**
+ * @brief Anti-passback table at a load factor of 0.8
+ *
+ */
+static void _apb_setup80(void)
+{
+	_apb_fill((APB_SLOTS / 10) * 8);
+}
+
+/**
+ * @brief Anti-passback table at a load factor of 0.9
+ *
+ */
+static void _apb_setup90(void)
+{
+	_apb_fill((APB_SLOTS / 10) * 9);
+}
+
+/**
+ * @brief Lookup of credentials present into the anti-passback table
+ *
+ */
+static void _b_apb_lookup(uint n)
+{
+	while (n--)
+	{
+		apb_idx += 7919;
+		if (apb_idx >= apb_fill)
+			apb_idx -= apb_fill;
+		bench_sink = apb_zone(BENCH_APB_CRED(apb_idx));
+	}
+}
+
+/**
+ * @brief Lookup of credentials not into the anti-passback table (longest probes)
+ *
+ */
+static void _b_apb_miss(uint n)
+{
+	while (n--)
+	{
+		apb_idx += 7919;
+		if (apb_idx >= apb_fill)
+			apb_idx -= apb_fill;
+		bench_sink = apb_zone(BENCH_APB_CRED(apb_fill + apb_idx));
+	}
+}
+
+/**
+ * @brief Grant of credentials present into the table (area changed)
+ *
+ */
+static void _b_apb_grant(uint n)
+{
+	while (n--)
+	{
+		apb_idx += 7919;
+		if (apb_idx >= apb_fill)
+			apb_idx -= apb_fill;
+		bench_sink = (u32)apb_grant(BENCH_APB_CRED(apb_idx), (apb_idx + n) & 3);
+	}
+}
+
+/**
+ * @brief Set an operation of a batch
+ *
+ * @param p    Pointer to the operation (CRED_OP_SIZE bytes)
+ * @param op   Operation (CRED_OP_*)
+ * @param id   Credential identifier
+ * @param attr Access profile
+ */
+static void _cred_op(u8 *p, uint op, u32 id, u32 attr)
+{
+	uint i;
+
+	p[0] = (u8)op;
+	for (i = 0; i < 4; i++)
+	{
+		p[1 + i] = (u8)(id   >> (8 * i));
+		p[5 + i] = (u8)(attr >> (8 * i));
+	}
+}
+
+/**
+ * @brief Credential store with a base of 6000 records and 256 changes
+ *
+ * The store is formatted first : with a flash image file (SIM_FLASH) the
+ * content left by a previous run does not change the results.
+ */
+static void _cred_setup(void)
+{
+	u32  bytes, count;
+	uint i;
+
+	cred_init();
+	cred_format();
+	cred_range_begin(1, CRED_ID_MAX, cred_version());
+	while (cred_range_put(BENCH_CRED_ID(0), 1) == CRED_ST_BUSY)
+		cred_poll();
+	for (i = 1; i < BENCH_CRED_BASE; i++)
+		cred_range_put(BENCH_CRED_ID(i), 1 + (i & 0xFF));
+	cred_range_end(1);
+	while (cred_version() != 1)
+		cred_poll();
+	bytes = cred_base_size(&count);
+	log_print(0, "  cred: %u records, %u bytes, %u.%2u bytes/credential\n",
+	          count, bytes, bytes / count, ((bytes % count) * 100) / count);
+
+	for (i = 0; i < BENCH_CRED_DELTA; i++)
+	{
+		_cred_op(cred_ops, CRED_OP_MODIFY, BENCH_CRED_ID(i * 23), 0x100 + i);
+		cred_apply(cred_version(), cred_version() + 1, cred_ops, 1);
+	}
+	cred_idx = 0;
+}
+
+/**
+ * @brief Lookup of credentials (base, and overlay for some of them)
+ *
+ */
+static void _b_cred_lookup(uint n)
+{
+	while (n--)
+	{
+		cred_idx += 7919;
+		if (cred_idx >= BENCH_CRED_BASE)
+			cred_idx -= BENCH_CRED_BASE;
+		bench_sink = cred_lookup(BENCH_CRED_ID(cred_idx));
+	}
+}
+
+/**
+ * @brief Batches of 8 modifications (checked, written into the log, applied)
+ *
+ */
+static void _b_cred_apply(uint n)
+{
+	uint i;
+
+	while (n--)
+	{
+		for (i = 0; i < 8; i++)
+		{
+			cred_idx += 7919;
+			if (cred_idx >= BENCH_CRED_BASE)
+				cred_idx -= BENCH_CRED_BASE;
+			_cred_op(cred_ops + (i * CRED_OP_SIZE), CRED_OP_MODIFY,
+			         BENCH_CRED_ID(cred_idx), 2 + n);
+		}
+		bench_sink = (u32)cred_apply(cred_version(), cred_version() + 1, cred_ops, 8);
+	}
+}
+
+/**
+ * @brief Rate limiter with buckets for 64 credentials
+ *
+ */
+static void _pin_setup(void)
+{
+	uint i;
+
+	entropy_init();
+	ratelim_init();
+	for (i = 0; i < 64; i++)
+		ratelim_attempt(i % RATELIM_READERS, BENCH_CRED_ID(i));
+}
+
+/**
+ * @brief PIN attempts of known credentials (allowed or refused, same cost)
+ *
+ */
+static void _b_pin_attempt(uint n)
+{
+	while (n--)
+	{
+		bench_sink = (u32)ratelim_attempt(n % RATELIM_READERS, BENCH_CRED_ID(n & 63));
+		ratelim_result(n % RATELIM_READERS, BENCH_CRED_ID(n & 63), 0);
+	}
+}
+
+/**
+ * @brief PIN attempts of credentials not into the table (bucket replaced)
+ *
+ */
+static void _b_pin_new(uint n)
+{
+	while (n--)
+	{
+		cred_idx++;
+		bench_sink = (u32)ratelim_attempt(n % RATELIM_READERS, BENCH_CRED_ID(cred_idx));
+		ratelim_result(n % RATELIM_READERS, BENCH_CRED_ID(cred_idx), 0);
+	}
+}
+
+/**
+ * @brief Door pipeline with the credential store of the cred_* cases
+ *
+ * The profile of the credential used has no schedule. The last door is
+ * used : it has no sequencer track, the strike outputs are not measured.
+ */
+static void _pipe_setup(void)
+{
+	u32 f, p;
+	uint i;
+
+	_cred_setup();
+	_cred_op(cred_ops, CRED_OP_MODIFY, BENCH_CRED_ID(1), PIPE_SCHED_ANY);
+	cred_apply(cred_version(), cred_version() + 1, cred_ops, 1);
+	pipe_init();
+
+	// Wiegand 26 : even parity of bits 24-13, odd parity of bits 12-1
+	f = (BENCH_CRED_ID(1) & 0xFFFFFF) << 1;
+	for (i = 1, p = 1; i < 13; i++)
+		p ^= (f >> i) & 1;
+	f |= p;
+	for (i = 13, p = 0; i < 25; i++)
+		p ^= (f >> i) & 1;
+	pipe_frame[0] = f | (p << 25);
+	pipe_frame[1] = 0;
+}
+
+/**
+ * @brief Transaction of a known credential, from the read to the journal
+ *
+ */
+static void _b_pipe_txn(uint n)
+{
+	while (n--)
+	{
+		bench_sink = (u32)pipe_submit(PIPE_DOORS - 1, pipe_frame, 26);
+		while (pipe_poll())
+			;
+	}
+}
+
+/**
+ * @brief Fill the journal with 1000 events of a population of 200 badges
+ *
+ * The size of the encoded records is reported, as bytes per event.
+ */
+static void _uplink_setup(void)
+{
+	static u8 buf[UPLINK_PAYLOAD];
+	u32  badges[200];
+	u32  seed = 1, off, bytes = 0;
+	uint i;
+
+	for (i = 0; i < 200; i++)
+	{
+		seed = (seed * 1103515245) + 12345;
+		badges[i] = (seed >> 6) & 0x3FFFFFF;
+	}
+	journal_init();
+	for (i = 0; i < 1000; i++)
+	{
+		seed = (seed * 1103515245) + 12345;
+		if ((seed >> 24) < 230)
+			journal_append((seed >> 8) & 3, JOURNAL_GRANT, badges[(seed >> 12) % 200], 0);
+		else
+			journal_append((seed >> 8) & 3, JOURNAL_DENY, badges[(seed >> 12) % 200], 1 + ((seed >> 20) & 7));
+	}
+	for (off = 1; off < 1001; )
+		bytes += uplink_pack(&off, 1001, buf, UPLINK_PAYLOAD);
+	log_print(0, "  uplink: 1000 events, %u bytes, %u.%2u bytes/event\n",
+	          bytes, bytes / 1000, (bytes % 1000) / 10);
+}
+
+/**
+ * @brief Build and load a set of compiled schedules
+ *
+ * @param count Number of schedules
+ */
+static void _sched_setup(uint count)
+{
+	sched_hdr *hdr = (sched_hdr *)sched_blob;
+	u32 *p = &sched_blob[sizeof(sched_hdr) / 4];
+	u32  addr, size;
+	uint i, j;
+
+	for (i = 0; i < BENCH_CAL_WORDS; i++)
+		*p++ = 0x01010101;
+	for (i = 0; i < count; i++)
+	{
+		*p++ = 0; // Calendar 0
+		for (j = 1; j < SCHED_REC_WORDS; j++)
+			*p++ = 0x00FFFF00 ^ i;
+	}
+	size = 4 * (BENCH_CAL_WORDS + (count * SCHED_REC_WORDS));
+
+	hdr->magic     = SCHED_MAGIC;
+	hdr->version   = SCHED_VERSION;
+	hdr->count     = (u16)count;
+	hdr->calendars = 1;
+	hdr->days      = 731;
+	hdr->base_day  = 8766; // 2024-01-01
+	hdr->size      = size;
+#ifdef HOST
+	// Blob is copied into simulated SRAM2
+	addr = 0x30040000;
+	hdr->crc = 0;
+	sim_load(addr, sched_blob, sizeof(sched_hdr) + size);
+	hdr->crc = crc_compute(addr + sizeof(sched_hdr), size);
+	sim_load(addr, sched_blob, sizeof(sched_hdr));
+#else
+	addr = (u32)sched_blob;
+	hdr->crc = crc_compute(addr + sizeof(sched_hdr), size);
+#endif
+	sched_init(addr);
+}
+
+/**
+ * @brief Initialize the MAC in loopback mode
+ */
+static void _eth_setup(void)
+{
+	log_mute(1);
+	eth_init();
+	eth_loopback(1);
+	log_mute(0);
+}
+
+/**
+ * @brief Receive handler of the can_loop case
+ *
+ * @param msg Pointer to the received message
+ */
+static void _can_rx(const fdcan_msg *msg)
+{
+	bench_sink = msg->data[0];
+}
+
+/**
+ * @brief Initialize the FDCAN controller (node 0) in loopback mode
+ */
+static void _can_setup(void)
+{
+	fdcan_init(0);
+	fdcan_handler(_can_rx);
+	fdcan_loopback(1);
+}
+
+/**
+ * @brief Load 4 schedules
+ */
+static void _sched_setup4(void)
+{
+	_sched_setup(4);
+}
+
+/**
+ * @brief Load 64 schedules
+ */
+static void _sched_setup64(void)
+{
+	_sched_setup(BENCH_SCHED_MAX);
+}
+/* EOF */
@@ -0,0 +1,207 @@
+/**
+ * @file  boot.c
+ * @brief Verification of the non-secure application before launch
+ *
+ * The image of the application is followed by a header (boot_hdr) created
+ * by the host signing tool (scripts/sign_app.py). The size of the image is
+ * stored by the same tool into a reserved entry of the vector table, so the
+ * header can be found without scanning the flash.
+ *
+ * Verification is made in two steps : SHA-256 of the image (HASH fed by
+ * DMA) compared to the digest of the header, then HMAC of the header with
+ * the key stored into OBK. After a success, the result is cached into an
+ * uninitialized SRAM3 area keyed by a CRC of the image and header : the
+ * restart after a fault of the secure firmware only computes the CRC (also
+ * DMA driven) instead of a full hash. Any other reset makes a full check,
+ * the application may have rewritten its own flash before it.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "boot.h"
+#include "crash.h"
+#include "cred.h"
+#include "driver/crc.h"
+#include "driver/dma.h"
+#include "driver/hash.h"
+#include "hardware.h"
+#include "log.h"
+#include "types.h"
+
+#define CACHE_MAGIC 0xB007CAC4
+
+#if (BOOT_IMAGE_END > CRED_OFFSET)
+#error "Firmware image overlaps the credential store"
+#endif
+
+typedef struct boot_cache
+{
+	u32 magic;
+	u32 base;
+	u32 size;
+	u32 crc;
+	u32 check;
+} boot_cache;
+
+static void _flash_rd(u32 addr, void *buf, uint len);
+static u32  _cache_check(const boot_cache *c);
+
+/* Verification cache, not initialized by startup (kept on warm reset) */
+static boot_cache cache __attribute__((section(".noinit")));
+
+/**
+ * @brief Verify the image of the non-secure application
+ *
+ * @param base Address of the image (vector table)
+ * @return BOOT_OK or BOOT_OK_CACHED on success, a negative BOOT_ERR_* code
+ *         if the image must not be started
+ */
+int boot_verify(u32 base)
+{
+	u8  digest[HASH_SHA256_LEN];
+	boot_hdr hdr;
+	u32 size;
+	u32 crc;
+
+	dma_init();
+	crc_init();
+	hash_init();
+
+	/* Get image size from vector table and check it */
+	size = reg_rd(base + BOOT_SIZE_OFFS);
+	if ((size < 0x100) || (size > (BOOT_APP_MAX - sizeof(boot_hdr))) ||
+	    (size & 0xF))
+		return(BOOT_ERR_SIZE);
+
+	/* Load and check header */
+	_flash_rd(base + size, &hdr, sizeof(boot_hdr));
+	if ((hdr.magic != BOOT_MAGIC) || (hdr.size != size))
+		return(BOOT_ERR_HDR);
+
+	/* Fast path : this image has already been verified, and the reset was
+	 * made by the secure firmware itself (restart after a fault). A CRC is
+	 * not a MAC : the cache must not be used after a reset that the
+	 * application can cause, nor after a fault of the application. */
+	crc = crc_compute(base, (uint)(size + sizeof(boot_hdr)));
+	if (crash_warm() && crash_secure() &&
+	    (cache.magic == CACHE_MAGIC) &&
+	    (cache.check == _cache_check(&cache)) &&
+	    (cache.base  == base) &&
+	    (cache.size  == size) &&
+	    (cache.crc   == crc))
+		return(BOOT_OK_CACHED);
+
+	boot_invalidate();
+
+	/* Compute SHA-256 of the image using HASH and DMA */
+	hash_begin();
+	if (hash_update_dma(base, (uint)size) < 0)
+		return(BOOT_ERR_DMA);
+	hash_final(digest);
+	if ( ! hash_equal(digest, hdr.digest, HASH_SHA256_LEN))
+		return(BOOT_ERR_HASH);
+
+	/* Authenticate the header */
+	if ( ! boot_auth(&hdr))
+		return(BOOT_ERR_SIGN);
+
+	/* Save the result for next (warm) boot */
+	cache.base  = base;
+	cache.size  = hdr.size;
+	cache.crc   = crc;
+	cache.magic = CACHE_MAGIC;
+	cache.check = _cache_check(&cache);
+
+	log_print(LOG_INF, "Boot: image %32x verified (%d bytes, v%d)\n",
+	          base, hdr.size, hdr.version);
+	return(BOOT_OK);
+}
+
+/**
+ * @brief Authenticate an image header (HMAC with the OBK key)
+ *
+ * @param hdr Pointer to the header to check
+ * @return True if the MAC of the header is valid
+ */
+int boot_auth(const boot_hdr *hdr)
+{
+	return boot_mac((const u8 *)hdr, sizeof(boot_hdr) - sizeof(hdr->mac),
+	                hdr->mac);
+}
+
+/**
+ * @brief Check the HMAC-SHA256 of a message with the OBK key
+ *
+ * Also used by the services that modify the panel from the framing channel
+ * (clock, configuration, credentials) : requests are signed by the same
+ * tools as the application images.
+ *
+ * @param msg Pointer to the message
+ * @param len Length of the message in bytes
+ * @param ref Pointer to the MAC to check (32 bytes)
+ * @return True if the MAC is valid
+ */
+int boot_mac(const u8 *msg, uint len, const u8 *ref)
+{
+	u8   key[BOOT_KEY_LEN];
+	u8   mac[HASH_SHA256_LEN];
+	uint i;
+	int  result;
+
+	_flash_rd(BOOT_KEY_ADDR, key, BOOT_KEY_LEN);
+	hash_hmac(key, BOOT_KEY_LEN, msg, len, mac);
+	result = hash_equal(mac, ref, HASH_SHA256_LEN);
+	// Wipe the key copy from stack
+	for (i = 0; i < BOOT_KEY_LEN; i++)
+		((vu8 *)key)[i] = 0;
+	return(result);
+}
+
+/**
+ * @brief Invalidate the verification cache (force a full check)
+ *
+ */
+void boot_invalidate(void)
+{
+	cache.magic = 0;
+	cache.check = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Copy a flash area into a RAM buffer
+ *
+ * @param addr Address of the flash area (32 bits aligned)
+ * @param buf  Pointer to destination buffer
+ * @param len  Number of bytes to copy (multiple of 4)
+ */
+static void _flash_rd(u32 addr, void *buf, uint len)
+{
+	u32 *dst = (u32 *)buf;
+
+	for ( ; len >= 4; len -= 4, addr += 4)
+		*dst++ = reg_rd(addr);
+}
+
+/**
+ * @brief Compute the integrity word of the cache
+ *
+ * @param c Pointer to the cache entry
+ * @return u32 Integrity word
+ */
+static u32 _cache_check(const boot_cache *c)
+{
+	return ~(c->magic ^ c->base ^ c->size ^ c->crc);
+}
+/* EOF */
@@ -0,0 +1,65 @@
+/**
+ * @file  boot.h
+ * @brief Definitions and prototypes for non-secure image verification
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef BOOT_H
+#define BOOT_H
+#include "driver/flash.h"
+#include "types.h"
+
+// Location of the non-secure application
+#define BOOT_APP_BASE  0x08010000
+// End of the firmware image into a bank (secure 64 kB, application 128 kB),
+// followed by the credential store (see cred.h)
+#define BOOT_IMAGE_END 0x30000
+#define BOOT_APP_MAX   (BOOT_IMAGE_END - (BOOT_APP_BASE - FLASH_BASE_NS))
+// Offset of the image size into vector table (reserved entry, set by signer)
+#define BOOT_SIZE_OFFS 0x20
+// Address of the verification key (OBK Key1, 32 bytes)
+#define BOOT_KEY_ADDR  0x0FFD0100
+#define BOOT_KEY_LEN   32
+
+#define BOOT_MAGIC 0x43414B43 /* "CKAC" */
+
+/* Result of a verification */
+#define BOOT_OK        0
+#define BOOT_OK_CACHED 1
+#define BOOT_ERR_SIZE  -1
+#define BOOT_ERR_HDR   -2
+#define BOOT_ERR_HASH  -3
+#define BOOT_ERR_SIGN  -4
+#define BOOT_ERR_DMA   -5
+
+/**
+ * @brief Header appended to the image by the host signing tool
+ *
+ * The MAC is an HMAC-SHA256 of the header fields (magic to digest) using
+ * the verification key, digest is the SHA-256 of the image itself.
+ */
+typedef struct boot_hdr
+{
+	u32 magic;
+	u32 version;
+	u32 size;
+	u32 flags;
+	u8  digest[32];
+	u8  mac[32];
+} boot_hdr;
+
+int  boot_verify(u32 base);
+int  boot_auth(const boot_hdr *hdr);
+int  boot_mac (const u8 *msg, uint len, const u8 *ref);
+void boot_invalidate(void);
+
+#endif
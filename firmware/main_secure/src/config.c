@@ -0,0 +1,931 @@
+/**
+ * @file  config.c
+ * @brief Configuration service : option bytes and site configuration
+ *
+ * The configuration is a set of items (tag, length, value) read and
+ * modified over the framing channel. The host stages changes, then commits
+ * them as one transaction :
+ * - the site configuration (identifiers, name, addresses) is written into
+ *   the other sector of the configuration area, without header,
+ * - the option bytes staged (secure watermarks, TZEN, product state) are
+ *   written into the *_PRG registers and applied by one OPTSTRT,
+ * - the header of the new sector is written last : until then, the
+ *   previous generation stays the valid one.
+ *
+ * Stage and commit frames carry a MAC with the OBK key (see _auth) : the
+ * stages are chained up to the commit, nothing is modified without the key.
+ * A change of the product state can not be undone, it is applied only when
+ * the commit confirms it (CONFIG_F_CONFIRM).
+ *
+ * The site configuration is cached into SRAM, indexed by tag : a read does
+ * not access the flash. See doc/config.md.
+ *
+ * These functions are called from the main loop only.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "apb.h"
+#include "boot.h"
+#include "config.h"
+#include "cred.h"
+#include "driver/crc.h"
+#include "driver/dma.h"
+#include "driver/flash.h"
+#include "driver/hash.h"
+#include "driver/uart.h"
+#include "frame.h"
+#include "log.h"
+#include "uplink.h"
+
+#if ((CONFIG_OFFSET + (CONFIG_SECTS * FLASH_SECT_SIZE)) > APB_LOG_OFFSET)
+#error "Configuration area overlaps the anti-passback log"
+#endif
+
+/* Last sector of the secure watermarks. Bank 1 : the application starts at
+ * BOOT_APP_BASE. Bank 2 : the image of the other firmware, at the same
+ * offsets (an update swaps the banks), then the credential store and the
+ * other data areas of the inactive bank, written through the non-secure alias */
+#define WM1_LAST   (((BOOT_APP_BASE - FLASH_BASE_NS) / FLASH_SECT_SIZE) - 1)
+#define WM2_LAST   (((BOOT_APP_BASE - FLASH_BASE_NS) / FLASH_SECT_SIZE) - 1)
+#if (CONFIG_WM_MIN > WM1_LAST) || (CONFIG_WM_MIN > WM2_LAST)
+#error "Secure firmware does not fit below the application"
+#endif
+#if (((WM2_LAST + 1) * FLASH_SECT_SIZE) > CRED_OFFSET)
+#error "Secure sectors of bank 2 overlap the credential store"
+#endif
+
+/* Items : option bytes first, then the site configuration */
+#define SLOTS      (CONFIG_T_OB_MAX + CONFIG_SITE_TAGS)
+#define SLOT_SITE  CONFIG_T_OB_MAX
+#define MASK_OB    ((1u << CONFIG_T_OB_MAX) - 1)
+// Header of a sector (one quad-word), then the items (ended by a tag 0)
+#define BODY_MAX   (((CONFIG_SITE_TAGS * (2 + CONFIG_VAL_MAX)) + 1 + 15) & ~15u)
+// Longest set of items into one stage frame (each slot once)
+#define STAGE_MAX  (SLOTS * (2 + CONFIG_VAL_MAX))
+
+/* States of the service */
+#define ST_IDLE 0
+#define ST_OFF  1 /* Stopped (flash error, or after handover) */
+
+static void _handler(u8 type, u8 seq, const u8 *data, uint len);
+static void _reply(u8 type, u8 seq, u8 status, u32 info, uint extra);
+static int  _auth(const char *tag, const u8 *chain, const u8 *data, uint len);
+static void _link(const u8 *mac);
+static int  _slot(uint tag);
+static int  _check(uint slot, const u8 *val, uint len);
+static uint _ob_get(uint slot, u8 *val);
+static int  _ob_apply(u32 mask);
+static void _load(void);
+static int  _save(u32 addr, u32 gen, u32 mask, int header);
+static void _apply(void);
+static int  _erase(u32 addr);
+static int  _write(u32 addr, const u32 *qw);
+static u32  _addr(u32 addr);
+static u32  _le32(const u8 *p);
+
+config_stats config_stat;
+
+// Length of the value of each slot : minimum, maximum (0 : unknown tag)
+static const u8 limits[SLOTS][2] =
+{
+	{ 2, 2 }, { 2, 2 }, { 1, 1 }, { 1, 1 },           // WM1, WM2, TZEN, STATE
+	{ 4, 4 }, { 4, 4 }, { 1, CONFIG_VAL_MAX },        // SITE, PANEL, NAME
+	{ 4, 4 }, { 4, 4 },                               // IP, SERVER
+};
+// Product states, in the order of provisioning (no way back)
+static const u8 states[] =
+{
+	CONFIG_PS_OPEN, CONFIG_PS_PROV, CONFIG_PS_IROT, CONFIG_PS_TZ, CONFIG_PS_CLOSED
+};
+
+static u8  cache[SLOTS][CONFIG_VAL_MAX]; // Site items (slots of option bytes unused)
+static u8  cache_len[SLOTS];             // 0 : item not set
+static u8  stage[SLOTS][CONFIG_VAL_MAX];
+static u8  stage_len[SLOTS];             // 0 : item removed
+static u32 staged;                       // Mask of the staged slots
+static u8  chain[HASH_SHA256_LEN];       // MAC of the last stage (zero : none)
+static u8  prev[HASH_SHA256_LEN];        // MAC of the stage before it
+static u32 body[BODY_MAX / 4];
+static u8  out[9 + (CONFIG_T_OB_MAX * 4) + (CONFIG_SITE_TAGS * (2 + CONFIG_VAL_MAX))];
+
+static struct
+{
+	u32  base;  // Address of the first sector
+	uint cur;   // Current sector
+	u32  gen;   // Generation of the current sector (0 : none)
+	uint state;
+} area;
+
+/**
+ * @brief Initialize the service, load the site configuration
+ *
+ */
+void config_init(void)
+{
+#ifdef RUN_SEC
+	uint i;
+#endif
+
+	config_stat.staged    = 0;
+	config_stat.refused   = 0;
+	config_stat.commits   = 0;
+	config_stat.ob_starts = 0;
+	config_stat.flash_err = 0;
+	config_stat.auth_err  = 0;
+	staged = 0;
+	_link(0);
+	area.state = ST_IDLE;
+
+	dma_init();
+	crc_init();
+#ifdef RUN_SEC
+	// Configuration sectors are secure into both banks (block-based)
+	for (i = (CONFIG_OFFSET / FLASH_SECT_SIZE); i < ((CONFIG_OFFSET / FLASH_SECT_SIZE) + CONFIG_SECTS); i++)
+	{
+		reg_set(FLASH_SECBB1R1(FLASH) + (4 * (i / 32)), (1u << (i % 32)));
+		reg_set(FLASH_SECBB2R1(FLASH) + (4 * (i / 32)), (1u << (i % 32)));
+	}
+#endif
+	area.base = _addr(flash_inactive(CONFIG_OFFSET));
+	_load();
+	_apply();
+	frame_register(FRAME_CLASS_CONFIG, _handler);
+	log_print(0, " * CONFIG: generation %u, site %u panel %u\n",
+	          area.gen, config_u32(CONFIG_T_SITE, 0), config_u32(CONFIG_T_PANEL, 0));
+}
+
+/**
+ * @brief Stage a set of items (TLV)
+ *
+ * All items are checked first : nothing is staged when one of them is
+ * refused. A site item with a length of 0 is removed by the commit. An
+ * item staged again replaces the previous value.
+ *
+ * @param tlv Pointer to the items (u8 tag, u8 length, value)
+ * @param len Length of the items (bytes)
+ * @param bad Pointer to a variable that receives the tag of a refused item
+ * @return integer CONFIG_OK on success, a CONFIG_ST_* or FRAME_ST_* code
+ */
+int config_stage(const u8 *tlv, uint len, u8 *bad)
+{
+	u32  seen;
+	uint off, n, i;
+	int  slot;
+
+	*bad = 0;
+	if (area.state == ST_OFF)
+		return(FRAME_ST_ERR);
+	if (len == 0)
+		return(FRAME_ST_BADARG);
+	seen = 0;
+	for (off = 0; off < len; off += 2 + n)
+	{
+		*bad = tlv[off];
+		if ((off + 2) > len)
+			return(FRAME_ST_BADARG);
+		n = tlv[off + 1];
+		if ((off + 2 + n) > len)
+			return(FRAME_ST_BADARG);
+		slot = _slot(tlv[off]);
+		if ((slot < 0) || (seen & (1u << slot)) ||
+		    (_check((uint)slot, tlv + off + 2, n) < 0))
+		{
+			config_stat.refused++;
+			return(CONFIG_ST_VAL);
+		}
+		seen |= (1u << slot);
+	}
+	*bad = 0;
+
+	for (off = 0; off < len; off += 2 + n)
+	{
+		n    = tlv[off + 1];
+		slot = _slot(tlv[off]);
+		for (i = 0; i < n; i++)
+			stage[slot][i] = tlv[off + 2 + i];
+		stage_len[slot] = (u8)n;
+		config_stat.staged++;
+	}
+	staged |= seen;
+	return(CONFIG_OK);
+}
+
+/**
+ * @brief Apply the staged items
+ *
+ * A new generation of the site configuration is written (even when only
+ * option bytes are staged), then the option bytes are applied, then the
+ * header of the new generation is written. On error, the previous
+ * generation is kept and the items stay staged. Option bytes take effect
+ * on the next reset (watermarks, TZEN) or immediately (product state).
+ * A new product state is refused without CONFIG_F_CONFIRM : there is no
+ * way back.
+ *
+ * @param gen   Generation the changes are based on (must be the current one)
+ * @param flags CONFIG_F_* flags (the reset is made by the caller)
+ * @return integer CONFIG_OK on success, a CONFIG_ST_* or FRAME_ST_* code
+ */
+int config_commit(u32 gen, uint flags)
+{
+	u32  addr;
+	uint slot, i;
+	u8   cur;
+
+	if (area.state == ST_OFF)
+		return(FRAME_ST_ERR);
+	if (gen != area.gen)
+		return(CONFIG_ST_GEN);
+	if (staged == 0)
+		return(CONFIG_ST_NONE);
+	if ((staged & (1u << (CONFIG_T_STATE - 1))) && ! (flags & CONFIG_F_CONFIRM))
+	{
+		_ob_get(CONFIG_T_STATE - 1, &cur);
+		if (stage[CONFIG_T_STATE - 1][0] != cur)
+			return(CONFIG_ST_CONFIRM);
+	}
+
+	addr = area.base + ((area.cur ^ 1) * FLASH_SECT_SIZE);
+	if ((_save(addr, area.gen + 1, staged, 0) < 0) ||
+	    (_ob_apply(staged & MASK_OB) < 0) ||
+	    (_save(addr, area.gen + 1, staged, 1) < 0))
+		return(FRAME_ST_ERR);
+
+	for (slot = SLOT_SITE; slot < SLOTS; slot++)
+	{
+		if ((staged & (1u << slot)) == 0)
+			continue;
+		for (i = 0; i < stage_len[slot]; i++)
+			cache[slot][i] = stage[slot][i];
+		cache_len[slot] = stage_len[slot];
+	}
+	area.cur ^= 1;
+	area.gen++;
+	staged = 0;
+	_link(0);
+	config_stat.commits++;
+	_apply();
+	log_print(LOG_INF, " * CONFIG: generation %u committed\n", area.gen);
+	return(CONFIG_OK);
+}
+
+/**
+ * @brief Discard the staged items
+ *
+ */
+void config_abort(void)
+{
+	staged = 0;
+	_link(0);
+}
+
+/**
+ * @brief Get the number of staged items
+ *
+ * @return uint Number of items
+ */
+uint config_staged(void)
+{
+	u32  m = staged;
+	uint n = 0;
+
+	for ( ; m; m &= (m - 1))
+		n++;
+	return(n);
+}
+
+/**
+ * @brief Get the generation of the site configuration
+ *
+ * @return u32 Generation (0 : never committed)
+ */
+u32 config_gen(void)
+{
+	return(area.gen);
+}
+
+/**
+ * @brief Read a site item from the cache
+ *
+ * @param tag Tag of the item (CONFIG_T_*)
+ * @param buf Pointer to a buffer that receives the value
+ * @param max Size of the buffer
+ * @return uint Length of the value, 0 if the item is not set
+ */
+uint config_get(uint tag, u8 *buf, uint max)
+{
+	uint len, i;
+	int  slot;
+
+	slot = _slot(tag);
+	if (slot < SLOT_SITE)
+		return(0);
+	len = cache_len[slot];
+	for (i = 0; (i < len) && (i < max); i++)
+		buf[i] = cache[slot][i];
+	return(len);
+}
+
+/**
+ * @brief Read a site item of 32 bits from the cache
+ *
+ * @param tag Tag of the item (CONFIG_T_*)
+ * @param def Value returned when the item is not set
+ * @return u32 Value of the item
+ */
+u32 config_u32(uint tag, u32 def)
+{
+	int slot;
+
+	slot = _slot(tag);
+	if ((slot < SLOT_SITE) || (cache_len[slot] != 4))
+		return(def);
+	return _le32(cache[slot]);
+}
+
+/**
+ * @brief Encode items (current values) as TLV
+ *
+ * Option bytes are read from the *_CUR registers, site items from the
+ * cache. A site item that is not set is encoded with a length of 0, an
+ * unknown tag is skipped.
+ *
+ * @param tags  Pointer to the tags to read
+ * @param count Number of tags, 0 for all items
+ * @param out   Pointer to the output buffer
+ * @param max   Size of the output buffer
+ * @return uint Number of bytes written
+ */
+uint config_read(const u8 *tags, uint count, u8 *out, uint max)
+{
+	uint pos, n, i, k;
+	int  slot;
+	u8   tag;
+
+	pos = 0;
+	for (k = 0; k < (count ? count : SLOTS); k++)
+	{
+		if (count)
+		{
+			tag  = tags[k];
+			slot = _slot(tag);
+			if (slot < 0)
+				continue;
+		}
+		else
+		{
+			slot = (int)k;
+			tag  = (u8)((k < SLOT_SITE) ? (k + 1) : (CONFIG_T_SITE0 + k - SLOT_SITE));
+			if ((limits[k][1] == 0) || ((k >= SLOT_SITE) && (cache_len[k] == 0)))
+				continue;
+		}
+		n = (slot < SLOT_SITE) ? 2 : cache_len[slot];
+		if ((pos + 2 + n) > max)
+			break;
+		out[pos] = tag;
+		if (slot < SLOT_SITE)
+			n = _ob_get((uint)slot, out + pos + 2);
+		else
+			for (i = 0; i < n; i++)
+				out[pos + 2 + i] = cache[slot][i];
+		out[pos + 1] = (u8)n;
+		pos += 2 + n;
+	}
+	return(pos);
+}
+
+/**
+ * @brief Save the site configuration for the firmware of the other bank
+ *
+ * Called before a bank swap : the area of the running bank is written with
+ * the current generation, it is the inactive one after the swap. The
+ * service is then stopped until reset.
+ */
+void config_handover(void)
+{
+	u32 addr;
+
+	if (area.state == ST_OFF)
+		return;
+	addr = _addr(FLASH_BASE_NS + CONFIG_OFFSET);
+	config_abort();
+	if ((_erase(addr + FLASH_SECT_SIZE) == 0) &&
+	    (_save(addr, area.gen, 0, 0) == 0))
+		_save(addr, area.gen, 0, 1);
+	area.state = ST_OFF;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Check the MAC of a stage or commit frame
+ *
+ * The MAC is a HMAC-SHA256 with the OBK key (see boot_mac) over a tag of
+ * 4 characters, the current generation (u32 LE), the MAC of the last stage
+ * (chain) and the payload. It follows the payload into the frame.
+ *
+ * @param tag   Type of the frame ("CFGS", "CFGC")
+ * @param chain MAC of the last stage (zero before the first one)
+ * @param data  Pointer to the payload, followed by the MAC
+ * @param len   Length of the payload (without the MAC)
+ * @return integer True if the MAC is valid
+ */
+static int _auth(const char *tag, const u8 *chain, const u8 *data, uint len)
+{
+	static u8 msg[8 + HASH_SHA256_LEN + STAGE_MAX];
+	uint i, n;
+
+	for (n = 0; n < 4; n++)
+		msg[n] = (u8)tag[n];
+	msg[n++] = (u8)(area.gen >>  0);
+	msg[n++] = (u8)(area.gen >>  8);
+	msg[n++] = (u8)(area.gen >> 16);
+	msg[n++] = (u8)(area.gen >> 24);
+	for (i = 0; i < HASH_SHA256_LEN; i++)
+		msg[n++] = chain[i];
+	for (i = 0; i < len; i++)
+		msg[n++] = data[i];
+	return(boot_mac(msg, n, data + len));
+}
+
+/**
+ * @brief Move the chain of the stages to a new MAC
+ *
+ * @param mac MAC of the accepted stage, null to restart the chain
+ */
+static void _link(const u8 *mac)
+{
+	uint i;
+
+	for (i = 0; i < HASH_SHA256_LEN; i++)
+	{
+		prev[i]  = mac ? chain[i] : 0;
+		chain[i] = mac ? mac[i]   : 0;
+	}
+}
+
+/**
+ * @brief Handler of configuration frames
+ *
+ * Stage and commit frames carry a MAC (see _auth). Each stage covers the
+ * MAC of the previous one since the last commit or abort, and the commit
+ * covers the last one : a stage can not be dropped, replayed or added. The
+ * last stage is also accepted again as is (retransmission).
+ *
+ * Replies : u8 status, u32 generation, u32 info (number of staged items,
+ * or tag of a refused item), then the items for CONFIG_READ.
+ *
+ * @param type Type of the received frame
+ * @param seq  Sequence number
+ * @param data Pointer to the payload
+ * @param len  Length of the payload
+ */
+static void _handler(u8 type, u8 seq, const u8 *data, uint len)
+{
+	uint n;
+	int  result;
+	u8   bad;
+
+	switch (type)
+	{
+		case CONFIG_STATUS:
+			_reply(type, seq, (area.state == ST_OFF) ? FRAME_ST_ERR : CONFIG_OK, config_staged(), 0);
+			break;
+		case CONFIG_READ:
+			n = config_read(data, len, out + 9, sizeof(out) - 9);
+			_reply(type, seq, CONFIG_OK, config_staged(), n);
+			break;
+		case CONFIG_STAGE:
+			if ((len <= HASH_SHA256_LEN) || (len > (STAGE_MAX + HASH_SHA256_LEN)))
+			{
+				_reply(type, seq, FRAME_ST_BADARG, 0, 0);
+				break;
+			}
+			len -= HASH_SHA256_LEN;
+			bad = 0;
+			if (_auth("CFGS", chain, data, len))
+			{
+				result = config_stage(data, len, &bad);
+				if (result == CONFIG_OK)
+					_link(data + len);
+			}
+			// Retransmission of the last stage, already staged
+			else if (_auth("CFGS", prev, data, len) &&
+			         hash_equal(data + len, chain, HASH_SHA256_LEN))
+				result = CONFIG_OK;
+			else
+			{
+				config_stat.auth_err++;
+				result = CONFIG_ST_AUTH;
+			}
+			_reply(type, seq, (u8)result, (result == CONFIG_OK) ? config_staged() : bad, 0);
+			break;
+		case CONFIG_COMMIT:
+			if (len != (5 + HASH_SHA256_LEN))
+			{
+				_reply(type, seq, FRAME_ST_BADARG, config_staged(), 0);
+				break;
+			}
+			// The MAC covers the generation : another one gets CONFIG_ST_GEN
+			if ((_le32(data) == area.gen) && ! _auth("CFGC", chain, data + 4, 1))
+			{
+				config_stat.auth_err++;
+				_reply(type, seq, CONFIG_ST_AUTH, config_staged(), 0);
+				break;
+			}
+			result = config_commit(_le32(data), data[4]);
+			_reply(type, seq, (u8)result, config_staged(), 0);
+			if ((result == CONFIG_OK) && (data[4] & CONFIG_F_RESET))
+			{
+				uart_flush();
+				hw_reset();
+			}
+			break;
+		case CONFIG_ABORT:
+			config_abort();
+			_reply(type, seq, CONFIG_OK, 0, 0);
+			break;
+		default:
+			frame_reply(type, seq, FRAME_ST_UNKNOWN);
+			break;
+	}
+}
+
+/**
+ * @brief Send a reply : status, generation, info and items (already into out)
+ *
+ * @param type   Type of the request frame
+ * @param seq    Sequence number of the request frame
+ * @param status Status code
+ * @param info   Number of staged items, or tag of a refused item
+ * @param extra  Length of the items after the header
+ */
+static void _reply(u8 type, u8 seq, u8 status, u32 info, uint extra)
+{
+	out[0] = status;
+	out[1] = (u8)(area.gen >>  0);
+	out[2] = (u8)(area.gen >>  8);
+	out[3] = (u8)(area.gen >> 16);
+	out[4] = (u8)(area.gen >> 24);
+	out[5] = (u8)(info >>  0);
+	out[6] = (u8)(info >>  8);
+	out[7] = (u8)(info >> 16);
+	out[8] = (u8)(info >> 24);
+	frame_send((u8)(type | FRAME_REPLY), seq, out, 9 + extra);
+}
+
+/**
+ * @brief Get the slot of an item
+ *
+ * @param tag Tag of the item
+ * @return integer Slot, -1 for an unknown tag
+ */
+static int _slot(uint tag)
+{
+	int slot;
+
+	if ((tag >= 1) && (tag <= CONFIG_T_OB_MAX))
+		slot = (int)tag - 1;
+	else if ((tag >= CONFIG_T_SITE0) && (tag < (CONFIG_T_SITE0 + CONFIG_SITE_TAGS)))
+		slot = (int)(tag - CONFIG_T_SITE0 + SLOT_SITE);
+	else
+		return(-1);
+	if (limits[slot][1] == 0)
+		return(-1);
+	return(slot);
+}
+
+/**
+ * @brief Check the value of an item
+ *
+ * @param slot Slot of the item
+ * @param val  Pointer to the value
+ * @param len  Length of the value
+ * @return integer Zero if the value is accepted, -1 if refused
+ */
+static int _check(uint slot, const u8 *val, uint len)
+{
+	uint cur, i, j;
+
+	// A site item can be removed (length 0)
+	if ((len == 0) && (slot >= SLOT_SITE))
+		return(0);
+	if ((len < limits[slot][0]) || (len > limits[slot][1]))
+		return(-1);
+	switch (slot + 1)
+	{
+		// The secure firmware (and schedules) must stay into secure sectors
+		case CONFIG_T_WM1:
+			if ((val[0] != 0) || (val[1] < CONFIG_WM_MIN) || (val[1] > WM1_LAST))
+				return(-1);
+			break;
+		case CONFIG_T_WM2:
+			if ((val[0] != 0) || (val[1] < CONFIG_WM_MIN) || (val[1] > WM2_LAST))
+				return(-1);
+			break;
+		case CONFIG_T_TZEN:
+			if (val[0] > 1)
+				return(-1);
+			break;
+		// Product state : known value, not before the current one
+		case CONFIG_T_STATE:
+			cur = (reg_rd(FLASH_OPTSR_CUR(FLASH)) >> 8) & 0xFF;
+			for (i = 0; i < sizeof(states); i++)
+				if (states[i] == cur)
+					break;
+			for (j = 0; j < sizeof(states); j++)
+				if (states[j] == val[0])
+					break;
+			if ((j == sizeof(states)) || (i == sizeof(states)) || (j < i))
+				return(-1);
+			break;
+		case (CONFIG_T_NAME - CONFIG_T_SITE0 + SLOT_SITE + 1):
+			for (i = 0; i < len; i++)
+				if ((val[i] < 0x20) || (val[i] > 0x7E))
+					return(-1);
+			break;
+	}
+	return(0);
+}
+
+/**
+ * @brief Read the current value of an option byte item
+ *
+ * @param slot Slot of the item (option bytes)
+ * @param val  Pointer to a buffer of 2 bytes
+ * @return uint Length of the value
+ */
+static uint _ob_get(uint slot, u8 *val)
+{
+	u32 v;
+
+	switch (slot + 1)
+	{
+		case CONFIG_T_WM1:
+		case CONFIG_T_WM2:
+			v = reg_rd((slot + 1 == CONFIG_T_WM1) ? FLASH_SECWM1R_CUR(FLASH) : FLASH_SECWM2R_CUR(FLASH));
+			val[0] = (u8)(v & 0x7F);
+			val[1] = (u8)((v >> 16) & 0x7F);
+			return(2);
+		case CONFIG_T_TZEN:
+			val[0] = (((reg_rd(FLASH_OPTSR2_CUR(FLASH)) >> 24) & 0xFF) == 0xB4);
+			return(1);
+		default:
+			val[0] = (u8)(reg_rd(FLASH_OPTSR_CUR(FLASH)) >> 8);
+			return(1);
+	}
+}
+
+/**
+ * @brief Write the staged option bytes and apply them (one OPTSTRT)
+ *
+ * @param mask Staged slots of option bytes
+ * @return integer Zero on success, -1 on error
+ */
+static int _ob_apply(u32 mask)
+{
+	u32 v;
+	int result;
+
+	if (mask == 0)
+		return(0);
+	if (flash_opt_unlock() != FLASH_OK)
+	{
+		config_stat.flash_err++;
+		return(-1);
+	}
+	if (mask & (1u << (CONFIG_T_WM1 - 1)))
+	{
+		v = reg_rd(FLASH_SECWM1R_PRG(FLASH)) & ~0x007F007Fu;
+		v |= ((u32)stage[CONFIG_T_WM1 - 1][1] << 16) | stage[CONFIG_T_WM1 - 1][0];
+		reg_wr(FLASH_SECWM1R_PRG(FLASH), v);
+	}
+	if (mask & (1u << (CONFIG_T_WM2 - 1)))
+	{
+		v = reg_rd(FLASH_SECWM2R_PRG(FLASH)) & ~0x007F007Fu;
+		v |= ((u32)stage[CONFIG_T_WM2 - 1][1] << 16) | stage[CONFIG_T_WM2 - 1][0];
+		reg_wr(FLASH_SECWM2R_PRG(FLASH), v);
+	}
+	if (mask & (1u << (CONFIG_T_TZEN - 1)))
+	{
+		v = reg_rd(FLASH_OPTSR2_PRG(FLASH)) & 0x00FFFFFF;
+		v |= stage[CONFIG_T_TZEN - 1][0] ? 0xB4000000 : 0xC3000000;
+		reg_wr(FLASH_OPTSR2_PRG(FLASH), v);
+	}
+	if (mask & (1u << (CONFIG_T_STATE - 1)))
+	{
+		v = reg_rd(FLASH_OPTSR_PRG(FLASH)) & 0xFFFF00FF;
+		v |= (u32)stage[CONFIG_T_STATE - 1][0] << 8;
+		reg_wr(FLASH_OPTSR_PRG(FLASH), v);
+	}
+	result = flash_opt_start();
+	flash_opt_lock();
+	config_stat.ob_starts++;
+	if (result == FLASH_OK)
+		return(0);
+	config_stat.flash_err++;
+	return(-1);
+}
+
+/**
+ * @brief Load the newest valid generation of the site configuration
+ *
+ */
+static void _load(void)
+{
+	u32  addr, gen, len, pos;
+	uint s, i;
+	int  slot;
+	u8  *p;
+
+	area.cur = 0;
+	area.gen = 0;
+	for (s = 0; s < CONFIG_SECTS; s++)
+	{
+		addr = area.base + (s * FLASH_SECT_SIZE);
+		gen  = reg_rd(addr + 4);
+		len  = reg_rd(addr + 8);
+		if ((reg_rd(addr) != CONFIG_MAGIC) || (len > BODY_MAX) || (len % FLASH_QW_SIZE) ||
+		    (gen <= area.gen) || (crc_compute(addr + FLASH_QW_SIZE, (uint)len) != reg_rd(addr + 12)))
+			continue;
+		area.cur = s;
+		area.gen = gen;
+	}
+	for (i = 0; i < SLOTS; i++)
+		cache_len[i] = 0;
+	if (area.gen == 0)
+		return;
+
+	addr = area.base + (area.cur * FLASH_SECT_SIZE);
+	len  = reg_rd(addr + 8);
+	for (i = 0; i < (len / 4); i++)
+		body[i] = reg_rd(addr + FLASH_QW_SIZE + (i * 4));
+	p = (u8 *)body;
+	for (pos = 0; ((pos + 2) <= len) && p[pos]; pos += 2 + (u32)p[pos + 1])
+	{
+		slot = _slot(p[pos]);
+		if ((slot < SLOT_SITE) || ((pos + 2 + p[pos + 1]) > len) ||
+		    (p[pos + 1] > CONFIG_VAL_MAX))
+			continue;
+		for (i = 0; i < p[pos + 1]; i++)
+			cache[slot][i] = p[pos + 2 + i];
+		cache_len[slot] = p[pos + 1];
+	}
+}
+
+/**
+ * @brief Write a generation of the site configuration into a sector
+ *
+ * The items are the cache with the staged ones on top. The sector is
+ * erased and receives the items without header, then the header is written
+ * in a second call (commit point).
+ *
+ * @param addr   Address of the sector
+ * @param gen    Generation
+ * @param mask   Staged slots to use instead of the cache
+ * @param header Zero to write the items, non-zero to write the header
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _save(u32 addr, u32 gen, u32 mask, int header)
+{
+	const u8 *val;
+	u32  qw[4];
+	uint pos, slot, n, i;
+	u8  *p = (u8 *)body;
+
+	for (i = 0; i < (BODY_MAX / 4); i++)
+		body[i] = 0;
+	pos = 0;
+	for (slot = SLOT_SITE; slot < SLOTS; slot++)
+	{
+		n   = (mask & (1u << slot)) ? stage_len[slot] : cache_len[slot];
+		val = (mask & (1u << slot)) ? stage[slot] : cache[slot];
+		if (n == 0)
+			continue;
+		p[pos++] = (u8)(slot - SLOT_SITE + CONFIG_T_SITE0);
+		p[pos++] = (u8)n;
+		for (i = 0; i < n; i++)
+			p[pos++] = val[i];
+	}
+	// Tag 0 ends the items, the length includes it
+	pos = (pos + 1 + (FLASH_QW_SIZE - 1)) & ~(uint)(FLASH_QW_SIZE - 1);
+
+	if (header)
+	{
+		qw[0] = CONFIG_MAGIC;
+		qw[1] = gen;
+		qw[2] = pos;
+		qw[3] = crc_compute(addr + FLASH_QW_SIZE, pos);
+		return _write(addr, qw);
+	}
+	if (_erase(addr) < 0)
+		return(-1);
+	for (i = 0; i < pos; i += FLASH_QW_SIZE)
+		if (_write(addr + FLASH_QW_SIZE + i, &body[i / 4]) < 0)
+			return(-1);
+	return(0);
+}
+
+/**
+ * @brief Give the site configuration to the modules
+ *
+ */
+static void _apply(void)
+{
+	u32 ip, server;
+
+	ip     = config_u32(CONFIG_T_IP, 0);
+	server = config_u32(CONFIG_T_SERVER, 0);
+	if (ip && server)
+		uplink_config(ip, server);
+}
+
+/**
+ * @brief Erase a sector (if not blank)
+ *
+ * @param addr Address of the sector
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _erase(u32 addr)
+{
+	int  locked, result;
+	uint i;
+
+	for (i = 0; i < FLASH_SECT_SIZE; i += 4)
+		if (reg_rd(addr + i) != 0xFFFFFFFF)
+			break;
+	if (i == FLASH_SECT_SIZE)
+		return(0);
+
+	locked = flash_locked();
+	result = flash_unlock();
+	if (result == FLASH_OK)
+		result = flash_erase(addr);
+	if (locked)
+		flash_lock();
+	if (result == FLASH_OK)
+		return(0);
+	config_stat.flash_err++;
+	return(-1);
+}
+
+/**
+ * @brief Program one quad-word
+ *
+ * @param addr Address into flash (quad-word aligned)
+ * @param qw   Pointer to the data (4 words)
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _write(u32 addr, const u32 *qw)
+{
+	int locked, result;
+
+	locked = flash_locked();
+	result = flash_unlock();
+	if (result == FLASH_OK)
+		result = flash_program(addr, qw);
+	if (locked)
+		flash_lock();
+	if (result == FLASH_OK)
+		return(0);
+	config_stat.flash_err++;
+	return(-1);
+}
+
+/**
+ * @brief Get the address to use for a sector of the area
+ *
+ * @param addr Address into the flash (any alias)
+ * @return u32 Secure alias (configuration sectors are secure), or the address
+ */
+static u32 _addr(u32 addr)
+{
+#ifdef RUN_SEC
+	return (addr | FLASH_BASE_S);
+#else
+	return(addr);
+#endif
+}
+
+/**
+ * @brief Decode a little-endian 32 bits word
+ *
+ * @param p Pointer to the first byte
+ * @return u32 Decoded value
+ */
+static u32 _le32(const u8 *p)
+{
+	return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+/* EOF */
@@ -0,0 +1,99 @@
+/**
+ * @file  config.h
+ * @brief Definitions and prototypes for the configuration service
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef CONFIG_H
+#define CONFIG_H
+#include "driver/flash.h"
+#include "types.h"
+
+/* Site configuration : two sectors between the credential store and the
+ * anti-passback log, into the inactive bank. See doc/config.md */
+#define CONFIG_OFFSET 0x68000
+#define CONFIG_SECTS  2
+#define CONFIG_MAGIC  0x31474643 /* "CFG1" */
+
+/* Frames of the configuration class */
+#define CONFIG_STATUS 0x30
+#define CONFIG_READ   0x31
+#define CONFIG_STAGE  0x32
+#define CONFIG_COMMIT 0x33
+#define CONFIG_ABORT  0x34
+
+/* Items (tag of a TLV : u8 tag, u8 length, value little-endian) */
+// Option bytes, applied by CONFIG_COMMIT with one OPTSTRT
+#define CONFIG_T_WM1     0x01 /* u8 first, u8 last secure sector, bank 1 */
+#define CONFIG_T_WM2     0x02 /* u8 first, u8 last secure sector, bank 2 */
+#define CONFIG_T_TZEN    0x03 /* u8 : 1 enabled, 0 disabled              */
+#define CONFIG_T_STATE   0x04 /* u8 : PRODUCT_STATE value                 */
+#define CONFIG_T_OB_MAX  0x04
+// Site configuration, saved into flash and cached into SRAM
+#define CONFIG_T_SITE    0x10 /* u32 : site identifier                    */
+#define CONFIG_T_PANEL   0x11 /* u32 : panel number into the site         */
+#define CONFIG_T_NAME    0x12 /* text : name of the panel                 */
+#define CONFIG_T_IP      0x13 /* u32 : IPv4 address (uplink)              */
+#define CONFIG_T_SERVER  0x14 /* u32 : IPv4 address of the collector      */
+#define CONFIG_T_SITE0   0x10
+#define CONFIG_SITE_TAGS 16
+// Longest value of a site item
+#define CONFIG_VAL_MAX   32
+
+/* Product states (OPTSR, PRODUCT_STATE), in the order of provisioning */
+#define CONFIG_PS_OPEN   0xED
+#define CONFIG_PS_PROV   0x17 /* Provisioning                  */
+#define CONFIG_PS_IROT   0x2E /* iRoT-Provisioned              */
+#define CONFIG_PS_TZ     0xC6 /* TZ-Closed                     */
+#define CONFIG_PS_CLOSED 0x72
+// Secure sectors needed by this firmware (image and schedules)
+#define CONFIG_WM_MIN    7
+
+/* Flags of CONFIG_COMMIT */
+#define CONFIG_F_RESET   (1 << 0) /* Reset after the commit                  */
+#define CONFIG_F_CONFIRM (1 << 1) /* Change of the product state (no way back) */
+
+/* Result codes, also first byte of the replies (with FRAME_ST_*) */
+#define CONFIG_OK     0x00
+#define CONFIG_ST_GEN 0x10 /* Generation is not the current one     */
+#define CONFIG_ST_VAL 0x11 /* Value refused (tag into the reply)    */
+#define CONFIG_ST_NONE 0x12 /* Nothing staged                       */
+#define CONFIG_ST_AUTH 0x13 /* Bad MAC (stage or commit)            */
+#define CONFIG_ST_CONFIRM 0x14 /* Product state staged, not confirmed */
+
+/**
+ * @brief Counters of the configuration service
+ */
+typedef struct config_stats
+{
+	u32 staged;    // Items staged
+	u32 refused;   // Stage requests refused
+	u32 commits;   // Commits done
+	u32 ob_starts; // Option bytes modifications (OPTSTRT)
+	u32 flash_err; // Erase, program or option bytes errors
+	u32 auth_err;  // Stage or commit requests with a bad MAC
+} config_stats;
+
+extern config_stats config_stat;
+
+void config_init  (void);
+int  config_stage (const u8 *tlv, uint len, u8 *bad);
+int  config_commit(u32 gen, uint flags);
+void config_abort (void);
+uint config_staged(void);
+u32  config_gen   (void);
+uint config_get   (uint tag, u8 *buf, uint max);
+u32  config_u32   (uint tag, u32 def);
+uint config_read  (const u8 *tags, uint count, u8 *out, uint max);
+void config_handover(void);
+
+#endif
@@ -0,0 +1,525 @@
+/**
+ * @file  crash.c
+ * @brief Crash capture into backup SRAM and warm restart
+ *
+ * The fault handlers (HardFault, MemManage, BusFault, UsageFault and
+ * SecureFault) save the registers, the fault status, the top of the stack
+ * and the last trace events into a record of the backup SRAM, then request
+ * a system reset. The record is kept by the reset, it is reported at the
+ * next boot and can be read by the debugger or the host build
+ * (scripts/crash_decode.py).
+ *
+ * SRAM3 is also kept by the reset : modules register the structures they
+ * can reuse after a restart (crash_retain). The fault handler computes a
+ * checksum of each one, unless it was being modified (crash_dirty). After
+ * the restart, crash_intact tells a module that its structures are the same
+ * as at the time of the fault, so their rebuild can be skipped.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "crash.h"
+#include "log.h"
+#include "trace.h"
+#ifdef HOST
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+/* SCB_SHCSR : MemManage, BusFault, UsageFault and SecureFault enabled */
+#define SHCSR_FAULTS (0xFu << 16)
+/* EXC_RETURN */
+#define EXC_DCRS  (1 << 5) /* 0 : callee registers stacked before the frame */
+#define EXC_FTYPE (1 << 4) /* 0 : frame extended with FP registers        */
+#define EXC_S     (1 << 6) /* 1 : secure stack (fault of the secure code)  */
+
+static u32  _sum  (const u32 *p, u32 words);
+static u32  _check(const crash_rec *c);
+static u32  _ipsr (void);
+static int  _ram  (u32 addr, u32 len);
+#ifdef HOST
+static void _sim_signal(int sig, siginfo_t *info, void *ctx);
+#else
+void _fault_entry(void);
+#endif
+
+/**
+ * @brief Structure registered by a module (crash_retain)
+ */
+typedef struct crash_retained
+{
+	const u32 *ptr;
+	u32  words;
+	uint id;
+} crash_retained;
+
+static crash_retained retained[CRASH_REGIONS];
+static uint nretained;
+static vu32 dirty; // Mask of the structures being modified
+static int  warm;  // This boot is a restart after a fault
+#ifdef HOST
+crash_rec crash_ram;
+#endif
+
+/**
+ * @brief Read the crash record, enable the fault handlers
+ *
+ * Must be called early (after log_init), before the modules that use
+ * crash_intact. A fault that occurs before is handled, but the modules
+ * will not be able to keep their structures.
+ */
+void crash_init(void)
+{
+	crash_rec *c = CRASH_REC;
+	u32 *w = (u32 *)c;
+	uint i;
+
+	nretained = 0;
+	dirty = 0;
+	warm  = 0;
+	if ((c->magic != CRASH_MAGIC) || (c->version != CRASH_VERSION) ||
+	    (c->size != sizeof(crash_rec)) || (c->check != _check(c)))
+	{
+		// Backup domain reset, or record damaged : empty record
+		for (i = 0; i < (sizeof(crash_rec) / 4); i++)
+			w[i] = 0;
+		c->magic   = CRASH_MAGIC;
+		c->version = CRASH_VERSION;
+		c->size    = sizeof(crash_rec);
+	}
+	else if (c->pending)
+	{
+		// After a few consecutive faults, the structures kept by the
+		// restart may be the cause : they are rebuilt.
+		warm = (c->burst <= CRASH_BURST);
+		c->pending = 0;
+		crash_dump();
+	}
+	else
+		c->burst = 0;
+	c->check = _check(c);
+
+	reg_set(SCB_SHCSR, SHCSR_FAULTS);
+}
+
+/**
+ * @brief Test if this boot is a restart after a fault
+ *
+ * @return integer Non-zero for a warm restart (retained structures usable)
+ */
+int crash_warm(void)
+{
+	return(warm);
+}
+
+/**
+ * @brief Test if the last fault occurred into the secure firmware
+ *
+ * A fault raised by the non-secure application (or a SecureFault, that is
+ * an access from the non-secure world) is not trusted : the application
+ * may cause it at will.
+ *
+ * @return integer Non-zero if the fault is a fault of the secure code
+ */
+int crash_secure(void)
+{
+	const crash_rec *c = CRASH_REC;
+
+	if (c->exc == CRASH_EXC_HOST)
+		return(1);
+	return ((c->exc != CRASH_EXC_SECURE) && (c->exc_return & EXC_S));
+}
+
+/**
+ * @brief Register a structure that can be kept by a warm restart
+ *
+ * The structure must be into a section that is not initialized by the
+ * startup code (.noinit) and its length must be a multiple of 4. A module
+ * can register several structures with the same identifier, always in the
+ * same order : they are checked together by crash_intact.
+ *
+ * @param id  Identifier of the module (CRASH_R_*)
+ * @param ptr Pointer to the structure
+ * @param len Length of the structure (bytes)
+ */
+void crash_retain(uint id, const void *ptr, uint len)
+{
+	crash_retained *r;
+	uint i;
+
+	// Already registered (module initialized again)
+	for (i = 0; i < nretained; i++)
+		if (retained[i].ptr == (const u32 *)ptr)
+			return;
+	if (nretained >= CRASH_REGIONS)
+		return;
+	r = &retained[nretained++];
+	r->ptr   = (const u32 *)ptr;
+	r->words = len / 4;
+	r->id    = id;
+}
+
+/**
+ * @brief Mark the structures of a module as being modified
+ *
+ * Until crash_clean, a fault makes them invalid for the next restart.
+ *
+ * @param id Identifier of the module (CRASH_R_*)
+ */
+void crash_dirty(uint id)
+{
+	dirty |= (1u << id);
+}
+
+/**
+ * @brief Mark the structures of a module as consistent
+ *
+ * @param id Identifier of the module (CRASH_R_*)
+ */
+void crash_clean(uint id)
+{
+	dirty &= ~(1u << id);
+}
+
+/**
+ * @brief Test if the structures of a module have been kept by the restart
+ *
+ * The structures must have been registered (crash_retain) at the same
+ * place as before the fault, they must not have been modified at the time
+ * of the fault, and their content must match the checksum computed by the
+ * fault handler.
+ *
+ * @param id Identifier of the module (CRASH_R_*)
+ * @return integer Non-zero if the structures can be used without rebuild
+ */
+int crash_intact(uint id)
+{
+	const crash_rec *c = CRASH_REC;
+	const crash_region *reg;
+	crash_retained *r;
+	uint i, n;
+
+	if ( ! warm)
+		return(0);
+	n = 0;
+	for (i = 0; i < nretained; i++)
+	{
+		r = &retained[i];
+		if (r->id != id)
+			continue;
+		reg = &c->reg[i];
+		if (( ! reg->valid) ||
+		    (reg->addr != (u32)(unsigned long)r->ptr) ||
+		    (reg->len  != r->words * 4) ||
+		    (reg->sum  != _sum(r->ptr, r->words)))
+			return(0);
+		n++;
+	}
+	return(n > 0);
+}
+
+/**
+ * @brief Save the state of the CPU into the crash record, then restart
+ *
+ * Called by the fault handlers (see _fault_entry) with the exception frame
+ * and the registers r4 to r11 ; on the host build, by the signal handler
+ * without frame.
+ *
+ * @param frame      Pointer to the exception frame (may be 0)
+ * @param exc_return EXC_RETURN value of the handler
+ * @param callee     Pointer to r4-r11 (may be 0)
+ */
+void crash_fault(const u32 *frame, u32 exc_return, const u32 *callee)
+{
+	crash_rec *c = CRASH_REC;
+	const trace_ring *t = TRACE_RING;
+	crash_region *reg;
+	crash_retained *r;
+	u32 sp, head;
+	uint i, n;
+
+	c->magic   = CRASH_MAGIC;
+	c->version = CRASH_VERSION;
+	c->size    = sizeof(crash_rec);
+	c->count++;
+	c->burst++;
+	c->pending = 1;
+	c->exc = _ipsr();
+	c->exc_return = exc_return;
+	for (i = 0; i < 13; i++)
+		c->r[i] = 0;
+	c->sp = c->lr = c->pc = c->xpsr = 0;
+	c->nstack = 0;
+	if (callee)
+	{
+		for (i = 0; i < 8; i++)
+			c->r[4 + i] = callee[i];
+	}
+	// With the callee registers stacked by hardware (secure handler of a
+	// non-secure context), the basic frame is after them.
+	if (frame && ((exc_return & EXC_DCRS) == 0))
+		frame += 10;
+	if (frame && _ram((u32)(unsigned long)frame, 32))
+	{
+		c->r[0]  = frame[0];
+		c->r[1]  = frame[1];
+		c->r[2]  = frame[2];
+		c->r[3]  = frame[3];
+		c->r[12] = frame[4];
+		c->lr    = frame[5];
+		c->pc    = frame[6];
+		c->xpsr  = frame[7];
+		// Stack pointer before the exception
+		sp = (u32)(unsigned long)frame + 32;
+		if ((exc_return & EXC_FTYPE) == 0)
+			sp += 18 * 4;
+		if (c->xpsr & (1 << 9))
+			sp += 4;
+		c->sp = sp;
+		for (n = 0; n < CRASH_STACK; n++)
+		{
+			if ( ! _ram(sp + (n * 4), 4))
+				break;
+			c->stack[n] = ((const u32 *)(unsigned long)sp)[n];
+		}
+		c->nstack = n;
+	}
+	c->cfsr  = reg_rd(SCB_CFSR);
+	c->hfsr  = reg_rd(SCB_HFSR);
+	c->mmfar = reg_rd(SCB_MMFAR);
+	c->bfar  = reg_rd(SCB_BFAR);
+	c->sfsr  = reg_rd(SCB_SFSR);
+	c->sfar  = reg_rd(SCB_SFAR);
+#ifdef HOST
+	c->time = trace_time();
+#else
+	c->time = *(volatile u32 *)TRACE_CYCCNT;
+#endif
+
+	// Last events of the trace buffer, the oldest first
+	head = (t->magic == TRACE_MAGIC) ? t->head : 0;
+	for (i = 0; i < CRASH_TRACE; i++)
+	{
+		if (head < (CRASH_TRACE - i))
+		{
+			c->trace[i].time = 0;
+			c->trace[i].info = 0;
+			continue;
+		}
+		c->trace[i] = t->rec[(head - CRASH_TRACE + i) & (TRACE_SIZE - 1)];
+	}
+
+	// Checksum of the retained structures
+	for (i = 0; i < CRASH_REGIONS; i++)
+	{
+		reg = &c->reg[i];
+		if (i >= nretained)
+		{
+			reg->addr = reg->len = reg->sum = reg->valid = 0;
+			continue;
+		}
+		r = &retained[i];
+		reg->addr  = (u32)(unsigned long)r->ptr;
+		reg->len   = r->words * 4;
+		reg->sum   = _sum(r->ptr, r->words);
+		reg->valid = ((dirty & (1u << r->id)) == 0);
+	}
+
+	c->check = _check(c);
+	hw_reset();
+}
+
+/**
+ * @brief Print the content of the crash record (last fault)
+ *
+ */
+void crash_dump(void)
+{
+	static const char *names[] = {
+		"HardFault", "MemManage", "BusFault", "UsageFault", "SecureFault"
+	};
+	const crash_rec *c = CRASH_REC;
+	const char *name;
+
+	if (c->count == 0)
+	{
+		log_print(LOG_INF, " * CRASH: no fault recorded\n");
+		return;
+	}
+	if ((c->exc >= CRASH_EXC_HARD) && (c->exc <= CRASH_EXC_SECURE))
+		name = names[c->exc - CRASH_EXC_HARD];
+	else if (c->exc == CRASH_EXC_HOST)
+		name = "signal";
+	else
+		name = "unknown";
+	log_print(0, " * %{CRASH%}: %s (exception %d), %d fault(s), %d in a row\n",
+	          1, name, (int)c->exc, (int)c->count, (int)c->burst);
+	log_print(0, "   pc %32x lr %32x sp %32x xpsr %32x\n",
+	          c->pc, c->lr, c->sp, c->xpsr);
+	log_print(0, "   cfsr %32x hfsr %32x sfsr %32x\n",
+	          c->cfsr, c->hfsr, c->sfsr);
+	log_print(0, "   mmfar %32x bfar %32x sfar %32x\n",
+	          c->mmfar, c->bfar, c->sfar);
+}
+
+#ifdef HOST
+/**
+ * @brief Handle the fault signals as a fault of the target (host build)
+ *
+ * A signal saves the crash record and restarts the firmware (hw_reset).
+ */
+void crash_sim(void)
+{
+	struct sigaction sa;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = _sim_signal;
+	sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+	sigaction(SIGSEGV, &sa, 0);
+	sigaction(SIGBUS,  &sa, 0);
+	sigaction(SIGILL,  &sa, 0);
+	sigaction(SIGFPE,  &sa, 0);
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Compute the checksum of a block of words (FNV-1a)
+ *
+ * @param p     Pointer to the first word
+ * @param words Number of words
+ * @return u32 Checksum
+ */
+static u32 _sum(const u32 *p, u32 words)
+{
+	u32 h = 0x811C9DC5;
+
+	while (words--)
+		h = (h ^ *p++) * 0x01000193;
+	return(h);
+}
+
+/**
+ * @brief Compute the checksum of the crash record
+ *
+ * @param c Pointer to the record
+ * @return u32 Checksum of the fields before "check"
+ */
+static u32 _check(const crash_rec *c)
+{
+	return _sum((const u32 *)c, (sizeof(crash_rec) / 4) - 1);
+}
+
+/**
+ * @brief Read the number of the active exception
+ *
+ * @return u32 Exception number (IPSR), CRASH_EXC_HOST on the host build
+ */
+static u32 _ipsr(void)
+{
+#ifdef HOST
+	return(CRASH_EXC_HOST);
+#else
+	u32 ipsr;
+
+	asm volatile("mrs %0, ipsr" : "=r" (ipsr));
+	return(ipsr & 0x1FF);
+#endif
+}
+
+/**
+ * @brief Test if a block can be read by the fault handler
+ *
+ * A corrupted stack pointer must not cause a second fault (lockup) : only
+ * the SRAM blocks are read.
+ *
+ * @param addr Address of the block
+ * @param len  Length of the block (bytes)
+ * @return integer Non-zero if the block is into SRAM
+ */
+static int _ram(u32 addr, u32 len)
+{
+	if (addr & 3)
+		return(0);
+	if ((addr >= 0x20000000) && (addr + len <= 0x200A0000))
+		return(1);
+	if ((addr >= 0x30000000) && (addr + len <= 0x300A0000))
+		return(1);
+	return(0);
+}
+
+#ifdef HOST
+/**
+ * @brief Signal handler of the host build, simulated fault
+ *
+ * The faulting address is saved as the MemManage address (low word).
+ * After CRASH_BURST consecutive faults, the host build is stopped.
+ *
+ * @param sig  Number of the signal
+ * @param info Signal information (faulting address)
+ * @param ctx  Context of the thread (unused)
+ */
+static void _sim_signal(int sig, siginfo_t *info, void *ctx)
+{
+	(void)ctx;
+
+	if (CRASH_REC->burst >= CRASH_BURST)
+	{
+		signal(sig, SIG_DFL);
+		raise(sig);
+		abort();
+	}
+	reg_wr(SCB_CFSR,  (1 << 1) | (1 << 7)); // DACCVIOL, MMARVALID
+	reg_wr(SCB_MMFAR, (u32)(unsigned long)info->si_addr);
+	crash_fault(0, 0, 0);
+}
+#else
+/**
+ * @brief Entry of the fault handlers
+ *
+ * Find the exception frame from EXC_RETURN (secure or non-secure stack,
+ * main or process), save r4-r11 on the handler stack then call crash_fault.
+ */
+__attribute__((naked)) void _fault_entry(void)
+{
+	asm volatile(
+		"tst   lr, #0x40      \n" // S : frame on the secure stack
+		"beq   1f             \n"
+		"tst   lr, #0x04      \n" // SPSEL : process stack
+		"ite   eq             \n"
+		"mrseq r0, msp        \n"
+		"mrsne r0, psp        \n"
+		"b     2f             \n"
+		"1:                   \n"
+		"tst   lr, #0x04      \n"
+		"ite   eq             \n"
+		"mrseq r0, msp_ns     \n"
+		"mrsne r0, psp_ns     \n"
+		"2:                   \n"
+		"mov   r1, lr         \n"
+		"push  {r4-r11}       \n"
+		"mov   r2, sp         \n"
+		"b     crash_fault    \n"
+	);
+}
+
+void HardFault_Handler  (void) __attribute__((alias("_fault_entry")));
+void MemManage_Handler  (void) __attribute__((alias("_fault_entry")));
+void BusFault_Handler   (void) __attribute__((alias("_fault_entry")));
+void Usage_Fault        (void) __attribute__((alias("_fault_entry")));
+void SecureFault_Handler(void) __attribute__((alias("_fault_entry")));
+#endif
+/* EOF */
@@ -0,0 +1,100 @@
+/**
+ * @file  crash.h
+ * @brief Definitions and prototypes for the crash capture (fault handlers)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef CRASH_H
+#define CRASH_H
+#include "hardware.h"
+#include "trace.h"
+#include "types.h"
+
+#define CRASH_MAGIC   0x48535243 /* "CRSH" */
+#define CRASH_VERSION 1
+// Words of the stack copied above the exception frame
+#define CRASH_STACK   64
+// Last events of the trace buffer
+#define CRASH_TRACE   32
+// Retained structures checked after a restart (all modules)
+#define CRASH_REGIONS 8
+// Consecutive faults before the retained structures are no more used
+#define CRASH_BURST   3
+
+/* Retained structures (SRAM3, kept by a warm restart) */
+#define CRASH_R_CRED 0 /* Credential store : state, overlay, fence index */
+#define CRASH_R_MAX  1
+
+/* Exceptions (IPSR), CRASH_EXC_HOST for a signal of the host build */
+#define CRASH_EXC_HARD   3
+#define CRASH_EXC_MEM    4
+#define CRASH_EXC_BUS    5
+#define CRASH_EXC_USAGE  6
+#define CRASH_EXC_SECURE 7
+#define CRASH_EXC_HOST   0xFF
+
+/**
+ * @brief Retained structure, as seen by the fault handler
+ */
+typedef struct crash_region
+{
+	u32 addr;
+	u32 len;
+	u32 sum;   // Checksum of the content at the time of the fault
+	u32 valid; // Non-zero if the structure was not being modified
+} crash_region;
+
+/**
+ * @brief Crash record, into backup SRAM (see scripts/crash_decode.py)
+ */
+typedef struct crash_rec
+{
+	u32 magic;      // CRASH_MAGIC
+	u16 version;    // CRASH_VERSION
+	u16 size;       // Size of the record (bytes)
+	u32 count;      // Faults since the backup domain reset
+	u32 burst;      // Consecutive faults (no normal boot between them)
+	u32 pending;    // Non-zero until the restart has been handled
+	u32 exc;        // Exception number (CRASH_EXC_*)
+	u32 exc_return; // EXC_RETURN value of the fault handler
+	u32 r[13];      // r0 to r12
+	u32 sp, lr, pc, xpsr;
+	u32 cfsr, hfsr, mmfar, bfar, sfsr, sfar;
+	u32 time;       // Time of the fault (same counter as the trace)
+	u32 nstack;     // Words of stack copied
+	crash_region reg[CRASH_REGIONS];
+	u32 stack[CRASH_STACK];
+	trace_rec trace[CRASH_TRACE];
+	u32 check;      // Checksum of the record (up to this field)
+} crash_rec;
+
+#ifdef HOST
+extern crash_rec crash_ram;
+#define CRASH_REC (&crash_ram)
+#else
+#define CRASH_REC ((crash_rec *)BKPSRAM)
+#endif
+
+void crash_init  (void);
+int  crash_warm  (void);
+int  crash_secure(void);
+void crash_retain(uint id, const void *ptr, uint len);
+void crash_dirty (uint id);
+void crash_clean (uint id);
+int  crash_intact(uint id);
+void crash_fault (const u32 *frame, u32 exc_return, const u32 *callee);
+void crash_dump  (void);
+#ifdef HOST
+void crash_sim   (void);
+#endif
+
+#endif
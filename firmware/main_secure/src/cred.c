@@ -0,0 +1,1492 @@
+/**
+ * @file  cred.c
+ * @brief Credential store with versioned delta synchronization
+ *
+ * Credentials (identifier and access profile) are kept into flash, into
+ * one of two areas reserved after the firmware image of the inactive bank
+ * (programmed without stall of the code fetches). An area holds a base,
+ * sorted by identifier, followed by a delta log. Each generation of the
+ * store has a version number given by the host.
+ *
+ * The base is made of blocks of 256 bytes : records are coded as the
+ * difference with the previous identifier, then bit-packed with the
+ * widths of the block. The first identifier of each block is kept into
+ * SRAM (fence index) : a lookup decodes one block.
+ *
+ * The host sends batches of operations (add, modify, revoke) against a
+ * base version. A batch is checked against the store, written into the
+ * delta log then closed by a commit record carrying the new version : the
+ * switch to the new generation is atomic, a batch without commit record
+ * is ignored at boot. Changes are kept into SRAM (overlay, sorted) on top
+ * of the base, which is not rebuilt.
+ *
+ * When the base version does not match (gap) or an operation does not
+ * match the content (conflict), the batch is refused. The host then finds
+ * the ranges that differ (digests) and sends the content of these ranges :
+ * a new area is written with the current content outside the range and
+ * the received one inside. The same copy (without range) compacts the
+ * overlay into a new base when the log is full. The header of the new area
+ * is written last, the area with the newest header is used at boot.
+ * See doc/credentials.md.
+ *
+ * The store state, the overlay and the fence index are kept into SRAM3
+ * (.noinit) : after a warm restart (fault), they are used without reload
+ * when the crash record shows they were consistent (see crash.c).
+ *
+ * These functions are called from the main loop only.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "apb.h"
+#include "boot.h"
+#include "config.h"
+#include "crash.h"
+#include "cred.h"
+#include "driver/crc.h"
+#include "driver/dma.h"
+#include "driver/flash.h"
+#include "driver/hash.h"
+#include "frame.h"
+#include "hardware.h"
+#include "log.h"
+
+#if ((CRED_OFFSET + (2 * CRED_AREA_SIZE)) > CONFIG_OFFSET)
+#error "Credential store overlaps the configuration area"
+#endif
+
+/* States of the store */
+#define ST_IDLE  0
+#define ST_BUILD 1 /* New area being written (batches refused) */
+#define ST_OFF   2 /* Stopped (flash error, or after handover)  */
+
+/* Steps of the copy into a new area */
+#define B_ERASE 0
+#define B_HEAD  1 /* Records before the range             */
+#define B_RANGE 2 /* Records of the range, sent by host   */
+#define B_TAIL  3 /* Records after the range              */
+#define B_DONE  4
+
+/**
+ * @brief Record of the base or of the overlay (attr 0 : revoked)
+ */
+typedef struct cred_rec
+{
+	u32 id;
+	u32 attr;
+} cred_rec;
+
+/**
+ * @brief Position into the base (block decoder)
+ */
+typedef struct cred_dec
+{
+	u32  addr; // Address of the current block
+	u32  blk;  // Current block
+	u32  id;   // Identifier of the last record read
+	u32  bit;  // Position of the next record into the block (bits)
+	u32  word; // Word of the block that contains this position
+	uint left; // Records left into the block
+	uint dw;   // Width of the differences (bits)
+	uint aw;   // Width of the access profiles (bits)
+} cred_dec;
+
+/**
+ * @brief Position into the content (base and overlay, by identifier)
+ */
+typedef struct cred_view
+{
+	cred_dec dec; // Position into the base
+	cred_rec b;   // Next record of the base (id 0 : end of the base)
+	uint     oi;  // Next record of the overlay
+} cred_view;
+
+static int  _auth(const char *tag, const u8 *chain, const u8 *data, uint len);
+static void _handler(u8 type, u8 seq, const u8 *data, uint len);
+static void _reply(u8 type, u8 seq, u8 status, u32 info);
+static u32  _base_get(u32 id);
+static u32  _fence_find(u32 id);
+static void _fence_load(void);
+static void _dec_block(cred_dec *dec, u32 blk);
+static void _dec_rec(cred_dec *dec, cred_rec *rec);
+static int  _dec_next(cred_dec *dec, cred_rec *rec);
+static u32  _dec_bits(cred_dec *dec, uint width);
+static uint _delta_find(u32 id);
+static int  _put(u32 id, u32 attr);
+static void _view_seek(cred_view *cur, u32 id);
+static int  _view_next(cred_view *cur, cred_rec *rec);
+static void _load(void);
+static void _replay(u32 from, u32 to);
+static void _build_start(u32 addr, u32 lo, u32 hi);
+static void _build_step(void);
+static int  _build_put(u32 id, u32 attr);
+static int  _build_flush(void);
+static void _build_finish(void);
+static int  _erase(u32 addr);
+static int  _write(u32 addr, const u32 *qw);
+static u32  _area(uint area);
+static u32  _addr(u32 addr);
+static u32  _mix(u32 x);
+static uint _width(u32 x);
+static u32  _le32(const u8 *p);
+
+cred_stats cred_stat;
+
+/* Kept by a warm restart (crash_intact) */
+static cred_rec delta[CRED_DELTA_MAX] __attribute__((section(".noinit")));
+static uint     delta_len __attribute__((section(".noinit")));
+static u32      fence[CRED_BLK_MAX] __attribute__((section(".noinit"))); // First identifier of each block
+static u32      conflict; // Identifier of the last conflict
+
+static struct
+{
+	u32  base;    // Address of the first area
+	uint area;    // Current area
+	uint valid;   // Current area has a valid header
+	u32  seq;     // Sequence of the current area
+	u32  version; // Version of the current generation
+	u32  count;   // Credentials (base and overlay)
+	u32  nbase;   // Records of the base
+	u32  nblk;    // Blocks of the base
+	u32  cap;     // Credentials of the last base that did not fit
+	u32  wr;      // Offset of the next record of the delta log
+	uint state;
+} store __attribute__((section(".noinit")));
+
+static struct
+{
+	u32  addr;    // Address of the area being written
+	u32  lo, hi;  // Range received from the host (none if lo > hi)
+	u32  version; // Version of the new generation
+	u32  last;    // Last identifier written
+	u32  count;   // Records written
+	u32  nblk;    // Blocks written
+	u32  wr;      // Offset of the next block
+	uint n;       // Records of the block being filled
+	uint dw, aw;  // Widths of the block being filled
+	cred_rec rec[CRED_BLK_RECS];
+	u32  blk[CRED_BLK_SIZE / 4];
+	uint sect;
+	uint phase;
+	uint handover;
+	cred_view cur;
+	u8   chain[HASH_SHA256_LEN]; // MAC of the last frame of the range
+	u8   prev[HASH_SHA256_LEN];  // MAC of the frame before (retransmission)
+} build;
+
+/**
+ * @brief Initialize the store, reload the current generation
+ *
+ * After a warm restart, the store kept into SRAM is used when it was not
+ * being modified at the time of the fault : the base and the delta log are
+ * not read again.
+ */
+void cred_init(void)
+{
+	u32 base;
+#ifdef RUN_SEC
+	uint i;
+#endif
+
+	cred_stat.batches   = 0;
+	cred_stat.ops       = 0;
+	cred_stat.rejected  = 0;
+	cred_stat.auth_err  = 0;
+	cred_stat.replayed  = 0;
+	cred_stat.builds    = 0;
+	cred_stat.flash_err = 0;
+
+	dma_init();
+	crc_init();
+#ifdef RUN_SEC
+	// Store sectors are secure into both banks (block-based security)
+	for (i = (CRED_OFFSET / FLASH_SECT_SIZE); i < ((CRED_OFFSET / FLASH_SECT_SIZE) + (2 * CRED_AREA_SECTS)); i++)
+	{
+		reg_set(FLASH_SECBB1R1(FLASH) + (4 * (i / 32)), (1u << (i % 32)));
+		reg_set(FLASH_SECBB2R1(FLASH) + (4 * (i / 32)), (1u << (i % 32)));
+	}
+#endif
+	base = _addr(flash_inactive(CRED_OFFSET));
+	crash_retain(CRASH_R_CRED, &store, sizeof(store));
+	crash_retain(CRASH_R_CRED, &delta_len, sizeof(delta_len));
+	crash_retain(CRASH_R_CRED, delta, sizeof(delta));
+	crash_retain(CRASH_R_CRED, fence, sizeof(fence));
+	if (crash_intact(CRASH_R_CRED) && (store.state == ST_IDLE) && (store.base == base))
+		log_print(0, " * CRED: store kept by the restart\n");
+	else
+	{
+		crash_dirty(CRASH_R_CRED);
+		store.state = ST_IDLE;
+		store.cap   = 0xFFFFFFFF;
+		store.base  = base;
+		_load();
+		crash_clean(CRASH_R_CRED);
+	}
+	frame_register(FRAME_CLASS_CRED, _handler);
+	log_print(0, " * CRED: %u credentials (version %u, %u blocks)\n",
+	          store.count, store.version, store.nblk);
+}
+
+/**
+ * @brief Erase the store (empty content, version 0)
+ *
+ * Both areas are erased then an empty base is written. This takes some
+ * time, it is used by the benchmarks and for a factory reset.
+ *
+ * @return integer Zero on success, -1 on flash error
+ */
+int cred_format(void)
+{
+	uint i;
+
+	// Left dirty on error : the store is reloaded by a restart
+	crash_dirty(CRASH_R_CRED);
+	store.state = ST_IDLE;
+	for (i = 0; i < CRED_AREA_SECTS; i++)
+	{
+		if ((_erase(_area(0) + (i * FLASH_SECT_SIZE)) < 0) ||
+		    (_erase(_area(1) + (i * FLASH_SECT_SIZE)) < 0))
+			return(-1);
+	}
+	store.valid   = 0;
+	store.area    = 1;
+	store.seq     = 0;
+	store.version = 0;
+	store.count   = 0;
+	store.nbase   = 0;
+	store.nblk    = 0;
+	store.cap     = 0xFFFFFFFF;
+	delta_len     = 0;
+	_build_start(_area(0), 0xFFFFFFFF, 0);
+	while (store.state == ST_BUILD)
+		_build_step();
+	if (store.state != ST_IDLE)
+		return(-1);
+	crash_clean(CRASH_R_CRED);
+	return(0);
+}
+
+/**
+ * @brief Get the access profile of a credential
+ *
+ * @param id Credential identifier
+ * @return u32 Access profile, 0 if the credential is unknown (or revoked)
+ */
+HOT_FCT u32 cred_lookup(u32 id)
+{
+	uint i;
+
+	i = _delta_find(id);
+	if ((i < delta_len) && (delta[i].id == id))
+		return(delta[i].attr);
+	return _base_get(id);
+}
+
+/**
+ * @brief Get the version of the current generation
+ *
+ * @return u32 Version (0 for an empty store)
+ */
+u32 cred_version(void)
+{
+	return(store.version);
+}
+
+/**
+ * @brief Get the number of credentials
+ *
+ * @return u32 Number of credentials
+ */
+u32 cred_count(void)
+{
+	return(store.count);
+}
+
+/**
+ * @brief Get the size of the base into flash
+ *
+ * @param count Pointer to a variable that receives the number of records
+ * @return u32 Size of the blocks of the base (bytes)
+ */
+u32 cred_base_size(u32 *count)
+{
+	*count = store.nbase;
+	return(store.nblk * CRED_BLK_SIZE);
+}
+
+/**
+ * @brief Apply a batch of operations
+ *
+ * All operations are checked first : nothing is changed when one of them
+ * is refused. An identifier can be used only once into a batch. A malformed
+ * operation is refused (BADARG) before it is compared with the store.
+ *
+ * @param base    Version the batch is based on (must be the current one)
+ * @param version Version of the new generation
+ * @param ops     Pointer to the operations (u8 op, u32 id, u32 attr)
+ * @param count   Number of operations
+ * @return integer CRED_OK on success, a CRED_ST_* or FRAME_ST_* code
+ */
+int cred_apply(u32 base, u32 version, const u8 *ops, uint count)
+{
+	u32  qw[4];
+	u32  id, attr, cur;
+	uint grow, i, j, op;
+
+	if (store.state != ST_IDLE)
+		return (store.state == ST_BUILD) ? CRED_ST_BUSY : FRAME_ST_ERR;
+	if ((count == 0) || (count > CRED_BATCH_MAX))
+		return(FRAME_ST_BADARG);
+	if (base != store.version)
+	{
+		cred_stat.rejected++;
+		return(CRED_ST_GAP);
+	}
+	if (version == base)
+		return(FRAME_ST_BADARG);
+
+	grow = 0;
+	for (i = 0; i < count; i++)
+	{
+		op   = ops[i * CRED_OP_SIZE];
+		id   = _le32(ops + (i * CRED_OP_SIZE) + 1);
+		attr = _le32(ops + (i * CRED_OP_SIZE) + 5);
+		if ((id == 0) || (id > CRED_ID_MAX))
+			return(FRAME_ST_BADARG);
+		if ((op > CRED_OP_REVOKE) || (op == 0) ||
+		    ((op != CRED_OP_REVOKE) && (attr == 0)))
+			return(FRAME_ST_BADARG);
+		for (j = 0; j < i; j++)
+			if (_le32(ops + (j * CRED_OP_SIZE) + 1) == id)
+				return(FRAME_ST_BADARG);
+		cur = cred_lookup(id);
+		if (((op == CRED_OP_ADD) && cur) ||
+		    ((op != CRED_OP_ADD) && (cur == 0)))
+		{
+			conflict = id;
+			cred_stat.rejected++;
+			return(CRED_ST_CONFLICT);
+		}
+		j = _delta_find(id);
+		if ((j >= delta_len) || (delta[j].id != id))
+			grow++;
+	}
+	// No space for the batch : compact the overlay into a new base first
+	if (((delta_len + grow) > CRED_DELTA_MAX) ||
+	    ((store.wr + ((((count + 1) / 2) + 1) * FLASH_QW_SIZE)) > CRED_AREA_SIZE))
+	{
+		cred_stat.rejected++;
+		if (store.count >= store.cap)
+			return(CRED_ST_FULL);
+		_build_start(_area(store.area ^ 1), 0xFFFFFFFF, 0);
+		return(CRED_ST_BUSY);
+	}
+
+	// Operations, two by quad-word, then the commit record. The store is
+	// left dirty on a flash error : a restart reloads it from the log.
+	crash_dirty(CRASH_R_CRED);
+	for (i = 0; i < count; i += 2)
+	{
+		for (j = 0; j < 2; j++)
+		{
+			qw[2 * j] = 0;
+			qw[(2 * j) + 1] = 0;
+			if ((i + j) >= count)
+				continue;
+			op = ops[(i + j) * CRED_OP_SIZE];
+			qw[2 * j] = _le32(ops + ((i + j) * CRED_OP_SIZE) + 1);
+			if (op != CRED_OP_REVOKE)
+				qw[(2 * j) + 1] = _le32(ops + ((i + j) * CRED_OP_SIZE) + 5);
+		}
+		if (_write(_area(store.area) + store.wr, qw) < 0)
+			return(FRAME_ST_ERR);
+		store.wr += FLASH_QW_SIZE;
+	}
+	qw[0] = 0;
+	qw[1] = CRED_COMMIT;
+	qw[2] = version;
+	qw[3] = ~version;
+	if (_write(_area(store.area) + store.wr, qw) < 0)
+		return(FRAME_ST_ERR);
+	store.wr += FLASH_QW_SIZE;
+
+	for (i = 0; i < count; i++)
+	{
+		op = ops[i * CRED_OP_SIZE];
+		attr = (op == CRED_OP_REVOKE) ? 0 : _le32(ops + (i * CRED_OP_SIZE) + 5);
+		_put(_le32(ops + (i * CRED_OP_SIZE) + 1), attr);
+	}
+	store.version = version;
+	crash_clean(CRASH_R_CRED);
+	cred_stat.batches++;
+	cred_stat.ops += count;
+	return(CRED_OK);
+}
+
+/**
+ * @brief Start the resynchronization of a range of identifiers
+ *
+ * A new area is written : current content before the range, then the
+ * records sent with cred_range_put, then current content after the range.
+ * Credentials of the range that are not sent are revoked.
+ *
+ * @param lo   First identifier of the range
+ * @param hi   Last identifier of the range
+ * @param base Version the content is based on (must be the current one)
+ * @return integer CRED_OK on success, a CRED_ST_* or FRAME_ST_* code
+ */
+int cred_range_begin(u32 lo, u32 hi, u32 base)
+{
+	if (store.state != ST_IDLE)
+		return (store.state == ST_BUILD) ? CRED_ST_BUSY : FRAME_ST_ERR;
+	if ((lo == 0) || (lo > hi) || (hi > CRED_ID_MAX))
+		return(FRAME_ST_BADARG);
+	if (base != store.version)
+		return(CRED_ST_GAP);
+	_build_start(_area(store.area ^ 1), lo, hi);
+	return(CRED_OK);
+}
+
+/**
+ * @brief Add a record to the range being resynchronized
+ *
+ * Records must be sent by increasing identifier. A record already
+ * received (retransmission) is ignored.
+ *
+ * @param id   Credential identifier (into the range)
+ * @param attr Access profile (not 0)
+ * @return integer CRED_OK on success, a CRED_ST_* or FRAME_ST_* code
+ */
+int cred_range_put(u32 id, u32 attr)
+{
+	if ((store.state != ST_BUILD) || (build.lo > build.hi))
+		return(FRAME_ST_STATE);
+	if (build.phase < B_RANGE)
+		return(CRED_ST_BUSY);
+	if (build.phase != B_RANGE)
+		return(FRAME_ST_STATE);
+	if (build.count && (id <= build.last))
+		return(CRED_OK);
+	if ((id < build.lo) || (id > build.hi) || (attr == 0))
+		return(FRAME_ST_BADARG);
+	if (_build_put(id, attr) < 0)
+		return (store.state == ST_OFF) ? FRAME_ST_ERR : CRED_ST_FULL;
+	return(CRED_OK);
+}
+
+/**
+ * @brief End of the range, the new area is completed by cred_poll
+ *
+ * @param version Version of the new generation
+ * @return integer CRED_OK on success, a FRAME_ST_* code
+ */
+int cred_range_end(u32 version)
+{
+	if ((store.state != ST_BUILD) || (build.phase != B_RANGE))
+		return(FRAME_ST_STATE);
+	if (version == store.version)
+		return(FRAME_ST_BADARG);
+	build.version = version;
+	_view_seek(&build.cur, build.hi + 1);
+	build.phase = B_TAIL;
+	return(CRED_OK);
+}
+
+/**
+ * @brief Compute the digest of a range of identifiers
+ *
+ * The digest is the sum of a hash of each record (identifier, profile),
+ * the host computes it on its own database to find ranges that differ.
+ *
+ * @param lo    First identifier of the range
+ * @param hi    Last identifier of the range
+ * @param count Pointer to a variable that receives the number of records
+ * @return u32 Digest of the range
+ */
+u32 cred_digest(u32 lo, u32 hi, u32 *count)
+{
+	cred_view cur;
+	cred_rec  rec;
+	u32 d = 0;
+
+	*count = 0;
+	_view_seek(&cur, lo);
+	while (_view_next(&cur, &rec) && (rec.id <= hi))
+	{
+		d += _mix(rec.id ^ _mix(rec.attr));
+		*count += 1;
+	}
+	return(d);
+}
+
+/**
+ * @brief Advance the writing of a new area, start a compaction if needed
+ *
+ */
+void cred_poll(void)
+{
+	if (store.state == ST_BUILD)
+	{
+		_build_step();
+		return;
+	}
+	// Compact before a batch is refused : overlay or log three quarters full
+	if ((store.state == ST_IDLE) && (store.count < store.cap) &&
+	    ((delta_len > ((CRED_DELTA_MAX / 4) * 3)) ||
+	     (store.wr > (CRED_AREA_SIZE - (CRED_LOG_MIN / 4)))))
+		_build_start(_area(store.area ^ 1), 0xFFFFFFFF, 0);
+}
+
+/**
+ * @brief Save the store for the firmware of the other bank (before a swap)
+ *
+ * The store area of the running bank is written with the current content :
+ * after the swap, this bank is the inactive one. The store is then stopped
+ * until reset. This takes some time and stalls the code fetches.
+ */
+void cred_handover(void)
+{
+	u32 addr;
+
+	if (store.state == ST_OFF)
+		return;
+	addr = _addr(FLASH_BASE_NS + CRED_OFFSET);
+	// Header of the second area, may be newer than the current one
+	if (_erase(addr + CRED_AREA_SIZE) < 0)
+		return;
+	_build_start(addr, 0xFFFFFFFF, 0);
+	build.handover = 1;
+	while (store.state == ST_BUILD)
+		_build_step();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Check the MAC of a credential frame
+ *
+ * The MAC is a HMAC-SHA256 with the OBK key (see boot_mac) over a tag of
+ * 4 characters, the MAC of the previous frame of the range (chain, if any)
+ * and the payload. It follows the payload into the frame.
+ *
+ * @param tag   Type of the frame ("CRDB", "CRRB", "CRRD", "CRRE", "CRRA")
+ * @param chain MAC of the previous frame (may be null)
+ * @param data  Pointer to the payload, followed by the MAC
+ * @param len   Length of the payload (without the MAC)
+ * @return integer True if the MAC is valid
+ */
+static int _auth(const char *tag, const u8 *chain, const u8 *data, uint len)
+{
+	static u8 msg[4 + HASH_SHA256_LEN + FRAME_MAX];
+	uint i, n;
+
+	for (n = 0; n < 4; n++)
+		msg[n] = (u8)tag[n];
+	for (i = 0; chain && (i < HASH_SHA256_LEN); i++)
+		msg[n++] = chain[i];
+	for (i = 0; i < len; i++)
+		msg[n++] = data[i];
+	return(boot_mac(msg, n, data + len));
+}
+
+/**
+ * @brief Handler of credential frames
+ *
+ * Batches and range frames carry a MAC (see _auth). The frames of a range
+ * are chained : each MAC covers the MAC of the previous frame, so a frame
+ * can not be dropped, reordered or taken from another range. The last
+ * frame is also accepted again as is (retransmission). An abort is signed
+ * over the current chain : it stops only the range it was signed for.
+ *
+ * Replies : u8 status, u32 version, u32 info (number of credentials, or
+ * identifier of the conflict, or last identifier received for a range).
+ *
+ * @param type Type of the received frame
+ * @param seq  Sequence number
+ * @param data Pointer to the payload
+ * @param len  Length of the payload
+ */
+static void _handler(u8 type, u8 seq, const u8 *data, uint len)
+{
+	u8   buf[13];
+	u32  d, n;
+	uint i;
+	int  result;
+
+	switch (type)
+	{
+		case CRED_STATUS:
+			_reply(type, seq, (store.state == ST_BUILD) ? CRED_ST_BUSY : CRED_OK, store.count);
+			break;
+		case CRED_BATCH:
+			if ((len < (8 + CRED_OP_SIZE + HASH_SHA256_LEN)) ||
+			    ((len - 8 - HASH_SHA256_LEN) % CRED_OP_SIZE))
+			{
+				_reply(type, seq, FRAME_ST_BADARG, store.count);
+				break;
+			}
+			len -= HASH_SHA256_LEN;
+			if ( ! _auth("CRDB", 0, data, len))
+			{
+				cred_stat.auth_err++;
+				_reply(type, seq, CRED_ST_AUTH, store.count);
+				break;
+			}
+			result = cred_apply(_le32(data), _le32(data + 4), data + 8, (len - 8) / CRED_OP_SIZE);
+			_reply(type, seq, (u8)result, (result == CRED_ST_CONFLICT) ? conflict : store.count);
+			break;
+		case CRED_DIGEST:
+			if (len != 8)
+			{
+				_reply(type, seq, FRAME_ST_BADARG, 0);
+				break;
+			}
+			d = cred_digest(_le32(data), _le32(data + 4), &n);
+			for (i = 0; i < 4; i++)
+			{
+				buf[1 + i] = (u8)(store.version >> (8 * i));
+				buf[5 + i] = (u8)(n >> (8 * i));
+				buf[9 + i] = (u8)(d >> (8 * i));
+			}
+			buf[0] = CRED_OK;
+			frame_send((u8)(type | FRAME_REPLY), seq, buf, 13);
+			break;
+		case CRED_RANGE_BEGIN:
+			if (len != (12 + HASH_SHA256_LEN))
+			{
+				_reply(type, seq, FRAME_ST_BADARG, 0);
+				break;
+			}
+			if ( ! _auth("CRRB", 0, data, 12))
+			{
+				cred_stat.auth_err++;
+				_reply(type, seq, CRED_ST_AUTH, 0);
+				break;
+			}
+			result = cred_range_begin(_le32(data), _le32(data + 4), _le32(data + 8));
+			if (result == CRED_OK)
+			{
+				for (i = 0; i < HASH_SHA256_LEN; i++)
+					build.chain[i] = build.prev[i] = data[12 + i];
+			}
+			_reply(type, seq, (u8)result, 0);
+			break;
+		case CRED_RANGE_DATA:
+			if ((len < HASH_SHA256_LEN) || ((len - HASH_SHA256_LEN) % 8))
+			{
+				_reply(type, seq, FRAME_ST_BADARG, 0);
+				break;
+			}
+			len -= HASH_SHA256_LEN;
+			if (_auth("CRRD", build.chain, data, len))
+			{
+				for (i = 0; i < HASH_SHA256_LEN; i++)
+				{
+					build.prev[i]  = build.chain[i];
+					build.chain[i] = data[len + i];
+				}
+			}
+			// Retransmission of the last frame only (same MAC)
+			else if ( ! _auth("CRRD", build.prev, data, len) ||
+			         ! hash_equal(data + len, build.chain, HASH_SHA256_LEN))
+			{
+				cred_stat.auth_err++;
+				_reply(type, seq, CRED_ST_AUTH, 0);
+				break;
+			}
+			result = CRED_OK;
+			for (i = 0; (i < len) && (result == CRED_OK); i += 8)
+				result = cred_range_put(_le32(data + i), _le32(data + i + 4));
+			_reply(type, seq, (u8)result, build.count ? build.last : 0);
+			break;
+		case CRED_RANGE_END:
+			if (len != (4 + HASH_SHA256_LEN))
+			{
+				_reply(type, seq, FRAME_ST_BADARG, 0);
+				break;
+			}
+			if ( ! _auth("CRRE", build.chain, data, 4))
+			{
+				cred_stat.auth_err++;
+				_reply(type, seq, CRED_ST_AUTH, 0);
+				break;
+			}
+			_reply(type, seq, (u8)cred_range_end(_le32(data)), 0);
+			break;
+		case CRED_RANGE_ABORT:
+			if (len != HASH_SHA256_LEN)
+			{
+				_reply(type, seq, FRAME_ST_BADARG, 0);
+				break;
+			}
+			if ( ! _auth("CRRA", build.chain, data, 0))
+			{
+				cred_stat.auth_err++;
+				_reply(type, seq, CRED_ST_AUTH, 0);
+				break;
+			}
+			if ((store.state == ST_BUILD) && (build.lo <= build.hi) && (build.handover == 0))
+				store.state = ST_IDLE;
+			_reply(type, seq, CRED_OK, 0);
+			break;
+		default:
+			frame_reply(type, seq, FRAME_ST_UNKNOWN);
+			break;
+	}
+}
+
+/**
+ * @brief Send a reply with a status, the current version and a value
+ *
+ * @param type   Type of the request frame
+ * @param seq    Sequence number of the request frame
+ * @param status Status code
+ * @param info   Value, depends on the request
+ */
+static void _reply(u8 type, u8 seq, u8 status, u32 info)
+{
+	u8   buf[9];
+	uint i;
+
+	buf[0] = status;
+	for (i = 0; i < 4; i++)
+	{
+		buf[1 + i] = (u8)(store.version >> (8 * i));
+		buf[5 + i] = (u8)(info >> (8 * i));
+	}
+	frame_send((u8)(type | FRAME_REPLY), seq, buf, 9);
+}
+
+/**
+ * @brief Get the access profile of a credential from the base
+ *
+ * Only the block that may contain the identifier is decoded.
+ *
+ * @param id Credential identifier
+ * @return u32 Access profile, 0 if not into the base
+ */
+static inline u32 _base_get(u32 id)
+{
+	cred_dec dec;
+	cred_rec rec;
+
+	if ((store.nblk == 0) || (id < fence[0]))
+		return(0);
+	_dec_block(&dec, _fence_find(id));
+	while (dec.left)
+	{
+		_dec_rec(&dec, &rec);
+		if (rec.id >= id)
+			return (rec.id == id) ? rec.attr : 0;
+	}
+	return(0);
+}
+
+/**
+ * @brief Search the block that may contain an identifier (fence index)
+ *
+ * @param id Credential identifier
+ * @return u32 Last block that starts at or below the identifier (or 0)
+ */
+static u32 _fence_find(u32 id)
+{
+	u32 lo = 0, hi = store.nblk, mid;
+
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (fence[mid] <= id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo > 0) ? (lo - 1) : 0;
+}
+
+/**
+ * @brief Load the fence index of the current area
+ *
+ */
+static void _fence_load(void)
+{
+	u32 addr = _area(store.area) + CRED_HDR_SIZE;
+	u32 i;
+
+	for (i = 0; i < store.nblk; i++)
+		fence[i] = reg_rd(addr + (i * CRED_BLK_SIZE));
+}
+
+/**
+ * @brief Set the decoder at the start of a block
+ *
+ * Block : u32 first identifier, u8 records, u8 width of the differences,
+ * u8 width of the profiles, u8 0, then the records (difference minus one
+ * with the previous identifier, profile) packed from the LSB of each word.
+ *
+ * @param dec Pointer to the decoder
+ * @param blk Block number (number of blocks : end of the base)
+ */
+static void _dec_block(cred_dec *dec, u32 blk)
+{
+	u32 w;
+
+	dec->blk  = blk;
+	dec->left = 0;
+	if (blk >= store.nblk)
+		return;
+	dec->addr = _area(store.area) + CRED_HDR_SIZE + (blk * CRED_BLK_SIZE);
+	dec->id   = reg_rd(dec->addr) - 1;
+	w = reg_rd(dec->addr + 4);
+	dec->left = (w >>  0) & 0xFF;
+	dec->dw   = (w >>  8) & 0xFF;
+	dec->aw   = (w >> 16) & 0xFF;
+	dec->bit  = 64;
+	dec->word = reg_rd(dec->addr + 8);
+}
+
+/**
+ * @brief Decode the next record of the current block
+ *
+ * @param dec Pointer to the decoder (at least one record left)
+ * @param rec Pointer to the record to fill
+ */
+static inline void _dec_rec(cred_dec *dec, cred_rec *rec)
+{
+	dec->id += _dec_bits(dec, dec->dw) + 1;
+	rec->id   = dec->id;
+	rec->attr = _dec_bits(dec, dec->aw);
+	dec->left--;
+}
+
+/**
+ * @brief Decode the next record of the base
+ *
+ * @param dec Pointer to the decoder
+ * @param rec Pointer to the record to fill
+ * @return integer Non-zero if a record has been read, 0 at the end
+ */
+static int _dec_next(cred_dec *dec, cred_rec *rec)
+{
+	while (dec->left == 0)
+	{
+		if ((dec->blk + 1) >= store.nblk)
+			return(0);
+		_dec_block(dec, dec->blk + 1);
+	}
+	_dec_rec(dec, rec);
+	return(1);
+}
+
+/**
+ * @brief Read a field of the current block
+ *
+ * @param dec   Pointer to the decoder
+ * @param width Width of the field (0 to 32 bits)
+ * @return u32 Value of the field
+ */
+static inline u32 _dec_bits(cred_dec *dec, uint width)
+{
+	u32 shift, v;
+
+	if (width == 0)
+		return(0);
+	shift = dec->bit & 31;
+	v = dec->word >> shift;
+	dec->bit += width;
+	// Field ends into (or at the end of) the current word : read the next one
+	if (((shift + width) >= 32) && (dec->bit < (CRED_BLK_SIZE * 8)))
+	{
+		dec->word = reg_rd(dec->addr + ((dec->bit >> 5) << 2));
+		if ((shift + width) > 32)
+			v |= dec->word << (32 - shift);
+	}
+	if (width < 32)
+		v &= ((u32)1 << width) - 1;
+	return(v);
+}
+
+/**
+ * @brief Search the first record of the overlay not below an identifier
+ *
+ * @param id Credential identifier
+ * @return uint Index of the record, delta_len if none
+ */
+static inline uint _delta_find(u32 id)
+{
+	uint lo = 0, hi = delta_len, mid;
+
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (delta[mid].id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return(lo);
+}
+
+/**
+ * @brief Set the access profile of a credential into the overlay
+ *
+ * @param id   Credential identifier
+ * @param attr Access profile, 0 to revoke the credential
+ * @return integer Zero on success, -1 if the overlay is full
+ */
+static int _put(u32 id, u32 attr)
+{
+	u32  prev, in_base;
+	uint i, j;
+
+	prev    = cred_lookup(id);
+	in_base = _base_get(id);
+	i = _delta_find(id);
+	if ((i < delta_len) && (delta[i].id == id))
+	{
+		delta[i].attr = attr;
+		// Revoked and not into the base : forget it
+		if ((attr == 0) && (in_base == 0))
+		{
+			for (j = i + 1; j < delta_len; j++)
+				delta[j - 1] = delta[j];
+			delta_len--;
+		}
+	}
+	else if (attr || in_base)
+	{
+		if (delta_len >= CRED_DELTA_MAX)
+			return(-1);
+		for (j = delta_len; j > i; j--)
+			delta[j] = delta[j - 1];
+		delta[i].id   = id;
+		delta[i].attr = attr;
+		delta_len++;
+	}
+	if (prev && (attr == 0))
+		store.count--;
+	else if ((prev == 0) && attr)
+		store.count++;
+	return(0);
+}
+
+/**
+ * @brief Set a position into the content
+ *
+ * @param cur Pointer to the position
+ * @param id  First identifier to read
+ */
+static void _view_seek(cred_view *cur, u32 id)
+{
+	cur->oi   = _delta_find(id);
+	cur->b.id = 0;
+	if (store.nblk == 0)
+		return;
+	_dec_block(&cur->dec, _fence_find(id));
+	while (_dec_next(&cur->dec, &cur->b))
+	{
+		if (cur->b.id >= id)
+			return;
+	}
+	cur->b.id = 0;
+}
+
+/**
+ * @brief Read the next credential, by increasing identifier
+ *
+ * Records of the overlay replace the ones of the base, revoked ones are
+ * skipped.
+ *
+ * @param cur Pointer to the position (updated)
+ * @param rec Pointer to the record to fill
+ * @return integer Non-zero if a record has been read, 0 at the end
+ */
+static int _view_next(cred_view *cur, cred_rec *rec)
+{
+	while (1)
+	{
+		if ((cur->b.id == 0) && (cur->oi >= delta_len))
+			return(0);
+		if ((cur->oi < delta_len) &&
+		    ((cur->b.id == 0) || (delta[cur->oi].id <= cur->b.id)))
+		{
+			if (delta[cur->oi].id == cur->b.id)
+			{
+				if ( ! _dec_next(&cur->dec, &cur->b))
+					cur->b.id = 0;
+			}
+			*rec = delta[cur->oi++];
+			if (rec->attr == 0)
+				continue;
+			return(1);
+		}
+		*rec = cur->b;
+		if ( ! _dec_next(&cur->dec, &cur->b))
+			cur->b.id = 0;
+		return(1);
+	}
+}
+
+/**
+ * @brief Load the newest valid area and replay its delta log
+ *
+ * Operations not followed by a commit record are cancelled by an abort
+ * record. When no area is valid, an empty one is written.
+ */
+static void _load(void)
+{
+	u32  w[4], off, start, seq = 0;
+	uint area, i;
+	int  best = -1;
+
+	for (area = 0; area < 2; area++)
+	{
+		for (i = 0; i < 4; i++)
+			w[i] = reg_rd(_area(area) + (4 * i));
+		if ((w[0] != CRED_MAGIC) || (w[2] != ~w[1]))
+			continue;
+		if ((best >= 0) && ((s32)(w[1] - seq) <= 0))
+			continue;
+		// Base : number of records, CRC-32, number of blocks
+		off = reg_rd(_area(area) + 24);
+		if ((off > CRED_BLK_MAX) ||
+		    (crc_compute(_area(area) + CRED_HDR_SIZE, (uint)(off * CRED_BLK_SIZE)) != reg_rd(_area(area) + 20)))
+			continue;
+		best = (int)area;
+		seq  = w[1];
+	}
+
+	delta_len = 0;
+	if (best < 0)
+	{
+		store.valid   = 0;
+		store.area    = 1;
+		store.seq     = 0;
+		store.version = 0;
+		store.count   = 0;
+		store.nbase   = 0;
+		store.nblk    = 0;
+		_build_start(_area(0), 0xFFFFFFFF, 0);
+		return;
+	}
+	store.valid   = 1;
+	store.area    = (uint)best;
+	store.seq     = seq;
+	store.version = reg_rd(_area(store.area) + 12);
+	store.nbase   = reg_rd(_area(store.area) + 16);
+	store.nblk    = reg_rd(_area(store.area) + 24);
+	store.count   = store.nbase;
+	_fence_load();
+
+	start = CRED_HDR_SIZE + (store.nblk * CRED_BLK_SIZE);
+	for (off = start; off < CRED_AREA_SIZE; off += FLASH_QW_SIZE)
+	{
+		for (i = 0; i < 4; i++)
+			w[i] = reg_rd(_area(store.area) + off + (4 * i));
+		if ((w[0] & w[1] & w[2] & w[3]) == 0xFFFFFFFF)
+			break;
+		if (w[0] != 0)
+			continue;
+		if ((w[1] == CRED_COMMIT) && (w[3] == ~w[2]))
+		{
+			_replay(start, off);
+			store.version = w[2];
+		}
+		else if (w[1] != CRED_ABORT)
+		{
+			// Damaged record : the content is saved into a new area
+			store.wr = off;
+			_build_start(_area(store.area ^ 1), 0xFFFFFFFF, 0);
+			return;
+		}
+		start = off + FLASH_QW_SIZE;
+	}
+	store.wr = off;
+	if ((start != off) && (off < CRED_AREA_SIZE))
+	{
+		w[0] = 0;
+		w[1] = CRED_ABORT;
+		w[2] = 0;
+		w[3] = 0;
+		if (_write(_area(store.area) + off, w) == 0)
+			store.wr += FLASH_QW_SIZE;
+	}
+}
+
+/**
+ * @brief Apply the operations of a committed batch read from the log
+ *
+ * @param from Offset of the first quad-word
+ * @param to   Offset of the commit record
+ */
+static void _replay(u32 from, u32 to)
+{
+	u32  addr;
+	uint j;
+
+	for ( ; from < to; from += FLASH_QW_SIZE)
+	{
+		addr = _area(store.area) + from;
+		for (j = 0; j < 2; j++)
+		{
+			if (reg_rd(addr + (8 * j)) == 0)
+				continue;
+			_put(reg_rd(addr + (8 * j)), reg_rd(addr + (8 * j) + 4));
+			cred_stat.replayed++;
+		}
+	}
+}
+
+/**
+ * @brief Start the writing of a new area
+ *
+ * @param addr Address of the area
+ * @param lo   First identifier of the range sent by the host
+ * @param hi   Last identifier of the range (lo > hi : copy only)
+ */
+static void _build_start(u32 addr, u32 lo, u32 hi)
+{
+	build.addr     = addr;
+	build.lo       = lo;
+	build.hi       = hi;
+	build.version  = store.version;
+	build.last     = 0;
+	build.count    = 0;
+	build.nblk     = 0;
+	build.wr       = CRED_HDR_SIZE;
+	build.n        = 0;
+	build.sect     = 0;
+	build.phase    = B_ERASE;
+	build.handover = 0;
+	store.state    = ST_BUILD;
+}
+
+/**
+ * @brief Advance the writing of the new area by one step
+ *
+ * A step is the erase of one sector, or the copy of CRED_COPY_STEP
+ * records.
+ */
+static void _build_step(void)
+{
+	cred_rec rec;
+	uint n;
+
+	switch (build.phase)
+	{
+		case B_ERASE:
+			if (_erase(build.addr + (build.sect * FLASH_SECT_SIZE)) < 0)
+				return;
+			if (++build.sect < CRED_AREA_SECTS)
+				break;
+			_view_seek(&build.cur, 1);
+			build.phase = B_HEAD;
+			break;
+
+		case B_HEAD:
+		case B_TAIL:
+			for (n = 0; n < CRED_COPY_STEP; n++)
+			{
+				if (( ! _view_next(&build.cur, &rec)) ||
+				    ((build.phase == B_HEAD) && (rec.id >= build.lo)))
+				{
+					if ((build.phase == B_HEAD) && (build.lo <= build.hi))
+						build.phase = B_RANGE;
+					else
+						build.phase = B_DONE;
+					break;
+				}
+				if (_build_put(rec.id, rec.attr) < 0)
+					return;
+			}
+			break;
+
+		case B_DONE:
+			_build_finish();
+			break;
+	}
+}
+
+/**
+ * @brief Add a record to the base of the new area
+ *
+ * Records are kept until the block is full : the widths of a block depend
+ * on all its records. When the base is full the new area is abandoned.
+ *
+ * @param id   Credential identifier (above the previous one)
+ * @param attr Access profile
+ * @return integer Zero on success, -1 on error
+ */
+static int _build_put(u32 id, u32 attr)
+{
+	uint dw, aw;
+
+	if (build.n)
+	{
+		dw = _width(id - build.rec[build.n - 1].id - 1);
+		aw = _width(attr);
+		if (dw < build.dw)
+			dw = build.dw;
+		if (aw < build.aw)
+			aw = build.aw;
+		if ((build.n >= CRED_BLK_RECS) ||
+		    (((build.n + 1) * (dw + aw)) > CRED_BLK_BITS))
+		{
+			if (_build_flush() < 0)
+				return(-1);
+		}
+		else
+		{
+			build.dw = dw;
+			build.aw = aw;
+		}
+	}
+	if (build.n == 0)
+	{
+		build.dw = 0;
+		build.aw = _width(attr);
+	}
+	build.rec[build.n].id   = id;
+	build.rec[build.n].attr = attr;
+	build.n++;
+	build.count++;
+	build.last = id;
+	return(0);
+}
+
+/**
+ * @brief Encode and write the block being filled
+ *
+ * When the base is full the new area is abandoned.
+ *
+ * @return integer Zero on success, -1 on error
+ */
+static int _build_flush(void)
+{
+	u32  bit, id, v;
+	uint i, j, k;
+
+	if (build.nblk >= CRED_BLK_MAX)
+	{
+		log_print(0, " * CRED: %{WARNING%} base full (%u)\n", LOG_YLW, build.count);
+		if (build.lo > build.hi)
+			store.cap = store.count;
+		store.state = ST_IDLE;
+		return(-1);
+	}
+	for (i = 0; i < (CRED_BLK_SIZE / 4); i++)
+		build.blk[i] = 0;
+	build.blk[0] = build.rec[0].id;
+	build.blk[1] = build.n | (build.dw << 8) | (build.aw << 16);
+	bit = 64;
+	id  = build.rec[0].id - 1;
+	for (i = 0; i < build.n; i++)
+	{
+		for (k = 0; k < 2; k++)
+		{
+			j = k ? build.aw : build.dw;
+			v = k ? build.rec[i].attr : (build.rec[i].id - id - 1);
+			if (j == 0)
+				continue;
+			build.blk[bit >> 5] |= v << (bit & 31);
+			if (((bit & 31) + j) > 32)
+				build.blk[(bit >> 5) + 1] |= v >> (32 - (bit & 31));
+			bit += j;
+		}
+		id = build.rec[i].id;
+	}
+	for (i = 0; i < (CRED_BLK_SIZE / 4); i += 4)
+	{
+		if (_write(build.addr + build.wr, &build.blk[i]) < 0)
+			return(-1);
+		build.wr += FLASH_QW_SIZE;
+	}
+	build.nblk++;
+	build.n = 0;
+	return(0);
+}
+
+/**
+ * @brief Write the header of the new area, it becomes the current one
+ *
+ */
+static void _build_finish(void)
+{
+	u32  qw[4];
+	uint area;
+
+	if (build.n && (_build_flush() < 0))
+		return;
+	// Second quad-word first : the magic validates the whole header
+	qw[0] = build.count;
+	qw[1] = crc_compute(build.addr + CRED_HDR_SIZE, (uint)(build.nblk * CRED_BLK_SIZE));
+	qw[2] = build.nblk;
+	qw[3] = 0;
+	if (_write(build.addr + FLASH_QW_SIZE, qw) < 0)
+		return;
+	qw[0] = CRED_MAGIC;
+	qw[1] = store.seq + 1;
+	qw[2] = ~(store.seq + 1);
+	qw[3] = build.version;
+	if (_write(build.addr, qw) < 0)
+		return;
+	cred_stat.builds++;
+	if (build.handover)
+	{
+		store.state = ST_OFF;
+		return;
+	}
+
+	area = (build.addr == _area(0)) ? 0 : 1;
+	store.area    = area;
+	store.valid   = 1;
+	store.seq++;
+	store.version = build.version;
+	store.nbase   = build.count;
+	store.nblk    = build.nblk;
+	store.count   = build.count;
+	store.cap     = 0xFFFFFFFF;
+	store.wr      = build.wr;
+	delta_len     = 0;
+	_fence_load();
+	store.state   = ST_IDLE;
+}
+
+/**
+ * @brief Erase a sector of the store (if not already blank)
+ *
+ * On error the store is stopped.
+ *
+ * @param addr Address of the sector
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _erase(u32 addr)
+{
+	int  locked, result;
+	uint i;
+
+	for (i = 0; i < FLASH_SECT_SIZE; i += 4)
+		if (reg_rd(addr + i) != 0xFFFFFFFF)
+			break;
+	if (i == FLASH_SECT_SIZE)
+		return(0);
+
+	locked = flash_locked();
+	result = flash_unlock();
+	if (result == FLASH_OK)
+		result = flash_erase(addr);
+	if (locked)
+		flash_lock();
+	if (result == FLASH_OK)
+		return(0);
+	cred_stat.flash_err++;
+	store.state = ST_OFF;
+	return(-1);
+}
+
+/**
+ * @brief Program a quad-word of the store
+ *
+ * On error the store is stopped.
+ *
+ * @param addr Address of the quad-word
+ * @param qw   Pointer to the four words
+ * @return integer Zero on success, -1 on flash error
+ */
+static int _write(u32 addr, const u32 *qw)
+{
+	int locked, result;
+
+	locked = flash_locked();
+	result = flash_unlock();
+	if (result == FLASH_OK)
+		result = flash_program(addr, qw);
+	if (locked)
+		flash_lock();
+	if (result == FLASH_OK)
+		return(0);
+	cred_stat.flash_err++;
+	store.state = ST_OFF;
+	return(-1);
+}
+
+/**
+ * @brief Get the address of an area of the store
+ *
+ * @param area Area number (0 or 1)
+ * @return u32 Address of the header of the area
+ */
+static inline u32 _area(uint area)
+{
+	return store.base + (area * CRED_AREA_SIZE);
+}
+
+/**
+ * @brief Get the address to use for a sector of the store
+ *
+ * @param addr Address into the flash (any alias)
+ * @return u32 Secure alias (store sectors are secure), or the address
+ */
+static u32 _addr(u32 addr)
+{
+#ifdef RUN_SEC
+	return (addr | FLASH_BASE_S);
+#else
+	return(addr);
+#endif
+}
+
+/**
+ * @brief Mix the bits of a word (hash of the digests)
+ *
+ * @param x Value
+ * @return u32 Hash
+ */
+static u32 _mix(u32 x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352D;
+	x ^= x >> 15;
+	x *= 0x846CA68B;
+	x ^= x >> 16;
+	return(x);
+}
+
+/**
+ * @brief Decode a little-endian 32 bits word
+ *
+ * @param p Pointer to the first byte
+ * @return u32 Decoded value
+ */
+static u32 _le32(const u8 *p)
+{
+	return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+/**
+ * @brief Get the number of bits needed to code a value
+ *
+ * @param x Value
+ * @return uint Number of bits (0 for 0)
+ */
+static uint _width(u32 x)
+{
+	uint n = 0;
+
+	while (x)
+	{
+		n++;
+		x >>= 1;
+	}
+	return(n);
+}
+/* EOF */
@@ -0,0 +1,101 @@
+/**
+ * @file  cred.h
+ * @brief Definitions and prototypes for the credential store (delta sync)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef CRED_H
+#define CRED_H
+#include "driver/flash.h"
+#include "types.h"
+
+/* Store : two areas after the firmware image (secure 64 kB, application
+ * 128 kB), into the inactive bank. See doc/credentials.md */
+#define CRED_OFFSET     0x30000
+#define CRED_AREA_SECTS 14
+#define CRED_AREA_SIZE  (CRED_AREA_SECTS * FLASH_SECT_SIZE)
+// Header of an area (two quad-words), then blocks of the base
+#define CRED_HDR_SIZE   (2 * FLASH_QW_SIZE)
+// Space kept for the delta log after the largest base
+#define CRED_LOG_MIN    0x4000
+// Block of the base : sorted records, delta and bit-packed (see doc)
+#define CRED_BLK_SIZE   256
+#define CRED_BLK_BITS   ((CRED_BLK_SIZE - 8) * 8)
+#define CRED_BLK_RECS   255
+#define CRED_BLK_MAX    ((CRED_AREA_SIZE - CRED_HDR_SIZE - CRED_LOG_MIN) / CRED_BLK_SIZE)
+// Changes kept into SRAM on top of the base (overlay)
+#define CRED_DELTA_MAX  1024
+// Operations of one batch (one frame, with its MAC)
+#define CRED_BATCH_MAX  110
+// Records copied into a new area by one call of cred_poll
+#define CRED_COPY_STEP  256
+
+#define CRED_MAGIC      0x44524331 /* "CRD1" */
+#define CRED_COMMIT     0x54494D43 /* "CMIT" */
+#define CRED_ABORT      0x54524241 /* "ABRT" */
+// Identifiers 0 and 0xFFFFFFFF are reserved (log records, erased flash)
+#define CRED_ID_MAX     0xFFFFFFFE
+
+/* Frames of the credential class */
+#define CRED_STATUS      0x20
+#define CRED_BATCH       0x21
+#define CRED_DIGEST      0x22
+#define CRED_RANGE_BEGIN 0x23
+#define CRED_RANGE_DATA  0x24
+#define CRED_RANGE_END   0x25
+#define CRED_RANGE_ABORT 0x26
+
+/* Operations of a batch (u8 op, u32 id, u32 attr) */
+#define CRED_OP_ADD    1
+#define CRED_OP_MODIFY 2
+#define CRED_OP_REVOKE 3
+#define CRED_OP_SIZE   9
+
+/* Result codes, also first byte of the replies (with FRAME_ST_*) */
+#define CRED_OK          0x00
+#define CRED_ST_GAP      0x10 /* Base version is not the current one      */
+#define CRED_ST_CONFLICT 0x11 /* Operation does not match the store       */
+#define CRED_ST_BUSY     0x12 /* New area being built, retry later        */
+#define CRED_ST_FULL     0x13 /* No space left for the base               */
+#define CRED_ST_AUTH     0x14 /* MAC of the frame is not valid            */
+
+/**
+ * @brief Counters of the credential store
+ */
+typedef struct cred_stats
+{
+	u32 batches;   // Batches applied
+	u32 ops;       // Operations applied (batches)
+	u32 rejected;  // Batches refused (gap, conflict, busy)
+	u32 auth_err;  // Frames refused (bad MAC)
+	u32 replayed;  // Operations applied from the delta log at boot
+	u32 builds;    // New areas written (compaction, resync)
+	u32 flash_err; // Erase or program errors
+} cred_stats;
+
+extern cred_stats cred_stat;
+
+void cred_init    (void);
+int  cred_format  (void);
+u32  cred_lookup  (u32 id);
+u32  cred_version (void);
+u32  cred_count   (void);
+u32  cred_base_size(u32 *count);
+int  cred_apply   (u32 base, u32 version, const u8 *ops, uint count);
+int  cred_range_begin(u32 lo, u32 hi, u32 base);
+int  cred_range_put  (u32 id, u32 attr);
+int  cred_range_end  (u32 version);
+u32  cred_digest  (u32 lo, u32 hi, u32 *count);
+void cred_poll    (void);
+void cred_handover(void);
+
+#endif
@@ -0,0 +1,323 @@
+/**
+ * @file  adc.c
+ * @brief This file contains a driver for STM32H5 ADC (continuous scan)
+ *
+ * ADC1 converts a sequence of channels in a loop (continuous mode), the
+ * GPDMA moves each result into a circular double buffer : two linked-list
+ * items, one per half, linked to each other. No interrupt is used for the
+ * data, adc_half() gives the last completed half when it is polled. The
+ * CPU is only interrupted by the analog watchdogs (ADC1_Handler), when a
+ * channel leaves its window.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/adc.h"
+#include "driver/dma.h"
+#include "hardware.h"
+#include "irq.h"
+#include "systime.h"
+#include "types.h"
+
+/* ADC_CR */
+#define CR_ADEN     (1u << 0)
+#define CR_ADSTART  (1u << 2)
+#define CR_ADSTP    (1u << 4)
+#define CR_ADVREGEN (1u << 28)
+#define CR_DEEPPWD  (1u << 29)
+#define CR_ADCAL    (1u << 31)
+/* ADC_CFGR */
+#define CFGR_DMAEN   (1u << 0)
+#define CFGR_DMACFG  (1u << 1)  /* DMA circular mode */
+#define CFGR_OVRMOD  (1u << 12) /* Overwrite on overrun */
+#define CFGR_CONT    (1u << 13)
+#define CFGR_AWD1SGL (1u << 22)
+#define CFGR_AWD1EN  (1u << 23)
+/* ADC_ISR */
+#define ISR_ADRDY (1u << 0)
+#define ISR_OVR   (1u << 4)
+/* Sampling time : 640.5 cycles (high impedance loops) */
+#define ADC_SMP 7
+/* Prescaler of the kernel clock : 32 MHz / 64 = 500 kHz */
+#define ADC_PRESC 9
+
+#ifdef HOST
+#define ADC_ADDR(p, len) sim_addr((const void *)(p), len)
+#else
+#define ADC_ADDR(p, len) ((u32)(p))
+#endif
+
+void ADC1_Handler(void);
+
+static void _sequence(const u8 *chan, uint count);
+
+static dma_lli adc_lli[2] __attribute__((aligned(16)));
+static const u16 *adc_buf;
+static u32     adc_bus; // Bus address of the buffer (DMA)
+static uint    adc_len;
+static adc_fct event_fct;
+
+/**
+ * @brief Initialize the ADC : clocks, regulator and calibration
+ *
+ */
+void adc_init(void)
+{
+	uint i;
+
+	adc_buf   = 0;
+	event_fct = 0;
+	dma_init();
+
+	// Activate ADC, kernel clock is HCLK (ADCDACSEL = 0)
+	reg_clr(RCC_CCIPR5(RCC), (7u << 0));
+	reg_set(RCC_AHB2ENR(RCC), (1 << 10));
+	reg_wr(ADC_CCR(ADC1), (ADC_PRESC << 18));
+
+	// Exit deep power-down, start the regulator (tADCVREG_STUP 10us)
+	reg_clr(ADC_CR(ADC1), CR_DEEPPWD);
+	reg_set(ADC_CR(ADC1), CR_ADVREGEN);
+	delay_us(20);
+
+	// Calibration (single-ended inputs)
+	reg_set(ADC_CR(ADC1), CR_ADCAL);
+	for (i = 0; (reg_rd(ADC_CR(ADC1)) & CR_ADCAL) && (i < 100000); i++)
+		;
+
+	// Enable the converter
+	reg_wr(ADC_ISR(ADC1), ISR_ADRDY);
+	reg_set(ADC_CR(ADC1), CR_ADEN);
+	for (i = 0; ((reg_rd(ADC_ISR(ADC1)) & ISR_ADRDY) == 0) && (i < 100000); i++)
+		;
+#ifdef HOST
+	sim_vector(IRQ_ADC1, ADC1_Handler);
+#endif
+}
+
+/**
+ * @brief Start the continuous conversion of a sequence of channels
+ *
+ * The buffer is split in two halves, each one holds an integer number of
+ * sequences. Samples are stored in the order of the sequence, then the
+ * next sequence ... The buffer must stay allocated until adc_stop().
+ *
+ * @param chan  Pointer to the list of channels (0 to 19), in order
+ * @param count Number of channels into the sequence (1 to ADC_RANKS_MAX)
+ * @param buf   Pointer to the buffer that receives the samples
+ * @param len   Number of samples into the buffer (two halves)
+ * @return integer Zero on success, -1 on bad parameters
+ */
+int adc_start(const u8 *chan, uint count, u16 *buf, uint len)
+{
+	u32 dr, lli;
+
+	if ((count == 0) || (count > ADC_RANKS_MAX) || (len % (2 * count)))
+		return(-1);
+	// One half (len / 2 samples of 2 bytes) is one DMA block
+	if (len > DMA_BLOCK_MAX)
+		return(-1);
+
+	adc_stop();
+	_sequence(chan, count);
+	reg_wr(ADC_CFGR(ADC1), (reg_rd(ADC_CFGR(ADC1)) & (CFGR_AWD1SGL | CFGR_AWD1EN | (0x1Fu << 26))) |
+	                       CFGR_DMAEN | CFGR_DMACFG | CFGR_OVRMOD | CFGR_CONT);
+
+	// Two items (one per half of the buffer), linked to each other
+	dr  = (u32)ADC_DR(ADC1);
+	lli = ADC_ADDR(adc_lli, sizeof(adc_lli));
+	adc_buf = buf;
+	adc_bus = ADC_ADDR(buf, len * 2);
+	adc_len = len;
+	adc_lli[0].br1 = len;
+	adc_lli[0].sar = dr;
+	adc_lli[0].dar = adc_bus;
+	adc_lli[0].llr = DMA_LLI_UB1 | DMA_LLI_USA | DMA_LLI_UDA | DMA_LLI_ULL |
+	                 ((lli + sizeof(dma_lli)) & DMA_LLI_LA);
+	adc_lli[1].br1 = len;
+	adc_lli[1].sar = dr;
+	adc_lli[1].dar = adc_bus + len;
+	adc_lli[1].llr = DMA_LLI_UB1 | DMA_LLI_USA | DMA_LLI_UDA | DMA_LLI_ULL |
+	                 (lli & DMA_LLI_LA);
+	dma_start_ring(DMA_CH_ADC, lli, &adc_lli[0], DMA_REQ_ADC1);
+
+	reg_wr(ADC_ISR(ADC1), ISR_OVR | ADC_AWD_ALL);
+	reg_set(ADC_CR(ADC1), CR_ADSTART);
+	return(0);
+}
+
+/**
+ * @brief Stop conversions and the DMA channel
+ *
+ */
+void adc_stop(void)
+{
+	uint i;
+
+	if (reg_rd(ADC_CR(ADC1)) & CR_ADSTART)
+	{
+		reg_set(ADC_CR(ADC1), CR_ADSTP);
+		for (i = 0; (reg_rd(ADC_CR(ADC1)) & CR_ADSTART) && (i < 100000); i++)
+			;
+	}
+	dma_stop(DMA_CH_ADC);
+	adc_buf = 0;
+}
+
+/**
+ * @brief Get the last half of the buffer completed since the previous call
+ *
+ * The half returned is stable until the DMA has filled the other one, it
+ * must be processed in less than one half period.
+ *
+ * @return pointer Start of the half, or NULL if no new half is available
+ */
+const u16 *adc_half(void)
+{
+	u32 dar;
+
+	if (adc_buf == 0)
+		return(0);
+	// TCF : end of a block (one half)
+	if ((reg_rd(DMA_CSR(GPDMA1, DMA_CH_ADC)) & (1 << 8)) == 0)
+		return(0);
+	reg_wr(DMA_CFCR(GPDMA1, DMA_CH_ADC), (1 << 8));
+
+	// The completed half is the one not being written
+	dar = reg_rd(DMA_CDAR(GPDMA1, DMA_CH_ADC));
+	if (dar < (adc_bus + adc_len))
+		return(adc_buf + (adc_len / 2));
+	return(adc_buf);
+}
+
+/**
+ * @brief Configure an analog watchdog
+ *
+ * AWD1 watches one channel (or all the channels of the sequence when the
+ * mask has more than one bit) with 12 bits thresholds. AWD2 and AWD3 watch
+ * a set of channels, with the 8 upper bits of the thresholds. An event is
+ * signaled when a result is out of the window [low, high]. Thresholds can
+ * only be written while conversions are stopped (before adc_start).
+ *
+ * @param awd       Watchdog to configure (ADC_AWD1, ADC_AWD2 or ADC_AWD3)
+ * @param chan_mask Channels to watch (bit n for channel n), 0 to disable
+ * @param low       Low threshold (12 bits)
+ * @param high      High threshold (12 bits)
+ */
+void adc_watch(u32 awd, u32 chan_mask, uint low, uint high)
+{
+	u32 cfgr;
+	uint ch;
+
+	if (awd == ADC_AWD1)
+	{
+		cfgr = reg_rd(ADC_CFGR(ADC1)) & ~(CFGR_AWD1SGL | CFGR_AWD1EN | (0x1Fu << 26));
+		if (chan_mask)
+		{
+			cfgr |= CFGR_AWD1EN;
+			if ((chan_mask & (chan_mask - 1)) == 0)
+			{
+				for (ch = 0; (chan_mask & (1u << ch)) == 0; ch++)
+					;
+				cfgr |= CFGR_AWD1SGL | ((u32)ch << 26);
+			}
+		}
+		reg_wr(ADC_TR1(ADC1), ((u32)(high & 0xFFF) << 16) | (low & 0xFFF));
+		reg_wr(ADC_CFGR(ADC1), cfgr);
+	}
+	else if (awd == ADC_AWD2)
+	{
+		reg_wr(ADC_TR2(ADC1), ((u32)((high >> 4) & 0xFF) << 16) | ((low >> 4) & 0xFF));
+		reg_wr(ADC_AWD2CR(ADC1), chan_mask & 0xFFFFF);
+	}
+	else if (awd == ADC_AWD3)
+	{
+		reg_wr(ADC_TR3(ADC1), ((u32)((high >> 4) & 0xFF) << 16) | ((low >> 4) & 0xFF));
+		reg_wr(ADC_AWD3CR(ADC1), chan_mask & 0xFFFFF);
+	}
+}
+
+/**
+ * @brief Enable the interrupt of analog watchdogs
+ *
+ * Pending events are cleared first. After an event the interrupt of the
+ * watchdog is disabled (a channel out of its window would raise it after
+ * each conversion), it is enabled again by this function.
+ *
+ * @param events Watchdogs to arm (combination of ADC_AWD1, 2, 3)
+ */
+void adc_arm(u32 events)
+{
+	events &= ADC_AWD_ALL;
+	reg_wr(ADC_ISR(ADC1), events);
+	reg_set(ADC_IER(ADC1), events);
+}
+
+/**
+ * @brief Define a function called on analog watchdog events
+ *
+ * @param fct Pointer to the function (called from interrupt)
+ */
+void adc_event(adc_fct fct)
+{
+	event_fct = fct;
+}
+
+/**
+ * @brief Interrupt handler of ADC1 (analog watchdogs)
+ *
+ */
+void ADC1_Handler(void)
+{
+	u32 events;
+
+	events = reg_rd(ADC_ISR(ADC1)) & reg_rd(ADC_IER(ADC1)) & ADC_AWD_ALL;
+	reg_clr(ADC_IER(ADC1), events);
+	reg_wr(ADC_ISR(ADC1), events);
+	if (event_fct && events)
+		event_fct(events);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Program the sequence of channels and their sampling time
+ *
+ * @param chan  Pointer to the list of channels
+ * @param count Number of channels (1 to ADC_RANKS_MAX)
+ */
+static void _sequence(const u8 *chan, uint count)
+{
+	u32  sqr[4] = { 0, 0, 0, 0 };
+	u32  smpr[2];
+	uint i, rank, ch;
+
+	smpr[0] = reg_rd(ADC_SMPR1(ADC1));
+	smpr[1] = reg_rd(ADC_SMPR2(ADC1));
+	// SQR1 holds the length (L) then SQ1 to SQ4, next registers 5 ranks
+	sqr[0] = (u32)(count - 1);
+	for (i = 0; i < count; i++)
+	{
+		ch   = chan[i] & 0x1F;
+		rank = i + 1;
+		sqr[rank / 5] |= (u32)ch << (6 * (rank % 5));
+		smpr[ch / 10] &= ~(7u << (3 * (ch % 10)));
+		smpr[ch / 10] |= (u32)ADC_SMP << (3 * (ch % 10));
+	}
+	reg_wr(ADC_SQR1(ADC1), sqr[0]);
+	reg_wr(ADC_SQR2(ADC1), sqr[1]);
+	reg_wr(ADC_SQR3(ADC1), sqr[2]);
+	reg_wr(ADC_SQR4(ADC1), sqr[3]);
+	reg_wr(ADC_SMPR1(ADC1), smpr[0]);
+	reg_wr(ADC_SMPR2(ADC1), smpr[1]);
+}
+/* EOF */
@@ -0,0 +1,60 @@
+/**
+ * @file  adc.h
+ * @brief Headers and definitions for STM32H5 ADC driver
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef ADC_H
+#define ADC_H
+#include "types.h"
+
+// ADC registers
+#define ADC_ISR(x)    (x + 0x00)
+#define ADC_IER(x)    (x + 0x04)
+#define ADC_CR(x)     (x + 0x08)
+#define ADC_CFGR(x)   (x + 0x0C)
+#define ADC_CFGR2(x)  (x + 0x10)
+#define ADC_SMPR1(x)  (x + 0x14)
+#define ADC_SMPR2(x)  (x + 0x18)
+#define ADC_TR1(x)    (x + 0x20)
+#define ADC_TR2(x)    (x + 0x24)
+#define ADC_TR3(x)    (x + 0x28)
+#define ADC_SQR1(x)   (x + 0x30)
+#define ADC_SQR2(x)   (x + 0x34)
+#define ADC_SQR3(x)   (x + 0x38)
+#define ADC_SQR4(x)   (x + 0x3C)
+#define ADC_DR(x)     (x + 0x40)
+#define ADC_AWD2CR(x) (x + 0xA0)
+#define ADC_AWD3CR(x) (x + 0xA4)
+// ADC common registers (ADC1 and ADC2)
+#define ADC_CCR(x)    (x + 0x308)
+
+/* Analog watchdog events (ISR and IER bits) */
+#define ADC_AWD1 (1u << 7)
+#define ADC_AWD2 (1u << 8)
+#define ADC_AWD3 (1u << 9)
+#define ADC_AWD_ALL (ADC_AWD1 | ADC_AWD2 | ADC_AWD3)
+
+// Longest scan sequence (SQ1 to SQ16)
+#define ADC_RANKS_MAX 16
+
+typedef void (*adc_fct)(u32 events);
+
+void adc_init (void);
+int  adc_start(const u8 *chan, uint count, u16 *buf, uint len);
+void adc_stop (void);
+const u16 *adc_half(void);
+void adc_watch(u32 awd, u32 chan_mask, uint low, uint high);
+void adc_arm  (u32 events);
+void adc_event(adc_fct fct);
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * @file  crc.c
+ * @brief This file contains a driver for STM32H5 CRC calculation unit
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/crc.h"
+#include "driver/dma.h"
+#include "hardware.h"
+#include "types.h"
+
+/**
+ * @brief Initialize the CRC driver
+ *
+ * The unit is used with its default configuration : CRC-32 (Ethernet)
+ * polynomial 0x04C11DB7 and initial value 0xFFFFFFFF.
+ */
+void crc_init(void)
+{
+	// Activate CRC
+	reg_set(RCC_AHB1ENR(RCC), (1 << 12));
+}
+
+/**
+ * @brief Compute the CRC-32 of a memory area
+ *
+ * Words are pushed to the CRC unit by GPDMA (memory-to-memory) so the
+ * processing of a large flash area does not load the CPU.
+ *
+ * @param addr Address of the first byte (32 bits aligned)
+ * @param len  Number of bytes (multiple of 4)
+ * @return u32 Computed CRC value
+ */
+u32 crc_compute(u32 addr, uint len)
+{
+	uint n;
+
+	// Reset the unit (DR is loaded with INIT value)
+	reg_wr(CRC_CR(CRC), (1 << 0));
+
+	len &= ~(uint)3;
+	while (len)
+	{
+		n = (len > DMA_BLOCK_MAX) ? DMA_BLOCK_MAX : len;
+		dma_start(DMA_CH_CRC, addr, CRC_DR(CRC), n, DMA_REQ_SW, DMA_SINC);
+		if (dma_wait(DMA_CH_CRC) < 0)
+			return(0);
+		addr += n;
+		len  -= n;
+	}
+	return( reg_rd(CRC_DR(CRC)) );
+}
+/* EOF */
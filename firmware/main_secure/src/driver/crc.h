@@ -0,0 +1,30 @@
+/**
+ * @file  crc.h
+ * @brief Headers and definitions for STM32H5 CRC calculation unit driver
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef CRC_H
+#define CRC_H
+#include "types.h"
+
+// CRC registers
+#define CRC_DR(x)   (x + 0x00)
+#define CRC_IDR(x)  (x + 0x04)
+#define CRC_CR(x)   (x + 0x08)
+#define CRC_INIT(x) (x + 0x10)
+#define CRC_POL(x)  (x + 0x14)
+
+void crc_init(void);
+u32  crc_compute(u32 addr, uint len);
+
+#endif
@@ -0,0 +1,253 @@
+/**
+ * @file  dma.c
+ * @brief This file contains a driver for STM32H5 GPDMA controller
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/dma.h"
+#include "hardware.h"
+#include "types.h"
+
+static inline int _is_secure(u32 addr);
+
+/**
+ * @brief Initialize the GPDMA driver
+ *
+ */
+void dma_init(void)
+{
+	// Activate GPDMA1
+	reg_set(RCC_AHB1ENR(RCC), (1 << 0));
+
+#ifdef RUN_SEC
+	// Channels used by secure drivers must be secure
+	reg_set(DMA_SECCFGR(GPDMA1), (1 << DMA_CH_CRC)  | (1 << DMA_CH_HASH) |
+	                             (1 << DMA_CH_SEQ0) | (1 << DMA_CH_SEQ1) |
+	                             (1 << DMA_CH_ADC));
+#endif
+}
+
+/**
+ * @brief Start a single block transfer (32 bits words)
+ *
+ * The transfer is started and this function returns immediately, use
+ * dma_wait() to know when the block has been fully transferred.
+ *
+ * @param ch    Channel to use
+ * @param src   Source address
+ * @param dst   Destination address
+ * @param len   Number of bytes to transfer (multiple of 4, max DMA_BLOCK_MAX)
+ * @param req   Hardware request (or DMA_REQ_SW for memory-to-memory)
+ * @param flags Combination of DMA_SINC and DMA_DINC
+ */
+void dma_start(uint ch, u32 src, u32 dst, uint len, uint req, uint flags)
+{
+	u32 v;
+
+	// Reset channel and clear all pending flags
+	reg_wr(DMA_CCR(GPDMA1, ch), (1 << 1));
+	reg_wr(DMA_CFCR(GPDMA1, ch), (0x7F << 8));
+
+	v  = (2 << 0);  // Source data width : 32 bits
+	v |= (2 << 16); // Destination data width : 32 bits
+	if (flags & DMA_SINC)
+		v |= (1 << 3);
+	if (flags & DMA_DINC)
+		v |= (1 << 19);
+	if (_is_secure(src))
+		v |= (1 << 15);
+	if (_is_secure(dst))
+		v |= (1u << 31);
+	reg_wr(DMA_CTR1(GPDMA1, ch), v);
+
+	if (req == DMA_REQ_SW)
+		v = (1 << 9);  // SWREQ: memory-to-memory
+	else
+		v = (req & 0x7F) | (1 << 10); // DREQ: destination is the requester
+	reg_wr(DMA_CTR2(GPDMA1, ch), v);
+
+	reg_wr(DMA_CBR1(GPDMA1, ch), (len & 0xFFFF));
+	reg_wr(DMA_CSAR(GPDMA1, ch), src);
+	reg_wr(DMA_CDAR(GPDMA1, ch), dst);
+	reg_wr(DMA_CLLR(GPDMA1, ch), 0);
+
+	// Enable channel
+	reg_wr(DMA_CCR(GPDMA1, ch), (1 << 0));
+}
+
+/**
+ * @brief Start a linked-list transfer (32 bits words, fixed addresses)
+ *
+ * The first item is loaded into the channel registers, the next ones are
+ * loaded by the controller at the end of each block. Each hardware request
+ * moves one word from the source to the destination of the current item,
+ * so an item of N words lasts N requests. The transfer ends after an item
+ * with a null CLLR ; an item linked to a previous one loops forever.
+ *
+ * @param ch    Channel to use
+ * @param base  Address of the 64 KB segment holding the items (CLBAR)
+ * @param first Pointer to the first item
+ * @param req   Hardware request that paces the transfer
+ */
+void dma_start_list(uint ch, u32 base, const dma_lli *first, uint req)
+{
+	u32 v;
+
+	// Reset channel and clear all pending flags
+	reg_wr(DMA_CCR(GPDMA1, ch), (1 << 1));
+	reg_wr(DMA_CFCR(GPDMA1, ch), (0x7F << 8));
+
+	v  = (2 << 0);  // Source data width : 32 bits
+	v |= (2 << 16); // Destination data width : 32 bits
+	if (_is_secure(first->sar))
+		v |= (1 << 15);
+	if (_is_secure(first->dar))
+		v |= (1u << 31);
+	reg_wr(DMA_CTR1(GPDMA1, ch), v);
+	// DREQ : destination is the requester (peripheral register)
+	reg_wr(DMA_CTR2(GPDMA1, ch), (req & 0x7F) | (1 << 10));
+
+	reg_wr(DMA_CLBAR(GPDMA1, ch), base & 0xFFFF0000);
+	reg_wr(DMA_CBR1(GPDMA1, ch), first->br1 & 0xFFFF);
+	reg_wr(DMA_CSAR(GPDMA1, ch), first->sar);
+	reg_wr(DMA_CDAR(GPDMA1, ch), first->dar);
+	reg_wr(DMA_CLLR(GPDMA1, ch), first->llr);
+
+	// Enable channel
+	reg_wr(DMA_CCR(GPDMA1, ch), (1 << 0));
+}
+
+/**
+ * @brief Start a circular reception from a peripheral (16 bits data)
+ *
+ * Same as dma_start_list() but the source (a peripheral data register)
+ * is the requester and the destination address is incremented : each
+ * request moves one half-word into the buffer of the current item. Items
+ * are normally linked in a loop, the TCF flag is set at the end of each
+ * block (see adc.c).
+ *
+ * @param ch    Channel to use
+ * @param base  Address of the 64 KB segment holding the items (CLBAR)
+ * @param first Pointer to the first item
+ * @param req   Hardware request that paces the transfer
+ */
+void dma_start_ring(uint ch, u32 base, const dma_lli *first, uint req)
+{
+	u32 v;
+
+	// Reset channel and clear all pending flags
+	reg_wr(DMA_CCR(GPDMA1, ch), (1 << 1));
+	reg_wr(DMA_CFCR(GPDMA1, ch), (0x7F << 8));
+
+	v  = (1 << 0);  // Source data width : 16 bits
+	v |= (1 << 16); // Destination data width : 16 bits
+	v |= (1 << 19); // Destination incremented
+	if (_is_secure(first->sar))
+		v |= (1 << 15);
+	if (_is_secure(first->dar))
+		v |= (1u << 31);
+	reg_wr(DMA_CTR1(GPDMA1, ch), v);
+	// SREQ : source is the requester (peripheral register)
+	reg_wr(DMA_CTR2(GPDMA1, ch), (req & 0x7F));
+
+	reg_wr(DMA_CLBAR(GPDMA1, ch), base & 0xFFFF0000);
+	reg_wr(DMA_CBR1(GPDMA1, ch), first->br1 & 0xFFFF);
+	reg_wr(DMA_CSAR(GPDMA1, ch), first->sar);
+	reg_wr(DMA_CDAR(GPDMA1, ch), first->dar);
+	reg_wr(DMA_CLLR(GPDMA1, ch), first->llr);
+
+	// Enable channel
+	reg_wr(DMA_CCR(GPDMA1, ch), (1 << 0));
+}
+
+/**
+ * @brief Wait end of the current transfer of a channel
+ *
+ * @param ch Channel to wait
+ * @return 0 on success, -1 if the transfer has been aborted by an error
+ */
+int dma_wait(uint ch)
+{
+	u32 sr;
+
+	while (1)
+	{
+		sr = reg_rd(DMA_CSR(GPDMA1, ch));
+		// Data transfer, update link or user setting error
+		if (sr & ((1 << 10) | (1 << 11) | (1 << 12)))
+		{
+			reg_wr(DMA_CFCR(GPDMA1, ch), (0x7F << 8));
+			return(-1);
+		}
+		// Transfer complete
+		if (sr & (1 << 8))
+			break;
+	}
+	reg_wr(DMA_CFCR(GPDMA1, ch), (1 << 8));
+	return(0);
+}
+
+/**
+ * @brief Test if a channel is idle (never started, completed or stopped)
+ *
+ * @param ch Channel to test
+ * @return True if the channel has no transfer in progress
+ */
+int dma_idle(uint ch)
+{
+	return ((reg_rd(DMA_CSR(GPDMA1, ch)) & (1 << 0)) != 0);
+}
+
+/**
+ * @brief Abort the transfer of a channel
+ *
+ * The channel is suspended (the current word is completed) then reset.
+ *
+ * @param ch Channel to stop
+ */
+void dma_stop(uint ch)
+{
+	if (reg_rd(DMA_CCR(GPDMA1, ch)) & (1 << 0))
+	{
+		reg_set(DMA_CCR(GPDMA1, ch), (1 << 2));
+		// Wait for SUSPF (or IDLEF if the transfer just completed)
+		while ((reg_rd(DMA_CSR(GPDMA1, ch)) & ((1 << 13) | (1 << 0))) == 0)
+			;
+	}
+	reg_wr(DMA_CCR(GPDMA1, ch), (1 << 1));
+	reg_wr(DMA_CFCR(GPDMA1, ch), (0x7F << 8));
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Test if an address targets a secure alias
+ *
+ * @param addr Address to test
+ * @return True if the address is in a secure memory region
+ */
+static inline int _is_secure(u32 addr)
+{
+#ifdef RUN_SEC
+	// Flash : 0x08000000 non-secure, 0x0C000000 secure
+	if (addr < 0x10000000)
+		return ((addr & 0x04000000) != 0);
+	// SRAM and peripherals : 0x2/0x4 non-secure, 0x3/0x5 secure
+	return ((addr & 0x10000000) != 0);
+#else
+	(void)addr;
+	return(0);
+#endif
+}
+/* EOF */
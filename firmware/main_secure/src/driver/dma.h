@@ -0,0 +1,88 @@
+/**
+ * @file  dma.h
+ * @brief Headers and definitions for STM32H5 GPDMA driver
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef DMA_H
+#define DMA_H
+#include "types.h"
+
+// GPDMA global registers
+#define DMA_SECCFGR(x)  (x + 0x00)
+#define DMA_PRIVCFGR(x) (x + 0x04)
+#define DMA_MISR(x)     (x + 0x0C)
+#define DMA_SMISR(x)    (x + 0x10)
+// GPDMA channel registers
+#define DMA_CLBAR(x,c)  (x + 0x50 + (0x80 * c))
+#define DMA_CFCR(x,c)   (x + 0x5C + (0x80 * c))
+#define DMA_CSR(x,c)    (x + 0x60 + (0x80 * c))
+#define DMA_CCR(x,c)    (x + 0x64 + (0x80 * c))
+#define DMA_CTR1(x,c)   (x + 0x90 + (0x80 * c))
+#define DMA_CTR2(x,c)   (x + 0x94 + (0x80 * c))
+#define DMA_CBR1(x,c)   (x + 0x98 + (0x80 * c))
+#define DMA_CSAR(x,c)   (x + 0x9C + (0x80 * c))
+#define DMA_CDAR(x,c)   (x + 0xA0 + (0x80 * c))
+#define DMA_CLLR(x,c)   (x + 0xCC + (0x80 * c))
+
+// Channels allocation (GPDMA1)
+#define DMA_CH_CRC  0
+#define DMA_CH_HASH 1
+#define DMA_CH_SEQ0 2
+#define DMA_CH_SEQ1 3
+#define DMA_CH_ADC  4
+
+// Requests (see RM0481 "GPDMA1 requests" table)
+#define DMA_REQ_SW      0xFFFF
+#define DMA_REQ_ADC1      0
+#define DMA_REQ_TIM3_UP  66
+#define DMA_REQ_TIM4_UP  72
+#define DMA_REQ_HASH_IN 110
+
+// Largest block supported by one transfer (BNDT is 16 bits)
+#define DMA_BLOCK_MAX 0xFFFC
+
+// Transfer flags
+#define DMA_SINC (1 << 0) /* Increment source address      */
+#define DMA_DINC (1 << 1) /* Increment destination address */
+
+// Linked-list item : registers reloaded at the end of each block (CLLR)
+#define DMA_LLI_UB1 (1u << 29) /* Reload CBR1 */
+#define DMA_LLI_USA (1u << 28) /* Reload CSAR */
+#define DMA_LLI_UDA (1u << 27) /* Reload CDAR */
+#define DMA_LLI_ULL (1u << 16) /* Reload CLLR */
+#define DMA_LLI_LA  0x0000FFFC /* Low 16 bits of the next item address */
+
+/**
+ * @brief Linked-list item with block size, source, destination and link
+ *
+ * The next item is loaded from the address of CLLR (low 16 bits) in the
+ * 64 KB segment given to dma_start_list(). Using DMA_LLI_UB1 | USA | UDA
+ * | ULL, the four words are read in this order.
+ */
+typedef struct dma_lli
+{
+	u32 br1;
+	u32 sar;
+	u32 dar;
+	u32 llr;
+} dma_lli;
+
+void dma_init(void);
+void dma_start(uint ch, u32 src, u32 dst, uint len, uint req, uint flags);
+void dma_start_list(uint ch, u32 base, const dma_lli *first, uint req);
+void dma_start_ring(uint ch, u32 base, const dma_lli *first, uint req);
+int  dma_wait (uint ch);
+int  dma_idle (uint ch);
+void dma_stop (uint ch);
+
+#endif
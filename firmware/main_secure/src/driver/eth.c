@@ -0,0 +1,522 @@
+/**
+ * @file  driver/eth.c
+ * @brief Driver of the Ethernet MAC (RMII, LAN8742 PHY)
+ *
+ * Descriptor rings and receive buffers are placed into the .ethernet_data
+ * section (SRAM1). Received frames are not copied : eth_recv() gives the
+ * buffer filled by the DMA to the caller and a free buffer of pool_eth
+ * replaces it into the ring. The caller gives it back with eth_release().
+ * Frames are transmitted from a list of segments (scatter-gather), two
+ * segments per descriptor, with IP/TCP/UDP checksums inserted by the MAC.
+ *
+ * The driver works by polling, eth_poll() reclaims transmit descriptors
+ * and follows the state of the link.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "driver/eth.h"
+#include "log.h"
+#include "power.h"
+#include "systime.h"
+
+#define ETH_SECT ".ethernet_data"
+// PHY (LAN8742A) address and registers
+#define PHY_ADDR  0
+#define PHY_BMCR  0
+#define PHY_BMSR  1
+#define PHY_SCSR 31
+// Device unique ID, used to build the MAC address
+#define UID_BASE 0x08FFF800
+
+// MAC configuration register
+#define MACCR_RE  (1 << 0)
+#define MACCR_TE  (1 << 1)
+#define MACCR_LM  (1 << 12)
+#define MACCR_DM  (1 << 13)
+#define MACCR_FES (1 << 14)
+#define MACCR_ACS (1 << 20)
+#define MACCR_CST (1 << 21)
+#define MACCR_IPC (1 << 27)
+// Checksum offload, FCS stripped, receiver and transmitter enabled
+#define MACCR_RUN (MACCR_IPC | MACCR_CST | MACCR_ACS | MACCR_TE | MACCR_RE)
+
+#ifdef HOST
+#define ETH_ADDR(p, len) sim_addr((const void *)(p), len)
+#else
+#define ETH_ADDR(p, len) ((u32)(p))
+#endif
+
+/**
+ * @brief DMA descriptor (normal format)
+ */
+typedef struct eth_desc
+{
+	u32 des0;
+	u32 des1;
+	u32 des2;
+	u32 des3;
+} eth_desc;
+
+/**
+ * @brief Callback of a transmitted frame (set on its last descriptor)
+ */
+typedef struct eth_done
+{
+	eth_done_fct fct;
+	void *arg;
+} eth_done;
+
+static int  _mdio_rd(uint reg);
+static int  _mdio_wr(uint reg, u32 value);
+static void _rx_arm(uint i, u8 *buf);
+static inline void _barrier(void);
+
+POOL_DEFINE(pool_eth, ETH_BUF_SIZE, ETH_RX_BUFS, ETH_SECT);
+static volatile eth_desc rx_ring[ETH_RX_DESC]
+	__attribute__((section(ETH_SECT ".rx_ring"), aligned(16)));
+static volatile eth_desc tx_ring[ETH_TX_DESC]
+	__attribute__((section(ETH_SECT ".tx_ring"), aligned(16)));
+
+static u8  *rx_buf[ETH_RX_DESC];
+static uint rx_next;
+static eth_done tx_done[ETH_TX_DESC];
+static uint tx_next;  // Next descriptor to fill
+static uint tx_clean; // Oldest descriptor given to the DMA
+static uint tx_free;
+static int  link;     // Speed (Mbit/s), 0 if down
+static u32  link_time;
+
+eth_stats eth_stat;
+
+/**
+ * @brief Initialize the MAC, its DMA and the PHY
+ *
+ * The link is negotiated by the PHY, the MAC is configured when it comes
+ * up (see eth_link).
+ */
+void eth_init(void)
+{
+	u32  uid0, uid1, uid2, v;
+	uint i;
+
+	// Select RMII interface (SBS clock is needed), before enabling ETH
+	reg_set(RCC_APB3ENR(RCC), (1 << 1));
+	v = reg_rd(SBS_PMCR(SBS)) & ~(7u << 21);
+	reg_wr(SBS_PMCR(SBS), v | (4u << 21));
+
+	// Activate ETH, ETHTX and ETHRX clocks then reset the peripheral
+	reg_set(RCC_AHB1ENR(RCC), (1 << 19) | (1 << 20) | (1 << 21));
+	reg_set(RCC_AHB1RST(RCC), (1 << 19));
+	reg_clr(RCC_AHB1RST(RCC), (1 << 19));
+
+	/* RMII pins, AF11 : PA1 REF_CLK, PA2 MDIO, PA7 CRS_DV, PC1 MDC,
+	 * PC4 RXD0, PC5 RXD1, PG11 TX_EN, PG13 TXD0, PB15 TXD1 */
+	reg_set(RCC_AHB2ENR(RCC), (1 << 0) | (1 << 1) | (1 << 2) | (1 << 6));
+	hw_gpio_af(GPIOA, (1 << 1) | (1 << 2) | (1 << 7), 11);
+	hw_gpio_af(GPIOB, (1 << 15), 11);
+	hw_gpio_af(GPIOC, (1 << 1) | (1 << 4) | (1 << 5), 11);
+	hw_gpio_af(GPIOG, (1 << 11) | (1 << 13), 11);
+
+	// DMA software reset (needs the RMII reference clock)
+	reg_wr(ETH_DMAMR(ETH), (1 << 0));
+	for (i = 0; (reg_rd(ETH_DMAMR(ETH)) & (1 << 0)) && (i < 100000); i++)
+		;
+
+	// MAC address : locally administered, from the device unique ID
+	uid0 = reg_rd(UID_BASE + 0);
+	uid1 = reg_rd(UID_BASE + 4);
+	uid2 = reg_rd(UID_BASE + 8);
+	v = uid0 ^ uid2;
+	reg_wr(ETH_MACA0LR(ETH), 0x02 | ((v & 0xFFFFFF) << 8));
+	reg_wr(ETH_MACA0HR(ETH), (1u << 31) | ((v >> 24) & 0xFF) | ((uid1 & 0xFF) << 8));
+	// Receive own unicast and broadcast
+	reg_wr(ETH_MACPFR(ETH), 0);
+
+	// MTL : store and forward (needed by checksum offload), queue enabled
+	reg_wr(ETH_MTLTXQOMR(ETH), (2 << 2) | (1 << 1));
+	reg_wr(ETH_MTLRXQOMR(ETH), (1 << 5));
+
+	// DMA : address-aligned beats, 16 bytes descriptors
+	reg_wr(ETH_DMASBMR(ETH), (1 << 12));
+	reg_wr(ETH_DMACCR(ETH), 0);
+
+	// Transmit ring, empty
+	for (i = 0; i < ETH_TX_DESC; i++)
+	{
+		tx_ring[i].des0 = tx_ring[i].des1 = 0;
+		tx_ring[i].des2 = tx_ring[i].des3 = 0;
+		tx_done[i].fct = 0;
+	}
+	tx_next = tx_clean = 0;
+	tx_free = ETH_TX_DESC;
+	reg_wr(ETH_DMACTXDLAR(ETH), ETH_ADDR(tx_ring, sizeof(tx_ring)));
+	reg_wr(ETH_DMACTXRLR(ETH), ETH_TX_DESC - 1);
+	reg_wr(ETH_DMACTXDTPR(ETH), ETH_ADDR(tx_ring, sizeof(tx_ring)));
+
+	// Receive ring, one buffer of the pool per descriptor
+	pool_create(&pool_eth);
+	for (i = 0; i < ETH_RX_DESC; i++)
+	{
+		rx_buf[i] = pool_alloc(&pool_eth);
+		_rx_arm(i, rx_buf[i]);
+	}
+	rx_next = 0;
+	reg_wr(ETH_DMACRXDLAR(ETH), ETH_ADDR(rx_ring, sizeof(rx_ring)));
+	reg_wr(ETH_DMACRXRLR(ETH), ETH_RX_DESC - 1);
+	reg_wr(ETH_DMACRXDTPR(ETH), ETH_ADDR(&rx_ring[ETH_RX_DESC - 1], sizeof(eth_desc)));
+
+	// Start DMA : 32 beats bursts, receive buffer size
+	reg_wr(ETH_DMACTXCR(ETH), (32 << 16) | (1 << 0));
+	reg_wr(ETH_DMACRXCR(ETH), (32 << 16) | (ETH_BUF_SIZE << 1) | (1 << 0));
+
+	// PHY : restart auto-negotiation
+	_mdio_wr(PHY_BMCR, (1 << 12) | (1 << 9));
+	link = 0;
+	link_time = systime_us();
+	eth_link();
+}
+
+/**
+ * @brief Update the state of the link, configure the MAC speed and duplex
+ *
+ * @return integer Speed in Mbit/s, 0 if the link is down
+ */
+int eth_link(void)
+{
+	int  bmsr, scsr, speed = 0;
+	u32  cr;
+
+	// Link status is latched-low, the first read gives the past state
+	_mdio_rd(PHY_BMSR);
+	bmsr = _mdio_rd(PHY_BMSR);
+	if ((bmsr > 0) && (bmsr & (1 << 2)) && (bmsr & (1 << 5)))
+	{
+		scsr  = _mdio_rd(PHY_SCSR);
+		speed = (scsr & (1 << 3)) ? 100 : 10;
+		// Auto-negotiation result : bit 4 full duplex
+		cr  = reg_rd(ETH_MACCR(ETH)) & ~(u32)(MACCR_FES | MACCR_DM);
+		cr |= (speed == 100) ? MACCR_FES : 0;
+		cr |= (scsr & (1 << 4)) ? MACCR_DM : 0;
+		cr |= MACCR_RUN;
+		if (speed != link)
+			reg_wr(ETH_MACCR(ETH), cr);
+	}
+	if (speed != link)
+	{
+		if (speed)
+		{
+			log_print(0, " * ETH link up, %d Mbit/s\n", speed);
+			power_hold(POWER_HOLD_ETH);
+		}
+		else
+		{
+			log_print(0, " * ETH link down\n");
+			power_release(POWER_HOLD_ETH);
+		}
+	}
+	link = speed;
+	return(speed);
+}
+
+/**
+ * @brief Enable or disable the internal loopback of the MAC
+ *
+ * Transmitted frames are received back, without PHY : this is used for
+ * self-test and by the benchmark.
+ *
+ * @param enable Non-zero to enable loopback
+ */
+void eth_loopback(int enable)
+{
+	u32 cr = reg_rd(ETH_MACCR(ETH));
+
+	if (enable)
+		cr |= MACCR_LM | MACCR_RUN;
+	else
+		cr &= ~(u32)MACCR_LM;
+	reg_wr(ETH_MACCR(ETH), cr);
+}
+
+/**
+ * @brief Get the MAC address of the interface
+ *
+ * @param mac Pointer to a buffer of 6 bytes
+ */
+void eth_addr(u8 *mac)
+{
+	u32 lo = reg_rd(ETH_MACA0LR(ETH));
+	u32 hi = reg_rd(ETH_MACA0HR(ETH));
+
+	mac[0] = (u8)(lo >>  0);
+	mac[1] = (u8)(lo >>  8);
+	mac[2] = (u8)(lo >> 16);
+	mac[3] = (u8)(lo >> 24);
+	mac[4] = (u8)(hi >>  0);
+	mac[5] = (u8)(hi >>  8);
+}
+
+/**
+ * @brief Get the next received frame
+ *
+ * The buffer of the frame is given to the caller and must be released
+ * with eth_release(). Frames with errors are dropped.
+ *
+ * @param frame Pointer to the frame descriptor to fill
+ * @return integer Zero if a frame has been received, -1 if none
+ */
+int eth_recv(eth_frame *frame)
+{
+	volatile eth_desc *d;
+	u32  st, st1;
+	u8  *spare;
+
+	while (1)
+	{
+		d  = &rx_ring[rx_next];
+		st = d->des3;
+		if (st & ETH_DES3_OWN)
+			return(-1);
+		st1 = d->des1;
+
+		if ((st & (ETH_DES3_FD | ETH_DES3_LD | ETH_DES3_ES)) != (ETH_DES3_FD | ETH_DES3_LD))
+		{
+			eth_stat.rx_err++;
+			spare = 0;
+		}
+		else if ((spare = pool_alloc(&pool_eth)) == 0)
+			eth_stat.rx_nobuf++;
+
+		// Frame dropped : the same buffer goes back to the ring
+		if (spare == 0)
+		{
+			_rx_arm(rx_next, rx_buf[rx_next]);
+			rx_next = (rx_next + 1) % ETH_RX_DESC;
+			continue;
+		}
+
+		frame->data  = rx_buf[rx_next];
+		frame->len   = (u16)(st & 0x7FFF);
+		frame->flags = 0;
+		if ((st & ETH_RDES3_RS1V) && (st1 & ETH_RDES1_IPV4))
+		{
+			frame->flags |= ETH_RX_IPV4;
+			if (((st1 & (ETH_RDES1_IPCE | ETH_RDES1_IPCB | ETH_RDES1_IPHE)) == 0) &&
+			    (st1 & ETH_RDES1_PT))
+				frame->flags |= ETH_RX_CSUM;
+		}
+		eth_stat.rx++;
+
+		rx_buf[rx_next] = spare;
+		_rx_arm(rx_next, spare);
+		rx_next = (rx_next + 1) % ETH_RX_DESC;
+		return(0);
+	}
+}
+
+/**
+ * @brief Release the buffer of a received frame
+ *
+ * @param frame Pointer to the frame given by eth_recv()
+ * @return integer Zero on success, -1 if the buffer is not a receive buffer
+ */
+int eth_release(eth_frame *frame)
+{
+	if (pool_free(&pool_eth, frame->data) < 0)
+		return(-1);
+	frame->data = 0;
+	return(0);
+}
+
+/**
+ * @brief Transmit a frame made of segments (scatter-gather)
+ *
+ * The MAC inserts the IP header and TCP/UDP/ICMP checksums, the padding
+ * and the FCS. Segments are not copied : they must stay valid until the
+ * done callback is called (from eth_poll).
+ *
+ * @param seg   Array of segments (each up to ETH_SEG_MAX bytes)
+ * @param count Number of segments
+ * @param done  Function called when the frame has been sent (or NULL)
+ * @param arg   Argument given to the done function
+ * @return integer Zero on success, -1 if not enough descriptors are free
+ */
+int eth_send(const eth_seg *seg, uint count, eth_done_fct done, void *arg)
+{
+	volatile eth_desc *d;
+	uint need = (count + 1) / 2;
+	uint first = tx_next;
+	uint i, len = 0;
+	u32  des3;
+
+	if ((count == 0) || (need > tx_free))
+	{
+		eth_stat.tx_full++;
+		return(-1);
+	}
+	for (i = 0; i < count; i++)
+		len += seg[i].len;
+
+	for (i = 0; i < count; i += 2)
+	{
+		d = &tx_ring[tx_next];
+		d->des0 = ETH_ADDR(seg[i].data, seg[i].len);
+		d->des2 = seg[i].len & ETH_SEG_MAX;
+		d->des1 = 0;
+		if ((i + 1) < count)
+		{
+			d->des1  = ETH_ADDR(seg[i + 1].data, seg[i + 1].len);
+			d->des2 |= (u32)(seg[i + 1].len & ETH_SEG_MAX) << 16;
+		}
+		des3 = (len & 0x7FFF) | ETH_TDES3_CIC;
+		if (i == 0)
+			des3 |= ETH_DES3_FD;
+		if ((i + 2) >= count)
+		{
+			des3 |= ETH_DES3_LD;
+			tx_done[tx_next].fct = done;
+			tx_done[tx_next].arg = arg;
+		}
+		else
+			tx_done[tx_next].fct = 0;
+		// The first descriptor is given to the DMA last
+		d->des3 = (i == 0) ? des3 : (des3 | ETH_DES3_OWN);
+		tx_next = (tx_next + 1) % ETH_TX_DESC;
+	}
+	tx_free -= need;
+	_barrier();
+	tx_ring[first].des3 |= ETH_DES3_OWN;
+	_barrier();
+	reg_wr(ETH_DMACTXDTPR(ETH), ETH_ADDR(&tx_ring[tx_next], sizeof(eth_desc)));
+	return(0);
+}
+
+/**
+ * @brief Reclaim sent descriptors and follow the link (once per second)
+ *
+ */
+void eth_poll(void)
+{
+	volatile eth_desc *d;
+	eth_done *dn;
+	u32 now;
+
+	while (tx_free < ETH_TX_DESC)
+	{
+		d = &tx_ring[tx_clean];
+		if (d->des3 & ETH_DES3_OWN)
+			break;
+		if (d->des3 & ETH_DES3_LD)
+		{
+			if (d->des3 & ETH_DES3_ES)
+				eth_stat.tx_err++;
+			else
+				eth_stat.tx++;
+			dn = &tx_done[tx_clean];
+			if (dn->fct)
+				dn->fct(dn->arg);
+		}
+		tx_clean = (tx_clean + 1) % ETH_TX_DESC;
+		tx_free++;
+	}
+
+	now = systime_us();
+	if ((now - link_time) >= 1000000)
+	{
+		link_time = now;
+		eth_link();
+	}
+}
+
+/**
+ * @brief Print the counters of the driver
+ *
+ */
+void eth_dump(void)
+{
+	log_print(0, " * ETH: link %d, rx %d (err %d, nobuf %d), tx %d (err %d, full %d)\n",
+	          link, eth_stat.rx, eth_stat.rx_err, eth_stat.rx_nobuf,
+	          eth_stat.tx, eth_stat.tx_err, eth_stat.tx_full);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Read a PHY register (MDIO clause 22)
+ *
+ * @param reg Register number
+ * @return integer Value of the register, -1 on timeout
+ */
+static int _mdio_rd(uint reg)
+{
+	uint i;
+
+	// CR=2 (HCLK 20-35 MHz), GOC=3 (read), GB
+	reg_wr(ETH_MACMDIOAR(ETH), (PHY_ADDR << 21) | (reg << 16) | (2 << 8) | (3 << 2) | (1 << 0));
+	for (i = 0; reg_rd(ETH_MACMDIOAR(ETH)) & (1 << 0); i++)
+		if (i > 10000)
+			return(-1);
+	return (int)(reg_rd(ETH_MACMDIODR(ETH)) & 0xFFFF);
+}
+
+/**
+ * @brief Write a PHY register (MDIO clause 22)
+ *
+ * @param reg   Register number
+ * @param value Value to write
+ * @return integer Zero on success, -1 on timeout
+ */
+static int _mdio_wr(uint reg, u32 value)
+{
+	uint i;
+
+	reg_wr(ETH_MACMDIODR(ETH), value & 0xFFFF);
+	// CR=2 (HCLK 20-35 MHz), GOC=1 (write), GB
+	reg_wr(ETH_MACMDIOAR(ETH), (PHY_ADDR << 21) | (reg << 16) | (2 << 8) | (1 << 2) | (1 << 0));
+	for (i = 0; reg_rd(ETH_MACMDIOAR(ETH)) & (1 << 0); i++)
+		if (i > 10000)
+			return(-1);
+	return(0);
+}
+
+/**
+ * @brief Give a receive descriptor (and its buffer) to the DMA
+ *
+ * @param i   Index of the descriptor
+ * @param buf Pointer to the receive buffer
+ */
+static void _rx_arm(uint i, u8 *buf)
+{
+	rx_ring[i].des0 = ETH_ADDR(buf, ETH_BUF_SIZE);
+	rx_ring[i].des1 = 0;
+	rx_ring[i].des2 = 0;
+	_barrier();
+	rx_ring[i].des3 = ETH_DES3_OWN | ETH_RDES3_IOC | ETH_RDES3_BUF1V;
+	_barrier();
+	reg_wr(ETH_DMACRXDTPR(ETH), ETH_ADDR(&rx_ring[i], sizeof(eth_desc)));
+}
+
+/**
+ * @brief Make descriptor writes visible to the DMA before going on
+ *
+ */
+static inline void _barrier(void)
+{
+#ifdef HOST
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+	asm volatile("dsb 0xF":::"memory");
+#endif
+}
+/* EOF */
@@ -0,0 +1,125 @@
+/**
+ * @file  driver/eth.h
+ * @brief Definitions and prototypes for the Ethernet MAC driver
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef ETH_H
+#define ETH_H
+#include "pool.h"
+#include "types.h"
+
+// MAC registers
+#define ETH_MACCR(x)     (x + 0x0000)
+#define ETH_MACPFR(x)    (x + 0x0008)
+#define ETH_MACMDIOAR(x) (x + 0x0200)
+#define ETH_MACMDIODR(x) (x + 0x0204)
+#define ETH_MACA0HR(x)   (x + 0x0300)
+#define ETH_MACA0LR(x)   (x + 0x0304)
+// MTL registers
+#define ETH_MTLTXQOMR(x) (x + 0x0D00)
+#define ETH_MTLRXQOMR(x) (x + 0x0D30)
+// DMA registers
+#define ETH_DMAMR(x)      (x + 0x1000)
+#define ETH_DMASBMR(x)    (x + 0x1004)
+#define ETH_DMACCR(x)     (x + 0x1100)
+#define ETH_DMACTXCR(x)   (x + 0x1104)
+#define ETH_DMACRXCR(x)   (x + 0x1108)
+#define ETH_DMACTXDLAR(x) (x + 0x1114)
+#define ETH_DMACRXDLAR(x) (x + 0x111C)
+#define ETH_DMACTXDTPR(x) (x + 0x1120)
+#define ETH_DMACRXDTPR(x) (x + 0x1128)
+#define ETH_DMACTXRLR(x)  (x + 0x112C)
+#define ETH_DMACRXRLR(x)  (x + 0x1130)
+#define ETH_DMACSR(x)     (x + 0x1160)
+
+// Descriptors (normal format)
+#define ETH_DES3_OWN  (1u << 31)
+#define ETH_DES3_FD   (1u << 29) /* First descriptor of a frame */
+#define ETH_DES3_LD   (1u << 28) /* Last descriptor of a frame  */
+#define ETH_DES3_ES   (1u << 15) /* Error summary (write-back)  */
+#define ETH_TDES3_CIC (3u << 16) /* Insert IP header and payload checksums */
+#define ETH_RDES3_IOC   (1u << 30)
+#define ETH_RDES3_BUF1V (1u << 24)
+#define ETH_RDES3_RS1V  (1u << 26) /* RDES1 status is valid */
+#define ETH_RDES1_IPCE  (1u << 7)  /* Payload checksum error  */
+#define ETH_RDES1_IPCB  (1u << 6)  /* Checksum offload bypassed */
+#define ETH_RDES1_IPV4  (1u << 4)
+#define ETH_RDES1_IPHE  (1u << 3)  /* IP header checksum error */
+#define ETH_RDES1_PT    0x7        /* Payload type (1 UDP, 2 TCP, 3 ICMP) */
+
+// Rings and buffers, into the .ethernet_data section of SRAM1
+#define ETH_RX_DESC  8
+#define ETH_TX_DESC  8
+#define ETH_BUF_SIZE 1536
+// Receive buffers : one per descriptor, plus the frames held by upper layers
+#define ETH_RX_BUFS  (ETH_RX_DESC + 8)
+// Longest segment of a transmitted frame (descriptor buffer length)
+#define ETH_SEG_MAX  0x3FFF
+
+/* Flags of received frames */
+#define ETH_RX_IPV4 (1 << 0)
+#define ETH_RX_CSUM (1 << 1) /* IP header and TCP/UDP/ICMP checksums verified */
+
+/**
+ * @brief Received frame, a reference to a receive buffer
+ *
+ * The buffer belongs to the caller of eth_recv() until eth_release().
+ */
+typedef struct eth_frame
+{
+	u8  *data;
+	u16  len;   // Length of the frame, without FCS
+	u16  flags; // ETH_RX_*
+} eth_frame;
+
+/**
+ * @brief Segment of a frame to transmit
+ *
+ * The data is read by the DMA, it must stay valid until the frame has
+ * been sent (see the done callback of eth_send).
+ */
+typedef struct eth_seg
+{
+	const void *data;
+	u16 len;
+} eth_seg;
+
+typedef void (*eth_done_fct)(void *arg);
+
+/**
+ * @brief Counters of the driver (see eth_dump)
+ */
+typedef struct eth_stats
+{
+	u32 rx;       // Frames received
+	u32 rx_err;   // Frames dropped : MAC error or too long
+	u32 rx_nobuf; // Frames dropped : all buffers held by upper layers
+	u32 tx;       // Frames sent
+	u32 tx_err;   // Frames aborted by the MAC
+	u32 tx_full;  // Frames rejected : not enough free descriptors
+} eth_stats;
+
+extern pool      pool_eth;
+extern eth_stats eth_stat;
+
+void eth_init    (void);
+int  eth_link    (void);
+void eth_loopback(int enable);
+void eth_addr    (u8 *mac);
+int  eth_recv    (eth_frame *frame);
+int  eth_release (eth_frame *frame);
+int  eth_send    (const eth_seg *seg, uint count, eth_done_fct done, void *arg);
+void eth_poll    (void);
+void eth_dump    (void);
+
+#endif
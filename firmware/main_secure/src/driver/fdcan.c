@@ -0,0 +1,496 @@
+/**
+ * @file  driver/fdcan.c
+ * @brief Driver of FDCAN1, bus between the panels of a site (CAN FD)
+ *
+ * Acceptance filtering is done by the controller : the filter elements of
+ * the message RAM only let the identifiers of this panel reach the CPU,
+ * other messages of the bus are discarded without an interrupt. Accepted
+ * messages are stored into two FIFOs, each one with its interrupt line :
+ *   - FIFO 0 (line 0) : door commands and site alerts, the handler
+ *     registered with fdcan_handler() is called from the interrupt
+ *   - FIFO 1 (line 1) : bulk synchronization, copied into a queue at a
+ *     lower priority and read by the main loop with fdcan_recv()
+ *
+ * The bus runs at 500 kbit/s (arbitration) and 2 Mbit/s (data phase, bit
+ * rate switching), with messages up to 64 bytes.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "driver/fdcan.h"
+#include "irq.h"
+#include "log.h"
+#include "power.h"
+#include "trace.h"
+
+/* Kernel clock : PLL2 Q, from HSI (32 MHz / 4 * 40 / 4 = 80 MHz) */
+#define PLL2_M 4
+#define PLL2_N 40
+#define PLL2_P 2
+#define PLL2_Q 4
+#define PLL2_R 2
+#define RCC_CR_PLL2ON  (1u << 26)
+#define RCC_CR_PLL2RDY (1u << 27)
+// PLL2SRC=HSI, PLL2RGE=3 (8-16 MHz input), Q output enabled
+#define PLL2CFGR ((1u << 0) | (3u << 2) | (PLL2_M << 8) | (1u << 17))
+#define PLL2DIVR (((PLL2_N - 1) << 0) | ((PLL2_P - 1) << 9) | \
+                  ((PLL2_Q - 1) << 16) | ((PLL2_R - 1) << 24))
+
+/* Nominal bit rate : 80 MHz / 10 = 8 MHz, 16 tq (87.5%) = 500 kbit/s */
+#define NBTP_VALUE ((1u << 25) | ((10 - 1) << 16) | ((13 - 1) << 8) | (2 - 1))
+/* Data bit rate : 80 MHz / 2 = 40 MHz, 20 tq (80%) = 2 Mbit/s, with TDC */
+#define DBTP_TDC   (1u << 23)
+#define DBTP_VALUE (DBTP_TDC | ((2 - 1) << 16) | ((15 - 1) << 8) | ((4 - 1) << 4) | (4 - 1))
+// Transmitter delay compensation offset : sample point, in kernel clocks
+#define TDCR_VALUE (((1 + 15) * 2) << 8)
+
+/* RXGFC : reject non-matching and remote frames */
+#define RXGFC_RRFE (1u << 0)
+#define RXGFC_RRFS (1u << 1)
+#define RXGFC_ANFE (2u << 2)
+#define RXGFC_ANFS (2u << 4)
+
+#define FDCAN_RAM(off) (SRAMCAN + (off))
+
+void FDCAN1_IT0_Handler(void);
+void FDCAN1_IT1_Handler(void);
+
+static void _config(int enable);
+static uint _dlc(uint len);
+static int  _read(uint fifo, fdcan_msg *msg);
+
+static const u8 dlc_len[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+
+static fdcan_rx_fct rx_handler;
+// Queue of FIFO 1 messages, written by the handler of line 1 only
+static fdcan_msg sync_queue[FDCAN_SYNC_QUEUE];
+static vu32 sync_head;
+static vu32 sync_tail;
+
+fdcan_stats fdcan_stat;
+
+/**
+ * @brief Initialize the controller and join the bus
+ *
+ * The filters accept site alerts, the door commands of this node and the
+ * synchronization messages, everything else is rejected by the controller.
+ *
+ * @param node Number of this panel on the bus (0 to 15)
+ */
+void fdcan_init(uint node)
+{
+	fdcan_filter filters[3];
+	uint i;
+	u32  v;
+
+	sync_head = 0;
+	sync_tail = 0;
+
+	// Filters : site alerts, door commands of this node, synchronization
+	node &= (FDCAN_NODE_MAX - 1);
+	filters[0].xtd    = 0;
+	filters[0].type   = FDCAN_RANGE;
+	filters[0].action = FDCAN_PRIO_FIFO0;
+	filters[0].id1    = FDCAN_ID_ALERT;
+	filters[0].id2    = FDCAN_ID_ALERT_END;
+	filters[1].xtd    = 0;
+	filters[1].type   = FDCAN_RANGE;
+	filters[1].action = FDCAN_FIFO0;
+	filters[1].id1    = FDCAN_ID_DOOR + (node * FDCAN_ID_DOOR_NODE);
+	filters[1].id2    = filters[1].id1 + FDCAN_ID_DOOR_NODE - 1;
+	filters[2].xtd    = 1;
+	filters[2].type   = FDCAN_MASK;
+	filters[2].action = FDCAN_FIFO1;
+	filters[2].id1    = FDCAN_ID_SYNC;
+	filters[2].id2    = FDCAN_ID_SYNC_MASK;
+
+	// Kernel clock : PLL2 Q output
+	reg_wr(RCC_PLL2CFGR(RCC), PLL2CFGR);
+	reg_wr(RCC_PLL2DIVR(RCC), PLL2DIVR);
+	reg_set(RCC_CR(RCC), RCC_CR_PLL2ON);
+	for (i = 0; ((reg_rd(RCC_CR(RCC)) & RCC_CR_PLL2RDY) == 0) && (i < 100000); i++)
+		;
+	v = reg_rd(RCC_CCIPR5(RCC)) & ~(3u << 8);
+	reg_wr(RCC_CCIPR5(RCC), v | (2u << 8));
+
+	// Activate FDCAN clock then reset the peripheral (both instances)
+	reg_set(RCC_APB1HENR(RCC), (1 << 9));
+	reg_set(RCC_APB1HRST(RCC), (1 << 9));
+	reg_clr(RCC_APB1HRST(RCC), (1 << 9));
+
+	// Pins, AF9 : PD0 RX, PD1 TX
+	reg_set(RCC_AHB2ENR(RCC), (1 << 3));
+	hw_gpio_af(GPIOD, (1 << 0) | (1 << 1), 9);
+
+	_config(1);
+	reg_wr(FDCAN_CKDIV(FDCAN1), 0);
+	reg_set(FDCAN_CCCR(FDCAN1), FDCAN_CCCR_FDOE | FDCAN_CCCR_BRSE);
+	reg_wr(FDCAN_NBTP(FDCAN1), NBTP_VALUE);
+	reg_wr(FDCAN_DBTP(FDCAN1), DBTP_VALUE);
+	reg_wr(FDCAN_TDCR(FDCAN1), TDCR_VALUE);
+
+	// Message RAM is not initialized by the reset
+	for (i = 0; i < FDCAN_RAM_SIZE; i += 4)
+		reg_wr(FDCAN_RAM(i), 0);
+
+	// Tx FIFO mode (TFQM = 0), messages are sent in the order of requests
+	reg_wr(FDCAN_TXBC(FDCAN1), 0);
+
+	// Interrupts : FIFO 0 and errors on line 0, FIFO 1 on line 1
+	reg_wr(FDCAN_IR(FDCAN1),  0xFFFFFFFF);
+	reg_wr(FDCAN_IE(FDCAN1),  FDCAN_IR_RF0N | FDCAN_IR_RF0L | FDCAN_IR_BO |
+	                          FDCAN_IR_RF1N | FDCAN_IR_RF1L);
+	reg_wr(FDCAN_ILS(FDCAN1), FDCAN_ILS_RXFIFO1);
+	reg_wr(FDCAN_ILE(FDCAN1), FDCAN_ILE_EINT0 | FDCAN_ILE_EINT1);
+#ifdef HOST
+	sim_vector(IRQ_FDCAN1_IT0, FDCAN1_IT0_Handler);
+	sim_vector(IRQ_FDCAN1_IT1, FDCAN1_IT1_Handler);
+#endif
+	// Bus activity can not wake the core from STOP, keep the clocks
+	power_hold(POWER_HOLD_CAN);
+	// The controller joins the bus once the filters are set
+	fdcan_filters(filters, 3);
+}
+
+/**
+ * @brief Program the acceptance filters
+ *
+ * Filters are evaluated by the controller in the order of the list (one
+ * list for standard identifiers, one for extended identifiers), the first
+ * match gives the action. Messages that match no filter are rejected. The
+ * controller leaves the bus while the filters are written.
+ *
+ * @param f     Pointer to a list of filters
+ * @param count Number of filters into the list
+ * @return integer Zero on success, -1 if too many filters
+ */
+int fdcan_filters(const fdcan_filter *f, uint count)
+{
+	uint nstd = 0, next = 0;
+	uint i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (f[i].xtd)
+			next++;
+		else
+			nstd++;
+	}
+	if ((nstd > FDCAN_STD_MAX) || (next > FDCAN_EXT_MAX))
+		return(-1);
+
+	_config(1);
+	nstd = next = 0;
+	for (i = 0; i < count; i++, f++)
+	{
+		if (f->xtd)
+		{
+			reg_wr(FDCAN_RAM(FDCAN_RAM_FLE + (next * 8)),
+			       ((u32)f->action << 29) | (f->id1 & 0x1FFFFFFF));
+			reg_wr(FDCAN_RAM(FDCAN_RAM_FLE + (next * 8) + 4),
+			       ((u32)f->type << 30) | (f->id2 & 0x1FFFFFFF));
+			next++;
+		}
+		else
+		{
+			reg_wr(FDCAN_RAM(FDCAN_RAM_FLS + (nstd * 4)),
+			       ((u32)f->type << 30) | ((u32)f->action << 27) |
+			       ((f->id1 & 0x7FF) << 16) | (f->id2 & 0x7FF));
+			nstd++;
+		}
+	}
+	reg_wr(FDCAN_XIDAM(FDCAN1), 0x1FFFFFFF);
+	reg_wr(FDCAN_RXGFC(FDCAN1), (next << 24) | (nstd << 16) |
+	       RXGFC_ANFS | RXGFC_ANFE | RXGFC_RRFS | RXGFC_RRFE);
+	_config(0);
+	return(0);
+}
+
+/**
+ * @brief Enable or disable the internal loopback (test mode)
+ *
+ * Sent messages are received back by the controller, through the filters,
+ * and not sent on the bus.
+ *
+ * @param enable Non-zero to enable loopback
+ */
+void fdcan_loopback(int enable)
+{
+	_config(1);
+	if (enable)
+	{
+		reg_set(FDCAN_CCCR(FDCAN1), FDCAN_CCCR_TEST | FDCAN_CCCR_MON);
+		reg_set(FDCAN_TEST(FDCAN1), FDCAN_TEST_LBCK);
+	}
+	else
+	{
+		reg_clr(FDCAN_TEST(FDCAN1), FDCAN_TEST_LBCK);
+		reg_clr(FDCAN_CCCR(FDCAN1), FDCAN_CCCR_TEST | FDCAN_CCCR_MON);
+	}
+	_config(0);
+}
+
+/**
+ * @brief Set the function called for each message of FIFO 0
+ *
+ * The function is called from the interrupt handler (IRQ_PRIO_DOOR), it
+ * should only start the action requested by the message.
+ *
+ * @param fct Pointer to the handler function (or NULL)
+ */
+void fdcan_handler(fdcan_rx_fct fct)
+{
+	rx_handler = fct;
+}
+
+/**
+ * @brief Give a message to the controller for transmission
+ *
+ * Messages longer than 8 bytes are sent as FD frames. Data is padded with
+ * zeros to the next valid FD length.
+ *
+ * @param msg Pointer to the message to send
+ * @return integer Zero on success, -1 if no Tx buffer is free
+ */
+int fdcan_send(const fdcan_msg *msg)
+{
+	u32  addr, t0, t1, w;
+	uint dlc, len, i, j;
+	u32  fqs;
+
+	fqs = reg_rd(FDCAN_TXFQS(FDCAN1));
+	if (fqs & (1u << 21))
+	{
+		fdcan_stat.tx_full++;
+		return(-1);
+	}
+	addr = FDCAN_RAM(FDCAN_RAM_TB + (((fqs >> 16) & 3) * FDCAN_ELEM));
+
+	len = (msg->len > 64) ? 64 : msg->len;
+	dlc = _dlc(len);
+	if (msg->flags & FDCAN_XTD)
+		t0 = FDCAN_E0_XTD | (msg->id & 0x1FFFFFFF);
+	else
+		t0 = (msg->id & 0x7FF) << 18;
+	t1 = (u32)dlc << 16;
+	if ((msg->flags & FDCAN_FD) || (len > 8))
+	{
+		t1 |= FDCAN_E1_FDF;
+		if (msg->flags & FDCAN_BRS)
+			t1 |= FDCAN_E1_BRS;
+	}
+	reg_wr(addr + 0, t0);
+	reg_wr(addr + 4, t1);
+	for (i = 0; i < dlc_len[dlc]; i += 4)
+	{
+		w = 0;
+		for (j = 0; j < 4; j++)
+			if ((i + j) < len)
+				w |= (u32)msg->data[i + j] << (j * 8);
+		reg_wr(addr + 8 + i, w);
+	}
+	reg_wr(FDCAN_TXBAR(FDCAN1), (1u << ((fqs >> 16) & 3)));
+	fdcan_stat.tx++;
+	return(0);
+}
+
+/**
+ * @brief Get the oldest synchronization message (FIFO 1)
+ *
+ * @param msg Pointer to a message structure to fill
+ * @return integer Zero on success, -1 if no message is waiting
+ */
+int fdcan_recv(fdcan_msg *msg)
+{
+	u32 tail = sync_tail;
+
+	if (tail == sync_head)
+		return(-1);
+	*msg = sync_queue[tail % FDCAN_SYNC_QUEUE];
+	sync_tail = tail + 1;
+	return(0);
+}
+
+/**
+ * @brief Print the counters of the driver
+ *
+ */
+void fdcan_dump(void)
+{
+	log_print(0, " * FDCAN: rx %d/%d (lost %d/%d, drop %d), tx %d (full %d), bus-off %d\n",
+	          fdcan_stat.rx[0], fdcan_stat.rx[1], fdcan_stat.lost[0],
+	          fdcan_stat.lost[1], fdcan_stat.drop, fdcan_stat.tx,
+	          fdcan_stat.tx_full, fdcan_stat.busoff);
+}
+
+/**
+ * @brief Interrupt handler of line 0 : FIFO 0 and bus errors
+ *
+ */
+HOT_FCT void FDCAN1_IT0_Handler(void)
+{
+	fdcan_msg msg;
+	u32 ir;
+
+	trace_enter(TRACE_ID_FDCAN_IT0);
+	ir = reg_rd(FDCAN_IR(FDCAN1)) & (FDCAN_IR_RF0N | FDCAN_IR_RF0L | FDCAN_IR_BO);
+	reg_wr(FDCAN_IR(FDCAN1), ir);
+
+	if (ir & FDCAN_IR_RF0L)
+		fdcan_stat.lost[0]++;
+	// Bus-off : leave init mode to start the recovery sequence
+	if ((ir & FDCAN_IR_BO) && (reg_rd(FDCAN_PSR(FDCAN1)) & FDCAN_PSR_BO))
+	{
+		reg_clr(FDCAN_CCCR(FDCAN1), FDCAN_CCCR_INIT);
+		fdcan_stat.busoff++;
+	}
+
+	while (_read(0, &msg) == 0)
+	{
+		fdcan_stat.rx[0]++;
+		if (rx_handler)
+			rx_handler(&msg);
+	}
+	trace_exit(TRACE_ID_FDCAN_IT0);
+}
+
+/**
+ * @brief Interrupt handler of line 1 : FIFO 1
+ *
+ */
+HOT_FCT void FDCAN1_IT1_Handler(void)
+{
+	fdcan_msg discard;
+	u32 ir, head;
+
+	trace_enter(TRACE_ID_FDCAN_IT1);
+	ir = reg_rd(FDCAN_IR(FDCAN1)) & (FDCAN_IR_RF1N | FDCAN_IR_RF1L);
+	reg_wr(FDCAN_IR(FDCAN1), ir);
+
+	if (ir & FDCAN_IR_RF1L)
+		fdcan_stat.lost[1]++;
+
+	for (;;)
+	{
+		head = sync_head;
+		if ((head - sync_tail) >= FDCAN_SYNC_QUEUE)
+		{
+			// Queue full : the message is read anyway to free the FIFO
+			if (_read(1, &discard) != 0)
+				break;
+			fdcan_stat.drop++;
+			continue;
+		}
+		if (_read(1, &sync_queue[head % FDCAN_SYNC_QUEUE]) != 0)
+			break;
+		fdcan_stat.rx[1]++;
+		sync_head = head + 1;
+	}
+	trace_count(TRACE_ID_CAN_QUEUE, (uint)(sync_head - sync_tail));
+	trace_exit(TRACE_ID_FDCAN_IT1);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Enter or leave the configuration mode
+ *
+ * Protected registers (bit timing, filters, test) can only be written in
+ * configuration mode, the controller is then disconnected from the bus.
+ *
+ * @param enable Non-zero to enter configuration mode, zero to leave it
+ */
+static void _config(int enable)
+{
+	uint i;
+
+	if (enable)
+	{
+		reg_set(FDCAN_CCCR(FDCAN1), FDCAN_CCCR_INIT);
+		// INIT is synchronized with the CAN clock
+		for (i = 0; ((reg_rd(FDCAN_CCCR(FDCAN1)) & FDCAN_CCCR_INIT) == 0) && (i < 10000); i++)
+			;
+		reg_set(FDCAN_CCCR(FDCAN1), FDCAN_CCCR_CCE);
+	}
+	else
+		reg_clr(FDCAN_CCCR(FDCAN1), FDCAN_CCCR_INIT);
+}
+
+/**
+ * @brief Get the data length code for a length of data
+ *
+ * @param len Length of data (0 to 64 bytes)
+ * @return uint Smallest DLC with room for the data
+ */
+static uint _dlc(uint len)
+{
+	uint dlc;
+
+	for (dlc = 0; dlc < 15; dlc++)
+		if (dlc_len[dlc] >= len)
+			break;
+	return(dlc);
+}
+
+/**
+ * @brief Read the oldest element of an Rx FIFO
+ *
+ * @param fifo Number of the FIFO (0 or 1)
+ * @param msg  Pointer to a message structure to fill
+ * @return integer Zero on success, -1 if the FIFO is empty
+ */
+HOT_FCT static int _read(uint fifo, fdcan_msg *msg)
+{
+	u32  addr, r0, r1, w, s;
+	uint gi, len, i, j;
+
+	s = reg_rd(fifo ? FDCAN_RXF1S(FDCAN1) : FDCAN_RXF0S(FDCAN1));
+	if ((s & 0xF) == 0)
+		return(-1);
+	gi = (s >> 8) & 3;
+	addr = FDCAN_RAM((fifo ? FDCAN_RAM_F1 : FDCAN_RAM_F0) + (gi * FDCAN_ELEM));
+
+	r0 = reg_rd(addr + 0);
+	r1 = reg_rd(addr + 4);
+	if (r0 & FDCAN_E0_XTD)
+	{
+		msg->id    = r0 & 0x1FFFFFFF;
+		msg->flags = FDCAN_XTD;
+	}
+	else
+	{
+		msg->id    = (r0 >> 18) & 0x7FF;
+		msg->flags = 0;
+	}
+	len = dlc_len[(r1 >> 16) & 0xF];
+	if (r1 & FDCAN_E1_FDF)
+		msg->flags |= FDCAN_FD;
+	else if (len > 8)
+		len = 8;
+	if (r1 & FDCAN_E1_BRS)
+		msg->flags |= FDCAN_BRS;
+	msg->len    = (u8)len;
+	msg->filter = (u8)((r1 >> 24) & 0x7F);
+
+	for (i = 0; i < len; i += 4)
+	{
+		w = reg_rd(addr + 8 + i);
+		for (j = 0; (j < 4) && ((i + j) < len); j++)
+			msg->data[i + j] = (u8)(w >> (j * 8));
+	}
+	// Acknowledge : the element can be reused by the controller
+	reg_wr(fifo ? FDCAN_RXF1A(FDCAN1) : FDCAN_RXF0A(FDCAN1), gi);
+	return(0);
+}
+/* EOF */
@@ -0,0 +1,163 @@
+/**
+ * @file  driver/fdcan.h
+ * @brief Definitions and prototypes for the FDCAN driver (inter-panel bus)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef FDCAN_H
+#define FDCAN_H
+#include "types.h"
+
+// FDCAN registers
+#define FDCAN_DBTP(x)  (x + 0x00C)
+#define FDCAN_TEST(x)  (x + 0x010)
+#define FDCAN_CCCR(x)  (x + 0x018)
+#define FDCAN_NBTP(x)  (x + 0x01C)
+#define FDCAN_ECR(x)   (x + 0x040)
+#define FDCAN_PSR(x)   (x + 0x044)
+#define FDCAN_TDCR(x)  (x + 0x048)
+#define FDCAN_IR(x)    (x + 0x050)
+#define FDCAN_IE(x)    (x + 0x054)
+#define FDCAN_ILS(x)   (x + 0x058)
+#define FDCAN_ILE(x)   (x + 0x05C)
+#define FDCAN_RXGFC(x) (x + 0x080)
+#define FDCAN_XIDAM(x) (x + 0x084)
+#define FDCAN_HPMS(x)  (x + 0x088)
+#define FDCAN_RXF0S(x) (x + 0x090)
+#define FDCAN_RXF0A(x) (x + 0x094)
+#define FDCAN_RXF1S(x) (x + 0x098)
+#define FDCAN_RXF1A(x) (x + 0x09C)
+#define FDCAN_TXBC(x)  (x + 0x0C0)
+#define FDCAN_TXFQS(x) (x + 0x0C4)
+#define FDCAN_TXBAR(x) (x + 0x0CC)
+#define FDCAN_CKDIV(x) (x + 0x100)
+
+/* CCCR */
+#define FDCAN_CCCR_INIT (1 << 0)
+#define FDCAN_CCCR_CCE  (1 << 1)
+#define FDCAN_CCCR_MON  (1 << 5)
+#define FDCAN_CCCR_TEST (1 << 7)
+#define FDCAN_CCCR_FDOE (1 << 8) /* FD operation */
+#define FDCAN_CCCR_BRSE (1 << 9) /* Bit rate switching */
+/* TEST */
+#define FDCAN_TEST_LBCK (1 << 4)
+/* IR, IE : interrupts used by the driver */
+#define FDCAN_IR_RF0N (1u << 0)
+#define FDCAN_IR_RF0L (1u << 2)
+#define FDCAN_IR_RF1N (1u << 3)
+#define FDCAN_IR_RF1L (1u << 5)
+#define FDCAN_IR_BO   (1u << 19)
+/* ILS : interrupt groups, ILE : lines */
+#define FDCAN_ILS_RXFIFO1 (1 << 1)
+#define FDCAN_ILE_EINT0   (1 << 0)
+#define FDCAN_ILE_EINT1   (1 << 1)
+/* PSR */
+#define FDCAN_PSR_BO (1 << 7)
+
+/* Message RAM : fixed layout of one instance (words of 32 bits) */
+#define FDCAN_RAM_FLS  0x000 /* 28 standard filters, 1 word  */
+#define FDCAN_RAM_FLE  0x070 /*  8 extended filters, 2 words */
+#define FDCAN_RAM_F0   0x0B0 /* Rx FIFO 0, 3 elements */
+#define FDCAN_RAM_F1   0x188 /* Rx FIFO 1, 3 elements */
+#define FDCAN_RAM_EF   0x260 /* Tx event FIFO, 3 elements of 2 words */
+#define FDCAN_RAM_TB   0x278 /* Tx buffers, 3 elements */
+#define FDCAN_RAM_SIZE 0x350
+#define FDCAN_ELEM     72    /* Rx/Tx element : 2 header words and 64 bytes */
+#define FDCAN_FIFO_LEN 3
+#define FDCAN_STD_MAX  28
+#define FDCAN_EXT_MAX   8
+
+/* Rx/Tx element headers */
+#define FDCAN_E0_XTD  (1u << 30)
+#define FDCAN_E0_RTR  (1u << 29)
+#define FDCAN_E1_FDF  (1u << 21)
+#define FDCAN_E1_BRS  (1u << 20)
+#define FDCAN_R1_ANMF (1u << 31) /* Accepted by the global filter */
+
+/* Filter types (SFT, EFT) */
+#define FDCAN_RANGE 0 /* id1 <= id <= id2 */
+#define FDCAN_DUAL  1 /* id == id1 or id == id2 */
+#define FDCAN_MASK  2 /* (id & id2) == (id1 & id2) */
+/* Filter actions (SFEC, EFEC) */
+#define FDCAN_FIFO0       1
+#define FDCAN_FIFO1       2
+#define FDCAN_REJECT      3
+#define FDCAN_PRIO_FIFO0  5 /* Store into FIFO 0, high priority message */
+#define FDCAN_PRIO_FIFO1  6
+
+/* Identifiers of the inter-panel bus (see fdcan.md) */
+#define FDCAN_ID_ALERT      0x010 /* 0x010-0x01F : site alerts (all panels) */
+#define FDCAN_ID_ALERT_END  0x01F
+#define FDCAN_ID_DOOR       0x100 /* 0x100-0x17F : door commands, 8 per node */
+#define FDCAN_ID_DOOR_NODE  8
+#define FDCAN_NODE_MAX      16
+#define FDCAN_ID_SYNC       0x18000000 /* Extended : bulk synchronization */
+#define FDCAN_ID_SYNC_MASK  0x1FF00000
+
+// Messages of FIFO 1 kept by the driver until fdcan_recv()
+#define FDCAN_SYNC_QUEUE 8
+
+/* Flags of messages */
+#define FDCAN_XTD (1 << 0) /* Extended (29 bits) identifier */
+#define FDCAN_FD  (1 << 1) /* FD frame, up to 64 bytes      */
+#define FDCAN_BRS (1 << 2) /* Data phase at the data bit rate */
+
+/**
+ * @brief Acceptance filter, programmed into the message RAM
+ */
+typedef struct fdcan_filter
+{
+	u8  xtd;    // Non-zero for an extended identifier filter
+	u8  type;   // FDCAN_RANGE, FDCAN_DUAL or FDCAN_MASK
+	u8  action; // FDCAN_FIFO0, FDCAN_FIFO1, FDCAN_REJECT ...
+	u32 id1;
+	u32 id2;
+} fdcan_filter;
+
+/**
+ * @brief Received or transmitted message
+ */
+typedef struct fdcan_msg
+{
+	u32 id;
+	u8  flags;  // FDCAN_XTD, FDCAN_FD, FDCAN_BRS
+	u8  len;    // Length of data (0 to 64)
+	u8  filter; // Index of the matching filter (received messages)
+	u8  data[64];
+} fdcan_msg;
+
+typedef void (*fdcan_rx_fct)(const fdcan_msg *msg);
+
+/**
+ * @brief Counters of the driver (see fdcan_dump)
+ */
+typedef struct fdcan_stats
+{
+	u32 rx[2];   // Messages received, per FIFO
+	u32 lost[2]; // Messages lost : FIFO full
+	u32 drop;    // FIFO 1 messages dropped : queue full
+	u32 tx;      // Messages given to the controller
+	u32 tx_full; // Messages rejected : no free Tx buffer
+	u32 busoff;  // Recoveries from bus-off
+} fdcan_stats;
+
+extern fdcan_stats fdcan_stat;
+
+void fdcan_init    (uint node);
+int  fdcan_filters (const fdcan_filter *f, uint count);
+void fdcan_loopback(int enable);
+void fdcan_handler (fdcan_rx_fct fct);
+int  fdcan_send    (const fdcan_msg *msg);
+int  fdcan_recv    (fdcan_msg *msg);
+void fdcan_dump    (void);
+
+#endif
@@ -0,0 +1,315 @@
+/**
+ * @file  flash.c
+ * @brief This file contains a driver for STM32H5 embedded flash memory
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/flash.h"
+#include "hardware.h"
+#include "types.h"
+
+#define SR_BUSY  ((1 << 0) | (1 << 1) | (1 << 3)) /* BSY, WBNE, DBNE */
+#define SR_ERROR (0x7F << 17) /* WRPERR to OPTCHANGEERR */
+
+static inline int _is_secure(u32 addr);
+static int  _unlock(u32 keyr, u32 cr);
+static int  _wait(u32 sr, u32 ccr);
+
+/**
+ * @brief Initialize the flash driver
+ *
+ */
+void flash_init(void)
+{
+	// Clear all pending status flags
+	reg_wr(FLASH_NSCCR(FLASH), (0xFF << 16));
+#ifdef RUN_SEC
+	reg_wr(FLASH_SECCCR(FLASH), (0xFF << 16));
+#endif
+}
+
+/**
+ * @brief Unlock flash control registers for erase and program operations
+ *
+ * @return FLASH_OK on success, FLASH_ERR_LOCK if registers are still locked
+ */
+int flash_unlock(void)
+{
+	if (_unlock(FLASH_NSKEYR(FLASH), FLASH_NSCR(FLASH)) < 0)
+		return(FLASH_ERR_LOCK);
+#ifdef RUN_SEC
+	if (_unlock(FLASH_SECKEYR(FLASH), FLASH_SECCR(FLASH)) < 0)
+		return(FLASH_ERR_LOCK);
+#endif
+	return(FLASH_OK);
+}
+
+/**
+ * @brief Lock flash control registers
+ *
+ */
+void flash_lock(void)
+{
+	reg_wr(FLASH_NSCR(FLASH), (1 << 0));
+#ifdef RUN_SEC
+	reg_wr(FLASH_SECCR(FLASH), (1 << 0));
+#endif
+}
+
+/**
+ * @brief Test if flash control registers are locked
+ *
+ * A module that writes the flash in the background uses this to restore
+ * the lock state, another one (like an update) may have unlocked it.
+ *
+ * @return True if the control register of current security state is locked
+ */
+int flash_locked(void)
+{
+#ifdef RUN_SEC
+	return ((reg_rd(FLASH_SECCR(FLASH)) & (1 << 0)) != 0);
+#else
+	return ((reg_rd(FLASH_NSCR(FLASH)) & (1 << 0)) != 0);
+#endif
+}
+
+/**
+ * @brief Erase the sector that contains an address
+ *
+ * The bank selector (BKSEL) designates a physical bank, so the current
+ * SWAP_BANK state is applied to the bank seen at the given address.
+ *
+ * @param addr Any address into the sector to erase
+ * @return FLASH_OK on success, FLASH_ERR_PROG on failure
+ */
+int flash_erase(u32 addr)
+{
+	u32 sr, cr, ccr;
+	u32 offset, sect, bank;
+	u32 v;
+
+	if (_is_secure(addr))
+	{
+		sr  = FLASH_SECSR(FLASH);
+		cr  = FLASH_SECCR(FLASH);
+		ccr = FLASH_SECCCR(FLASH);
+	}
+	else
+	{
+		sr  = FLASH_NSSR(FLASH);
+		cr  = FLASH_NSCR(FLASH);
+		ccr = FLASH_NSCCR(FLASH);
+	}
+
+	offset = (addr & 0x001FFFFF);
+	bank   = (offset / FLASH_BANK_SIZE);
+	sect   = (offset % FLASH_BANK_SIZE) / FLASH_SECT_SIZE;
+	if (flash_swapped())
+		bank ^= 1;
+
+	v  = (1 << 2);             // SER : Sector erase
+	v |= (sect & 0x7F) << 6;   // SNB : Sector number
+	v |= (bank << 31);         // BKSEL
+	reg_wr(cr, v);
+	reg_wr(cr, v | (1 << 5));  // STRT
+	if (_wait(sr, ccr) < 0)
+	{
+		reg_wr(cr, 0);
+		return(FLASH_ERR_PROG);
+	}
+	reg_wr(cr, 0);
+	return(FLASH_OK);
+}
+
+/**
+ * @brief Program one quad-word (128 bits) into flash
+ *
+ * @param addr Destination address (16 bytes aligned, erased)
+ * @param qw   Pointer to the four words to program
+ * @return FLASH_OK on success, a negative FLASH_ERR_* code on failure
+ */
+int flash_program(u32 addr, const u32 *qw)
+{
+	u32 sr, cr, ccr;
+	int i;
+
+	if (addr & (FLASH_QW_SIZE - 1))
+		return(FLASH_ERR_ALIGN);
+
+	if (_is_secure(addr))
+	{
+		sr  = FLASH_SECSR(FLASH);
+		cr  = FLASH_SECCR(FLASH);
+		ccr = FLASH_SECCCR(FLASH);
+	}
+	else
+	{
+		sr  = FLASH_NSSR(FLASH);
+		cr  = FLASH_NSCR(FLASH);
+		ccr = FLASH_NSCCR(FLASH);
+	}
+
+	reg_wr(cr, (1 << 1)); // PG
+	for (i = 0; i < 4; i++)
+		reg_wr(addr + (u32)(4 * i), qw[i]);
+	i = _wait(sr, ccr);
+	reg_wr(cr, 0);
+	if (i < 0)
+		return(FLASH_ERR_PROG);
+
+	// Read back
+	for (i = 0; i < 4; i++)
+		if (reg_rd(addr + (u32)(4 * i)) != qw[i])
+			return(FLASH_ERR_PROG);
+	return(FLASH_OK);
+}
+
+/**
+ * @brief Get the address of an offset into the inactive bank
+ *
+ * The inactive bank is always seen at the second MB of the flash address
+ * space. Sectors covered by the secure watermark of this (physical) bank
+ * are reached through the secure alias.
+ *
+ * @param offset Offset into the bank
+ * @return u32 Address to use for read, erase and program
+ */
+u32 flash_inactive(u32 offset)
+{
+	u32 wm, sect, start, end;
+
+#ifdef RUN_SEC
+	if (flash_swapped())
+		wm = reg_rd(FLASH_SECWM1R_CUR(FLASH));
+	else
+		wm = reg_rd(FLASH_SECWM2R_CUR(FLASH));
+	start = (wm >>  0) & 0x7F;
+	end   = (wm >> 16) & 0x7F;
+	sect  = (offset / FLASH_SECT_SIZE);
+	if ((start <= end) && (sect >= start) && (sect <= end))
+		return(FLASH_BASE_S + FLASH_BANK_SIZE + offset);
+#else
+	(void)wm; (void)sect; (void)start; (void)end;
+#endif
+	return(FLASH_BASE_NS + FLASH_BANK_SIZE + offset);
+}
+
+/**
+ * @brief Test if flash banks are currently swapped
+ *
+ * @return True if SWAP_BANK is active (bank2 mapped at first MB)
+ */
+int flash_swapped(void)
+{
+	return ((reg_rd(FLASH_OPTSR_CUR(FLASH)) & (1u << 31)) != 0);
+}
+
+/**
+ * @brief Unlock OPTCR before modifying option bytes (*_PRG registers)
+ *
+ * @return FLASH_OK on success, FLASH_ERR_LOCK if OPTCR is still locked
+ */
+int flash_opt_unlock(void)
+{
+	if (reg_rd(FLASH_OPTCR(FLASH)) & (1 << 0))
+	{
+		reg_wr(FLASH_OPTKEYR(FLASH), 0x08192A3B);
+		reg_wr(FLASH_OPTKEYR(FLASH), 0x4C5D6E7F);
+	}
+	if (reg_rd(FLASH_OPTCR(FLASH)) & (1 << 0))
+		return(FLASH_ERR_LOCK);
+	return(FLASH_OK);
+}
+
+/**
+ * @brief Lock OPTCR
+ *
+ */
+void flash_opt_lock(void)
+{
+	reg_set(FLASH_OPTCR(FLASH), (1 << 0));
+}
+
+/**
+ * @brief Apply all pending option bytes modifications (OPTSTRT)
+ *
+ * @return FLASH_OK on success, FLASH_ERR_PROG if the change was rejected
+ */
+int flash_opt_start(void)
+{
+	reg_set(FLASH_OPTCR(FLASH), (1 << 1));
+	while (reg_rd(FLASH_OPTCR(FLASH)) & (1 << 1))
+		;
+	if (_wait(FLASH_NSSR(FLASH), FLASH_NSCCR(FLASH)) < 0)
+		return(FLASH_ERR_PROG);
+	return(FLASH_OK);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Test if an address targets the secure flash alias
+ *
+ * @param addr Address to test
+ * @return True if the address is into secure alias
+ */
+static inline int _is_secure(u32 addr)
+{
+#ifdef RUN_SEC
+	return ((addr & 0x04000000) != 0);
+#else
+	(void)addr;
+	return(0);
+#endif
+}
+
+/**
+ * @brief Unlock one flash control register
+ *
+ * @param keyr Address of the key register
+ * @param cr   Address of the control register
+ * @return 0 on success, -1 if still locked
+ */
+static int _unlock(u32 keyr, u32 cr)
+{
+	if (reg_rd(cr) & (1 << 0))
+	{
+		reg_wr(keyr, 0x45670123);
+		reg_wr(keyr, 0xCDEF89AB);
+	}
+	if (reg_rd(cr) & (1 << 0))
+		return(-1);
+	return(0);
+}
+
+/**
+ * @brief Wait end of current flash operation and check errors
+ *
+ * @param sr  Address of the status register
+ * @param ccr Address of the status clear register
+ * @return 0 on success, -1 if an error has been reported
+ */
+static int _wait(u32 sr, u32 ccr)
+{
+	u32 v;
+
+	while (reg_rd(sr) & SR_BUSY)
+		;
+	v = reg_rd(sr);
+	reg_wr(ccr, (0xFF << 16));
+	if (v & SR_ERROR)
+		return(-1);
+	return(0);
+}
+/* EOF */
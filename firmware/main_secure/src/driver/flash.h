@@ -0,0 +1,69 @@
+/**
+ * @file  flash.h
+ * @brief Headers and definitions for STM32H5 embedded flash driver
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef FLASH_H
+#define FLASH_H
+#include "types.h"
+
+// FLASH registers
+#define FLASH_ACR(x)         (x + 0x000)
+#define FLASH_NSKEYR(x)      (x + 0x004)
+#define FLASH_SECKEYR(x)     (x + 0x008)
+#define FLASH_OPTKEYR(x)     (x + 0x00C)
+#define FLASH_OPSR(x)        (x + 0x018)
+#define FLASH_OPTCR(x)       (x + 0x01C)
+#define FLASH_NSSR(x)        (x + 0x020)
+#define FLASH_SECSR(x)       (x + 0x024)
+#define FLASH_NSCR(x)        (x + 0x028)
+#define FLASH_SECCR(x)       (x + 0x02C)
+#define FLASH_NSCCR(x)       (x + 0x030)
+#define FLASH_SECCCR(x)      (x + 0x034)
+#define FLASH_OPTSR_CUR(x)   (x + 0x050)
+#define FLASH_OPTSR_PRG(x)   (x + 0x054)
+#define FLASH_OPTSR2_CUR(x)  (x + 0x070)
+#define FLASH_OPTSR2_PRG(x)  (x + 0x074)
+#define FLASH_SECBB1R1(x)    (x + 0x0A0)
+#define FLASH_SECWM1R_CUR(x) (x + 0x0E0)
+#define FLASH_SECWM1R_PRG(x) (x + 0x0E4)
+#define FLASH_SECBB2R1(x)    (x + 0x1A0)
+#define FLASH_SECWM2R_CUR(x) (x + 0x1E0)
+#define FLASH_SECWM2R_PRG(x) (x + 0x1E4)
+
+// Memory organization
+#define FLASH_BASE_NS   0x08000000
+#define FLASH_BASE_S    0x0C000000
+#define FLASH_BANK_SIZE 0x00100000
+#define FLASH_SECT_SIZE 0x2000
+#define FLASH_QW_SIZE   16
+
+// Result codes
+#define FLASH_OK        0
+#define FLASH_ERR_LOCK  -1
+#define FLASH_ERR_PROG  -2
+#define FLASH_ERR_ALIGN -3
+
+void flash_init(void);
+int  flash_unlock(void);
+void flash_lock(void);
+int  flash_locked(void);
+int  flash_erase(u32 addr);
+int  flash_program(u32 addr, const u32 *qw);
+u32  flash_inactive(u32 offset);
+int  flash_swapped(void);
+int  flash_opt_unlock(void);
+void flash_opt_lock(void);
+int  flash_opt_start(void);
+
+#endif
@@ -0,0 +1,259 @@
+/**
+ * @file  hash.c
+ * @brief This file contains a driver for STM32H5 HASH coprocessor
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/dma.h"
+#include "driver/hash.h"
+#include "hardware.h"
+#include "types.h"
+
+static void _start(int hmac, int long_key);
+static void _feed (const u8 *data, uint len);
+static void _close(void);
+static void _wait (u32 flag);
+static void _read (u8 *digest);
+
+static u8   tail[4];
+static uint tail_len;
+
+/**
+ * @brief Initialize the HASH driver
+ *
+ */
+void hash_init(void)
+{
+	// Activate HASH
+	reg_set(RCC_AHB2ENR(RCC), (1 << 17));
+	tail_len = 0;
+}
+
+/**
+ * @brief Start a new SHA-256 computation
+ *
+ */
+void hash_begin(void)
+{
+	_start(0, 0);
+}
+
+/**
+ * @brief Push data into current computation (using CPU)
+ *
+ * @param data Pointer to the data buffer
+ * @param len  Number of bytes into buffer (any size)
+ */
+void hash_update(const u8 *data, uint len)
+{
+	_feed(data, len);
+}
+
+/**
+ * @brief Push a memory area into current computation (using DMA)
+ *
+ * This function is used for large data blocks (like firmware images), the
+ * HASH input FIFO is fed by GPDMA and CPU only wait end of transfers.
+ *
+ * @param addr Address of the first byte to hash (32 bits aligned)
+ * @param len  Number of bytes (multiple of 4)
+ * @return 0 on success, -1 on error
+ */
+int hash_update_dma(u32 addr, uint len)
+{
+	uint n;
+	int  result = 0;
+
+	if (tail_len || (addr & 3) || (len & 3))
+		return(-1);
+
+	// Set DMAE and MDMAT (DCAL is set by software at the end)
+	reg_set(HASH_CR(HASH), (1 << 3) | (1 << 13));
+
+	while (len)
+	{
+		n = (len > DMA_BLOCK_MAX) ? DMA_BLOCK_MAX : len;
+		dma_start(DMA_CH_HASH, addr, HASH_DIN(HASH), n, DMA_REQ_HASH_IN, DMA_SINC);
+		if (dma_wait(DMA_CH_HASH) < 0)
+		{
+			result = -1;
+			break;
+		}
+		addr += n;
+		len  -= n;
+	}
+
+	reg_clr(HASH_CR(HASH), (1 << 3) | (1 << 13));
+	return(result);
+}
+
+/**
+ * @brief Finish current computation and read result
+ *
+ * @param digest Pointer to a buffer where to store digest (32 bytes)
+ */
+void hash_final(u8 *digest)
+{
+	_close();
+	_wait(1 << 1); // DCIS
+	_read(digest);
+}
+
+/**
+ * @brief Compute an HMAC-SHA256 of a (small) message
+ *
+ * @param key  Pointer to the secret key
+ * @param klen Length of the key in bytes
+ * @param msg  Pointer to the message
+ * @param len  Length of the message in bytes
+ * @param mac  Pointer to a buffer where to store result (32 bytes)
+ */
+void hash_hmac(const u8 *key, uint klen, const u8 *msg, uint len, u8 *mac)
+{
+	_start(1, (klen > 64));
+	// Inner key
+	_feed(key, klen);
+	_close();
+	_wait(1 << 0); // DINIS
+	// Message
+	_feed(msg, len);
+	_close();
+	_wait(1 << 0); // DINIS
+	// Outer key
+	_feed(key, klen);
+	_close();
+	_wait(1 << 1); // DCIS
+	_read(mac);
+}
+
+/**
+ * @brief Compare two buffers in constant time
+ *
+ * @param a   Pointer to first buffer
+ * @param b   Pointer to second buffer
+ * @param len Number of bytes to compare
+ * @return True if both buffers have the same content
+ */
+int hash_equal(const u8 *a, const u8 *b, uint len)
+{
+	u8 diff = 0;
+	uint i;
+
+	for (i = 0; i < len; i++)
+		diff |= (u8)(a[i] ^ b[i]);
+	return (diff == 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Configure and initialize the coprocessor for a new digest
+ *
+ * @param hmac     True to use HMAC mode, False for a simple hash
+ * @param long_key True if HMAC key is longer than one block (64 bytes)
+ */
+static void _start(int hmac, int long_key)
+{
+	u32 v;
+
+	v  = (3 << 17); // ALGO: SHA2-256
+	v |= (2 <<  4); // DATATYPE: bytes (input words are byte-swapped)
+	if (hmac)
+		v |= (1 << 6);
+	if (long_key)
+		v |= (1 << 16);
+	reg_wr(HASH_CR(HASH), v);
+	// Set INIT to start a new digest
+	reg_wr(HASH_CR(HASH), v | (1 << 2));
+	tail_len = 0;
+}
+
+/**
+ * @brief Write bytes to the input FIFO, keep incomplete word for later
+ *
+ * @param data Pointer to the data buffer
+ * @param len  Number of bytes into buffer
+ */
+static void _feed(const u8 *data, uint len)
+{
+	u32 w;
+
+	while (len)
+	{
+		tail[tail_len++] = *data++;
+		len--;
+		if (tail_len < 4)
+			continue;
+		w = (u32)((u32)tail[0] | ((u32)tail[1] << 8) |
+		          ((u32)tail[2] << 16) | ((u32)tail[3] << 24));
+		reg_wr(HASH_DIN(HASH), w);
+		tail_len = 0;
+	}
+}
+
+/**
+ * @brief Flush last (incomplete) word and start final digest calculation
+ *
+ */
+static void _close(void)
+{
+	u32 w = 0;
+	uint i;
+
+	if (tail_len)
+	{
+		for (i = 0; i < tail_len; i++)
+			w |= ((u32)tail[i] << (8 * i));
+		reg_wr(HASH_DIN(HASH), w);
+	}
+	// Set number of valid bits into last word, and DCAL
+	reg_wr(HASH_STR(HASH), (u32)(8 * tail_len) | (1 << 8));
+	tail_len = 0;
+}
+
+/**
+ * @brief Wait until a status flag is set
+ *
+ * @param flag Mask of the flag into HASH_SR
+ */
+static void _wait(u32 flag)
+{
+	while ((reg_rd(HASH_SR(HASH)) & flag) == 0)
+		;
+	// Also wait that the coprocessor is not busy
+	while (reg_rd(HASH_SR(HASH)) & (1 << 3))
+		;
+}
+
+/**
+ * @brief Read SHA-256 result registers
+ *
+ * @param digest Pointer to a buffer where to store digest (32 bytes)
+ */
+static void _read(u8 *digest)
+{
+	u32  v;
+	uint i;
+
+	for (i = 0; i < 8; i++)
+	{
+		v = reg_rd(HASH_HR(HASH, i));
+		// Result registers are big-endian
+		*digest++ = (u8)(v >> 24);
+		*digest++ = (u8)(v >> 16);
+		*digest++ = (u8)(v >>  8);
+		*digest++ = (u8)(v >>  0);
+	}
+}
+/* EOF */
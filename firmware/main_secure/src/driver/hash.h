@@ -0,0 +1,38 @@
+/**
+ * @file  hash.h
+ * @brief Headers and definitions for STM32H5 HASH coprocessor driver
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef HASH_H
+#define HASH_H
+#include "types.h"
+
+// HASH registers
+#define HASH_CR(x)    (x + 0x000)
+#define HASH_DIN(x)   (x + 0x004)
+#define HASH_STR(x)   (x + 0x008)
+#define HASH_IMR(x)   (x + 0x020)
+#define HASH_SR(x)    (x + 0x024)
+#define HASH_HR(x, n) (x + 0x310 + (4 * n))
+
+#define HASH_SHA256_LEN 32
+
+void hash_init  (void);
+void hash_begin (void);
+void hash_update(const u8 *data, uint len);
+int  hash_update_dma(u32 addr, uint len);
+void hash_final (u8 *digest);
+void hash_hmac  (const u8 *key, uint klen, const u8 *msg, uint len, u8 *mac);
+int  hash_equal (const u8 *a, const u8 *b, uint len);
+
+#endif
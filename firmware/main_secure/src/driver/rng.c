@@ -0,0 +1,239 @@
+/**
+ * @file  rng.c
+ * @brief This file contains a driver for STM32H5 RNG (true random generator)
+ *
+ * The RNG is clocked by HSI48 and configured with the NIST recommended
+ * values. It runs in the background : each time a word is ready the
+ * interrupt (RNG_Handler) reads it and checks it with two continuous health
+ * tests (NIST SP 800-90B, on top of the hardware ones) :
+ * - repetition count : two identical consecutive words
+ * - adaptive proportion : the low byte of the first word of a window found
+ *   too often into the window
+ * A block of RNG_BLOCK words is then given to the conditioning function.
+ * On a failure (or a seed error) the words collected are discarded and the
+ * RNG is restarted (CONDRST).
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/rng.h"
+#include "hardware.h"
+#include "irq.h"
+#include "types.h"
+
+/* RCC_CR */
+#define RCC_CR_HSI48ON  (1u << 12)
+#define RCC_CR_HSI48RDY (1u << 13)
+/* RNG_CR */
+#define CR_RNGEN   (1u << 2)
+#define CR_IE      (1u << 3)
+#define CR_CONDRST (1u << 30)
+/* RNG_CR : NIST configuration (RNG_CONFIG1 0x0F, RNG_CONFIG3 0x0D) */
+#define CR_CONFIG  0x00F00D00
+#define HTCR_NIST  0x0000AAC7
+/* RNG_SR */
+#define SR_DRDY (1u << 0)
+#define SR_CEIS (1u << 5)
+#define SR_SEIS (1u << 6)
+
+void RNG_Handler(void);
+
+static void _restart(void);
+static int  _health(u32 w);
+
+rng_stats rng_stat;
+static u32  raw[RNG_BLOCK];
+static uint raw_len;
+static u32  rct_last;  // Last word (repetition count test)
+static uint rct_valid;
+static u32  apt_ref;   // Low byte of the first word of the window
+static uint apt_pos, apt_cnt;
+static rng_fct block_fct;
+
+/**
+ * @brief Initialize the RNG : kernel clock and configuration
+ *
+ * The RNG is configured but not started (see rng_start).
+ *
+ * @param fct Function called with each block of raw words (from interrupt)
+ */
+void rng_init(rng_fct fct)
+{
+	uint i;
+
+	rng_stat.blocks   = 0;
+	rng_stat.rct_fail = 0;
+	rng_stat.apt_fail = 0;
+	rng_stat.seed_err = 0;
+	rng_stat.clk_err  = 0;
+	block_fct = fct;
+
+	// Kernel clock is HSI48 (RNGSEL = 0)
+	reg_set(RCC_CR(RCC), RCC_CR_HSI48ON);
+	for (i = 0; ((reg_rd(RCC_CR(RCC)) & RCC_CR_HSI48RDY) == 0) && (i < 100000); i++)
+		;
+	reg_clr(RCC_CCIPR5(RCC), (3u << 4));
+	reg_set(RCC_AHB2ENR(RCC), (1 << 18));
+#ifdef HOST
+	sim_vector(IRQ_RNG, RNG_Handler);
+#endif
+	_restart();
+}
+
+/**
+ * @brief Start the generation of random words (in the background)
+ *
+ */
+void rng_start(void)
+{
+	reg_set(RNG_CR(RNG), CR_RNGEN | CR_IE);
+}
+
+/**
+ * @brief Stop the generation of random words
+ *
+ * Words already collected for the current block are kept, the health tests
+ * continue on the next words after rng_start().
+ */
+void rng_stop(void)
+{
+	reg_clr(RNG_CR(RNG), CR_RNGEN | CR_IE);
+}
+
+/**
+ * @brief Test if the RNG is running
+ *
+ * @return integer Non-zero if the RNG is enabled
+ */
+int rng_running(void)
+{
+	return (reg_rd(RNG_CR(RNG)) & CR_RNGEN) ? 1 : 0;
+}
+
+/**
+ * @brief Interrupt handler of the RNG
+ *
+ * Words are read while they are ready, until a block is complete. The
+ * block is then given to the conditioning function and erased.
+ */
+void RNG_Handler(void)
+{
+	u32  sr;
+	uint i;
+
+	sr = reg_rd(RNG_SR(RNG));
+	if (sr & (SR_CEIS | SR_SEIS))
+	{
+		if (sr & SR_CEIS)
+			rng_stat.clk_err++;
+		// Error flags are cleared by writing 0
+		reg_wr(RNG_SR(RNG), 0);
+		if (sr & SR_SEIS)
+		{
+			rng_stat.seed_err++;
+			_restart();
+			return;
+		}
+	}
+
+	while ((sr & SR_DRDY) && (raw_len < RNG_BLOCK))
+	{
+		raw[raw_len] = reg_rd(RNG_DR(RNG));
+		if (_health(raw[raw_len]) < 0)
+		{
+			_restart();
+			return;
+		}
+		raw_len++;
+		sr = reg_rd(RNG_SR(RNG));
+	}
+	if (raw_len < RNG_BLOCK)
+		return;
+
+	rng_stat.blocks++;
+	if (block_fct)
+		block_fct(raw, RNG_BLOCK);
+	for (i = 0; i < RNG_BLOCK; i++)
+		raw[i] = 0;
+	raw_len = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Reset the conditioning of the RNG and the health tests
+ *
+ * The words collected are discarded. The RNG keeps its state (running or
+ * stopped), a running RNG restarts its seeding.
+ */
+static void _restart(void)
+{
+	u32  run;
+	uint i;
+
+	run = reg_rd(RNG_CR(RNG)) & (CR_RNGEN | CR_IE);
+
+	// Configuration is written with CONDRST set, then released
+	reg_wr(RNG_CR(RNG), CR_CONFIG | CR_CONDRST);
+	reg_wr(RNG_HTCR(RNG), HTCR_NIST);
+	reg_wr(RNG_CR(RNG), CR_CONFIG);
+	for (i = 0; (reg_rd(RNG_CR(RNG)) & CR_CONDRST) && (i < 100000); i++)
+		;
+	if (run)
+		reg_set(RNG_CR(RNG), run);
+
+	for (i = 0; i < RNG_BLOCK; i++)
+		raw[i] = 0;
+	raw_len   = 0;
+	rct_valid = 0;
+	apt_pos   = 0;
+}
+
+/**
+ * @brief Continuous health tests of one raw word
+ *
+ * @param w Word read from the RNG
+ * @return integer Zero if the word is accepted, -1 on a test failure
+ */
+static int _health(u32 w)
+{
+	// Repetition count : cutoff of 2 for 32 bits words
+	if (rct_valid && (w == rct_last))
+	{
+		rng_stat.rct_fail++;
+		return(-1);
+	}
+	rct_last  = w;
+	rct_valid = 1;
+
+	// Adaptive proportion : on the low byte, over a window of words
+	if (apt_pos == 0)
+	{
+		apt_ref = w & 0xFF;
+		apt_cnt = 1;
+	}
+	else if ((w & 0xFF) == apt_ref)
+	{
+		apt_cnt++;
+		if (apt_cnt >= RNG_APT_CUTOFF)
+		{
+			rng_stat.apt_fail++;
+			return(-1);
+		}
+	}
+	apt_pos++;
+	if (apt_pos == RNG_APT_WINDOW)
+		apt_pos = 0;
+	return(0);
+}
+/* EOF */
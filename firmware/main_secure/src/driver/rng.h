@@ -0,0 +1,53 @@
+/**
+ * @file  rng.h
+ * @brief Headers and definitions for STM32H5 RNG driver (TRNG)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef RNG_H
+#define RNG_H
+#include "types.h"
+
+// RNG registers
+#define RNG_CR(x)   (x + 0x00)
+#define RNG_SR(x)   (x + 0x04)
+#define RNG_DR(x)   (x + 0x08)
+#define RNG_HTCR(x) (x + 0x10)
+
+// Raw words given to the conditioning function (one block)
+#define RNG_BLOCK 16
+// Window of the adaptive proportion test (words) and its cutoff
+#define RNG_APT_WINDOW 64
+#define RNG_APT_CUTOFF 8
+
+typedef void (*rng_fct)(const u32 *raw, uint count);
+
+/**
+ * @brief Counters of the RNG driver
+ */
+typedef struct rng_stats
+{
+	u32 blocks;   // Blocks of raw words delivered
+	u32 rct_fail; // Repetition count test failures (same word twice)
+	u32 apt_fail; // Adaptive proportion test failures
+	u32 seed_err; // Seed errors reported by the RNG (SEIS)
+	u32 clk_err;  // Clock errors reported by the RNG (CEIS)
+} rng_stats;
+
+extern rng_stats rng_stat;
+
+void rng_init (rng_fct fct);
+void rng_start(void);
+void rng_stop (void);
+int  rng_running(void);
+
+#endif
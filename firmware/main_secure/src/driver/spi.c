@@ -14,6 +14,7 @@
  * This program is distributed WITHOUT ANY WARRANTY.
  */
 #include "hardware.h"
+#include "regs.h"
 #include "types.h"
 #include "spi.h"
 
@@ -31,25 +32,76 @@ SPI6:
  */
 void spi_init(void)
 {
-	u32 v;
+	spi_cfg1_t cfg1;
+	spi_cfg2_t cfg2;
 
 	// Activate SPI4
-	reg_set(RCC_APB2ENR(RCC), (1 << 19));
+	rcc_apb2enr_modify(RCC, rcc_apb2enr_spi4en(rcc_apb2enr(), 1));
 
 	// Configure format
-	v  = (7 << 28); // Set master clock /256
-	v |= (7 << 16); // CRC size 8bits (must be set also with CRC disabled)
-	v |= (7 <<  0); // Data size 8 bits
-	reg_wr(SPI_CFG1(SPI4), v);
-	v  = (1 << 22); // Master mode
-	v |= (1 << 29); // SSOE : SS output enable
-	//v |= (1 << 30); // SSOM : SS output is managed in master mode
-	v |= (1 <<  0); // MSSI = 1 clock
-	reg_wr(SPI_CFG2(SPI4), v);
+	cfg1 = spi_cfg1_mbr(spi_cfg1(), 7); // Set master clock /256
+	cfg1 = spi_cfg1_crcsize(cfg1, 7);   // CRC size 8bits (must be set also with CRC disabled)
+	cfg1 = spi_cfg1_dsize(cfg1, 7);     // Data size 8 bits
+	spi_cfg1_wr(SPI4, cfg1);
+	cfg2 = spi_cfg2_master(spi_cfg2(), 1); // Master mode
+	cfg2 = spi_cfg2_ssoe(cfg2, 1);         // SSOE : SS output enable
+	//cfg2 = spi_cfg2_ssom(cfg2, 1);       // SSOM : SS output is managed in master mode
+	cfg2 = spi_cfg2_mssi(cfg2, 1);         // MSSI = 1 clock
+	spi_cfg2_wr(SPI4, cfg2);
 	// Set TSIZE to 0 (endless transaction)
-	reg_wr(SPI_CR2(SPI4), 0);
+	spi_cr2_wr(SPI4, spi_cr2_tsize(spi_cr2(), 0));
 
 	// Enable SPI (set SPE=1)
-	reg_set(SPI_CR1(SPI4), (1 << 0));
+	spi_cr1_modify(SPI4, spi_cr1_spe(spi_cr1(), 1));
+}
+
+/**
+ * @brief Make a full-duplex transfer of a block of bytes
+ *
+ * @param tx  Pointer to the bytes to send (or NULL to send 0xFF)
+ * @param rx  Pointer to a buffer for received bytes (or NULL to ignore)
+ * @param len Number of bytes to transfer (1 to 65535)
+ * @return 0 on success, -1 on error
+ */
+int spi_xfer(const u8 *tx, u8 *rx, uint len)
+{
+	uint tx_count = 0;
+	uint rx_count = 0;
+	spi_sr_t sr;
+	u8   c;
+
+	if ((len == 0) || (len > 0xFFFF))
+		return(-1);
+
+	// TSIZE can only be modified when SPI is disabled
+	spi_cr1_modify(SPI4, spi_cr1_spe(spi_cr1(), 0));
+	spi_cr2_wr(SPI4, spi_cr2_tsize(spi_cr2(), len));
+	spi_cr1_modify(SPI4, spi_cr1_spe(spi_cr1(), 1));
+	// Set CSTART to start transfer
+	spi_cr1_modify(SPI4, spi_cr1_cstart(spi_cr1(), 1));
+
+	while (rx_count < len)
+	{
+		sr = spi_sr_rd(SPI4);
+		// TXP : room available into TX fifo
+		if ((tx_count < len) && spi_sr_txp_get(sr))
+		{
+			reg8_wr(SPI_TXDR(SPI4), tx ? tx[tx_count] : 0xFF);
+			tx_count++;
+		}
+		// RXP : a byte has been received
+		if (spi_sr_rxp_get(sr))
+		{
+			c = reg8_rd(SPI_RXDR(SPI4));
+			if (rx)
+				rx[rx_count] = c;
+			rx_count++;
+		}
+	}
+	// Wait EOT then clear EOT and TXTF flags
+	while (spi_sr_eot_get(spi_sr_rd(SPI4)) == 0)
+		;
+	spi_ifcr_wr(SPI4, spi_ifcr_txtfc(spi_ifcr_eotc(spi_ifcr(), 1), 1));
+	return(0);
 }
 /* EOF */
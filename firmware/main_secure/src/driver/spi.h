@@ -15,6 +15,7 @@
  */
 #ifndef SPI_H
 #define SPI_H
+#include "types.h"
 
 // SPI registers
 #define SPI_CR1(x)     (x + 0x00)
@@ -33,5 +34,6 @@
 #define SPI_I2SCFGR(x) (x + 0x50)
 
 void spi_init(void);
+int  spi_xfer(const u8 *tx, u8 *rx, uint len);
 
 #endif
@@ -15,17 +15,37 @@
  */
 #include "driver/uart.h"
 #include "hardware.h"
+#include "irq.h"
+#include "power.h"
+#include "regs.h"
 #include "types.h"
 
+void USART3_Handler(void);
+
+/**
+ * @brief Initialize the console UART (USART3)
+ *
+ * The kernel clock is HSI (same frequency as APB1), it is requested by the
+ * USART in STOP mode : a byte is received without CPU and wakes the core.
+ */
 void uart_init(void)
 {
-	/* Activate USART3 */
-	reg_set(RCC_APB1LENR(RCC), (1 << 18));
+	usart_cr1_t cr1;
+
+	/* Activate USART3, kernel clock HSI (USART3SEL = 3) */
+	rcc_apb1lenr_modify(RCC, rcc_apb1lenr_usart3en(rcc_apb1lenr(), 1));
+	reg_wr(RCC_CCIPR1(RCC), (reg_rd(RCC_CCIPR1(RCC)) & ~(7u << 6)) | (3u << 6));
 
 	/* Configure UART3 */
-	reg_wr(USART_BRR(USART3),  278); // 115200 @ 32MHz
-	reg_wr(USART_CR1(USART3), 0x0C); // Set TE & RE
-	reg_wr(USART_CR1(USART3), 0x0D); // Set USART enable bit
+	usart_brr_wr(USART3, usart_brr_brr(usart_brr(), 278)); // 115200 @ 32MHz
+	reg_wr(USART_CR3(USART3), USART_CR3_WUS | USART_CR3_WUFIE);
+	cr1 = usart_cr1_re(usart_cr1_te(usart_cr1(), 1), 1);
+	usart_cr1_wr(USART3, cr1);                    // Set TE & RE
+	usart_cr1_wr(USART3, usart_cr1_ue(cr1, 1));   // Set USART enable bit
+	reg_set(USART_CR1(USART3), USART_CR1_UESM);   // Wakeup from STOP
+#ifdef HOST
+	sim_vector(IRQ_USART3, USART3_Handler);
+#endif
 }
 
 /**
@@ -38,7 +58,7 @@ int uart_getc(unsigned char *c)
 {
 	u32 rx;
 
-	if (reg_rd(USART_ISR(USART3)) & (1 << 5))
+	if (usart_isr_rxfne_get(usart_isr_rd(USART3)))
 	{
 		/* Get the received byte from RX fifo */
 		rx = reg_rd(USART_RDR(USART3));
@@ -58,11 +78,32 @@ int uart_getc(unsigned char *c)
  */
 void uart_putc(u8 c)
 {
-	while ((reg_rd(USART_ISR(USART3)) & (1 << 7)) == 0)
+	while (usart_isr_txfnf_get(usart_isr_rd(USART3)) == 0)
 		;
 	reg_wr(USART_TDR(USART3), c);
 }
 
+/**
+ * @brief Wait until all bytes have been sent (transmission complete)
+ *
+ */
+void uart_flush(void)
+{
+	while (usart_isr_tc_get(usart_isr_rd(USART3)) == 0)
+		;
+}
+
+/**
+ * @brief Interrupt handler of USART3 : wakeup from STOP mode
+ *
+ * The received byte is kept into the FIFO, for uart_getc().
+ */
+void USART3_Handler(void)
+{
+	power_mark(POWER_WAKE_CONSOLE);
+	reg_wr(USART_ICR(USART3), USART_ICR_WUCF);
+}
+
 /**
  * @brief Send a text string to UART
  *
@@ -31,9 +31,17 @@
 #define USART_TDR(x)   (x + 0x28)
 #define USART_PRESC(x) (x + 0x2C)
 
+/* Wakeup from STOP mode on reception (see power.c) */
+#define USART_CR1_UESM   (1u << 1)
+#define USART_CR3_WUS    (3u << 20) /* Wakeup on RXNE */
+#define USART_CR3_WUFIE  (1u << 22)
+#define USART_ISR_WUF    (1u << 20)
+#define USART_ICR_WUCF   (1u << 20)
+
 void uart_init(void);
 int  uart_getc(unsigned char *c);
 void uart_putc(u8 c);
+void uart_flush(void);
 void uart_puts(char *s);
 
 #endif
@@ -0,0 +1,238 @@
+/**
+ * @file  entropy.c
+ * @brief Entropy pool : random bytes pre-generated in the background
+ *
+ * Random numbers are needed on the critical path of a badge read (card
+ * challenges, session keys), they are served from a pool filled in the
+ * background. The TRNG (driver/rng.c) delivers blocks of health-tested raw
+ * words, each block is mixed into the key of a ChaCha20 generator which
+ * then adds one chunk to the pool. After each chunk the key is replaced by
+ * the next output of the generator (fast key erasure) : a copy of the
+ * state does not give the bytes already produced.
+ *
+ * The TRNG is stopped when the pool is full, and started again when the
+ * pool falls below ENTROPY_LOW. A request never waits for the TRNG : it is
+ * copied from the pool in a time that only depends on its length, or
+ * refused when the pool does not hold enough bytes.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/rng.h"
+#include "entropy.h"
+#include "irq.h"
+#include "power.h"
+
+#if (ENTROPY_POOL & (ENTROPY_POOL - 1)) || (ENTROPY_POOL % ENTROPY_CHUNK)
+#error "ENTROPY_POOL must be a power of two and a multiple of ENTROPY_CHUNK"
+#endif
+
+#define ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QR(a, b, c, d) \
+	a += b; d ^= a; d = ROTL(d, 16); \
+	c += d; b ^= c; b = ROTL(b, 12); \
+	a += b; d ^= a; d = ROTL(d, 8);  \
+	c += d; b ^= c; b = ROTL(b, 7)
+
+static void _chacha(const u32 *key, u32 counter, u32 nonce, u32 *out);
+static void _reseed(const u32 *raw, uint count);
+
+entropy_stats entropy_stat;
+static u32  pool[ENTROPY_POOL / 4];
+static vu32 pool_rd;  // Free-running byte counters
+static vu32 pool_wr;
+static vu32 refill;   // TRNG running, pool not full
+static u32  drbg_key[8];
+static u32  drbg_nonce;
+
+/**
+ * @brief Initialize the pool and start the TRNG to fill it
+ *
+ */
+void entropy_init(void)
+{
+	uint i;
+
+	entropy_stat.reseeds = 0;
+	entropy_stat.refills = 0;
+	entropy_stat.served  = 0;
+	entropy_stat.empty   = 0;
+	for (i = 0; i < 8; i++)
+		drbg_key[i] = 0;
+	drbg_nonce = 0;
+	pool_rd = 0;
+	pool_wr = 0;
+
+	rng_init(_reseed);
+	refill = 1;
+	entropy_stat.refills++;
+	// The TRNG kernel clock (HSI48) is stopped in STOP mode
+	power_hold(POWER_HOLD_RNG);
+	rng_start();
+}
+
+/**
+ * @brief Get random bytes from the pool
+ *
+ * The bytes are copied then erased from the pool, in a time that only
+ * depends on the length. This function does not wait : when the pool does
+ * not hold enough bytes (after a burst of requests, or just after boot)
+ * the request is refused and can be retried later.
+ *
+ * @param buf Pointer to the buffer that receives the bytes
+ * @param len Number of bytes (up to ENTROPY_GET_MAX)
+ * @return integer Zero on success, -1 if the pool does not hold enough bytes
+ */
+int entropy_get(u8 *buf, uint len)
+{
+	u8  *src = (u8 *)pool;
+	u32  prev, rd, level;
+	uint i, pos;
+	int  result = -1;
+
+	if (len > ENTROPY_GET_MAX)
+		return(-1);
+
+	prev  = irq_lock(IRQ_PRIO_READER);
+	rd    = pool_rd;
+	level = pool_wr - rd;
+	if (level >= len)
+	{
+		for (i = 0; i < len; i++)
+		{
+			pos = (rd + i) & (ENTROPY_POOL - 1);
+			buf[i]   = src[pos];
+			src[pos] = 0;
+		}
+		pool_rd = rd + len;
+		level  -= len;
+		entropy_stat.served += len;
+		result = 0;
+	}
+	else
+		entropy_stat.empty++;
+	// Start the TRNG into the section, the interrupt may be stopping it
+	if ((refill == 0) && (level < ENTROPY_LOW))
+	{
+		refill = 1;
+		entropy_stat.refills++;
+		power_hold(POWER_HOLD_RNG);
+		rng_start();
+	}
+	irq_unlock(prev);
+	return(result);
+}
+
+/**
+ * @brief Get the number of bytes available into the pool
+ *
+ * @return uint Number of bytes
+ */
+uint entropy_level(void)
+{
+	return (uint)(pool_wr - pool_rd);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Compute one ChaCha20 block (RFC 8439)
+ *
+ * @param key     Pointer to the key (8 words)
+ * @param counter Block counter
+ * @param nonce   First word of the nonce (the two others are zero)
+ * @param out     Pointer to the output (16 words)
+ */
+static void _chacha(const u32 *key, u32 counter, u32 nonce, u32 *out)
+{
+	u32  x[16];
+	uint i;
+
+	out[0] = 0x61707865;
+	out[1] = 0x3320646e;
+	out[2] = 0x79622d32;
+	out[3] = 0x6b206574;
+	for (i = 0; i < 8; i++)
+		out[4 + i] = key[i];
+	out[12] = counter;
+	out[13] = nonce;
+	out[14] = 0;
+	out[15] = 0;
+	for (i = 0; i < 16; i++)
+		x[i] = out[i];
+
+	for (i = 0; i < 10; i++)
+	{
+		QR(x[0], x[4], x[ 8], x[12]);
+		QR(x[1], x[5], x[ 9], x[13]);
+		QR(x[2], x[6], x[10], x[14]);
+		QR(x[3], x[7], x[11], x[15]);
+		QR(x[0], x[5], x[10], x[15]);
+		QR(x[1], x[6], x[11], x[12]);
+		QR(x[2], x[7], x[ 8], x[13]);
+		QR(x[3], x[4], x[ 9], x[14]);
+	}
+	for (i = 0; i < 16; i++)
+	{
+		out[i] += x[i];
+		x[i] = 0;
+	}
+}
+
+/**
+ * @brief Mix a block of raw words and add one chunk to the pool
+ *
+ * Called from the RNG interrupt. The chunk is written into the free part
+ * of the pool (not read by entropy_get), then published by moving the
+ * write counter.
+ *
+ * @param raw   Pointer to the raw words (health-tested)
+ * @param count Number of words (RNG_BLOCK)
+ */
+static void _reseed(const u32 *raw, uint count)
+{
+	u32  blk[16];
+	u32  prev, wr;
+	uint i;
+
+	for (i = 0; i < count; i++)
+		drbg_key[i % 8] ^= raw[i];
+	entropy_stat.reseeds++;
+
+	wr = pool_wr;
+	if ((ENTROPY_POOL - (wr - pool_rd)) >= ENTROPY_CHUNK)
+	{
+		_chacha(drbg_key, 0, drbg_nonce, blk);
+		for (i = 0; i < 16; i++)
+			pool[((wr & (ENTROPY_POOL - 1)) / 4) + i] = blk[i];
+		wr += ENTROPY_CHUNK;
+	}
+	// Fast key erasure : the next key is the next output of the generator
+	_chacha(drbg_key, 1, drbg_nonce, blk);
+	for (i = 0; i < 8; i++)
+		drbg_key[i] = blk[i];
+	for (i = 0; i < 16; i++)
+		blk[i] = 0;
+	drbg_nonce++;
+
+	prev = irq_lock(IRQ_PRIO_READER);
+	pool_wr = wr;
+	if ((wr - pool_rd) > (ENTROPY_POOL - ENTROPY_CHUNK))
+	{
+		refill = 0;
+		rng_stop();
+		power_release(POWER_HOLD_RNG);
+	}
+	irq_unlock(prev);
+}
+/* EOF */
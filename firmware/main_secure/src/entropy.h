@@ -0,0 +1,46 @@
+/**
+ * @file  entropy.h
+ * @brief Definitions and prototypes for the entropy pool (random numbers)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef ENTROPY_H
+#define ENTROPY_H
+#include "types.h"
+
+// Size of the pool in bytes (power of two, multiple of ENTROPY_CHUNK)
+#define ENTROPY_POOL  512
+// Bytes added to the pool for each block of raw words (one ChaCha20 block)
+#define ENTROPY_CHUNK 64
+// The TRNG is started when the pool falls below this level
+#define ENTROPY_LOW   256
+// Largest request served by entropy_get
+#define ENTROPY_GET_MAX 32
+
+/**
+ * @brief Counters of the entropy pool
+ */
+typedef struct entropy_stats
+{
+	u32 reseeds; // Blocks of raw words mixed into the generator
+	u32 refills; // Starts of the TRNG (pool below the low level)
+	u32 served;  // Bytes given to callers
+	u32 empty;   // Requests refused, not enough bytes into the pool
+} entropy_stats;
+
+extern entropy_stats entropy_stat;
+
+void entropy_init (void);
+int  entropy_get  (u8 *buf, uint len);
+uint entropy_level(void);
+
+#endif
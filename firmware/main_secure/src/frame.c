@@ -0,0 +1,358 @@
+/**
+ * @file  frame.c
+ * @brief Framing channel over the console UART
+ *
+ * Frames are byte-stuffed (SLIP) so they can be interleaved with log text
+ * on the same UART : everything that is not a valid frame (bad length or
+ * CRC) is silently dropped.
+ *
+ *   END | type | seq | len (16 bits LE) | payload | crc16 (LE) | END
+ *
+ * The CRC is a CRC-16/CCITT-FALSE computed over type to end of payload.
+ * Frames are dispatched to the handler registered for their class (high
+ * nibble of the type), replies use the same type with FRAME_REPLY set.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/hash.h"
+#include "driver/uart.h"
+#include "boot.h"
+#include "entropy.h"
+#include "frame.h"
+#include "journal.h"
+#include "systime.h"
+#include "types.h"
+
+#define SLIP_END     0xC0
+#define SLIP_ESC     0xDB
+#define SLIP_ESC_END 0xDC
+#define SLIP_ESC_ESC 0xDD
+
+#define FRAME_HDR 4
+#define FRAME_CRC 2
+
+// Set of the clock : u32 seconds, HMAC-SHA256 of "TIME" | challenge | seconds
+#define TIME_SET_LEN (4 + HASH_SHA256_LEN)
+
+static u16  _crc16(u16 crc, const u8 *data, uint len);
+static void _dispatch(void);
+static void _putc(u8 c);
+static void _sys_handler(u8 type, u8 seq, const u8 *data, uint len);
+static void _sys_time(u8 type, u8 seq, const u8 *data, uint len);
+
+static frame_handler handlers[8];
+static u8   rx_buf[FRAME_HDR + FRAME_MAX + FRAME_CRC];
+static uint rx_len;
+static int  rx_esc;
+static u32  challenge; // Of the next set of the clock (0 if not drawn)
+
+/**
+ * @brief Initialize the framing channel
+ *
+ */
+void frame_init(void)
+{
+	uint i;
+
+	for (i = 0; i < 8; i++)
+		handlers[i] = 0;
+	rx_len = 0;
+	rx_esc = 0;
+	challenge = 0;
+
+	frame_register(FRAME_CLASS_SYS, _sys_handler);
+}
+
+/**
+ * @brief Register the handler of a class of frames
+ *
+ * @param cls Class of frames (FRAME_CLASS_*)
+ * @param fct Function called for each received frame of this class
+ * @return 0 on success, -1 if the class is invalid
+ */
+int frame_register(u8 cls, frame_handler fct)
+{
+	if (cls & 0x8F)
+		return(-1);
+	handlers[cls >> 4] = fct;
+	return(0);
+}
+
+/**
+ * @brief Process all bytes received on the UART
+ *
+ */
+void frame_poll(void)
+{
+	u8 c;
+
+	while (uart_getc(&c))
+	{
+		if (c == SLIP_END)
+		{
+			if (rx_len >= (FRAME_HDR + FRAME_CRC))
+				_dispatch();
+			rx_len = 0;
+			rx_esc = 0;
+			continue;
+		}
+		if (c == SLIP_ESC)
+		{
+			rx_esc = 1;
+			continue;
+		}
+		if (rx_esc)
+		{
+			if (c == SLIP_ESC_END)
+				c = SLIP_END;
+			else if (c == SLIP_ESC_ESC)
+				c = SLIP_ESC;
+			rx_esc = 0;
+		}
+		// Drop oversized frames, wait for next END
+		if (rx_len < sizeof(rx_buf))
+			rx_buf[rx_len++] = c;
+	}
+}
+
+/**
+ * @brief Send a frame
+ *
+ * @param type Type of the frame
+ * @param seq  Sequence number
+ * @param data Pointer to the payload (may be null if len is 0)
+ * @param len  Length of the payload
+ */
+void frame_send(u8 type, u8 seq, const u8 *data, uint len)
+{
+	u8  hdr[FRAME_HDR];
+	u16 crc;
+	uint i;
+
+	hdr[0] = type;
+	hdr[1] = seq;
+	hdr[2] = (u8)(len & 0xFF);
+	hdr[3] = (u8)(len >> 8);
+	crc = _crc16(0xFFFF, hdr, FRAME_HDR);
+	crc = _crc16(crc, data, len);
+
+	uart_putc(SLIP_END);
+	for (i = 0; i < FRAME_HDR; i++)
+		_putc(hdr[i]);
+	for (i = 0; i < len; i++)
+		_putc(data[i]);
+	_putc((u8)(crc & 0xFF));
+	_putc((u8)(crc >> 8));
+	uart_putc(SLIP_END);
+}
+
+/**
+ * @brief Send a reply frame that only contains a status code
+ *
+ * @param type   Type of the request frame
+ * @param seq    Sequence number of the request frame
+ * @param status Status code (FRAME_ST_*)
+ */
+void frame_reply(u8 type, u8 seq, u8 status)
+{
+	frame_send((u8)(type | FRAME_REPLY), seq, &status, 1);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Check a complete received frame and call its handler
+ *
+ */
+static void _dispatch(void)
+{
+	frame_handler fct;
+	uint len;
+	u16  crc;
+
+	len = (uint)(rx_buf[2] | (rx_buf[3] << 8));
+	if ((len > FRAME_MAX) || (rx_len != (FRAME_HDR + len + FRAME_CRC)))
+		return;
+	crc = _crc16(0xFFFF, rx_buf, FRAME_HDR + len);
+	if ((rx_buf[rx_len - 2] != (crc & 0xFF)) ||
+	    (rx_buf[rx_len - 1] != (crc >> 8)))
+		return;
+	// Ignore replies (echo or other target on the line)
+	if (rx_buf[0] & FRAME_REPLY)
+		return;
+
+	fct = handlers[rx_buf[0] >> 4];
+	if (fct == 0)
+	{
+		frame_reply(rx_buf[0], rx_buf[1], FRAME_ST_UNKNOWN);
+		return;
+	}
+	fct(rx_buf[0], rx_buf[1], rx_buf + FRAME_HDR, len);
+}
+
+/**
+ * @brief Send one byte with SLIP escape
+ *
+ * @param c Byte to send
+ */
+static void _putc(u8 c)
+{
+	if (c == SLIP_END)
+	{
+		uart_putc(SLIP_ESC);
+		uart_putc(SLIP_ESC_END);
+	}
+	else if (c == SLIP_ESC)
+	{
+		uart_putc(SLIP_ESC);
+		uart_putc(SLIP_ESC_ESC);
+	}
+	else
+		uart_putc(c);
+}
+
+/**
+ * @brief Update a CRC-16/CCITT-FALSE
+ *
+ * @param crc  Current CRC value (0xFFFF for a new computation)
+ * @param data Pointer to the data
+ * @param len  Number of bytes
+ * @return u16 Updated CRC value
+ */
+static u16 _crc16(u16 crc, const u8 *data, uint len)
+{
+	int i;
+
+	while (len--)
+	{
+		crc ^= (u16)(*data++ << 8);
+		for (i = 0; i < 8; i++)
+		{
+			if (crc & 0x8000)
+				crc = (u16)((crc << 1) ^ 0x1021);
+			else
+				crc = (u16)(crc << 1);
+		}
+	}
+	return(crc);
+}
+
+/**
+ * @brief Handler of system frames (class 0)
+ *
+ * @param type Type of the received frame
+ * @param seq  Sequence number
+ * @param data Pointer to the payload
+ * @param len  Length of the payload
+ */
+static void _sys_handler(u8 type, u8 seq, const u8 *data, uint len)
+{
+	u8  buf[6];
+	u32 now;
+
+	switch (type)
+	{
+		/* Ping */
+		case 0x01:
+			frame_reply(type, seq, FRAME_ST_OK);
+			break;
+		/* Time : get, or authenticated set */
+		case 0x02:
+			_sys_time(type, seq, data, len);
+			break;
+		/* Journal : get head offset */
+		case 0x03:
+			// Records come from the doors only, nothing is forged
+			if (len)
+			{
+				frame_reply(type, seq, FRAME_ST_BADARG);
+				break;
+			}
+			now = journal_head();
+			buf[0] = FRAME_ST_OK;
+			buf[1] = (u8)(now >>  0);
+			buf[2] = (u8)(now >>  8);
+			buf[3] = (u8)(now >> 16);
+			buf[4] = (u8)(now >> 24);
+			frame_send((u8)(type | FRAME_REPLY), seq, buf, 5);
+			break;
+		default:
+			frame_reply(type, seq, FRAME_ST_UNKNOWN);
+			break;
+	}
+}
+/**
+ * @brief System frame 0x02 : read or set the wall-clock
+ *
+ * Without payload the time is read, the reply also gives the challenge of
+ * the next set. A set carries the time and its HMAC with the OBK key (see
+ * boot_mac), over "TIME", the challenge and the time (u32 LE). A new
+ * challenge is drawn after each set, accepted or not : a captured frame
+ * can not be replayed.
+ *
+ * Reply : u8 status, u32 wall-clock, u8 valid, u32 challenge
+ *
+ * @param type Type of the received frame
+ * @param seq  Sequence number
+ * @param data Pointer to the payload
+ * @param len  Length of the payload
+ */
+static void _sys_time(u8 type, u8 seq, const u8 *data, uint len)
+{
+	u8   buf[12];
+	u32  now;
+	uint i;
+	u8   status = FRAME_ST_OK;
+
+	if ((len != 0) && (len != TIME_SET_LEN))
+	{
+		frame_reply(type, seq, FRAME_ST_BADARG);
+		return;
+	}
+	if (len == TIME_SET_LEN)
+	{
+		buf[0] = 'T'; buf[1] = 'I'; buf[2] = 'M'; buf[3] = 'E';
+		buf[4] = (u8)(challenge >>  0);
+		buf[5] = (u8)(challenge >>  8);
+		buf[6] = (u8)(challenge >> 16);
+		buf[7] = (u8)(challenge >> 24);
+		for (i = 0; i < 4; i++)
+			buf[8 + i] = data[i];
+		if (challenge == 0)
+			status = FRAME_ST_STATE;
+		else if ( ! boot_mac(buf, 12, data + 4))
+			status = FRAME_ST_ERR;
+		else
+			systime_set((u32)data[0]         | ((u32)data[1] << 8) |
+			            ((u32)data[2] << 16) | ((u32)data[3] << 24));
+		challenge = 0;
+	}
+	// Draw the challenge of the next set (stays 0 if the pool is empty)
+	if (challenge == 0)
+		entropy_get((u8 *)&challenge, sizeof(challenge));
+
+	now = systime_wall();
+	buf[0] = status;
+	buf[1] = (u8)(now >>  0);
+	buf[2] = (u8)(now >>  8);
+	buf[3] = (u8)(now >> 16);
+	buf[4] = (u8)(now >> 24);
+	buf[5] = (u8)systime_valid();
+	buf[6] = (u8)(challenge >>  0);
+	buf[7] = (u8)(challenge >>  8);
+	buf[8] = (u8)(challenge >> 16);
+	buf[9] = (u8)(challenge >> 24);
+	frame_send((u8)(type | FRAME_REPLY), seq, buf, 10);
+}
+/* EOF */
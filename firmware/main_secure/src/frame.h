@@ -0,0 +1,46 @@
+/**
+ * @file  frame.h
+ * @brief Definitions and prototypes for the UART framing channel
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef FRAME_H
+#define FRAME_H
+#include "types.h"
+
+/* Maximum size of a frame payload */
+#define FRAME_MAX 1040
+
+/* Frame classes (high nibble of type) */
+#define FRAME_CLASS_SYS    0x00
+#define FRAME_CLASS_UPDATE 0x10
+#define FRAME_CLASS_CRED   0x20
+#define FRAME_CLASS_CONFIG 0x30
+/* Response flag, set by the target into type of reply frames */
+#define FRAME_REPLY 0x80
+
+/* Status codes (first byte of reply payload) */
+#define FRAME_ST_OK      0x00
+#define FRAME_ST_ERR     0x01
+#define FRAME_ST_BADARG  0x02
+#define FRAME_ST_STATE   0x03
+#define FRAME_ST_UNKNOWN 0x04
+
+typedef void (*frame_handler)(u8 type, u8 seq, const u8 *data, uint len);
+
+void frame_init(void);
+int  frame_register(u8 cls, frame_handler fct);
+void frame_poll(void);
+void frame_send(u8 type, u8 seq, const u8 *data, uint len);
+void frame_reply(u8 type, u8 seq, u8 status);
+
+#endif
@@ -14,8 +14,12 @@
  * This program is distributed WITHOUT ANY WARRANTY.
  */
 #include "hardware.h"
+#include "irq.h"
+#include "regs.h"
+#include "systime.h"
 
 static inline void _cfg_sec(void);
+static inline void _init_bkp(void);
 static inline void _init_led(void);
 static inline void _init_spi(void);
 static inline void _init_uart(void);
@@ -27,25 +31,103 @@ static inline void _init_uart(void);
  */
 void hw_init(void)
 {
-	int i;
+	rcc_ahb2enr_t en;
+	rcc_ahb2rstr_t rst;
 
 	_cfg_sec();
-
-	// Enable GPIO ports
-	reg_set(RCC_AHB2ENR(RCC), (1 << 1) | /* GPIO-B */
-	                          (1 << 3) | /* GPIO-D */
-	                          (1 << 4)); /* GPIO-E */
+	irq_init();
+	_init_bkp();
+	systime_init();
+
+	// Enable GPIO ports B, D and E
+	en = rcc_ahb2enr_gpioben(rcc_ahb2enr(), 1);
+	en = rcc_ahb2enr_gpioden(en, 1);
+	en = rcc_ahb2enr_gpioeen(en, 1);
+	rcc_ahb2enr_modify(RCC, en);
 	// RCC : Reset GPIOB and GPIOD
-	reg_wr(RCC_AHB2RST(RCC), (1 << 1) | (1 << 3));
-	for (i = 0; i < 16; i++)
-		asm volatile("nop");
-	reg_wr(RCC_AHB2RST(RCC), 0);
+	rst = rcc_ahb2rstr_gpiodrst(rcc_ahb2rstr_gpiobrst(rcc_ahb2rstr(), 1), 1);
+	rcc_ahb2rstr_wr(RCC, rst);
+	delay_us(1);
+	rcc_ahb2rstr_wr(RCC, rcc_ahb2rstr());
 
 	_init_led();
 	_init_uart();
 	_init_spi();	
 }
 
+/**
+ * @brief Request a system reset
+ *
+ */
+void hw_reset(void)
+{
+#ifdef HOST
+	sim_reset();
+#else
+	// SCB AIRCR : VECTKEY and SYSRESETREQ
+	asm volatile("dsb 0xF":::"memory");
+	reg_wr(0xE000ED0C, 0x05FA0004);
+	asm volatile("dsb 0xF":::"memory");
+	while(1)
+		;
+#endif
+}
+
+/**
+ * @brief Read a backup register (kept on reset, cleared on tamper)
+ *
+ * @param n Index of the register (0 to 31)
+ * @return u32 Value of the register
+ */
+u32 hw_bkp_read(uint n)
+{
+	return reg_rd(TAMP_BKPR(TAMP, n));
+}
+
+/**
+ * @brief Write a backup register
+ *
+ * @param n     Index of the register (0 to 31)
+ * @param value New value to write
+ */
+void hw_bkp_write(uint n, u32 value)
+{
+	reg_wr(TAMP_BKPR(TAMP, n), value);
+}
+
+/**
+ * @brief Configure some pins of a GPIO port to use an alternate function
+ *
+ * Pins are also set to the highest speed.
+ *
+ * @param port Base address of the GPIO port
+ * @param mask Mask of the pins to configure
+ * @param af   Alternate function number (0 to 15)
+ */
+void hw_gpio_af(u32 port, u32 mask, uint af)
+{
+	u32  afr[2], mode, speed;
+	uint pin;
+
+	afr[0] = reg_rd(GPIO_AFRL(port));
+	afr[1] = reg_rd(GPIO_AFRH(port));
+	mode   = reg_rd(GPIO_MODER(port));
+	speed  = reg_rd(GPIO_OSPEEDR(port));
+	for (pin = 0; pin < 16; pin++)
+	{
+		if ((mask & (1u << pin)) == 0)
+			continue;
+		afr[pin / 8] &= ~(0xFu << ((pin % 8) * 4));
+		afr[pin / 8] |= (u32)(af & 0xF) << ((pin % 8) * 4);
+		mode  = (mode & ~(3u << (pin * 2))) | (2u << (pin * 2));
+		speed |= (3u << (pin * 2));
+	}
+	reg_wr(GPIO_AFRL(port), afr[0]);
+	reg_wr(GPIO_AFRH(port), afr[1]);
+	reg_wr(GPIO_OSPEEDR(port), speed);
+	reg_wr(GPIO_MODER(port), mode);
+}
+
 /**
  * @brief Configure of the secure context (SAU and TZSC)
  *
@@ -62,7 +144,7 @@ static inline void _cfg_sec(void)
 	reg_wr(0xE000ED8C, 0xC00);
 
 	// Enable TZSC for peripheral protection
-	reg_set(RCC_AHB1ENR(RCC), (1 << 24));
+	rcc_ahb1enr_modify(RCC, rcc_ahb1enr_tzsc1en(rcc_ahb1enr(), 1));
 
 	for (i = 0; i < 31; i++)
 		reg_wr((u32)(GTZC1 + 0x1000 + 0x200+ (i*4)), (u32)0xFFFFFFFF);
@@ -74,22 +156,31 @@ static inline void _cfg_sec(void)
 #endif
 }
 
+/**
+ * @brief Allow access to backup domain (TAMP backup registers, backup SRAM)
+ *
+ */
+static inline void _init_bkp(void)
+{
+	// Enable RTC/TAMP APB clock
+	rcc_apb3enr_modify(RCC, rcc_apb3enr_rtcapben(rcc_apb3enr(), 1));
+	// Disable backup domain write protection (DBP)
+	reg_set(PWR_DBPCR(PWR), (1 << 0));
+	// Enable backup SRAM clock (BKPRAMEN), used for the crash record
+	reg_set(RCC_AHB1ENR(RCC), (1 << 28));
+}
+
 /**
  * @brief Initialize IOs of the LEDs
  *
  */
 static inline void _init_led(void)
 {
-	u32 v;
-
-	// Configure PB0 as output
-	v = reg_rd(GPIO_MODER(GPIOB));
-	v &= ~(u32)(3 << 0); // Clear curernt mode
-	v |=  (u32)(1 << 0); // Set general purpose output mode
-	reg_wr(GPIO_MODER(GPIOB), v);
+	// Configure PB0 as general purpose output
+	gpio_moder_modify(GPIOB, gpio_moder_mode0(gpio_moder(), 1));
 
 	// Set PB0 to '1'
-	reg_wr(GPIO_BSRR(GPIOB), 1);
+	gpio_set(GPIOB, (1 << 0));
 }
 
 /**
@@ -98,24 +189,21 @@ static inline void _init_led(void)
  */
 static inline void _init_spi(void)
 {
-	u32 v;
+	gpio_afrh_t  af;
+	gpio_moder_t mode;
 
 	/* Select appropriate alterna functions for PE/SPI4 */
-	v = reg_rd(GPIO_AFRH(GPIOE));
-	v &= ~(u32)(0xF << 12); // Clear current PE11 config
-	v &= ~(u32)(0xF << 16); // Clear current PE12 config
-	v &= ~(u32)(0xF << 20); // Clear current PE13 config
-	v &= ~(u32)(0xF << 24); // Clear current PE14 config
-	v |=  (u32)(  5 << 12); // PE11 use AF5 (SPI4_NSS)
-	v |=  (u32)(  5 << 16); // PE12 use AF5 (SPI4_SCK)
-	v |=  (u32)(  5 << 20); // PE13 use AF5 (SPI4_MISO)
-	v |=  (u32)(  5 << 24); // PE14 use AF5 (SPI4_MOSI)
-	reg_wr(GPIO_AFRH(GPIOE), v);
+	af = gpio_afrh_afsel11(gpio_afrh(), 5); // PE11 use AF5 (SPI4_NSS)
+	af = gpio_afrh_afsel12(af, 5);          // PE12 use AF5 (SPI4_SCK)
+	af = gpio_afrh_afsel13(af, 5);          // PE13 use AF5 (SPI4_MISO)
+	af = gpio_afrh_afsel14(af, 5);          // PE14 use AF5 (SPI4_MOSI)
+	gpio_afrh_modify(GPIOE, af);
 	/* Set ios mode to use alternate-function */
-	v = reg_rd(GPIO_MODER(GPIOE));
-	v &= ~(u32)( (3 << 22) | (3 << 24) | (3 << 26) | (3 << 28) );
-	v |=  (u32)( (2 << 22) | (2 << 24) | (2 << 26) | (2 << 28) );
-	reg_wr(GPIO_MODER(GPIOE), v);
+	mode = gpio_moder_mode11(gpio_moder(), 2);
+	mode = gpio_moder_mode12(mode, 2);
+	mode = gpio_moder_mode13(mode, 2);
+	mode = gpio_moder_mode14(mode, 2);
+	gpio_moder_modify(GPIOE, mode);
 }
 
 /**
@@ -124,20 +212,10 @@ static inline void _init_spi(void)
  */
 static inline void _init_uart(void)
 {
-	u32 v;
-
 	/* Configure PD8 (UART-TX) and PD9 (UART-RX) to use AF7 (USART3) */
-	v = reg_rd(GPIO_AFRH(GPIOD));
-	v &= ~(u32)(0xF << 0); // Clear current PD8 config
-	v |=  (u32)(  7 << 0); // PD8 use AF7
-	v &= ~(u32)(0xF << 4); // Clear current PD9 config
-	v |=  (u32)(  7 << 4); // PD9 use AF7
-	reg_wr(GPIO_AFRH(GPIOD), v);
+	gpio_afrh_modify(GPIOD, gpio_afrh_afsel9(gpio_afrh_afsel8(gpio_afrh(), 7), 7));
 
 	/* Configure PD8 and PD9 mode to use alternate function */
-	v = reg_rd(GPIO_MODER(GPIOD));
-	v &= ~(u32)( (3 << 16) | (3 << 18) );
-	v |=  (u32)( (2 << 16) | (2 << 18) );
-	reg_wr(GPIO_MODER(GPIOD), v);
+	gpio_moder_modify(GPIOD, gpio_moder_mode9(gpio_moder_mode8(gpio_moder(), 2), 2));
 }
 /* EOF */
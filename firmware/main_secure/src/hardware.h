@@ -34,54 +34,225 @@
 #define AHB4_S 0X56000000
 
 // Peripherals addresses (non-secure)
+#define ADC1_NS   (AHB2_NS + 0x8000)
+#define BKPSRAM_NS (AHB1_NS + 0x16400)
+#define GPDMA1_NS (AHB1_NS + 0x0000)
+#define FLASH_NS  (AHB1_NS + 0x2000)
+#define CRC_NS    (AHB1_NS + 0x3000)
+#define ETH_NS    (AHB1_NS + 0x8000)
+#define EXTI_NS   (AHB3_NS + 0x2000)
+#define FDCAN1_NS (APB1_NS + 0xA400)
 #define GTZC1_NS  (AHB1_NS + 0x12400)
 #define GPIOA_NS  (AHB2_NS + 0x0000)
 #define GPIOB_NS  (AHB2_NS + 0x0400)
 #define GPIOC_NS  (AHB2_NS + 0x0800)
 #define GPIOD_NS  (AHB2_NS + 0x0C00)
 #define GPIOE_NS  (AHB2_NS + 0x1000)
+#define GPIOG_NS  (AHB2_NS + 0x1800)
+#define HASH_NS   (AHB2_NS + 0xA0400)
+#define LPTIM1_NS (APB3_NS + 0x4400)
+#define RTC_NS    (APB3_NS + 0x7800)
+#define SBS_NS    (APB3_NS + 0x0400)
+#define TAMP_NS   (APB3_NS + 0x7C00)
+#define PWR_NS    (AHB3_NS + 0X0800)
 #define SPI4_NS   (APB2_NS + 0x4C00)
+#define SRAMCAN_NS (APB1_NS + 0xAC00)
 #define RCC_NS    (AHB3_NS + 0X0C00)
+#define RNG_NS    (AHB2_NS + 0xA0800)
+#define TIM2_NS   (APB1_NS + 0x0000)
+#define TIM3_NS   (APB1_NS + 0x0400)
+#define TIM4_NS   (APB1_NS + 0x0800)
 #define USART3_NS (APB1_NS + 0x4800)
 // Peripherals addresses (secure)
+#define ADC1_S   (AHB2_S + 0x8000)
+#define BKPSRAM_S (AHB1_S + 0x16400)
+#define GPDMA1_S (AHB1_S + 0x0000)
+#define FLASH_S  (AHB1_S + 0x2000)
+#define CRC_S    (AHB1_S + 0x3000)
+#define ETH_S    (AHB1_S + 0x8000)
+#define EXTI_S   (AHB3_S + 0x2000)
+#define FDCAN1_S (APB1_S + 0xA400)
 #define GTZC1_S  (AHB1_S + 0x12400)
 #define GPIOA_S  (AHB2_S + 0x0000)
 #define GPIOB_S  (AHB2_S + 0x0400)
 #define GPIOC_S  (AHB2_S + 0x0800)
 #define GPIOD_S  (AHB2_S + 0x0C00)
 #define GPIOE_S  (AHB2_S + 0x1000)
+#define GPIOG_S  (AHB2_S + 0x1800)
+#define HASH_S   (AHB2_S + 0xA0400)
+#define LPTIM1_S (APB3_S + 0x4400)
+#define RTC_S    (APB3_S + 0x7800)
+#define SBS_S    (APB3_S + 0x0400)
+#define TAMP_S   (APB3_S + 0x7C00)
+#define PWR_S    (AHB3_S + 0X0800)
 #define SPI4_S   (APB2_S + 0x4C00)
+#define SRAMCAN_S (APB1_S + 0xAC00)
 #define RCC_S    (AHB3_S + 0X0C00)
+#define RNG_S    (AHB2_S + 0xA0800)
+#define TIM2_S   (APB1_S + 0x0000)
+#define TIM3_S   (APB1_S + 0x0400)
+#define TIM4_S   (APB1_S + 0x0800)
 #define USART3_S (APB1_S + 0x4800)
 
 #ifdef RUN_SEC
+#define ADC1   ADC1_S
+#define BKPSRAM BKPSRAM_S
+#define CRC    CRC_S
+#define ETH    ETH_S
+#define EXTI   EXTI_S
+#define FDCAN1 FDCAN1_S
+#define FLASH  FLASH_S
+#define GPDMA1 GPDMA1_S
 #define GTZC1  GTZC1_S
 #define GPIOA  GPIOA_S
 #define GPIOB  GPIOB_S
 #define GPIOC  GPIOC_S
 #define GPIOD  GPIOD_S
 #define GPIOE  GPIOE_S
+#define GPIOG  GPIOG_S
+#define HASH   HASH_S
+#define LPTIM1 LPTIM1_S
+#define PWR    PWR_S
+#define TAMP   TAMP_S
 #define RCC    RCC_S
+#define RNG    RNG_S
+#define RTC    RTC_S
+#define SBS    SBS_S
 #define SPI4   SPI4_S
+#define SRAMCAN SRAMCAN_S
+#define TIM2   TIM2_S
+#define TIM3   TIM3_S
+#define TIM4   TIM4_S
 #define USART3 USART3_S
 #else
+#define ADC1   ADC1_NS
+#define BKPSRAM BKPSRAM_NS
+#define CRC    CRC_NS
+#define ETH    ETH_NS
+#define EXTI   EXTI_NS
+#define FDCAN1 FDCAN1_NS
+#define FLASH  FLASH_NS
+#define GPDMA1 GPDMA1_NS
 #define GTZC1  GTZC1_NS
 #define GPIOA  GPIOA_NS
 #define GPIOB  GPIOB_NS
 #define GPIOC  GPIOC_NS
 #define GPIOD  GPIOD_NS
 #define GPIOE  GPIOE_NS
+#define GPIOG  GPIOG_NS
+#define HASH   HASH_NS
+#define LPTIM1 LPTIM1_NS
+#define PWR    PWR_NS
+#define TAMP   TAMP_NS
 #define RCC    RCC_NS
+#define RNG    RNG_NS
+#define RTC    RTC_NS
+#define SBS    SBS_NS
 #define SPI4   SPI4_NS
+#define SRAMCAN SRAMCAN_NS
+#define TIM2   TIM2_NS
+#define TIM3   TIM3_NS
+#define TIM4   TIM4_NS
 #define USART3 USART3_NS
 #endif
 
 // RCC registers
+#define RCC_CR(x)       (x + 0x00)
+#define RCC_CFGR1(x)    (x + 0x1C)
+#define RCC_PLL2CFGR(x) (x + 0x2C)
+#define RCC_PLL2DIVR(x) (x + 0x3C)
 #define RCC_AHB1ENR(x)  (x + 0x88)
 #define RCC_AHB2ENR(x)  (x + 0x8C)
+#define RCC_AHB1RST(x)  (x + 0x60)
 #define RCC_AHB2RST(x)  (x + 0x64)
+#define RCC_APB1HRST(x) (x + 0x78)
 #define RCC_APB1LENR(x) (x + 0x9C)
+#define RCC_APB1HENR(x) (x + 0xA0)
 #define RCC_APB2ENR(x)  (x + 0xA4)
+#define RCC_APB3ENR(x)  (x + 0xA8)
+#define RCC_CCIPR1(x)   (x + 0xD8)
+#define RCC_CCIPR2(x)   (x + 0xDC)
+#define RCC_CCIPR5(x)   (x + 0xE8)
+#define RCC_BDCR(x)     (x + 0xF0)
+
+// PWR registers
+#define PWR_PMCR(x)  (x + 0x00)
+#define PWR_PMSR(x)  (x + 0x04)
+#define PWR_DBPCR(x) (x + 0x24)
+
+// EXTI registers (lines 0 to 31)
+#define EXTI_RTSR1(x)     (x + 0x00)
+#define EXTI_FTSR1(x)     (x + 0x04)
+#define EXTI_RPR1(x)      (x + 0x0C)
+#define EXTI_FPR1(x)      (x + 0x10)
+#define EXTI_SECCFGR1(x)  (x + 0x14)
+#define EXTI_EXTICR(x, n) (x + 0x60 + (4 * (n)))
+#define EXTI_IMR1(x)      (x + 0x80)
+
+// Low-power timer registers
+#define LPTIM_ISR(x)  (x + 0x00)
+#define LPTIM_CFGR(x) (x + 0x0C)
+#define LPTIM_CR(x)   (x + 0x10)
+#define LPTIM_ARR(x)  (x + 0x18)
+#define LPTIM_CNT(x)  (x + 0x1C)
+
+// GTZC1 block-based memory protection (MPCBB) of SRAM3, blocks of 512 bytes
+#define GTZC1_MPCBB3(x)     (x + 0x1000)
+#define MPCBB_SECCFGR(x, n) (x + 0x100 + (4 * (n)))
+
+// RTC registers
+#define RTC_TR(x)      (x + 0x00)
+#define RTC_DR(x)      (x + 0x04)
+#define RTC_SSR(x)     (x + 0x08)
+#define RTC_ICSR(x)    (x + 0x0C)
+#define RTC_PRER(x)    (x + 0x10)
+#define RTC_WUTR(x)    (x + 0x14)
+#define RTC_CR(x)      (x + 0x18)
+#define RTC_SECCFGR(x) (x + 0x20)
+#define RTC_WPR(x)     (x + 0x24)
+#define RTC_SR(x)      (x + 0x50)
+#define RTC_SCR(x)     (x + 0x5C)
+
+// SBS registers
+#define SBS_PMCR(x) (x + 0x100)
+
+// TAMP registers
+#define TAMP_BKPR(x, n) ((x) + 0x100 + (4 * (n)))
+
+// General purpose timer registers (TIM2 to TIM5)
+#define TIM_CR1(x)   (x + 0x00)
+#define TIM_DIER(x)  (x + 0x0C)
+#define TIM_SR(x)    (x + 0x10)
+#define TIM_EGR(x)   (x + 0x14)
+#define TIM_CCMR1(x) (x + 0x18)
+#define TIM_CCER(x)  (x + 0x20)
+#define TIM_CNT(x)   (x + 0x24)
+#define TIM_PSC(x)   (x + 0x28)
+#define TIM_ARR(x)   (x + 0x2C)
+#define TIM_CCR1(x)  (x + 0x34)
+
+// Cortex-M33 interrupt controller
+#define NVIC_ISER(n) (0xE000E100 + (4 * (n)))
+#define NVIC_ICER(n) (0xE000E180 + (4 * (n)))
+#define NVIC_ISPR(n) (0xE000E200 + (4 * (n)))
+#define NVIC_ICPR(n) (0xE000E280 + (4 * (n)))
+#define NVIC_ITNS(n) (0xE000E380 + (4 * (n)))
+#define NVIC_IPR(n)  (0xE000E400 + (n))
+#define SCB_AIRCR    0xE000ED0C
+#define SCB_SCR      0xE000ED10
+// Cortex-M33 fault status
+#define SCB_SHCSR    0xE000ED24
+#define SCB_CFSR     0xE000ED28
+#define SCB_HFSR     0xE000ED2C
+#define SCB_MMFAR    0xE000ED34
+#define SCB_BFAR     0xE000ED38
+#define SCB_SFSR     0xE000EDE4
+#define SCB_SFAR     0xE000EDE8
+
+// Cortex-M33 debug registers (cycle counter)
+#define SCB_DEMCR  0xE000EDFC
+#define DWT_CTRL   0xE0001000
+#define DWT_CYCCNT 0xE0001004
 
 // GPIO registers
 #define GPIO_MODER(x)   (x + 0x00)
@@ -98,13 +269,34 @@
 #define GPIO_HSLVR(x)   (x + 0x2C)
 #define GPIO_SECCFGR(x) (x + 0x30)
 
-void hw_init(void);
-
 #include "types.h"
 
+void hw_init(void);
+void hw_reset(void);
+u32  hw_bkp_read (uint n);
+void hw_bkp_write(uint n, u32 value);
+void hw_gpio_af(u32 port, u32 mask, uint af);
+
 /* -------------------------------------------------------------------------- */
 /*                        Low level register functions                        */
 /* -------------------------------------------------------------------------- */
+#ifdef HOST
+#include "host/sim.h"
+
+/* Host build : all accesses are routed to the simulated bus */
+static inline void reg_wr  (u32 addr, u32 value) { sim_wr(addr, value, 4); }
+static inline void reg16_wr(u32 addr, u16 value) { sim_wr(addr, value, 2); }
+static inline void reg8_wr (u32 addr, u8  value) { sim_wr(addr, value, 1); }
+static inline u32  reg_rd  (u32 addr) { return sim_rd(addr, 4); }
+static inline u16  reg16_rd(u32 addr) { return (u16)sim_rd(addr, 2); }
+static inline u8   reg8_rd (u32 addr) { return (u8)sim_rd(addr, 1); }
+static inline void reg_clr  (u32 addr, u32 value) { reg_wr(addr, reg_rd(addr) & ~value); }
+static inline void reg16_clr(u32 addr, u16 value) { reg16_wr(addr, (u16)(reg16_rd(addr) & ~value)); }
+static inline void reg8_clr (u32 addr, u8  value) { reg8_wr(addr, (u8)(reg8_rd(addr) & ~value)); }
+static inline void reg_set  (u32 addr, u32 value) { reg_wr(addr, reg_rd(addr) | value); }
+static inline void reg16_set(u32 addr, u16 value) { reg16_wr(addr, (u16)(reg16_rd(addr) | value)); }
+static inline void reg8_set (u32 addr, u8  value) { reg8_wr(addr, (u8)(reg8_rd(addr) | value)); }
+#else
 
 /**
  * @brief Write a 32 bits value to a memory mapped register
@@ -237,4 +429,58 @@ inline void reg8_set(u32 addr, u8 value)
 {
 	*(volatile u8 *)addr = ( *(volatile u8 *)addr | value );
 }
+#endif /* HOST */
+
+/**
+ * @brief Mask interrupts (PRIMASK) and return the previous state
+ *
+ * @return u32 Previous state, to be given to hw_irq_restore()
+ */
+static inline u32 hw_irq_save(void)
+{
+#ifdef HOST
+	return sim_irq_mask(1);
+#else
+	u32 primask;
+
+	asm volatile("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+	return(primask);
+#endif
+}
+
+/**
+ * @brief Restore interrupts state saved by hw_irq_save()
+ *
+ * @param primask Previous state
+ */
+static inline void hw_irq_restore(u32 primask)
+{
+#ifdef HOST
+	sim_irq_mask(primask);
+#else
+	asm volatile("msr primask, %0" :: "r" (primask) : "memory");
+#endif
+}
+
+/**
+ * @brief Set some output pins of a GPIO port (atomic, using BSRR)
+ *
+ * @param port Base address of the GPIO port
+ * @param mask Mask of the pins to set
+ */
+static inline void gpio_set(u32 port, u32 mask)
+{
+	reg_wr(GPIO_BSRR(port), mask & 0xFFFF);
+}
+
+/**
+ * @brief Clear some output pins of a GPIO port (atomic, using BRR)
+ *
+ * @param port Base address of the GPIO port
+ * @param mask Mask of the pins to clear
+ */
+static inline void gpio_clr(u32 port, u32 mask)
+{
+	reg_wr(GPIO_BRR(port), mask & 0xFFFF);
+}
 #endif
@@ -0,0 +1,286 @@
+/**
+ * @file  host/main.c
+ * @brief Entry point of the host build (firmware running on a simulated bus)
+ *
+ * The console UART is mapped to stdin/stdout, so the framing channel can be
+ * driven by the scripts (fw_update.py) through a pipe or a pty. The flash
+ * content is kept into the file named by SIM_FLASH and the OBK key can be
+ * loaded from the file named by SIM_KEY. On exit, the trace buffer is saved
+ * into the file named by SIM_TRACE (see trace.h) and the crash record into
+ * the file named by SIM_CRASH (see crash.h). The test events of the file
+ * named by SIM_EVENTS are appended to the journal (see doc/uplink.md).
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hardware.h"
+#include "apb.h"
+#include "boot.h"
+#include "config.h"
+#include "crash.h"
+#include "cred.h"
+#include "driver/eth.h"
+#include "driver/fdcan.h"
+#include "driver/spi.h"
+#include "driver/uart.h"
+#include "entropy.h"
+#include "frame.h"
+#include "journal.h"
+#include "irq.h"
+#include "log.h"
+#include "loop.h"
+#include "monitor.h"
+#include "pipeline.h"
+#include "pool.h"
+#include "power.h"
+#include "ratelim.h"
+#include "sched.h"
+#include "seq.h"
+#include "trace.h"
+#include "update.h"
+#include "uplink.h"
+#include "host/test.h"
+
+/**
+ * @brief Test mode of the host build ("--<name>-test")
+ */
+typedef struct host_test
+{
+	const char *name;
+	int (*fct)(void); // Returns the number of failed checks
+} host_test;
+
+static void _feed_events(void);
+static void _load_key(void);
+static void _save(const char *env, const void *data, uint len);
+
+static const host_test tests[] =
+{
+	{ "crash",   test_crash   },
+	{ "config",  test_config  },
+	{ "time",    test_time    },
+	{ "pool",    test_pool    },
+	{ "seq",     test_seq     },
+	{ "eth",     test_eth     },
+	{ "fdcan",   test_fdcan   },
+	{ "monitor", test_monitor },
+	{ "entropy", test_entropy },
+	{ "cred",    test_cred    },
+	{ "ratelim", test_ratelim },
+	{ "irq",     test_irq     },
+};
+
+u32 test_init; // Time of the modules init (ns)
+
+/**
+ * @brief Entry point of the host build
+ *
+ * With "--irq-report", only the interrupt latency report is printed. With
+ * "--pipe-sim [doors] [seconds]", only the door pipeline is simulated. The
+ * "--<name>-test" options run the checks of one module, from the table of
+ * the test modes (see doc/host_build.md).
+ *
+ * @param argc Number of command line arguments
+ * @param argv Array of arguments
+ */
+int main(int argc, char **argv)
+{
+	char opt[32];
+	int  result;
+	uint i;
+
+	sim_init();
+	_load_key();
+
+	// A simulated reset (hw_reset) restarts here
+	setjmp(sim_boot);
+
+	hw_init();
+	trace_init();
+	uart_init();
+	spi_init();
+	log_init();
+	crash_init();
+	if ((argc > 1) && (strcmp(argv[1], "--irq-report") == 0))
+	{
+		irq_report();
+		return(0);
+	}
+	test_init = trace_time();
+	loop_init();
+	pool_init();
+	journal_init();
+	seq_init();
+	eth_init();
+	uplink_init();
+	fdcan_init(0);
+	frame_init();
+	update_init();
+	monitor_init();
+	entropy_init();
+	apb_init();
+	cred_init();
+	config_init();
+	ratelim_init();
+	pipe_init();
+	sched_init(SCHED_ADDR);
+	power_init();
+	test_init = trace_time() - test_init;
+
+	for (i = 0; (argc > 1) && (i < (sizeof(tests) / sizeof(tests[0]))); i++)
+	{
+		snprintf(opt, sizeof(opt), "--%s-test", tests[i].name);
+		if (strcmp(argv[1], opt) != 0)
+			continue;
+		result = tests[i].fct();
+		_save("SIM_CRASH", CRASH_REC, sizeof(crash_rec));
+		return(result ? 1 : 0);
+	}
+	if ((argc > 1) && (strcmp(argv[1], "--pipe-sim") == 0))
+	{
+		result = pipe_sim((argc > 2) ? (uint)atoi(argv[2]) : PIPE_DOORS,
+		                  (argc > 3) ? (uint)atoi(argv[3]) : 8);
+		if (result < 0)
+			fprintf(stderr, "sim: bad pipeline simulation arguments\n");
+		return(result ? 1 : 0);
+	}
+
+	log_print(0, "\n%{--=={ CowKeyr-AC (host) }==--%}\n", LOG_BBLU);
+	update_boot();
+
+	result = boot_verify(BOOT_APP_BASE);
+	if (result < 0)
+	{
+		log_print(0, " -> %{ERROR%}: Application verification failed (%d)\n", 1, result);
+		if (update_pending())
+			update_rollback();
+	}
+	else
+	{
+		update_confirm();
+		log_print(0, " * Application verified%s\n", (result == BOOT_OK_CACHED) ? " (warm boot)" : "");
+	}
+
+	while (( ! sim_uart_eof()) || sim_adc_busy())
+	{
+		_feed_events();
+		loop_poll();
+		power_idle();
+	}
+
+	power_dump();
+	fprintf(stderr, "sim: %lu reads, %lu writes\n", sim_stat.rd, sim_stat.wr);
+	_save("SIM_TRACE", &trace_ram, sizeof(trace_ram));
+	_save("SIM_CRASH", CRASH_REC, sizeof(crash_rec));
+	return(0);
+}
+
+/**
+ * @brief Append the test events of SIM_EVENTS to the journal
+ *
+ * The file holds records of 8 bytes (door u8, type u8, credential u32 LE,
+ * detail u16 LE). They are appended as the doors would do, up to 128 per
+ * pass of the main loop and while less than 512 records (half of the
+ * journal) wait for the acknowledgement of the collector.
+ */
+static void _feed_events(void)
+{
+	static FILE *f = 0;
+	static int   done = 0;
+	const char  *name;
+	u8   rec[8];
+	uint n;
+
+	if (done)
+		return;
+	if (f == 0)
+	{
+		done = 1;
+		name = getenv("SIM_EVENTS");
+		if (name == 0)
+			return;
+		f = fopen(name, "rb");
+		if (f == 0)
+		{
+			fprintf(stderr, "sim: can not open events file %s\n", name);
+			return;
+		}
+		done = 0;
+	}
+	for (n = 0; (n < 128) && ((journal_head() - uplink_acked()) < 512); n++)
+	{
+		if (fread(rec, 1, sizeof(rec), f) != sizeof(rec))
+		{
+			fclose(f);
+			done = 1;
+			break;
+		}
+		journal_append(rec[0], rec[1],
+		               (u32)rec[2]         | ((u32)rec[3] << 8) |
+		               ((u32)rec[4] << 16) | ((u32)rec[5] << 24),
+		               (uint)rec[6] | ((uint)rec[7] << 8));
+	}
+}
+
+/**
+ * @brief Load the OBK key from file (if SIM_KEY is set)
+ *
+ */
+static void _load_key(void)
+{
+	const char *name = getenv("SIM_KEY");
+	u8    key[BOOT_KEY_LEN];
+	FILE *f;
+
+	if (name == 0)
+		return;
+	f = fopen(name, "rb");
+	if (f == 0)
+	{
+		fprintf(stderr, "sim: can not open key file %s\n", name);
+		return;
+	}
+	if (fread(key, 1, sizeof(key), f) == sizeof(key))
+		sim_load(BOOT_KEY_ADDR, key, sizeof(key));
+	fclose(f);
+}
+
+/**
+ * @brief Save a buffer into a file (if the environment variable is set)
+ *
+ * The trace buffer (SIM_TRACE) has the same layout as a dump of the target
+ * (trace.gdb), it can be converted with trace2json.py. The crash record
+ * (SIM_CRASH) is decoded by crash_decode.py.
+ *
+ * @param env  Name of the variable that holds the file name
+ * @param data Pointer to the buffer
+ * @param len  Length of the buffer (bytes)
+ */
+static void _save(const char *env, const void *data, uint len)
+{
+	const char *name = getenv(env);
+	FILE *f;
+
+	if (name == 0)
+		return;
+	f = fopen(name, "wb");
+	if (f == 0)
+	{
+		fprintf(stderr, "sim: can not create file %s\n", name);
+		return;
+	}
+	fwrite(data, 1, len, f);
+	fclose(f);
+}
+/* EOF */
@@ -0,0 +1,534 @@
+/**
+ * @file  host/sim.c
+ * @brief Simulated MMIO bus used by the host build
+ *
+ * All register accessors of hardware.h are routed here when the firmware
+ * is compiled for the host (HOST defined). An access is dispatched to the
+ * peripheral model that covers the address, or to a sparse memory when no
+ * model is attached (registers then simply keep the last written value).
+ *
+ * Secure aliases are folded to the non-secure ones, so a model only needs
+ * to be attached once.
+ *
+ * Buffers given to bus masters (DMA descriptors, frames) are in the host
+ * memory : sim_addr() maps them into a window of the bus, so models access
+ * them with sim_rd/sim_wr, without copy.
+ *
+ * Interrupts are delivered synchronously : a model calls sim_irq() and the
+ * handler registered with sim_vector() runs immediately if the line is
+ * enabled in the NVIC (ISER/ICER) and its priority (IPR) is higher than the
+ * current execution priority (active handler, BASEPRI, PRIMASK). Otherwise
+ * it stays pending until it is.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host/sim.h"
+
+#define PAGE_SIZE  4096
+#define PAGE_COUNT 1024
+#define IRQ_COUNT  160
+// Bus range used to map host memory (see sim_addr)
+#define WINDOW_BASE  0x2C000000
+#define WINDOW_COUNT 64
+
+typedef struct sim_page
+{
+	u32 base;
+	u8  data[PAGE_SIZE];
+} sim_page;
+
+typedef struct sim_window
+{
+	u32 base;
+	u32 size;
+	u8 *host;
+} sim_window;
+
+static u32  _fold(u32 addr);
+static u8  *_mem(u32 addr);
+static void _irq_run(void);
+static u32  _nvic_rd(sim_periph *p, u32 offset, uint size);
+static void _nvic_wr(sim_periph *p, u32 offset, u32 value, uint size);
+
+sim_stats sim_stat;
+jmp_buf   sim_boot;
+
+static sim_periph *periphs;
+static sim_periph *last;
+static sim_page   *pages[PAGE_COUNT];
+static uint        page_count;
+static sim_window  windows[WINDOW_COUNT];
+static uint        window_count;
+static u32         window_next = WINDOW_BASE;
+
+static void (*vectors[IRQ_COUNT])(void);
+static u32  irq_enabled[IRQ_COUNT / 32];
+static u32  irq_pending[IRQ_COUNT / 32];
+static u32  irq_target[IRQ_COUNT / 32];
+static u8   irq_prio[IRQ_COUNT];
+static u32  irq_masked;
+static u32  irq_basepri;
+static u32  irq_active = 0x100;
+
+static sim_periph nvic_model =
+{
+	.name = "NVIC",
+	.base = 0xE000E100,
+	.size = 0x400,
+	.rd   = _nvic_rd,
+	.wr   = _nvic_wr,
+};
+
+/**
+ * @brief Initialize the bus and attach all peripheral models
+ *
+ */
+void sim_init(void)
+{
+	periphs = 0;
+	last    = 0;
+	memset(&sim_stat, 0, sizeof(sim_stat));
+
+	sim_attach(&nvic_model);
+	sim_rcc_init();
+	sim_gpio_init();
+	sim_uart_init();
+	sim_spi_init();
+	sim_flash_init();
+	sim_dma_init();
+	sim_adc_init();
+	sim_eth_init();
+	sim_fdcan_init();
+	sim_crypto_init();
+	sim_rng_init();
+	sim_rtc_init();
+	sim_tim_init();
+}
+
+/**
+ * @brief Attach a peripheral model to the bus
+ *
+ * @param p Pointer to the model descriptor (must stay allocated)
+ */
+void sim_attach(sim_periph *p)
+{
+	p->next = periphs;
+	periphs = p;
+}
+
+/**
+ * @brief Read a value from the bus
+ *
+ * @param addr Address to read
+ * @param size Size of the access (1, 2 or 4 bytes)
+ * @return u32 Value read
+ */
+u32 sim_rd(u32 addr, uint size)
+{
+	sim_periph *p;
+	u8  *m;
+	u32  v = 0;
+	uint i;
+
+	sim_stat.rd++;
+	addr = _fold(addr);
+
+	if (last && (addr >= last->base) && (addr < (last->base + last->size)))
+		return last->rd(last, addr - last->base, size);
+	for (p = periphs; p; p = p->next)
+	{
+		if ((addr < p->base) || (addr >= (p->base + p->size)))
+			continue;
+		last = p;
+		return p->rd(p, addr - p->base, size);
+	}
+
+	m = _mem(addr);
+	for (i = 0; i < size; i++)
+		v |= (u32)m[i] << (8 * i);
+	return(v);
+}
+
+/**
+ * @brief Write a value to the bus
+ *
+ * @param addr  Address to write
+ * @param value Value to write
+ * @param size  Size of the access (1, 2 or 4 bytes)
+ */
+void sim_wr(u32 addr, u32 value, uint size)
+{
+	sim_periph *p;
+	u8  *m;
+	uint i;
+
+	sim_stat.wr++;
+	addr = _fold(addr);
+
+	if (last && (addr >= last->base) && (addr < (last->base + last->size)))
+	{
+		last->wr(last, addr - last->base, value, size);
+		return;
+	}
+	for (p = periphs; p; p = p->next)
+	{
+		if ((addr < p->base) || (addr >= (p->base + p->size)))
+			continue;
+		last = p;
+		p->wr(p, addr - p->base, value, size);
+		return;
+	}
+
+	m = _mem(addr);
+	for (i = 0; i < size; i++)
+		m[i] = (u8)(value >> (8 * i));
+}
+
+/**
+ * @brief Load a buffer into memory without going through models
+ *
+ * This is used by host tools to preload content like OBK keys.
+ *
+ * @param addr Destination address
+ * @param data Pointer to the data to load
+ * @param len  Number of bytes
+ */
+void sim_load(u32 addr, const void *data, uint len)
+{
+	const u8 *src = (const u8 *)data;
+
+	addr = _fold(addr);
+	while (len--)
+		*_mem(addr++) = *src++;
+}
+
+/**
+ * @brief Copy data from the memory (sparse memory or mapped buffers)
+ *
+ * This is used by the models of bus masters (DMA), these accesses are not
+ * counted into the bus statistics.
+ *
+ * @param addr Source address
+ * @param data Pointer to the destination buffer
+ * @param len  Number of bytes
+ */
+void sim_read(u32 addr, void *data, uint len)
+{
+	u8 *dst = (u8 *)data;
+
+	addr = _fold(addr);
+	while (len--)
+		*dst++ = *_mem(addr++);
+}
+
+/**
+ * @brief Get the bus address of host memory (buffer given to a bus master)
+ *
+ * A window of the bus is mapped onto the host pages of the buffer on first
+ * use, and kept up to the end of the program. Whole 4 KB pages are mapped :
+ * the alignment of the buffer is kept, and buffers of variable length (or
+ * neighbours) reuse the same window.
+ *
+ * @param ptr Pointer to the buffer
+ * @param len Size of the buffer (bytes)
+ * @return u32 Bus address of the buffer
+ */
+u32 sim_addr(const void *ptr, uint len)
+{
+	const u8 *p = (const u8 *)ptr;
+	sim_window *w;
+	uint i;
+
+	for (i = 0; i < window_count; i++)
+	{
+		w = &windows[i];
+		if ((p >= w->host) && ((p + len) <= (w->host + w->size)))
+			return(w->base + (u32)(p - w->host));
+	}
+	if (window_count == WINDOW_COUNT)
+	{
+		fprintf(stderr, "sim: no more windows to map host memory\n");
+		exit(1);
+	}
+	w = &windows[window_count++];
+	w->host = (u8 *)((uintptr_t)p & ~(uintptr_t)(PAGE_SIZE - 1));
+	w->size = (u32)(((uintptr_t)(p + len) + PAGE_SIZE - 1) & ~(uintptr_t)(PAGE_SIZE - 1)) -
+	          (u32)(uintptr_t)w->host;
+	w->base = window_next;
+	window_next += w->size + PAGE_SIZE;
+	return(w->base + (u32)(p - w->host));
+}
+
+/**
+ * @brief Register the handler of an interrupt (vector table)
+ *
+ * @param irq     Interrupt number
+ * @param handler Function called when the interrupt is raised
+ */
+void sim_vector(uint irq, void (*handler)(void))
+{
+	if (irq < IRQ_COUNT)
+		vectors[irq] = handler;
+}
+
+/**
+ * @brief Raise an interrupt
+ *
+ * @param irq Interrupt number
+ */
+void sim_irq(uint irq)
+{
+	if (irq >= IRQ_COUNT)
+		return;
+	irq_pending[irq / 32] |= (1u << (irq % 32));
+	_irq_run();
+}
+
+/**
+ * @brief Mask or unmask interrupts (PRIMASK)
+ *
+ * @param mask New state, non-zero to mask interrupts
+ * @return u32 Previous state
+ */
+u32 sim_irq_mask(u32 mask)
+{
+	u32 prev = irq_masked;
+
+	irq_masked = mask;
+	if ( ! mask)
+		_irq_run();
+	return(prev);
+}
+
+/**
+ * @brief Set the base priority mask (BASEPRI)
+ *
+ * @param basepri New value, 0 to disable masking
+ * @param max     If non-zero, the mask is only raised (BASEPRI_MAX)
+ * @return u32 Previous value
+ */
+u32 sim_irq_basepri(u32 basepri, int max)
+{
+	u32 prev = irq_basepri;
+
+	basepri &= 0xFF;
+	if (max && ((basepri == 0) || ((prev != 0) && (prev <= basepri))))
+		return(prev);
+	irq_basepri = basepri;
+	_irq_run();
+	return(prev);
+}
+
+/**
+ * @brief Simulate a system reset
+ *
+ * All models are reset (pending option bytes are applied) then the host
+ * main restarts from its boot point. Sparse memory (SRAM, backup
+ * registers) is kept, like a warm reset.
+ */
+void sim_reset(void)
+{
+	sim_periph *p;
+
+	for (p = periphs; p; p = p->next)
+		if (p->reset)
+			p->reset(p);
+	last = 0;
+	memset(vectors,     0, sizeof(vectors));
+	memset(irq_enabled, 0, sizeof(irq_enabled));
+	memset(irq_pending, 0, sizeof(irq_pending));
+	memset(irq_target,  0, sizeof(irq_target));
+	memset(irq_prio,    0, sizeof(irq_prio));
+	irq_masked  = 0;
+	irq_basepri = 0;
+	irq_active  = 0x100;
+	longjmp(sim_boot, 1);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Convert a secure alias address to the non-secure one
+ *
+ * @param addr Address to convert
+ * @return u32 Non-secure address
+ */
+static u32 _fold(u32 addr)
+{
+	// Flash : 0x0C000000 -> 0x08000000
+	if ((addr >= 0x0C000000) && (addr < 0x0C200000))
+		return (addr - 0x04000000);
+	// SRAM and peripherals : 0x3xxxxxxx -> 0x2xxxxxxx, 0x5x -> 0x4x
+	if ((addr >= 0x20000000) && (addr < 0x60000000))
+		return (addr & ~(u32)0x10000000);
+	return(addr);
+}
+
+/**
+ * @brief Get a pointer to the sparse memory for an address
+ *
+ * @param addr Address to access
+ * @return Pointer to the byte
+ */
+static u8 *_mem(u32 addr)
+{
+	static sim_page *hit;
+	sim_page *page;
+	u32 base = (addr & ~(u32)(PAGE_SIZE - 1));
+	uint i;
+
+	if ((addr >= WINDOW_BASE) && (addr < window_next))
+	{
+		for (i = 0; i < window_count; i++)
+			if ((addr >= windows[i].base) && (addr < (windows[i].base + windows[i].size)))
+				return &windows[i].host[addr - windows[i].base];
+	}
+	if (hit && (hit->base == base))
+		return &hit->data[addr - base];
+	for (i = 0; i < page_count; i++)
+	{
+		if (pages[i]->base != base)
+			continue;
+		hit = pages[i];
+		return &hit->data[addr - base];
+	}
+
+	if (page_count == PAGE_COUNT)
+	{
+		fprintf(stderr, "sim: out of memory pages (access %08X)\n", addr);
+		exit(1);
+	}
+	page = (sim_page *)calloc(1, sizeof(sim_page));
+	if (page == 0)
+		exit(1);
+	page->base = base;
+	pages[page_count++] = page;
+	hit = page;
+	return &page->data[addr - base];
+}
+
+/**
+ * @brief Call the handlers of pending and enabled interrupts
+ *
+ * The most urgent pending interrupt is called while its priority is higher
+ * than the execution priority. A handler is preempted when it raises a
+ * more urgent interrupt, like on the target.
+ */
+static void _irq_run(void)
+{
+	u32  prev, level, best, ready;
+	uint i, n, irq;
+
+	while ( ! irq_masked)
+	{
+		level = irq_active;
+		if (irq_basepri && (irq_basepri < level))
+			level = irq_basepri;
+
+		best = 0x100;
+		irq  = IRQ_COUNT;
+		for (i = 0; i < (IRQ_COUNT / 32); i++)
+		{
+			ready = irq_pending[i] & irq_enabled[i];
+			while (ready)
+			{
+				n = (uint)__builtin_ctz(ready);
+				ready &= ~(1u << n);
+				if (irq_prio[(i * 32) + n] < best)
+				{
+					best = irq_prio[(i * 32) + n];
+					irq  = (i * 32) + n;
+				}
+			}
+		}
+		if ((irq == IRQ_COUNT) || (best >= level))
+			return;
+
+		irq_pending[irq / 32] &= ~(1u << (irq % 32));
+		prev = irq_active;
+		irq_active = best;
+		if (vectors[irq])
+			vectors[irq]();
+		irq_active = prev;
+	}
+}
+
+/**
+ * @brief Read a register of the NVIC
+ *
+ * ISER and ICER give the enabled lines, ISPR and ICPR the pending ones.
+ */
+static u32 _nvic_rd(sim_periph *p, u32 offset, uint size)
+{
+	uint n = (offset & 0x7F) >> 2;
+	u32  v = 0;
+	uint i;
+	(void)p;
+
+	// IPR : one byte per interrupt
+	if (offset >= 0x300)
+	{
+		for (i = 0; i < size; i++)
+			if ((offset - 0x300 + i) < IRQ_COUNT)
+				v |= (u32)irq_prio[offset - 0x300 + i] << (8 * i);
+		return(v);
+	}
+	if (n >= (IRQ_COUNT / 32))
+		return(0);
+	switch (offset >> 7)
+	{
+		case 0: case 1: return(irq_enabled[n]);
+		case 2: case 3: return(irq_pending[n]);
+		case 5:         return(irq_target[n]);
+	}
+	return(0);
+}
+
+/**
+ * @brief Write a register of the NVIC
+ *
+ * ISER/ICER set and clear enabled lines, ISPR/ICPR pending ones, ITNS
+ * selects the target security state and IPR the priorities.
+ */
+static void _nvic_wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	uint n = (offset & 0x7F) >> 2;
+	uint i;
+	(void)p;
+
+	if (offset >= 0x300)
+	{
+		for (i = 0; i < size; i++)
+			if ((offset - 0x300 + i) < IRQ_COUNT)
+				irq_prio[offset - 0x300 + i] = (u8)(value >> (8 * i));
+		_irq_run();
+		return;
+	}
+	if (n >= (IRQ_COUNT / 32))
+		return;
+	switch (offset >> 7)
+	{
+		case 0: irq_enabled[n] |=  value; break;
+		case 1: irq_enabled[n] &= ~value; break;
+		case 2: irq_pending[n] |=  value; break;
+		case 3: irq_pending[n] &= ~value; break;
+		case 5: irq_target[n]   =  value; break;
+	}
+	_irq_run();
+}
+/* EOF */
@@ -0,0 +1,96 @@
+/**
+ * @file  host/sim.h
+ * @brief Definitions for the simulated MMIO bus of the host build
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef SIM_H
+#define SIM_H
+#include <setjmp.h>
+#include "types.h"
+
+struct sim_periph;
+
+typedef u32  (*sim_rd_fct)(struct sim_periph *p, u32 offset, uint size);
+typedef void (*sim_wr_fct)(struct sim_periph *p, u32 offset, u32 value, uint size);
+typedef void (*sim_rst_fct)(struct sim_periph *p);
+
+/**
+ * @brief Model of a peripheral attached to the simulated bus
+ *
+ * The base address is the non-secure alias, accesses to the secure alias
+ * are routed to the same model.
+ */
+typedef struct sim_periph
+{
+	const char *name;
+	u32  base;
+	u32  size;
+	sim_rd_fct  rd;
+	sim_wr_fct  wr;
+	sim_rst_fct reset;
+	void *priv;
+	struct sim_periph *next;
+} sim_periph;
+
+/**
+ * @brief Counters of bus accesses (used by benchmarks)
+ */
+typedef struct sim_stats
+{
+	unsigned long rd;
+	unsigned long wr;
+} sim_stats;
+
+extern sim_stats sim_stat;
+extern jmp_buf   sim_boot;
+
+void sim_init  (void);
+void sim_attach(sim_periph *p);
+u32  sim_rd    (u32 addr, uint size);
+void sim_wr    (u32 addr, u32 value, uint size);
+void sim_load  (u32 addr, const void *data, uint len);
+void sim_read  (u32 addr, void *data, uint len);
+u32  sim_addr  (const void *ptr, uint len);
+void sim_reset (void);
+void sim_vector(uint irq, void (*handler)(void));
+void sim_irq   (uint irq);
+u32  sim_irq_mask(u32 mask);
+u32  sim_irq_basepri(u32 basepri, int max);
+
+/* Peripheral models */
+void sim_adc_init  (void);
+void sim_adc_poll  (void);
+int  sim_adc_busy  (void);
+void sim_uart_init (void);
+int  sim_uart_eof  (void);
+void sim_spi_init  (void);
+void sim_rcc_init  (void);
+void sim_rng_init  (void);
+void sim_gpio_init (void);
+u32  sim_gpio_odr  (uint port);
+void sim_flash_init(void);
+void sim_flash_save(void);
+void sim_dma_init  (void);
+void sim_eth_init  (void);
+void sim_eth_poll  (void);
+void sim_fdcan_init(void);
+int  sim_fdcan_rx  (u32 id, int xtd, int fd, const u8 *data, uint len);
+void sim_dma_paced (uint req);
+void sim_dma_request(uint req);
+void sim_crypto_init(void);
+void sim_rtc_init  (void);
+void sim_rtc_poll  (void);
+void sim_tim_init  (void);
+void sim_tim_poll  (void);
+
+#endif
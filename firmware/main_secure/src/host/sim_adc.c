@@ -0,0 +1,261 @@
+/**
+ * @file  host/sim_adc.c
+ * @brief Host model of ADC1 (continuous scan with DMA, analog watchdogs)
+ *
+ * The results come from a recorded trace given by SIM_ADC : a text file
+ * with one sequence per line, one value (12 bits) per rank separated by
+ * spaces or commas. Lines starting with '#' are ignored. Without trace,
+ * or after its end, the last values are converted again (2048 for all
+ * channels at start).
+ *
+ * One sequence is converted each time the status of the DMA is read (see
+ * sim_dma.c) : each result is moved by a DMA request and checked by the
+ * analog watchdogs. The replay is deterministic, it does not depend on
+ * the host clock.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hardware.h"
+#include "driver/adc.h"
+#include "driver/dma.h"
+#include "host/sim.h"
+
+#define ADC_IRQ  37
+#define REG(off) regs[(off) >> 2]
+// Sequences converted after the end of the trace (results processed)
+#define TAIL 64
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+static void _next(void);
+static uint _channel(uint rank);
+static u32  _watch(uint ch, u32 v);
+
+static u32  regs[0x400 / 4];
+static u16  values[ADC_RANKS_MAX];
+static FILE *f_in;
+static uint tail;
+static int  busy;
+
+static sim_periph adc_model =
+{
+	.name = "ADC1",
+	.base = ADC1_NS,
+	.size = 0x400,
+	.rd   = _rd,
+	.wr   = _wr,
+};
+
+/**
+ * @brief Attach the ADC model to the bus, open the trace
+ *
+ */
+void sim_adc_init(void)
+{
+	const char *name;
+	uint i;
+
+	memset(regs, 0, sizeof(regs));
+	REG(0x08) = (1u << 29); // CR : DEEPPWD
+	for (i = 0; i < ADC_RANKS_MAX; i++)
+		values[i] = 2048;
+	tail = 0;
+	busy = 0;
+	f_in = 0;
+	name = getenv("SIM_ADC");
+	if (name)
+	{
+		f_in = fopen(name, "r");
+		if (f_in == 0)
+			fprintf(stderr, "sim: can not open %s\n", name);
+	}
+	sim_dma_paced(DMA_REQ_ADC1);
+	sim_attach(&adc_model);
+}
+
+/**
+ * @brief Test if the trace has not been fully converted
+ *
+ * @return integer Non-zero while sequences of the trace remain
+ */
+int sim_adc_busy(void)
+{
+	return (f_in != 0) || ((tail > 0) && (tail < TAIL));
+}
+
+/**
+ * @brief Convert one sequence (if conversions are running)
+ *
+ */
+void sim_adc_poll(void)
+{
+	u32  events = 0;
+	uint rank, count;
+
+	// ADSTART and DMAEN
+	if (((REG(0x08) & (1u << 2)) == 0) || ((REG(0x0C) & 1) == 0) || busy)
+		return;
+	busy = 1;
+	_next();
+	count = (REG(0x30) & 0xF) + 1;
+	for (rank = 0; rank < count; rank++)
+	{
+		REG(0x40) = values[rank];
+		events |= _watch(_channel(rank), values[rank]);
+		REG(0x00) |= (1u << 2); // EOC
+		sim_dma_request(DMA_REQ_ADC1);
+	}
+	REG(0x00) |= (1u << 3) | events; // EOS
+	busy = 0;
+	if (REG(0x00) & REG(0x04) & ADC_AWD_ALL)
+		sim_irq(ADC_IRQ);
+}
+
+/**
+ * @brief Read a register of the ADC
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	(void)p; (void)size;
+
+	if (offset >= sizeof(regs))
+		return(0);
+	return REG(offset);
+}
+
+/**
+ * @brief Write a register of the ADC
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	(void)p; (void)size;
+
+	if (offset >= sizeof(regs))
+		return;
+	switch (offset)
+	{
+		case 0x00: // ISR : write 1 to clear
+			REG(0x00) &= ~value;
+			break;
+		case 0x08: // CR
+			// Calibration ends at once
+			value &= ~(1u << 31);
+			if (value & (1u << 0))
+				REG(0x00) |= (1u << 0); // ADRDY
+			// ADSTP : conversions stopped at once
+			if (value & (1u << 4))
+				value &= ~((1u << 4) | (1u << 2));
+			REG(0x08) = value;
+			break;
+		default:
+			REG(offset) = value;
+			break;
+	}
+}
+
+/**
+ * @brief Load the values of the next sequence from the trace
+ *
+ */
+static void _next(void)
+{
+	char line[256];
+	char *s, *end;
+	uint rank;
+	long v;
+
+	if (f_in == 0)
+	{
+		if (tail)
+			tail++;
+		return;
+	}
+	while (fgets(line, sizeof(line), f_in))
+	{
+		if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r'))
+			continue;
+		s = line;
+		for (rank = 0; rank < ADC_RANKS_MAX; rank++)
+		{
+			while ((*s == ' ') || (*s == ',') || (*s == '\t'))
+				s++;
+			v = strtol(s, &end, 0);
+			if (end == s)
+				break;
+			values[rank] = (u16)(v & 0xFFF);
+			s = end;
+		}
+		return;
+	}
+	fclose(f_in);
+	f_in = 0;
+	tail = 1;
+}
+
+/**
+ * @brief Get the channel converted at a rank of the sequence
+ *
+ * @param rank Index of the rank (0 for SQ1)
+ * @return uint Channel number
+ */
+static uint _channel(uint rank)
+{
+	static const u8 reg[4] = { 0x30, 0x34, 0x38, 0x3C };
+	uint pos = rank + 1;
+
+	return (REG(reg[pos / 5]) >> (6 * (pos % 5))) & 0x1F;
+}
+
+/**
+ * @brief Check a result against the analog watchdogs
+ *
+ * @param ch Channel of the result
+ * @param v  Result (12 bits)
+ * @return u32 Watchdog events (ISR bits)
+ */
+static u32 _watch(uint ch, u32 v)
+{
+	u32 cfgr = REG(0x0C);
+	u32 events = 0;
+	u32 lt, ht;
+
+	// AWD1 : all channels or one (AWD1SGL), 12 bits thresholds
+	if ((cfgr & (1u << 23)) &&
+	    (((cfgr & (1u << 22)) == 0) || (((cfgr >> 26) & 0x1F) == ch)))
+	{
+		lt = REG(0x20) & 0xFFF;
+		ht = (REG(0x20) >> 16) & 0xFFF;
+		if ((v < lt) || (v > ht))
+			events |= ADC_AWD1;
+	}
+	// AWD2 and AWD3 : channel masks, 8 bits thresholds
+	v >>= 4;
+	if (REG(0xA0) & (1u << ch))
+	{
+		lt = REG(0x24) & 0xFF;
+		ht = (REG(0x24) >> 16) & 0xFF;
+		if ((v < lt) || (v > ht))
+			events |= ADC_AWD2;
+	}
+	if (REG(0xA4) & (1u << ch))
+	{
+		lt = REG(0x28) & 0xFF;
+		ht = (REG(0x28) >> 16) & 0xFF;
+		if ((v < lt) || (v > ht))
+			events |= ADC_AWD3;
+	}
+	return(events);
+}
+/* EOF */
@@ -0,0 +1,422 @@
+/**
+ * @file  host/sim_crypto.c
+ * @brief Host models of the CRC unit and HASH coprocessor (SHA-256 only)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "driver/crc.h"
+#include "driver/hash.h"
+#include "hardware.h"
+#include "host/sim.h"
+
+typedef struct sha256_ctx
+{
+	u32 h[8];
+	u8  block[64];
+	uint len;
+	unsigned long total;
+} sha256_ctx;
+
+static u32  _crc_rd(sim_periph *p, u32 offset, uint size);
+static void _crc_wr(sim_periph *p, u32 offset, u32 value, uint size);
+static u32  _hash_rd(sim_periph *p, u32 offset, uint size);
+static void _hash_wr(sim_periph *p, u32 offset, u32 value, uint size);
+static void _hash_calc(void);
+static void _hash_push(u8 c);
+static void _hmac(void);
+static void _sha256(const u8 *data, uint len, u8 *digest);
+static void _sha256_init(sha256_ctx *ctx);
+static void _sha256_update(sha256_ctx *ctx, const u8 *data, uint len);
+static void _sha256_final(sha256_ctx *ctx, u8 *digest);
+static void _sha256_block(sha256_ctx *ctx);
+
+static u32  crc_regs[0x400 / 4];
+static u32  crc_value;
+static u32  hash_regs[0x400 / 4];
+static u8  *hash_buf;
+static uint hash_len, hash_cap;
+static u8  *hash_key;
+static uint hash_key_len;
+static uint hash_phase;
+
+static sim_periph crc_model =
+{
+	.name = "CRC",
+	.base = CRC_NS,
+	.size = 0x400,
+	.rd   = _crc_rd,
+	.wr   = _crc_wr,
+};
+
+static sim_periph hash_model =
+{
+	.name = "HASH",
+	.base = HASH_NS,
+	.size = 0x400,
+	.rd   = _hash_rd,
+	.wr   = _hash_wr,
+};
+
+static const u32 k256[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/**
+ * @brief Attach CRC and HASH models to the bus
+ *
+ */
+void sim_crypto_init(void)
+{
+	crc_regs[CRC_INIT(0) >> 2] = 0xFFFFFFFF;
+	crc_regs[CRC_POL(0)  >> 2] = 0x04C11DB7;
+	crc_value  = 0xFFFFFFFF;
+	hash_phase = 0;
+	hash_len   = 0;
+	sim_attach(&crc_model);
+	sim_attach(&hash_model);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  CRC unit                                  */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Read a register of the CRC unit
+ */
+static u32 _crc_rd(sim_periph *p, u32 offset, uint size)
+{
+	(void)p; (void)size;
+
+	if (offset == CRC_DR(0))
+		return(crc_value);
+	return crc_regs[offset >> 2];
+}
+
+/**
+ * @brief Write a register of the CRC unit
+ *
+ * Only the default configuration is modelled : 32 bits polynomial, words
+ * processed MSB first without reversal.
+ */
+static void _crc_wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	uint i;
+	(void)p; (void)size;
+
+	if (offset == CRC_DR(0))
+	{
+		crc_value ^= value;
+		for (i = 0; i < 32; i++)
+		{
+			if (crc_value & 0x80000000)
+				crc_value = (crc_value << 1) ^ crc_regs[CRC_POL(0) >> 2];
+			else
+				crc_value = (crc_value << 1);
+		}
+		return;
+	}
+	if ((offset == CRC_CR(0)) && (value & (1 << 0)))
+	{
+		crc_value = crc_regs[CRC_INIT(0) >> 2];
+		value &= ~(u32)(1 << 0);
+	}
+	crc_regs[offset >> 2] = value;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              HASH coprocessor                              */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Read a register of the HASH coprocessor
+ */
+static u32 _hash_rd(sim_periph *p, u32 offset, uint size)
+{
+	(void)p; (void)size;
+	return hash_regs[offset >> 2];
+}
+
+/**
+ * @brief Write a register of the HASH coprocessor
+ */
+static void _hash_wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	uint i;
+	(void)p; (void)size;
+
+	switch (offset)
+	{
+		case HASH_CR(0):
+			if (value & (1 << 2))
+			{
+				// INIT : start a new digest
+				hash_len   = 0;
+				hash_phase = 0;
+				hash_regs[HASH_SR(0) >> 2] = (1 << 0);
+				value &= ~(u32)(1 << 2);
+			}
+			hash_regs[HASH_CR(0) >> 2] = value;
+			break;
+		case HASH_DIN(0):
+			// DATATYPE bytes : first byte of the message is the LSB
+			for (i = 0; i < 4; i++)
+				_hash_push((u8)(value >> (8 * i)));
+			break;
+		case HASH_STR(0):
+			hash_regs[HASH_STR(0) >> 2] = value & 0x1F;
+			if ((value & (1 << 8)) == 0)
+				break;
+			// Remove unused bytes of the last word
+			if ((value & 0x1F) && (hash_phase != 2) && (hash_len >= 4))
+				hash_len -= 4 - ((value & 0x1F) / 8);
+			_hash_calc();
+			break;
+		case HASH_SR(0):
+			hash_regs[HASH_SR(0) >> 2] &= value;
+			break;
+		default:
+			if (offset < 0x310)
+				hash_regs[offset >> 2] = value;
+			break;
+	}
+}
+
+/**
+ * @brief Process the data received since the last DCAL
+ *
+ */
+static void _hash_calc(void)
+{
+	u32 *sr = &hash_regs[HASH_SR(0) >> 2];
+	u8   digest[32];
+	uint i;
+
+	if ((hash_regs[HASH_CR(0) >> 2] & (1 << 6)) == 0)
+		_sha256(hash_buf, hash_len, digest);
+	else if (hash_phase == 0)
+	{
+		// HMAC : first phase is the key
+		free(hash_key);
+		hash_key     = (u8 *)malloc(hash_len + 1);
+		hash_key_len = hash_len;
+		memcpy(hash_key, hash_buf, hash_len);
+		hash_phase = 1;
+		hash_len   = 0;
+		*sr |= (1 << 0);
+		return;
+	}
+	else if (hash_phase == 1)
+	{
+		// HMAC : second phase is the message, keep it into buffer
+		hash_phase = 2;
+		*sr |= (1 << 0);
+		return;
+	}
+	else
+	{
+		_hmac();
+		return;
+	}
+
+	for (i = 0; i < 8; i++)
+		hash_regs[(HASH_HR(0, i)) >> 2] = (u32)(digest[4*i] << 24) | (u32)(digest[4*i+1] << 16) |
+		                                  (u32)(digest[4*i+2] << 8) | (u32)digest[4*i+3];
+	hash_len = 0;
+	*sr |= (1 << 1) | (1 << 0);
+}
+
+/**
+ * @brief Append one byte to the input buffer
+ *
+ * @param c Byte to append
+ */
+static void _hash_push(u8 c)
+{
+	if (hash_phase == 2)
+		return; // Outer key : already known from first phase
+	if (hash_len == hash_cap)
+	{
+		hash_cap = hash_cap ? (2 * hash_cap) : 4096;
+		hash_buf = (u8 *)realloc(hash_buf, hash_cap);
+		if (hash_buf == 0)
+			abort();
+	}
+	hash_buf[hash_len++] = c;
+}
+
+/**
+ * @brief Compute HMAC with the key of phase 1 and message into buffer
+ *
+ */
+static void _hmac(void)
+{
+	sha256_ctx ctx;
+	u8   k[64], pad[64], inner[32], digest[32];
+	uint i;
+
+	memset(k, 0, sizeof(k));
+	if (hash_key_len > 64)
+		_sha256(hash_key, hash_key_len, k);
+	else
+		memcpy(k, hash_key, hash_key_len);
+
+	for (i = 0; i < 64; i++)
+		pad[i] = k[i] ^ 0x36;
+	_sha256_init(&ctx);
+	_sha256_update(&ctx, pad, 64);
+	_sha256_update(&ctx, hash_buf, hash_len);
+	_sha256_final(&ctx, inner);
+
+	for (i = 0; i < 64; i++)
+		pad[i] = k[i] ^ 0x5C;
+	_sha256_init(&ctx);
+	_sha256_update(&ctx, pad, 64);
+	_sha256_update(&ctx, inner, 32);
+	_sha256_final(&ctx, digest);
+
+	for (i = 0; i < 8; i++)
+		hash_regs[(HASH_HR(0, i)) >> 2] = (u32)(digest[4*i] << 24) | (u32)(digest[4*i+1] << 16) |
+		                                  (u32)(digest[4*i+2] << 8) | (u32)digest[4*i+3];
+	hash_len   = 0;
+	hash_phase = 0;
+	hash_regs[HASH_SR(0) >> 2] |= (1 << 1) | (1 << 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           SHA-256 implementation                           */
+/* -------------------------------------------------------------------------- */
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/**
+ * @brief Compute the SHA-256 digest of a buffer
+ *
+ * @param data   Pointer to the data
+ * @param len    Number of bytes
+ * @param digest Pointer to a buffer where to store result (32 bytes)
+ */
+static void _sha256(const u8 *data, uint len, u8 *digest)
+{
+	sha256_ctx ctx;
+
+	_sha256_init(&ctx);
+	_sha256_update(&ctx, data, len);
+	_sha256_final(&ctx, digest);
+}
+
+/**
+ * @brief Initialize a SHA-256 context
+ *
+ * @param ctx Pointer to the context
+ */
+static void _sha256_init(sha256_ctx *ctx)
+{
+	static const u32 h0[8] =
+	{
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+	memcpy(ctx->h, h0, sizeof(h0));
+	ctx->len   = 0;
+	ctx->total = 0;
+}
+
+/**
+ * @brief Push data into a SHA-256 context
+ *
+ * @param ctx  Pointer to the context
+ * @param data Pointer to the data
+ * @param len  Number of bytes
+ */
+static void _sha256_update(sha256_ctx *ctx, const u8 *data, uint len)
+{
+	ctx->total += len;
+	while (len--)
+	{
+		ctx->block[ctx->len++] = *data++;
+		if (ctx->len == 64)
+		{
+			_sha256_block(ctx);
+			ctx->len = 0;
+		}
+	}
+}
+
+/**
+ * @brief Add padding and extract the digest of a SHA-256 context
+ *
+ * @param ctx    Pointer to the context
+ * @param digest Pointer to a buffer where to store result (32 bytes)
+ */
+static void _sha256_final(sha256_ctx *ctx, u8 *digest)
+{
+	unsigned long bits = ctx->total * 8;
+	uint i;
+
+	ctx->block[ctx->len++] = 0x80;
+	if (ctx->len > 56)
+	{
+		memset(&ctx->block[ctx->len], 0, 64 - ctx->len);
+		_sha256_block(ctx);
+		ctx->len = 0;
+	}
+	memset(&ctx->block[ctx->len], 0, 56 - ctx->len);
+	for (i = 0; i < 8; i++)
+		ctx->block[63 - i] = (u8)(bits >> (8 * i));
+	_sha256_block(ctx);
+
+	for (i = 0; i < 32; i++)
+		digest[i] = (u8)(ctx->h[i / 4] >> (24 - (8 * (i % 4))));
+}
+
+/**
+ * @brief Process one 64 bytes block
+ *
+ * @param ctx Pointer to the context
+ */
+static void _sha256_block(sha256_ctx *ctx)
+{
+	u32 w[64], v[8], t1, t2;
+	uint i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = (u32)(ctx->block[4*i] << 24) | (u32)(ctx->block[4*i+1] << 16) |
+		       (u32)(ctx->block[4*i+2] << 8) | (u32)ctx->block[4*i+3];
+	for (i = 16; i < 64; i++)
+		w[i] = (ROR(w[i-2], 17) ^ ROR(w[i-2], 19) ^ (w[i-2] >> 10)) + w[i-7] +
+		       (ROR(w[i-15], 7) ^ ROR(w[i-15], 18) ^ (w[i-15] >> 3)) + w[i-16];
+
+	memcpy(v, ctx->h, sizeof(v));
+	for (i = 0; i < 64; i++)
+	{
+		t1 = v[7] + (ROR(v[4], 6) ^ ROR(v[4], 11) ^ ROR(v[4], 25)) +
+		     ((v[4] & v[5]) ^ (~v[4] & v[6])) + k256[i] + w[i];
+		t2 = (ROR(v[0], 2) ^ ROR(v[0], 13) ^ ROR(v[0], 22)) +
+		     ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+		memmove(&v[1], &v[0], 7 * sizeof(u32));
+		v[4] += t1;
+		v[0]  = t1 + t2;
+	}
+	for (i = 0; i < 8; i++)
+		ctx->h[i] += v[i];
+}
+/* EOF */
@@ -0,0 +1,224 @@
+/**
+ * @file  host/sim_dma.c
+ * @brief Host model of GPDMA1
+ *
+ * Memory-to-memory transfers, and transfers to peripherals modeled as
+ * always ready (CRC, HASH), are made immediately when the channel is
+ * enabled. Requests of paced peripherals (timers and ADC, see
+ * sim_dma_paced) move one data each. Linked-list items are loaded at the
+ * end of each block.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/dma.h"
+#include "hardware.h"
+#include "host/sim.h"
+
+#define CHANNELS 8
+#define CH_REG(ch, offset) regs[(0x50 + (0x80 * (ch)) + (offset)) >> 2]
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+static void _transfer(uint ch);
+static void _beat(uint ch);
+static int  _link(uint ch);
+
+static u32 regs[0x1000 / 4];
+static u32 paced[4];
+
+static sim_periph dma_model =
+{
+	.name = "GPDMA1",
+	.base = GPDMA1_NS,
+	.size = 0x1000,
+	.rd   = _rd,
+	.wr   = _wr,
+};
+
+/**
+ * @brief Attach the GPDMA1 model to the bus
+ *
+ */
+void sim_dma_init(void)
+{
+	uint ch;
+
+	for (ch = 0; ch < CHANNELS; ch++)
+		CH_REG(ch, 0x10) = (1 << 0); // IDLEF
+	sim_attach(&dma_model);
+}
+
+/**
+ * @brief Declare a request line that paces the transfers
+ *
+ * @param req Request number (REQSEL)
+ */
+void sim_dma_paced(uint req)
+{
+	paced[(req & 0x7F) / 32] |= (1u << (req % 32));
+}
+
+/**
+ * @brief Signal a hardware request, one word is moved by each channel
+ *        enabled for this request
+ *
+ * @param req Request number (REQSEL)
+ */
+void sim_dma_request(uint req)
+{
+	uint ch;
+
+	for (ch = 0; ch < CHANNELS; ch++)
+	{
+		if ((CH_REG(ch, 0x14) & ((1 << 0) | (1 << 2))) != (1 << 0))
+			continue;
+		if ((CH_REG(ch, 0x44) & ((1 << 9) | 0x7F)) != (req & 0x7F))
+			continue;
+		_beat(ch);
+	}
+}
+
+/**
+ * @brief Read a register of the DMA controller
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	(void)p; (void)size;
+	// Status of timer and ADC driven transfers
+	sim_tim_poll();
+	sim_adc_poll();
+	return regs[offset >> 2];
+}
+
+/**
+ * @brief Write a register of the DMA controller
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	uint ch, reg, req;
+	(void)p; (void)size;
+
+	if ((offset < 0x50) || (offset >= (0x50 + (0x80 * CHANNELS))))
+	{
+		regs[offset >> 2] = value;
+		return;
+	}
+	ch  = (offset - 0x50) / 0x80;
+	reg = (offset - 0x50) % 0x80;
+	switch (reg)
+	{
+		case 0x0C: // CxFCR
+			CH_REG(ch, 0x10) &= ~value;
+			break;
+		case 0x10: // CxSR (read only)
+			break;
+		case 0x14: // CxCR
+			if (value & (1 << 1))
+			{
+				CH_REG(ch, 0x10) = (1 << 0); // IDLEF
+				CH_REG(ch, 0x14) = 0;
+				break;
+			}
+			// SUSP : stops at once, SUSPF and IDLEF
+			if (value & (1 << 2))
+				CH_REG(ch, 0x10) |= (1 << 13) | (1 << 0);
+			CH_REG(ch, 0x14) = value;
+			if ((value & ((1 << 0) | (1 << 2))) != (1 << 0))
+				break;
+			CH_REG(ch, 0x10) &= ~(u32)(1 << 0);
+			req = CH_REG(ch, 0x44) & 0x7F;
+			if ((CH_REG(ch, 0x44) & (1 << 9)) ||
+			    ((paced[req / 32] & (1u << (req % 32))) == 0))
+				_transfer(ch);
+			break;
+		default:
+			regs[offset >> 2] = value;
+			break;
+	}
+}
+
+/**
+ * @brief Execute all the programmed transfer of a channel (not paced)
+ *
+ * @param ch Index of the channel
+ */
+static void _transfer(uint ch)
+{
+	while (CH_REG(ch, 0x14) & (1 << 0))
+		_beat(ch);
+}
+
+/**
+ * @brief Move one data (width of the source), load the next item at the
+ *        end of a block
+ *
+ * @param ch Index of the channel
+ */
+static void _beat(uint ch)
+{
+	u32  tr1  = CH_REG(ch, 0x40);
+	u32  len  = CH_REG(ch, 0x48) & 0xFFFF;
+	uint size = 1u << (tr1 & 3); // SDW_LOG2
+
+	if (len >= size)
+	{
+		sim_wr(CH_REG(ch, 0x50), sim_rd(CH_REG(ch, 0x4C), size), size);
+		if (tr1 & (1 << 3))
+			CH_REG(ch, 0x4C) += size;
+		if (tr1 & (1 << 19))
+			CH_REG(ch, 0x50) += size;
+		len -= size;
+		CH_REG(ch, 0x48) = (CH_REG(ch, 0x48) & ~(u32)0xFFFF) | len;
+	}
+	if (len >= size)
+		return;
+
+	CH_REG(ch, 0x10) |= (1 << 8); // TCF (end of block)
+	if (_link(ch))
+		return;
+	CH_REG(ch, 0x14) &= ~(u32)(1 << 0);
+	CH_REG(ch, 0x10) |= (1 << 0); // IDLEF
+}
+
+/**
+ * @brief Load the next linked-list item of a channel
+ *
+ * Registers flagged into CLLR are read in their order (CTR1, CTR2, CBR1,
+ * CSAR, CDAR, CTR3, CBR2, CLLR) from the address given by CLBAR and LA.
+ *
+ * @param ch Index of the channel
+ * @return integer Non-zero if an item has been loaded
+ */
+static int _link(uint ch)
+{
+	static const u8 order[8]  = { 0x40, 0x44, 0x48, 0x4C, 0x50, 0x54, 0x58, 0x7C };
+	static const u8 flags[8]  = { 31, 30, 29, 28, 27, 26, 25, 16 };
+	u32  llr = CH_REG(ch, 0x7C);
+	u32  addr;
+	uint i;
+
+	if (llr == 0)
+		return(0);
+	addr = (CH_REG(ch, 0x00) & 0xFFFF0000) | (llr & 0xFFFC);
+	for (i = 0; i < 8; i++)
+	{
+		if ((llr & (1u << flags[i])) == 0)
+			continue;
+		CH_REG(ch, order[i]) = sim_rd(addr, 4);
+		addr += 4;
+	}
+	// CLLR not updated : the list ends after this item
+	if ((llr & (1u << 16)) == 0)
+		CH_REG(ch, 0x7C) = 0;
+	return(1);
+}
+/* EOF */
\ No newline at end of file
@@ -0,0 +1,563 @@
+/**
+ * @file  host/sim_eth.c
+ * @brief Host model of the Ethernet MAC, its DMA and the PHY
+ *
+ * Descriptor rings are processed like the DMA of the MAC does : transmit
+ * descriptors when the tail pointer is written, receive descriptors when
+ * a frame is available. Frames are exchanged with pcap files (or named
+ * pipes) given by environment variables :
+ *
+ *   SIM_ETH_TX : transmitted frames are appended to this file
+ *   SIM_ETH_RX : frames read from this file are received, in order
+ *
+ * With MACCR.LM (loopback), transmitted frames are received back. The
+ * destination address filter, IP/TCP/UDP/ICMP checksum insertion (TX) and
+ * verification (RX) are modeled. The PHY always reports a 100 Mbit/s full
+ * duplex link.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "hardware.h"
+#include "driver/eth.h"
+#include "host/sim.h"
+
+#define SIM_FRAME_MAX 1536
+#define QUEUE_LEN     16
+#define REG(off)      regs[(off) >> 2]
+
+typedef struct sim_frame
+{
+	u32 len;
+	u8  data[SIM_FRAME_MAX];
+} sim_frame;
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+static void _rst(sim_periph *p);
+static void _mdio(u32 value);
+static void _tx(void);
+static void _rx(void);
+static void _input(void);
+static void _queue(const u8 *data, u32 len);
+static int  _accept(const u8 *data);
+static void _pcap_write(const u8 *data, u32 len);
+static void _csum_insert(u8 *f, u32 len);
+static u32  _csum_check(const u8 *f, u32 len);
+static u16  _csum(const u8 *data, u32 len, u32 sum);
+static u32  _pseudo(const u8 *ip, u32 len);
+
+static u32 regs[0x1200 / 4];
+static u16 phy_bmcr;
+static uint tx_index, rx_index;
+static sim_frame tx_frame;
+static sim_frame queue[QUEUE_LEN];
+static uint q_head, q_count;
+static FILE *f_tx;
+static int   f_rx = -1;
+static u8    in_buf[2 * (SIM_FRAME_MAX + 16)];
+static uint  in_len;
+static int   in_hdr;
+
+static sim_periph eth_model =
+{
+	.name  = "ETH",
+	.base  = ETH_NS,
+	.size  = 0x1200,
+	.rd    = _rd,
+	.wr    = _wr,
+	.reset = _rst,
+};
+
+/**
+ * @brief Attach the ETH model to the bus, open the pcap files
+ *
+ */
+void sim_eth_init(void)
+{
+	static const u32 hdr[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, 1 };
+	const char *name;
+
+	name = getenv("SIM_ETH_TX");
+	if (name)
+	{
+		f_tx = fopen(name, "wb");
+		if (f_tx)
+			fwrite(hdr, sizeof(hdr), 1, f_tx);
+		else
+			fprintf(stderr, "sim: can not open %s\n", name);
+	}
+	name = getenv("SIM_ETH_RX");
+	if (name)
+	{
+		f_rx = open(name, O_RDONLY | O_NONBLOCK);
+		if (f_rx < 0)
+			fprintf(stderr, "sim: can not open %s\n", name);
+	}
+	in_len = 0;
+	in_hdr = 0;
+	_rst(&eth_model);
+	sim_attach(&eth_model);
+}
+
+/**
+ * @brief Receive the frames available from the input file
+ *
+ * Called when the time is read (see sim_tim.c), like frames received by
+ * the MAC while the firmware was running.
+ */
+void sim_eth_poll(void)
+{
+	_rx();
+}
+
+/**
+ * @brief Read a register of the MAC
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	(void)p; (void)size;
+
+	if (offset >= sizeof(regs))
+		return(0);
+	// Status of the DMA : receive pending frames first
+	if (offset == 0x1160)
+		_rx();
+	return REG(offset);
+}
+
+/**
+ * @brief Write a register of the MAC
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	(void)p; (void)size;
+
+	if (offset >= sizeof(regs))
+		return;
+	switch (offset)
+	{
+		// DMAMR : software reset
+		case 0x1000:
+			if (value & 1)
+			{
+				_rst(&eth_model);
+				break;
+			}
+			REG(offset) = value;
+			break;
+		// MACMDIOAR : operation done at once
+		case 0x0200:
+			if (value & 1)
+				_mdio(value);
+			REG(offset) = value & ~(u32)1;
+			break;
+		// DMACSR : write 1 to clear
+		case 0x1160:
+			REG(offset) &= ~value;
+			break;
+		case 0x1114: // DMACTXDLAR
+			REG(offset) = value;
+			tx_index = 0;
+			break;
+		case 0x111C: // DMACRXDLAR
+			REG(offset) = value;
+			rx_index = 0;
+			break;
+		case 0x1104: // DMACTXCR
+		case 0x1120: // DMACTXDTPR
+			REG(offset) = value;
+			_tx();
+			break;
+		case 0x0000: // MACCR
+		case 0x1108: // DMACRXCR
+		case 0x1128: // DMACRXDTPR
+			REG(offset) = value;
+			_rx();
+			break;
+		default:
+			REG(offset) = value;
+			break;
+	}
+}
+
+/**
+ * @brief Reset the MAC (system reset or DMAMR.SWR)
+ */
+static void _rst(sim_periph *p)
+{
+	(void)p;
+	memset(regs, 0, sizeof(regs));
+	phy_bmcr = (1 << 12);
+	tx_index = rx_index = 0;
+	q_head = q_count = 0;
+}
+
+/**
+ * @brief Execute a MDIO operation on the PHY (LAN8742A, address 0)
+ *
+ * @param value Value written to MACMDIOAR
+ */
+static void _mdio(u32 value)
+{
+	uint reg = (value >> 16) & 0x1F;
+	u32  v;
+
+	// GOC : 1 write, 3 read
+	if (((value >> 2) & 3) == 1)
+	{
+		if (reg == 0)
+			phy_bmcr = (u16)(REG(0x204) & ~(u32)((1 << 15) | (1 << 9)));
+		return;
+	}
+	switch (reg)
+	{
+		case 0:  v = phy_bmcr; break;
+		case 1:  v = 0x782D; break; // Link up, auto-negotiation complete
+		case 2:  v = 0x0007; break;
+		case 3:  v = 0xC131; break;
+		case 31: v = 0x1018; break; // Autodone, 100BASE-TX full duplex
+		default: v = 0; break;
+	}
+	REG(0x204) = v;
+}
+
+/**
+ * @brief Process the transmit descriptors owned by the DMA
+ *
+ */
+static void _tx(void)
+{
+	u32 d[4], addr, len;
+
+	if ((REG(0x1104) & 1) == 0)
+		return;
+	while (1)
+	{
+		addr = REG(0x1114) + (tx_index * 16);
+		sim_read(addr, d, sizeof(d));
+		if ((d[3] & ETH_DES3_OWN) == 0)
+			break;
+		if (d[3] & ETH_DES3_FD)
+			tx_frame.len = 0;
+
+		// Buffer 1 then buffer 2
+		len = d[2] & ETH_SEG_MAX;
+		if ((tx_frame.len + len) <= SIM_FRAME_MAX)
+		{
+			sim_read(d[0], tx_frame.data + tx_frame.len, len);
+			tx_frame.len += len;
+		}
+		len = (d[2] >> 16) & ETH_SEG_MAX;
+		if ((tx_frame.len + len) <= SIM_FRAME_MAX)
+		{
+			sim_read(d[1], tx_frame.data + tx_frame.len, len);
+			tx_frame.len += len;
+		}
+
+		if (d[3] & ETH_DES3_LD)
+		{
+			if ((d[3] & ETH_TDES3_CIC) == ETH_TDES3_CIC)
+				_csum_insert(tx_frame.data, tx_frame.len);
+			// Padding to the minimal frame size
+			for ( ; tx_frame.len < 60; tx_frame.len++)
+				tx_frame.data[tx_frame.len] = 0;
+			if (REG(0x0000) & (1 << 12))
+				_queue(tx_frame.data, tx_frame.len);
+			else
+				_pcap_write(tx_frame.data, tx_frame.len);
+			REG(0x1160) |= (1 << 15) | (1 << 0); // NIS, TI
+		}
+		// Write-back : status only
+		d[3] &= (ETH_DES3_FD | ETH_DES3_LD);
+		sim_load(addr + 12, &d[3], 4);
+		tx_index = (tx_index + 1) % ((REG(0x112C) & 0x3FF) + 1);
+	}
+	_rx();
+}
+
+/**
+ * @brief Move pending frames into the receive descriptors owned by the DMA
+ *
+ */
+static void _rx(void)
+{
+	sim_frame *f;
+	u32 d[4], addr, size;
+
+	_input();
+	// Receiver (MACCR.RE) and receive DMA (DMACRXCR.SR) must be enabled
+	if (((REG(0x0000) & (1 << 0)) == 0) || ((REG(0x1108) & 1) == 0))
+		return;
+	while (q_count)
+	{
+		addr = REG(0x111C) + (rx_index * 16);
+		sim_read(addr, d, sizeof(d));
+		if ((d[3] & ETH_DES3_OWN) == 0)
+			break;
+		f = &queue[q_head];
+		size = (REG(0x1108) >> 1) & 0x3FFF;
+		if (f->len > size)
+			d[3] = ETH_DES3_FD | ETH_DES3_LD | ETH_DES3_ES | (1 << 21);
+		else
+		{
+			sim_load(d[0], f->data, f->len);
+			d[1] = (REG(0x0000) & (1 << 27)) ? _csum_check(f->data, f->len) : 0;
+			d[3] = ETH_DES3_FD | ETH_DES3_LD | ETH_RDES3_RS1V | f->len;
+		}
+		d[0] = d[2] = 0;
+		sim_load(addr, d, sizeof(d));
+		q_head = (q_head + 1) % QUEUE_LEN;
+		q_count--;
+		rx_index = (rx_index + 1) % ((REG(0x1130) & 0x3FF) + 1);
+		REG(0x1160) |= (1 << 15) | (1 << 6); // NIS, RI
+	}
+}
+
+/**
+ * @brief Read the frames available from the input file (non blocking)
+ *
+ */
+static void _input(void)
+{
+	u32  hdr[4];
+	long n;
+
+	if (f_rx < 0)
+		return;
+	n = read(f_rx, in_buf + in_len, sizeof(in_buf) - in_len);
+	if (n > 0)
+		in_len += (uint)n;
+
+	// Skip the global header of the file
+	if ( ! in_hdr)
+	{
+		if (in_len < 24)
+			return;
+		memmove(in_buf, in_buf + 24, in_len - 24);
+		in_len -= 24;
+		in_hdr = 1;
+	}
+	while (in_len >= sizeof(hdr))
+	{
+		memcpy(hdr, in_buf, sizeof(hdr));
+		if (hdr[2] > SIM_FRAME_MAX)
+		{
+			fprintf(stderr, "sim: invalid pcap record (%u bytes)\n", hdr[2]);
+			close(f_rx);
+			f_rx = -1;
+			return;
+		}
+		if (in_len < (sizeof(hdr) + hdr[2]))
+			break;
+		_queue(in_buf + sizeof(hdr), hdr[2]);
+		in_len -= (uint)sizeof(hdr) + hdr[2];
+		memmove(in_buf, in_buf + sizeof(hdr) + hdr[2], in_len);
+	}
+}
+
+/**
+ * @brief Add a frame to the receive queue, if accepted by the filter
+ *
+ * @param data Pointer to the frame
+ * @param len  Length of the frame (without FCS)
+ */
+static void _queue(const u8 *data, u32 len)
+{
+	sim_frame *f;
+
+	if ((len < 14) || (q_count == QUEUE_LEN) || ! _accept(data))
+		return;
+	f = &queue[(q_head + q_count) % QUEUE_LEN];
+	memcpy(f->data, data, len);
+	f->len = len;
+	q_count++;
+}
+
+/**
+ * @brief Destination address filter (MACPFR, MACA0HR/LR)
+ *
+ * @param data Pointer to the frame
+ * @return integer Non-zero if the frame is accepted
+ */
+static int _accept(const u8 *data)
+{
+	u32 pfr = REG(0x0008);
+	u8  mac[6];
+
+	// PR : promiscuous
+	if (pfr & (1 << 0))
+		return(1);
+	// Group address : broadcast unless DBF, multicast with PM
+	if (data[0] & 1)
+	{
+		if (memcmp(data, "\xFF\xFF\xFF\xFF\xFF\xFF", 6) == 0)
+			return ((pfr & (1 << 5)) == 0);
+		return ((pfr & (1 << 4)) != 0);
+	}
+	mac[0] = (u8)(REG(0x0304) >>  0);
+	mac[1] = (u8)(REG(0x0304) >>  8);
+	mac[2] = (u8)(REG(0x0304) >> 16);
+	mac[3] = (u8)(REG(0x0304) >> 24);
+	mac[4] = (u8)(REG(0x0300) >>  0);
+	mac[5] = (u8)(REG(0x0300) >>  8);
+	return (memcmp(data, mac, 6) == 0);
+}
+
+/**
+ * @brief Append a transmitted frame to the output pcap file
+ *
+ * @param data Pointer to the frame
+ * @param len  Length of the frame
+ */
+static void _pcap_write(const u8 *data, u32 len)
+{
+	struct timeval tv;
+	u32 hdr[4];
+
+	if (f_tx == 0)
+		return;
+	gettimeofday(&tv, 0);
+	hdr[0] = (u32)tv.tv_sec;
+	hdr[1] = (u32)tv.tv_usec;
+	hdr[2] = hdr[3] = len;
+	fwrite(hdr, sizeof(hdr), 1, f_tx);
+	fwrite(data, len, 1, f_tx);
+	fflush(f_tx);
+}
+
+/**
+ * @brief Insert IPv4 header and TCP/UDP/ICMP checksums (TDES3.CIC)
+ *
+ * @param f   Pointer to the frame
+ * @param len Length of the frame
+ */
+static void _csum_insert(u8 *f, u32 len)
+{
+	u8  *ip = f + 14;
+	u32  ihl, tot, off;
+	u16  sum;
+
+	if ((len < 34) || (f[12] != 0x08) || (f[13] != 0x00))
+		return;
+	ihl = (u32)(ip[0] & 0x0F) * 4;
+	tot = ((u32)ip[2] << 8) | ip[3];
+	if ((ihl < 20) || (tot < ihl) || ((14 + tot) > len))
+		return;
+	ip[10] = ip[11] = 0;
+	sum = _csum(ip, ihl, 0);
+	ip[10] = (u8)(sum >> 8);
+	ip[11] = (u8)sum;
+
+	switch (ip[9])
+	{
+		case 1:  off = 2;  break; // ICMP
+		case 6:  off = 16; break; // TCP
+		case 17: off = 6;  break; // UDP
+		default: return;
+	}
+	if ((tot - ihl) < (off + 2))
+		return;
+	ip[ihl + off] = ip[ihl + off + 1] = 0;
+	sum = _csum(ip + ihl, tot - ihl, (ip[9] == 1) ? 0 : _pseudo(ip, tot - ihl));
+	if ((ip[9] == 17) && (sum == 0))
+		sum = 0xFFFF;
+	ip[ihl + off]     = (u8)(sum >> 8);
+	ip[ihl + off + 1] = (u8)sum;
+}
+
+/**
+ * @brief Verify checksums of a received frame
+ *
+ * @param f   Pointer to the frame
+ * @param len Length of the frame
+ * @return u32 Value of RDES1 (IPV4, IPHE, IPCE and payload type)
+ */
+static u32 _csum_check(const u8 *f, u32 len)
+{
+	const u8 *ip = f + 14;
+	u32 ihl, tot, st;
+
+	if ((len < 34) || (f[12] != 0x08) || (f[13] != 0x00))
+		return(0);
+	st  = ETH_RDES1_IPV4;
+	ihl = (u32)(ip[0] & 0x0F) * 4;
+	tot = ((u32)ip[2] << 8) | ip[3];
+	if ((ihl < 20) || (tot < ihl) || ((14 + tot) > len) || _csum(ip, ihl, 0))
+		return(st | ETH_RDES1_IPHE);
+
+	switch (ip[9])
+	{
+		case 1:
+			st |= 3;
+			if (_csum(ip + ihl, tot - ihl, 0))
+				st |= ETH_RDES1_IPCE;
+			break;
+		case 6:
+			st |= 2;
+			if (_csum(ip + ihl, tot - ihl, _pseudo(ip, tot - ihl)))
+				st |= ETH_RDES1_IPCE;
+			break;
+		case 17:
+			st |= 1;
+			// A null UDP checksum is not verified
+			if (((ip[ihl + 6] | ip[ihl + 7]) != 0) &&
+			    _csum(ip + ihl, tot - ihl, _pseudo(ip, tot - ihl)))
+				st |= ETH_RDES1_IPCE;
+			break;
+	}
+	return(st);
+}
+
+/**
+ * @brief Compute an internet checksum (RFC 1071)
+ *
+ * @param data Pointer to the data
+ * @param len  Length of the data
+ * @param sum  Initial sum (pseudo header)
+ * @return u16 Checksum, 0 when verifying valid data
+ */
+static u16 _csum(const u8 *data, u32 len, u32 sum)
+{
+	u32 i;
+
+	for (i = 0; (i + 1) < len; i += 2)
+		sum += ((u32)data[i] << 8) | data[i + 1];
+	if (len & 1)
+		sum += (u32)data[len - 1] << 8;
+	while (sum >> 16)
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	return (u16)~sum;
+}
+
+/**
+ * @brief Sum of the TCP/UDP pseudo header
+ *
+ * @param ip  Pointer to the IPv4 header
+ * @param len Length of the payload
+ * @return u32 Partial sum
+ */
+static u32 _pseudo(const u8 *ip, u32 len)
+{
+	u32 sum = 0;
+	uint i;
+
+	for (i = 12; i < 20; i += 2)
+		sum += ((u32)ip[i] << 8) | ip[i + 1];
+	return(sum + ip[9] + len);
+}
+/* EOF */
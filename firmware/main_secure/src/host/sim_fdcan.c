@@ -0,0 +1,451 @@
+/**
+ * @file  host/sim_fdcan.c
+ * @brief Host model of FDCAN1 and its acceptance filters
+ *
+ * The model evaluates the filter elements of the message RAM like the
+ * controller : the list of standard or extended filters is scanned in
+ * order, the first matching element gives the action, messages that match
+ * no element follow the global filter (RXGFC). Accepted messages are
+ * written into the Rx FIFO elements of the message RAM, and the interrupt
+ * line selected by ILS is raised.
+ *
+ * Messages of the bus are given to the model with sim_fdcan_rx(). Sent
+ * messages are received back when the internal loopback is enabled
+ * (TEST.LBCK), and written in the candump log format to the file given by
+ * the SIM_CAN_TX environment variable. Bit timing is not modeled, a
+ * message is sent as soon as it is requested.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "hardware.h"
+#include "driver/fdcan.h"
+#include "host/sim.h"
+
+#define FDCAN_IT0_IRQ 39
+#define REG(off)      regs[(off) >> 2]
+#define RAM(off)      ram[(off) >> 2]
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+static void _rst(sim_periph *p);
+static u32  _ram_rd(sim_periph *p, u32 offset, uint size);
+static void _ram_wr(sim_periph *p, u32 offset, u32 value, uint size);
+static int  _filter(u32 id, int xtd, uint *index);
+static int  _match(uint type, u32 id, u32 id1, u32 id2);
+static int  _receive(u32 r0, u32 r1, const u32 *data);
+static void _irq(void);
+static void _tx(uint index);
+
+static u32 regs[0x400 / 4];
+static u32 ram[FDCAN_RAM_SIZE / 4];
+// Rx FIFOs : get index and fill level
+static uint rx_get[2], rx_fill[2];
+static uint tx_put;
+static FILE *f_tx;
+
+static sim_periph fdcan_model =
+{
+	.name  = "FDCAN1",
+	.base  = FDCAN1_NS,
+	.size  = 0x400,
+	.rd    = _rd,
+	.wr    = _wr,
+	.reset = _rst,
+};
+
+static sim_periph sramcan_model =
+{
+	.name  = "SRAMCAN",
+	.base  = SRAMCAN_NS,
+	.size  = FDCAN_RAM_SIZE,
+	.rd    = _ram_rd,
+	.wr    = _ram_wr,
+};
+
+/**
+ * @brief Attach the FDCAN model and its message RAM to the bus
+ *
+ */
+void sim_fdcan_init(void)
+{
+	const char *name;
+
+	name = getenv("SIM_CAN_TX");
+	if (name)
+	{
+		f_tx = fopen(name, "w");
+		if (f_tx == 0)
+			fprintf(stderr, "sim: can not open %s\n", name);
+	}
+	memset(ram, 0, sizeof(ram));
+	_rst(&fdcan_model);
+	sim_attach(&fdcan_model);
+	sim_attach(&sramcan_model);
+}
+
+/**
+ * @brief Receive a message from the bus
+ *
+ * The message is filtered and stored like by the controller (only when
+ * the controller is on the bus, CCCR.INIT cleared).
+ *
+ * @param id   Identifier of the message (11 or 29 bits)
+ * @param xtd  Non-zero for an extended identifier
+ * @param fd   Non-zero for an FD frame with bit rate switching
+ * @param data Pointer to the data (may be NULL if len is 0)
+ * @param len  Length of data (0 to 64 bytes, 8 for a classic frame)
+ * @return integer FIFO that received the message (0 or 1), -1 if the
+ *                 message has been rejected, -2 if lost (FIFO full)
+ */
+int sim_fdcan_rx(u32 id, int xtd, int fd, const u8 *data, uint len)
+{
+	static const u8 dlc_len[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+	u32  words[16];
+	u32  r0, r1;
+	uint dlc;
+
+	if ((REG(0x18) & FDCAN_CCCR_INIT) || (len > (fd ? 64u : 8u)))
+		return(-1);
+	for (dlc = 0; (dlc < 15) && (dlc_len[dlc] < len); dlc++)
+		;
+	memset(words, 0, sizeof(words));
+	if (len)
+		memcpy(words, data, len);
+
+	r0 = xtd ? (FDCAN_E0_XTD | (id & 0x1FFFFFFF)) : ((id & 0x7FF) << 18);
+	r1 = (u32)dlc << 16;
+	if (fd)
+		r1 |= FDCAN_E1_FDF | FDCAN_E1_BRS;
+	return _receive(r0, r1, words);
+}
+
+/**
+ * @brief Read a register of the controller
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	uint i;
+	(void)p; (void)size;
+
+	// RXF0S, RXF1S : fill level, get and put indexes, full
+	if ((offset == 0x90) || (offset == 0x98))
+	{
+		i = (offset == 0x98);
+		return (rx_fill[i]) | (rx_get[i] << 8) |
+		       (((rx_get[i] + rx_fill[i]) % FDCAN_FIFO_LEN) << 16) |
+		       ((rx_fill[i] == FDCAN_FIFO_LEN) ? (1u << 24) : 0);
+	}
+	// TXFQS : messages are sent immediately, all buffers are free
+	if (offset == 0xC4)
+		return FDCAN_FIFO_LEN | (tx_put << 16);
+	return REG(offset);
+}
+
+/**
+ * @brief Write a register of the controller
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	u32  cccr = REG(0x18);
+	uint i;
+	(void)p; (void)size;
+
+	switch (offset)
+	{
+		// CCCR : CCE needs INIT, it is cleared with it
+		case 0x18:
+			if (((value & FDCAN_CCCR_INIT) == 0) || ((cccr & FDCAN_CCCR_INIT) == 0))
+				value &= ~(u32)FDCAN_CCCR_CCE;
+			REG(0x18) = value;
+			break;
+		// Protected registers, writable in configuration mode only
+		case 0x0C: case 0x10: case 0x1C: case 0x48:
+		case 0x80: case 0x84: case 0xC0: case 0x100:
+			if ((cccr & (FDCAN_CCCR_INIT | FDCAN_CCCR_CCE)) ==
+			    (FDCAN_CCCR_INIT | FDCAN_CCCR_CCE))
+				REG(offset) = value;
+			break;
+		// IR : flags are cleared by writing 1
+		case 0x50:
+			REG(0x50) &= ~value;
+			break;
+		// RXF0A, RXF1A : acknowledge of the element at the get index
+		case 0x94:
+		case 0x9C:
+			i = (offset == 0x9C);
+			if (rx_fill[i] && (value == rx_get[i]))
+			{
+				rx_get[i] = (rx_get[i] + 1) % FDCAN_FIFO_LEN;
+				rx_fill[i]--;
+			}
+			break;
+		// TXBAR : transmission requests
+		case 0xCC:
+			if (cccr & FDCAN_CCCR_INIT)
+				break;
+			for (i = 0; i < FDCAN_FIFO_LEN; i++)
+				if (value & (1u << i))
+					_tx(i);
+			break;
+		default:
+			if (offset < sizeof(regs))
+				REG(offset) = value;
+			break;
+	}
+	_irq();
+}
+
+/**
+ * @brief Reset of the controller : configuration mode, empty FIFOs
+ */
+static void _rst(sim_periph *p)
+{
+	(void)p;
+
+	memset(regs, 0, sizeof(regs));
+	REG(0x18) = FDCAN_CCCR_INIT;
+	REG(0x0C) = 0x00000A33; // DBTP
+	REG(0x1C) = 0x06000A03; // NBTP
+	REG(0x84) = 0x1FFFFFFF; // XIDAM
+	rx_get[0] = rx_get[1] = 0;
+	rx_fill[0] = rx_fill[1] = 0;
+	tx_put = 0;
+}
+
+/**
+ * @brief Read a word of the message RAM
+ */
+static u32 _ram_rd(sim_periph *p, u32 offset, uint size)
+{
+	(void)p; (void)size;
+	return RAM(offset & ~3u);
+}
+
+/**
+ * @brief Write a word of the message RAM
+ */
+static void _ram_wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	(void)p; (void)size;
+	RAM(offset & ~3u) = value;
+}
+
+/**
+ * @brief Filter engine : find the action for an identifier
+ *
+ * @param id    Identifier of the message
+ * @param xtd   Non-zero for an extended identifier
+ * @param index Filled with the index of the matching element
+ * @return integer Action (FDCAN_FIFO0 ...), 0 if no element matches
+ */
+static int _filter(u32 id, int xtd, uint *index)
+{
+	u32  rxgfc = REG(0x80);
+	u32  f0, f1;
+	uint count, i;
+
+	if (xtd)
+	{
+		count = (rxgfc >> 24) & 0xF;
+		for (i = 0; (i < count) && (i < FDCAN_EXT_MAX); i++)
+		{
+			f0 = RAM(FDCAN_RAM_FLE + (i * 8));
+			f1 = RAM(FDCAN_RAM_FLE + (i * 8) + 4);
+			// EFEC = 0 : element disabled
+			if ((f0 >> 29) == 0)
+				continue;
+			// EFT = 3 : range without the XIDAM mask
+			if ((f1 >> 30) == 3)
+			{
+				if (_match(FDCAN_RANGE, id, f0 & 0x1FFFFFFF, f1 & 0x1FFFFFFF) == 0)
+					continue;
+			}
+			else if (_match(f1 >> 30, id & REG(0x84), f0 & 0x1FFFFFFF, f1 & 0x1FFFFFFF) == 0)
+				continue;
+			*index = i;
+			return (int)(f0 >> 29);
+		}
+	}
+	else
+	{
+		count = (rxgfc >> 16) & 0x1F;
+		for (i = 0; (i < count) && (i < FDCAN_STD_MAX); i++)
+		{
+			f0 = RAM(FDCAN_RAM_FLS + (i * 4));
+			// SFT = 3 or SFEC = 0 : element disabled
+			if (((f0 >> 30) == 3) || (((f0 >> 27) & 7) == 0))
+				continue;
+			if (_match(f0 >> 30, id, (f0 >> 16) & 0x7FF, f0 & 0x7FF) == 0)
+				continue;
+			*index = i;
+			return (int)((f0 >> 27) & 7);
+		}
+	}
+	return(0);
+}
+
+/**
+ * @brief Test an identifier against one filter element
+ *
+ * @param type Filter type (FDCAN_RANGE, FDCAN_DUAL or FDCAN_MASK)
+ * @param id   Identifier of the message
+ * @param id1  First identifier of the element
+ * @param id2  Second identifier (or mask) of the element
+ * @return integer Non-zero if the identifier matches
+ */
+static int _match(uint type, u32 id, u32 id1, u32 id2)
+{
+	switch (type)
+	{
+		case FDCAN_RANGE: return (id >= id1) && (id <= id2);
+		case FDCAN_DUAL:  return (id == id1) || (id == id2);
+		case FDCAN_MASK:  return (id & id2) == (id1 & id2);
+	}
+	return(0);
+}
+
+/**
+ * @brief Filter a message and store it into an Rx FIFO
+ *
+ * @param r0   First header word (identifier)
+ * @param r1   Second header word (DLC, FDF, BRS)
+ * @param data Data words (16)
+ * @return integer FIFO that received the message, -1 if rejected, -2 if lost
+ */
+static int _receive(u32 r0, u32 r1, const u32 *data)
+{
+	u32  rxgfc = REG(0x80);
+	uint index = 0, fifo, elem;
+	int  xtd = (r0 & FDCAN_E0_XTD) != 0;
+	int  action;
+	u32  id;
+
+	id = xtd ? (r0 & 0x1FFFFFFF) : ((r0 >> 18) & 0x7FF);
+	if (r0 & FDCAN_E0_RTR)
+	{
+		// Remote frames : RRFE / RRFS
+		if (rxgfc & (xtd ? (1u << 0) : (1u << 1)))
+			return(-1);
+	}
+	action = _filter(id, xtd, &index);
+	if (action == 0)
+	{
+		// Non-matching frames : ANFE / ANFS (0 FIFO0, 1 FIFO1, else reject)
+		action = (int)((rxgfc >> (xtd ? 2 : 4)) & 3) + 1;
+		r1 |= FDCAN_R1_ANMF;
+	}
+	else
+		r1 |= (u32)index << 24;
+
+	switch (action)
+	{
+		case FDCAN_FIFO0: case FDCAN_PRIO_FIFO0: fifo = 0; break;
+		case FDCAN_FIFO1: case FDCAN_PRIO_FIFO1: fifo = 1; break;
+		default: return(-1);
+	}
+	// High priority message : HPMS and IR.HPM
+	if ((action == FDCAN_PRIO_FIFO0) || (action == FDCAN_PRIO_FIFO1))
+	{
+		REG(0x88) = (index << 8) | ((fifo + 2) << 6) | (xtd ? (1u << 15) : 0);
+		REG(0x50) |= (1u << 6);
+	}
+
+	// FIFO full : the message is lost (blocking mode, overwrite is not modeled)
+	if (rx_fill[fifo] == FDCAN_FIFO_LEN)
+	{
+		REG(0x50) |= fifo ? FDCAN_IR_RF1L : FDCAN_IR_RF0L;
+		_irq();
+		return(-2);
+	}
+	elem = (fifo ? FDCAN_RAM_F1 : FDCAN_RAM_F0) +
+	       (((rx_get[fifo] + rx_fill[fifo]) % FDCAN_FIFO_LEN) * FDCAN_ELEM);
+	RAM(elem + 0) = r0;
+	RAM(elem + 4) = r1;
+	memcpy(&RAM(elem + 8), data, 64);
+	rx_fill[fifo]++;
+	REG(0x50) |= fifo ? FDCAN_IR_RF1N : FDCAN_IR_RF0N;
+	_irq();
+	return (int)fifo;
+}
+
+/**
+ * @brief Raise the interrupt lines with pending and enabled flags
+ *
+ * IR bits are mapped to the groups of ILS : RXFIFO0 (0-2), RXFIFO1 (3-5),
+ * SMSG (6-8), TFERR (9-12), MISC (13-15), BERR (16-17), PERR (18-23).
+ */
+static void _irq(void)
+{
+	static const u8 group_first[8] = { 0, 3, 6, 9, 13, 16, 18, 24 };
+	u32  pending = REG(0x50) & REG(0x54);
+	u32  lines = 0;
+	uint g;
+
+	for (g = 0; g < 7; g++)
+	{
+		u32 mask = ((1u << group_first[g + 1]) - 1) & ~((1u << group_first[g]) - 1);
+		if (pending & mask)
+			lines |= (REG(0x58) & (1u << g)) ? 2 : 1;
+	}
+	lines &= REG(0x5C);
+	if (lines & 1)
+		sim_irq(FDCAN_IT0_IRQ);
+	if (lines & 2)
+		sim_irq(FDCAN_IT0_IRQ + 1);
+}
+
+/**
+ * @brief Send the message of a Tx buffer
+ *
+ * @param index Index of the Tx buffer
+ */
+static void _tx(uint index)
+{
+	static const u8 dlc_len[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+	u32  elem = FDCAN_RAM_TB + (index * FDCAN_ELEM);
+	u32  t0 = RAM(elem), t1 = RAM(elem + 4);
+	const u8 *data = (const u8 *)&RAM(elem + 8);
+	struct timeval tv;
+	uint len, i;
+
+	tx_put = (index + 1) % FDCAN_FIFO_LEN;
+	len = dlc_len[(t1 >> 16) & 0xF];
+	if (((t1 & FDCAN_E1_FDF) == 0) && (len > 8))
+		len = 8;
+
+	if (f_tx)
+	{
+		gettimeofday(&tv, 0);
+		fprintf(f_tx, "(%ld.%06ld) can0 ", (long)tv.tv_sec, (long)tv.tv_usec);
+		if (t0 & FDCAN_E0_XTD)
+			fprintf(f_tx, "%08X", t0 & 0x1FFFFFFF);
+		else
+			fprintf(f_tx, "%03X", (t0 >> 18) & 0x7FF);
+		if (t1 & FDCAN_E1_FDF)
+			fprintf(f_tx, "##%X", (t1 & FDCAN_E1_BRS) ? 1 : 0);
+		else
+			fprintf(f_tx, "#");
+		for (i = 0; i < len; i++)
+			fprintf(f_tx, "%02X", data[i]);
+		fprintf(f_tx, "\n");
+		fflush(f_tx);
+	}
+
+	// Internal loopback : the message goes through the filters
+	if ((REG(0x18) & FDCAN_CCCR_TEST) && (REG(0x10) & FDCAN_TEST_LBCK))
+		_receive(t0 & ~(1u << 31), t1 & (FDCAN_E1_FDF | FDCAN_E1_BRS | (0xFu << 16)), &RAM(elem + 8));
+}
+/* EOF */
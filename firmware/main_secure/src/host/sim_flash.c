@@ -0,0 +1,334 @@
+/**
+ * @file  host/sim_flash.c
+ * @brief Host model of the embedded flash (memory, controller and option bytes)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "driver/flash.h"
+#include "hardware.h"
+#include "host/sim.h"
+
+#define FLASH_SIZE (2 * FLASH_BANK_SIZE)
+
+#define R(offset) regs[(offset) >> 2]
+
+static u32  _mem_rd(sim_periph *p, u32 offset, uint size);
+static void _mem_wr(sim_periph *p, u32 offset, u32 value, uint size);
+static u32  _reg_rd(sim_periph *p, u32 offset, uint size);
+static void _reg_wr(sim_periph *p, u32 offset, u32 value, uint size);
+static void _reset(sim_periph *p);
+static void _erase(u32 cr);
+static u32  _phys(u32 offset);
+static void _error(u32 flag);
+
+/* Option bytes saved after memory content into the SIM_FLASH file */
+static const u32 opt_regs[] =
+{
+	FLASH_OPTSR_CUR(0), FLASH_OPTSR2_CUR(0),
+	FLASH_SECWM1R_CUR(0), FLASH_SECWM2R_CUR(0)
+};
+
+static u8   mem[FLASH_SIZE];
+static u32  regs[0x400 / 4];
+static u8   qw[FLASH_QW_SIZE];
+static u32  qw_addr;
+static uint qw_count;
+static int  key_ns, key_sec, key_opt;
+static const char *mem_file;
+
+static sim_periph mem_model =
+{
+	.name  = "FLASH-MEM",
+	.base  = FLASH_BASE_NS,
+	.size  = FLASH_SIZE,
+	.rd    = _mem_rd,
+	.wr    = _mem_wr,
+	.reset = _reset,
+};
+
+static sim_periph reg_model =
+{
+	.name = "FLASH",
+	.base = FLASH_NS,
+	.size = 0x400,
+	.rd   = _reg_rd,
+	.wr   = _reg_wr,
+};
+
+/**
+ * @brief Attach the flash model to the bus
+ *
+ * If the SIM_FLASH environment variable is set, the content of the flash
+ * (and current option bytes) is loaded from (and saved to) this file.
+ */
+void sim_flash_init(void)
+{
+	FILE *f;
+	uint  i;
+
+	memset(mem, 0xFF, sizeof(mem));
+	memset(regs, 0, sizeof(regs));
+	R(FLASH_NSCR(0)) = (1 << 0);      // NSCR locked
+	R(FLASH_SECCR(0)) = (1 << 0);      // SECCR locked
+	R(FLASH_OPTCR(0)) = (1 << 0);      // OPTCR locked
+	R(FLASH_OPTSR_CUR(0)) = (0xED << 8);   // OPTSR : product state OPEN
+	R(FLASH_OPTSR_PRG(0)) = R(FLASH_OPTSR_CUR(0));
+	R(FLASH_OPTSR2_CUR(0)) = (0xB4u << 24); // OPTSR2 : TrustZone enabled
+	R(FLASH_OPTSR2_PRG(0)) = R(FLASH_OPTSR2_CUR(0));
+	R(FLASH_SECWM1R_CUR(0)) = (7 << 16);     // SECWM1 : sectors 0-7 secure
+	R(FLASH_SECWM1R_PRG(0)) = R(FLASH_SECWM1R_CUR(0));
+	R(FLASH_SECWM2R_CUR(0)) = (7 << 16);     // SECWM2 : sectors 0-7 secure
+	R(FLASH_SECWM2R_PRG(0)) = R(FLASH_SECWM2R_CUR(0));
+
+	mem_file = getenv("SIM_FLASH");
+	if (mem_file)
+	{
+		f = fopen(mem_file, "rb");
+		if (f)
+		{
+			if (fread(mem, 1, sizeof(mem), f) == 0)
+				fprintf(stderr, "sim: %s is empty\n", mem_file);
+			for (i = 0; i < (sizeof(opt_regs) / sizeof(u32)); i++)
+			{
+				if (fread(&R(opt_regs[i]), sizeof(u32), 1, f) != 1)
+					break;
+				R(opt_regs[i] + 4) = R(opt_regs[i]);
+			}
+			fclose(f);
+		}
+		atexit(sim_flash_save);
+	}
+
+	sim_attach(&mem_model);
+	sim_attach(&reg_model);
+}
+
+/**
+ * @brief Save flash content to file (if SIM_FLASH is set)
+ *
+ */
+void sim_flash_save(void)
+{
+	FILE *f;
+	uint  i;
+
+	if (mem_file == 0)
+		return;
+	f = fopen(mem_file, "wb");
+	if (f == 0)
+		return;
+	fwrite(mem, 1, sizeof(mem), f);
+	for (i = 0; i < (sizeof(opt_regs) / sizeof(u32)); i++)
+		fwrite(&R(opt_regs[i]), sizeof(u32), 1, f);
+	fclose(f);
+}
+
+/**
+ * @brief Read flash memory (bank swap applied)
+ */
+static u32 _mem_rd(sim_periph *p, u32 offset, uint size)
+{
+	u32  v = 0;
+	uint i;
+	(void)p;
+
+	for (i = 0; i < size; i++)
+		v |= (u32)mem[_phys(offset + i)] << (8 * i);
+	return(v);
+}
+
+/**
+ * @brief Write flash memory, data are programmed by quad-words
+ */
+static void _mem_wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	u32  phys;
+	uint i;
+	(void)p;
+
+	if (((R(FLASH_NSCR(0)) | R(FLASH_SECCR(0))) & (1 << 1)) == 0)
+	{
+		_error(1 << 18); // PGSERR : PG not set
+		return;
+	}
+	if (qw_count == 0)
+		qw_addr = offset & ~(u32)(FLASH_QW_SIZE - 1);
+	if ((offset & ~(u32)(FLASH_QW_SIZE - 1)) != qw_addr)
+	{
+		_error(1 << 20); // INCERR : inconsistent quad-word
+		qw_count = 0;
+		return;
+	}
+	for (i = 0; i < size; i++)
+		qw[(offset + i) & (FLASH_QW_SIZE - 1)] = (u8)(value >> (8 * i));
+	qw_count += size;
+	if (qw_count < FLASH_QW_SIZE)
+		return;
+	qw_count = 0;
+
+	// Only an erased quad-word can be programmed (ECC)
+	phys = _phys(qw_addr);
+	for (i = 0; i < FLASH_QW_SIZE; i++)
+	{
+		if (mem[phys + i] != 0xFF)
+		{
+			_error(1 << 18);
+			return;
+		}
+	}
+	memcpy(&mem[phys], qw, FLASH_QW_SIZE);
+	R(FLASH_NSSR(0)) |= (1 << 16); // EOP
+}
+
+/**
+ * @brief Read a register of the flash controller
+ */
+static u32 _reg_rd(sim_periph *p, u32 offset, uint size)
+{
+	(void)p; (void)size;
+	return R(offset);
+}
+
+/**
+ * @brief Write a register of the flash controller
+ */
+static void _reg_wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	(void)p; (void)size;
+
+	switch (offset)
+	{
+		case FLASH_NSKEYR(0):
+		case FLASH_SECKEYR(0):
+		{
+			int *stage = (offset == FLASH_NSKEYR(0)) ? &key_ns : &key_sec;
+			u32  cr    = (offset == FLASH_NSKEYR(0)) ? FLASH_NSCR(0) : FLASH_SECCR(0);
+			if ((*stage == 0) && (value == 0x45670123))
+				*stage = 1;
+			else if ((*stage == 1) && (value == 0xCDEF89AB))
+			{
+				R(cr) &= ~(u32)(1 << 0);
+				*stage = 0;
+			}
+			else
+				*stage = 0;
+			break;
+		}
+		case FLASH_OPTKEYR(0):
+			if ((key_opt == 0) && (value == 0x08192A3B))
+				key_opt = 1;
+			else if ((key_opt == 1) && (value == 0x4C5D6E7F))
+			{
+				R(FLASH_OPTCR(0)) &= ~(u32)(1 << 0);
+				key_opt = 0;
+			}
+			else
+				key_opt = 0;
+			break;
+		case FLASH_OPTCR(0):
+			if (R(FLASH_OPTCR(0)) & (1 << 0))
+				break;
+			if (value & (1 << 1))
+			{
+				// OPTSTRT : SWAP_BANK is applied on next reset
+				R(FLASH_OPTSR_CUR(0)) = (R(FLASH_OPTSR_PRG(0)) & 0x7FFFFFFF) | (R(FLASH_OPTSR_CUR(0)) & 0x80000000);
+				R(FLASH_OPTSR2_CUR(0)) = R(FLASH_OPTSR2_PRG(0));
+				R(FLASH_SECWM1R_CUR(0)) = R(FLASH_SECWM1R_PRG(0));
+				R(FLASH_SECWM2R_CUR(0)) = R(FLASH_SECWM2R_PRG(0));
+			}
+			R(FLASH_OPTCR(0)) = value & ~(u32)(1 << 1);
+			break;
+		case FLASH_NSCR(0):
+		case FLASH_SECCR(0):
+			if (R(offset) & (1 << 0))
+				break;
+			if ((value & (1 << 2)) && (value & (1 << 5)))
+			{
+				_erase(value);
+				value &= ~(u32)(1 << 5);
+			}
+			R(offset) = value;
+			break;
+		case FLASH_NSCCR(0):
+		case FLASH_SECCCR(0):
+			R(offset - 0x10) &= ~value;
+			break;
+		// Status registers are read only
+		case FLASH_NSSR(0):
+		case FLASH_SECSR(0):
+		case FLASH_OPTSR_CUR(0):
+		case FLASH_OPTSR2_CUR(0):
+		case FLASH_SECWM1R_CUR(0):
+		case FLASH_SECWM2R_CUR(0):
+			break;
+		default:
+			R(offset) = value;
+			break;
+	}
+}
+
+/**
+ * @brief Reset of the flash model (apply pending bank swap)
+ */
+static void _reset(sim_periph *p)
+{
+	(void)p;
+
+	R(FLASH_OPTSR_CUR(0)) = (R(FLASH_OPTSR_CUR(0)) & 0x7FFFFFFF) | (R(FLASH_OPTSR_PRG(0)) & 0x80000000);
+	R(FLASH_NSCR(0)) = (1 << 0);
+	R(FLASH_SECCR(0)) = (1 << 0);
+	R(FLASH_OPTCR(0)) = (1 << 0);
+	qw_count = 0;
+	sim_flash_save();
+}
+
+/**
+ * @brief Erase one sector
+ *
+ * @param cr Value written into control register (SNB and BKSEL)
+ */
+static void _erase(u32 cr)
+{
+	u32 sect = (cr >> 6) & 0x7F;
+	u32 bank = (cr >> 31) & 1;
+
+	memset(&mem[(bank * FLASH_BANK_SIZE) + (sect * FLASH_SECT_SIZE)], 0xFF, FLASH_SECT_SIZE);
+	R(FLASH_NSSR(0)) |= (1 << 16); // EOP
+}
+
+/**
+ * @brief Convert an offset into flash address space to physical offset
+ *
+ * @param offset Offset from start of flash
+ * @return u32 Offset into physical memory
+ */
+static u32 _phys(u32 offset)
+{
+	if (R(FLASH_OPTSR_CUR(0)) & 0x80000000)
+		return (offset ^ FLASH_BANK_SIZE);
+	return(offset);
+}
+
+/**
+ * @brief Report an error into both status registers
+ *
+ * @param flag Error flag
+ */
+static void _error(u32 flag)
+{
+	R(FLASH_NSSR(0)) |= flag;
+	R(FLASH_SECSR(0)) |= flag;
+}
+/* EOF */
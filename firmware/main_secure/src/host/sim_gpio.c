@@ -0,0 +1,132 @@
+/**
+ * @file  host/sim_gpio.c
+ * @brief Host model of GPIO ports A to I
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "host/sim.h"
+
+#define PORTS 9
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+static void _reset_port(uint port);
+
+static u32 regs[PORTS][0x400 / 4];
+
+static sim_periph gpio_model =
+{
+	.name = "GPIO",
+	.base = GPIOA_NS,
+	.size = 0x400 * PORTS,
+	.rd   = _rd,
+	.wr   = _wr,
+};
+
+/**
+ * @brief Attach the GPIO model to the bus
+ *
+ */
+void sim_gpio_init(void)
+{
+	uint i;
+
+	for (i = 0; i < PORTS; i++)
+		_reset_port(i);
+	sim_attach(&gpio_model);
+}
+
+/**
+ * @brief Get the output data register of a port
+ *
+ * Elapsed timer events are processed first, so outputs written by DMA
+ * are up to date.
+ *
+ * @param port Index of the port (0 for GPIOA)
+ * @return u32 Value of ODR
+ */
+u32 sim_gpio_odr(uint port)
+{
+	// Outputs may be driven by timer paced DMA
+	sim_tim_poll();
+	return regs[port][0x14 >> 2];
+}
+
+/**
+ * @brief Read a register of the GPIO ports
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	uint port = offset / 0x400;
+	(void)p; (void)size;
+
+	offset %= 0x400;
+	switch (offset)
+	{
+		case 0x10: // IDR : outputs are read back
+			return regs[port][0x14 >> 2];
+		case 0x18: // BSRR (write only)
+		case 0x28: // BRR  (write only)
+			return(0);
+		default:
+			return regs[port][offset >> 2];
+	}
+}
+
+/**
+ * @brief Write a register of the GPIO ports
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	uint port = offset / 0x400;
+	u32 *odr;
+	(void)p; (void)size;
+
+	offset %= 0x400;
+	odr = &regs[port][0x14 >> 2];
+	switch (offset)
+	{
+		case 0x18: // BSRR : reset has priority
+			*odr |=  (value & 0xFFFF);
+			*odr &= ~(value >> 16);
+			break;
+		case 0x28: // BRR
+			*odr &= ~(value & 0xFFFF);
+			break;
+		case 0x3FC: // Private : reset of the port (from RCC model)
+			_reset_port(port);
+			break;
+		default:
+			regs[port][offset >> 2] = value;
+			break;
+	}
+}
+
+/**
+ * @brief Load reset values of a port
+ *
+ * @param port Index of the port
+ */
+static void _reset_port(uint port)
+{
+	uint i;
+
+	for (i = 0; i < (0x400 / 4); i++)
+		regs[port][i] = 0;
+	regs[port][0] = 0xFFFFFFFF; // MODER : analog mode
+	if (port == 0)
+		regs[port][0] = 0xABFFFFFF;
+	if (port == 1)
+		regs[port][0] = 0xFFFFFEBF;
+}
+/* EOF */
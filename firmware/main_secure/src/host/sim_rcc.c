@@ -0,0 +1,83 @@
+/**
+ * @file  host/sim_rcc.c
+ * @brief Host model of the reset and clock controller
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "host/sim.h"
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+
+static u32 regs[0x400 / 4];
+
+static sim_periph rcc_model =
+{
+	.name = "RCC",
+	.base = RCC_NS,
+	.size = 0x400,
+	.rd   = _rd,
+	.wr   = _wr,
+};
+
+/**
+ * @brief Attach the RCC model to the bus
+ *
+ */
+void sim_rcc_init(void)
+{
+	sim_attach(&rcc_model);
+}
+
+/**
+ * @brief Read a register of the RCC
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	(void)p; (void)size;
+	return regs[offset >> 2];
+}
+
+/**
+ * @brief Write a register of the RCC
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	uint i;
+	(void)p; (void)size;
+
+	// AHB2RSTR : reset of GPIO ports
+	if (offset == 0x64)
+	{
+		for (i = 0; i < 9; i++)
+			if (value & (1u << i))
+				sim_wr(GPIOA_NS + (0x400 * i) + 0x3FC, 0, 4);
+	}
+	// CR : PLLs lock and HSI48 is ready immediately (RDY follows ON)
+	if (offset == 0x00)
+	{
+		value &= ~((1u << 13) | (1u << 25) | (1u << 27) | (1u << 29));
+		value |= (value & ((1u << 12) | (1u << 24) | (1u << 26) | (1u << 28))) << 1;
+	}
+	// BDCR : oscillators of the backup domain are ready immediately
+	if (offset == 0xF0)
+	{
+		value &= ~((1u << 1) | (1u << 27));
+		if (value & (1u << 0))
+			value |= (1u << 1);
+		if (value & (1u << 26))
+			value |= (1u << 27);
+	}
+	regs[offset >> 2] = value;
+}
+/* EOF */
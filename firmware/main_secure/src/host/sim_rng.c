@@ -0,0 +1,147 @@
+/**
+ * @file  host/sim_rng.c
+ * @brief Host model of the RNG (deterministic generator)
+ *
+ * The random words come from a xorshift generator seeded by SIM_RNG_SEED
+ * (1 by default) : the content of the entropy pool, and so the challenges
+ * and keys derived from it, are the same on each run. A word is always
+ * ready while the RNG is enabled, and the interrupt is raised again after
+ * each word read, until the RNG is stopped.
+ *
+ * SIM_RNG_FAULT gives the number of a word replaced by a copy of the
+ * previous one, to test the repetition count test of the driver.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hardware.h"
+#include "host/sim.h"
+
+#define RNG_IRQ  114
+#define REG(off) regs[(off) >> 2]
+/* RNG_CR */
+#define CR_RUN     ((1u << 2) | (1u << 3)) /* RNGEN and IE */
+#define CR_CONDRST (1u << 30)
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+static u32  _next(void);
+
+static u32 regs[0x400 / 4];
+static u32 state;
+static u32 last;
+static unsigned long count;
+static unsigned long fault;
+
+static sim_periph rng_model =
+{
+	.name = "RNG",
+	.base = RNG_NS,
+	.size = 0x400,
+	.rd   = _rd,
+	.wr   = _wr,
+};
+
+/**
+ * @brief Attach the RNG model to the bus, seed the generator
+ *
+ */
+void sim_rng_init(void)
+{
+	const char *s;
+
+	memset(regs, 0, sizeof(regs));
+	state = 1;
+	s = getenv("SIM_RNG_SEED");
+	if (s && strtoul(s, 0, 0))
+		state = (u32)strtoul(s, 0, 0);
+	fault = 0;
+	s = getenv("SIM_RNG_FAULT");
+	if (s)
+		fault = strtoul(s, 0, 0);
+	count = 0;
+	last  = 0;
+	sim_attach(&rng_model);
+}
+
+/**
+ * @brief Read a register of the RNG
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	u32 cr = REG(0x00);
+	(void)p; (void)size;
+
+	if (offset >= sizeof(regs))
+		return(0);
+	switch (offset)
+	{
+		case 0x04: // SR : DRDY while enabled
+			if ((cr & (1u << 2)) && ((cr & CR_CONDRST) == 0))
+				return REG(0x04) | (1u << 0);
+			return REG(0x04) & ~(1u << 0);
+		case 0x08: // DR
+			if (((cr & (1u << 2)) == 0) || (cr & CR_CONDRST))
+				return(0);
+			if ((cr & CR_RUN) == CR_RUN)
+				sim_irq(RNG_IRQ);
+			return _next();
+		default:
+			return REG(offset);
+	}
+}
+
+/**
+ * @brief Write a register of the RNG
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	u32 prev = REG(0x00);
+	(void)p; (void)size;
+
+	if (offset >= sizeof(regs))
+		return;
+	switch (offset)
+	{
+		case 0x04: // SR : error flags cleared by writing 0
+			REG(0x04) &= value;
+			break;
+		case 0x00: // CR
+			REG(0x00) = value;
+			if (((prev & CR_RUN) != CR_RUN) && ((value & CR_RUN) == CR_RUN) &&
+			    ((value & CR_CONDRST) == 0))
+				sim_irq(RNG_IRQ);
+			break;
+		default:
+			REG(offset) = value;
+			break;
+	}
+}
+
+/**
+ * @brief Produce the next random word (xorshift32)
+ *
+ * @return u32 Random word
+ */
+static u32 _next(void)
+{
+	count++;
+	if (fault && (count == fault))
+		return(last);
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	last = state;
+	return(state);
+}
+/* EOF */
@@ -0,0 +1,232 @@
+/**
+ * @file  host/sim_rtc.c
+ * @brief Host model of the real-time clock
+ *
+ * The calendar follows the host wall-clock, with an offset set when the
+ * firmware leaves the initialization mode. Shadow registers are not
+ * modeled (reads always give the current time). The wakeup timer only
+ * supports the 1 Hz clock (ck_spre), it is checked each time the RTC or
+ * the timer (see sim_tim.c) is accessed.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <string.h>
+#include <time.h>
+#include "hardware.h"
+#include "host/sim.h"
+
+#define RTC_IRQ    2
+#define RTC_S_IRQ  3
+#define EPOCH_2000 946684800
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+static s64  _now(void);
+static int  _bcd(u32 v);
+static void _set(void);
+static void _sync(void);
+static u32  _tobcd(int v);
+
+static s64 skew;     // Calendar minus host time (ns)
+static u32 tr, dr;   // Calendar registers (in init mode)
+static u32 regs[0x60 / 4];
+static int init;
+static s64 last_wakeup;
+
+static sim_periph rtc_model =
+{
+	.name = "RTC",
+	.base = RTC_NS,
+	.size = 0x400,
+	.rd   = _rd,
+	.wr   = _wr,
+};
+
+/**
+ * @brief Attach the RTC model to the bus
+ *
+ * The calendar starts at 2000-01-01 00:00:00, like after a power-on reset
+ * of the backup domain.
+ */
+void sim_rtc_init(void)
+{
+	memset(regs, 0, sizeof(regs));
+	regs[0x04 >> 2] = 0x00002101;   // DR : 2000-01-01, Saturday
+	regs[0x10 >> 2] = 0x007F00FF;   // PRER
+	regs[0x14 >> 2] = 0x0000FFFF;   // WUTR
+	skew = -_now();
+	last_wakeup = -1;
+	sim_attach(&rtc_model);
+}
+
+/**
+ * @brief Check the wakeup timer, raise its interrupt once per second
+ *
+ */
+void sim_rtc_poll(void)
+{
+	u32 cr = regs[0x18 >> 2];
+	s64 sec;
+
+	// WUTE, and ck_spre clock (WUCKSEL = 10x)
+	if (((cr & (1 << 10)) == 0) || ((cr & 6) != 4))
+		return;
+	sec = (_now() + skew) / 1000000000;
+	if (last_wakeup < 0)
+		last_wakeup = sec;
+	if ((sec - last_wakeup) <= (s64)(regs[0x14 >> 2] & 0xFFFF))
+		return;
+	last_wakeup = sec;
+
+	regs[0x50 >> 2] |= (1 << 2);
+	if (cr & (1 << 14))
+		sim_irq((regs[0x20 >> 2] & (1 << 2)) ? RTC_S_IRQ : RTC_IRQ);
+}
+
+/**
+ * @brief Read a register of the RTC
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	u32 v;
+	(void)p; (void)size;
+
+	sim_rtc_poll();
+	if (offset >= sizeof(regs))
+		return 0;
+	if (! init)
+		_sync();
+	v = regs[offset >> 2];
+	// ICSR : RSF and WUTWF always set, INITF in init mode
+	if (offset == 0x0C)
+	{
+		v |= (1 << 5) | (1 << 2);
+		if (init)
+			v |= (1 << 6) | (1 << 7);
+		if (regs[0x04 >> 2] & 0x00FF0000)
+			v |= (1 << 4);
+	}
+	return v;
+}
+
+/**
+ * @brief Write a register of the RTC
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	(void)p; (void)size;
+
+	switch (offset)
+	{
+		// TR and DR can only be written in init mode
+		case 0x00:
+			if (init)
+				tr = value & 0x007F7F7F;
+			return;
+		case 0x04:
+			if (init)
+				dr = value & 0x00FFFF3F;
+			return;
+		case 0x0C:
+			if ((value & (1 << 7)) && ! init)
+			{
+				_sync();
+				tr = regs[0x00 >> 2];
+				dr = regs[0x04 >> 2];
+				init = 1;
+			}
+			else if (((value & (1 << 7)) == 0) && init)
+			{
+				init = 0;
+				_set();
+			}
+			return;
+		// SCR : clear flags of SR
+		case 0x5C:
+			regs[0x50 >> 2] &= ~value;
+			return;
+	}
+	if (offset < sizeof(regs))
+		regs[offset >> 2] = value;
+}
+
+/**
+ * @brief Get the host wall-clock
+ *
+ * @return s64 Nanoseconds since 2000-01-01
+ */
+static s64 _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (((s64)ts.tv_sec - EPOCH_2000) * 1000000000) + ts.tv_nsec;
+}
+
+/**
+ * @brief Convert a BCD byte
+ */
+static int _bcd(u32 v)
+{
+	return (int)(((v >> 4) & 0xF) * 10 + (v & 0xF));
+}
+
+/**
+ * @brief Convert a value (0 to 99) to BCD
+ */
+static u32 _tobcd(int v)
+{
+	return (u32)(((v / 10) << 4) | (v % 10));
+}
+
+/**
+ * @brief Load the calendar written in init mode
+ *
+ * The sub-second counter restarts when the init mode is left.
+ */
+static void _set(void)
+{
+	struct tm tm;
+
+	memset(&tm, 0, sizeof(tm));
+	tm.tm_year = 100 + _bcd(dr >> 16);
+	tm.tm_mon  = _bcd((dr >> 8) & 0x1F) - 1;
+	tm.tm_mday = _bcd(dr & 0x3F);
+	tm.tm_hour = _bcd((tr >> 16) & 0x3F);
+	tm.tm_min  = _bcd((tr >> 8) & 0x7F);
+	tm.tm_sec  = _bcd(tr & 0x7F);
+	skew = (((s64)timegm(&tm) - EPOCH_2000) * 1000000000) - _now();
+	last_wakeup = -1;
+	_sync();
+}
+
+/**
+ * @brief Update the calendar registers (TR, DR, SSR) from the host clock
+ *
+ */
+static void _sync(void)
+{
+	struct tm tm;
+	time_t t;
+	s64 now = _now() + skew;
+	u32 prediv_s = regs[0x10 >> 2] & 0x7FFF;
+	u32 frac = (u32)(now % 1000000000);
+
+	t = (time_t)(now / 1000000000) + EPOCH_2000;
+	gmtime_r(&t, &tm);
+	regs[0x00 >> 2] = (_tobcd(tm.tm_hour) << 16) | (_tobcd(tm.tm_min) << 8) | _tobcd(tm.tm_sec);
+	regs[0x04 >> 2] = (_tobcd(tm.tm_year - 100) << 16) |
+	                  ((u32)(tm.tm_wday ? tm.tm_wday : 7) << 13) |
+	                  (_tobcd(tm.tm_mon + 1) << 8) | _tobcd(tm.tm_mday);
+	regs[0x08 >> 2] = prediv_s - (u32)(((u64)frac * (prediv_s + 1)) / 1000000000);
+}
+/* EOF */
@@ -0,0 +1,114 @@
+/**
+ * @file  host/sim_spi.c
+ * @brief Host model of SPI4, with MOSI connected to MISO (loopback)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/spi.h"
+#include "hardware.h"
+#include "host/sim.h"
+
+#define FIFO_SIZE 16
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+
+static u32  regs[0x400 / 4];
+static u8   fifo[FIFO_SIZE];
+static uint fifo_rd, fifo_count;
+static uint xfer_count, eot;
+
+static sim_periph spi_model =
+{
+	.name = "SPI4",
+	.base = SPI4_NS,
+	.size = 0x400,
+	.rd   = _rd,
+	.wr   = _wr,
+};
+
+/**
+ * @brief Attach the SPI4 model to the bus
+ *
+ */
+void sim_spi_init(void)
+{
+	sim_attach(&spi_model);
+}
+
+/**
+ * @brief Read a register of the SPI
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	u32 v;
+	(void)p; (void)size;
+
+	switch (offset)
+	{
+		case 0x14: // SR : TXP when fifo is not full, RXP when not empty
+			v = 0;
+			if (fifo_count < FIFO_SIZE)
+				v |= (1 << 1);
+			if (fifo_count)
+				v |= (1 << 0);
+			// EOT : end of a sized transfer, or endless one with data
+			if (eot || ((regs[0x04 >> 2] == 0) && fifo_count))
+				v |= (1 << 3);
+			return(v);
+		case 0x30: // RXDR
+			if (fifo_count == 0)
+				return(0);
+			v = fifo[fifo_rd];
+			fifo_rd = (fifo_rd + 1) % FIFO_SIZE;
+			fifo_count--;
+			return(v);
+		default:
+			return regs[offset >> 2];
+	}
+}
+
+/**
+ * @brief Write a register of the SPI
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	(void)p; (void)size;
+
+	if (offset == 0x20) // TXDR : loopback into RX fifo
+	{
+		if (fifo_count < FIFO_SIZE)
+		{
+			fifo[(fifo_rd + fifo_count) % FIFO_SIZE] = (u8)value;
+			fifo_count++;
+		}
+		xfer_count++;
+		if (regs[0x04 >> 2] && (xfer_count >= (regs[0x04 >> 2] & 0xFFFF)))
+			eot = 1;
+		return;
+	}
+	if (offset == 0x18) // IFCR : EOTC
+	{
+		if (value & (1 << 3))
+			eot = 0;
+		return;
+	}
+	// CSTART is cleared by hardware at end of transfer
+	if (offset == 0x00)
+	{
+		if (value & (1 << 9))
+			xfer_count = 0;
+		value &= ~(u32)(1 << 9);
+	}
+	regs[offset >> 2] = value;
+}
+/* EOF */
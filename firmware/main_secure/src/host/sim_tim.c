@@ -0,0 +1,274 @@
+/**
+ * @file  host/sim_tim.c
+ * @brief Host model of TIM2 (time base) and TIM3/TIM4 (sequencer)
+ *
+ * The counters follow the host monotonic clock, scaled to the 32 MHz
+ * kernel clock of the timers. Only the up-counting mode is supported. An
+ * update event (counter reaching ARR) sets UIF, raises the interrupt if
+ * UIE is set and sends one DMA request if UDE is set. Events are computed
+ * when the timer is accessed or polled (sim_tim_poll), all events elapsed
+ * since the last access are signaled at once.
+ *
+ * Reading the counter also brings the RTC and the frames received by the
+ * ETH model up to date.
+ *
+ * SIM_TIM_START can be set to the value loaded into the TIM2 counter by an
+ * update event (UG), to reach an overflow a few seconds after boot.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdlib.h>
+#include <time.h>
+#include "driver/dma.h"
+#include "hardware.h"
+#include "host/sim.h"
+
+#define TIM_HZ 32000000
+
+/**
+ * @brief State of one timer
+ */
+typedef struct sim_timer
+{
+	uint irq;     // Update interrupt
+	uint req;     // DMA request of the update event (0 if none)
+	u32  arr_rst; // Reset value of ARR (16 or 32 bits counter)
+	u32  cr1, dier, sr, psc, arr, ccmr1, ccer, ccr1;
+	u64  base;    // Counter value at t0
+	u64  t0;      // Host time (ns) of the last rebase
+	u64  events;  // Number of update events already signaled
+	u64  start;   // Counter value loaded by UG
+} sim_timer;
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+static void _rst(sim_periph *p);
+static u64  _count(sim_timer *t);
+static u64  _now(void);
+static void _rebase(sim_timer *t, u64 count);
+static void _update(sim_timer *t, u64 count);
+
+static sim_timer tim2 = { .irq = 45, .req = 0,               .arr_rst = 0xFFFFFFFF };
+static sim_timer tim3 = { .irq = 46, .req = DMA_REQ_TIM3_UP, .arr_rst = 0xFFFF };
+static sim_timer tim4 = { .irq = 47, .req = DMA_REQ_TIM4_UP, .arr_rst = 0xFFFF };
+
+static sim_periph tim_models[] =
+{
+	{ .name = "TIM2", .base = TIM2_NS, .size = 0x400, .rd = _rd, .wr = _wr,
+	  .reset = _rst, .priv = &tim2 },
+	{ .name = "TIM3", .base = TIM3_NS, .size = 0x400, .rd = _rd, .wr = _wr,
+	  .reset = _rst, .priv = &tim3 },
+	{ .name = "TIM4", .base = TIM4_NS, .size = 0x400, .rd = _rd, .wr = _wr,
+	  .reset = _rst, .priv = &tim4 },
+};
+
+/**
+ * @brief Attach the timer models to the bus
+ *
+ */
+void sim_tim_init(void)
+{
+	const char *s = getenv("SIM_TIM_START");
+	uint i;
+
+	tim2.start = s ? strtoul(s, 0, 0) & 0xFFFFFFFF : 0;
+	for (i = 0; i < (sizeof(tim_models) / sizeof(tim_models[0])); i++)
+	{
+		_rst(&tim_models[i]);
+		sim_attach(&tim_models[i]);
+	}
+	sim_dma_paced(tim3.req);
+	sim_dma_paced(tim4.req);
+}
+
+/**
+ * @brief Signal the update events elapsed since the last access
+ *
+ * Called by models that observe the effect of timer driven DMA (GPIO
+ * outputs, DMA status), since these transfers need no CPU access.
+ */
+void sim_tim_poll(void)
+{
+	static int busy;
+	uint i;
+
+	// A DMA request may write a timer register (CCR)
+	if (busy)
+		return;
+	busy = 1;
+	for (i = 0; i < (sizeof(tim_models) / sizeof(tim_models[0])); i++)
+		_update(tim_models[i].priv, _count(tim_models[i].priv));
+	busy = 0;
+}
+
+/**
+ * @brief Read a register of a timer
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	sim_timer *t = p->priv;
+	u64 c;
+	(void)size;
+
+	switch (offset)
+	{
+		case 0x00: return t->cr1;
+		case 0x0C: return t->dier;
+		case 0x10:
+			_update(t, _count(t));
+			return t->sr;
+		case 0x18: return t->ccmr1;
+		case 0x20: return t->ccer;
+		case 0x24:
+			sim_rtc_poll();
+			sim_eth_poll();
+			c = _count(t);
+			_update(t, c);
+			return (u32)(c % ((u64)t->arr + 1));
+		case 0x28: return t->psc;
+		case 0x2C: return t->arr;
+		case 0x34: return t->ccr1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Write a register of a timer
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	sim_timer *t = p->priv;
+	u64 c;
+	(void)size;
+
+	switch (offset)
+	{
+		case 0x00:
+			c = _count(t);
+			t->cr1 = value;
+			_rebase(t, c);
+			break;
+		case 0x0C:
+			t->dier = value;
+			break;
+		// SR : flags are cleared by writing 0
+		case 0x10:
+			t->sr &= value;
+			break;
+		// EGR : UG reloads the counter, UIF is set unless URS
+		case 0x14:
+			if ((value & 1) == 0)
+				break;
+			_rebase(t, t->start);
+			if ((t->cr1 & (1 << 2)) == 0)
+				t->sr |= 1;
+			break;
+		case 0x18:
+			t->ccmr1 = value;
+			break;
+		case 0x20:
+			t->ccer = value;
+			break;
+		case 0x24:
+			_rebase(t, value);
+			break;
+		case 0x28:
+			c = _count(t);
+			t->psc = value & 0xFFFF;
+			_rebase(t, c);
+			break;
+		// ARR : the new period starts from the current counter value
+		case 0x2C:
+			c = _count(t);
+			_update(t, c);
+			_rebase(t, c % ((u64)t->arr + 1));
+			t->arr = value & t->arr_rst;
+			break;
+		case 0x34:
+			t->ccr1 = value & t->arr_rst;
+			break;
+	}
+}
+
+/**
+ * @brief Reset a timer (system reset)
+ */
+static void _rst(sim_periph *p)
+{
+	sim_timer *t = p->priv;
+
+	t->cr1 = t->dier = t->sr = t->psc = 0;
+	t->ccmr1 = t->ccer = t->ccr1 = 0;
+	t->arr = t->arr_rst;
+	_rebase(t, 0);
+}
+
+/**
+ * @brief Get the current value of the (unwrapped) counter
+ *
+ * @param t Pointer to the timer
+ * @return u64 Counter value
+ */
+static u64 _count(sim_timer *t)
+{
+	if ((t->cr1 & 1) == 0)
+		return t->base;
+	return t->base + (((_now() - t->t0) * (TIM_HZ / 1000000)) / 1000) / (t->psc + 1);
+}
+
+/**
+ * @brief Get the host monotonic time
+ *
+ * @return u64 Time in nanoseconds
+ */
+static u64 _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((u64)ts.tv_sec * 1000000000ull) + (u64)ts.tv_nsec;
+}
+
+/**
+ * @brief Load a new counter value
+ *
+ * @param t     Pointer to the timer
+ * @param count Value of the counter from now
+ */
+static void _rebase(sim_timer *t, u64 count)
+{
+	t->base   = count & t->arr_rst;
+	t->t0     = _now();
+	t->events = 0;
+}
+
+/**
+ * @brief Signal update events that occured since the last access
+ *
+ * @param t     Pointer to the timer
+ * @param count Current value of the counter
+ */
+static void _update(sim_timer *t, u64 count)
+{
+	u64 events = count / ((u64)t->arr + 1);
+
+	if (events == t->events)
+		return;
+	t->sr |= 1;
+	if (t->dier & 1)
+		sim_irq(t->irq);
+	for ( ; t->events < events; t->events++)
+		if ((t->dier & (1 << 8)) && t->req)
+			sim_dma_request(t->req);
+	t->events = events;
+}
+/* EOF */
@@ -0,0 +1,130 @@
+/**
+ * @file  host/sim_uart.c
+ * @brief Host model of USART3 (console), connected to stdin/stdout
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <poll.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "driver/uart.h"
+#include "hardware.h"
+#include "host/sim.h"
+
+static u32  _rd(sim_periph *p, u32 offset, uint size);
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size);
+static int  _rx_ready(void);
+
+static u32 regs[0x400 / 4];
+static int rx_byte = -1;
+static int rx_eof;
+
+static sim_periph uart_model =
+{
+	.name = "USART3",
+	.base = USART3_NS,
+	.size = 0x400,
+	.rd   = _rd,
+	.wr   = _wr,
+};
+
+/**
+ * @brief Attach the USART3 model to the bus
+ *
+ */
+void sim_uart_init(void)
+{
+	sim_attach(&uart_model);
+}
+
+/**
+ * @brief Test if stdin has been closed
+ *
+ * @return True when no more byte can be received
+ */
+int sim_uart_eof(void)
+{
+	return (rx_eof && (rx_byte < 0));
+}
+
+/**
+ * @brief Read a register of the USART
+ */
+static u32 _rd(sim_periph *p, u32 offset, uint size)
+{
+	u32 v;
+	(void)p; (void)size;
+
+	switch (offset)
+	{
+		case 0x1C: // ISR : TXE and TC always set, RXNE if a byte is available
+			v = (1 << 7) | (1 << 6);
+			if (_rx_ready())
+				v |= (1 << 5);
+			return(v);
+		case 0x24: // RDR
+			if (rx_byte < 0)
+				return(0);
+			v = (u32)rx_byte;
+			rx_byte = -1;
+			return(v);
+		default:
+			return regs[offset >> 2];
+	}
+}
+
+/**
+ * @brief Write a register of the USART
+ */
+static void _wr(sim_periph *p, u32 offset, u32 value, uint size)
+{
+	(void)p; (void)size;
+
+	if (offset == 0x28) // TDR
+	{
+		putchar((int)(value & 0xFF));
+		if ((value & 0xFF) == '\n')
+			fflush(stdout);
+		return;
+	}
+	regs[offset >> 2] = value;
+}
+
+/**
+ * @brief Poll stdin for one byte (short timeout to avoid busy loops)
+ *
+ * @return True if a received byte is available
+ */
+static int _rx_ready(void)
+{
+	struct pollfd fd;
+	unsigned char c;
+
+	if (rx_byte >= 0)
+		return(1);
+	if (rx_eof)
+		return(0);
+
+	fflush(stdout);
+	fd.fd = 0;
+	fd.events = POLLIN;
+	if (poll(&fd, 1, 1) <= 0)
+		return(0);
+	if (read(0, &c, 1) != 1)
+	{
+		rx_eof = 1;
+		return(0);
+	}
+	rx_byte = c;
+	return(1);
+}
+/* EOF */
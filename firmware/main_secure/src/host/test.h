@@ -0,0 +1,36 @@
+/**
+ * @file  host/test.h
+ * @brief Checks of the modules, run by the test modes of the host build
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef TEST_H
+#define TEST_H
+#include "types.h"
+
+extern u32 test_init; // Time of the modules init of this boot (ns), host/main.c
+
+/* Each test returns its number of failed checks (see doc/host_build.md) */
+int test_crash  (void); // host/test_crash.c
+int test_config (void); // host/test_config.c
+int test_time   (void); // host/test_time.c
+int test_pool   (void); // host/test_pool.c
+int test_seq    (void); // host/test_seq.c
+int test_eth    (void); // host/test_eth.c
+int test_fdcan  (void); // host/test_fdcan.c
+int test_monitor(void); // host/test_monitor.c
+int test_entropy(void); // host/test_entropy.c
+int test_cred   (void); // host/test_cred.c
+int test_ratelim(void); // host/test_ratelim.c
+int test_irq    (void); // host/test_irq.c
+
+#endif
@@ -0,0 +1,267 @@
+/**
+ * @file  host/test_config.c
+ * @brief Checks of the configuration service (host build, "--config-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include "config.c" // Handler, replies and area of the service (private)
+#include "host/test.h"
+
+static u8 _test_frame(u8 type, const u8 *chain, const u8 *data, uint len, u8 *mac);
+
+static u8 test_buf[STAGE_MAX + HASH_SHA256_LEN]; // Last frame sent by the test
+
+/**
+ * @brief Test of the TLV codec and of the staging (host build)
+ *
+ * The stage and commit frames are then signed with the key of the
+ * simulated OBK : chain of the stages, retransmission, replay, and
+ * confirmation of a new product state.
+ *
+ * The configuration area and the option bytes of the simulated flash are
+ * modified (product state up to iRoT-Provisioned) : do not use a flash
+ * file (SIM_FLASH) that must be kept.
+ *
+ * @return integer Zero on success, else number of failed checks
+ */
+int test_config(void)
+{
+	static const struct
+	{
+		u8   len;
+		u8   tlv[10];
+		int  result;
+		u8   bad;
+	} refused[] =
+	{
+		{ 1, { CONFIG_T_SITE },                         FRAME_ST_BADARG, CONFIG_T_SITE },
+		{ 4, { CONFIG_T_SITE, 4, 1, 2 },                FRAME_ST_BADARG, CONFIG_T_SITE },
+		{ 3, { 0x20, 1, 0 },                            CONFIG_ST_VAL, 0x20 },
+		{ 5, { CONFIG_T_SITE, 3, 1, 2, 3 },             CONFIG_ST_VAL, CONFIG_T_SITE },
+		{ 4, { CONFIG_T_WM1, 2, 1, 7 },                 CONFIG_ST_VAL, CONFIG_T_WM1 },
+		{ 4, { CONFIG_T_WM2, 2, 0, 6 },                 CONFIG_ST_VAL, CONFIG_T_WM2 },
+		{ 4, { CONFIG_T_WM1, 2, 0, WM1_LAST + 1 },      CONFIG_ST_VAL, CONFIG_T_WM1 },
+		{ 4, { CONFIG_T_WM2, 2, 0, WM2_LAST + 1 },      CONFIG_ST_VAL, CONFIG_T_WM2 },
+		{ 4, { CONFIG_T_WM2, 2, 0, 127 },               CONFIG_ST_VAL, CONFIG_T_WM2 },
+		{ 3, { CONFIG_T_TZEN, 1, 2 },                   CONFIG_ST_VAL, CONFIG_T_TZEN },
+		{ 3, { CONFIG_T_STATE, 1, 0x5C },               CONFIG_ST_VAL, CONFIG_T_STATE },
+		{ 4, { CONFIG_T_NAME, 2, 'A', 0x07 },           CONFIG_ST_VAL, CONFIG_T_NAME },
+		{ 2, { CONFIG_T_WM1, 0 },                       CONFIG_ST_VAL, CONFIG_T_WM1 },
+		{ 8, { CONFIG_T_TZEN, 1, 1, 0, 0, CONFIG_T_TZEN, 1, 1 }, CONFIG_ST_VAL, 0 },
+		{ 10, { CONFIG_T_TZEN, 1, 1, CONFIG_T_TZEN, 1, 1, 0, 0, 0, 0 }, CONFIG_ST_VAL, CONFIG_T_TZEN },
+	};
+	static const u8 set[] =
+	{
+		CONFIG_T_SITE,   4, 0x39, 0x30, 0, 0,     // 12345
+		CONFIG_T_PANEL,  4, 7, 0, 0, 0,
+		CONFIG_T_NAME,   6, 'G', 'a', 't', 'e', ' ', '7',
+		CONFIG_T_IP,     4, 20, 0, 0, 10,         // 10.0.0.20
+		CONFIG_T_SERVER, 4, 1, 0, 0, 10,
+		CONFIG_T_WM1,    2, 0, WM1_LAST,
+		CONFIG_T_STATE,  1, CONFIG_PS_PROV,
+	};
+	static const u8 panel[] = { CONFIG_T_PANEL, 4, 8, 0, 0, 0 };
+	static const u8 irot[]  = { CONFIG_T_STATE, 1, CONFIG_PS_IROT };
+	u8   buf[sizeof(out)];
+	u8   zero[HASH_SHA256_LEN], ones[HASH_SHA256_LEN];
+	u8   mac[2][HASH_SHA256_LEN];
+	u8   cmd[5];
+	u8   bad;
+	uint fail, n, i;
+	u32  gen, auth;
+	int  r;
+
+	fail = 0;
+	config_abort();
+	gen = config_gen();
+
+	// Malformed or refused sets : nothing is staged
+	for (i = 0; i < (sizeof(refused) / sizeof(refused[0])); i++)
+	{
+		r = config_stage(refused[i].tlv, refused[i].len, &bad);
+		if ((r != refused[i].result) || (config_staged() != 0) ||
+		    ((refused[i].bad != 0) && (bad != refused[i].bad)))
+		{
+			fprintf(stderr, "sim: config set %u : result %d, tag %02X\n", i, r, bad);
+			fail++;
+		}
+	}
+	if (config_commit(gen, 0) != CONFIG_ST_NONE)
+		fail++;
+
+	// Staged, aborted, staged again then committed
+	if ((config_stage(set, sizeof(set), &bad) != CONFIG_OK) || (config_staged() != 7))
+		fail++;
+	config_abort();
+	if (config_staged() != 0)
+		fail++;
+	if ((config_stage(set, sizeof(set), &bad) != CONFIG_OK) ||
+	    (config_commit(gen + 1, 0) != CONFIG_ST_GEN) || (config_staged() != 7))
+		fail++;
+	// New product state : not applied without confirmation
+	if ((config_commit(gen, 0) != CONFIG_ST_CONFIRM) || (config_staged() != 7) ||
+	    (config_stat.ob_starts != 0))
+		fail++;
+	r = config_commit(gen, CONFIG_F_CONFIRM);
+	if ((r != CONFIG_OK) || (config_gen() != gen + 1) ||
+	    (config_staged() != 0) || (config_stat.ob_starts != 1))
+	{
+		fprintf(stderr, "sim: config commit %d (generation %u)\n", r, config_gen());
+		fail++;
+	}
+	if ((config_u32(CONFIG_T_SITE, 0) != 12345) || (config_u32(CONFIG_T_IP, 0) != 0x0A000014) ||
+	    (config_get(CONFIG_T_NAME, buf, sizeof(buf)) != 6) || (buf[5] != '7'))
+		fail++;
+
+	// Option bytes applied, read back as TLV
+	buf[0] = CONFIG_T_WM1;
+	buf[1] = CONFIG_T_STATE;
+	buf[2] = 0x20;
+	n = config_read(buf, 3, buf + 3, sizeof(buf) - 3);
+	if ((n != 7) || (buf[3] != CONFIG_T_WM1) || (buf[4] != 2) || (buf[6] != WM1_LAST) ||
+	    (buf[7] != CONFIG_T_STATE) || (buf[9] != CONFIG_PS_PROV))
+		fail++;
+	// No way back to a previous product state
+	if (config_stage((const u8 *)"\x04\x01\xED", 3, &bad) != CONFIG_ST_VAL)
+		fail++;
+
+	// Remove an item, then reload from flash
+	if ((config_stage((const u8 *)"\x12\x00", 2, &bad) != CONFIG_OK) ||
+	    (config_commit(gen + 1, 0) != CONFIG_OK))
+		fail++;
+	n = config_read(0, 0, buf, sizeof(buf));
+	for (i = 0; i < SLOTS; i++)
+		cache_len[i] = 0;
+	_load();
+	if ((config_gen() != gen + 2) || (config_get(CONFIG_T_NAME, buf, 0) != 0) ||
+	    (config_u32(CONFIG_T_PANEL, 0) != 7) || (config_read(0, 0, buf + n, sizeof(buf) - n) != n))
+		fail++;
+	for (i = 0; i < n; i++)
+		if (buf[i] != buf[n + i])
+			fail++;
+
+	// Frames : stages chained from zero, bad link refused
+	gen  = config_gen();
+	auth = config_stat.auth_err;
+	for (i = 0; i < HASH_SHA256_LEN; i++)
+	{
+		zero[i] = 0;
+		ones[i] = 0xFF;
+	}
+	_handler(CONFIG_STAGE, 0, ones, HASH_SHA256_LEN);
+	if ((out[0] != FRAME_ST_BADARG) ||
+	    (_test_frame(CONFIG_STAGE, ones, panel, sizeof(panel), 0) != CONFIG_ST_AUTH) ||
+	    (config_staged() != 0))
+		fail++;
+	if ((_test_frame(CONFIG_STAGE, zero, panel, sizeof(panel), mac[0]) != CONFIG_OK) ||
+	    (config_staged() != 1))
+		fail++;
+	for (i = 0; i < sizeof(panel) + HASH_SHA256_LEN; i++)
+		buf[i] = test_buf[i];
+	// Retransmission accepted as is, another frame with the same link refused
+	_handler(CONFIG_STAGE, 0, buf, sizeof(panel) + HASH_SHA256_LEN);
+	if ((out[0] != CONFIG_OK) || (config_staged() != 1) ||
+	    (_test_frame(CONFIG_STAGE, zero, irot, sizeof(irot), 0) != CONFIG_ST_AUTH) ||
+	    (config_staged() != 1))
+		fail++;
+	if ((_test_frame(CONFIG_STAGE, mac[0], irot, sizeof(irot), mac[1]) != CONFIG_OK) ||
+	    (config_staged() != 2))
+		fail++;
+	_handler(CONFIG_STAGE, 0, test_buf, sizeof(irot) + HASH_SHA256_LEN);
+	if ((out[0] != CONFIG_OK) || (config_staged() != 2))
+		fail++;
+
+	// Commit : covers the last stage, product state confirmed
+	cmd[0] = (u8)(gen >>  0);
+	cmd[1] = (u8)(gen >>  8);
+	cmd[2] = (u8)(gen >> 16);
+	cmd[3] = (u8)(gen >> 24);
+	cmd[4] = 0;
+	if ((_test_frame(CONFIG_COMMIT, mac[0], cmd, 5, 0) != CONFIG_ST_AUTH) ||
+	    (_test_frame(CONFIG_COMMIT, mac[1], cmd, 5, 0) != CONFIG_ST_CONFIRM) ||
+	    (config_staged() != 2))
+		fail++;
+	cmd[4] = CONFIG_F_CONFIRM;
+	r = _test_frame(CONFIG_COMMIT, mac[1], cmd, 5, 0);
+	_ob_get(CONFIG_T_STATE - 1, &bad);
+	if ((r != CONFIG_OK) || (config_gen() != gen + 1) || (config_staged() != 0) ||
+	    (config_u32(CONFIG_T_PANEL, 0) != 8) || (bad != CONFIG_PS_IROT))
+	{
+		fprintf(stderr, "sim: config signed commit %d (generation %u)\n", r, config_gen());
+		fail++;
+	}
+	// Replay of the stage and of the commit (previous generation)
+	for (i = 0; i < 5 + HASH_SHA256_LEN; i++)
+		buf[64 + i] = test_buf[i];
+	_handler(CONFIG_STAGE, 0, buf, sizeof(panel) + HASH_SHA256_LEN);
+	if ((out[0] != CONFIG_ST_AUTH) || (config_staged() != 0))
+		fail++;
+	_handler(CONFIG_COMMIT, 0, buf + 64, 5 + HASH_SHA256_LEN);
+	if ((out[0] != CONFIG_ST_GEN) || (config_gen() != gen + 1))
+		fail++;
+	// Same product state again : nothing to confirm
+	cmd[0]++;
+	cmd[4] = 0;
+	if ((_test_frame(CONFIG_STAGE, zero, irot, sizeof(irot), mac[0]) != CONFIG_OK) ||
+	    (_test_frame(CONFIG_COMMIT, mac[0], cmd, 5, 0) != CONFIG_OK))
+		fail++;
+	if (config_stat.auth_err != (auth + 4))
+		fail++;
+
+	fprintf(stderr, "sim: config test %s (generation %u, %u option bytes starts, %u bad MACs)\n",
+	        fail ? "FAILED" : "passed", config_gen(), config_stat.ob_starts, config_stat.auth_err);
+	return((int)fail);
+}
+
+/**
+ * @brief Sign a stage or commit frame and give it to the handler
+ *
+ * The MAC is computed with the key of the simulated OBK, the frame is kept
+ * into test_buf (for a replay).
+ *
+ * @param type  Type of the frame (CONFIG_STAGE or CONFIG_COMMIT)
+ * @param chain MAC of the last stage
+ * @param data  Pointer to the payload (without MAC)
+ * @param len   Length of the payload
+ * @param mac   Pointer to a buffer that receives the MAC (may be null)
+ * @return u8 Status of the reply
+ */
+static u8 _test_frame(u8 type, const u8 *chain, const u8 *data, uint len, u8 *mac)
+{
+	static u8 msg[8 + HASH_SHA256_LEN + STAGE_MAX];
+	u8   key[BOOT_KEY_LEN];
+	uint i, n;
+
+	for (i = 0; i < BOOT_KEY_LEN; i++)
+		key[i] = (u8)(reg_rd(BOOT_KEY_ADDR + (i & ~3u)) >> (8 * (i & 3)));
+	n = 0;
+	msg[n++] = 'C';
+	msg[n++] = 'F';
+	msg[n++] = 'G';
+	msg[n++] = (type == CONFIG_STAGE) ? 'S' : 'C';
+	for (i = 0; i < 4; i++)
+		msg[n++] = (u8)(area.gen >> (8 * i));
+	for (i = 0; i < HASH_SHA256_LEN; i++)
+		msg[n++] = chain[i];
+	// A commit signs its flags, the generation is into the message
+	for (i = (type == CONFIG_STAGE) ? 0 : 4; i < len; i++)
+		msg[n++] = data[i];
+	for (i = 0; i < len; i++)
+		test_buf[i] = data[i];
+	hash_hmac(key, BOOT_KEY_LEN, msg, n, test_buf + len);
+	for (i = 0; mac && (i < HASH_SHA256_LEN); i++)
+		mac[i] = test_buf[len + i];
+	_handler(type, 0, test_buf, len + HASH_SHA256_LEN);
+	return(out[0]);
+}
+/* EOF */
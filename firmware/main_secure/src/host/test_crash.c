@@ -0,0 +1,181 @@
+/**
+ * @file  host/test_crash.c
+ * @brief Fault and warm restart check (host build, "--crash-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include "hardware.h"
+#include "crash.h"
+#include "cred.h"
+#include "host/test.h"
+
+static int _crash_store(u32 count);
+
+static volatile u32 *volatile crash_ptr; // Null pointer, raises the faults
+
+/**
+ * @brief Check the content of the credential store after a restart
+ *
+ * @param count Number of credentials expected
+ * @return integer Non-zero if the store is the one filled by the test
+ */
+static int _crash_store(u32 count)
+{
+	return((cred_count() == count) && (cred_lookup(1000) == 1) &&
+	       (cred_lookup(1001) == 2) && (cred_lookup(1002) == 0));
+}
+
+/**
+ * @brief Fault and warm restart test (host build, "--crash-test")
+ *
+ * This function is called at each boot : the store is filled then the
+ * firmware is reset (cold boot with a full store), then a fault is raised.
+ * After the warm restart, the store must have been kept and the record
+ * must describe the fault. Then :
+ *  - a fault while the store is modified : it is reloaded from flash
+ *  - a reset without fault : cold boot, the faults in a row are cleared
+ *  - a damaged record : cleared, cold boot
+ *  - more than CRASH_BURST faults in a row : cold boot
+ *
+ * @return integer Zero on success (exit code)
+ */
+int test_crash(void)
+{
+	static uint step;
+	static u32  cold;
+	static u32  count;
+	u8   ops[CRED_BATCH_MAX * CRED_OP_SIZE];
+	u8  *p;
+	u32  id;
+	uint i, j;
+
+	crash_sim();
+	switch (step)
+	{
+		// First boot : base of 20000 credentials, 1000 changes into the log
+		case 0:
+			cred_format();
+			cred_range_begin(1, CRED_ID_MAX, cred_version());
+			while (cred_range_put(1000, 1) == CRED_ST_BUSY)
+				cred_poll();
+			for (i = 1; i < 20000; i++)
+				cred_range_put(1000 + (i * 3), 1 + (i & 0xFF));
+			cred_range_end(1);
+			while (cred_version() != 1)
+				cred_poll();
+			for (i = 0; i < 10; i++)
+			{
+				for (j = 0; j < 100; j++)
+				{
+					p  = ops + (j * CRED_OP_SIZE);
+					id = 1001 + (((i * 100) + j) * 3);
+					p[0] = CRED_OP_ADD;
+					p[1] = (u8)id;
+					p[2] = (u8)(id >> 8);
+					p[3] = (u8)(id >> 16);
+					p[4] = (u8)(id >> 24);
+					p[5] = 2;
+					p[6] = p[7] = p[8] = 0;
+				}
+				if (cred_apply(cred_version(), cred_version() + 1, ops, 100) != CRED_OK)
+				{
+					fprintf(stderr, "sim: crash test, batch %u refused\n", i);
+					return(1);
+				}
+			}
+			step = 1;
+			hw_reset();
+			break;
+		// Cold boot with the full store, then fault
+		case 1:
+			cold  = test_init;
+			count = cred_count();
+			step  = 2;
+			*crash_ptr = 0;
+			break;
+		// Warm restart, then fault while the store is being modified
+		case 2:
+			fprintf(stderr, "sim: cold boot %u us, warm restart %u us\n",
+			        cold / 1000, test_init / 1000);
+			if (( ! crash_warm()) || ( ! crash_intact(CRASH_R_CRED)) ||
+			    ( ! _crash_store(count)))
+			{
+				fprintf(stderr, "sim: crash test FAILED (store not kept)\n");
+				return(1);
+			}
+			if ((CRASH_REC->count != 1) || (CRASH_REC->burst != 1) ||
+			    CRASH_REC->pending || (CRASH_REC->exc != CRASH_EXC_HOST) ||
+			    (CRASH_REC->mmfar != 0) || ( ! crash_secure()))
+			{
+				fprintf(stderr, "sim: crash test FAILED (record)\n");
+				return(1);
+			}
+			step = 3;
+			crash_dirty(CRASH_R_CRED);
+			*crash_ptr = 0;
+			break;
+		// Store reloaded, then reset without fault
+		case 3:
+			if (( ! crash_warm()) || crash_intact(CRASH_R_CRED) ||
+			    ( ! _crash_store(count)) || (CRASH_REC->burst != 2))
+			{
+				fprintf(stderr, "sim: crash test FAILED (modified store kept)\n");
+				return(1);
+			}
+			step = 4;
+			hw_reset();
+			break;
+		// Cold boot, then damaged record
+		case 4:
+			if (crash_warm() || (CRASH_REC->count != 2) || (CRASH_REC->burst != 0) ||
+			    ( ! _crash_store(count)))
+			{
+				fprintf(stderr, "sim: crash test FAILED (reset taken as a fault)\n");
+				return(1);
+			}
+			step = 5;
+			CRASH_REC->count++;
+			hw_reset();
+			break;
+		// Record cleared, then faults in a row
+		case 5:
+			if (crash_warm() || (CRASH_REC->count != 0) || ( ! _crash_store(count)))
+			{
+				fprintf(stderr, "sim: crash test FAILED (damaged record used)\n");
+				return(1);
+			}
+			step = 6;
+			crash_fault(0, 0, 0);
+			break;
+		case 6:
+			if (CRASH_REC->burst <= CRASH_BURST)
+			{
+				if (( ! crash_warm()) || ( ! crash_intact(CRASH_R_CRED)))
+				{
+					fprintf(stderr, "sim: crash test FAILED (restart %u)\n", CRASH_REC->burst);
+					return(1);
+				}
+				crash_fault(0, 0, 0);
+				break;
+			}
+			if (crash_warm() || crash_intact(CRASH_R_CRED) || ( ! _crash_store(count)))
+			{
+				fprintf(stderr, "sim: crash test FAILED (burst of faults)\n");
+				return(1);
+			}
+			fprintf(stderr, "sim: crash test passed, %u credentials kept\n", count);
+			return(0);
+	}
+	return(1);
+}
+/* EOF */
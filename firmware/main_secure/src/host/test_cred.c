@@ -0,0 +1,267 @@
+/**
+ * @file  host/test_cred.c
+ * @brief Checks of the coding of the credential store (host build, "--cred-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include "cred.c" // Records, state and hash of the store (private)
+#include "host/test.h"
+
+#define TEST_RECS 15000
+
+static void _test_abort(const u8 *chain);
+static u32  _test_rand(void);
+static uint _test_check(const char *name);
+static uint _test_load(u32 lo, u32 hi, uint from, uint to);
+
+static cred_rec test_db[TEST_RECS]; // Expected content, sorted
+static uint     test_len;
+static u32      test_seed;
+
+/**
+ * @brief Check the coding of the base (host build)
+ *
+ * Bases of random 32 bits UIDs, of card numbers with 10% missing and of
+ * mixed widths (differences and profiles from 1 to 32 bits, identifiers 1
+ * and CRED_ID_MAX) are written then compared with the expected content :
+ * lookup of each record and of its missing neighbours, digest and count of
+ * the whole store. The random base is then decoded and coded again : range
+ * replaced into the middle, then overlay compacted into a new base. At the
+ * end, a range is aborted : only by a frame signed over its chain.
+ *
+ * @return integer Number of failed checks
+ */
+int test_cred(void)
+{
+	u8   ops[CRED_BATCH_MAX * CRED_OP_SIZE];
+	u32  bpc[2], id, n, attr;
+	uint fail = 0;
+	uint i, j;
+
+	test_seed = 0x43524431;
+
+	// Random 32 bits UIDs, profile 8 bits
+	for (i = 0, id = 0; i < 6000; i++)
+	{
+		id += 1 + (_test_rand() % 700000);
+		test_db[i].id   = id;
+		test_db[i].attr = 1 + (_test_rand() % 255);
+	}
+	test_len = i;
+	fail += _test_load(1, CRED_ID_MAX, 0, test_len);
+	fail += _test_check("random");
+	bpc[0] = (cred_base_size(&n) * 10) / n;
+
+	// Range into the middle : every other record, new profiles
+	j = 1000;
+	for (i = 1000; i < 3000; i += 2, j++)
+	{
+		test_db[j].id   = test_db[i].id;
+		test_db[j].attr = test_db[i].attr ^ 0x100;
+	}
+	fail += _test_load(test_db[1000].id, test_db[2999].id, 1000, j);
+	for (i = 3000; i < test_len; i++, j++)
+		test_db[j] = test_db[i];
+	test_len = j;
+	fail += _test_check("range");
+
+	// Overlay, then compaction into a new base
+	for (i = 0; i < CRED_BATCH_MAX; i++)
+	{
+		attr = 0xFFFF0000 | i;
+		ops[i * CRED_OP_SIZE] = CRED_OP_MODIFY;
+		for (j = 0; j < 4; j++)
+		{
+			ops[(i * CRED_OP_SIZE) + 1 + j] = (u8)(test_db[i * 40].id >> (8 * j));
+			ops[(i * CRED_OP_SIZE) + 5 + j] = (u8)(attr >> (8 * j));
+		}
+		test_db[i * 40].attr = attr;
+	}
+	if (cred_apply(store.version, store.version + 1, ops, CRED_BATCH_MAX) != CRED_OK)
+		fail++;
+	fail += _test_check("overlay");
+	_build_start(_area(store.area ^ 1), 0xFFFFFFFF, 0);
+	while (store.state == ST_BUILD)
+		_build_step();
+	if (delta_len != 0)
+		fail++;
+	fail += _test_check("compaction");
+
+	// Card numbers, 10% missing
+	for (i = 0, id = 100000; i < TEST_RECS; id++)
+	{
+		if ((_test_rand() % 10) == 0)
+			continue;
+		test_db[i].id   = id;
+		test_db[i].attr = 1 + (_test_rand() % 255);
+		i++;
+	}
+	test_len = i;
+	fail += _test_load(1, CRED_ID_MAX, 0, test_len);
+	fail += _test_check("cards");
+	bpc[1] = (cred_base_size(&n) * 10) / n;
+
+	// Mixed widths, from identifier 1 to CRED_ID_MAX
+	id = 1;
+	for (i = 0; i < 2000; i++)
+	{
+		test_db[i].id = id;
+		n = _test_rand();
+		test_db[i].attr = (n & 1) ? (_test_rand() >> (n % 32)) | 1 : 1 + (n % 3);
+		n = _test_rand();
+		if (n & 1)
+			n = 1;
+		else
+			n = 1 + (_test_rand() >> (n % 32));
+		if ((i == 1998) || (n > (CRED_ID_MAX - id)))
+		{
+			test_db[++i].id  = CRED_ID_MAX;
+			test_db[i].attr  = 0xFFFFFFFF;
+			break;
+		}
+		id += n;
+	}
+	test_len = i + 1;
+	fail += _test_load(1, CRED_ID_MAX, 0, test_len);
+	fail += _test_check("widths");
+
+	// Abort of a range : refused without a MAC or with the MAC of another chain
+	if (cred_range_begin(1, CRED_ID_MAX, store.version) != CRED_OK)
+		fail++;
+	for (i = 0; i < HASH_SHA256_LEN; i++)
+	{
+		build.chain[i] = (u8)(i * 7);
+		ops[i] = 0;
+	}
+	n = cred_stat.auth_err;
+	_handler(CRED_RANGE_ABORT, 0, ops, 0);
+	_test_abort(ops);
+	if ((store.state != ST_BUILD) || (cred_stat.auth_err != n + 1))
+		fail++;
+	_test_abort(build.chain);
+	if ((store.state != ST_IDLE) || (cred_stat.auth_err != n + 1))
+		fail++;
+	fail += _test_check("aborted range");
+
+	fprintf(stderr, "sim: cred test %s (%u.%u bytes/credential random, %u.%u cards)\n",
+	        fail ? "FAILED" : "passed", bpc[0] / 10, bpc[0] % 10, bpc[1] / 10, bpc[1] % 10);
+	return((int)fail);
+}
+
+/**
+ * @brief Sign an abort frame over a chain and give it to the handler
+ *
+ * @param chain MAC of the chain the abort is signed for
+ */
+static void _test_abort(const u8 *chain)
+{
+	u8   key[BOOT_KEY_LEN];
+	u8   msg[4 + HASH_SHA256_LEN];
+	u8   mac[HASH_SHA256_LEN];
+	uint i;
+
+	for (i = 0; i < BOOT_KEY_LEN; i++)
+		key[i] = (u8)(reg_rd(BOOT_KEY_ADDR + (i & ~3u)) >> (8 * (i & 3)));
+	msg[0] = 'C';
+	msg[1] = 'R';
+	msg[2] = 'R';
+	msg[3] = 'A';
+	for (i = 0; i < HASH_SHA256_LEN; i++)
+		msg[4 + i] = chain[i];
+	hash_hmac(key, BOOT_KEY_LEN, msg, sizeof(msg), mac);
+	_handler(CRED_RANGE_ABORT, 0, mac, HASH_SHA256_LEN);
+}
+
+/**
+ * @brief Pseudo-random value of the test (reproducible)
+ *
+ * @return u32 32 bits value
+ */
+static u32 _test_rand(void)
+{
+	u32 v;
+
+	test_seed = (test_seed * 1103515245) + 12345;
+	v = test_seed >> 16;
+	test_seed = (test_seed * 1103515245) + 12345;
+	return((v << 16) | (test_seed >> 16));
+}
+
+/**
+ * @brief Compare the store with the expected content
+ *
+ * @param name Name of the base, for the error report
+ * @return uint Number of failed checks (0 or 1)
+ */
+static uint _test_check(const char *name)
+{
+	u32  d = 0, dig, n;
+	uint err = 0;
+	uint i;
+
+	for (i = 0; i < test_len; i++)
+	{
+		if (cred_lookup(test_db[i].id) != test_db[i].attr)
+			err++;
+		// Missing neighbours
+		if ((test_db[i].id > 1) && ((i == 0) || (test_db[i - 1].id != (test_db[i].id - 1))) &&
+		    cred_lookup(test_db[i].id - 1))
+			err++;
+		if ((test_db[i].id < CRED_ID_MAX) &&
+		    (((i + 1) == test_len) || (test_db[i + 1].id != (test_db[i].id + 1))) &&
+		    cred_lookup(test_db[i].id + 1))
+			err++;
+		d += _mix(test_db[i].id ^ _mix(test_db[i].attr));
+	}
+	dig = cred_digest(1, CRED_ID_MAX, &n);
+	if ((dig != d) || (n != test_len) || (cred_count() != test_len))
+		err++;
+	if (err)
+		fprintf(stderr, "sim: cred test, %s base : %u errors\n", name, err);
+	return(err ? 1 : 0);
+}
+
+/**
+ * @brief Write expected records into a range of the store (new area)
+ *
+ * @param lo   First identifier of the range
+ * @param hi   Last identifier of the range
+ * @param from Index of the first record to send
+ * @param to   Index after the last record to send
+ * @return uint Number of failed checks (0 or 1)
+ */
+static uint _test_load(u32 lo, u32 hi, uint from, uint to)
+{
+	u32  version;
+	int  result;
+	uint i;
+
+	if ((lo == 1) && (hi == CRED_ID_MAX) && (cred_format() < 0))
+		return(1);
+	version = store.version;
+	if (cred_range_begin(lo, hi, version) != CRED_OK)
+		return(1);
+	for (i = from; i < to; i++)
+	{
+		while ((result = cred_range_put(test_db[i].id, test_db[i].attr)) == CRED_ST_BUSY)
+			cred_poll();
+		if (result != CRED_OK)
+			return(1);
+	}
+	if (cred_range_end(version + 1) != CRED_OK)
+		return(1);
+	while (store.state == ST_BUILD)
+		cred_poll();
+	return((store.version == (version + 1)) ? 0 : 1);
+}
+/* EOF */
@@ -0,0 +1,112 @@
+/**
+ * @file  host/test_entropy.c
+ * @brief Checks of the entropy pool (host build, "--entropy-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "entropy.c" // Cipher and pool (private)
+#include "host/test.h"
+
+#define TEST_BYTES 65536
+
+/**
+ * @brief Check the generator and the pool (host build)
+ *
+ * ChaCha20 blocks against known answers (RFC 8439 A.1 #1, and a key,
+ * counter and nonce word computed by a reference implementation). Pool :
+ * request too long, bytes erased once served, refill below the low level,
+ * requests refused while the TRNG interrupt is masked then served after,
+ * no repeated block and balanced bits over the bytes served.
+ *
+ * @return integer Number of failed checks
+ */
+int test_entropy(void)
+{
+	static const u32 kat[2][16] =
+	{
+		{
+			0xADE0B876, 0x903DF1A0, 0xE56A5D40, 0x28BD8653,
+			0xB819D2BD, 0x1AED8DA0, 0xCCEF36A8, 0xC70D778B,
+			0x7C5941DA, 0x8D485751, 0x3FE02477, 0x374AD8B8,
+			0xF4B8436A, 0x1CA11815, 0x69B687C3, 0x8665EEB2
+		},
+		{
+			0xCDF1B31D, 0x7025B7AF, 0x0730222B, 0x337FF588,
+			0x8D92DFF0, 0xC95AED45, 0x5BC0AD65, 0x1AB6AEBB,
+			0xA1E66E23, 0xB6AF8DBF, 0xB6D238A7, 0x89E67B0C,
+			0x2A50A3AE, 0x5E78E9C5, 0xE5399C2A, 0x57874233
+		},
+	};
+	static u8 prev_buf[ENTROPY_GET_MAX];
+	u8   buf[ENTROPY_GET_MAX];
+	u32  key[8], blk[16];
+	u32  lock, rd, ones = 0;
+	uint i, j, n, same = 0;
+	uint fail = 0;
+
+	// Known answers
+	for (i = 0; i < 8; i++)
+		key[i] = 0;
+	_chacha(key, 0, 0, blk);
+	for (i = 0; i < 16; i++)
+		fail += (blk[i] != kat[0][i]);
+	for (i = 0; i < 8; i++)
+		key[i] = 0x03020100 + (i * 0x04040404);
+	_chacha(key, 1, 0x09000000, blk);
+	for (i = 0; i < 16; i++)
+		fail += (blk[i] != kat[1][i]);
+
+	// Requests : too long, served bytes erased from the pool
+	if (entropy_get(buf, ENTROPY_GET_MAX + 1) != -1)
+		fail++;
+	rd = pool_rd;
+	if (entropy_get(buf, 16) != 0)
+		fail++;
+	for (i = 0; i < 16; i++)
+		fail += (((u8 *)pool)[(rd + i) & (ENTROPY_POOL - 1)] != 0);
+
+	// Bytes served : refills, no block twice, balanced bits
+	n = entropy_stat.refills;
+	for (i = 0; i < (TEST_BYTES / ENTROPY_GET_MAX); i++)
+	{
+		if (entropy_get(buf, ENTROPY_GET_MAX) != 0)
+		{
+			fail++;
+			break;
+		}
+		for (j = 0; j < ENTROPY_GET_MAX; j++)
+			ones += (u32)__builtin_popcount(buf[j]);
+		same += (memcmp(buf, prev_buf, ENTROPY_GET_MAX) == 0);
+		memcpy(prev_buf, buf, ENTROPY_GET_MAX);
+	}
+	if ((same != 0) || (entropy_stat.refills == n) ||
+	    (ones < (TEST_BYTES * 4) - 2048) || (ones > (TEST_BYTES * 4) + 2048))
+		fail++;
+
+	// TRNG interrupt masked : the pool runs out, requests are refused
+	n = entropy_stat.empty;
+	lock = irq_lock(IRQ_PRIO_CRYPTO);
+	for (i = 0; (entropy_get(buf, ENTROPY_GET_MAX) == 0) && (i < ENTROPY_POOL); i++)
+		;
+	if ((entropy_level() >= ENTROPY_GET_MAX) || (entropy_stat.empty != n + 1))
+		fail++;
+	irq_unlock(lock);
+	if ((entropy_level() <= (ENTROPY_POOL - ENTROPY_CHUNK)) || (entropy_get(buf, 8) != 0))
+		fail++;
+
+	fprintf(stderr, "sim: entropy test %s (%u bytes, %u reseeds)\n",
+	        fail ? "FAILED" : "passed", entropy_stat.served, entropy_stat.reseeds);
+	return((int)fail);
+}
+/* EOF */
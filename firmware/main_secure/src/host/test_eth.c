@@ -0,0 +1,211 @@
+/**
+ * @file  host/test_eth.c
+ * @brief Checks of the Ethernet driver (host build, "--eth-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "hardware.h"
+#include "driver/eth.h"
+#include "host/test.h"
+
+#define TEST_FRAMES (ETH_RX_DESC * 3)
+
+static u8   test_tx[ETH_BUF_SIZE];
+static uint test_done;
+
+/**
+ * @brief Build a test frame : broadcast, IPv4/UDP, payload from a seed
+ *
+ * @param seed Value of the first byte of the payload (and of the length)
+ * @param ip   Non-zero for an IPv4/UDP frame, zero for another ethertype
+ * @return uint Length of the frame
+ */
+static uint _test_frame(uint seed, int ip)
+{
+	static const u8 hdr[42] =
+	{
+		0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02, 0, 0, 0, 0, 1, 0x08, 0x00,
+		0x45, 0, 0, 0, 0, 0, 0x40, 0, 64, 17, 0, 0,
+		192, 168, 1, 10, 192, 168, 1, 255,
+		0x17, 0x70, 0x17, 0x70, 0, 0, 0, 0
+	};
+	uint pl = 32 + ((seed * 157) % 1400);
+	uint i;
+
+	memcpy(test_tx, hdr, sizeof(hdr));
+	test_tx[16] = (u8)((pl + 28) >> 8);
+	test_tx[17] = (u8)(pl + 28);
+	test_tx[38] = (u8)((pl + 8) >> 8);
+	test_tx[39] = (u8)(pl + 8);
+	if ( ! ip)
+		test_tx[12] = 0x88, test_tx[13] = 0xB5;
+	for (i = 0; i < pl; i++)
+		test_tx[42 + i] = (u8)(seed + (i * 7));
+	return(42 + pl);
+}
+
+/**
+ * @brief Done callback of the transmitted test frames
+ */
+static void _test_sent(void *arg)
+{
+	(void)arg;
+	test_done++;
+}
+
+/**
+ * @brief Send the test frame, cut into 1 to 4 segments
+ *
+ * @param len   Length of the frame
+ * @param count Number of segments
+ * @return integer Result of eth_send()
+ */
+static int _test_send(uint len, uint count)
+{
+	eth_seg seg[4];
+	uint i, pos = 0, n;
+
+	for (i = 0; i < count; i++)
+	{
+		n = (i == (count - 1)) ? (len - pos) : ((len / count) - i);
+		seg[i].data = test_tx + pos;
+		seg[i].len  = (u16)n;
+		pos += n;
+	}
+	return eth_send(seg, count, _test_sent, 0);
+}
+
+/**
+ * @brief Check a received frame against the test frame of a seed
+ *
+ * @param frame Pointer to the received frame
+ * @param seed  Seed of the expected frame
+ * @param ip    Non-zero if an IPv4/UDP frame is expected
+ * @return integer Zero if the frame matches
+ */
+static int _test_check(const eth_frame *frame, uint seed, int ip)
+{
+	uint len = _test_frame(seed, ip);
+	u16  flags = ip ? (ETH_RX_IPV4 | ETH_RX_CSUM) : 0;
+
+	// Checksums are inserted by the MAC : compare the payload only
+	if ((frame->len != len) || (frame->flags != flags) ||
+	    (memcmp(frame->data, test_tx, 14) != 0) ||
+	    (memcmp(frame->data + 42, test_tx + 42, len - 42) != 0))
+	{
+		fprintf(stderr, "sim: eth frame %u : len %u flags %X\n",
+		        seed, frame->len, frame->flags);
+		return(-1);
+	}
+	return(0);
+}
+
+/**
+ * @brief Check the rings and buffers of the driver (host build)
+ *
+ * In MAC loopback : round trip of frames of 1 to 4 segments over several
+ * turns of the rings (content, checksum flags, done callbacks), receive
+ * with all the buffers held by the caller (frames dropped, held buffers
+ * intact, reception resumes after release), transmit ring full, release
+ * of a foreign buffer.
+ *
+ * @return integer Number of failed checks
+ */
+int test_eth(void)
+{
+	static u8 foreign[ETH_BUF_SIZE];
+	eth_frame held[ETH_RX_BUFS];
+	eth_frame frame;
+	eth_stats ref;
+	uint i, n;
+	uint fail = 0;
+
+	eth_loopback(1);
+	// Nothing pending from the init of other modules
+	eth_poll();
+	while (eth_recv(&frame) == 0)
+		eth_release(&frame);
+	ref = eth_stat;
+	test_done = 0;
+
+	// Round trip, the rings turn three times
+	for (i = 0; i < TEST_FRAMES; i++)
+	{
+		n = _test_frame(i, (i % 5) != 0);
+		if (_test_send(n, 1 + (i % 4)) != 0)
+		{
+			fail++;
+			break;
+		}
+		if ((eth_recv(&frame) != 0) || (_test_check(&frame, i, (i % 5) != 0) != 0))
+			fail++;
+		else
+			eth_release(&frame);
+		eth_poll();
+	}
+	if ((test_done != TEST_FRAMES) || (eth_stat.rx - ref.rx != TEST_FRAMES) ||
+	    (eth_stat.tx - ref.tx != TEST_FRAMES))
+		fail++;
+
+	// All the buffers held : the next frames are dropped, not overwritten
+	for (n = 0; n < ETH_RX_BUFS; n++)
+	{
+		_test_send(_test_frame(100 + n, 1), 2);
+		eth_poll();
+		if (eth_recv(&held[n]) != 0)
+			break;
+	}
+	ref = eth_stat;
+	_test_send(_test_frame(200, 1), 2);
+	eth_poll();
+	if ((n != (ETH_RX_BUFS - ETH_RX_DESC)) || (eth_recv(&frame) == 0) ||
+	    (eth_stat.rx_nobuf == ref.rx_nobuf))
+		fail++;
+	for (i = 0; i < n; i++)
+	{
+		if (_test_check(&held[i], 100 + i, 1) != 0)
+			fail++;
+		eth_release(&held[i]);
+	}
+	_test_send(_test_frame(201, 1), 3);
+	eth_poll();
+	if ((eth_recv(&frame) != 0) || (_test_check(&frame, 201, 1) != 0))
+		fail++;
+	else
+		eth_release(&frame);
+
+	// Transmit ring full : refused until eth_poll() reclaims it
+	ref = eth_stat;
+	for (n = 0; _test_send(_test_frame(n, 1), 2) == 0; n++)
+		;
+	if ((n != ETH_TX_DESC) || (eth_stat.tx_full != ref.tx_full + 1))
+		fail++;
+	eth_poll();
+	if (_test_send(_test_frame(0, 1), 2) != 0)
+		fail++;
+	eth_poll();
+	while (eth_recv(&frame) == 0)
+		eth_release(&frame);
+
+	// A buffer that does not come from eth_recv()
+	frame.data = foreign;
+	if (eth_release(&frame) != -1)
+		fail++;
+
+	eth_loopback(0);
+	fprintf(stderr, "sim: eth test %s (%u frames)\n",
+	        fail ? "FAILED" : "passed", eth_stat.rx);
+	return((int)fail);
+}
+/* EOF */
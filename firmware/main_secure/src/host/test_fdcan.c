@@ -0,0 +1,177 @@
+/**
+ * @file  host/test_fdcan.c
+ * @brief Checks of the FDCAN driver (host build, "--fdcan-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "hardware.h"
+#include "driver/fdcan.h"
+#include "irq.h"
+#include "host/test.h"
+
+static fdcan_msg test_msg;
+static uint      test_count;
+
+/**
+ * @brief Handler of FIFO 0 during the test : keep the last message
+ */
+static void _test_rx(const fdcan_msg *msg)
+{
+	test_msg = *msg;
+	test_count++;
+}
+
+/**
+ * @brief Give a message of the bus to the model and check where it goes
+ *
+ * @param id     Identifier of the message
+ * @param xtd    Non-zero for an extended identifier
+ * @param fifo   Expected FIFO (0 or 1), -1 if the message must be rejected
+ * @param filter Expected index of the matching filter (FIFO 0)
+ * @return integer Zero if the message has been routed as expected
+ */
+static int _test_route(u32 id, int xtd, int fifo, uint filter)
+{
+	uint count = test_count;
+	int  r = sim_fdcan_rx(id, xtd, 0, (const u8 *)"\x5A", 1);
+
+	if ((r == fifo) && ((fifo != 0) ||
+	    ((test_count == count + 1) && (test_msg.id == id) && (test_msg.filter == filter))))
+		return(0);
+	fprintf(stderr, "sim: fdcan id %X%s : fifo %d, %d expected\n",
+	        id, xtd ? " (ext)" : "", r, fifo);
+	return(-1);
+}
+
+/**
+ * @brief Check the filters and routing of the driver (host build)
+ *
+ * Filters of a node : bounds of the alert, door command and synchronization
+ * ranges, extended identifiers that match a standard filter. Filters given
+ * by the caller : first match wins, dual and reject filters, too many
+ * filters. Data of classic and FD messages, FIFO 0 full while its handler
+ * is masked, queue of FIFO 1 full, loopback of the node's own commands.
+ *
+ * @return integer Number of failed checks
+ */
+int test_fdcan(void)
+{
+	static const fdcan_filter custom[3] =
+	{
+		{ 0, FDCAN_RANGE, FDCAN_REJECT, 0x200, 0x20F },
+		{ 0, FDCAN_RANGE, FDCAN_FIFO0,  0x200, 0x2FF },
+		{ 0, FDCAN_DUAL,  FDCAN_FIFO1,  0x300, 0x305 },
+	};
+	fdcan_filter many[FDCAN_EXT_MAX + 1];
+	fdcan_msg msg;
+	u8   data[64];
+	u32  prev, base;
+	uint i, fail = 0;
+
+	fdcan_init(3);
+	fdcan_handler(_test_rx);
+	base = FDCAN_ID_DOOR + (3 * FDCAN_ID_DOOR_NODE);
+
+	// Filters of node 3
+	fail += (_test_route(FDCAN_ID_ALERT, 0, 0, 0) != 0);
+	fail += (_test_route(FDCAN_ID_ALERT_END, 0, 0, 0) != 0);
+	fail += (_test_route(FDCAN_ID_ALERT - 1, 0, -1, 0) != 0);
+	fail += (_test_route(FDCAN_ID_ALERT_END + 1, 0, -1, 0) != 0);
+	fail += (_test_route(base, 0, 0, 1) != 0);
+	fail += (_test_route(base + FDCAN_ID_DOOR_NODE - 1, 0, 0, 1) != 0);
+	fail += (_test_route(base - 1, 0, -1, 0) != 0);
+	fail += (_test_route(base + FDCAN_ID_DOOR_NODE, 0, -1, 0) != 0);
+	fail += (_test_route(base, 1, -1, 0) != 0);
+	fail += (_test_route(FDCAN_ID_SYNC, 1, 1, 0) != 0);
+	fail += (_test_route(FDCAN_ID_SYNC | 0xFFFFF, 1, 1, 0) != 0);
+	fail += (_test_route(FDCAN_ID_SYNC + 0x100000, 1, -1, 0) != 0);
+	while (fdcan_recv(&msg) == 0)
+		;
+
+	// Data : classic frame, FD frame padded to the next length
+	for (i = 0; i < 64; i++)
+		data[i] = (u8)(i * 13);
+	sim_fdcan_rx(base, 0, 0, data, 8);
+	if ((test_msg.len != 8) || (test_msg.flags != 0) || memcmp(test_msg.data, data, 8))
+		fail++;
+	sim_fdcan_rx(base, 0, 1, data, 13);
+	if ((test_msg.len != 16) || (test_msg.flags != (FDCAN_FD | FDCAN_BRS)) ||
+	    memcmp(test_msg.data, data, 13) || test_msg.data[13] || test_msg.data[15])
+		fail++;
+	sim_fdcan_rx(FDCAN_ID_SYNC + 7, 1, 1, data, 64);
+	if ((fdcan_recv(&msg) != 0) || (msg.id != FDCAN_ID_SYNC + 7) || (msg.len != 64) ||
+	    (msg.flags != (FDCAN_XTD | FDCAN_FD | FDCAN_BRS)) || memcmp(msg.data, data, 64))
+		fail++;
+
+	// FIFO 0 full while its handler is masked, then drained
+	fdcan_stat.lost[0] = 0;
+	prev = irq_lock(IRQ_PRIO_DOOR);
+	i = test_count;
+	fail += (sim_fdcan_rx(base, 0, 0, data, 1) != 0);
+	fail += (sim_fdcan_rx(base, 0, 0, data, 1) != 0);
+	fail += (sim_fdcan_rx(base, 0, 0, data, 1) != 0);
+	fail += (sim_fdcan_rx(base, 0, 0, data, 1) != -2);
+	irq_unlock(prev);
+	if ((test_count != i + FDCAN_FIFO_LEN) || (fdcan_stat.lost[0] != 1))
+		fail++;
+
+	// Queue of FIFO 1 full : the oldest messages are kept, in order
+	fdcan_stat.drop = 0;
+	for (i = 0; i < FDCAN_SYNC_QUEUE + 2; i++)
+		sim_fdcan_rx(FDCAN_ID_SYNC + i, 1, 0, data, 8);
+	for (i = 0; fdcan_recv(&msg) == 0; i++)
+		if (msg.id != FDCAN_ID_SYNC + i)
+			fail++;
+	if ((i != FDCAN_SYNC_QUEUE) || (fdcan_stat.drop != 2))
+		fail++;
+
+	// Filters of the caller : the first match wins
+	if (fdcan_filters(custom, 3) != 0)
+		fail++;
+	fail += (_test_route(0x205, 0, -1, 0) != 0);
+	fail += (_test_route(0x210, 0,  0, 1) != 0);
+	fail += (_test_route(0x2FF, 0,  0, 1) != 0);
+	fail += (_test_route(0x300, 0,  1, 0) != 0);
+	fail += (_test_route(0x305, 0,  1, 0) != 0);
+	fail += (_test_route(0x304, 0, -1, 0) != 0);
+	fail += (_test_route(FDCAN_ID_ALERT, 0, -1, 0) != 0);
+	while (fdcan_recv(&msg) == 0)
+		;
+	memset(many, 0, sizeof(many));
+	for (i = 0; i <= FDCAN_EXT_MAX; i++)
+		many[i].xtd = 1;
+	if (fdcan_filters(many, FDCAN_EXT_MAX + 1) != -1)
+		fail++;
+
+	// Loopback : the command of this node comes back, not the other one
+	fdcan_init(3);
+	fdcan_handler(_test_rx);
+	fdcan_loopback(1);
+	memset(&msg, 0, sizeof(msg));
+	msg.id  = base + FDCAN_ID_DOOR_NODE;
+	msg.len = 4;
+	i = test_count;
+	fdcan_send(&msg);
+	msg.id = base + 2;
+	fdcan_send(&msg);
+	if ((test_count != i + 1) || (test_msg.id != base + 2) || (test_msg.len != 4))
+		fail++;
+
+	fdcan_init(0);
+	fdcan_handler(0);
+	fprintf(stderr, "sim: fdcan test %s (%u messages)\n",
+	        fail ? "FAILED" : "passed", fdcan_stat.rx[0] + fdcan_stat.rx[1]);
+	return((int)fail);
+}
+/* EOF */
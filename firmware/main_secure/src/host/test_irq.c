@@ -0,0 +1,62 @@
+/**
+ * @file  host/test_irq.c
+ * @brief Checks of the interrupt lines against the vectors (host build, "--irq-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "irq.c" // Table of the interrupt lines (private)
+#include "host/test.h"
+
+// Peripheral vectors of startup.s, without "_Handler" (generated)
+static const char *const vectors[] =
+{
+#include "vectors.h"
+};
+
+/**
+ * @brief Check the interrupt numbers of the table (host build)
+ *
+ * The simulated NVIC calls the handler given to sim_vector() whatever the
+ * number of its line : a wrong IRQ_* value would only be seen on target.
+ * The number of each line of the table must be the index of the vector of
+ * the same name into startup.s, and the vector table must have the
+ * IRQ_LINES lines of the STM32H563.
+ *
+ * @return integer Number of failed checks
+ */
+int test_irq(void)
+{
+	uint i, fail = 0;
+
+	if (ARRAY_SIZE(vectors) != IRQ_LINES)
+	{
+		fprintf(stderr, "sim: irq vector table of %u lines, %u expected\n",
+		        (uint)ARRAY_SIZE(vectors), IRQ_LINES);
+		fail++;
+	}
+	for (i = 0; i < ARRAY_SIZE(irq_table); i++)
+	{
+		if ((irq_table[i].irq < ARRAY_SIZE(vectors)) &&
+		    (strcmp(vectors[irq_table[i].irq], irq_table[i].name) == 0))
+			continue;
+		fprintf(stderr, "sim: irq %s : line %u is the vector of %s\n",
+		        irq_table[i].name, irq_table[i].irq,
+		        (irq_table[i].irq < ARRAY_SIZE(vectors)) ? vectors[irq_table[i].irq] : "-");
+		fail++;
+	}
+	fprintf(stderr, "sim: irq test %s (%u lines)\n",
+	        fail ? "FAILED" : "passed", (uint)ARRAY_SIZE(irq_table));
+	return((int)fail);
+}
+/* EOF */
@@ -0,0 +1,127 @@
+/**
+ * @file  host/test_monitor.c
+ * @brief Checks of the analog inputs classifier (host build, "--monitor-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include "monitor.c" // Thresholds of the inputs (private)
+#include "host/test.h"
+
+#define TEST_BATCHES 20000
+
+/**
+ * @brief Classify a half-buffer one sample at a time (test reference)
+ *
+ * @param buf   Pointer to the samples (scans sequences of MON_CHANNELS)
+ * @param scans Number of sequences (1 to 16)
+ * @param out   Pointer to the result
+ */
+static void _test_classify(const u16 *buf, uint scans, mon_batch *out)
+{
+	uint i, s, c, v, sum;
+	int  cls;
+
+	for (i = 0; i < MON_CHANNELS; i++)
+	{
+		cls = -1;
+		sum = 0;
+		for (s = 0; s < scans; s++)
+		{
+			v = buf[(s * MON_CHANNELS) + i] & 0x0FFF;
+			sum += v;
+			for (c = 0; (c < 3) && (v >= inputs[i].thr[c]); c++)
+				;
+			if (cls == -1)
+				cls = (int)c;
+			else if (cls != (int)c)
+				cls = MON_UNSTABLE;
+		}
+		out->state[i] = (u8)cls;
+		out->mean[i]  = (u16)(sum / scans);
+	}
+}
+
+/**
+ * @brief Check the classifier against a scalar reference (host build)
+ *
+ * Random halves of 1 to 16 sequences : inputs with all their samples in
+ * one class (values drawn up to the bounds of the class, thresholds
+ * included) or spread over two classes, and samples at 0 and 4095 (sums
+ * at the limit of the 16 bits lanes).
+ *
+ * @return integer Number of failed checks
+ */
+int test_monitor(void)
+{
+	static u16 buf[16 * MON_CHANNELS];
+	mon_batch ref, res;
+	u32  seed = 0x4D4F4E31;
+	uint lo, hi, cls, n, scans, i, s, k;
+	uint fail = 0;
+
+	for (n = 0; n < TEST_BATCHES; n++)
+	{
+		seed  = (seed * 1103515245) + 12345;
+		scans = 1 + ((seed >> 16) % 16);
+		for (i = 0; i < MON_CHANNELS; i++)
+		{
+			seed = (seed * 1103515245) + 12345;
+			cls  = (seed >> 16) & 3;
+			for (s = 0; s < scans; s++)
+			{
+				seed = (seed * 1103515245) + 12345;
+				// One input out of four : the class changes into the half
+				k = ((n & 3) == (i & 3)) ? ((cls + s) & 3) : cls;
+				lo = k ? inputs[i].thr[k - 1] : 0;
+				hi = (k < 3) ? inputs[i].thr[k] : 4096;
+				if (lo >= hi)
+					lo = hi = (hi > 4095) ? 4095 : hi;
+				// Bounds of the class one time out of eight
+				switch ((seed >> 8) & 15)
+				{
+					case 0:  buf[(s * MON_CHANNELS) + i] = (u16)lo; break;
+					case 1:  buf[(s * MON_CHANNELS) + i] = (u16)((hi > lo) ? (hi - 1) : hi); break;
+					case 2:  buf[(s * MON_CHANNELS) + i] = (n & 8) ? 4095 : 0; break;
+					default:
+						buf[(s * MON_CHANNELS) + i] = (u16)(lo + ((seed >> 16) % ((hi > lo) ? (hi - lo) : 1)));
+						break;
+				}
+			}
+		}
+		monitor_classify(buf, scans, &res);
+		_test_classify(buf, scans, &ref);
+		for (i = 0; i < MON_CHANNELS; i++)
+		{
+			if ((res.state[i] == ref.state[i]) && (res.mean[i] == ref.mean[i]))
+				continue;
+			fprintf(stderr, "sim: monitor batch %u input %u : %u/%u, %u expected\n",
+			        n, i, res.state[i], res.mean[i], ref.state[i]);
+			fail++;
+			break;
+		}
+		if (fail > 8)
+			break;
+	}
+	// Largest sums of the lanes : 16 sequences at 4095
+	for (i = 0; i < 16 * MON_CHANNELS; i++)
+		buf[i] = 4095;
+	monitor_classify(buf, 16, &res);
+	for (i = 0; i < MON_CHANNELS; i++)
+		if ((res.mean[i] != 4095) || (res.state[i] != ((i == MON_SUPPLY) ? MON_OPEN : MON_CUT)))
+			fail++;
+
+	fprintf(stderr, "sim: monitor test %s (%u batches)\n",
+	        fail ? "FAILED" : "passed", n);
+	return((int)fail);
+}
+/* EOF */
@@ -0,0 +1,115 @@
+/**
+ * @file  host/test_pool.c
+ * @brief Stress test of the free list of the pools (host build, "--pool-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include "pool.c" // Layout of the free list head (private)
+#include "host/test.h"
+
+#define TEST_THREADS 4
+#define TEST_HELD    3
+#define TEST_LOOPS   100000
+
+POOL_DEFINE(pool_stress, 16, 8, POOL_SRAM3);
+static u32 stress_errors;
+
+/**
+ * @brief Worker of the stress test : take blocks, mark, check, release
+ *
+ * @param arg Pointer to the identifier of the thread
+ */
+static void *_stress(void *arg)
+{
+	u32  id = *(u32 *)arg;
+	u32 *held[TEST_HELD];
+	uint i, j, n;
+
+	for (i = 0; i < TEST_LOOPS; i++)
+	{
+		n = 0;
+		for (j = 0; j < TEST_HELD; j++)
+			if ((held[n] = pool_alloc(&pool_stress)) != 0)
+				n++;
+		for (j = 0; j < n; j++)
+		{
+			held[j][0] = id;
+			held[j][1] = i;
+			held[j][2] = j;
+		}
+		// A block given twice is marked by two threads
+		for (j = 0; j < n; j++)
+			if ((held[j][0] != id) || (held[j][1] != i) || (held[j][2] != j))
+				__atomic_fetch_add(&stress_errors, 1, __ATOMIC_RELAXED);
+		for (j = 0; j < n; j++)
+			if (pool_free(&pool_stress, held[j]) != 0)
+				__atomic_fetch_add(&stress_errors, 1, __ATOMIC_RELAXED);
+	}
+	return(0);
+}
+
+/**
+ * @brief Stress test of the free list (host build)
+ *
+ * Threads take more blocks than the pool holds and release them in a loop
+ * (the threads of the host preempt each other at any instruction, like
+ * interrupt handlers on target). A block must never be given twice, and
+ * the free list must hold all the blocks at the end.
+ *
+ * @return integer Zero on success, else number of failed checks
+ */
+int test_pool(void)
+{
+	pthread_t thread[TEST_THREADS];
+	u32  id[TEST_THREADS];
+	u8   seen[8];
+	u32  index;
+	uint fail, i, n;
+
+	pool_create(&pool_stress);
+	stress_errors = 0;
+	fail = 0;
+	for (i = 0; i < TEST_THREADS; i++)
+	{
+		id[i] = i + 1;
+		if (pthread_create(&thread[i], 0, _stress, &id[i]) != 0)
+			fail++;
+	}
+	for (i = 0; i < TEST_THREADS; i++)
+		pthread_join(thread[i], 0);
+	fail += stress_errors;
+
+	// All blocks back into the free list, each one once
+	for (i = 0; i < pool_stress.count; i++)
+		seen[i] = 0;
+	n = 0;
+	for (index = pool_stress.head & HEAD_INDEX; index; n++)
+	{
+		if ((index > pool_stress.count) || seen[index - 1] || (n > pool_stress.count))
+		{
+			fail++;
+			break;
+		}
+		seen[index - 1] = 1;
+		index = *(u32 *)(pool_stress.mem + ((index - 1) * pool_stress.size));
+	}
+	if ((n != pool_stress.count) || (pool_stress.used != 0) ||
+	    (pool_stress.high > pool_stress.count))
+		fail++;
+
+	fprintf(stderr, "sim: pool test %s (%u threads, %u empty pool)\n",
+	        fail ? "FAILED" : "passed", TEST_THREADS, pool_stress.fails);
+	return((int)fail);
+}
+/* EOF */
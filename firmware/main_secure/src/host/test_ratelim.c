@@ -0,0 +1,141 @@
+/**
+ * @file  host/test_ratelim.c
+ * @brief Checks of the rate limiter across the wrap of the clock (host build, "--ratelim-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include "ratelim.c" // Buckets, refill and clock offset (private)
+#include "host/test.h"
+
+/**
+ * @brief Check the buckets around the wrap of the clock (host build)
+ *
+ * The refill is compared with a 64 bits reference for times that wrap
+ * (bucket stamped just before the wrap, used just after), and elapsed
+ * times up to 2^32 - 1. The lockout and its doubling are checked across
+ * the wrap, and the branch free comparisons against the C operators. Then
+ * the clock offset is moved so that attempts are made across the wrap.
+ *
+ * @return integer Number of failed checks
+ */
+int test_ratelim(void)
+{
+	static const u32 edges[] =
+	{
+		0, 1, 2, 0x7FFFFFFE, 0x7FFFFFFF, 0x80000000, 0x80000001,
+		0xFFFFFFFE, 0xFFFFFFFF, RATELIM_ONE, RATELIM_ONE - 1,
+	};
+	const ratelim_param *par;
+	ratelim_bucket b;
+	u64  ref;
+	u32  seed = 0x524C4D31;
+	u32  t, e, n;
+	uint fail = 0;
+	uint i, j;
+
+	// Branch free helpers
+	for (i = 0; i < (sizeof(edges) / sizeof(edges[0])); i++)
+		for (j = 0; j < (sizeof(edges) / sizeof(edges[0])); j++)
+		{
+			if ((_ct_lt(edges[i], edges[j]) != ((edges[i] < edges[j]) ? 0xFFFFFFFF : 0)) ||
+			    (_ct_eq(edges[i], edges[j]) != ((edges[i] == edges[j]) ? 0xFFFFFFFF : 0)) ||
+			    (_ct_min(edges[i], edges[j]) != ((edges[i] < edges[j]) ? edges[i] : edges[j])))
+				fail++;
+		}
+
+	// Refill, stamp before the wrap and use after (or far later)
+	for (i = 0; i < 20000; i++)
+	{
+		par = (i & 1) ? &cred_par : &reader_par;
+		seed = (seed * 1103515245) + 12345;
+		t = 0xFFFFFFFF - ((seed >> 8) % (2 * par->full));
+		seed = (seed * 1103515245) + 12345;
+		switch ((seed >> 16) & 3)
+		{
+			case 0:  e = (seed >> 8) % (3 * par->full); break;
+			case 1:  e = par->full - 1 + ((seed >> 16) & 1); break;
+			case 2:  e = 0xFFFFFFFF - ((seed >> 8) & 0xFF); break;
+			default: e = (seed & 0xFFFF0000) | (seed >> 24); break;
+		}
+		seed = (seed * 1103515245) + 12345;
+		b.stamp  = t;
+		b.tokens = (seed >> 4) % (par->cap + 1);
+		ref = b.tokens + ((u64)((e < par->full) ? e : par->full) * par->rate);
+		if (ref > par->cap)
+			ref = par->cap;
+		_refill(&b, t + e, par);
+		if ((b.tokens != (u32)ref) || (b.stamp != (t + e)))
+			fail++;
+	}
+	// One attempt back in (at most) the refill time, full after `full`
+	b.stamp  = 0xFFFFFFFF - 2;
+	b.tokens = 0;
+	_refill(&b, b.stamp + RATELIM_CRED_REFILL, &cred_par);
+	if (b.tokens < RATELIM_ONE)
+		fail++;
+	b.tokens = 0;
+	_refill(&b, b.stamp + cred_par.full - 1, &cred_par);
+	if (b.tokens >= cred_par.cap)
+		fail++;
+	_refill(&b, b.stamp + 1, &cred_par);
+	if (b.tokens != cred_par.cap)
+		fail++;
+
+	// Lockout across the wrap, doubled by each new failure
+	for (n = 0; n < 10; n++)
+	{
+		b.fails = cred_par.fails + n;
+		b.since = 0xFFFFFFFF - 4;
+		e = (u32)RATELIM_LOCK_MIN << ((n < RATELIM_LOCK_SHIFT) ? n : RATELIM_LOCK_SHIFT);
+		if (( ! _locked(&b, b.since + e - 1, &cred_par)) ||
+		    _locked(&b, b.since + e, &cred_par))
+			fail++;
+	}
+	b.fails = cred_par.fails - 1;
+	if (_locked(&b, b.since, &cred_par))
+		fail++;
+
+	// Attempts across the wrap of the clock : 3 allowed, one back after 60 s
+	clock_base = (0xFFFFFFFF - 1) - (u32)(systime_ticks() >> RATELIM_TICK_SHIFT);
+	for (i = 0; i < RATELIM_CRED_BURST; i++)
+		if (ratelim_attempt(i, 1234) != RATELIM_OK)
+			fail++;
+	if (ratelim_attempt(4, 1234) != RATELIM_THROTTLED)
+		fail++;
+	clock_base += RATELIM_CRED_REFILL;
+	if ((ratelim_now() > RATELIM_CRED_REFILL) ||
+	    (ratelim_attempt(5, 1234) != RATELIM_OK) ||
+	    (ratelim_attempt(6, 1234) != RATELIM_THROTTLED))
+		fail++;
+	// Lockout started before the wrap, ends after it (token back after 60 s)
+	clock_base = (0xFFFFFFFF - 8) - (u32)(systime_ticks() >> RATELIM_TICK_SHIFT);
+	for (i = 0; i < RATELIM_CRED_FAILS; i++)
+	{
+		if (ratelim_attempt(8 + i, 5678) != RATELIM_OK)
+			fail++;
+		ratelim_result(8 + i, 5678, 0);
+	}
+	clock_base += RATELIM_LOCK_MIN - 16;
+	if (ratelim_attempt(12, 5678) != RATELIM_LOCKED)
+		fail++;
+	clock_base += RATELIM_CRED_REFILL - RATELIM_LOCK_MIN + 16;
+	if (ratelim_attempt(13, 5678) != RATELIM_OK)
+		fail++;
+
+	fprintf(stderr, "sim: ratelim test %s (%u allowed, %u throttled, %u locked)\n",
+	        fail ? "FAILED" : "passed", ratelim_stat.allowed,
+	        ratelim_stat.throttled, ratelim_stat.locked);
+	ratelim_init();
+	return((int)fail);
+}
+/* EOF */
@@ -0,0 +1,219 @@
+/**
+ * @file  host/test_seq.c
+ * @brief Checks of the sequence compiler (host build, "--seq-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include "seq.c" // Compiler and lists of the tracks (private)
+#include "host/test.h"
+
+// Periods recorded by the test (longest sequence : 50 s)
+#define TEST_PERIODS 200016
+#define TEST_BASE    0x30010000
+
+static u8  test_out[2][TEST_PERIODS];
+static u16 test_ccr[2][TEST_PERIODS];
+
+/**
+ * @brief Expected outputs of a sequence, period by period
+ *
+ * @param desc   Pointer to the waveform descriptor
+ * @param target Pointer to the registers and pins of the track
+ * @return u32 Number of periods of one play of the list (all repeats)
+ */
+static u32 _test_expect(const seq_desc *desc, const seq_target *target)
+{
+	const seq_step *step;
+	u32  ticks, duty, prev = 0xFFFFFFFF;
+	u32  n = 0;
+	uint play, i;
+	u8   out = 0;
+	u16  ccr = 0;
+
+	for (play = 0; (play == 0) || (play < desc->repeat); play++)
+	{
+		for (i = 0; i < desc->count; i++)
+		{
+			step  = &desc->steps[i];
+			ticks = ((u32)step->ms * 1000) / target->period;
+			if ((ticks == 0) || ((n + ticks + 3) > TEST_PERIODS))
+				continue;
+			duty = (step->duty > 100) ? 100 : step->duty;
+			// A change of duty uses the first period, outputs unchanged
+			if (duty != prev)
+			{
+				prev = duty;
+				ccr  = (u16)((duty * target->period) / 100);
+				test_out[0][n] = out;
+				test_ccr[0][n++] = ccr;
+				if (ticks > 1)
+					ticks--;
+			}
+			out = step->out;
+			for ( ; ticks; ticks--)
+			{
+				test_out[0][n] = out;
+				test_ccr[0][n++] = ccr;
+			}
+		}
+	}
+	if (desc->repeat != SEQ_FOREVER)
+	{
+		test_out[0][n] = out;
+		test_ccr[0][n++] = 0;
+		test_out[0][n] = 0;
+		test_ccr[0][n++] = 0;
+	}
+	return(n);
+}
+
+/**
+ * @brief Play a compiled list like the DMA, record the outputs
+ *
+ * @param target Pointer to the registers and pins of the track
+ * @param nodes  Pointer to the items
+ * @param count  Number of items
+ * @param loop   Pointer to the end state (1 linked to the first item)
+ * @return u32 Number of periods, 0 if an item is malformed
+ */
+static u32 _test_play(const seq_target *target, const seq_node *nodes,
+                      uint count, int *loop)
+{
+	const seq_node *node;
+	u32  addr = TEST_BASE;
+	u32  gpio = 0, n = 0, k;
+	uint i, o, items;
+	u16  ccr = 0;
+
+	for (items = 0; items < count; items++)
+	{
+		i = (addr - TEST_BASE) / (u32)sizeof(seq_node);
+		node = &nodes[i];
+		if ((addr < TEST_BASE) || (i >= count) ||
+		    (node->lli.sar != addr + (u32)sizeof(dma_lli)) ||
+		    (node->lli.br1 == 0) || (node->lli.br1 > DMA_BLOCK_MAX) ||
+		    ((n + (node->lli.br1 / 4)) > TEST_PERIODS))
+			return(0);
+		for (k = 0; k < node->lli.br1 / 4; k++)
+		{
+			if (node->lli.dar == target->bsrr)
+				gpio = (gpio | (node->value & 0xFFFF)) & ~(node->value >> 16);
+			else if (node->lli.dar == target->ccr)
+				ccr = (u16)node->value;
+			else
+				return(0);
+			test_out[1][n] = 0;
+			for (o = 0; o < SEQ_OUTS; o++)
+				if (gpio & target->pins[o])
+					test_out[1][n] |= (u8)(1u << o);
+			test_ccr[1][n++] = ccr;
+		}
+		if (node->lli.llr == 0)
+		{
+			*loop = 0;
+			return(n);
+		}
+		if ((node->lli.llr & SEQ_LINK) != SEQ_LINK)
+			return(0);
+		// The next item is into the same 64 KB segment
+		addr = (addr & ~(u32)DMA_LLI_LA) | (node->lli.llr & DMA_LLI_LA);
+		if (addr == TEST_BASE)
+		{
+			*loop = 1;
+			return(n);
+		}
+	}
+	return(0);
+}
+
+/**
+ * @brief Test of the descriptor compiler (host build)
+ *
+ * Each descriptor is compiled, then the list is played like the DMA does
+ * (count, source, destination and link of each item) : the outputs and
+ * the duty of each period must match the steps of the descriptor.
+ *
+ * @return integer Zero on success, else number of failed checks
+ */
+int test_seq(void)
+{
+	static const seq_step long_steps[] =
+	{
+		{ 30000, SEQ_OUT_RED,   120 }, // Split, duty clamped to 100%
+		{     0, SEQ_OUT_GREEN,  10 }, // Shorter than one period : skipped
+		{ 20000, SEQ_OUT_STRIKE, 10 },
+	};
+	static const seq_step short_steps[] =
+	{
+		{ 1, SEQ_OUT_GREEN, 20 },
+		{ 1, SEQ_OUT_RED,   20 },
+		{ 1, 0,             40 },
+	};
+	static const seq_desc valid[] =
+	{
+		{ "long",  long_steps,  3, 1, SEQ_PRIO_STATUS },
+		{ "short", short_steps, 3, 5, SEQ_PRIO_STATUS },
+	};
+	static const seq_desc empty = { "empty", long_steps + 1, 1, 1, SEQ_PRIO_STATUS };
+	static const seq_desc many  = { "many",  short_steps, 3, 40, SEQ_PRIO_STATUS };
+	static seq_node nodes[SEQ_NODES];
+	const seq_desc *list[5];
+	seq_target zero;
+	u32  n, p;
+	uint i, cases;
+	int  count, loop;
+	uint fail = 0;
+
+	list[0] = &seq_grant;
+	list[1] = &seq_deny;
+	list[2] = &seq_alarm;
+	list[3] = &valid[0];
+	list[4] = &valid[1];
+	for (i = 0; i < 5; i++)
+	{
+		count = seq_compile(list[i], &seq_tracks[i & 1].target, nodes, SEQ_NODES, TEST_BASE);
+		n = _test_expect(list[i], &seq_tracks[i & 1].target);
+		loop = -1;
+		p = (count > 0) ? _test_play(&seq_tracks[i & 1].target, nodes, (uint)count, &loop) : 0;
+		if ((p != n) || (loop != (list[i]->repeat == SEQ_FOREVER)))
+		{
+			fprintf(stderr, "sim: seq %s : %u periods played, %u expected\n",
+			        list[i]->name, p, n);
+			fail++;
+			continue;
+		}
+		for (p = 0; p < n; p++)
+			if ((test_out[0][p] != test_out[1][p]) || (test_ccr[0][p] != test_ccr[1][p]))
+				break;
+		if (p != n)
+		{
+			fprintf(stderr, "sim: seq %s : period %u, outputs %X duty %u\n",
+			        list[i]->name, p, test_out[1][p], test_ccr[1][p]);
+			fail++;
+		}
+	}
+	cases = i;
+
+	// Refused : nothing to play, too many items, no period
+	zero = seq_tracks[0].target;
+	zero.period = 0;
+	if ((seq_compile(&empty, &seq_tracks[0].target, nodes, SEQ_NODES, TEST_BASE) != -1) ||
+	    (seq_compile(&many, &seq_tracks[0].target, nodes, SEQ_NODES, TEST_BASE) != -1) ||
+	    (seq_compile(&seq_grant, &zero, nodes, SEQ_NODES, TEST_BASE) != -1))
+		fail++;
+
+	fprintf(stderr, "sim: seq test %s (%u descriptors)\n",
+	        fail ? "FAILED" : "passed", cases);
+	return((int)fail);
+}
+/* EOF */
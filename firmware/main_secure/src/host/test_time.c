@@ -0,0 +1,123 @@
+/**
+ * @file  host/test_time.c
+ * @brief Checks of the time base across wraparounds (host build, "--time-test")
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <stdio.h>
+#include "systime.c" // Timer, calendar and calibration (private)
+#include "host/test.h"
+
+/**
+ * @brief Test of the time base across wraparounds (host build)
+ *
+ * The 32 bits overflow of TIM2 is crossed with interrupts masked (pending
+ * overflow) and by a STOP period, the wall-clock is interpolated from an
+ * anchor older than 2^32 ticks, and the RTC calendar is written and read
+ * back from 2000 to 2099. The calendar of the simulated RTC is restored.
+ *
+ * @return integer Zero on success, else number of failed checks
+ */
+int test_time(void)
+{
+	static const u32 dates[] =
+	{
+		0, 59 * 86400, (366 * 86400) - 1, 366 * 86400,
+		(366 + (3 * 365) + 59) * 86400, (36525 * 86400u) - 1,
+	};
+	u64  t, prev, end;
+	u32  irq, hi, sec, frac, ref, d, lcg;
+	uint fail, i;
+
+	fail = 0;
+	ref = _rtc_read(&frac);
+
+	// Overflow of TIM2 while its interrupt is held : UIF extends the count
+	irq = hw_irq_save();
+	hi  = time_hi;
+	reg_wr(TIM_CNT(TIM2), 0xFFFFFFFF - (SYSTIME_HZ / 1000));
+	prev = systime_ticks();
+	do
+	{
+		t = systime_ticks();
+		if ((t < prev) || (systime_ns() < ((prev * 125) >> 2)))
+			break;
+		prev = t;
+	} while ((u32)t > (SYSTIME_HZ / 1000));
+	if ((t != prev) || ((t >> 32) != hi + 1) || (time_hi != hi))
+		fail++;
+	// Let the count run 1 ms after the overflow
+	end = t + (SYSTIME_HZ / 1000);
+	while ((t = systime_ticks()) < end)
+		;
+	hw_irq_restore(irq);
+	// The interrupt is handled now, the count does not move back
+	if ((time_hi != hi + 1) || (systime_ticks() < prev))
+		fail++;
+
+	// Overflow of TIM2 by the correction of a STOP period (one second)
+	irq = hw_irq_save();
+	hi  = time_hi;
+	lp_stop = (_lptim_read() - lp_hz) & 0xFFFF;
+	reg_wr(TIM_CNT(TIM2), 0xFFFFFFFF - 1000);
+	prev = systime_ticks();
+	systime_resume();
+	t = systime_ticks();
+	if ((time_hi != hi + 1) || ((t - prev) < SYSTIME_HZ - 64) ||
+	    ((t - prev) > SYSTIME_HZ + (SYSTIME_HZ / 100)))
+	{
+		fprintf(stderr, "sim: time resume %llu ticks\n", (unsigned long long)(t - prev));
+		fail++;
+	}
+
+	// Anchor older than 2^32 ticks (no RTC interrupt for ~2 minutes)
+	d = 0x3FFFFFFF; // 1/4 s before the second boundary
+	_anchor(systime_ticks() - (((u64)5 << 32) + d), 1000, NS_PER_SEC - 1, SYSTIME_HZ);
+	sec = _wall(&frac);
+	t   = (((u64)5 << 32) + d) / SYSTIME_HZ;
+	if ((sec < 1000 + t) || (sec > 1000 + t + 1) || (frac >= NS_PER_SEC) ||
+	    ((systime_wall_ns() / NS_PER_SEC) < sec))
+	{
+		fprintf(stderr, "sim: time long interval %u.%09u\n", sec, frac);
+		fail++;
+	}
+	hw_irq_restore(irq);
+
+	// Calendar : fixed dates (leap days, end of years), then random ones
+	lcg = 12345;
+	for (i = 0; i < 1000 + (sizeof(dates) / sizeof(dates[0])); i++)
+	{
+		if (i < (sizeof(dates) / sizeof(dates[0])))
+			sec = dates[i];
+		else
+		{
+			lcg = (lcg * 1103515245) + 12345;
+			sec = lcg % (36525 * 86400u);
+		}
+		_rtc_write(sec);
+		d = _rtc_read(&frac) - sec;
+		if (d > 1)
+		{
+			fprintf(stderr, "sim: time calendar %u read as %u\n", sec, sec + d);
+			fail++;
+		}
+	}
+	_rtc_write(ref);
+	last_wakeup = 0;
+	ref = _rtc_read(&frac);
+	_anchor(systime_ticks(), ref, frac, cal.rate);
+
+	fprintf(stderr, "sim: time test %s (%u overflows)\n",
+	        fail ? "FAILED" : "passed", time_hi);
+	return((int)fail);
+}
+/* EOF */
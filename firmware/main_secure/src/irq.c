@@ -0,0 +1,211 @@
+/**
+ * @file  irq.c
+ * @brief Interrupt manager : priorities, security targeting and latency
+ *
+ * All interrupt lines used by the firmware are declared into one table,
+ * with their priority, target security state (NVIC_ITNS) and worst-case
+ * handler duration. The table is applied at boot; lines not declared get
+ * the lowest priority and stay secure. Non-secure priorities are mapped
+ * below the secure ones (AIRCR.PRIS), so the non-secure application can
+ * never delay a secure handler.
+ *
+ * Since the whole configuration is known, the worst-case latency of each
+ * line can be computed (see irq_report).
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "irq.h"
+#include "log.h"
+#include "systime.h"
+
+// Number of interrupt lines of the STM32H563
+#define IRQ_LINES 131
+
+#define AIRCR_VECTKEY  0x05FA0000
+#define AIRCR_KEEP     ((1 << 13) | (1 << 3)) // BFHFNMINS, SYSRESETREQS
+#define AIRCR_PRIS     (1 << 14)
+// All implemented priority bits are used for preemption (no sub-priority)
+#define AIRCR_PRIGROUP (3 << 8)
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
+
+static u32 _latency(const irq_cfg *cfg);
+
+static const irq_cfg irq_table[] =
+{
+	// Card reader bus : must preempt everything else
+	{ "SPI4",       IRQ_SPI4,       IRQ_PRIO_READER, IRQ_SECURE,    0, 200 },
+	{ "EXTI15",     IRQ_EXTI15,     IRQ_PRIO_READER, IRQ_SECURE,    1,  80 },
+	// Time service (see systime.c)
+	{ "TIM2",       IRQ_TIM2,       IRQ_PRIO_TIME,   IRQ_SECURE,    1,  40 },
+	{ "RTC_S",      IRQ_RTC_S,      IRQ_PRIO_TIME,   IRQ_SECURE,    1, 900 },
+	// Supervised inputs : analog watchdogs (see monitor.c)
+	{ "ADC1",       IRQ_ADC1,       IRQ_PRIO_DOOR,   IRQ_SECURE,    1,  60 },
+	// Inter-panel bus : door commands (FIFO 0, see fdcan.c)
+	{ "FDCAN1_IT0", IRQ_FDCAN1_IT0, IRQ_PRIO_DOOR,   IRQ_SECURE,    1, 500 },
+	// Communication
+	{ "USART3",     IRQ_USART3,     IRQ_PRIO_COMM,   IRQ_SECURE,    1, 150 },
+	{ "GPDMA1_CH0", IRQ_GPDMA1_CH0, IRQ_PRIO_COMM,   IRQ_SECURE,    0,  60 },
+	// Crypto
+	{ "HASH",       IRQ_HASH,       IRQ_PRIO_CRYPTO, IRQ_SECURE,    0, 120 },
+	{ "RNG",        IRQ_RNG,        IRQ_PRIO_CRYPTO, IRQ_SECURE,    1, 4500 },
+	// Inter-panel bus : bulk synchronization (FIFO 1)
+	{ "FDCAN1_IT1", IRQ_FDCAN1_IT1, IRQ_PRIO_BULK,   IRQ_SECURE,    1, 600 },
+	// Non-secure application
+	{ "RTC",        IRQ_RTC,        IRQ_PRIO_LOG,    IRQ_NONSECURE, 0,   0 },
+};
+
+static const irq_section irq_sections[] =
+{
+	// Update of the wall-clock anchor, with PRIMASK
+	{ "systime anchor", 0,               30 },
+	// RTC init mode (INITF takes up to 2 RTC clock cycles)
+	{ "systime_set",    IRQ_PRIO_TIME,   2500 },
+	// Copy of one journal record
+	{ "journal_append", IRQ_PRIO_READER, 40 },
+	// Copy of a request from the entropy pool (ENTROPY_GET_MAX bytes)
+	{ "entropy_get",    IRQ_PRIO_READER, 250 },
+	// Update of the buckets of a PIN attempt (reader, credential set)
+	{ "ratelim",        IRQ_PRIO_READER, 300 },
+	// Search of a free transaction of the door pipeline
+	{ "pipe_submit",    IRQ_PRIO_READER, 200 },
+};
+
+/**
+ * @brief Apply the interrupt table
+ *
+ */
+void irq_init(void)
+{
+	u32  itns[(IRQ_LINES + 31) / 32];
+	uint i;
+
+	reg_wr(SCB_AIRCR, AIRCR_VECTKEY | (reg_rd(SCB_AIRCR) & AIRCR_KEEP) |
+	                  AIRCR_PRIS | AIRCR_PRIGROUP);
+
+	// Lines not declared : lowest priority, secure
+	for (i = 0; i < IRQ_LINES; i++)
+		reg8_wr(NVIC_IPR(i), 0xFF);
+	for (i = 0; i < ARRAY_SIZE(itns); i++)
+		itns[i] = 0;
+
+	for (i = 0; i < ARRAY_SIZE(irq_table); i++)
+	{
+		reg8_wr(NVIC_IPR(irq_table[i].irq),
+		        (u8)(irq_table[i].prio << (8 - IRQ_PRIO_BITS)));
+		if (irq_table[i].target == IRQ_NONSECURE)
+			itns[irq_table[i].irq / 32] |= (1u << (irq_table[i].irq % 32));
+	}
+	for (i = 0; i < ARRAY_SIZE(itns); i++)
+		reg_wr(NVIC_ITNS(i), itns[i]);
+
+	for (i = 0; i < ARRAY_SIZE(irq_table); i++)
+		if (irq_table[i].enable)
+			irq_enable(irq_table[i].irq);
+}
+
+/**
+ * @brief Enable an interrupt line
+ *
+ * @param irq Interrupt number
+ */
+void irq_enable(uint irq)
+{
+	reg_wr(NVIC_ISER(irq / 32), 1u << (irq % 32));
+}
+
+/**
+ * @brief Disable an interrupt line
+ *
+ * When this function returns, the handler can no more be called.
+ *
+ * @param irq Interrupt number
+ */
+void irq_disable(uint irq)
+{
+	reg_wr(NVIC_ICER(irq / 32), 1u << (irq % 32));
+#ifndef HOST
+	asm volatile("dsb 0xF":::"memory");
+	asm volatile("isb 0xF":::"memory");
+#endif
+}
+
+/**
+ * @brief Print the worst-case latency of each interrupt line
+ *
+ * The latency is the time between the interrupt request and the first
+ * instruction of its handler (see _latency).
+ */
+void irq_report(void)
+{
+	const irq_cfg *cfg;
+	u32  cycles;
+	uint i;
+
+	log_print(0, "IRQ latency report (%d MHz)\n", SYSTIME_HZ / 1000000);
+	for (i = 0; i < ARRAY_SIZE(irq_table); i++)
+	{
+		cfg = &irq_table[i];
+		if (cfg->target == IRQ_NONSECURE)
+		{
+			log_print(0, " %d %s: prio %d, non-secure (below all secure lines)\n",
+			          cfg->irq, cfg->name, cfg->prio);
+			continue;
+		}
+		cycles = _latency(cfg);
+		log_print(0, " %d %s: prio %d, handler %d, latency %d cycles (%d us)\n",
+		          cfg->irq, cfg->name, cfg->prio, cfg->wcet, cycles,
+		          (cycles + (SYSTIME_HZ / 1000000) - 1) / (SYSTIME_HZ / 1000000));
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Compute the worst-case latency of an interrupt
+ *
+ * The handler may have to wait for :
+ * - all more urgent handlers, with their entry (each one occurs once)
+ * - the longest handler of the same level (it can not be preempted), or
+ *   the longest critical section that masks this level, whichever is longer
+ *
+ * @param cfg Pointer to the configuration of the line
+ * @return u32 Latency in cycles
+ */
+static u32 _latency(const irq_cfg *cfg)
+{
+	u32  higher = 0;
+	u32  block  = 0;
+	uint i;
+
+	for (i = 0; i < ARRAY_SIZE(irq_table); i++)
+	{
+		if ((&irq_table[i] == cfg) || (irq_table[i].target != IRQ_SECURE))
+			continue;
+		if (irq_table[i].prio < cfg->prio)
+			higher += IRQ_ENTRY_CYCLES + irq_table[i].wcet;
+		else if ((irq_table[i].prio == cfg->prio) && (irq_table[i].wcet > block))
+			block = irq_table[i].wcet;
+	}
+	for (i = 0; i < ARRAY_SIZE(irq_sections); i++)
+	{
+		if (irq_sections[i].level > cfg->prio)
+			continue;
+		if (irq_sections[i].cycles > block)
+			block = irq_sections[i].cycles;
+	}
+	return(IRQ_ENTRY_CYCLES + higher + block);
+}
+/* EOF */
@@ -0,0 +1,122 @@
+/**
+ * @file  irq.h
+ * @brief Definitions and prototypes for the interrupt manager
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef IRQ_H
+#define IRQ_H
+#include "hardware.h"
+#include "types.h"
+
+// Number of priority bits implemented by the STM32H5 NVIC
+#define IRQ_PRIO_BITS 4
+
+/* Priority levels (0 is the most urgent, 0 is never masked by irq_lock) */
+#define IRQ_PRIO_READER  2
+#define IRQ_PRIO_TIME    3
+#define IRQ_PRIO_DOOR    4
+#define IRQ_PRIO_COMM    6
+#define IRQ_PRIO_CRYPTO  9
+#define IRQ_PRIO_BULK   10
+#define IRQ_PRIO_LOG    12
+
+/* Target security state */
+#define IRQ_SECURE    0
+#define IRQ_NONSECURE 1
+
+/* Interrupt numbers (see startup.s) */
+#define IRQ_RTC         2
+#define IRQ_RTC_S       3
+#define IRQ_EXTI15     26
+#define IRQ_GPDMA1_CH0 27
+#define IRQ_ADC1       37
+#define IRQ_FDCAN1_IT0 39
+#define IRQ_FDCAN1_IT1 40
+#define IRQ_TIM2       45
+#define IRQ_USART3     60
+#define IRQ_SPI4       82
+#define IRQ_RNG       114
+#define IRQ_HASH      117
+
+// Cycles used by the core to enter a handler (stacking, vector fetch)
+#define IRQ_ENTRY_CYCLES 12
+
+/**
+ * @brief Configuration of one interrupt line
+ *
+ * The worst-case execution time (cycles) of the handler is used by the
+ * latency report (see irq_report).
+ */
+typedef struct irq_cfg
+{
+	const char *name;
+	u8  irq;
+	u8  prio;
+	u8  target;
+	u8  enable;
+	u32 wcet;
+} irq_cfg;
+
+/**
+ * @brief Critical section taken with irq_lock, declared for the report
+ */
+typedef struct irq_section
+{
+	const char *name;
+	u8  level;  // Level given to irq_lock (0 for hw_irq_save)
+	u32 cycles; // Longest duration of the section
+} irq_section;
+
+void irq_init   (void);
+void irq_enable (uint irq);
+void irq_disable(uint irq);
+void irq_report (void);
+
+/**
+ * @brief Enter a critical section, masking interrupts of a level and below
+ *
+ * Interrupts more urgent than the level are still served. Sections can be
+ * nested, the mask is only raised (BASEPRI_MAX).
+ *
+ * @param level Priority level (1 to 15)
+ * @return u32 Previous mask, to be given to irq_unlock()
+ */
+static inline u32 irq_lock(uint level)
+{
+	u32 mask = (u32)(level << (8 - IRQ_PRIO_BITS)) & 0xFF;
+#ifdef HOST
+	return sim_irq_basepri(mask, 1);
+#else
+	u32 prev;
+
+	asm volatile("mrs %0, basepri" : "=r" (prev));
+	asm volatile("msr basepri_max, %0" :: "r" (mask) : "memory");
+	return(prev);
+#endif
+}
+
+/**
+ * @brief Leave a critical section
+ *
+ * @param prev Mask returned by irq_lock()
+ */
+static inline void irq_unlock(u32 prev)
+{
+#ifdef HOST
+	sim_irq_basepri(prev, 0);
+#else
+	asm volatile("msr basepri, %0" :: "r" (prev) : "memory");
+#endif
+}
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @file  journal.c
+ * @brief Journal of access events
+ *
+ * Events are kept into a ring of records (SRAM3). Each record is known by
+ * its offset : the number of records appended before it since startup.
+ * Offsets only increase, a consumer (like the uplink) keeps the offset of
+ * the next record it needs and reads the journal at its own pace. When the
+ * consumer is too slow, the oldest records are overwritten : journal_tail()
+ * gives the offset of the oldest record still available.
+ *
+ * Records can be appended from interrupt handlers up to IRQ_PRIO_READER.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "irq.h"
+#include "journal.h"
+#include "systime.h"
+#include "trace.h"
+
+static journal_rec ring[JOURNAL_SIZE]
+	__attribute__((section(JOURNAL_SECT), aligned(8)));
+static volatile u32 head;
+
+/**
+ * @brief Initialize the journal (empty)
+ *
+ */
+void journal_init(void)
+{
+	head = 0;
+	journal_append(0, JOURNAL_BOOT, 0, 0);
+}
+
+/**
+ * @brief Append an event to the journal
+ *
+ * @param door Door (reader) number
+ * @param type Type of the event (JOURNAL_*)
+ * @param cred Credential identifier, 0 if none
+ * @param info Detail of the event
+ * @return u32 Offset of the new record
+ */
+HOT_FCT u32 journal_append(uint door, uint type, u32 cred, uint info)
+{
+	journal_rec *rec;
+	u32 lock, offset;
+
+	lock = irq_lock(IRQ_PRIO_READER);
+	offset = head;
+	rec = &ring[offset & (JOURNAL_SIZE - 1)];
+	rec->time = systime_wall();
+	rec->cred = cred;
+	rec->door = (u8)door;
+	rec->type = (u8)type;
+	rec->info = (u16)info;
+	head = offset + 1;
+	irq_unlock(lock);
+	trace_mark(TRACE_ID_JOURNAL, type);
+	return(offset);
+}
+
+/**
+ * @brief Get the offset of the next record to be appended
+ *
+ * @return u32 Offset
+ */
+u32 journal_head(void)
+{
+	return(head);
+}
+
+/**
+ * @brief Get the offset of the oldest record still available
+ *
+ * @return u32 Offset
+ */
+u32 journal_tail(void)
+{
+	u32 h = head;
+
+	return (h > JOURNAL_SIZE) ? (h - JOURNAL_SIZE) : 0;
+}
+
+/**
+ * @brief Read a record of the journal
+ *
+ * @param offset Offset of the record
+ * @param rec    Pointer to a record to fill
+ * @return integer Zero on success, -1 if not available (not yet written or
+ *                 already overwritten)
+ */
+int journal_read(u32 offset, journal_rec *rec)
+{
+	u32 h = head;
+
+	if ((h - offset - 1) >= JOURNAL_SIZE)
+		return(-1);
+	*rec = ring[offset & (JOURNAL_SIZE - 1)];
+	// Overwritten by an append during the copy
+	if ((head - offset) > JOURNAL_SIZE)
+		return(-1);
+	return(0);
+}
+/* EOF */
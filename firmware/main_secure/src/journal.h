@@ -0,0 +1,51 @@
+/**
+ * @file  journal.h
+ * @brief Definitions and prototypes for the event journal
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+#include "pool.h"
+#include "types.h"
+
+// Number of records kept (power of two), the oldest ones are overwritten
+#define JOURNAL_SIZE 1024
+#define JOURNAL_SECT POOL_SRAM3 ".journal"
+
+/* Event types */
+#define JOURNAL_BOOT   0x00
+#define JOURNAL_GRANT  0x01
+#define JOURNAL_DENY   0x02
+#define JOURNAL_ALARM  0x03
+#define JOURNAL_DOOR   0x04
+#define JOURNAL_TEST   0x0F
+
+/**
+ * @brief Record of the journal
+ */
+typedef struct journal_rec
+{
+	u32 time;  // Seconds since 2000-01-01 (systime_wall)
+	u32 cred;  // Credential identifier, 0 if none
+	u8  door;  // Door (reader) number
+	u8  type;  // JOURNAL_*
+	u16 info;  // Reason or detail, depends on type
+} journal_rec;
+
+void journal_init  (void);
+u32  journal_append(uint door, uint type, u32 cred, uint info);
+u32  journal_head  (void);
+u32  journal_tail  (void);
+int  journal_read  (u32 offset, journal_rec *rec);
+
+#endif
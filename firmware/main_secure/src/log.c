@@ -18,6 +18,9 @@
 #include "types.h"
 
 static uint log_level;
+#ifdef BENCH
+static int  log_muted;
+#endif
 
 /**
  * @brief Initialize log module
@@ -28,6 +31,18 @@ void log_init(void)
 	log_level = 5;
 }
 
+#ifdef BENCH
+/**
+ * @brief Drop output bytes, used to measure formatting code alone
+ *
+ * @param enable True to mute console output, False to restore it
+ */
+void log_mute(int enable)
+{
+	log_muted = enable;
+}
+#endif
+
 /**
  * @brief Write a VT100 escape sequence to change font color
  *
@@ -79,7 +94,7 @@ void log_dump(const u8 *data, uint count, uint flags)
 	{
 		/* Print line header with absolute address */
 		if (flags & 1)
-			log_print(0, "%32x ", (u32)data);
+			log_print(0, "%32x ", (u32)(uptr)data);
 		/* Print line header with relative address */
 		else if (flags & 2)
 			log_print(0, "%32x ", (u32)(data - origin));
@@ -172,7 +187,8 @@ void log_print(uint level, const char *fmt, ...)
 				{
 					char *str;
 					str = __builtin_va_arg(args, char*);
-					uart_puts(str);	
+					while (*str)
+						log_putc(*str++);
 					break;
 				}
 				/* Insert an unsigned decimal integer */
@@ -230,6 +246,10 @@ void log_print(uint level, const char *fmt, ...)
  */
 void log_putc(const char c)
 {
+#ifdef BENCH
+	if (log_muted)
+		return;
+#endif
 	uart_putc(c);
 }
 
@@ -48,5 +48,8 @@ void log_puts  (uint level, const char *s);
 /* Log structured contents */
 void log_dump(const u8 *data, uint count, uint flags);
 void log_print(uint level, const char *s, ...);
+#ifdef BENCH
+void log_mute(int enable);
+#endif
 
 #endif
@@ -0,0 +1,82 @@
+/**
+ * @file  loop.c
+ * @brief Passes of the main loop, shared by all the callers
+ *
+ * The services of the secure firmware are polled by the main loop of
+ * main.c until the application starts, then by the main loop of the
+ * application (nsc_poll, nsc_idle), and by the main loop of the host build.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "apb.h"
+#include "cred.h"
+#include "driver/eth.h"
+#include "frame.h"
+#include "loop.h"
+#include "monitor.h"
+#include "pipeline.h"
+#include "power.h"
+#include "uplink.h"
+
+static int polling; // A pass of loop_poll is in progress
+
+/**
+ * @brief Initialize the main loop (no pass in progress)
+ *
+ */
+void loop_init(void)
+{
+	polling = 0;
+}
+
+/**
+ * @brief Make one pass of the services of the secure firmware
+ *
+ * Called by the main loop of main.c when the application is not started,
+ * and by the main loop of the application (nsc_poll) once it runs. A call
+ * from a non-secure interrupt, while a pass is in progress, is refused.
+ *
+ * @return integer Zero on success, -1 if a pass is already in progress
+ */
+int loop_poll(void)
+{
+	if (polling)
+		return(-1);
+	polling = 1;
+	frame_poll();
+	eth_poll();
+	uplink_poll();
+	monitor_poll();
+	apb_poll();
+	cred_poll();
+	pipe_poll();
+	polling = 0;
+	return(0);
+}
+
+/**
+ * @brief Enter STOP mode if nothing has to be done (see power_idle)
+ *
+ * Called by the main loop of the application (nsc_idle) after its pass of
+ * nsc_poll, when it has nothing to do itself. A call from a non-secure
+ * interrupt, while a pass is in progress, is refused.
+ *
+ * @return integer Zero on success, -1 if a pass is in progress
+ */
+int loop_idle(void)
+{
+	if (polling)
+		return(-1);
+	power_idle();
+	return(0);
+}
+/* EOF */
@@ -0,0 +1,24 @@
+/**
+ * @file  loop.h
+ * @brief Definitions and prototypes for the passes of the main loop
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef LOOP_H
+#define LOOP_H
+#include "types.h"
+
+void loop_init(void);
+int  loop_poll(void);
+int  loop_idle(void);
+
+#endif
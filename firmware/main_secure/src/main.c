@@ -14,9 +14,30 @@
  * This program is distributed WITHOUT ANY WARRANTY.
  */
 #include "hardware.h"
+#include "apb.h"
+#include "boot.h"
+#include "config.h"
+#include "crash.h"
+#include "cred.h"
+#include "driver/eth.h"
+#include "driver/fdcan.h"
 #include "driver/spi.h"
 #include "driver/uart.h"
+#include "entropy.h"
+#include "frame.h"
+#include "journal.h"
 #include "log.h"
+#include "loop.h"
+#include "monitor.h"
+#include "pipeline.h"
+#include "pool.h"
+#include "power.h"
+#include "ratelim.h"
+#include "sched.h"
+#include "seq.h"
+#include "trace.h"
+#include "update.h"
+#include "uplink.h"
 
 void main_ns(void);
 void spi_test(void);
@@ -30,13 +51,33 @@ void start_app(void);
  */
 int main(void)
 {
+	loop_init();
 	// Board init
 	hw_init();
+	trace_init();
 	// Drivers init
 	uart_init();
 	spi_init();
 	// Functional modules init
 	log_init();
+	crash_init();
+	pool_init();
+	journal_init();
+	seq_init();
+	eth_init();
+	uplink_init();
+	fdcan_init(0);
+	frame_init();
+	update_init();
+	monitor_init();
+	entropy_init();
+	apb_init();
+	cred_init();
+	config_init();
+	ratelim_init();
+	pipe_init();
+	sched_init(SCHED_ADDR);
+	power_init();
 
 	log_print(0, "\n%{--=={ CowKeyr-AC }==--%}\n", LOG_BBLU);
 
@@ -45,6 +86,7 @@ int main(void)
 		log_print(0, " * Run in %{secure%} mode.\n", 2);
 	else
 		log_print(0, " * Run in %{unsecure%} mode.\n", 3);
+	update_boot();
 	log_print(0, "\n");
 
 #ifdef TEST_UNPRIV
@@ -70,7 +112,13 @@ int main(void)
 	}
 #endif
 	start_app();
-	while(1);
+
+	// Application not started, wait for update or configuration frames
+	while(1)
+	{
+		loop_poll();
+		power_idle();
+	}
 }
 
 /**
@@ -81,6 +129,7 @@ void start_app(void)
 {
 	void __attribute((cmse_nonsecure_call)) (*fct)(void);
 	u32 v, wm_s, wm_e;
+	int result;
 
 	// Check flash bank1 watermark configuration
 	v = *(unsigned long *)0x500220E0;
@@ -92,10 +141,23 @@ void start_app(void)
 		log_print(0, " -> %{ERROR%}: Wrong SECWM1 config (end > 0x08010000)\n", 1);
 	}
 
+	// Verify image of the application before starting it
+	result = boot_verify(BOOT_APP_BASE);
+	if (result < 0)
+	{
+		log_print(0, " -> %{ERROR%}: Application verification failed (%d)\n", 1, result);
+		// New firmware is not valid, revert to previous one
+		if (update_pending())
+			update_rollback();
+		return;
+	}
+	update_confirm();
+	if (result == BOOT_OK_CACHED)
+		log_print(0, " * Application already verified (warm boot)\n");
+
 	log_print(0, "%{TEST:%} Switch to unsafe env\n", LOG_BGRN);
-	log_dump((const u8*)0x08010000, 64, 1);
 	asm volatile("msr msp_ns, %0"::"r"(0x20050100):);
-	fct = *(unsigned long *)0x08010004;
+	fct = *(unsigned long *)(BOOT_APP_BASE + 4);
 	log_print(0, "Non secure entry at %32x\n\n", (u32)fct);
 	if (fct != 0)
 		fct();
@@ -0,0 +1,274 @@
+/**
+ * @file  monitor.c
+ * @brief Monitor of the analog inputs : supply, tamper and door loops
+ *
+ * The inputs are converted in a loop by the ADC (see driver/adc.c) into a
+ * double buffer of MON_SCANS sequences per half. While all the inputs are
+ * in their normal state, the halves are not read : the analog watchdogs
+ * interrupt the CPU when an input leaves its normal window (AWD1 for the
+ * supply, AWD2 for the loops). Then each completed half is classified in
+ * one batch, until all the inputs are normal again and the watchdogs are
+ * armed again.
+ *
+ * A state change is accepted when all the samples of a half (about 60 ms)
+ * are in the same class, then it is logged and added to the journal.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "driver/adc.h"
+#include "journal.h"
+#include "log.h"
+#include "monitor.h"
+#include "power.h"
+
+#if (MON_CHANNELS % 2) || (MON_SCANS > 16)
+#error "MON_CHANNELS must be even and MON_SCANS at most 16"
+#endif
+
+#define MON_WORDS (MON_CHANNELS / 2)
+// Journal "door" of inputs that are not a door
+#define MON_PANEL 0xFF
+
+/**
+ * @brief Wiring and thresholds of one input
+ */
+typedef struct mon_input
+{
+	const char *name;
+	u32 port;
+	u8  pin;
+	u8  chan;    // ADC channel
+	u16 thr[3];  // Lower bound of MON_NORMAL, MON_OPEN and MON_CUT
+} mon_input;
+
+static void _alert(u32 events);
+static void _report(uint input, uint state, uint mean);
+
+static const mon_input inputs[MON_CHANNELS] =
+{
+	{ "supply", GPIOA, 0,  0, { MON_SUPPLY_LOW, MON_SUPPLY_HIGH, MON_NEVER } },
+	{ "tamper", GPIOA, 3, 15, { MON_LOOP_SHORT, MON_LOOP_OPEN, MON_LOOP_CUT } },
+	{ "door0",  GPIOC, 0, 10, { MON_LOOP_SHORT, MON_LOOP_OPEN, MON_LOOP_CUT } },
+	{ "door1",  GPIOC, 2, 12, { MON_LOOP_SHORT, MON_LOOP_OPEN, MON_LOOP_CUT } },
+	{ "door2",  GPIOC, 3, 13, { MON_LOOP_SHORT, MON_LOOP_OPEN, MON_LOOP_CUT } },
+	{ "door3",  GPIOA, 6,  3, { MON_LOOP_SHORT, MON_LOOP_OPEN, MON_LOOP_CUT } },
+};
+static const char *state_names[4]  = { "short", "normal", "open", "cut" };
+static const char *supply_names[4] = { "low", "normal", "high", "-" };
+
+mon_stats monitor_stat;
+static u16  mon_buf[2 * MON_HALF] __attribute__((aligned(4)));
+static u8   mon_state[MON_CHANNELS];
+static vu32 active; // Halves are classified (watchdog event, input not normal)
+
+/**
+ * @brief Initialize the monitor and start the conversions
+ *
+ */
+void monitor_init(void)
+{
+	u8   chan[MON_CHANNELS];
+	u32  loops = 0;
+	uint i, pin;
+
+	monitor_stat.halves   = 0;
+	monitor_stat.batches  = 0;
+	monitor_stat.alerts   = 0;
+	monitor_stat.unstable = 0;
+
+	// Inputs in analog mode (GPIOA and GPIOC clocks)
+	reg_set(RCC_AHB2ENR(RCC), (1 << 0) | (1 << 2));
+	for (i = 0; i < MON_CHANNELS; i++)
+	{
+		pin = inputs[i].pin;
+		reg_set(GPIO_MODER(inputs[i].port), (3u << (pin * 2)));
+		reg_clr(GPIO_PUPDR(inputs[i].port), (3u << (pin * 2)));
+		chan[i] = inputs[i].chan;
+		if (i != MON_SUPPLY)
+			loops |= (1u << inputs[i].chan);
+		mon_state[i] = MON_NORMAL;
+	}
+
+	adc_init();
+	adc_watch(ADC_AWD1, (1u << inputs[MON_SUPPLY].chan), MON_SUPPLY_LOW, MON_SUPPLY_HIGH);
+	adc_watch(ADC_AWD2, loops, MON_LOOP_SHORT, MON_LOOP_OPEN);
+	adc_event(_alert);
+
+	// The first halves are classified, watchdogs are armed when all normal
+	active = 1;
+	if (adc_start(chan, MON_CHANNELS, mon_buf, 2 * MON_HALF) < 0)
+	{
+		log_print(0, " * MON: %{ERROR%} ADC not started\n", 1);
+		return;
+	}
+	// The ADC kernel clock is stopped in STOP mode
+	power_hold(POWER_HOLD_ADC);
+}
+
+/**
+ * @brief Process the last completed half-buffer, called by the main loop
+ *
+ */
+void monitor_poll(void)
+{
+	mon_batch  batch;
+	const u16 *half;
+	uint i, normal;
+
+	half = adc_half();
+	if (half == 0)
+		return;
+	monitor_stat.halves++;
+	// All inputs normal : wait for an event of the analog watchdogs
+	if (active == 0)
+		return;
+
+	monitor_classify(half, MON_SCANS, &batch);
+	monitor_stat.batches++;
+
+	normal = 1;
+	for (i = 0; i < MON_CHANNELS; i++)
+	{
+		if (batch.state[i] == MON_UNSTABLE)
+		{
+			monitor_stat.unstable++;
+			normal = 0;
+			continue;
+		}
+		if (batch.state[i] != mon_state[i])
+		{
+			mon_state[i] = batch.state[i];
+			_report(i, batch.state[i], batch.mean[i]);
+		}
+		if (batch.state[i] != MON_NORMAL)
+			normal = 0;
+	}
+	if (normal)
+	{
+		active = 0;
+		adc_arm(ADC_AWD1 | ADC_AWD2);
+	}
+}
+
+/**
+ * @brief Get the current state of an input
+ *
+ * @param input Index of the input (MON_SUPPLY, MON_TAMPER, MON_DOOR0 ...)
+ * @return uint State of the input (MON_*)
+ */
+uint monitor_state(uint input)
+{
+	if (input >= MON_CHANNELS)
+		return(MON_UNSTABLE);
+	return(mon_state[input]);
+}
+
+/**
+ * @brief Classify the samples of a half-buffer
+ *
+ * Two samples (inputs 2n and 2n+1) are processed at once in a 32 bits
+ * word : with bit 15 of each half set, subtracting a threshold leaves bit
+ * 15 set when the sample is above or equal to it, without borrow between
+ * the halves. The class of a sample is the number of thresholds reached.
+ * The AND and the OR of the classes of all the sequences are equal only
+ * when all the samples of an input are in the same class. This function
+ * has no side effect, it can be used on recorded buffers.
+ *
+ * @param buf   Pointer to the samples (scans sequences of MON_CHANNELS)
+ * @param scans Number of sequences (1 to 16)
+ * @param out   Pointer to the result
+ */
+void monitor_classify(const u16 *buf, uint scans, mon_batch *out)
+{
+	u32  t1[MON_WORDS], t2[MON_WORDS], t3[MON_WORDS];
+	u32  all[MON_WORDS], any[MON_WORDS], sum[MON_WORDS];
+	u32  x, c, a, o;
+	uint i, s, lane;
+
+	for (i = 0; i < MON_WORDS; i++)
+	{
+		t1[i] = inputs[2 * i].thr[0] | ((u32)inputs[2 * i + 1].thr[0] << 16);
+		t2[i] = inputs[2 * i].thr[1] | ((u32)inputs[2 * i + 1].thr[1] << 16);
+		t3[i] = inputs[2 * i].thr[2] | ((u32)inputs[2 * i + 1].thr[2] << 16);
+		all[i] = 0xFFFFFFFF;
+		any[i] = 0;
+		sum[i] = 0;
+	}
+	for (s = 0; s < scans; s++)
+	{
+		for (i = 0; i < MON_WORDS; i++)
+		{
+			x  = (buf[2 * i] | ((u32)buf[2 * i + 1] << 16)) & 0x0FFF0FFF;
+			sum[i] += x;
+			x |= 0x80008000;
+			c  = ((x - t1[i]) >> 15) & 0x00010001;
+			c += ((x - t2[i]) >> 15) & 0x00010001;
+			c += ((x - t3[i]) >> 15) & 0x00010001;
+			all[i] &= c;
+			any[i] |= c;
+		}
+		buf += MON_CHANNELS;
+	}
+	for (i = 0; i < MON_CHANNELS; i++)
+	{
+		lane = (i & 1) * 16;
+		a = (all[i / 2] >> lane) & 3;
+		o = (any[i / 2] >> lane) & 3;
+		out->state[i] = (a == o) ? (u8)a : MON_UNSTABLE;
+		out->mean[i]  = scans ? (u16)(((sum[i / 2] >> lane) & 0xFFFF) / scans) : 0;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Analog watchdog event (called from the ADC interrupt)
+ *
+ * @param events Watchdogs that have detected an input out of its window
+ */
+static void _alert(u32 events)
+{
+	(void)events;
+	monitor_stat.alerts++;
+	active = 1;
+}
+
+/**
+ * @brief Log and record the new state of an input
+ *
+ * @param input Index of the input
+ * @param state New state (MON_*)
+ * @param mean  Mean of the samples of the batch
+ */
+static void _report(uint input, uint state, uint mean)
+{
+	const char *name = state_names[state & 3];
+	uint type = JOURNAL_ALARM;
+
+	if (input == MON_SUPPLY)
+		name = supply_names[state & 3];
+	log_print(0, " * MON %s: %s (%u)\n", inputs[input].name, name, mean);
+
+	if ((input >= MON_DOOR0) && (input < (MON_DOOR0 + MON_DOORS)))
+	{
+		// Door open or closed is an event, a short or a cut is an alarm
+		if ((state == MON_NORMAL) || (state == MON_OPEN))
+			type = JOURNAL_DOOR;
+		journal_append(input - MON_DOOR0, type, 0, state);
+	}
+	else
+		journal_append(MON_PANEL, type, 0, (input << 8) | state);
+}
+/* EOF */
@@ -0,0 +1,74 @@
+/**
+ * @file  monitor.h
+ * @brief Definitions and prototypes for the analog inputs monitor
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef MONITOR_H
+#define MONITOR_H
+#include "types.h"
+
+/* Inputs, in the order of the scan sequence */
+#define MON_SUPPLY 0 /* Supply voltage (divider)         */
+#define MON_TAMPER 1 /* Enclosure tamper loop            */
+#define MON_DOOR0  2 /* First door contact (4 contacts)  */
+#define MON_DOORS  4
+// Number of inputs, must be even (the classifier reads samples by pairs)
+#define MON_CHANNELS 6
+// Sequences per half-buffer (1 to 16, sums are kept on 16 bits)
+#define MON_SCANS    8
+#define MON_HALF     (MON_CHANNELS * MON_SCANS)
+
+/* States of an input (class of its samples) */
+#define MON_SHORT    0 /* Loop shorted (supply : too low)   */
+#define MON_NORMAL   1 /* Loop closed with its end-of-line resistor */
+#define MON_OPEN     2 /* Contact open (supply : too high)  */
+#define MON_CUT      3 /* Loop cut (both resistors missing) */
+#define MON_UNSTABLE 0xFF /* Samples of a batch not in the same class */
+
+/* Thresholds (12 bits codes) of supervised loops : 4k7 pull-up, 2 x 4k7 EOL */
+#define MON_LOOP_SHORT 600
+#define MON_LOOP_OPEN  2400
+#define MON_LOOP_CUT   3500
+/* Thresholds of the supply : divider gives 2048 for 12 V */
+#define MON_SUPPLY_LOW  1792 /* 10.5 V */
+#define MON_SUPPLY_HIGH 2475 /* 14.5 V */
+#define MON_NEVER       4096
+
+/**
+ * @brief Result of the classification of one half-buffer
+ */
+typedef struct mon_batch
+{
+	u8  state[MON_CHANNELS]; // MON_* state, or MON_UNSTABLE
+	u16 mean[MON_CHANNELS];  // Mean of the samples (12 bits)
+} mon_batch;
+
+/**
+ * @brief Counters of the monitor
+ */
+typedef struct mon_stats
+{
+	u32 halves;   // Half-buffers completed
+	u32 batches;  // Half-buffers classified
+	u32 alerts;   // Analog watchdog interrupts
+	u32 unstable; // Inputs not classified (samples in several classes)
+} mon_stats;
+
+extern mon_stats monitor_stat;
+
+void monitor_init    (void);
+void monitor_poll    (void);
+uint monitor_state   (uint input);
+void monitor_classify(const u16 *buf, uint scans, mon_batch *out);
+
+#endif
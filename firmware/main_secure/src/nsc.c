@@ -0,0 +1,83 @@
+/**
+ * @file  nsc.c
+ * @brief Secure gateway : entry points of the non-secure application
+ *
+ * Each entry is a "secure gateway" veneer (SG instruction) placed by the
+ * linker into the non-secure callable region (.gnu.sgstubs). The arguments
+ * come from the non-secure world : pointers are checked against the
+ * security attribution and the MPU of the caller before any access.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include <arm_cmse.h>
+#include "entropy.h"
+#include "loop.h"
+#include "nsc.h"
+
+#if (NSC_RANDOM_MAX > ENTROPY_GET_MAX)
+#error "NSC_RANDOM_MAX must not exceed ENTROPY_GET_MAX"
+#endif
+
+/**
+ * @brief Get random bytes from the entropy pool
+ *
+ * The request is served from the pool (see entropy_get), it does not wait
+ * for the TRNG. The buffer must be writable by the non-secure caller.
+ *
+ * @param buf Pointer to the buffer that receives the bytes (non-secure)
+ * @param len Number of bytes (1 to NSC_RANDOM_MAX)
+ * @return integer Zero on success, -1 on bad parameters or empty pool
+ */
+int __attribute((cmse_nonsecure_entry)) nsc_random(u8 *buf, uint len)
+{
+	u8 *dst;
+
+	if ((len == 0) || (len > NSC_RANDOM_MAX))
+		return(-1);
+	dst = cmse_check_address_range(buf, len, CMSE_NONSECURE | CMSE_MPU_READWRITE);
+	if (dst == 0)
+		return(-1);
+	return entropy_get(dst, len);
+}
+
+/**
+ * @brief Make one pass of the services of the secure firmware
+ *
+ * Once the application is started, the main loop of the secure firmware
+ * no more runs : the application must call this function from its own
+ * main loop (frame channel, network, background flash work, door
+ * transactions). A call made while a pass is in progress (from a
+ * non-secure interrupt handler) is refused.
+ *
+ * @return integer Zero on success, -1 if a pass is already in progress
+ */
+int __attribute((cmse_nonsecure_entry)) nsc_poll(void)
+{
+	return loop_poll();
+}
+
+/**
+ * @brief Let the secure firmware enter STOP mode until the next event
+ *
+ * Called by the main loop of the application after nsc_poll(), when it has
+ * nothing to do. STOP is entered only when no secure module holds the
+ * clocks (see power.c), the call returns after the wake event has been
+ * handled. The application must not call it while one of its own
+ * peripherals needs the clocks (they are stopped too).
+ *
+ * @return integer Zero on success, -1 if a pass is in progress
+ */
+int __attribute((cmse_nonsecure_entry)) nsc_idle(void)
+{
+	return loop_idle();
+}
+/* EOF */
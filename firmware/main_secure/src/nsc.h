@@ -0,0 +1,30 @@
+/**
+ * @file  nsc.h
+ * @brief Secure gateway : functions callable from the non-secure application
+ *
+ * This header is shared with the application (main_app), the entries are
+ * resolved with the import library of the secure firmware (fw_secure_nsc.o).
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef NSC_H
+#define NSC_H
+#include "types.h"
+
+// Largest request of random bytes (see ENTROPY_GET_MAX)
+#define NSC_RANDOM_MAX 32
+
+int nsc_random(u8 *buf, uint len);
+int nsc_poll  (void);
+int nsc_idle  (void);
+
+#endif
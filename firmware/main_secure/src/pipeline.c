@@ -0,0 +1,636 @@
+/**
+ * @file  pipeline.c
+ * @brief Pipeline of the door transactions (badge read to journal)
+ *
+ * A badge read starts a transaction that goes through the stages decode,
+ * lookup, rules, crypto, actuate and journal. The main loop runs one stage
+ * at a time (pipe_poll, from loop_poll : secure main loop, or nsc_poll once
+ * the application runs), chosen by the priority of the stage then by the
+ * deadline of the transaction : a stage that waits for a card or a reader
+ * (PIPE_AGAIN) does not stall the other doors. Each transaction has a
+ * deadline (PIPE_DEADLINE_MS from the read to the strike), the decisions
+ * made after it are counted and traced (TRACE_ID_PIPE_MISS).
+ *
+ * pipe_submit can be called from the reader handlers (IRQ_PRIO_READER) or
+ * from the main loop, the other functions from the main loop only. See
+ * doc/pipeline.md.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "cred.h"
+#include "irq.h"
+#include "journal.h"
+#include "log.h"
+#include "pipeline.h"
+#include "power.h"
+#include "sched.h"
+#include "seq.h"
+#include "systime.h"
+#include "trace.h"
+#ifdef HOST
+#include <stdlib.h>
+#include "driver/hash.h"
+#endif
+
+static pipe_txn *_pick(u32 now);
+static u32  _now(void);
+static uint _parity(u32 v);
+static int  _decode (pipe_txn *txn);
+static int  _lookup (pipe_txn *txn);
+static int  _rules  (pipe_txn *txn);
+static int  _crypto (pipe_txn *txn);
+static int  _actuate(pipe_txn *txn);
+static int  _journal(pipe_txn *txn);
+#ifdef HOST
+static int  _sim_crypto(pipe_txn *txn);
+static int  _sim_run(uint doors, uint seconds, uint mode);
+static int  _sim_cmp(const void *a, const void *b);
+static u32  _sim_rand(void);
+#endif
+
+/* Priority of the stages, the highest first : a transaction near its strike
+ * is not delayed by new reads. The journal is written when no decision is
+ * waiting. */
+static const u8 prio[PIPE_STAGES] = { 1, 2, 3, 4, 5, 0 };
+static const pipe_fct stages_default[PIPE_STAGES] =
+{
+	_decode, _lookup, _rules, _crypto, _actuate, _journal
+};
+/* Upper limit of the buckets of the latency histogram */
+static const u32 limits[PIPE_BUCKETS - 1] =
+{
+	PIPE_MS(10), PIPE_MS(20), PIPE_MS(50), PIPE_MS(100), PIPE_MS(200)
+};
+
+pipe_stats pipe_stat;
+static pipe_txn txns[PIPE_TXNS];
+static pipe_fct stages[PIPE_STAGES];
+static uint active; // Transactions in progress (updated under irq_lock)
+static u32  last;   // Time of the last poll
+static uint busy;   // Transactions were in progress at the last poll
+#ifdef HOST
+static uint serial; // Simulation : run the transactions one after the other
+static u32 *sim_lat;
+static uint sim_count, sim_max;
+static u32  sim_seed;
+#endif
+
+/**
+ * @brief Initialize the pipeline (no transaction, default stages)
+ *
+ */
+void pipe_init(void)
+{
+	uint i;
+
+	for (i = 0; i < PIPE_TXNS; i++)
+		txns[i].stage = PIPE_FREE;
+	for (i = 0; i < PIPE_STAGES; i++)
+		stages[i] = stages_default[i];
+	active = 0;
+	busy   = 0;
+
+	pipe_stat.reads   = 0;
+	pipe_stat.dropped = 0;
+	pipe_stat.granted = 0;
+	pipe_stat.denied  = 0;
+	pipe_stat.missed  = 0;
+	pipe_stat.max     = 0;
+	pipe_stat.gap     = 0;
+	for (i = 0; i < PIPE_BUCKETS; i++)
+		pipe_stat.hist[i] = 0;
+	power_release(POWER_HOLD_PIPE);
+}
+
+/**
+ * @brief Start a transaction for a badge read
+ *
+ * A read is refused when the door already has a transaction waiting for
+ * its decision, or when all the transactions are in use.
+ *
+ * @param door Door (reader) number
+ * @param data Wiegand frame, last bit received into bit 0 of data[0]
+ * @param bits Length of the frame (up to 64 bits)
+ * @return integer Zero on success, -1 if the read is dropped
+ */
+int pipe_submit(uint door, const u32 *data, uint bits)
+{
+	pipe_txn *txn, *slot = 0;
+	u32  now = _now();
+	u32  prev;
+	uint i;
+
+	prev = irq_lock(IRQ_PRIO_READER);
+	pipe_stat.reads++;
+	for (i = 0; i < PIPE_TXNS; i++)
+	{
+		txn = &txns[i];
+		if (txn->stage == PIPE_FREE)
+		{
+			if (slot == 0)
+				slot = txn;
+		}
+		else if ((txn->door == door) && (txn->stage < PIPE_ACTUATE))
+			break;
+	}
+	if ((i < PIPE_TXNS) || (slot == 0) || (door >= PIPE_DOORS) || (bits > 64))
+	{
+		pipe_stat.dropped++;
+		irq_unlock(prev);
+		return(-1);
+	}
+	slot->start    = now;
+	slot->deadline = now + PIPE_MS(PIPE_DEADLINE_MS);
+	slot->wake     = now;
+	slot->cred     = 0;
+	slot->attr     = 0;
+	slot->data[0]  = data[0];
+	slot->data[1]  = (bits > 32) ? data[1] : 0;
+	slot->bits     = (u8)bits;
+	slot->door     = (u8)door;
+	slot->reason   = 0;
+	slot->priv     = 0;
+	slot->stage    = PIPE_DECODE;
+	active++;
+	power_hold(POWER_HOLD_PIPE);
+	irq_unlock(prev);
+	return(0);
+}
+
+/**
+ * @brief Replace the function of a stage
+ *
+ * Used for the stages that depend on the readers (crypto : card
+ * authentication). A NULL function restores the default one.
+ *
+ * @param stage Stage to replace (PIPE_DECODE to PIPE_JOURNAL)
+ * @param fct   New function of the stage
+ */
+void pipe_stage(uint stage, pipe_fct fct)
+{
+	if (stage >= PIPE_STAGES)
+		return;
+	stages[stage] = fct ? fct : stages_default[stage];
+}
+
+/**
+ * @brief Run one stage of the pipeline (main loop)
+ *
+ * The stage with the highest priority is run, between the transactions
+ * that are not waiting. For the same stage, the earliest deadline first.
+ * The time between two polls while transactions are in progress adds to
+ * their latency, the longest is kept (pipe_stat.gap).
+ *
+ * @return integer 1 if a stage has been run, 0 if nothing to do
+ */
+int pipe_poll(void)
+{
+	pipe_txn *txn;
+	u32  now = _now();
+	u32  prev;
+	uint stage;
+	int  result;
+
+	if (busy && ((now - last) > pipe_stat.gap))
+		pipe_stat.gap = now - last;
+	last = now;
+	busy = (active != 0);
+
+	txn = _pick(now);
+	if (txn == 0)
+		return(0);
+
+	stage = txn->stage;
+	trace_enter(TRACE_ID_PIPE);
+	result = stages[stage](txn);
+	trace_exit(TRACE_ID_PIPE);
+
+	if (result == PIPE_AGAIN)
+	{
+		// No wake time given by the stage, retry later
+		if ((s32)(txn->wake - now) <= 0)
+			txn->wake = now + PIPE_RETRY;
+		return(1);
+	}
+	txn->priv = 0;
+	if ((result == PIPE_DENY) && (stage < PIPE_ACTUATE))
+		stage = PIPE_ACTUATE;
+	else
+		stage++;
+	if (stage < PIPE_STAGES)
+	{
+		txn->stage = (u8)stage;
+		return(1);
+	}
+	prev = irq_lock(IRQ_PRIO_READER);
+	txn->stage = PIPE_FREE;
+	active--;
+	if (active == 0)
+		power_release(POWER_HOLD_PIPE);
+	irq_unlock(prev);
+	return(1);
+}
+
+/**
+ * @brief Print the counters and the decision latency histogram
+ *
+ */
+void pipe_dump(void)
+{
+	const u32 *h = pipe_stat.hist;
+	u32 us = SYSTIME_HZ / 1000000;
+
+	log_print(0, " * PIPE: %u reads, %u dropped, %u granted, %u denied, %u missed\n",
+	          pipe_stat.reads, pipe_stat.dropped, pipe_stat.granted,
+	          pipe_stat.denied, pipe_stat.missed);
+	log_print(0, "   decision\t<10ms\t<20ms\t<50ms\t<100ms\t<200ms\tmore\tmax(us)\tgap(us)\n");
+	log_print(0, "   \t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\n",
+	          h[0], h[1], h[2], h[3], h[4], h[5], pipe_stat.max / us, pipe_stat.gap / us);
+}
+
+#ifdef HOST
+/**
+ * @brief Simulation of many doors (host build, "--pipe-sim")
+ *
+ * Badges are read on each door at random times, the crypto stage is
+ * replaced by a model of a card exchange (one slow door). The same load is
+ * run twice : transactions one after the other (as a single call stack),
+ * then with the pipeline. The credential store is formatted.
+ *
+ * @param doors   Number of doors (up to PIPE_DOORS)
+ * @param seconds Duration of each run
+ * @return integer Zero on success, -1 on error
+ */
+int pipe_sim(uint doors, uint seconds)
+{
+	uint i;
+
+	if ((doors == 0) || (doors > PIPE_DOORS) || (seconds == 0))
+		return(-1);
+
+	// Credentials 1000 to 1511, 90% of the reads use a known one
+	cred_format();
+	cred_range_begin(1, CRED_ID_MAX, cred_version());
+	while (cred_range_put(1000, PIPE_SCHED_ANY) == CRED_ST_BUSY)
+		cred_poll();
+	for (i = 1; i < 512; i++)
+		cred_range_put(1000 + i, PIPE_SCHED_ANY);
+	cred_range_end(1);
+	while (cred_version() != 1)
+		cred_poll();
+
+	sim_max = doors * seconds * 4;
+	sim_lat = malloc(sim_max * sizeof(u32));
+	if (sim_lat == 0)
+		return(-1);
+	_sim_run(doors, seconds, 1);
+	_sim_run(doors, seconds, 0);
+	free(sim_lat);
+	sim_lat = 0;
+	pipe_init();
+	return(0);
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Select the next stage to run
+ *
+ * @param now Current time
+ * @return pipe_txn* Pointer to the transaction, NULL if none is ready
+ */
+static pipe_txn *_pick(u32 now)
+{
+	pipe_txn *txn, *best = 0;
+	uint i;
+
+	for (i = 0; i < PIPE_TXNS; i++)
+	{
+		txn = &txns[i];
+		if (txn->stage == PIPE_FREE)
+			continue;
+#ifdef HOST
+		// Oldest transaction, waiting or not (a single call stack)
+		if (serial)
+		{
+			if ((best == 0) || ((s32)(txn->start - best->start) < 0))
+				best = txn;
+			continue;
+		}
+#endif
+		if ((s32)(now - txn->wake) < 0)
+			continue;
+		if ((best == 0) || (prio[txn->stage] > prio[best->stage]))
+			best = txn;
+		else if ((prio[txn->stage] == prio[best->stage]) &&
+		         ((s32)(txn->deadline - best->deadline) < 0))
+			best = txn;
+	}
+	return(best);
+}
+
+/**
+ * @brief Get the time of the pipeline
+ *
+ * @return u32 Low word of the system timer (wraps after 134 s)
+ */
+static u32 _now(void)
+{
+	return (u32)systime_ticks();
+}
+
+/**
+ * @brief Compute the parity of a word
+ *
+ * @param v Value to test
+ * @return integer 1 if the number of bits set is odd, 0 otherwise
+ */
+static uint _parity(u32 v)
+{
+	v ^= v >> 16;
+	v ^= v >> 8;
+	v ^= v >> 4;
+	v ^= v >> 2;
+	v ^= v >> 1;
+	return(v & 1);
+}
+
+/**
+ * @brief Stage decode : Wiegand frame to credential identifier
+ *
+ * Formats of 26 bits (8 bits facility, 16 bits card) and 34 bits (32 bits
+ * card). The first bit is the even parity of the first half of the frame,
+ * the last bit is the odd parity of the second half.
+ *
+ * @param txn Pointer to the transaction
+ * @return integer PIPE_NEXT, or PIPE_DENY if the frame is not valid
+ */
+static int _decode(pipe_txn *txn)
+{
+	u32 hi, lo, id;
+
+	if (txn->bits == 26)
+	{
+		hi = (txn->data[0] >> 13) & 0x1FFF;
+		lo = txn->data[0] & 0x1FFF;
+		id = (txn->data[0] >> 1) & 0xFFFFFF;
+	}
+	else if (txn->bits == 34)
+	{
+		hi = ((txn->data[1] & 3) << 15) | (txn->data[0] >> 17);
+		lo = txn->data[0] & 0x1FFFF;
+		id = (txn->data[1] << 31) | (txn->data[0] >> 1);
+	}
+	else
+		hi = lo = id = 0;
+
+	if ((id == 0) || (id == 0xFFFFFFFF) || _parity(hi) || ! _parity(lo))
+	{
+		txn->reason = PIPE_R_FORMAT;
+		return(PIPE_DENY);
+	}
+	txn->cred = id;
+	return(PIPE_NEXT);
+}
+
+/**
+ * @brief Stage lookup : access profile of the credential
+ *
+ * @param txn Pointer to the transaction
+ * @return integer PIPE_NEXT, or PIPE_DENY if the credential is unknown
+ */
+static int _lookup(pipe_txn *txn)
+{
+	txn->attr = cred_lookup(txn->cred);
+	if (txn->attr == 0)
+	{
+		txn->reason = PIPE_R_UNKNOWN;
+		return(PIPE_DENY);
+	}
+	return(PIPE_NEXT);
+}
+
+/**
+ * @brief Stage rules : schedule of the access profile
+ *
+ * @param txn Pointer to the transaction
+ * @return integer PIPE_NEXT, or PIPE_DENY out of the schedule
+ */
+static int _rules(pipe_txn *txn)
+{
+	uint id = PIPE_SCHED(txn->attr);
+	uint minute;
+	u32  day;
+
+	if (id == PIPE_SCHED_ANY)
+		return(PIPE_NEXT);
+	systime_date(&day, &minute);
+	if ( ! sched_check(id, day, minute))
+	{
+		txn->reason = PIPE_R_SCHEDULE;
+		return(PIPE_DENY);
+	}
+	return(PIPE_NEXT);
+}
+
+/**
+ * @brief Stage crypto : card authentication (default, none)
+ *
+ * The readers of the panel give the identifier only, the card exchange of
+ * other readers is installed with pipe_stage().
+ *
+ * @param txn Pointer to the transaction
+ * @return integer PIPE_NEXT
+ */
+static int _crypto(pipe_txn *txn)
+{
+	(void)txn;
+	return(PIPE_NEXT);
+}
+
+/**
+ * @brief Stage actuate : strike or deny sequence, latency of the decision
+ *
+ * Only the first SEQ_TRACKS doors have outputs on the panel.
+ *
+ * @param txn Pointer to the transaction
+ * @return integer PIPE_NEXT
+ */
+static int _actuate(pipe_txn *txn)
+{
+	u32  now = _now();
+	u32  lat = now - txn->start;
+	uint i;
+
+	if (txn->door < SEQ_TRACKS)
+		seq_play(txn->door, txn->reason ? &seq_deny : &seq_grant);
+
+	if (txn->reason)
+		pipe_stat.denied++;
+	else
+		pipe_stat.granted++;
+	for (i = 0; i < (PIPE_BUCKETS - 1); i++)
+	{
+		if (lat < limits[i])
+			break;
+	}
+	pipe_stat.hist[i]++;
+	if (lat > pipe_stat.max)
+		pipe_stat.max = lat;
+	if ((s32)(now - txn->deadline) > 0)
+	{
+		pipe_stat.missed++;
+		trace_mark(TRACE_ID_PIPE_MISS, txn->door);
+	}
+#ifdef HOST
+	if (sim_lat && (sim_count < sim_max))
+		sim_lat[sim_count++] = lat;
+#endif
+	return(PIPE_NEXT);
+}
+
+/**
+ * @brief Stage journal : event of the decision
+ *
+ * @param txn Pointer to the transaction
+ * @return integer PIPE_NEXT
+ */
+static int _journal(pipe_txn *txn)
+{
+	journal_append(txn->door, txn->reason ? JOURNAL_DENY : JOURNAL_GRANT,
+	               txn->cred, txn->reason);
+	return(PIPE_NEXT);
+}
+
+#ifdef HOST
+/**
+ * @brief Model of a card exchange for the simulation
+ *
+ * A MAC is computed (HASH peripheral), then the answer of the card comes
+ * after 20 to 40 ms, or 150 ms on door 0 (slow reader).
+ *
+ * @param txn Pointer to the transaction
+ * @return integer PIPE_AGAIN until the answer, then PIPE_NEXT
+ */
+static int _sim_crypto(pipe_txn *txn)
+{
+	static const u8 key[32] = { 0x43, 0x4B, 0x41, 0x43 };
+	u8  mac[32];
+	u32 now = _now();
+
+	if (txn->priv == 0)
+	{
+		hash_hmac(key, sizeof(key), (const u8 *)txn, sizeof(pipe_txn), mac);
+		if (txn->door == 0)
+			txn->wake = now + PIPE_MS(150);
+		else
+			txn->wake = now + PIPE_MS(20 + (_sim_rand() % 21));
+		txn->priv = 1;
+		return(PIPE_AGAIN);
+	}
+	if ((s32)(now - txn->wake) < 0)
+		return(PIPE_AGAIN);
+	return(PIPE_NEXT);
+}
+
+/**
+ * @brief Run one load of the simulation and print its latencies
+ *
+ * Each door gets a read every 0.2 to 1.8 s (1 s average), 10% of the
+ * credentials are unknown.
+ *
+ * @param doors   Number of doors
+ * @param seconds Duration of the load
+ * @param mode    1 : one transaction after the other, 0 : pipeline
+ * @return integer Number of decisions
+ */
+static int _sim_run(uint doors, uint seconds, uint mode)
+{
+	u32  next[PIPE_DOORS];
+	u32  frame[2];
+	u32  now, end, id, us;
+	uint i, n;
+
+	pipe_init();
+	pipe_stage(PIPE_CRYPTO, _sim_crypto);
+	serial = mode;
+	sim_count = 0;
+	sim_seed = 0x2545F491;
+
+	now = _now();
+	for (i = 0; i < doors; i++)
+		next[i] = now + PIPE_MS(_sim_rand() % 1000);
+	end = now + PIPE_MS(seconds * 1000);
+
+	while ((s32)(now - end) < 0)
+	{
+		for (i = 0; i < doors; i++)
+		{
+			if ((s32)(now - next[i]) < 0)
+				continue;
+			next[i] += PIPE_MS(200 + (_sim_rand() % 1601));
+			id = 1000 + (_sim_rand() % 568);
+			// Wiegand 26 : parity, 24 bits of identifier, parity
+			frame[0] = (id & 0xFFFFFF) << 1;
+			frame[0] |= (u32)_parity(frame[0] & 0x1FFE) ^ 1;
+			frame[0] |= (u32)_parity(frame[0] & 0x1FFE000) << 25;
+			pipe_submit(i, frame, 26);
+		}
+		pipe_poll();
+		now = _now();
+	}
+	while (active)
+		pipe_poll();
+
+	n = sim_count;
+	us = SYSTIME_HZ / 1000000;
+	qsort(sim_lat, n, sizeof(u32), _sim_cmp);
+	log_print(0, " * PIPE sim (%s): %u doors, %u decisions, p50 %u us, p99 %u us\n",
+	          mode ? "serial" : "pipeline", doors, n,
+	          n ? (sim_lat[n / 2] / us) : 0, n ? (sim_lat[(n * 99) / 100] / us) : 0);
+	pipe_dump();
+	serial = 0;
+	return((int)n);
+}
+
+/**
+ * @brief Compare two latencies (qsort)
+ *
+ * @param a Pointer to the first value
+ * @param b Pointer to the second value
+ * @return integer Negative, zero or positive as for qsort
+ */
+static int _sim_cmp(const void *a, const void *b)
+{
+	u32 va = *(const u32 *)a;
+	u32 vb = *(const u32 *)b;
+
+	return (va > vb) - (va < vb);
+}
+
+/**
+ * @brief Pseudo-random numbers of the simulation (xorshift)
+ *
+ * @return u32 Next value
+ */
+static u32 _sim_rand(void)
+{
+	sim_seed ^= sim_seed << 13;
+	sim_seed ^= sim_seed >> 17;
+	sim_seed ^= sim_seed << 5;
+	return(sim_seed);
+}
+#endif
+/* EOF */
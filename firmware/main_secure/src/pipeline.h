@@ -0,0 +1,104 @@
+/**
+ * @file  pipeline.h
+ * @brief Definitions and prototypes for the door transaction pipeline
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef PIPELINE_H
+#define PIPELINE_H
+#include "systime.h"
+#include "types.h"
+
+#define PIPE_DOORS 16
+// Transactions in progress (all doors), a read is dropped when none is free
+#define PIPE_TXNS  32
+// Badge read to strike (decision and actuation)
+#define PIPE_DEADLINE_MS 200
+#define PIPE_MS(ms)      ((u32)(ms) * (SYSTIME_HZ / 1000))
+// Delay before a waiting stage (PIPE_AGAIN) is called again, by default
+#define PIPE_RETRY       PIPE_MS(1)
+
+/* Stages of a transaction, in order (priority into pipeline.c) */
+#define PIPE_DECODE  0 /* Wiegand frame to credential        */
+#define PIPE_LOOKUP  1 /* Credential store                   */
+#define PIPE_RULES   2 /* Schedule of the access profile     */
+#define PIPE_CRYPTO  3 /* Card authentication (pipe_stage)   */
+#define PIPE_ACTUATE 4 /* Strike or deny sequence            */
+#define PIPE_JOURNAL 5 /* Event of the journal               */
+#define PIPE_STAGES  6
+#define PIPE_FREE    0xFF
+
+/* Result of a stage */
+#define PIPE_NEXT  0 /* Done, go to the next stage              */
+#define PIPE_AGAIN 1 /* Waiting, called again at txn->wake      */
+#define PIPE_DENY  2 /* Access denied (txn->reason), actuation  */
+
+/* Reasons of a deny (info of the journal event) */
+#define PIPE_R_FORMAT   1 /* Wiegand frame length or parity    */
+#define PIPE_R_UNKNOWN  2 /* Credential not into the store     */
+#define PIPE_R_SCHEDULE 3 /* Out of the schedule of the profile */
+#define PIPE_R_CRYPTO   4 /* Card authentication failed        */
+
+// Access profile : schedule index into the low byte (0xFF : no schedule)
+#define PIPE_SCHED(attr) ((uint)(attr) & 0xFF)
+#define PIPE_SCHED_ANY   0xFF
+
+/* Decision latency histogram : below 10, 20, 50, 100, 200 ms, more */
+#define PIPE_BUCKETS 6
+
+/**
+ * @brief Transaction of one badge read
+ */
+typedef struct pipe_txn
+{
+	u32 start;    // Time of the read (low word of systime_ticks)
+	u32 deadline; // Time of the deadline
+	u32 wake;     // Time to call a waiting stage again
+	u32 cred;     // Credential identifier (after decode)
+	u32 attr;     // Access profile (after lookup)
+	u32 data[2];  // Wiegand frame, first bit received is the MSB
+	u8  bits;     // Length of the frame
+	u8  door;
+	u8  stage;    // PIPE_* stage, or PIPE_FREE
+	u8  reason;   // PIPE_R_* for a deny, 0 for a grant
+	u32 priv;     // Free for the stages (state of a card exchange ...)
+} pipe_txn;
+
+typedef int (*pipe_fct)(pipe_txn *txn);
+
+/**
+ * @brief Counters of the pipeline (see pipe_dump)
+ */
+typedef struct pipe_stats
+{
+	u32 reads;   // Badge reads submitted
+	u32 dropped; // Reads refused (door busy, no free transaction)
+	u32 granted; // Decisions
+	u32 denied;
+	u32 missed;  // Decisions after the deadline
+	u32 hist[PIPE_BUCKETS];
+	u32 max;     // Highest decision latency (cycles)
+	u32 gap;     // Longest time between two polls, transactions in progress (cycles)
+} pipe_stats;
+
+extern pipe_stats pipe_stat;
+
+void pipe_init  (void);
+int  pipe_submit(uint door, const u32 *data, uint bits);
+void pipe_stage (uint stage, pipe_fct fct);
+int  pipe_poll  (void);
+void pipe_dump  (void);
+#ifdef HOST
+int  pipe_sim   (uint doors, uint seconds);
+#endif
+
+#endif
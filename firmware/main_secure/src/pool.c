@@ -0,0 +1,164 @@
+/**
+ * @file  pool.c
+ * @brief Lock-free pools of fixed-size blocks
+ *
+ * A pool is an array of blocks of the same size, defined at compile time
+ * (see POOL_DEFINE) and placed into SRAM3. Allocation and release
+ * are O(1) : they pop or push the head of a free list with a single
+ * compare-and-swap (LDREX/STREX), so they can be used from interrupt
+ * handlers without masking interrupts. There is no fragmentation since all
+ * blocks of a pool have the same size.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "log.h"
+#include "pool.h"
+
+#define HEAD_INDEX 0x0000FFFF
+#define HEAD_TAG   0xFFFF0000
+
+static inline u32 _head(u32 head, u32 index);
+
+static pool *pools;
+
+/**
+ * @brief Initialize the list of pools
+ *
+ * Called before the init of the modules, each module creates its own pools
+ * (see pool_create).
+ */
+void pool_init(void)
+{
+	pools = 0;
+}
+
+/**
+ * @brief Initialize a pool : all blocks are free
+ *
+ * The pool is also registered for statistics (see pool_dump).
+ *
+ * @param p Pointer to the pool (see POOL_DEFINE)
+ */
+void pool_create(pool *p)
+{
+	pool *cur;
+	u32  i;
+
+	for (i = 0; i < p->count; i++)
+		*(u32 *)(p->mem + (i * p->size)) = ((i + 1) < p->count) ? (i + 2) : 0;
+	p->head  = (p->count ? 1 : 0);
+	p->used  = 0;
+	p->high  = 0;
+	p->fails = 0;
+
+	for (cur = pools; cur; cur = cur->next)
+		if (cur == p)
+			return;
+	p->next = pools;
+	pools = p;
+}
+
+/**
+ * @brief Allocate a block
+ *
+ * @param p Pointer to the pool
+ * @return Pointer to the block, or NULL if the pool is empty
+ */
+void *pool_alloc(pool *p)
+{
+	u32  head, next, used, high;
+	u8  *block;
+
+	head = __atomic_load_n(&p->head, __ATOMIC_ACQUIRE);
+	do
+	{
+		if ((head & HEAD_INDEX) == 0)
+		{
+			__atomic_fetch_add(&p->fails, 1, __ATOMIC_RELAXED);
+			return(0);
+		}
+		block = p->mem + (((head & HEAD_INDEX) - 1) * p->size);
+		// May be modified if the block is taken meanwhile, the CAS fails then
+		next = __atomic_load_n((u32 *)block, __ATOMIC_RELAXED);
+	} while ( ! __atomic_compare_exchange_n(&p->head, &head, _head(head, next),
+	            1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	// Update statistics
+	used = __atomic_add_fetch(&p->used, 1, __ATOMIC_RELAXED);
+	high = __atomic_load_n(&p->high, __ATOMIC_RELAXED);
+	while ((used > high) &&
+	       ! __atomic_compare_exchange_n(&p->high, &high, used,
+	                 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+	return(block);
+}
+
+/**
+ * @brief Release a block
+ *
+ * @param p     Pointer to the pool
+ * @param block Pointer to the block (returned by pool_alloc)
+ * @return integer Zero on success, -1 if the block is not part of the pool
+ */
+int pool_free(pool *p, void *block)
+{
+	u8  *b = (u8 *)block;
+	u32  offset, index, head;
+
+	if ((b < p->mem) || (b >= (p->mem + (p->size * p->count))))
+		return(-1);
+	offset = (u32)(b - p->mem);
+	if (offset % p->size)
+		return(-1);
+	index = (offset / p->size) + 1;
+
+	// Counted out before the push : once pushed, the block can be taken and
+	// counted again by a preempting allocation
+	__atomic_fetch_sub(&p->used, 1, __ATOMIC_RELAXED);
+	head = __atomic_load_n(&p->head, __ATOMIC_RELAXED);
+	do
+	{
+		__atomic_store_n((u32 *)b, head & HEAD_INDEX, __ATOMIC_RELAXED);
+	} while ( ! __atomic_compare_exchange_n(&p->head, &head, _head(head, index),
+	            1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	return(0);
+}
+
+/**
+ * @brief Print statistics of all pools
+ *
+ */
+void pool_dump(void)
+{
+	pool *p;
+
+	for (p = pools; p; p = p->next)
+		log_print(0, " * Pool %s: %d/%d used (%d bytes), high %d, %d failed\n",
+		          p->name, p->used, p->count, p->size, p->high, p->fails);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Compute a new value of the free list head
+ *
+ * @param head  Current value of the head
+ * @param index New first free block (index + 1, 0 if none)
+ * @return u32 Value of the head, with an incremented tag
+ */
+static inline u32 _head(u32 head, u32 index)
+{
+	return(((head + 0x10000) & HEAD_TAG) | (index & HEAD_INDEX));
+}
+/* EOF */
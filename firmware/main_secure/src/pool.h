@@ -0,0 +1,67 @@
+/**
+ * @file  pool.h
+ * @brief Definitions and prototypes for the fixed-size block pools
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef POOL_H
+#define POOL_H
+#include "types.h"
+
+// Linker section used for pool storage (see linker_s.ld). SRAM2 belongs
+// to the non-secure application (main_app linker.ld), it is not used.
+#define POOL_SRAM3 ".pool_sram3"
+
+/**
+ * @brief Pool of fixed-size blocks
+ *
+ * Free blocks are linked through their first word. The head of the free
+ * list holds the index of the first free block (plus one, 0 when empty)
+ * in its low half and a modification tag in its high half, so a single
+ * compare-and-swap updates it without ABA problem.
+ */
+typedef struct pool
+{
+	const char *name;
+	u8  *mem;
+	u32  size;       // Size of one block (bytes, multiple of 8)
+	u32  count;      // Number of blocks (max 65535)
+	u32  head;
+	u32  used;       // Number of allocated blocks
+	u32  high;       // Highest number of allocated blocks
+	u32  fails;      // Number of allocations that failed (pool empty)
+	struct pool *next;
+} pool;
+
+#define POOL_BLOCK(size) (((size) + 7) & ~7u)
+
+/**
+ * @brief Define a pool and its storage
+ *
+ * @param var   Name of the pool variable
+ * @param bsize Size of one block (bytes)
+ * @param n     Number of blocks
+ * @param sect  Linker section of the storage (POOL_SRAM3, or a section of
+ *              the module like ETH_SECT)
+ */
+#define POOL_DEFINE(var, bsize, n, sect) \
+	static u64 var##_mem[(POOL_BLOCK(bsize) / 8) * (n)] \
+		__attribute__((section(sect "." #var), aligned(8))); \
+	pool var = { #var, (u8 *)var##_mem, POOL_BLOCK(bsize), (n), 0, 0, 0, 0, 0 }
+
+void  pool_init  (void);
+void  pool_create(pool *p);
+void *pool_alloc (pool *p);
+int   pool_free  (pool *p, void *block);
+void  pool_dump  (void);
+
+#endif
@@ -0,0 +1,280 @@
+/**
+ * @file  power.c
+ * @brief Power manager : STOP mode when the main loop is idle
+ *
+ * The main loop calls power_idle() after each pass, or the main loop of
+ * the application through nsc_idle() once it runs. When no module holds
+ * its clocks (power_hold) and no wake event is waiting to be processed,
+ * the core enters STOP mode : all clocks are stopped, SRAM and registers
+ * are kept. The wake sources are the IRQ line of the card reader (EXTI),
+ * the console (USART3 wakeup, see uart.c) and the RTC wakeup timer (each
+ * second, see systime.c).
+ *
+ * STOP is entered with interrupts masked (PRIMASK) : after the wake, the
+ * monotonic timer is corrected (systime_resume) and the PLLs are restarted
+ * before the handler of the wake source runs. The system clock is HSI,
+ * available a few microseconds after the wake (Stop voltage scaling 3 and
+ * flash kept in normal mode). The delay from the end of WFI to the entry of
+ * the handler is measured with the cycle counter, and kept as a histogram
+ * per wake source (power_dump).
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "driver/uart.h"
+#include "irq.h"
+#include "log.h"
+#include "power.h"
+#include "systime.h"
+
+/* PWR_PMCR */
+#define PMCR_LPMS  (1 << 0) /* 0: Stop, 1: Standby */
+#define PMCR_SVOS  (3 << 2) /* Voltage scaling in Stop (3 : fastest wake) */
+#define PMCR_FLPS  (1 << 4) /* Flash low-power in Stop (slower wake) */
+#define PMCR_CSSF  (1 << 7) /* Clear STOPF and SBF */
+/* RCC_CR : oscillators and PLLs stopped by STOP mode */
+#define RCC_CR_STOP ((1 << 8) | (1 << 12) | (1 << 16) | (1 << 24) | (1 << 26) | (1 << 28))
+/* RCC_CFGR1 */
+#define CFGR1_STOPWUCK    (1 << 6)
+#define CFGR1_STOPKERWUCK (1 << 7)
+/* SCB_SCR */
+#define SCR_SLEEPDEEP (1 << 2)
+
+void EXTI15_Handler(void);
+
+static u32  _cycles(void);
+static void _stop(void);
+
+power_stats power_stat;
+static vu32 holds;
+static vu32 pending;  // Wake event not yet processed by the main loop
+static vu32 wake_cyc; // Cycle counter at the end of WFI (0 : not measured)
+static power_fct reader_fct;
+
+/**
+ * @brief Initialize the power manager and the wake sources
+ *
+ * The console wake source is configured by the UART driver, the RTC by
+ * systime. Interrupt lines are enabled by the interrupt manager.
+ */
+void power_init(void)
+{
+	uint i, j, pin = POWER_READER_PIN;
+
+	// holds are not cleared : drivers may be initialized before
+	pending = 0;
+	wake_cyc = 0;
+	reader_fct = 0;
+	power_stat.stops = 0;
+	power_stat.skipped = 0;
+	for (i = 0; i < POWER_WAKE_COUNT; i++)
+	{
+		for (j = 0; j < POWER_BUCKETS; j++)
+			power_stat.hist[i][j] = 0;
+		power_stat.max[i] = 0;
+	}
+
+	// Stop mode, fastest wake : highest voltage, flash kept in normal mode
+	reg_wr(PWR_PMCR(PWR), PMCR_SVOS | PMCR_CSSF);
+	// System and kernel clocks on HSI after STOP
+	reg_clr(RCC_CFGR1(RCC), CFGR1_STOPWUCK | CFGR1_STOPKERWUCK);
+
+	// Reader IRQ line : input with pull-up, falling edge (active low)
+	reg_clr(GPIO_MODER(POWER_READER_PORT), (3u << (pin * 2)));
+	reg_clr(GPIO_PUPDR(POWER_READER_PORT), (3u << (pin * 2)));
+	reg_set(GPIO_PUPDR(POWER_READER_PORT), (1u << (pin * 2)));
+	reg_clr(EXTI_EXTICR(EXTI, pin / 4), (0xFFu << ((pin % 4) * 8)));
+	reg_set(EXTI_EXTICR(EXTI, pin / 4), (4u << ((pin % 4) * 8))); // Port E
+	reg_set(EXTI_SECCFGR1(EXTI), (1u << pin));
+	reg_set(EXTI_FTSR1(EXTI), (1u << pin));
+	reg_wr (EXTI_FPR1(EXTI), (1u << pin));
+	reg_set(EXTI_IMR1(EXTI), (1u << pin));
+#ifdef HOST
+	sim_vector(IRQ_EXTI15, EXTI15_Handler);
+#endif
+}
+
+/**
+ * @brief Enter STOP mode if nothing has to be done
+ *
+ * This function is called by the main loop after each pass (loop_idle
+ * when the application runs). It returns
+ * after a wake event, once the handler of this event has been executed.
+ */
+void power_idle(void)
+{
+	u32 lock;
+
+	lock = hw_irq_save();
+	if (holds || pending)
+	{
+		pending = 0;
+		power_stat.skipped++;
+		hw_irq_restore(lock);
+		return;
+	}
+	// Wait for the end of the console output (the UART clock will stop)
+	uart_flush();
+
+	_stop();
+	power_stat.stops++;
+	// Handler of the wake source (called on restore) takes the measure
+	hw_irq_restore(lock);
+
+	if (wake_cyc)
+		power_mark(POWER_WAKE_OTHER);
+	pending = 0;
+
+	if ((power_stat.stops % POWER_DUMP_PERIOD) == 0)
+		power_dump();
+}
+
+/**
+ * @brief Prevent STOP mode (module that needs its clocks)
+ *
+ * @param mask Module(s) that need clocks (POWER_HOLD_*)
+ */
+void power_hold(u32 mask)
+{
+	u32 lock = hw_irq_save();
+	holds |= mask;
+	hw_irq_restore(lock);
+}
+
+/**
+ * @brief Allow STOP mode again, see power_hold
+ *
+ * @param mask Module(s) that no more need clocks (POWER_HOLD_*)
+ */
+void power_release(u32 mask)
+{
+	u32 lock = hw_irq_save();
+	holds &= ~mask;
+	hw_irq_restore(lock);
+}
+
+/**
+ * @brief Signal a wake event, called at the entry of wake handlers
+ *
+ * The main loop will make one more pass before the next STOP. For the
+ * first handler after a STOP, the wake latency is added to the histogram.
+ *
+ * @param src Wake source (POWER_WAKE_*)
+ */
+void power_mark(uint src)
+{
+	u32 d, lim;
+	uint b;
+
+	pending = 1;
+	if (wake_cyc == 0)
+		return;
+	d = _cycles() - wake_cyc;
+	wake_cyc = 0;
+
+	// Buckets of 1, 2, 4, 8, 16 us
+	lim = SYSTIME_HZ / 1000000;
+	for (b = 0; (b < (POWER_BUCKETS - 1)) && (d >= lim); b++)
+		lim <<= 1;
+	power_stat.hist[src][b]++;
+	if (d > power_stat.max[src])
+		power_stat.max[src] = d;
+}
+
+/**
+ * @brief Define a function called on reader activity (IRQ line)
+ *
+ * @param fct Pointer to the function, called from the EXTI interrupt
+ */
+void power_reader(power_fct fct)
+{
+	reader_fct = fct;
+}
+
+/**
+ * @brief Print the counters and the wake latency histograms
+ *
+ */
+void power_dump(void)
+{
+	static const char *names[POWER_WAKE_COUNT] = { "reader", "console", "rtc", "other" };
+	const u32 *h;
+	uint i;
+
+	log_print(0, " * POWER: %u stops, %u skipped, holds %8x\n",
+	          power_stat.stops, power_stat.skipped, holds);
+	log_print(0, "   wake\t<1us\t<2us\t<4us\t<8us\t<16us\tmore\tmax(cycles)\n");
+	for (i = 0; i < POWER_WAKE_COUNT; i++)
+	{
+		h = power_stat.hist[i];
+		log_print(0, "   %s\t%u\t%u\t%u\t%u\t%u\t%u\t%u\n", names[i],
+		          h[0], h[1], h[2], h[3], h[4], h[5], power_stat.max[i]);
+	}
+}
+
+/**
+ * @brief Interrupt handler of EXTI line 15 (card reader activity)
+ *
+ */
+void EXTI15_Handler(void)
+{
+	power_mark(POWER_WAKE_READER);
+	reg_wr(EXTI_FPR1(EXTI), (1u << POWER_READER_PIN));
+	if (reader_fct)
+		reader_fct();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Read the cycle counter (started by trace_init)
+ *
+ * @return u32 Current value of the counter (wraps)
+ */
+static u32 _cycles(void)
+{
+#ifdef HOST
+	return(1);
+#else
+	return reg_rd(DWT_CYCCNT);
+#endif
+}
+
+/**
+ * @brief Enter STOP mode, restore the clocks after the wake
+ *
+ * Called with interrupts masked : WFI returns on a pending interrupt but
+ * the handler is only executed when the mask is removed.
+ */
+static void _stop(void)
+{
+	u32 osc;
+
+	osc = reg_rd(RCC_CR(RCC)) & RCC_CR_STOP;
+	systime_suspend();
+	reg_wr(PWR_PMCR(PWR), PMCR_SVOS | PMCR_CSSF);
+	reg_set(SCB_SCR, SCR_SLEEPDEEP);
+#ifndef HOST
+	asm volatile("dsb 0xF":::"memory");
+	asm volatile("wfi");
+#endif
+	wake_cyc = _cycles() | 1;
+	reg_clr(SCB_SCR, SCR_SLEEPDEEP);
+
+	// The timer was stopped, then restart oscillators and PLLs (HSI is
+	// already the system clock, peripherals wait for their PLL lock)
+	systime_resume();
+	reg_set(RCC_CR(RCC), osc);
+}
+/* EOF */
@@ -0,0 +1,68 @@
+/**
+ * @file  power.h
+ * @brief Definitions and prototypes for the power manager (STOP mode)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef POWER_H
+#define POWER_H
+#include "types.h"
+
+/* Card reader activity : IRQ output of the reader on PE15 (EXTI15) */
+#define POWER_READER_PORT GPIOE
+#define POWER_READER_PIN  15
+
+/* Modules that need their clocks : STOP mode is not entered */
+#define POWER_HOLD_CAN  (1 << 0) /* FDCAN, no wake on bus activity */
+#define POWER_HOLD_ETH  (1 << 1) /* Ethernet link up */
+#define POWER_HOLD_USER (1 << 2) /* Console command, test ... */
+#define POWER_HOLD_ADC  (1 << 3) /* Supervised inputs, continuous scan */
+#define POWER_HOLD_RNG  (1 << 4) /* Entropy pool refill (TRNG running) */
+#define POWER_HOLD_PIPE (1 << 5) /* Door transactions in progress */
+
+/* Wake sources (histograms) */
+#define POWER_WAKE_READER  0
+#define POWER_WAKE_CONSOLE 1
+#define POWER_WAKE_RTC     2
+#define POWER_WAKE_OTHER   3
+#define POWER_WAKE_COUNT   4
+
+/* Counters printed every N STOP periods (RTC wake each second : 1 hour) */
+#define POWER_DUMP_PERIOD 3600
+
+/* Histogram buckets : latency below 1, 2, 4, 8, 16 us and above */
+#define POWER_BUCKETS 6
+
+typedef void (*power_fct)(void);
+
+/**
+ * @brief Counters of the power manager (see power_dump)
+ */
+typedef struct power_stats
+{
+	u32 stops;   // Number of STOP periods
+	u32 skipped; // Idle calls with a hold or pending work
+	u32 hist[POWER_WAKE_COUNT][POWER_BUCKETS];
+	u32 max[POWER_WAKE_COUNT]; // Highest latency (cycles)
+} power_stats;
+
+extern power_stats power_stat;
+
+void power_init   (void);
+void power_idle   (void);
+void power_hold   (u32 mask);
+void power_release(u32 mask);
+void power_mark   (uint src);
+void power_reader (power_fct fct);
+void power_dump   (void);
+
+#endif
@@ -0,0 +1,415 @@
+/**
+ * @file  ratelim.c
+ * @brief Rate limiter of PIN attempts (per reader and per credential)
+ *
+ * Each PIN attempt takes one token from the bucket of its reader and one
+ * from the bucket of its credential, before any lookup or crypto work.
+ * Buckets are refilled lazily : the tokens earned since the last use are
+ * computed from the monotonic clock when the bucket is used, no periodic
+ * scan of the tables is made. Consecutive wrong PINs start a lockout, its
+ * duration doubles with each new failure.
+ *
+ * The update of the buckets does not depend on their content (no branch
+ * on a token count, a lockout, or the position of the credential into its
+ * set) : the time of an attempt does not tell the state of the limiter.
+ * See doc/rate_limiter.md.
+ *
+ * These functions can be called from the reader handlers (IRQ_PRIO_READER)
+ * and from the main loop.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "entropy.h"
+#include "irq.h"
+#include "ratelim.h"
+#include "systime.h"
+
+#if ((RATELIM_READER_BURST * RATELIM_ONE) > 0x7FFFFFFF)
+#error "Reader burst does not fit into the fixed point tokens"
+#endif
+
+// Tokens by time unit, rounded up : one token in (at most) the refill time
+#define RATE(refill)      ((RATELIM_ONE + (refill) - 1) / (refill))
+// Time to refill an empty bucket, rounded up
+#define FULL(burst, refill) (((burst) * RATELIM_ONE + RATE(refill) - 1) / RATE(refill))
+
+/**
+ * @brief Token bucket (reader or credential)
+ */
+typedef struct ratelim_bucket
+{
+	u32 key;    // Credential (0 : unused), not used for readers
+	u32 stamp;  // Time of the last refill
+	u32 tokens; // Tokens left (fixed point, RATELIM_ONE for one attempt)
+	u32 since;  // Time of the last failure
+	u32 fails;  // Consecutive failures
+} ratelim_bucket;
+
+/**
+ * @brief Parameters of a class of buckets
+ */
+typedef struct ratelim_param
+{
+	u32 cap;   // Tokens of a full bucket
+	u32 rate;  // Tokens earned by time unit
+	u32 full;  // Time to refill an empty bucket
+	u32 fails; // Failures allowed before a lockout
+} ratelim_param;
+
+static void _refill(ratelim_bucket *b, u32 now, const ratelim_param *par);
+static u32  _locked(const ratelim_bucket *b, u32 now, const ratelim_param *par);
+static void _fail  (ratelim_bucket *b, u32 now, u32 success, const ratelim_param *par);
+static ratelim_bucket *_cred_bucket(u32 cred, u32 now);
+static void _rekey (void);
+static u32  _ct_lt (u32 a, u32 b);
+static u32  _ct_eq (u32 a, u32 b);
+static u32  _ct_sel(u32 mask, u32 a, u32 b);
+static u32  _ct_min(u32 a, u32 b);
+static u32  _mix   (u32 x);
+
+ratelim_stats ratelim_stat;
+
+static const ratelim_param reader_par =
+{
+	.cap   = RATELIM_READER_BURST * RATELIM_ONE,
+	.rate  = RATE(RATELIM_READER_REFILL),
+	.full  = FULL(RATELIM_READER_BURST, RATELIM_READER_REFILL),
+	.fails = RATELIM_READER_FAILS,
+};
+static const ratelim_param cred_par =
+{
+	.cap   = RATELIM_CRED_BURST * RATELIM_ONE,
+	.rate  = RATE(RATELIM_CRED_REFILL),
+	.full  = FULL(RATELIM_CRED_BURST, RATELIM_CRED_REFILL),
+	.fails = RATELIM_CRED_FAILS,
+};
+
+static ratelim_bucket readers[RATELIM_READERS];
+static ratelim_bucket creds[RATELIM_SETS * RATELIM_WAYS];
+static u32  clock_base; // Offset of the clock (see RATELIM_CLOCK_START)
+static u32  hash_key;   // Random key of the set index
+static uint keyed;
+
+/**
+ * @brief Initialize the rate limiter, all buckets full
+ *
+ */
+void ratelim_init(void)
+{
+	u32  now;
+	uint i;
+
+	ratelim_stat.allowed   = 0;
+	ratelim_stat.throttled = 0;
+	ratelim_stat.locked    = 0;
+	ratelim_stat.failures  = 0;
+	ratelim_stat.lockouts  = 0;
+	ratelim_stat.evicted   = 0;
+
+	clock_base = RATELIM_CLOCK_START - (u32)(systime_ticks() >> RATELIM_TICK_SHIFT);
+	now = ratelim_now();
+	for (i = 0; i < RATELIM_READERS; i++)
+	{
+		readers[i].key    = 0;
+		readers[i].stamp  = now;
+		readers[i].tokens = reader_par.cap;
+		readers[i].since  = now;
+		readers[i].fails  = 0;
+	}
+	for (i = 0; i < (RATELIM_SETS * RATELIM_WAYS); i++)
+		creds[i].key = 0;
+	// Key of the set index, taken when the entropy pool is filled
+	hash_key = 0;
+	keyed    = 0;
+}
+
+/**
+ * @brief Check a PIN attempt, take a token from its reader and credential
+ *
+ * This must be called before the lookup of the credential and the check
+ * of the PIN : a refused attempt must not cost any flash or crypto work.
+ * When the attempt is refused, no token is taken.
+ *
+ * @param reader Reader number (0 to RATELIM_READERS - 1)
+ * @param cred   Credential identifier (not 0)
+ * @return integer RATELIM_OK if the PIN can be checked, RATELIM_THROTTLED,
+ *                 RATELIM_LOCKED, or RATELIM_ERR for a bad argument
+ */
+int ratelim_attempt(uint reader, u32 cred)
+{
+	ratelim_bucket *r, *c;
+	u32 prev, now, lock, ok;
+
+	if ((reader >= RATELIM_READERS) || (cred == 0))
+		return(RATELIM_ERR);
+
+	prev = irq_lock(IRQ_PRIO_READER);
+	if (keyed == 0)
+		_rekey();
+	now = ratelim_now();
+	r = &readers[reader];
+	c = _cred_bucket(cred, now);
+	_refill(r, now, &reader_par);
+	_refill(c, now, &cred_par);
+
+	lock = _locked(r, now, &reader_par) | _locked(c, now, &cred_par);
+	ok   = ~_ct_lt(r->tokens, RATELIM_ONE) & ~_ct_lt(c->tokens, RATELIM_ONE) & ~lock;
+	r->tokens -= ok & RATELIM_ONE;
+	c->tokens -= ok & RATELIM_ONE;
+
+	ratelim_stat.allowed   += ok & 1;
+	ratelim_stat.locked    += lock & 1;
+	ratelim_stat.throttled += ~ok & ~lock & 1;
+	irq_unlock(prev);
+
+	return (int)_ct_sel(ok, (u32)RATELIM_OK,
+	                    _ct_sel(lock, (u32)RATELIM_LOCKED, (u32)RATELIM_THROTTLED));
+}
+
+/**
+ * @brief Report the result of the PIN check of an allowed attempt
+ *
+ * A wrong PIN counts one failure for the reader and the credential, a
+ * lockout starts when the allowed failures are reached. A good PIN clears
+ * the failures.
+ *
+ * @param reader  Reader number
+ * @param cred    Credential identifier
+ * @param success Non-zero if the PIN was right
+ */
+void ratelim_result(uint reader, u32 cred, int success)
+{
+	ratelim_bucket *c;
+	u32 prev, now, ok;
+
+	if ((reader >= RATELIM_READERS) || (cred == 0))
+		return;
+
+	ok = (u32)0 - (u32)(success != 0);
+	prev = irq_lock(IRQ_PRIO_READER);
+	now = ratelim_now();
+	c = _cred_bucket(cred, now);
+	_fail(&readers[reader], now, ok, &reader_par);
+	_fail(c, now, ok, &cred_par);
+	ratelim_stat.failures += ~ok & 1;
+	irq_unlock(prev);
+}
+
+/**
+ * @brief Get the clock of the buckets
+ *
+ * The clock counts units of 2^RATELIM_TICK_SHIFT timer cycles from
+ * RATELIM_CLOCK_START : it wraps a few minutes after boot. Durations are
+ * always computed as differences (modulo 2^32).
+ *
+ * @return u32 Current time (units)
+ */
+u32 ratelim_now(void)
+{
+	return (u32)(systime_ticks() >> RATELIM_TICK_SHIFT) + clock_base;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Add the tokens earned since the last use of a bucket
+ *
+ * The elapsed time is limited to the time of a full refill before the
+ * multiplication : the result never overflows, even for a bucket not used
+ * for a long time.
+ *
+ * @param b   Pointer to the bucket
+ * @param now Current time
+ * @param par Parameters of the bucket
+ */
+static void _refill(ratelim_bucket *b, u32 now, const ratelim_param *par)
+{
+	u32 elapsed;
+
+	elapsed   = _ct_min(now - b->stamp, par->full);
+	b->tokens = _ct_min(b->tokens + (elapsed * par->rate), par->cap);
+	b->stamp  = now;
+}
+
+/**
+ * @brief Test if a bucket is locked out
+ *
+ * After the allowed failures, the lockout lasts RATELIM_LOCK_MIN from the
+ * last failure, doubled for each failure beyond (up to RATELIM_LOCK_SHIFT
+ * times).
+ *
+ * @param b   Pointer to the bucket
+ * @param now Current time
+ * @param par Parameters of the bucket
+ * @return u32 All bits set if locked, 0 otherwise
+ */
+static u32 _locked(const ratelim_bucket *b, u32 now, const ratelim_param *par)
+{
+	u32 active, shift, len;
+
+	active = ~_ct_lt(b->fails, par->fails);
+	shift  = _ct_min(b->fails - par->fails, RATELIM_LOCK_SHIFT) & active;
+	len    = ((u32)RATELIM_LOCK_MIN << shift) & active;
+	return _ct_lt(now - b->since, len);
+}
+
+/**
+ * @brief Count a failure of a bucket, or clear its failures
+ *
+ * @param b       Pointer to the bucket
+ * @param now     Current time
+ * @param success All bits set for a good PIN, 0 for a wrong one
+ * @param par     Parameters of the bucket
+ */
+static void _fail(ratelim_bucket *b, u32 now, u32 success, const ratelim_param *par)
+{
+	u32 fails;
+
+	fails    = b->fails + (_ct_lt(b->fails, 0xFF) & 1);
+	b->fails = _ct_sel(success, 0, fails);
+	b->since = _ct_sel(success, b->since, now);
+	ratelim_stat.lockouts += ~success & _ct_eq(fails, par->fails) & 1;
+}
+
+/**
+ * @brief Get the bucket of a credential, a new one if not into the table
+ *
+ * All the ways of the set are read. When the credential is not found, the
+ * way with no failure not used for the longest time is replaced by a full
+ * bucket (ways with failures are replaced last).
+ *
+ * @param cred Credential identifier
+ * @param now  Current time
+ * @return ratelim_bucket* Pointer to the bucket
+ */
+static ratelim_bucket *_cred_bucket(u32 cred, u32 now)
+{
+	ratelim_bucket *set, *b;
+	u32 found = 0, way = 0, victim = 0, best = 0xFFFFFFFF;
+	u32 hit, score, lower, used;
+	uint i;
+
+	set = &creds[(_mix(cred ^ hash_key) >> (32 - RATELIM_SET_BITS)) * RATELIM_WAYS];
+	for (i = 0; i < RATELIM_WAYS; i++)
+	{
+		hit    = _ct_eq(set[i].key, cred);
+		way    = _ct_sel(hit, i, way);
+		found |= hit;
+		// Score to keep the way : failures first, then time of last use
+		score  = (_ct_lt(0, set[i].fails) & 0x80000000) |
+		         (0x7FFFFFFF - _ct_min(now - set[i].stamp, 0x7FFFFFFF));
+		score &= ~_ct_eq(set[i].key, 0);
+		lower  = _ct_lt(score, best);
+		best   = _ct_sel(lower, score, best);
+		victim = _ct_sel(lower, i, victim);
+	}
+	b = &set[_ct_sel(found, way, victim)];
+
+	used = ~_ct_eq(b->key, 0);
+	ratelim_stat.evicted += ~found & used & 1;
+	b->key    = cred;
+	b->stamp  = _ct_sel(found, b->stamp,  now);
+	b->tokens = _ct_sel(found, b->tokens, cred_par.cap);
+	b->since  = _ct_sel(found, b->since,  now);
+	b->fails  = _ct_sel(found, b->fails,  0);
+	return(b);
+}
+
+/**
+ * @brief Take a random key for the set index of the credentials
+ *
+ * The pool is empty just after boot : until the key is taken, buckets use
+ * key 0, they are cleared when the key is set.
+ */
+static void _rekey(void)
+{
+	u32  key;
+	uint i;
+
+	if (entropy_get((u8 *)&key, sizeof(key)) < 0)
+		return;
+	hash_key = key;
+	keyed = 1;
+	for (i = 0; i < (RATELIM_SETS * RATELIM_WAYS); i++)
+		creds[i].key = 0;
+}
+
+/**
+ * @brief Compare two values without branch
+ *
+ * @param a First value
+ * @param b Second value
+ * @return u32 All bits set if a < b, 0 otherwise
+ */
+static inline u32 _ct_lt(u32 a, u32 b)
+{
+	// Borrow of a - b
+	return (u32)0 - (((~a & b) | (~(a ^ b) & (a - b))) >> 31);
+}
+
+/**
+ * @brief Test the equality of two values without branch
+ *
+ * @param a First value
+ * @param b Second value
+ * @return u32 All bits set if a == b, 0 otherwise
+ */
+static inline u32 _ct_eq(u32 a, u32 b)
+{
+	u32 x = a ^ b;
+
+	return (((x | ((u32)0 - x)) >> 31) - 1);
+}
+
+/**
+ * @brief Select a value with a mask, without branch
+ *
+ * @param mask All bits set to select a, 0 to select b
+ * @param a    First value
+ * @param b    Second value
+ * @return u32 Selected value
+ */
+static inline u32 _ct_sel(u32 mask, u32 a, u32 b)
+{
+	return b ^ (mask & (a ^ b));
+}
+
+/**
+ * @brief Get the smallest of two values without branch
+ *
+ * @param a First value
+ * @param b Second value
+ * @return u32 Smallest value
+ */
+static inline u32 _ct_min(u32 a, u32 b)
+{
+	return _ct_sel(_ct_lt(a, b), a, b);
+}
+
+/**
+ * @brief Mix the bits of a word (set index)
+ *
+ * @param x Value to mix
+ * @return u32 Hash
+ */
+static u32 _mix(u32 x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352D;
+	x ^= x >> 15;
+	x *= 0x846CA68B;
+	x ^= x >> 16;
+	return(x);
+}
+/* EOF */
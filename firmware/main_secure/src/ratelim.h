@@ -0,0 +1,76 @@
+/**
+ * @file  ratelim.h
+ * @brief Definitions and prototypes for the PIN attempts rate limiter
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef RATELIM_H
+#define RATELIM_H
+#include "systime.h"
+#include "types.h"
+
+// Time unit of the buckets : 2^20 timer cycles (~33 ms), wraps after ~4.4 years
+#define RATELIM_TICK_SHIFT 20
+#define RATELIM_SEC(s)     ((u32)(((u64)(s) * SYSTIME_HZ) >> RATELIM_TICK_SHIFT))
+// The clock starts 5 minutes before its wrap, so wrap is used on each boot
+#define RATELIM_CLOCK_START ((u32)0 - RATELIM_SEC(300))
+
+/* Tables : one bucket per reader, credentials into a set associative table.
+ * 512 credential buckets of 20 bytes (10 kB of SRAM1) : a bucket only
+ * matters until it is full again (3 min) or while it has failures (these
+ * ways are replaced last). */
+#define RATELIM_READERS  32
+#define RATELIM_SET_BITS 7
+#define RATELIM_SETS     (1u << RATELIM_SET_BITS)
+#define RATELIM_WAYS     4
+
+/* Tokens are fixed point (24 bits of fraction), one token per attempt */
+#define RATELIM_ONE      (1u << 24)
+// Reader : burst of attempts, time to get back one attempt
+#define RATELIM_READER_BURST  10
+#define RATELIM_READER_REFILL RATELIM_SEC(6)
+#define RATELIM_READER_FAILS  10
+// Credential : burst of attempts, time to get back one attempt
+#define RATELIM_CRED_BURST    3
+#define RATELIM_CRED_REFILL   RATELIM_SEC(60)
+#define RATELIM_CRED_FAILS    3
+// Lockout after the allowed failures, doubled on each new failure
+#define RATELIM_LOCK_MIN   RATELIM_SEC(30)
+#define RATELIM_LOCK_SHIFT 7
+
+/* Result of ratelim_attempt */
+#define RATELIM_OK        0
+#define RATELIM_THROTTLED -1 /* No token left (reader or credential) */
+#define RATELIM_LOCKED    -2 /* Lockout after consecutive failures   */
+#define RATELIM_ERR       -3
+
+/**
+ * @brief Counters of the rate limiter
+ */
+typedef struct ratelim_stats
+{
+	u32 allowed;   // Attempts allowed
+	u32 throttled; // Attempts refused, no token left
+	u32 locked;    // Attempts refused during a lockout
+	u32 failures;  // Wrong PIN reported
+	u32 lockouts;  // Lockouts started (reader or credential)
+	u32 evicted;   // Credential buckets replaced (table set full)
+} ratelim_stats;
+
+extern ratelim_stats ratelim_stat;
+
+void ratelim_init   (void);
+int  ratelim_attempt(uint reader, u32 cred);
+void ratelim_result (uint reader, u32 cred, int success);
+u32  ratelim_now    (void);
+
+#endif
@@ -0,0 +1,1437 @@
+/**
+ * @file  regs.h
+ * @brief Register field accessors (generated by scripts/svd_gen.py)
+ *
+ * This file is generated from STM32H563_subset.svd, do not edit.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef REGS_H
+#define REGS_H
+#include "hardware.h"
+#include "types.h"
+
+/* -------------------------------------------------------------------------- */
+/* GPIO : General-purpose I/Os                                                */
+/* -------------------------------------------------------------------------- */
+
+/* MODER : port mode register */
+typedef struct { u32 v; u32 m; } gpio_moder_t;
+static inline gpio_moder_t gpio_moder(void) { gpio_moder_t r = { 0, 0 }; return r; }
+static inline gpio_moder_t gpio_moder_rd(u32 base) { gpio_moder_t r = { reg_rd(base + 0x00), 0 }; return r; }
+static inline void gpio_moder_wr(u32 base, gpio_moder_t r) { reg_wr(base + 0x00, r.v); }
+static inline void gpio_moder_modify(u32 base, gpio_moder_t r) { reg_wr(base + 0x00, (reg_rd(base + 0x00) & ~r.m) | r.v); }
+#define GPIO_MODER_MODE0_Pos 0
+#define GPIO_MODER_MODE0_Msk 0x00000003u
+static inline gpio_moder_t gpio_moder_mode0(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x00000003u) | ((v << 0) & 0x00000003u); r.m |= 0x00000003u; return r; }
+static inline u32 gpio_moder_mode0_get(gpio_moder_t r) { return (r.v & 0x00000003u) >> 0; }
+#define GPIO_MODER_MODE1_Pos 2
+#define GPIO_MODER_MODE1_Msk 0x0000000Cu
+static inline gpio_moder_t gpio_moder_mode1(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x0000000Cu) | ((v << 2) & 0x0000000Cu); r.m |= 0x0000000Cu; return r; }
+static inline u32 gpio_moder_mode1_get(gpio_moder_t r) { return (r.v & 0x0000000Cu) >> 2; }
+#define GPIO_MODER_MODE2_Pos 4
+#define GPIO_MODER_MODE2_Msk 0x00000030u
+static inline gpio_moder_t gpio_moder_mode2(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x00000030u) | ((v << 4) & 0x00000030u); r.m |= 0x00000030u; return r; }
+static inline u32 gpio_moder_mode2_get(gpio_moder_t r) { return (r.v & 0x00000030u) >> 4; }
+#define GPIO_MODER_MODE3_Pos 6
+#define GPIO_MODER_MODE3_Msk 0x000000C0u
+static inline gpio_moder_t gpio_moder_mode3(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x000000C0u) | ((v << 6) & 0x000000C0u); r.m |= 0x000000C0u; return r; }
+static inline u32 gpio_moder_mode3_get(gpio_moder_t r) { return (r.v & 0x000000C0u) >> 6; }
+#define GPIO_MODER_MODE4_Pos 8
+#define GPIO_MODER_MODE4_Msk 0x00000300u
+static inline gpio_moder_t gpio_moder_mode4(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x00000300u) | ((v << 8) & 0x00000300u); r.m |= 0x00000300u; return r; }
+static inline u32 gpio_moder_mode4_get(gpio_moder_t r) { return (r.v & 0x00000300u) >> 8; }
+#define GPIO_MODER_MODE5_Pos 10
+#define GPIO_MODER_MODE5_Msk 0x00000C00u
+static inline gpio_moder_t gpio_moder_mode5(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x00000C00u) | ((v << 10) & 0x00000C00u); r.m |= 0x00000C00u; return r; }
+static inline u32 gpio_moder_mode5_get(gpio_moder_t r) { return (r.v & 0x00000C00u) >> 10; }
+#define GPIO_MODER_MODE6_Pos 12
+#define GPIO_MODER_MODE6_Msk 0x00003000u
+static inline gpio_moder_t gpio_moder_mode6(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x00003000u) | ((v << 12) & 0x00003000u); r.m |= 0x00003000u; return r; }
+static inline u32 gpio_moder_mode6_get(gpio_moder_t r) { return (r.v & 0x00003000u) >> 12; }
+#define GPIO_MODER_MODE7_Pos 14
+#define GPIO_MODER_MODE7_Msk 0x0000C000u
+static inline gpio_moder_t gpio_moder_mode7(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x0000C000u) | ((v << 14) & 0x0000C000u); r.m |= 0x0000C000u; return r; }
+static inline u32 gpio_moder_mode7_get(gpio_moder_t r) { return (r.v & 0x0000C000u) >> 14; }
+#define GPIO_MODER_MODE8_Pos 16
+#define GPIO_MODER_MODE8_Msk 0x00030000u
+static inline gpio_moder_t gpio_moder_mode8(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x00030000u) | ((v << 16) & 0x00030000u); r.m |= 0x00030000u; return r; }
+static inline u32 gpio_moder_mode8_get(gpio_moder_t r) { return (r.v & 0x00030000u) >> 16; }
+#define GPIO_MODER_MODE9_Pos 18
+#define GPIO_MODER_MODE9_Msk 0x000C0000u
+static inline gpio_moder_t gpio_moder_mode9(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x000C0000u) | ((v << 18) & 0x000C0000u); r.m |= 0x000C0000u; return r; }
+static inline u32 gpio_moder_mode9_get(gpio_moder_t r) { return (r.v & 0x000C0000u) >> 18; }
+#define GPIO_MODER_MODE10_Pos 20
+#define GPIO_MODER_MODE10_Msk 0x00300000u
+static inline gpio_moder_t gpio_moder_mode10(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x00300000u) | ((v << 20) & 0x00300000u); r.m |= 0x00300000u; return r; }
+static inline u32 gpio_moder_mode10_get(gpio_moder_t r) { return (r.v & 0x00300000u) >> 20; }
+#define GPIO_MODER_MODE11_Pos 22
+#define GPIO_MODER_MODE11_Msk 0x00C00000u
+static inline gpio_moder_t gpio_moder_mode11(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x00C00000u) | ((v << 22) & 0x00C00000u); r.m |= 0x00C00000u; return r; }
+static inline u32 gpio_moder_mode11_get(gpio_moder_t r) { return (r.v & 0x00C00000u) >> 22; }
+#define GPIO_MODER_MODE12_Pos 24
+#define GPIO_MODER_MODE12_Msk 0x03000000u
+static inline gpio_moder_t gpio_moder_mode12(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x03000000u) | ((v << 24) & 0x03000000u); r.m |= 0x03000000u; return r; }
+static inline u32 gpio_moder_mode12_get(gpio_moder_t r) { return (r.v & 0x03000000u) >> 24; }
+#define GPIO_MODER_MODE13_Pos 26
+#define GPIO_MODER_MODE13_Msk 0x0C000000u
+static inline gpio_moder_t gpio_moder_mode13(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x0C000000u) | ((v << 26) & 0x0C000000u); r.m |= 0x0C000000u; return r; }
+static inline u32 gpio_moder_mode13_get(gpio_moder_t r) { return (r.v & 0x0C000000u) >> 26; }
+#define GPIO_MODER_MODE14_Pos 28
+#define GPIO_MODER_MODE14_Msk 0x30000000u
+static inline gpio_moder_t gpio_moder_mode14(gpio_moder_t r, u32 v) { r.v = (r.v & ~0x30000000u) | ((v << 28) & 0x30000000u); r.m |= 0x30000000u; return r; }
+static inline u32 gpio_moder_mode14_get(gpio_moder_t r) { return (r.v & 0x30000000u) >> 28; }
+#define GPIO_MODER_MODE15_Pos 30
+#define GPIO_MODER_MODE15_Msk 0xC0000000u
+static inline gpio_moder_t gpio_moder_mode15(gpio_moder_t r, u32 v) { r.v = (r.v & ~0xC0000000u) | ((v << 30) & 0xC0000000u); r.m |= 0xC0000000u; return r; }
+static inline u32 gpio_moder_mode15_get(gpio_moder_t r) { return (r.v & 0xC0000000u) >> 30; }
+
+/* OTYPER : port output type register */
+typedef struct { u32 v; u32 m; } gpio_otyper_t;
+static inline gpio_otyper_t gpio_otyper(void) { gpio_otyper_t r = { 0, 0 }; return r; }
+static inline gpio_otyper_t gpio_otyper_rd(u32 base) { gpio_otyper_t r = { reg_rd(base + 0x04), 0 }; return r; }
+static inline void gpio_otyper_wr(u32 base, gpio_otyper_t r) { reg_wr(base + 0x04, r.v); }
+static inline void gpio_otyper_modify(u32 base, gpio_otyper_t r) { reg_wr(base + 0x04, (reg_rd(base + 0x04) & ~r.m) | r.v); }
+#define GPIO_OTYPER_OT0_Pos 0
+#define GPIO_OTYPER_OT0_Msk 0x00000001u
+static inline gpio_otyper_t gpio_otyper_ot0(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 gpio_otyper_ot0_get(gpio_otyper_t r) { return (r.v & 0x00000001u) >> 0; }
+#define GPIO_OTYPER_OT1_Pos 1
+#define GPIO_OTYPER_OT1_Msk 0x00000002u
+static inline gpio_otyper_t gpio_otyper_ot1(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 gpio_otyper_ot1_get(gpio_otyper_t r) { return (r.v & 0x00000002u) >> 1; }
+#define GPIO_OTYPER_OT2_Pos 2
+#define GPIO_OTYPER_OT2_Msk 0x00000004u
+static inline gpio_otyper_t gpio_otyper_ot2(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 gpio_otyper_ot2_get(gpio_otyper_t r) { return (r.v & 0x00000004u) >> 2; }
+#define GPIO_OTYPER_OT3_Pos 3
+#define GPIO_OTYPER_OT3_Msk 0x00000008u
+static inline gpio_otyper_t gpio_otyper_ot3(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 gpio_otyper_ot3_get(gpio_otyper_t r) { return (r.v & 0x00000008u) >> 3; }
+#define GPIO_OTYPER_OT4_Pos 4
+#define GPIO_OTYPER_OT4_Msk 0x00000010u
+static inline gpio_otyper_t gpio_otyper_ot4(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 gpio_otyper_ot4_get(gpio_otyper_t r) { return (r.v & 0x00000010u) >> 4; }
+#define GPIO_OTYPER_OT5_Pos 5
+#define GPIO_OTYPER_OT5_Msk 0x00000020u
+static inline gpio_otyper_t gpio_otyper_ot5(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 gpio_otyper_ot5_get(gpio_otyper_t r) { return (r.v & 0x00000020u) >> 5; }
+#define GPIO_OTYPER_OT6_Pos 6
+#define GPIO_OTYPER_OT6_Msk 0x00000040u
+static inline gpio_otyper_t gpio_otyper_ot6(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 gpio_otyper_ot6_get(gpio_otyper_t r) { return (r.v & 0x00000040u) >> 6; }
+#define GPIO_OTYPER_OT7_Pos 7
+#define GPIO_OTYPER_OT7_Msk 0x00000080u
+static inline gpio_otyper_t gpio_otyper_ot7(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 gpio_otyper_ot7_get(gpio_otyper_t r) { return (r.v & 0x00000080u) >> 7; }
+#define GPIO_OTYPER_OT8_Pos 8
+#define GPIO_OTYPER_OT8_Msk 0x00000100u
+static inline gpio_otyper_t gpio_otyper_ot8(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 gpio_otyper_ot8_get(gpio_otyper_t r) { return (r.v & 0x00000100u) >> 8; }
+#define GPIO_OTYPER_OT9_Pos 9
+#define GPIO_OTYPER_OT9_Msk 0x00000200u
+static inline gpio_otyper_t gpio_otyper_ot9(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000200u) | ((v << 9) & 0x00000200u); r.m |= 0x00000200u; return r; }
+static inline u32 gpio_otyper_ot9_get(gpio_otyper_t r) { return (r.v & 0x00000200u) >> 9; }
+#define GPIO_OTYPER_OT10_Pos 10
+#define GPIO_OTYPER_OT10_Msk 0x00000400u
+static inline gpio_otyper_t gpio_otyper_ot10(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000400u) | ((v << 10) & 0x00000400u); r.m |= 0x00000400u; return r; }
+static inline u32 gpio_otyper_ot10_get(gpio_otyper_t r) { return (r.v & 0x00000400u) >> 10; }
+#define GPIO_OTYPER_OT11_Pos 11
+#define GPIO_OTYPER_OT11_Msk 0x00000800u
+static inline gpio_otyper_t gpio_otyper_ot11(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00000800u) | ((v << 11) & 0x00000800u); r.m |= 0x00000800u; return r; }
+static inline u32 gpio_otyper_ot11_get(gpio_otyper_t r) { return (r.v & 0x00000800u) >> 11; }
+#define GPIO_OTYPER_OT12_Pos 12
+#define GPIO_OTYPER_OT12_Msk 0x00001000u
+static inline gpio_otyper_t gpio_otyper_ot12(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 gpio_otyper_ot12_get(gpio_otyper_t r) { return (r.v & 0x00001000u) >> 12; }
+#define GPIO_OTYPER_OT13_Pos 13
+#define GPIO_OTYPER_OT13_Msk 0x00002000u
+static inline gpio_otyper_t gpio_otyper_ot13(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00002000u) | ((v << 13) & 0x00002000u); r.m |= 0x00002000u; return r; }
+static inline u32 gpio_otyper_ot13_get(gpio_otyper_t r) { return (r.v & 0x00002000u) >> 13; }
+#define GPIO_OTYPER_OT14_Pos 14
+#define GPIO_OTYPER_OT14_Msk 0x00004000u
+static inline gpio_otyper_t gpio_otyper_ot14(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00004000u) | ((v << 14) & 0x00004000u); r.m |= 0x00004000u; return r; }
+static inline u32 gpio_otyper_ot14_get(gpio_otyper_t r) { return (r.v & 0x00004000u) >> 14; }
+#define GPIO_OTYPER_OT15_Pos 15
+#define GPIO_OTYPER_OT15_Msk 0x00008000u
+static inline gpio_otyper_t gpio_otyper_ot15(gpio_otyper_t r, u32 v) { r.v = (r.v & ~0x00008000u) | ((v << 15) & 0x00008000u); r.m |= 0x00008000u; return r; }
+static inline u32 gpio_otyper_ot15_get(gpio_otyper_t r) { return (r.v & 0x00008000u) >> 15; }
+
+/* OSPEEDR : port output speed register */
+typedef struct { u32 v; u32 m; } gpio_ospeedr_t;
+static inline gpio_ospeedr_t gpio_ospeedr(void) { gpio_ospeedr_t r = { 0, 0 }; return r; }
+static inline gpio_ospeedr_t gpio_ospeedr_rd(u32 base) { gpio_ospeedr_t r = { reg_rd(base + 0x08), 0 }; return r; }
+static inline void gpio_ospeedr_wr(u32 base, gpio_ospeedr_t r) { reg_wr(base + 0x08, r.v); }
+static inline void gpio_ospeedr_modify(u32 base, gpio_ospeedr_t r) { reg_wr(base + 0x08, (reg_rd(base + 0x08) & ~r.m) | r.v); }
+#define GPIO_OSPEEDR_OSPEED0_Pos 0
+#define GPIO_OSPEEDR_OSPEED0_Msk 0x00000003u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed0(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x00000003u) | ((v << 0) & 0x00000003u); r.m |= 0x00000003u; return r; }
+static inline u32 gpio_ospeedr_ospeed0_get(gpio_ospeedr_t r) { return (r.v & 0x00000003u) >> 0; }
+#define GPIO_OSPEEDR_OSPEED1_Pos 2
+#define GPIO_OSPEEDR_OSPEED1_Msk 0x0000000Cu
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed1(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x0000000Cu) | ((v << 2) & 0x0000000Cu); r.m |= 0x0000000Cu; return r; }
+static inline u32 gpio_ospeedr_ospeed1_get(gpio_ospeedr_t r) { return (r.v & 0x0000000Cu) >> 2; }
+#define GPIO_OSPEEDR_OSPEED2_Pos 4
+#define GPIO_OSPEEDR_OSPEED2_Msk 0x00000030u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed2(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x00000030u) | ((v << 4) & 0x00000030u); r.m |= 0x00000030u; return r; }
+static inline u32 gpio_ospeedr_ospeed2_get(gpio_ospeedr_t r) { return (r.v & 0x00000030u) >> 4; }
+#define GPIO_OSPEEDR_OSPEED3_Pos 6
+#define GPIO_OSPEEDR_OSPEED3_Msk 0x000000C0u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed3(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x000000C0u) | ((v << 6) & 0x000000C0u); r.m |= 0x000000C0u; return r; }
+static inline u32 gpio_ospeedr_ospeed3_get(gpio_ospeedr_t r) { return (r.v & 0x000000C0u) >> 6; }
+#define GPIO_OSPEEDR_OSPEED4_Pos 8
+#define GPIO_OSPEEDR_OSPEED4_Msk 0x00000300u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed4(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x00000300u) | ((v << 8) & 0x00000300u); r.m |= 0x00000300u; return r; }
+static inline u32 gpio_ospeedr_ospeed4_get(gpio_ospeedr_t r) { return (r.v & 0x00000300u) >> 8; }
+#define GPIO_OSPEEDR_OSPEED5_Pos 10
+#define GPIO_OSPEEDR_OSPEED5_Msk 0x00000C00u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed5(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x00000C00u) | ((v << 10) & 0x00000C00u); r.m |= 0x00000C00u; return r; }
+static inline u32 gpio_ospeedr_ospeed5_get(gpio_ospeedr_t r) { return (r.v & 0x00000C00u) >> 10; }
+#define GPIO_OSPEEDR_OSPEED6_Pos 12
+#define GPIO_OSPEEDR_OSPEED6_Msk 0x00003000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed6(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x00003000u) | ((v << 12) & 0x00003000u); r.m |= 0x00003000u; return r; }
+static inline u32 gpio_ospeedr_ospeed6_get(gpio_ospeedr_t r) { return (r.v & 0x00003000u) >> 12; }
+#define GPIO_OSPEEDR_OSPEED7_Pos 14
+#define GPIO_OSPEEDR_OSPEED7_Msk 0x0000C000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed7(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x0000C000u) | ((v << 14) & 0x0000C000u); r.m |= 0x0000C000u; return r; }
+static inline u32 gpio_ospeedr_ospeed7_get(gpio_ospeedr_t r) { return (r.v & 0x0000C000u) >> 14; }
+#define GPIO_OSPEEDR_OSPEED8_Pos 16
+#define GPIO_OSPEEDR_OSPEED8_Msk 0x00030000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed8(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x00030000u) | ((v << 16) & 0x00030000u); r.m |= 0x00030000u; return r; }
+static inline u32 gpio_ospeedr_ospeed8_get(gpio_ospeedr_t r) { return (r.v & 0x00030000u) >> 16; }
+#define GPIO_OSPEEDR_OSPEED9_Pos 18
+#define GPIO_OSPEEDR_OSPEED9_Msk 0x000C0000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed9(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x000C0000u) | ((v << 18) & 0x000C0000u); r.m |= 0x000C0000u; return r; }
+static inline u32 gpio_ospeedr_ospeed9_get(gpio_ospeedr_t r) { return (r.v & 0x000C0000u) >> 18; }
+#define GPIO_OSPEEDR_OSPEED10_Pos 20
+#define GPIO_OSPEEDR_OSPEED10_Msk 0x00300000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed10(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x00300000u) | ((v << 20) & 0x00300000u); r.m |= 0x00300000u; return r; }
+static inline u32 gpio_ospeedr_ospeed10_get(gpio_ospeedr_t r) { return (r.v & 0x00300000u) >> 20; }
+#define GPIO_OSPEEDR_OSPEED11_Pos 22
+#define GPIO_OSPEEDR_OSPEED11_Msk 0x00C00000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed11(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x00C00000u) | ((v << 22) & 0x00C00000u); r.m |= 0x00C00000u; return r; }
+static inline u32 gpio_ospeedr_ospeed11_get(gpio_ospeedr_t r) { return (r.v & 0x00C00000u) >> 22; }
+#define GPIO_OSPEEDR_OSPEED12_Pos 24
+#define GPIO_OSPEEDR_OSPEED12_Msk 0x03000000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed12(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x03000000u) | ((v << 24) & 0x03000000u); r.m |= 0x03000000u; return r; }
+static inline u32 gpio_ospeedr_ospeed12_get(gpio_ospeedr_t r) { return (r.v & 0x03000000u) >> 24; }
+#define GPIO_OSPEEDR_OSPEED13_Pos 26
+#define GPIO_OSPEEDR_OSPEED13_Msk 0x0C000000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed13(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x0C000000u) | ((v << 26) & 0x0C000000u); r.m |= 0x0C000000u; return r; }
+static inline u32 gpio_ospeedr_ospeed13_get(gpio_ospeedr_t r) { return (r.v & 0x0C000000u) >> 26; }
+#define GPIO_OSPEEDR_OSPEED14_Pos 28
+#define GPIO_OSPEEDR_OSPEED14_Msk 0x30000000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed14(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0x30000000u) | ((v << 28) & 0x30000000u); r.m |= 0x30000000u; return r; }
+static inline u32 gpio_ospeedr_ospeed14_get(gpio_ospeedr_t r) { return (r.v & 0x30000000u) >> 28; }
+#define GPIO_OSPEEDR_OSPEED15_Pos 30
+#define GPIO_OSPEEDR_OSPEED15_Msk 0xC0000000u
+static inline gpio_ospeedr_t gpio_ospeedr_ospeed15(gpio_ospeedr_t r, u32 v) { r.v = (r.v & ~0xC0000000u) | ((v << 30) & 0xC0000000u); r.m |= 0xC0000000u; return r; }
+static inline u32 gpio_ospeedr_ospeed15_get(gpio_ospeedr_t r) { return (r.v & 0xC0000000u) >> 30; }
+
+/* PUPDR : port pull-up/pull-down register */
+typedef struct { u32 v; u32 m; } gpio_pupdr_t;
+static inline gpio_pupdr_t gpio_pupdr(void) { gpio_pupdr_t r = { 0, 0 }; return r; }
+static inline gpio_pupdr_t gpio_pupdr_rd(u32 base) { gpio_pupdr_t r = { reg_rd(base + 0x0C), 0 }; return r; }
+static inline void gpio_pupdr_wr(u32 base, gpio_pupdr_t r) { reg_wr(base + 0x0C, r.v); }
+static inline void gpio_pupdr_modify(u32 base, gpio_pupdr_t r) { reg_wr(base + 0x0C, (reg_rd(base + 0x0C) & ~r.m) | r.v); }
+#define GPIO_PUPDR_PUPD0_Pos 0
+#define GPIO_PUPDR_PUPD0_Msk 0x00000003u
+static inline gpio_pupdr_t gpio_pupdr_pupd0(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x00000003u) | ((v << 0) & 0x00000003u); r.m |= 0x00000003u; return r; }
+static inline u32 gpio_pupdr_pupd0_get(gpio_pupdr_t r) { return (r.v & 0x00000003u) >> 0; }
+#define GPIO_PUPDR_PUPD1_Pos 2
+#define GPIO_PUPDR_PUPD1_Msk 0x0000000Cu
+static inline gpio_pupdr_t gpio_pupdr_pupd1(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x0000000Cu) | ((v << 2) & 0x0000000Cu); r.m |= 0x0000000Cu; return r; }
+static inline u32 gpio_pupdr_pupd1_get(gpio_pupdr_t r) { return (r.v & 0x0000000Cu) >> 2; }
+#define GPIO_PUPDR_PUPD2_Pos 4
+#define GPIO_PUPDR_PUPD2_Msk 0x00000030u
+static inline gpio_pupdr_t gpio_pupdr_pupd2(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x00000030u) | ((v << 4) & 0x00000030u); r.m |= 0x00000030u; return r; }
+static inline u32 gpio_pupdr_pupd2_get(gpio_pupdr_t r) { return (r.v & 0x00000030u) >> 4; }
+#define GPIO_PUPDR_PUPD3_Pos 6
+#define GPIO_PUPDR_PUPD3_Msk 0x000000C0u
+static inline gpio_pupdr_t gpio_pupdr_pupd3(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x000000C0u) | ((v << 6) & 0x000000C0u); r.m |= 0x000000C0u; return r; }
+static inline u32 gpio_pupdr_pupd3_get(gpio_pupdr_t r) { return (r.v & 0x000000C0u) >> 6; }
+#define GPIO_PUPDR_PUPD4_Pos 8
+#define GPIO_PUPDR_PUPD4_Msk 0x00000300u
+static inline gpio_pupdr_t gpio_pupdr_pupd4(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x00000300u) | ((v << 8) & 0x00000300u); r.m |= 0x00000300u; return r; }
+static inline u32 gpio_pupdr_pupd4_get(gpio_pupdr_t r) { return (r.v & 0x00000300u) >> 8; }
+#define GPIO_PUPDR_PUPD5_Pos 10
+#define GPIO_PUPDR_PUPD5_Msk 0x00000C00u
+static inline gpio_pupdr_t gpio_pupdr_pupd5(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x00000C00u) | ((v << 10) & 0x00000C00u); r.m |= 0x00000C00u; return r; }
+static inline u32 gpio_pupdr_pupd5_get(gpio_pupdr_t r) { return (r.v & 0x00000C00u) >> 10; }
+#define GPIO_PUPDR_PUPD6_Pos 12
+#define GPIO_PUPDR_PUPD6_Msk 0x00003000u
+static inline gpio_pupdr_t gpio_pupdr_pupd6(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x00003000u) | ((v << 12) & 0x00003000u); r.m |= 0x00003000u; return r; }
+static inline u32 gpio_pupdr_pupd6_get(gpio_pupdr_t r) { return (r.v & 0x00003000u) >> 12; }
+#define GPIO_PUPDR_PUPD7_Pos 14
+#define GPIO_PUPDR_PUPD7_Msk 0x0000C000u
+static inline gpio_pupdr_t gpio_pupdr_pupd7(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x0000C000u) | ((v << 14) & 0x0000C000u); r.m |= 0x0000C000u; return r; }
+static inline u32 gpio_pupdr_pupd7_get(gpio_pupdr_t r) { return (r.v & 0x0000C000u) >> 14; }
+#define GPIO_PUPDR_PUPD8_Pos 16
+#define GPIO_PUPDR_PUPD8_Msk 0x00030000u
+static inline gpio_pupdr_t gpio_pupdr_pupd8(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x00030000u) | ((v << 16) & 0x00030000u); r.m |= 0x00030000u; return r; }
+static inline u32 gpio_pupdr_pupd8_get(gpio_pupdr_t r) { return (r.v & 0x00030000u) >> 16; }
+#define GPIO_PUPDR_PUPD9_Pos 18
+#define GPIO_PUPDR_PUPD9_Msk 0x000C0000u
+static inline gpio_pupdr_t gpio_pupdr_pupd9(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x000C0000u) | ((v << 18) & 0x000C0000u); r.m |= 0x000C0000u; return r; }
+static inline u32 gpio_pupdr_pupd9_get(gpio_pupdr_t r) { return (r.v & 0x000C0000u) >> 18; }
+#define GPIO_PUPDR_PUPD10_Pos 20
+#define GPIO_PUPDR_PUPD10_Msk 0x00300000u
+static inline gpio_pupdr_t gpio_pupdr_pupd10(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x00300000u) | ((v << 20) & 0x00300000u); r.m |= 0x00300000u; return r; }
+static inline u32 gpio_pupdr_pupd10_get(gpio_pupdr_t r) { return (r.v & 0x00300000u) >> 20; }
+#define GPIO_PUPDR_PUPD11_Pos 22
+#define GPIO_PUPDR_PUPD11_Msk 0x00C00000u
+static inline gpio_pupdr_t gpio_pupdr_pupd11(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x00C00000u) | ((v << 22) & 0x00C00000u); r.m |= 0x00C00000u; return r; }
+static inline u32 gpio_pupdr_pupd11_get(gpio_pupdr_t r) { return (r.v & 0x00C00000u) >> 22; }
+#define GPIO_PUPDR_PUPD12_Pos 24
+#define GPIO_PUPDR_PUPD12_Msk 0x03000000u
+static inline gpio_pupdr_t gpio_pupdr_pupd12(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x03000000u) | ((v << 24) & 0x03000000u); r.m |= 0x03000000u; return r; }
+static inline u32 gpio_pupdr_pupd12_get(gpio_pupdr_t r) { return (r.v & 0x03000000u) >> 24; }
+#define GPIO_PUPDR_PUPD13_Pos 26
+#define GPIO_PUPDR_PUPD13_Msk 0x0C000000u
+static inline gpio_pupdr_t gpio_pupdr_pupd13(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x0C000000u) | ((v << 26) & 0x0C000000u); r.m |= 0x0C000000u; return r; }
+static inline u32 gpio_pupdr_pupd13_get(gpio_pupdr_t r) { return (r.v & 0x0C000000u) >> 26; }
+#define GPIO_PUPDR_PUPD14_Pos 28
+#define GPIO_PUPDR_PUPD14_Msk 0x30000000u
+static inline gpio_pupdr_t gpio_pupdr_pupd14(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0x30000000u) | ((v << 28) & 0x30000000u); r.m |= 0x30000000u; return r; }
+static inline u32 gpio_pupdr_pupd14_get(gpio_pupdr_t r) { return (r.v & 0x30000000u) >> 28; }
+#define GPIO_PUPDR_PUPD15_Pos 30
+#define GPIO_PUPDR_PUPD15_Msk 0xC0000000u
+static inline gpio_pupdr_t gpio_pupdr_pupd15(gpio_pupdr_t r, u32 v) { r.v = (r.v & ~0xC0000000u) | ((v << 30) & 0xC0000000u); r.m |= 0xC0000000u; return r; }
+static inline u32 gpio_pupdr_pupd15_get(gpio_pupdr_t r) { return (r.v & 0xC0000000u) >> 30; }
+
+/* IDR : port input data register */
+typedef struct { u32 v; u32 m; } gpio_idr_t;
+static inline gpio_idr_t gpio_idr(void) { gpio_idr_t r = { 0, 0 }; return r; }
+static inline gpio_idr_t gpio_idr_rd(u32 base) { gpio_idr_t r = { reg_rd(base + 0x10), 0 }; return r; }
+static inline void gpio_idr_wr(u32 base, gpio_idr_t r) { reg_wr(base + 0x10, r.v); }
+static inline void gpio_idr_modify(u32 base, gpio_idr_t r) { reg_wr(base + 0x10, (reg_rd(base + 0x10) & ~r.m) | r.v); }
+#define GPIO_IDR_ID0_Pos 0
+#define GPIO_IDR_ID0_Msk 0x00000001u
+static inline gpio_idr_t gpio_idr_id0(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 gpio_idr_id0_get(gpio_idr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define GPIO_IDR_ID1_Pos 1
+#define GPIO_IDR_ID1_Msk 0x00000002u
+static inline gpio_idr_t gpio_idr_id1(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 gpio_idr_id1_get(gpio_idr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define GPIO_IDR_ID2_Pos 2
+#define GPIO_IDR_ID2_Msk 0x00000004u
+static inline gpio_idr_t gpio_idr_id2(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 gpio_idr_id2_get(gpio_idr_t r) { return (r.v & 0x00000004u) >> 2; }
+#define GPIO_IDR_ID3_Pos 3
+#define GPIO_IDR_ID3_Msk 0x00000008u
+static inline gpio_idr_t gpio_idr_id3(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 gpio_idr_id3_get(gpio_idr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define GPIO_IDR_ID4_Pos 4
+#define GPIO_IDR_ID4_Msk 0x00000010u
+static inline gpio_idr_t gpio_idr_id4(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 gpio_idr_id4_get(gpio_idr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define GPIO_IDR_ID5_Pos 5
+#define GPIO_IDR_ID5_Msk 0x00000020u
+static inline gpio_idr_t gpio_idr_id5(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 gpio_idr_id5_get(gpio_idr_t r) { return (r.v & 0x00000020u) >> 5; }
+#define GPIO_IDR_ID6_Pos 6
+#define GPIO_IDR_ID6_Msk 0x00000040u
+static inline gpio_idr_t gpio_idr_id6(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 gpio_idr_id6_get(gpio_idr_t r) { return (r.v & 0x00000040u) >> 6; }
+#define GPIO_IDR_ID7_Pos 7
+#define GPIO_IDR_ID7_Msk 0x00000080u
+static inline gpio_idr_t gpio_idr_id7(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 gpio_idr_id7_get(gpio_idr_t r) { return (r.v & 0x00000080u) >> 7; }
+#define GPIO_IDR_ID8_Pos 8
+#define GPIO_IDR_ID8_Msk 0x00000100u
+static inline gpio_idr_t gpio_idr_id8(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 gpio_idr_id8_get(gpio_idr_t r) { return (r.v & 0x00000100u) >> 8; }
+#define GPIO_IDR_ID9_Pos 9
+#define GPIO_IDR_ID9_Msk 0x00000200u
+static inline gpio_idr_t gpio_idr_id9(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000200u) | ((v << 9) & 0x00000200u); r.m |= 0x00000200u; return r; }
+static inline u32 gpio_idr_id9_get(gpio_idr_t r) { return (r.v & 0x00000200u) >> 9; }
+#define GPIO_IDR_ID10_Pos 10
+#define GPIO_IDR_ID10_Msk 0x00000400u
+static inline gpio_idr_t gpio_idr_id10(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000400u) | ((v << 10) & 0x00000400u); r.m |= 0x00000400u; return r; }
+static inline u32 gpio_idr_id10_get(gpio_idr_t r) { return (r.v & 0x00000400u) >> 10; }
+#define GPIO_IDR_ID11_Pos 11
+#define GPIO_IDR_ID11_Msk 0x00000800u
+static inline gpio_idr_t gpio_idr_id11(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00000800u) | ((v << 11) & 0x00000800u); r.m |= 0x00000800u; return r; }
+static inline u32 gpio_idr_id11_get(gpio_idr_t r) { return (r.v & 0x00000800u) >> 11; }
+#define GPIO_IDR_ID12_Pos 12
+#define GPIO_IDR_ID12_Msk 0x00001000u
+static inline gpio_idr_t gpio_idr_id12(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 gpio_idr_id12_get(gpio_idr_t r) { return (r.v & 0x00001000u) >> 12; }
+#define GPIO_IDR_ID13_Pos 13
+#define GPIO_IDR_ID13_Msk 0x00002000u
+static inline gpio_idr_t gpio_idr_id13(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00002000u) | ((v << 13) & 0x00002000u); r.m |= 0x00002000u; return r; }
+static inline u32 gpio_idr_id13_get(gpio_idr_t r) { return (r.v & 0x00002000u) >> 13; }
+#define GPIO_IDR_ID14_Pos 14
+#define GPIO_IDR_ID14_Msk 0x00004000u
+static inline gpio_idr_t gpio_idr_id14(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00004000u) | ((v << 14) & 0x00004000u); r.m |= 0x00004000u; return r; }
+static inline u32 gpio_idr_id14_get(gpio_idr_t r) { return (r.v & 0x00004000u) >> 14; }
+#define GPIO_IDR_ID15_Pos 15
+#define GPIO_IDR_ID15_Msk 0x00008000u
+static inline gpio_idr_t gpio_idr_id15(gpio_idr_t r, u32 v) { r.v = (r.v & ~0x00008000u) | ((v << 15) & 0x00008000u); r.m |= 0x00008000u; return r; }
+static inline u32 gpio_idr_id15_get(gpio_idr_t r) { return (r.v & 0x00008000u) >> 15; }
+
+/* ODR : port output data register */
+typedef struct { u32 v; u32 m; } gpio_odr_t;
+static inline gpio_odr_t gpio_odr(void) { gpio_odr_t r = { 0, 0 }; return r; }
+static inline gpio_odr_t gpio_odr_rd(u32 base) { gpio_odr_t r = { reg_rd(base + 0x14), 0 }; return r; }
+static inline void gpio_odr_wr(u32 base, gpio_odr_t r) { reg_wr(base + 0x14, r.v); }
+static inline void gpio_odr_modify(u32 base, gpio_odr_t r) { reg_wr(base + 0x14, (reg_rd(base + 0x14) & ~r.m) | r.v); }
+#define GPIO_ODR_OD0_Pos 0
+#define GPIO_ODR_OD0_Msk 0x00000001u
+static inline gpio_odr_t gpio_odr_od0(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 gpio_odr_od0_get(gpio_odr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define GPIO_ODR_OD1_Pos 1
+#define GPIO_ODR_OD1_Msk 0x00000002u
+static inline gpio_odr_t gpio_odr_od1(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 gpio_odr_od1_get(gpio_odr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define GPIO_ODR_OD2_Pos 2
+#define GPIO_ODR_OD2_Msk 0x00000004u
+static inline gpio_odr_t gpio_odr_od2(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 gpio_odr_od2_get(gpio_odr_t r) { return (r.v & 0x00000004u) >> 2; }
+#define GPIO_ODR_OD3_Pos 3
+#define GPIO_ODR_OD3_Msk 0x00000008u
+static inline gpio_odr_t gpio_odr_od3(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 gpio_odr_od3_get(gpio_odr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define GPIO_ODR_OD4_Pos 4
+#define GPIO_ODR_OD4_Msk 0x00000010u
+static inline gpio_odr_t gpio_odr_od4(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 gpio_odr_od4_get(gpio_odr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define GPIO_ODR_OD5_Pos 5
+#define GPIO_ODR_OD5_Msk 0x00000020u
+static inline gpio_odr_t gpio_odr_od5(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 gpio_odr_od5_get(gpio_odr_t r) { return (r.v & 0x00000020u) >> 5; }
+#define GPIO_ODR_OD6_Pos 6
+#define GPIO_ODR_OD6_Msk 0x00000040u
+static inline gpio_odr_t gpio_odr_od6(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 gpio_odr_od6_get(gpio_odr_t r) { return (r.v & 0x00000040u) >> 6; }
+#define GPIO_ODR_OD7_Pos 7
+#define GPIO_ODR_OD7_Msk 0x00000080u
+static inline gpio_odr_t gpio_odr_od7(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 gpio_odr_od7_get(gpio_odr_t r) { return (r.v & 0x00000080u) >> 7; }
+#define GPIO_ODR_OD8_Pos 8
+#define GPIO_ODR_OD8_Msk 0x00000100u
+static inline gpio_odr_t gpio_odr_od8(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 gpio_odr_od8_get(gpio_odr_t r) { return (r.v & 0x00000100u) >> 8; }
+#define GPIO_ODR_OD9_Pos 9
+#define GPIO_ODR_OD9_Msk 0x00000200u
+static inline gpio_odr_t gpio_odr_od9(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000200u) | ((v << 9) & 0x00000200u); r.m |= 0x00000200u; return r; }
+static inline u32 gpio_odr_od9_get(gpio_odr_t r) { return (r.v & 0x00000200u) >> 9; }
+#define GPIO_ODR_OD10_Pos 10
+#define GPIO_ODR_OD10_Msk 0x00000400u
+static inline gpio_odr_t gpio_odr_od10(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000400u) | ((v << 10) & 0x00000400u); r.m |= 0x00000400u; return r; }
+static inline u32 gpio_odr_od10_get(gpio_odr_t r) { return (r.v & 0x00000400u) >> 10; }
+#define GPIO_ODR_OD11_Pos 11
+#define GPIO_ODR_OD11_Msk 0x00000800u
+static inline gpio_odr_t gpio_odr_od11(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00000800u) | ((v << 11) & 0x00000800u); r.m |= 0x00000800u; return r; }
+static inline u32 gpio_odr_od11_get(gpio_odr_t r) { return (r.v & 0x00000800u) >> 11; }
+#define GPIO_ODR_OD12_Pos 12
+#define GPIO_ODR_OD12_Msk 0x00001000u
+static inline gpio_odr_t gpio_odr_od12(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 gpio_odr_od12_get(gpio_odr_t r) { return (r.v & 0x00001000u) >> 12; }
+#define GPIO_ODR_OD13_Pos 13
+#define GPIO_ODR_OD13_Msk 0x00002000u
+static inline gpio_odr_t gpio_odr_od13(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00002000u) | ((v << 13) & 0x00002000u); r.m |= 0x00002000u; return r; }
+static inline u32 gpio_odr_od13_get(gpio_odr_t r) { return (r.v & 0x00002000u) >> 13; }
+#define GPIO_ODR_OD14_Pos 14
+#define GPIO_ODR_OD14_Msk 0x00004000u
+static inline gpio_odr_t gpio_odr_od14(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00004000u) | ((v << 14) & 0x00004000u); r.m |= 0x00004000u; return r; }
+static inline u32 gpio_odr_od14_get(gpio_odr_t r) { return (r.v & 0x00004000u) >> 14; }
+#define GPIO_ODR_OD15_Pos 15
+#define GPIO_ODR_OD15_Msk 0x00008000u
+static inline gpio_odr_t gpio_odr_od15(gpio_odr_t r, u32 v) { r.v = (r.v & ~0x00008000u) | ((v << 15) & 0x00008000u); r.m |= 0x00008000u; return r; }
+static inline u32 gpio_odr_od15_get(gpio_odr_t r) { return (r.v & 0x00008000u) >> 15; }
+
+/* BSRR : port bit set/reset register */
+typedef struct { u32 v; u32 m; } gpio_bsrr_t;
+static inline gpio_bsrr_t gpio_bsrr(void) { gpio_bsrr_t r = { 0, 0 }; return r; }
+static inline gpio_bsrr_t gpio_bsrr_rd(u32 base) { gpio_bsrr_t r = { reg_rd(base + 0x18), 0 }; return r; }
+static inline void gpio_bsrr_wr(u32 base, gpio_bsrr_t r) { reg_wr(base + 0x18, r.v); }
+static inline void gpio_bsrr_modify(u32 base, gpio_bsrr_t r) { reg_wr(base + 0x18, (reg_rd(base + 0x18) & ~r.m) | r.v); }
+#define GPIO_BSRR_BS0_Pos 0
+#define GPIO_BSRR_BS0_Msk 0x00000001u
+static inline gpio_bsrr_t gpio_bsrr_bs0(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 gpio_bsrr_bs0_get(gpio_bsrr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define GPIO_BSRR_BS1_Pos 1
+#define GPIO_BSRR_BS1_Msk 0x00000002u
+static inline gpio_bsrr_t gpio_bsrr_bs1(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 gpio_bsrr_bs1_get(gpio_bsrr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define GPIO_BSRR_BS2_Pos 2
+#define GPIO_BSRR_BS2_Msk 0x00000004u
+static inline gpio_bsrr_t gpio_bsrr_bs2(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 gpio_bsrr_bs2_get(gpio_bsrr_t r) { return (r.v & 0x00000004u) >> 2; }
+#define GPIO_BSRR_BS3_Pos 3
+#define GPIO_BSRR_BS3_Msk 0x00000008u
+static inline gpio_bsrr_t gpio_bsrr_bs3(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 gpio_bsrr_bs3_get(gpio_bsrr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define GPIO_BSRR_BS4_Pos 4
+#define GPIO_BSRR_BS4_Msk 0x00000010u
+static inline gpio_bsrr_t gpio_bsrr_bs4(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 gpio_bsrr_bs4_get(gpio_bsrr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define GPIO_BSRR_BS5_Pos 5
+#define GPIO_BSRR_BS5_Msk 0x00000020u
+static inline gpio_bsrr_t gpio_bsrr_bs5(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 gpio_bsrr_bs5_get(gpio_bsrr_t r) { return (r.v & 0x00000020u) >> 5; }
+#define GPIO_BSRR_BS6_Pos 6
+#define GPIO_BSRR_BS6_Msk 0x00000040u
+static inline gpio_bsrr_t gpio_bsrr_bs6(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 gpio_bsrr_bs6_get(gpio_bsrr_t r) { return (r.v & 0x00000040u) >> 6; }
+#define GPIO_BSRR_BS7_Pos 7
+#define GPIO_BSRR_BS7_Msk 0x00000080u
+static inline gpio_bsrr_t gpio_bsrr_bs7(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 gpio_bsrr_bs7_get(gpio_bsrr_t r) { return (r.v & 0x00000080u) >> 7; }
+#define GPIO_BSRR_BS8_Pos 8
+#define GPIO_BSRR_BS8_Msk 0x00000100u
+static inline gpio_bsrr_t gpio_bsrr_bs8(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 gpio_bsrr_bs8_get(gpio_bsrr_t r) { return (r.v & 0x00000100u) >> 8; }
+#define GPIO_BSRR_BS9_Pos 9
+#define GPIO_BSRR_BS9_Msk 0x00000200u
+static inline gpio_bsrr_t gpio_bsrr_bs9(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000200u) | ((v << 9) & 0x00000200u); r.m |= 0x00000200u; return r; }
+static inline u32 gpio_bsrr_bs9_get(gpio_bsrr_t r) { return (r.v & 0x00000200u) >> 9; }
+#define GPIO_BSRR_BS10_Pos 10
+#define GPIO_BSRR_BS10_Msk 0x00000400u
+static inline gpio_bsrr_t gpio_bsrr_bs10(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000400u) | ((v << 10) & 0x00000400u); r.m |= 0x00000400u; return r; }
+static inline u32 gpio_bsrr_bs10_get(gpio_bsrr_t r) { return (r.v & 0x00000400u) >> 10; }
+#define GPIO_BSRR_BS11_Pos 11
+#define GPIO_BSRR_BS11_Msk 0x00000800u
+static inline gpio_bsrr_t gpio_bsrr_bs11(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00000800u) | ((v << 11) & 0x00000800u); r.m |= 0x00000800u; return r; }
+static inline u32 gpio_bsrr_bs11_get(gpio_bsrr_t r) { return (r.v & 0x00000800u) >> 11; }
+#define GPIO_BSRR_BS12_Pos 12
+#define GPIO_BSRR_BS12_Msk 0x00001000u
+static inline gpio_bsrr_t gpio_bsrr_bs12(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 gpio_bsrr_bs12_get(gpio_bsrr_t r) { return (r.v & 0x00001000u) >> 12; }
+#define GPIO_BSRR_BS13_Pos 13
+#define GPIO_BSRR_BS13_Msk 0x00002000u
+static inline gpio_bsrr_t gpio_bsrr_bs13(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00002000u) | ((v << 13) & 0x00002000u); r.m |= 0x00002000u; return r; }
+static inline u32 gpio_bsrr_bs13_get(gpio_bsrr_t r) { return (r.v & 0x00002000u) >> 13; }
+#define GPIO_BSRR_BS14_Pos 14
+#define GPIO_BSRR_BS14_Msk 0x00004000u
+static inline gpio_bsrr_t gpio_bsrr_bs14(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00004000u) | ((v << 14) & 0x00004000u); r.m |= 0x00004000u; return r; }
+static inline u32 gpio_bsrr_bs14_get(gpio_bsrr_t r) { return (r.v & 0x00004000u) >> 14; }
+#define GPIO_BSRR_BS15_Pos 15
+#define GPIO_BSRR_BS15_Msk 0x00008000u
+static inline gpio_bsrr_t gpio_bsrr_bs15(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00008000u) | ((v << 15) & 0x00008000u); r.m |= 0x00008000u; return r; }
+static inline u32 gpio_bsrr_bs15_get(gpio_bsrr_t r) { return (r.v & 0x00008000u) >> 15; }
+#define GPIO_BSRR_BR0_Pos 16
+#define GPIO_BSRR_BR0_Msk 0x00010000u
+static inline gpio_bsrr_t gpio_bsrr_br0(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00010000u) | ((v << 16) & 0x00010000u); r.m |= 0x00010000u; return r; }
+static inline u32 gpio_bsrr_br0_get(gpio_bsrr_t r) { return (r.v & 0x00010000u) >> 16; }
+#define GPIO_BSRR_BR1_Pos 17
+#define GPIO_BSRR_BR1_Msk 0x00020000u
+static inline gpio_bsrr_t gpio_bsrr_br1(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00020000u) | ((v << 17) & 0x00020000u); r.m |= 0x00020000u; return r; }
+static inline u32 gpio_bsrr_br1_get(gpio_bsrr_t r) { return (r.v & 0x00020000u) >> 17; }
+#define GPIO_BSRR_BR2_Pos 18
+#define GPIO_BSRR_BR2_Msk 0x00040000u
+static inline gpio_bsrr_t gpio_bsrr_br2(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00040000u) | ((v << 18) & 0x00040000u); r.m |= 0x00040000u; return r; }
+static inline u32 gpio_bsrr_br2_get(gpio_bsrr_t r) { return (r.v & 0x00040000u) >> 18; }
+#define GPIO_BSRR_BR3_Pos 19
+#define GPIO_BSRR_BR3_Msk 0x00080000u
+static inline gpio_bsrr_t gpio_bsrr_br3(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00080000u) | ((v << 19) & 0x00080000u); r.m |= 0x00080000u; return r; }
+static inline u32 gpio_bsrr_br3_get(gpio_bsrr_t r) { return (r.v & 0x00080000u) >> 19; }
+#define GPIO_BSRR_BR4_Pos 20
+#define GPIO_BSRR_BR4_Msk 0x00100000u
+static inline gpio_bsrr_t gpio_bsrr_br4(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00100000u) | ((v << 20) & 0x00100000u); r.m |= 0x00100000u; return r; }
+static inline u32 gpio_bsrr_br4_get(gpio_bsrr_t r) { return (r.v & 0x00100000u) >> 20; }
+#define GPIO_BSRR_BR5_Pos 21
+#define GPIO_BSRR_BR5_Msk 0x00200000u
+static inline gpio_bsrr_t gpio_bsrr_br5(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00200000u) | ((v << 21) & 0x00200000u); r.m |= 0x00200000u; return r; }
+static inline u32 gpio_bsrr_br5_get(gpio_bsrr_t r) { return (r.v & 0x00200000u) >> 21; }
+#define GPIO_BSRR_BR6_Pos 22
+#define GPIO_BSRR_BR6_Msk 0x00400000u
+static inline gpio_bsrr_t gpio_bsrr_br6(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00400000u) | ((v << 22) & 0x00400000u); r.m |= 0x00400000u; return r; }
+static inline u32 gpio_bsrr_br6_get(gpio_bsrr_t r) { return (r.v & 0x00400000u) >> 22; }
+#define GPIO_BSRR_BR7_Pos 23
+#define GPIO_BSRR_BR7_Msk 0x00800000u
+static inline gpio_bsrr_t gpio_bsrr_br7(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x00800000u) | ((v << 23) & 0x00800000u); r.m |= 0x00800000u; return r; }
+static inline u32 gpio_bsrr_br7_get(gpio_bsrr_t r) { return (r.v & 0x00800000u) >> 23; }
+#define GPIO_BSRR_BR8_Pos 24
+#define GPIO_BSRR_BR8_Msk 0x01000000u
+static inline gpio_bsrr_t gpio_bsrr_br8(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x01000000u) | ((v << 24) & 0x01000000u); r.m |= 0x01000000u; return r; }
+static inline u32 gpio_bsrr_br8_get(gpio_bsrr_t r) { return (r.v & 0x01000000u) >> 24; }
+#define GPIO_BSRR_BR9_Pos 25
+#define GPIO_BSRR_BR9_Msk 0x02000000u
+static inline gpio_bsrr_t gpio_bsrr_br9(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x02000000u) | ((v << 25) & 0x02000000u); r.m |= 0x02000000u; return r; }
+static inline u32 gpio_bsrr_br9_get(gpio_bsrr_t r) { return (r.v & 0x02000000u) >> 25; }
+#define GPIO_BSRR_BR10_Pos 26
+#define GPIO_BSRR_BR10_Msk 0x04000000u
+static inline gpio_bsrr_t gpio_bsrr_br10(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x04000000u) | ((v << 26) & 0x04000000u); r.m |= 0x04000000u; return r; }
+static inline u32 gpio_bsrr_br10_get(gpio_bsrr_t r) { return (r.v & 0x04000000u) >> 26; }
+#define GPIO_BSRR_BR11_Pos 27
+#define GPIO_BSRR_BR11_Msk 0x08000000u
+static inline gpio_bsrr_t gpio_bsrr_br11(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x08000000u) | ((v << 27) & 0x08000000u); r.m |= 0x08000000u; return r; }
+static inline u32 gpio_bsrr_br11_get(gpio_bsrr_t r) { return (r.v & 0x08000000u) >> 27; }
+#define GPIO_BSRR_BR12_Pos 28
+#define GPIO_BSRR_BR12_Msk 0x10000000u
+static inline gpio_bsrr_t gpio_bsrr_br12(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x10000000u) | ((v << 28) & 0x10000000u); r.m |= 0x10000000u; return r; }
+static inline u32 gpio_bsrr_br12_get(gpio_bsrr_t r) { return (r.v & 0x10000000u) >> 28; }
+#define GPIO_BSRR_BR13_Pos 29
+#define GPIO_BSRR_BR13_Msk 0x20000000u
+static inline gpio_bsrr_t gpio_bsrr_br13(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x20000000u) | ((v << 29) & 0x20000000u); r.m |= 0x20000000u; return r; }
+static inline u32 gpio_bsrr_br13_get(gpio_bsrr_t r) { return (r.v & 0x20000000u) >> 29; }
+#define GPIO_BSRR_BR14_Pos 30
+#define GPIO_BSRR_BR14_Msk 0x40000000u
+static inline gpio_bsrr_t gpio_bsrr_br14(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x40000000u) | ((v << 30) & 0x40000000u); r.m |= 0x40000000u; return r; }
+static inline u32 gpio_bsrr_br14_get(gpio_bsrr_t r) { return (r.v & 0x40000000u) >> 30; }
+#define GPIO_BSRR_BR15_Pos 31
+#define GPIO_BSRR_BR15_Msk 0x80000000u
+static inline gpio_bsrr_t gpio_bsrr_br15(gpio_bsrr_t r, u32 v) { r.v = (r.v & ~0x80000000u) | ((v << 31) & 0x80000000u); r.m |= 0x80000000u; return r; }
+static inline u32 gpio_bsrr_br15_get(gpio_bsrr_t r) { return (r.v & 0x80000000u) >> 31; }
+
+/* AFRL : alternate function low register */
+typedef struct { u32 v; u32 m; } gpio_afrl_t;
+static inline gpio_afrl_t gpio_afrl(void) { gpio_afrl_t r = { 0, 0 }; return r; }
+static inline gpio_afrl_t gpio_afrl_rd(u32 base) { gpio_afrl_t r = { reg_rd(base + 0x20), 0 }; return r; }
+static inline void gpio_afrl_wr(u32 base, gpio_afrl_t r) { reg_wr(base + 0x20, r.v); }
+static inline void gpio_afrl_modify(u32 base, gpio_afrl_t r) { reg_wr(base + 0x20, (reg_rd(base + 0x20) & ~r.m) | r.v); }
+#define GPIO_AFRL_AFSEL0_Pos 0
+#define GPIO_AFRL_AFSEL0_Msk 0x0000000Fu
+static inline gpio_afrl_t gpio_afrl_afsel0(gpio_afrl_t r, u32 v) { r.v = (r.v & ~0x0000000Fu) | ((v << 0) & 0x0000000Fu); r.m |= 0x0000000Fu; return r; }
+static inline u32 gpio_afrl_afsel0_get(gpio_afrl_t r) { return (r.v & 0x0000000Fu) >> 0; }
+#define GPIO_AFRL_AFSEL1_Pos 4
+#define GPIO_AFRL_AFSEL1_Msk 0x000000F0u
+static inline gpio_afrl_t gpio_afrl_afsel1(gpio_afrl_t r, u32 v) { r.v = (r.v & ~0x000000F0u) | ((v << 4) & 0x000000F0u); r.m |= 0x000000F0u; return r; }
+static inline u32 gpio_afrl_afsel1_get(gpio_afrl_t r) { return (r.v & 0x000000F0u) >> 4; }
+#define GPIO_AFRL_AFSEL2_Pos 8
+#define GPIO_AFRL_AFSEL2_Msk 0x00000F00u
+static inline gpio_afrl_t gpio_afrl_afsel2(gpio_afrl_t r, u32 v) { r.v = (r.v & ~0x00000F00u) | ((v << 8) & 0x00000F00u); r.m |= 0x00000F00u; return r; }
+static inline u32 gpio_afrl_afsel2_get(gpio_afrl_t r) { return (r.v & 0x00000F00u) >> 8; }
+#define GPIO_AFRL_AFSEL3_Pos 12
+#define GPIO_AFRL_AFSEL3_Msk 0x0000F000u
+static inline gpio_afrl_t gpio_afrl_afsel3(gpio_afrl_t r, u32 v) { r.v = (r.v & ~0x0000F000u) | ((v << 12) & 0x0000F000u); r.m |= 0x0000F000u; return r; }
+static inline u32 gpio_afrl_afsel3_get(gpio_afrl_t r) { return (r.v & 0x0000F000u) >> 12; }
+#define GPIO_AFRL_AFSEL4_Pos 16
+#define GPIO_AFRL_AFSEL4_Msk 0x000F0000u
+static inline gpio_afrl_t gpio_afrl_afsel4(gpio_afrl_t r, u32 v) { r.v = (r.v & ~0x000F0000u) | ((v << 16) & 0x000F0000u); r.m |= 0x000F0000u; return r; }
+static inline u32 gpio_afrl_afsel4_get(gpio_afrl_t r) { return (r.v & 0x000F0000u) >> 16; }
+#define GPIO_AFRL_AFSEL5_Pos 20
+#define GPIO_AFRL_AFSEL5_Msk 0x00F00000u
+static inline gpio_afrl_t gpio_afrl_afsel5(gpio_afrl_t r, u32 v) { r.v = (r.v & ~0x00F00000u) | ((v << 20) & 0x00F00000u); r.m |= 0x00F00000u; return r; }
+static inline u32 gpio_afrl_afsel5_get(gpio_afrl_t r) { return (r.v & 0x00F00000u) >> 20; }
+#define GPIO_AFRL_AFSEL6_Pos 24
+#define GPIO_AFRL_AFSEL6_Msk 0x0F000000u
+static inline gpio_afrl_t gpio_afrl_afsel6(gpio_afrl_t r, u32 v) { r.v = (r.v & ~0x0F000000u) | ((v << 24) & 0x0F000000u); r.m |= 0x0F000000u; return r; }
+static inline u32 gpio_afrl_afsel6_get(gpio_afrl_t r) { return (r.v & 0x0F000000u) >> 24; }
+#define GPIO_AFRL_AFSEL7_Pos 28
+#define GPIO_AFRL_AFSEL7_Msk 0xF0000000u
+static inline gpio_afrl_t gpio_afrl_afsel7(gpio_afrl_t r, u32 v) { r.v = (r.v & ~0xF0000000u) | ((v << 28) & 0xF0000000u); r.m |= 0xF0000000u; return r; }
+static inline u32 gpio_afrl_afsel7_get(gpio_afrl_t r) { return (r.v & 0xF0000000u) >> 28; }
+
+/* AFRH : alternate function high register */
+typedef struct { u32 v; u32 m; } gpio_afrh_t;
+static inline gpio_afrh_t gpio_afrh(void) { gpio_afrh_t r = { 0, 0 }; return r; }
+static inline gpio_afrh_t gpio_afrh_rd(u32 base) { gpio_afrh_t r = { reg_rd(base + 0x24), 0 }; return r; }
+static inline void gpio_afrh_wr(u32 base, gpio_afrh_t r) { reg_wr(base + 0x24, r.v); }
+static inline void gpio_afrh_modify(u32 base, gpio_afrh_t r) { reg_wr(base + 0x24, (reg_rd(base + 0x24) & ~r.m) | r.v); }
+#define GPIO_AFRH_AFSEL8_Pos 0
+#define GPIO_AFRH_AFSEL8_Msk 0x0000000Fu
+static inline gpio_afrh_t gpio_afrh_afsel8(gpio_afrh_t r, u32 v) { r.v = (r.v & ~0x0000000Fu) | ((v << 0) & 0x0000000Fu); r.m |= 0x0000000Fu; return r; }
+static inline u32 gpio_afrh_afsel8_get(gpio_afrh_t r) { return (r.v & 0x0000000Fu) >> 0; }
+#define GPIO_AFRH_AFSEL9_Pos 4
+#define GPIO_AFRH_AFSEL9_Msk 0x000000F0u
+static inline gpio_afrh_t gpio_afrh_afsel9(gpio_afrh_t r, u32 v) { r.v = (r.v & ~0x000000F0u) | ((v << 4) & 0x000000F0u); r.m |= 0x000000F0u; return r; }
+static inline u32 gpio_afrh_afsel9_get(gpio_afrh_t r) { return (r.v & 0x000000F0u) >> 4; }
+#define GPIO_AFRH_AFSEL10_Pos 8
+#define GPIO_AFRH_AFSEL10_Msk 0x00000F00u
+static inline gpio_afrh_t gpio_afrh_afsel10(gpio_afrh_t r, u32 v) { r.v = (r.v & ~0x00000F00u) | ((v << 8) & 0x00000F00u); r.m |= 0x00000F00u; return r; }
+static inline u32 gpio_afrh_afsel10_get(gpio_afrh_t r) { return (r.v & 0x00000F00u) >> 8; }
+#define GPIO_AFRH_AFSEL11_Pos 12
+#define GPIO_AFRH_AFSEL11_Msk 0x0000F000u
+static inline gpio_afrh_t gpio_afrh_afsel11(gpio_afrh_t r, u32 v) { r.v = (r.v & ~0x0000F000u) | ((v << 12) & 0x0000F000u); r.m |= 0x0000F000u; return r; }
+static inline u32 gpio_afrh_afsel11_get(gpio_afrh_t r) { return (r.v & 0x0000F000u) >> 12; }
+#define GPIO_AFRH_AFSEL12_Pos 16
+#define GPIO_AFRH_AFSEL12_Msk 0x000F0000u
+static inline gpio_afrh_t gpio_afrh_afsel12(gpio_afrh_t r, u32 v) { r.v = (r.v & ~0x000F0000u) | ((v << 16) & 0x000F0000u); r.m |= 0x000F0000u; return r; }
+static inline u32 gpio_afrh_afsel12_get(gpio_afrh_t r) { return (r.v & 0x000F0000u) >> 16; }
+#define GPIO_AFRH_AFSEL13_Pos 20
+#define GPIO_AFRH_AFSEL13_Msk 0x00F00000u
+static inline gpio_afrh_t gpio_afrh_afsel13(gpio_afrh_t r, u32 v) { r.v = (r.v & ~0x00F00000u) | ((v << 20) & 0x00F00000u); r.m |= 0x00F00000u; return r; }
+static inline u32 gpio_afrh_afsel13_get(gpio_afrh_t r) { return (r.v & 0x00F00000u) >> 20; }
+#define GPIO_AFRH_AFSEL14_Pos 24
+#define GPIO_AFRH_AFSEL14_Msk 0x0F000000u
+static inline gpio_afrh_t gpio_afrh_afsel14(gpio_afrh_t r, u32 v) { r.v = (r.v & ~0x0F000000u) | ((v << 24) & 0x0F000000u); r.m |= 0x0F000000u; return r; }
+static inline u32 gpio_afrh_afsel14_get(gpio_afrh_t r) { return (r.v & 0x0F000000u) >> 24; }
+#define GPIO_AFRH_AFSEL15_Pos 28
+#define GPIO_AFRH_AFSEL15_Msk 0xF0000000u
+static inline gpio_afrh_t gpio_afrh_afsel15(gpio_afrh_t r, u32 v) { r.v = (r.v & ~0xF0000000u) | ((v << 28) & 0xF0000000u); r.m |= 0xF0000000u; return r; }
+static inline u32 gpio_afrh_afsel15_get(gpio_afrh_t r) { return (r.v & 0xF0000000u) >> 28; }
+
+/* BRR : port bit reset register */
+typedef struct { u32 v; u32 m; } gpio_brr_t;
+static inline gpio_brr_t gpio_brr(void) { gpio_brr_t r = { 0, 0 }; return r; }
+static inline gpio_brr_t gpio_brr_rd(u32 base) { gpio_brr_t r = { reg_rd(base + 0x28), 0 }; return r; }
+static inline void gpio_brr_wr(u32 base, gpio_brr_t r) { reg_wr(base + 0x28, r.v); }
+static inline void gpio_brr_modify(u32 base, gpio_brr_t r) { reg_wr(base + 0x28, (reg_rd(base + 0x28) & ~r.m) | r.v); }
+#define GPIO_BRR_BR0_Pos 0
+#define GPIO_BRR_BR0_Msk 0x00000001u
+static inline gpio_brr_t gpio_brr_br0(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 gpio_brr_br0_get(gpio_brr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define GPIO_BRR_BR1_Pos 1
+#define GPIO_BRR_BR1_Msk 0x00000002u
+static inline gpio_brr_t gpio_brr_br1(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 gpio_brr_br1_get(gpio_brr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define GPIO_BRR_BR2_Pos 2
+#define GPIO_BRR_BR2_Msk 0x00000004u
+static inline gpio_brr_t gpio_brr_br2(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 gpio_brr_br2_get(gpio_brr_t r) { return (r.v & 0x00000004u) >> 2; }
+#define GPIO_BRR_BR3_Pos 3
+#define GPIO_BRR_BR3_Msk 0x00000008u
+static inline gpio_brr_t gpio_brr_br3(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 gpio_brr_br3_get(gpio_brr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define GPIO_BRR_BR4_Pos 4
+#define GPIO_BRR_BR4_Msk 0x00000010u
+static inline gpio_brr_t gpio_brr_br4(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 gpio_brr_br4_get(gpio_brr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define GPIO_BRR_BR5_Pos 5
+#define GPIO_BRR_BR5_Msk 0x00000020u
+static inline gpio_brr_t gpio_brr_br5(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 gpio_brr_br5_get(gpio_brr_t r) { return (r.v & 0x00000020u) >> 5; }
+#define GPIO_BRR_BR6_Pos 6
+#define GPIO_BRR_BR6_Msk 0x00000040u
+static inline gpio_brr_t gpio_brr_br6(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 gpio_brr_br6_get(gpio_brr_t r) { return (r.v & 0x00000040u) >> 6; }
+#define GPIO_BRR_BR7_Pos 7
+#define GPIO_BRR_BR7_Msk 0x00000080u
+static inline gpio_brr_t gpio_brr_br7(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 gpio_brr_br7_get(gpio_brr_t r) { return (r.v & 0x00000080u) >> 7; }
+#define GPIO_BRR_BR8_Pos 8
+#define GPIO_BRR_BR8_Msk 0x00000100u
+static inline gpio_brr_t gpio_brr_br8(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 gpio_brr_br8_get(gpio_brr_t r) { return (r.v & 0x00000100u) >> 8; }
+#define GPIO_BRR_BR9_Pos 9
+#define GPIO_BRR_BR9_Msk 0x00000200u
+static inline gpio_brr_t gpio_brr_br9(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000200u) | ((v << 9) & 0x00000200u); r.m |= 0x00000200u; return r; }
+static inline u32 gpio_brr_br9_get(gpio_brr_t r) { return (r.v & 0x00000200u) >> 9; }
+#define GPIO_BRR_BR10_Pos 10
+#define GPIO_BRR_BR10_Msk 0x00000400u
+static inline gpio_brr_t gpio_brr_br10(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000400u) | ((v << 10) & 0x00000400u); r.m |= 0x00000400u; return r; }
+static inline u32 gpio_brr_br10_get(gpio_brr_t r) { return (r.v & 0x00000400u) >> 10; }
+#define GPIO_BRR_BR11_Pos 11
+#define GPIO_BRR_BR11_Msk 0x00000800u
+static inline gpio_brr_t gpio_brr_br11(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00000800u) | ((v << 11) & 0x00000800u); r.m |= 0x00000800u; return r; }
+static inline u32 gpio_brr_br11_get(gpio_brr_t r) { return (r.v & 0x00000800u) >> 11; }
+#define GPIO_BRR_BR12_Pos 12
+#define GPIO_BRR_BR12_Msk 0x00001000u
+static inline gpio_brr_t gpio_brr_br12(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 gpio_brr_br12_get(gpio_brr_t r) { return (r.v & 0x00001000u) >> 12; }
+#define GPIO_BRR_BR13_Pos 13
+#define GPIO_BRR_BR13_Msk 0x00002000u
+static inline gpio_brr_t gpio_brr_br13(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00002000u) | ((v << 13) & 0x00002000u); r.m |= 0x00002000u; return r; }
+static inline u32 gpio_brr_br13_get(gpio_brr_t r) { return (r.v & 0x00002000u) >> 13; }
+#define GPIO_BRR_BR14_Pos 14
+#define GPIO_BRR_BR14_Msk 0x00004000u
+static inline gpio_brr_t gpio_brr_br14(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00004000u) | ((v << 14) & 0x00004000u); r.m |= 0x00004000u; return r; }
+static inline u32 gpio_brr_br14_get(gpio_brr_t r) { return (r.v & 0x00004000u) >> 14; }
+#define GPIO_BRR_BR15_Pos 15
+#define GPIO_BRR_BR15_Msk 0x00008000u
+static inline gpio_brr_t gpio_brr_br15(gpio_brr_t r, u32 v) { r.v = (r.v & ~0x00008000u) | ((v << 15) & 0x00008000u); r.m |= 0x00008000u; return r; }
+static inline u32 gpio_brr_br15_get(gpio_brr_t r) { return (r.v & 0x00008000u) >> 15; }
+
+/* -------------------------------------------------------------------------- */
+/* RCC : Reset and clock control                                              */
+/* -------------------------------------------------------------------------- */
+
+/* AHB2RSTR : AHB2 peripheral reset register */
+typedef struct { u32 v; u32 m; } rcc_ahb2rstr_t;
+static inline rcc_ahb2rstr_t rcc_ahb2rstr(void) { rcc_ahb2rstr_t r = { 0, 0 }; return r; }
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_rd(u32 base) { rcc_ahb2rstr_t r = { reg_rd(base + 0x64), 0 }; return r; }
+static inline void rcc_ahb2rstr_wr(u32 base, rcc_ahb2rstr_t r) { reg_wr(base + 0x64, r.v); }
+static inline void rcc_ahb2rstr_modify(u32 base, rcc_ahb2rstr_t r) { reg_wr(base + 0x64, (reg_rd(base + 0x64) & ~r.m) | r.v); }
+#define RCC_AHB2RSTR_GPIOARST_Pos 0
+#define RCC_AHB2RSTR_GPIOARST_Msk 0x00000001u
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_gpioarst(rcc_ahb2rstr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 rcc_ahb2rstr_gpioarst_get(rcc_ahb2rstr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define RCC_AHB2RSTR_GPIOBRST_Pos 1
+#define RCC_AHB2RSTR_GPIOBRST_Msk 0x00000002u
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_gpiobrst(rcc_ahb2rstr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 rcc_ahb2rstr_gpiobrst_get(rcc_ahb2rstr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define RCC_AHB2RSTR_GPIOCRST_Pos 2
+#define RCC_AHB2RSTR_GPIOCRST_Msk 0x00000004u
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_gpiocrst(rcc_ahb2rstr_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 rcc_ahb2rstr_gpiocrst_get(rcc_ahb2rstr_t r) { return (r.v & 0x00000004u) >> 2; }
+#define RCC_AHB2RSTR_GPIODRST_Pos 3
+#define RCC_AHB2RSTR_GPIODRST_Msk 0x00000008u
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_gpiodrst(rcc_ahb2rstr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 rcc_ahb2rstr_gpiodrst_get(rcc_ahb2rstr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define RCC_AHB2RSTR_GPIOERST_Pos 4
+#define RCC_AHB2RSTR_GPIOERST_Msk 0x00000010u
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_gpioerst(rcc_ahb2rstr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 rcc_ahb2rstr_gpioerst_get(rcc_ahb2rstr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define RCC_AHB2RSTR_GPIOFRST_Pos 5
+#define RCC_AHB2RSTR_GPIOFRST_Msk 0x00000020u
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_gpiofrst(rcc_ahb2rstr_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 rcc_ahb2rstr_gpiofrst_get(rcc_ahb2rstr_t r) { return (r.v & 0x00000020u) >> 5; }
+#define RCC_AHB2RSTR_GPIOGRST_Pos 6
+#define RCC_AHB2RSTR_GPIOGRST_Msk 0x00000040u
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_gpiogrst(rcc_ahb2rstr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 rcc_ahb2rstr_gpiogrst_get(rcc_ahb2rstr_t r) { return (r.v & 0x00000040u) >> 6; }
+#define RCC_AHB2RSTR_GPIOHRST_Pos 7
+#define RCC_AHB2RSTR_GPIOHRST_Msk 0x00000080u
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_gpiohrst(rcc_ahb2rstr_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 rcc_ahb2rstr_gpiohrst_get(rcc_ahb2rstr_t r) { return (r.v & 0x00000080u) >> 7; }
+#define RCC_AHB2RSTR_GPIOIRST_Pos 8
+#define RCC_AHB2RSTR_GPIOIRST_Msk 0x00000100u
+static inline rcc_ahb2rstr_t rcc_ahb2rstr_gpioirst(rcc_ahb2rstr_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 rcc_ahb2rstr_gpioirst_get(rcc_ahb2rstr_t r) { return (r.v & 0x00000100u) >> 8; }
+
+/* AHB1ENR : AHB1 peripheral clock register */
+typedef struct { u32 v; u32 m; } rcc_ahb1enr_t;
+static inline rcc_ahb1enr_t rcc_ahb1enr(void) { rcc_ahb1enr_t r = { 0, 0 }; return r; }
+static inline rcc_ahb1enr_t rcc_ahb1enr_rd(u32 base) { rcc_ahb1enr_t r = { reg_rd(base + 0x88), 0 }; return r; }
+static inline void rcc_ahb1enr_wr(u32 base, rcc_ahb1enr_t r) { reg_wr(base + 0x88, r.v); }
+static inline void rcc_ahb1enr_modify(u32 base, rcc_ahb1enr_t r) { reg_wr(base + 0x88, (reg_rd(base + 0x88) & ~r.m) | r.v); }
+#define RCC_AHB1ENR_GPDMA1EN_Pos 0
+#define RCC_AHB1ENR_GPDMA1EN_Msk 0x00000001u
+static inline rcc_ahb1enr_t rcc_ahb1enr_gpdma1en(rcc_ahb1enr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 rcc_ahb1enr_gpdma1en_get(rcc_ahb1enr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define RCC_AHB1ENR_GPDMA2EN_Pos 1
+#define RCC_AHB1ENR_GPDMA2EN_Msk 0x00000002u
+static inline rcc_ahb1enr_t rcc_ahb1enr_gpdma2en(rcc_ahb1enr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 rcc_ahb1enr_gpdma2en_get(rcc_ahb1enr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define RCC_AHB1ENR_FLITFEN_Pos 8
+#define RCC_AHB1ENR_FLITFEN_Msk 0x00000100u
+static inline rcc_ahb1enr_t rcc_ahb1enr_flitfen(rcc_ahb1enr_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 rcc_ahb1enr_flitfen_get(rcc_ahb1enr_t r) { return (r.v & 0x00000100u) >> 8; }
+#define RCC_AHB1ENR_CRCEN_Pos 12
+#define RCC_AHB1ENR_CRCEN_Msk 0x00001000u
+static inline rcc_ahb1enr_t rcc_ahb1enr_crcen(rcc_ahb1enr_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 rcc_ahb1enr_crcen_get(rcc_ahb1enr_t r) { return (r.v & 0x00001000u) >> 12; }
+#define RCC_AHB1ENR_RAMCFGEN_Pos 17
+#define RCC_AHB1ENR_RAMCFGEN_Msk 0x00020000u
+static inline rcc_ahb1enr_t rcc_ahb1enr_ramcfgen(rcc_ahb1enr_t r, u32 v) { r.v = (r.v & ~0x00020000u) | ((v << 17) & 0x00020000u); r.m |= 0x00020000u; return r; }
+static inline u32 rcc_ahb1enr_ramcfgen_get(rcc_ahb1enr_t r) { return (r.v & 0x00020000u) >> 17; }
+#define RCC_AHB1ENR_TZSC1EN_Pos 24
+#define RCC_AHB1ENR_TZSC1EN_Msk 0x01000000u
+static inline rcc_ahb1enr_t rcc_ahb1enr_tzsc1en(rcc_ahb1enr_t r, u32 v) { r.v = (r.v & ~0x01000000u) | ((v << 24) & 0x01000000u); r.m |= 0x01000000u; return r; }
+static inline u32 rcc_ahb1enr_tzsc1en_get(rcc_ahb1enr_t r) { return (r.v & 0x01000000u) >> 24; }
+
+/* AHB2ENR : AHB2 peripheral clock register */
+typedef struct { u32 v; u32 m; } rcc_ahb2enr_t;
+static inline rcc_ahb2enr_t rcc_ahb2enr(void) { rcc_ahb2enr_t r = { 0, 0 }; return r; }
+static inline rcc_ahb2enr_t rcc_ahb2enr_rd(u32 base) { rcc_ahb2enr_t r = { reg_rd(base + 0x8C), 0 }; return r; }
+static inline void rcc_ahb2enr_wr(u32 base, rcc_ahb2enr_t r) { reg_wr(base + 0x8C, r.v); }
+static inline void rcc_ahb2enr_modify(u32 base, rcc_ahb2enr_t r) { reg_wr(base + 0x8C, (reg_rd(base + 0x8C) & ~r.m) | r.v); }
+#define RCC_AHB2ENR_GPIOAEN_Pos 0
+#define RCC_AHB2ENR_GPIOAEN_Msk 0x00000001u
+static inline rcc_ahb2enr_t rcc_ahb2enr_gpioaen(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 rcc_ahb2enr_gpioaen_get(rcc_ahb2enr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define RCC_AHB2ENR_GPIOBEN_Pos 1
+#define RCC_AHB2ENR_GPIOBEN_Msk 0x00000002u
+static inline rcc_ahb2enr_t rcc_ahb2enr_gpioben(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 rcc_ahb2enr_gpioben_get(rcc_ahb2enr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define RCC_AHB2ENR_GPIOCEN_Pos 2
+#define RCC_AHB2ENR_GPIOCEN_Msk 0x00000004u
+static inline rcc_ahb2enr_t rcc_ahb2enr_gpiocen(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 rcc_ahb2enr_gpiocen_get(rcc_ahb2enr_t r) { return (r.v & 0x00000004u) >> 2; }
+#define RCC_AHB2ENR_GPIODEN_Pos 3
+#define RCC_AHB2ENR_GPIODEN_Msk 0x00000008u
+static inline rcc_ahb2enr_t rcc_ahb2enr_gpioden(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 rcc_ahb2enr_gpioden_get(rcc_ahb2enr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define RCC_AHB2ENR_GPIOEEN_Pos 4
+#define RCC_AHB2ENR_GPIOEEN_Msk 0x00000010u
+static inline rcc_ahb2enr_t rcc_ahb2enr_gpioeen(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 rcc_ahb2enr_gpioeen_get(rcc_ahb2enr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define RCC_AHB2ENR_GPIOFEN_Pos 5
+#define RCC_AHB2ENR_GPIOFEN_Msk 0x00000020u
+static inline rcc_ahb2enr_t rcc_ahb2enr_gpiofen(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 rcc_ahb2enr_gpiofen_get(rcc_ahb2enr_t r) { return (r.v & 0x00000020u) >> 5; }
+#define RCC_AHB2ENR_GPIOGEN_Pos 6
+#define RCC_AHB2ENR_GPIOGEN_Msk 0x00000040u
+static inline rcc_ahb2enr_t rcc_ahb2enr_gpiogen(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 rcc_ahb2enr_gpiogen_get(rcc_ahb2enr_t r) { return (r.v & 0x00000040u) >> 6; }
+#define RCC_AHB2ENR_GPIOHEN_Pos 7
+#define RCC_AHB2ENR_GPIOHEN_Msk 0x00000080u
+static inline rcc_ahb2enr_t rcc_ahb2enr_gpiohen(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 rcc_ahb2enr_gpiohen_get(rcc_ahb2enr_t r) { return (r.v & 0x00000080u) >> 7; }
+#define RCC_AHB2ENR_GPIOIEN_Pos 8
+#define RCC_AHB2ENR_GPIOIEN_Msk 0x00000100u
+static inline rcc_ahb2enr_t rcc_ahb2enr_gpioien(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 rcc_ahb2enr_gpioien_get(rcc_ahb2enr_t r) { return (r.v & 0x00000100u) >> 8; }
+#define RCC_AHB2ENR_HASHEN_Pos 17
+#define RCC_AHB2ENR_HASHEN_Msk 0x00020000u
+static inline rcc_ahb2enr_t rcc_ahb2enr_hashen(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00020000u) | ((v << 17) & 0x00020000u); r.m |= 0x00020000u; return r; }
+static inline u32 rcc_ahb2enr_hashen_get(rcc_ahb2enr_t r) { return (r.v & 0x00020000u) >> 17; }
+#define RCC_AHB2ENR_RNGEN_Pos 18
+#define RCC_AHB2ENR_RNGEN_Msk 0x00040000u
+static inline rcc_ahb2enr_t rcc_ahb2enr_rngen(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x00040000u) | ((v << 18) & 0x00040000u); r.m |= 0x00040000u; return r; }
+static inline u32 rcc_ahb2enr_rngen_get(rcc_ahb2enr_t r) { return (r.v & 0x00040000u) >> 18; }
+#define RCC_AHB2ENR_SRAM2EN_Pos 30
+#define RCC_AHB2ENR_SRAM2EN_Msk 0x40000000u
+static inline rcc_ahb2enr_t rcc_ahb2enr_sram2en(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x40000000u) | ((v << 30) & 0x40000000u); r.m |= 0x40000000u; return r; }
+static inline u32 rcc_ahb2enr_sram2en_get(rcc_ahb2enr_t r) { return (r.v & 0x40000000u) >> 30; }
+#define RCC_AHB2ENR_SRAM1EN_Pos 31
+#define RCC_AHB2ENR_SRAM1EN_Msk 0x80000000u
+static inline rcc_ahb2enr_t rcc_ahb2enr_sram1en(rcc_ahb2enr_t r, u32 v) { r.v = (r.v & ~0x80000000u) | ((v << 31) & 0x80000000u); r.m |= 0x80000000u; return r; }
+static inline u32 rcc_ahb2enr_sram1en_get(rcc_ahb2enr_t r) { return (r.v & 0x80000000u) >> 31; }
+
+/* APB1LENR : APB1 peripheral low clock register */
+typedef struct { u32 v; u32 m; } rcc_apb1lenr_t;
+static inline rcc_apb1lenr_t rcc_apb1lenr(void) { rcc_apb1lenr_t r = { 0, 0 }; return r; }
+static inline rcc_apb1lenr_t rcc_apb1lenr_rd(u32 base) { rcc_apb1lenr_t r = { reg_rd(base + 0x9C), 0 }; return r; }
+static inline void rcc_apb1lenr_wr(u32 base, rcc_apb1lenr_t r) { reg_wr(base + 0x9C, r.v); }
+static inline void rcc_apb1lenr_modify(u32 base, rcc_apb1lenr_t r) { reg_wr(base + 0x9C, (reg_rd(base + 0x9C) & ~r.m) | r.v); }
+#define RCC_APB1LENR_TIM2EN_Pos 0
+#define RCC_APB1LENR_TIM2EN_Msk 0x00000001u
+static inline rcc_apb1lenr_t rcc_apb1lenr_tim2en(rcc_apb1lenr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 rcc_apb1lenr_tim2en_get(rcc_apb1lenr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define RCC_APB1LENR_USART2EN_Pos 17
+#define RCC_APB1LENR_USART2EN_Msk 0x00020000u
+static inline rcc_apb1lenr_t rcc_apb1lenr_usart2en(rcc_apb1lenr_t r, u32 v) { r.v = (r.v & ~0x00020000u) | ((v << 17) & 0x00020000u); r.m |= 0x00020000u; return r; }
+static inline u32 rcc_apb1lenr_usart2en_get(rcc_apb1lenr_t r) { return (r.v & 0x00020000u) >> 17; }
+#define RCC_APB1LENR_USART3EN_Pos 18
+#define RCC_APB1LENR_USART3EN_Msk 0x00040000u
+static inline rcc_apb1lenr_t rcc_apb1lenr_usart3en(rcc_apb1lenr_t r, u32 v) { r.v = (r.v & ~0x00040000u) | ((v << 18) & 0x00040000u); r.m |= 0x00040000u; return r; }
+static inline u32 rcc_apb1lenr_usart3en_get(rcc_apb1lenr_t r) { return (r.v & 0x00040000u) >> 18; }
+
+/* APB2ENR : APB2 peripheral clock register */
+typedef struct { u32 v; u32 m; } rcc_apb2enr_t;
+static inline rcc_apb2enr_t rcc_apb2enr(void) { rcc_apb2enr_t r = { 0, 0 }; return r; }
+static inline rcc_apb2enr_t rcc_apb2enr_rd(u32 base) { rcc_apb2enr_t r = { reg_rd(base + 0xA4), 0 }; return r; }
+static inline void rcc_apb2enr_wr(u32 base, rcc_apb2enr_t r) { reg_wr(base + 0xA4, r.v); }
+static inline void rcc_apb2enr_modify(u32 base, rcc_apb2enr_t r) { reg_wr(base + 0xA4, (reg_rd(base + 0xA4) & ~r.m) | r.v); }
+#define RCC_APB2ENR_SPI1EN_Pos 12
+#define RCC_APB2ENR_SPI1EN_Msk 0x00001000u
+static inline rcc_apb2enr_t rcc_apb2enr_spi1en(rcc_apb2enr_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 rcc_apb2enr_spi1en_get(rcc_apb2enr_t r) { return (r.v & 0x00001000u) >> 12; }
+#define RCC_APB2ENR_SPI4EN_Pos 19
+#define RCC_APB2ENR_SPI4EN_Msk 0x00080000u
+static inline rcc_apb2enr_t rcc_apb2enr_spi4en(rcc_apb2enr_t r, u32 v) { r.v = (r.v & ~0x00080000u) | ((v << 19) & 0x00080000u); r.m |= 0x00080000u; return r; }
+static inline u32 rcc_apb2enr_spi4en_get(rcc_apb2enr_t r) { return (r.v & 0x00080000u) >> 19; }
+
+/* APB3ENR : APB3 peripheral clock register */
+typedef struct { u32 v; u32 m; } rcc_apb3enr_t;
+static inline rcc_apb3enr_t rcc_apb3enr(void) { rcc_apb3enr_t r = { 0, 0 }; return r; }
+static inline rcc_apb3enr_t rcc_apb3enr_rd(u32 base) { rcc_apb3enr_t r = { reg_rd(base + 0xA8), 0 }; return r; }
+static inline void rcc_apb3enr_wr(u32 base, rcc_apb3enr_t r) { reg_wr(base + 0xA8, r.v); }
+static inline void rcc_apb3enr_modify(u32 base, rcc_apb3enr_t r) { reg_wr(base + 0xA8, (reg_rd(base + 0xA8) & ~r.m) | r.v); }
+#define RCC_APB3ENR_RTCAPBEN_Pos 21
+#define RCC_APB3ENR_RTCAPBEN_Msk 0x00200000u
+static inline rcc_apb3enr_t rcc_apb3enr_rtcapben(rcc_apb3enr_t r, u32 v) { r.v = (r.v & ~0x00200000u) | ((v << 21) & 0x00200000u); r.m |= 0x00200000u; return r; }
+static inline u32 rcc_apb3enr_rtcapben_get(rcc_apb3enr_t r) { return (r.v & 0x00200000u) >> 21; }
+
+/* -------------------------------------------------------------------------- */
+/* SPI : Serial peripheral interface                                          */
+/* -------------------------------------------------------------------------- */
+
+/* CR1 : control register 1 */
+typedef struct { u32 v; u32 m; } spi_cr1_t;
+static inline spi_cr1_t spi_cr1(void) { spi_cr1_t r = { 0, 0 }; return r; }
+static inline spi_cr1_t spi_cr1_rd(u32 base) { spi_cr1_t r = { reg_rd(base + 0x00), 0 }; return r; }
+static inline void spi_cr1_wr(u32 base, spi_cr1_t r) { reg_wr(base + 0x00, r.v); }
+static inline void spi_cr1_modify(u32 base, spi_cr1_t r) { reg_wr(base + 0x00, (reg_rd(base + 0x00) & ~r.m) | r.v); }
+#define SPI_CR1_SPE_Pos 0
+#define SPI_CR1_SPE_Msk 0x00000001u
+static inline spi_cr1_t spi_cr1_spe(spi_cr1_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 spi_cr1_spe_get(spi_cr1_t r) { return (r.v & 0x00000001u) >> 0; }
+#define SPI_CR1_MASRX_Pos 8
+#define SPI_CR1_MASRX_Msk 0x00000100u
+static inline spi_cr1_t spi_cr1_masrx(spi_cr1_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 spi_cr1_masrx_get(spi_cr1_t r) { return (r.v & 0x00000100u) >> 8; }
+#define SPI_CR1_CSTART_Pos 9
+#define SPI_CR1_CSTART_Msk 0x00000200u
+static inline spi_cr1_t spi_cr1_cstart(spi_cr1_t r, u32 v) { r.v = (r.v & ~0x00000200u) | ((v << 9) & 0x00000200u); r.m |= 0x00000200u; return r; }
+static inline u32 spi_cr1_cstart_get(spi_cr1_t r) { return (r.v & 0x00000200u) >> 9; }
+#define SPI_CR1_CSUSP_Pos 10
+#define SPI_CR1_CSUSP_Msk 0x00000400u
+static inline spi_cr1_t spi_cr1_csusp(spi_cr1_t r, u32 v) { r.v = (r.v & ~0x00000400u) | ((v << 10) & 0x00000400u); r.m |= 0x00000400u; return r; }
+static inline u32 spi_cr1_csusp_get(spi_cr1_t r) { return (r.v & 0x00000400u) >> 10; }
+#define SPI_CR1_HDDIR_Pos 11
+#define SPI_CR1_HDDIR_Msk 0x00000800u
+static inline spi_cr1_t spi_cr1_hddir(spi_cr1_t r, u32 v) { r.v = (r.v & ~0x00000800u) | ((v << 11) & 0x00000800u); r.m |= 0x00000800u; return r; }
+static inline u32 spi_cr1_hddir_get(spi_cr1_t r) { return (r.v & 0x00000800u) >> 11; }
+#define SPI_CR1_SSI_Pos 12
+#define SPI_CR1_SSI_Msk 0x00001000u
+static inline spi_cr1_t spi_cr1_ssi(spi_cr1_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 spi_cr1_ssi_get(spi_cr1_t r) { return (r.v & 0x00001000u) >> 12; }
+
+/* CR2 : control register 2 */
+typedef struct { u32 v; u32 m; } spi_cr2_t;
+static inline spi_cr2_t spi_cr2(void) { spi_cr2_t r = { 0, 0 }; return r; }
+static inline spi_cr2_t spi_cr2_rd(u32 base) { spi_cr2_t r = { reg_rd(base + 0x04), 0 }; return r; }
+static inline void spi_cr2_wr(u32 base, spi_cr2_t r) { reg_wr(base + 0x04, r.v); }
+static inline void spi_cr2_modify(u32 base, spi_cr2_t r) { reg_wr(base + 0x04, (reg_rd(base + 0x04) & ~r.m) | r.v); }
+#define SPI_CR2_TSIZE_Pos 0
+#define SPI_CR2_TSIZE_Msk 0x0000FFFFu
+static inline spi_cr2_t spi_cr2_tsize(spi_cr2_t r, u32 v) { r.v = (r.v & ~0x0000FFFFu) | ((v << 0) & 0x0000FFFFu); r.m |= 0x0000FFFFu; return r; }
+static inline u32 spi_cr2_tsize_get(spi_cr2_t r) { return (r.v & 0x0000FFFFu) >> 0; }
+
+/* CFG1 : configuration register 1 */
+typedef struct { u32 v; u32 m; } spi_cfg1_t;
+static inline spi_cfg1_t spi_cfg1(void) { spi_cfg1_t r = { 0, 0 }; return r; }
+static inline spi_cfg1_t spi_cfg1_rd(u32 base) { spi_cfg1_t r = { reg_rd(base + 0x08), 0 }; return r; }
+static inline void spi_cfg1_wr(u32 base, spi_cfg1_t r) { reg_wr(base + 0x08, r.v); }
+static inline void spi_cfg1_modify(u32 base, spi_cfg1_t r) { reg_wr(base + 0x08, (reg_rd(base + 0x08) & ~r.m) | r.v); }
+#define SPI_CFG1_DSIZE_Pos 0
+#define SPI_CFG1_DSIZE_Msk 0x0000001Fu
+static inline spi_cfg1_t spi_cfg1_dsize(spi_cfg1_t r, u32 v) { r.v = (r.v & ~0x0000001Fu) | ((v << 0) & 0x0000001Fu); r.m |= 0x0000001Fu; return r; }
+static inline u32 spi_cfg1_dsize_get(spi_cfg1_t r) { return (r.v & 0x0000001Fu) >> 0; }
+#define SPI_CFG1_FTHLV_Pos 5
+#define SPI_CFG1_FTHLV_Msk 0x000001E0u
+static inline spi_cfg1_t spi_cfg1_fthlv(spi_cfg1_t r, u32 v) { r.v = (r.v & ~0x000001E0u) | ((v << 5) & 0x000001E0u); r.m |= 0x000001E0u; return r; }
+static inline u32 spi_cfg1_fthlv_get(spi_cfg1_t r) { return (r.v & 0x000001E0u) >> 5; }
+#define SPI_CFG1_UDRCFG_Pos 9
+#define SPI_CFG1_UDRCFG_Msk 0x00000200u
+static inline spi_cfg1_t spi_cfg1_udrcfg(spi_cfg1_t r, u32 v) { r.v = (r.v & ~0x00000200u) | ((v << 9) & 0x00000200u); r.m |= 0x00000200u; return r; }
+static inline u32 spi_cfg1_udrcfg_get(spi_cfg1_t r) { return (r.v & 0x00000200u) >> 9; }
+#define SPI_CFG1_RXDMAEN_Pos 14
+#define SPI_CFG1_RXDMAEN_Msk 0x00004000u
+static inline spi_cfg1_t spi_cfg1_rxdmaen(spi_cfg1_t r, u32 v) { r.v = (r.v & ~0x00004000u) | ((v << 14) & 0x00004000u); r.m |= 0x00004000u; return r; }
+static inline u32 spi_cfg1_rxdmaen_get(spi_cfg1_t r) { return (r.v & 0x00004000u) >> 14; }
+#define SPI_CFG1_TXDMAEN_Pos 15
+#define SPI_CFG1_TXDMAEN_Msk 0x00008000u
+static inline spi_cfg1_t spi_cfg1_txdmaen(spi_cfg1_t r, u32 v) { r.v = (r.v & ~0x00008000u) | ((v << 15) & 0x00008000u); r.m |= 0x00008000u; return r; }
+static inline u32 spi_cfg1_txdmaen_get(spi_cfg1_t r) { return (r.v & 0x00008000u) >> 15; }
+#define SPI_CFG1_CRCSIZE_Pos 16
+#define SPI_CFG1_CRCSIZE_Msk 0x001F0000u
+static inline spi_cfg1_t spi_cfg1_crcsize(spi_cfg1_t r, u32 v) { r.v = (r.v & ~0x001F0000u) | ((v << 16) & 0x001F0000u); r.m |= 0x001F0000u; return r; }
+static inline u32 spi_cfg1_crcsize_get(spi_cfg1_t r) { return (r.v & 0x001F0000u) >> 16; }
+#define SPI_CFG1_CRCEN_Pos 22
+#define SPI_CFG1_CRCEN_Msk 0x00400000u
+static inline spi_cfg1_t spi_cfg1_crcen(spi_cfg1_t r, u32 v) { r.v = (r.v & ~0x00400000u) | ((v << 22) & 0x00400000u); r.m |= 0x00400000u; return r; }
+static inline u32 spi_cfg1_crcen_get(spi_cfg1_t r) { return (r.v & 0x00400000u) >> 22; }
+#define SPI_CFG1_MBR_Pos 28
+#define SPI_CFG1_MBR_Msk 0x70000000u
+static inline spi_cfg1_t spi_cfg1_mbr(spi_cfg1_t r, u32 v) { r.v = (r.v & ~0x70000000u) | ((v << 28) & 0x70000000u); r.m |= 0x70000000u; return r; }
+static inline u32 spi_cfg1_mbr_get(spi_cfg1_t r) { return (r.v & 0x70000000u) >> 28; }
+#define SPI_CFG1_BPASS_Pos 31
+#define SPI_CFG1_BPASS_Msk 0x80000000u
+static inline spi_cfg1_t spi_cfg1_bpass(spi_cfg1_t r, u32 v) { r.v = (r.v & ~0x80000000u) | ((v << 31) & 0x80000000u); r.m |= 0x80000000u; return r; }
+static inline u32 spi_cfg1_bpass_get(spi_cfg1_t r) { return (r.v & 0x80000000u) >> 31; }
+
+/* CFG2 : configuration register 2 */
+typedef struct { u32 v; u32 m; } spi_cfg2_t;
+static inline spi_cfg2_t spi_cfg2(void) { spi_cfg2_t r = { 0, 0 }; return r; }
+static inline spi_cfg2_t spi_cfg2_rd(u32 base) { spi_cfg2_t r = { reg_rd(base + 0x0C), 0 }; return r; }
+static inline void spi_cfg2_wr(u32 base, spi_cfg2_t r) { reg_wr(base + 0x0C, r.v); }
+static inline void spi_cfg2_modify(u32 base, spi_cfg2_t r) { reg_wr(base + 0x0C, (reg_rd(base + 0x0C) & ~r.m) | r.v); }
+#define SPI_CFG2_MSSI_Pos 0
+#define SPI_CFG2_MSSI_Msk 0x0000000Fu
+static inline spi_cfg2_t spi_cfg2_mssi(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x0000000Fu) | ((v << 0) & 0x0000000Fu); r.m |= 0x0000000Fu; return r; }
+static inline u32 spi_cfg2_mssi_get(spi_cfg2_t r) { return (r.v & 0x0000000Fu) >> 0; }
+#define SPI_CFG2_MIDI_Pos 4
+#define SPI_CFG2_MIDI_Msk 0x000000F0u
+static inline spi_cfg2_t spi_cfg2_midi(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x000000F0u) | ((v << 4) & 0x000000F0u); r.m |= 0x000000F0u; return r; }
+static inline u32 spi_cfg2_midi_get(spi_cfg2_t r) { return (r.v & 0x000000F0u) >> 4; }
+#define SPI_CFG2_RDIOM_Pos 13
+#define SPI_CFG2_RDIOM_Msk 0x00002000u
+static inline spi_cfg2_t spi_cfg2_rdiom(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x00002000u) | ((v << 13) & 0x00002000u); r.m |= 0x00002000u; return r; }
+static inline u32 spi_cfg2_rdiom_get(spi_cfg2_t r) { return (r.v & 0x00002000u) >> 13; }
+#define SPI_CFG2_RDIOP_Pos 14
+#define SPI_CFG2_RDIOP_Msk 0x00004000u
+static inline spi_cfg2_t spi_cfg2_rdiop(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x00004000u) | ((v << 14) & 0x00004000u); r.m |= 0x00004000u; return r; }
+static inline u32 spi_cfg2_rdiop_get(spi_cfg2_t r) { return (r.v & 0x00004000u) >> 14; }
+#define SPI_CFG2_IOSWP_Pos 15
+#define SPI_CFG2_IOSWP_Msk 0x00008000u
+static inline spi_cfg2_t spi_cfg2_ioswp(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x00008000u) | ((v << 15) & 0x00008000u); r.m |= 0x00008000u; return r; }
+static inline u32 spi_cfg2_ioswp_get(spi_cfg2_t r) { return (r.v & 0x00008000u) >> 15; }
+#define SPI_CFG2_COMM_Pos 17
+#define SPI_CFG2_COMM_Msk 0x00060000u
+static inline spi_cfg2_t spi_cfg2_comm(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x00060000u) | ((v << 17) & 0x00060000u); r.m |= 0x00060000u; return r; }
+static inline u32 spi_cfg2_comm_get(spi_cfg2_t r) { return (r.v & 0x00060000u) >> 17; }
+#define SPI_CFG2_SP_Pos 19
+#define SPI_CFG2_SP_Msk 0x00380000u
+static inline spi_cfg2_t spi_cfg2_sp(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x00380000u) | ((v << 19) & 0x00380000u); r.m |= 0x00380000u; return r; }
+static inline u32 spi_cfg2_sp_get(spi_cfg2_t r) { return (r.v & 0x00380000u) >> 19; }
+#define SPI_CFG2_MASTER_Pos 22
+#define SPI_CFG2_MASTER_Msk 0x00400000u
+static inline spi_cfg2_t spi_cfg2_master(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x00400000u) | ((v << 22) & 0x00400000u); r.m |= 0x00400000u; return r; }
+static inline u32 spi_cfg2_master_get(spi_cfg2_t r) { return (r.v & 0x00400000u) >> 22; }
+#define SPI_CFG2_LSBFRST_Pos 23
+#define SPI_CFG2_LSBFRST_Msk 0x00800000u
+static inline spi_cfg2_t spi_cfg2_lsbfrst(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x00800000u) | ((v << 23) & 0x00800000u); r.m |= 0x00800000u; return r; }
+static inline u32 spi_cfg2_lsbfrst_get(spi_cfg2_t r) { return (r.v & 0x00800000u) >> 23; }
+#define SPI_CFG2_CPHA_Pos 24
+#define SPI_CFG2_CPHA_Msk 0x01000000u
+static inline spi_cfg2_t spi_cfg2_cpha(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x01000000u) | ((v << 24) & 0x01000000u); r.m |= 0x01000000u; return r; }
+static inline u32 spi_cfg2_cpha_get(spi_cfg2_t r) { return (r.v & 0x01000000u) >> 24; }
+#define SPI_CFG2_CPOL_Pos 25
+#define SPI_CFG2_CPOL_Msk 0x02000000u
+static inline spi_cfg2_t spi_cfg2_cpol(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x02000000u) | ((v << 25) & 0x02000000u); r.m |= 0x02000000u; return r; }
+static inline u32 spi_cfg2_cpol_get(spi_cfg2_t r) { return (r.v & 0x02000000u) >> 25; }
+#define SPI_CFG2_SSM_Pos 26
+#define SPI_CFG2_SSM_Msk 0x04000000u
+static inline spi_cfg2_t spi_cfg2_ssm(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x04000000u) | ((v << 26) & 0x04000000u); r.m |= 0x04000000u; return r; }
+static inline u32 spi_cfg2_ssm_get(spi_cfg2_t r) { return (r.v & 0x04000000u) >> 26; }
+#define SPI_CFG2_SSIOP_Pos 28
+#define SPI_CFG2_SSIOP_Msk 0x10000000u
+static inline spi_cfg2_t spi_cfg2_ssiop(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x10000000u) | ((v << 28) & 0x10000000u); r.m |= 0x10000000u; return r; }
+static inline u32 spi_cfg2_ssiop_get(spi_cfg2_t r) { return (r.v & 0x10000000u) >> 28; }
+#define SPI_CFG2_SSOE_Pos 29
+#define SPI_CFG2_SSOE_Msk 0x20000000u
+static inline spi_cfg2_t spi_cfg2_ssoe(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x20000000u) | ((v << 29) & 0x20000000u); r.m |= 0x20000000u; return r; }
+static inline u32 spi_cfg2_ssoe_get(spi_cfg2_t r) { return (r.v & 0x20000000u) >> 29; }
+#define SPI_CFG2_SSOM_Pos 30
+#define SPI_CFG2_SSOM_Msk 0x40000000u
+static inline spi_cfg2_t spi_cfg2_ssom(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x40000000u) | ((v << 30) & 0x40000000u); r.m |= 0x40000000u; return r; }
+static inline u32 spi_cfg2_ssom_get(spi_cfg2_t r) { return (r.v & 0x40000000u) >> 30; }
+#define SPI_CFG2_AFCNTR_Pos 31
+#define SPI_CFG2_AFCNTR_Msk 0x80000000u
+static inline spi_cfg2_t spi_cfg2_afcntr(spi_cfg2_t r, u32 v) { r.v = (r.v & ~0x80000000u) | ((v << 31) & 0x80000000u); r.m |= 0x80000000u; return r; }
+static inline u32 spi_cfg2_afcntr_get(spi_cfg2_t r) { return (r.v & 0x80000000u) >> 31; }
+
+/* IER : interrupt enable register */
+typedef struct { u32 v; u32 m; } spi_ier_t;
+static inline spi_ier_t spi_ier(void) { spi_ier_t r = { 0, 0 }; return r; }
+static inline spi_ier_t spi_ier_rd(u32 base) { spi_ier_t r = { reg_rd(base + 0x10), 0 }; return r; }
+static inline void spi_ier_wr(u32 base, spi_ier_t r) { reg_wr(base + 0x10, r.v); }
+static inline void spi_ier_modify(u32 base, spi_ier_t r) { reg_wr(base + 0x10, (reg_rd(base + 0x10) & ~r.m) | r.v); }
+#define SPI_IER_RXPIE_Pos 0
+#define SPI_IER_RXPIE_Msk 0x00000001u
+static inline spi_ier_t spi_ier_rxpie(spi_ier_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 spi_ier_rxpie_get(spi_ier_t r) { return (r.v & 0x00000001u) >> 0; }
+#define SPI_IER_TXPIE_Pos 1
+#define SPI_IER_TXPIE_Msk 0x00000002u
+static inline spi_ier_t spi_ier_txpie(spi_ier_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 spi_ier_txpie_get(spi_ier_t r) { return (r.v & 0x00000002u) >> 1; }
+#define SPI_IER_DXPIE_Pos 2
+#define SPI_IER_DXPIE_Msk 0x00000004u
+static inline spi_ier_t spi_ier_dxpie(spi_ier_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 spi_ier_dxpie_get(spi_ier_t r) { return (r.v & 0x00000004u) >> 2; }
+#define SPI_IER_EOTIE_Pos 3
+#define SPI_IER_EOTIE_Msk 0x00000008u
+static inline spi_ier_t spi_ier_eotie(spi_ier_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 spi_ier_eotie_get(spi_ier_t r) { return (r.v & 0x00000008u) >> 3; }
+
+/* SR : status register */
+typedef struct { u32 v; u32 m; } spi_sr_t;
+static inline spi_sr_t spi_sr(void) { spi_sr_t r = { 0, 0 }; return r; }
+static inline spi_sr_t spi_sr_rd(u32 base) { spi_sr_t r = { reg_rd(base + 0x14), 0 }; return r; }
+static inline void spi_sr_wr(u32 base, spi_sr_t r) { reg_wr(base + 0x14, r.v); }
+static inline void spi_sr_modify(u32 base, spi_sr_t r) { reg_wr(base + 0x14, (reg_rd(base + 0x14) & ~r.m) | r.v); }
+#define SPI_SR_RXP_Pos 0
+#define SPI_SR_RXP_Msk 0x00000001u
+static inline spi_sr_t spi_sr_rxp(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 spi_sr_rxp_get(spi_sr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define SPI_SR_TXP_Pos 1
+#define SPI_SR_TXP_Msk 0x00000002u
+static inline spi_sr_t spi_sr_txp(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 spi_sr_txp_get(spi_sr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define SPI_SR_DXP_Pos 2
+#define SPI_SR_DXP_Msk 0x00000004u
+static inline spi_sr_t spi_sr_dxp(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 spi_sr_dxp_get(spi_sr_t r) { return (r.v & 0x00000004u) >> 2; }
+#define SPI_SR_EOT_Pos 3
+#define SPI_SR_EOT_Msk 0x00000008u
+static inline spi_sr_t spi_sr_eot(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 spi_sr_eot_get(spi_sr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define SPI_SR_TXTF_Pos 4
+#define SPI_SR_TXTF_Msk 0x00000010u
+static inline spi_sr_t spi_sr_txtf(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 spi_sr_txtf_get(spi_sr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define SPI_SR_UDR_Pos 5
+#define SPI_SR_UDR_Msk 0x00000020u
+static inline spi_sr_t spi_sr_udr(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 spi_sr_udr_get(spi_sr_t r) { return (r.v & 0x00000020u) >> 5; }
+#define SPI_SR_CRCE_Pos 6
+#define SPI_SR_CRCE_Msk 0x00000040u
+static inline spi_sr_t spi_sr_crce(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 spi_sr_crce_get(spi_sr_t r) { return (r.v & 0x00000040u) >> 6; }
+#define SPI_SR_MODF_Pos 7
+#define SPI_SR_MODF_Msk 0x00000080u
+static inline spi_sr_t spi_sr_modf(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 spi_sr_modf_get(spi_sr_t r) { return (r.v & 0x00000080u) >> 7; }
+#define SPI_SR_SUSP_Pos 11
+#define SPI_SR_SUSP_Msk 0x00000800u
+static inline spi_sr_t spi_sr_susp(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00000800u) | ((v << 11) & 0x00000800u); r.m |= 0x00000800u; return r; }
+static inline u32 spi_sr_susp_get(spi_sr_t r) { return (r.v & 0x00000800u) >> 11; }
+#define SPI_SR_TXC_Pos 12
+#define SPI_SR_TXC_Msk 0x00001000u
+static inline spi_sr_t spi_sr_txc(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 spi_sr_txc_get(spi_sr_t r) { return (r.v & 0x00001000u) >> 12; }
+#define SPI_SR_RXPLVL_Pos 13
+#define SPI_SR_RXPLVL_Msk 0x00006000u
+static inline spi_sr_t spi_sr_rxplvl(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00006000u) | ((v << 13) & 0x00006000u); r.m |= 0x00006000u; return r; }
+static inline u32 spi_sr_rxplvl_get(spi_sr_t r) { return (r.v & 0x00006000u) >> 13; }
+#define SPI_SR_RXWNE_Pos 15
+#define SPI_SR_RXWNE_Msk 0x00008000u
+static inline spi_sr_t spi_sr_rxwne(spi_sr_t r, u32 v) { r.v = (r.v & ~0x00008000u) | ((v << 15) & 0x00008000u); r.m |= 0x00008000u; return r; }
+static inline u32 spi_sr_rxwne_get(spi_sr_t r) { return (r.v & 0x00008000u) >> 15; }
+#define SPI_SR_CTSIZE_Pos 16
+#define SPI_SR_CTSIZE_Msk 0xFFFF0000u
+static inline spi_sr_t spi_sr_ctsize(spi_sr_t r, u32 v) { r.v = (r.v & ~0xFFFF0000u) | ((v << 16) & 0xFFFF0000u); r.m |= 0xFFFF0000u; return r; }
+static inline u32 spi_sr_ctsize_get(spi_sr_t r) { return (r.v & 0xFFFF0000u) >> 16; }
+
+/* IFCR : interrupt/status flags clear register */
+typedef struct { u32 v; u32 m; } spi_ifcr_t;
+static inline spi_ifcr_t spi_ifcr(void) { spi_ifcr_t r = { 0, 0 }; return r; }
+static inline spi_ifcr_t spi_ifcr_rd(u32 base) { spi_ifcr_t r = { reg_rd(base + 0x18), 0 }; return r; }
+static inline void spi_ifcr_wr(u32 base, spi_ifcr_t r) { reg_wr(base + 0x18, r.v); }
+static inline void spi_ifcr_modify(u32 base, spi_ifcr_t r) { reg_wr(base + 0x18, (reg_rd(base + 0x18) & ~r.m) | r.v); }
+#define SPI_IFCR_EOTC_Pos 3
+#define SPI_IFCR_EOTC_Msk 0x00000008u
+static inline spi_ifcr_t spi_ifcr_eotc(spi_ifcr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 spi_ifcr_eotc_get(spi_ifcr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define SPI_IFCR_TXTFC_Pos 4
+#define SPI_IFCR_TXTFC_Msk 0x00000010u
+static inline spi_ifcr_t spi_ifcr_txtfc(spi_ifcr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 spi_ifcr_txtfc_get(spi_ifcr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define SPI_IFCR_UDRC_Pos 5
+#define SPI_IFCR_UDRC_Msk 0x00000020u
+static inline spi_ifcr_t spi_ifcr_udrc(spi_ifcr_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 spi_ifcr_udrc_get(spi_ifcr_t r) { return (r.v & 0x00000020u) >> 5; }
+#define SPI_IFCR_CRCEC_Pos 6
+#define SPI_IFCR_CRCEC_Msk 0x00000040u
+static inline spi_ifcr_t spi_ifcr_crcec(spi_ifcr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 spi_ifcr_crcec_get(spi_ifcr_t r) { return (r.v & 0x00000040u) >> 6; }
+#define SPI_IFCR_MODFC_Pos 7
+#define SPI_IFCR_MODFC_Msk 0x00000080u
+static inline spi_ifcr_t spi_ifcr_modfc(spi_ifcr_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 spi_ifcr_modfc_get(spi_ifcr_t r) { return (r.v & 0x00000080u) >> 7; }
+#define SPI_IFCR_SUSPC_Pos 11
+#define SPI_IFCR_SUSPC_Msk 0x00000800u
+static inline spi_ifcr_t spi_ifcr_suspc(spi_ifcr_t r, u32 v) { r.v = (r.v & ~0x00000800u) | ((v << 11) & 0x00000800u); r.m |= 0x00000800u; return r; }
+static inline u32 spi_ifcr_suspc_get(spi_ifcr_t r) { return (r.v & 0x00000800u) >> 11; }
+
+/* TXDR : transmit data register */
+typedef struct { u32 v; u32 m; } spi_txdr_t;
+static inline spi_txdr_t spi_txdr(void) { spi_txdr_t r = { 0, 0 }; return r; }
+static inline spi_txdr_t spi_txdr_rd(u32 base) { spi_txdr_t r = { reg_rd(base + 0x20), 0 }; return r; }
+static inline void spi_txdr_wr(u32 base, spi_txdr_t r) { reg_wr(base + 0x20, r.v); }
+static inline void spi_txdr_modify(u32 base, spi_txdr_t r) { reg_wr(base + 0x20, (reg_rd(base + 0x20) & ~r.m) | r.v); }
+#define SPI_TXDR_TXDR_Pos 0
+#define SPI_TXDR_TXDR_Msk 0xFFFFFFFFu
+static inline spi_txdr_t spi_txdr_txdr(spi_txdr_t r, u32 v) { r.v = (r.v & ~0xFFFFFFFFu) | ((v << 0) & 0xFFFFFFFFu); r.m |= 0xFFFFFFFFu; return r; }
+static inline u32 spi_txdr_txdr_get(spi_txdr_t r) { return (r.v & 0xFFFFFFFFu) >> 0; }
+
+/* RXDR : receive data register */
+typedef struct { u32 v; u32 m; } spi_rxdr_t;
+static inline spi_rxdr_t spi_rxdr(void) { spi_rxdr_t r = { 0, 0 }; return r; }
+static inline spi_rxdr_t spi_rxdr_rd(u32 base) { spi_rxdr_t r = { reg_rd(base + 0x30), 0 }; return r; }
+static inline void spi_rxdr_wr(u32 base, spi_rxdr_t r) { reg_wr(base + 0x30, r.v); }
+static inline void spi_rxdr_modify(u32 base, spi_rxdr_t r) { reg_wr(base + 0x30, (reg_rd(base + 0x30) & ~r.m) | r.v); }
+#define SPI_RXDR_RXDR_Pos 0
+#define SPI_RXDR_RXDR_Msk 0xFFFFFFFFu
+static inline spi_rxdr_t spi_rxdr_rxdr(spi_rxdr_t r, u32 v) { r.v = (r.v & ~0xFFFFFFFFu) | ((v << 0) & 0xFFFFFFFFu); r.m |= 0xFFFFFFFFu; return r; }
+static inline u32 spi_rxdr_rxdr_get(spi_rxdr_t r) { return (r.v & 0xFFFFFFFFu) >> 0; }
+
+/* -------------------------------------------------------------------------- */
+/* USART : Universal synchronous asynchronous receiver transmitter            */
+/* -------------------------------------------------------------------------- */
+
+/* CR1 : control register 1 */
+typedef struct { u32 v; u32 m; } usart_cr1_t;
+static inline usart_cr1_t usart_cr1(void) { usart_cr1_t r = { 0, 0 }; return r; }
+static inline usart_cr1_t usart_cr1_rd(u32 base) { usart_cr1_t r = { reg_rd(base + 0x00), 0 }; return r; }
+static inline void usart_cr1_wr(u32 base, usart_cr1_t r) { reg_wr(base + 0x00, r.v); }
+static inline void usart_cr1_modify(u32 base, usart_cr1_t r) { reg_wr(base + 0x00, (reg_rd(base + 0x00) & ~r.m) | r.v); }
+#define USART_CR1_UE_Pos 0
+#define USART_CR1_UE_Msk 0x00000001u
+static inline usart_cr1_t usart_cr1_ue(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 usart_cr1_ue_get(usart_cr1_t r) { return (r.v & 0x00000001u) >> 0; }
+#define USART_CR1_UESM_Pos 1
+#define USART_CR1_UESM_Msk 0x00000002u
+static inline usart_cr1_t usart_cr1_uesm(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 usart_cr1_uesm_get(usart_cr1_t r) { return (r.v & 0x00000002u) >> 1; }
+#define USART_CR1_RE_Pos 2
+#define USART_CR1_RE_Msk 0x00000004u
+static inline usart_cr1_t usart_cr1_re(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 usart_cr1_re_get(usart_cr1_t r) { return (r.v & 0x00000004u) >> 2; }
+#define USART_CR1_TE_Pos 3
+#define USART_CR1_TE_Msk 0x00000008u
+static inline usart_cr1_t usart_cr1_te(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 usart_cr1_te_get(usart_cr1_t r) { return (r.v & 0x00000008u) >> 3; }
+#define USART_CR1_IDLEIE_Pos 4
+#define USART_CR1_IDLEIE_Msk 0x00000010u
+static inline usart_cr1_t usart_cr1_idleie(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 usart_cr1_idleie_get(usart_cr1_t r) { return (r.v & 0x00000010u) >> 4; }
+#define USART_CR1_RXFNEIE_Pos 5
+#define USART_CR1_RXFNEIE_Msk 0x00000020u
+static inline usart_cr1_t usart_cr1_rxfneie(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 usart_cr1_rxfneie_get(usart_cr1_t r) { return (r.v & 0x00000020u) >> 5; }
+#define USART_CR1_TCIE_Pos 6
+#define USART_CR1_TCIE_Msk 0x00000040u
+static inline usart_cr1_t usart_cr1_tcie(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 usart_cr1_tcie_get(usart_cr1_t r) { return (r.v & 0x00000040u) >> 6; }
+#define USART_CR1_TXFNFIE_Pos 7
+#define USART_CR1_TXFNFIE_Msk 0x00000080u
+static inline usart_cr1_t usart_cr1_txfnfie(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 usart_cr1_txfnfie_get(usart_cr1_t r) { return (r.v & 0x00000080u) >> 7; }
+#define USART_CR1_PEIE_Pos 8
+#define USART_CR1_PEIE_Msk 0x00000100u
+static inline usart_cr1_t usart_cr1_peie(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000100u) | ((v << 8) & 0x00000100u); r.m |= 0x00000100u; return r; }
+static inline u32 usart_cr1_peie_get(usart_cr1_t r) { return (r.v & 0x00000100u) >> 8; }
+#define USART_CR1_PS_Pos 9
+#define USART_CR1_PS_Msk 0x00000200u
+static inline usart_cr1_t usart_cr1_ps(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000200u) | ((v << 9) & 0x00000200u); r.m |= 0x00000200u; return r; }
+static inline u32 usart_cr1_ps_get(usart_cr1_t r) { return (r.v & 0x00000200u) >> 9; }
+#define USART_CR1_PCE_Pos 10
+#define USART_CR1_PCE_Msk 0x00000400u
+static inline usart_cr1_t usart_cr1_pce(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000400u) | ((v << 10) & 0x00000400u); r.m |= 0x00000400u; return r; }
+static inline u32 usart_cr1_pce_get(usart_cr1_t r) { return (r.v & 0x00000400u) >> 10; }
+#define USART_CR1_WAKE_Pos 11
+#define USART_CR1_WAKE_Msk 0x00000800u
+static inline usart_cr1_t usart_cr1_wake(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00000800u) | ((v << 11) & 0x00000800u); r.m |= 0x00000800u; return r; }
+static inline u32 usart_cr1_wake_get(usart_cr1_t r) { return (r.v & 0x00000800u) >> 11; }
+#define USART_CR1_M0_Pos 12
+#define USART_CR1_M0_Msk 0x00001000u
+static inline usart_cr1_t usart_cr1_m0(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00001000u) | ((v << 12) & 0x00001000u); r.m |= 0x00001000u; return r; }
+static inline u32 usart_cr1_m0_get(usart_cr1_t r) { return (r.v & 0x00001000u) >> 12; }
+#define USART_CR1_MME_Pos 13
+#define USART_CR1_MME_Msk 0x00002000u
+static inline usart_cr1_t usart_cr1_mme(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00002000u) | ((v << 13) & 0x00002000u); r.m |= 0x00002000u; return r; }
+static inline u32 usart_cr1_mme_get(usart_cr1_t r) { return (r.v & 0x00002000u) >> 13; }
+#define USART_CR1_CMIE_Pos 14
+#define USART_CR1_CMIE_Msk 0x00004000u
+static inline usart_cr1_t usart_cr1_cmie(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00004000u) | ((v << 14) & 0x00004000u); r.m |= 0x00004000u; return r; }
+static inline u32 usart_cr1_cmie_get(usart_cr1_t r) { return (r.v & 0x00004000u) >> 14; }
+#define USART_CR1_OVER8_Pos 15
+#define USART_CR1_OVER8_Msk 0x00008000u
+static inline usart_cr1_t usart_cr1_over8(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x00008000u) | ((v << 15) & 0x00008000u); r.m |= 0x00008000u; return r; }
+static inline u32 usart_cr1_over8_get(usart_cr1_t r) { return (r.v & 0x00008000u) >> 15; }
+#define USART_CR1_FIFOEN_Pos 29
+#define USART_CR1_FIFOEN_Msk 0x20000000u
+static inline usart_cr1_t usart_cr1_fifoen(usart_cr1_t r, u32 v) { r.v = (r.v & ~0x20000000u) | ((v << 29) & 0x20000000u); r.m |= 0x20000000u; return r; }
+static inline u32 usart_cr1_fifoen_get(usart_cr1_t r) { return (r.v & 0x20000000u) >> 29; }
+
+/* CR2 : control register 2 */
+typedef struct { u32 v; u32 m; } usart_cr2_t;
+static inline usart_cr2_t usart_cr2(void) { usart_cr2_t r = { 0, 0 }; return r; }
+static inline usart_cr2_t usart_cr2_rd(u32 base) { usart_cr2_t r = { reg_rd(base + 0x04), 0 }; return r; }
+static inline void usart_cr2_wr(u32 base, usart_cr2_t r) { reg_wr(base + 0x04, r.v); }
+static inline void usart_cr2_modify(u32 base, usart_cr2_t r) { reg_wr(base + 0x04, (reg_rd(base + 0x04) & ~r.m) | r.v); }
+#define USART_CR2_STOP_Pos 12
+#define USART_CR2_STOP_Msk 0x00003000u
+static inline usart_cr2_t usart_cr2_stop(usart_cr2_t r, u32 v) { r.v = (r.v & ~0x00003000u) | ((v << 12) & 0x00003000u); r.m |= 0x00003000u; return r; }
+static inline u32 usart_cr2_stop_get(usart_cr2_t r) { return (r.v & 0x00003000u) >> 12; }
+
+/* CR3 : control register 3 */
+typedef struct { u32 v; u32 m; } usart_cr3_t;
+static inline usart_cr3_t usart_cr3(void) { usart_cr3_t r = { 0, 0 }; return r; }
+static inline usart_cr3_t usart_cr3_rd(u32 base) { usart_cr3_t r = { reg_rd(base + 0x08), 0 }; return r; }
+static inline void usart_cr3_wr(u32 base, usart_cr3_t r) { reg_wr(base + 0x08, r.v); }
+static inline void usart_cr3_modify(u32 base, usart_cr3_t r) { reg_wr(base + 0x08, (reg_rd(base + 0x08) & ~r.m) | r.v); }
+#define USART_CR3_EIE_Pos 0
+#define USART_CR3_EIE_Msk 0x00000001u
+static inline usart_cr3_t usart_cr3_eie(usart_cr3_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 usart_cr3_eie_get(usart_cr3_t r) { return (r.v & 0x00000001u) >> 0; }
+#define USART_CR3_DMAR_Pos 6
+#define USART_CR3_DMAR_Msk 0x00000040u
+static inline usart_cr3_t usart_cr3_dmar(usart_cr3_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 usart_cr3_dmar_get(usart_cr3_t r) { return (r.v & 0x00000040u) >> 6; }
+#define USART_CR3_DMAT_Pos 7
+#define USART_CR3_DMAT_Msk 0x00000080u
+static inline usart_cr3_t usart_cr3_dmat(usart_cr3_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 usart_cr3_dmat_get(usart_cr3_t r) { return (r.v & 0x00000080u) >> 7; }
+
+/* BRR : baud rate register */
+typedef struct { u32 v; u32 m; } usart_brr_t;
+static inline usart_brr_t usart_brr(void) { usart_brr_t r = { 0, 0 }; return r; }
+static inline usart_brr_t usart_brr_rd(u32 base) { usart_brr_t r = { reg_rd(base + 0x0C), 0 }; return r; }
+static inline void usart_brr_wr(u32 base, usart_brr_t r) { reg_wr(base + 0x0C, r.v); }
+static inline void usart_brr_modify(u32 base, usart_brr_t r) { reg_wr(base + 0x0C, (reg_rd(base + 0x0C) & ~r.m) | r.v); }
+#define USART_BRR_BRR_Pos 0
+#define USART_BRR_BRR_Msk 0x0000FFFFu
+static inline usart_brr_t usart_brr_brr(usart_brr_t r, u32 v) { r.v = (r.v & ~0x0000FFFFu) | ((v << 0) & 0x0000FFFFu); r.m |= 0x0000FFFFu; return r; }
+static inline u32 usart_brr_brr_get(usart_brr_t r) { return (r.v & 0x0000FFFFu) >> 0; }
+
+/* ISR : interrupt and status register */
+typedef struct { u32 v; u32 m; } usart_isr_t;
+static inline usart_isr_t usart_isr(void) { usart_isr_t r = { 0, 0 }; return r; }
+static inline usart_isr_t usart_isr_rd(u32 base) { usart_isr_t r = { reg_rd(base + 0x1C), 0 }; return r; }
+static inline void usart_isr_wr(u32 base, usart_isr_t r) { reg_wr(base + 0x1C, r.v); }
+static inline void usart_isr_modify(u32 base, usart_isr_t r) { reg_wr(base + 0x1C, (reg_rd(base + 0x1C) & ~r.m) | r.v); }
+#define USART_ISR_PE_Pos 0
+#define USART_ISR_PE_Msk 0x00000001u
+static inline usart_isr_t usart_isr_pe(usart_isr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 usart_isr_pe_get(usart_isr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define USART_ISR_FE_Pos 1
+#define USART_ISR_FE_Msk 0x00000002u
+static inline usart_isr_t usart_isr_fe(usart_isr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 usart_isr_fe_get(usart_isr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define USART_ISR_NE_Pos 2
+#define USART_ISR_NE_Msk 0x00000004u
+static inline usart_isr_t usart_isr_ne(usart_isr_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 usart_isr_ne_get(usart_isr_t r) { return (r.v & 0x00000004u) >> 2; }
+#define USART_ISR_ORE_Pos 3
+#define USART_ISR_ORE_Msk 0x00000008u
+static inline usart_isr_t usart_isr_ore(usart_isr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 usart_isr_ore_get(usart_isr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define USART_ISR_IDLE_Pos 4
+#define USART_ISR_IDLE_Msk 0x00000010u
+static inline usart_isr_t usart_isr_idle(usart_isr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 usart_isr_idle_get(usart_isr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define USART_ISR_RXFNE_Pos 5
+#define USART_ISR_RXFNE_Msk 0x00000020u
+static inline usart_isr_t usart_isr_rxfne(usart_isr_t r, u32 v) { r.v = (r.v & ~0x00000020u) | ((v << 5) & 0x00000020u); r.m |= 0x00000020u; return r; }
+static inline u32 usart_isr_rxfne_get(usart_isr_t r) { return (r.v & 0x00000020u) >> 5; }
+#define USART_ISR_TC_Pos 6
+#define USART_ISR_TC_Msk 0x00000040u
+static inline usart_isr_t usart_isr_tc(usart_isr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 usart_isr_tc_get(usart_isr_t r) { return (r.v & 0x00000040u) >> 6; }
+#define USART_ISR_TXFNF_Pos 7
+#define USART_ISR_TXFNF_Msk 0x00000080u
+static inline usart_isr_t usart_isr_txfnf(usart_isr_t r, u32 v) { r.v = (r.v & ~0x00000080u) | ((v << 7) & 0x00000080u); r.m |= 0x00000080u; return r; }
+static inline u32 usart_isr_txfnf_get(usart_isr_t r) { return (r.v & 0x00000080u) >> 7; }
+
+/* ICR : interrupt flag clear register */
+typedef struct { u32 v; u32 m; } usart_icr_t;
+static inline usart_icr_t usart_icr(void) { usart_icr_t r = { 0, 0 }; return r; }
+static inline usart_icr_t usart_icr_rd(u32 base) { usart_icr_t r = { reg_rd(base + 0x20), 0 }; return r; }
+static inline void usart_icr_wr(u32 base, usart_icr_t r) { reg_wr(base + 0x20, r.v); }
+static inline void usart_icr_modify(u32 base, usart_icr_t r) { reg_wr(base + 0x20, (reg_rd(base + 0x20) & ~r.m) | r.v); }
+#define USART_ICR_PECF_Pos 0
+#define USART_ICR_PECF_Msk 0x00000001u
+static inline usart_icr_t usart_icr_pecf(usart_icr_t r, u32 v) { r.v = (r.v & ~0x00000001u) | ((v << 0) & 0x00000001u); r.m |= 0x00000001u; return r; }
+static inline u32 usart_icr_pecf_get(usart_icr_t r) { return (r.v & 0x00000001u) >> 0; }
+#define USART_ICR_FECF_Pos 1
+#define USART_ICR_FECF_Msk 0x00000002u
+static inline usart_icr_t usart_icr_fecf(usart_icr_t r, u32 v) { r.v = (r.v & ~0x00000002u) | ((v << 1) & 0x00000002u); r.m |= 0x00000002u; return r; }
+static inline u32 usart_icr_fecf_get(usart_icr_t r) { return (r.v & 0x00000002u) >> 1; }
+#define USART_ICR_NECF_Pos 2
+#define USART_ICR_NECF_Msk 0x00000004u
+static inline usart_icr_t usart_icr_necf(usart_icr_t r, u32 v) { r.v = (r.v & ~0x00000004u) | ((v << 2) & 0x00000004u); r.m |= 0x00000004u; return r; }
+static inline u32 usart_icr_necf_get(usart_icr_t r) { return (r.v & 0x00000004u) >> 2; }
+#define USART_ICR_ORECF_Pos 3
+#define USART_ICR_ORECF_Msk 0x00000008u
+static inline usart_icr_t usart_icr_orecf(usart_icr_t r, u32 v) { r.v = (r.v & ~0x00000008u) | ((v << 3) & 0x00000008u); r.m |= 0x00000008u; return r; }
+static inline u32 usart_icr_orecf_get(usart_icr_t r) { return (r.v & 0x00000008u) >> 3; }
+#define USART_ICR_IDLECF_Pos 4
+#define USART_ICR_IDLECF_Msk 0x00000010u
+static inline usart_icr_t usart_icr_idlecf(usart_icr_t r, u32 v) { r.v = (r.v & ~0x00000010u) | ((v << 4) & 0x00000010u); r.m |= 0x00000010u; return r; }
+static inline u32 usart_icr_idlecf_get(usart_icr_t r) { return (r.v & 0x00000010u) >> 4; }
+#define USART_ICR_TCCF_Pos 6
+#define USART_ICR_TCCF_Msk 0x00000040u
+static inline usart_icr_t usart_icr_tccf(usart_icr_t r, u32 v) { r.v = (r.v & ~0x00000040u) | ((v << 6) & 0x00000040u); r.m |= 0x00000040u; return r; }
+static inline u32 usart_icr_tccf_get(usart_icr_t r) { return (r.v & 0x00000040u) >> 6; }
+
+/* RDR : receive data register */
+typedef struct { u32 v; u32 m; } usart_rdr_t;
+static inline usart_rdr_t usart_rdr(void) { usart_rdr_t r = { 0, 0 }; return r; }
+static inline usart_rdr_t usart_rdr_rd(u32 base) { usart_rdr_t r = { reg_rd(base + 0x24), 0 }; return r; }
+static inline void usart_rdr_wr(u32 base, usart_rdr_t r) { reg_wr(base + 0x24, r.v); }
+static inline void usart_rdr_modify(u32 base, usart_rdr_t r) { reg_wr(base + 0x24, (reg_rd(base + 0x24) & ~r.m) | r.v); }
+#define USART_RDR_RDR_Pos 0
+#define USART_RDR_RDR_Msk 0x000001FFu
+static inline usart_rdr_t usart_rdr_rdr(usart_rdr_t r, u32 v) { r.v = (r.v & ~0x000001FFu) | ((v << 0) & 0x000001FFu); r.m |= 0x000001FFu; return r; }
+static inline u32 usart_rdr_rdr_get(usart_rdr_t r) { return (r.v & 0x000001FFu) >> 0; }
+
+/* TDR : transmit data register */
+typedef struct { u32 v; u32 m; } usart_tdr_t;
+static inline usart_tdr_t usart_tdr(void) { usart_tdr_t r = { 0, 0 }; return r; }
+static inline usart_tdr_t usart_tdr_rd(u32 base) { usart_tdr_t r = { reg_rd(base + 0x28), 0 }; return r; }
+static inline void usart_tdr_wr(u32 base, usart_tdr_t r) { reg_wr(base + 0x28, r.v); }
+static inline void usart_tdr_modify(u32 base, usart_tdr_t r) { reg_wr(base + 0x28, (reg_rd(base + 0x28) & ~r.m) | r.v); }
+#define USART_TDR_TDR_Pos 0
+#define USART_TDR_TDR_Msk 0x000001FFu
+static inline usart_tdr_t usart_tdr_tdr(usart_tdr_t r, u32 v) { r.v = (r.v & ~0x000001FFu) | ((v << 0) & 0x000001FFu); r.m |= 0x000001FFu; return r; }
+static inline u32 usart_tdr_tdr_get(usart_tdr_t r) { return (r.v & 0x000001FFu) >> 0; }
+
+/* PRESC : prescaler register */
+typedef struct { u32 v; u32 m; } usart_presc_t;
+static inline usart_presc_t usart_presc(void) { usart_presc_t r = { 0, 0 }; return r; }
+static inline usart_presc_t usart_presc_rd(u32 base) { usart_presc_t r = { reg_rd(base + 0x2C), 0 }; return r; }
+static inline void usart_presc_wr(u32 base, usart_presc_t r) { reg_wr(base + 0x2C, r.v); }
+static inline void usart_presc_modify(u32 base, usart_presc_t r) { reg_wr(base + 0x2C, (reg_rd(base + 0x2C) & ~r.m) | r.v); }
+#define USART_PRESC_PRESCALER_Pos 0
+#define USART_PRESC_PRESCALER_Msk 0x0000000Fu
+static inline usart_presc_t usart_presc_prescaler(usart_presc_t r, u32 v) { r.v = (r.v & ~0x0000000Fu) | ((v << 0) & 0x0000000Fu); r.m |= 0x0000000Fu; return r; }
+static inline u32 usart_presc_prescaler_get(usart_presc_t r) { return (r.v & 0x0000000Fu) >> 0; }
+
+#endif
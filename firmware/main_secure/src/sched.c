@@ -0,0 +1,141 @@
+/**
+ * @file  sched.c
+ * @brief Access schedules, precompiled into bitmaps of 15 minutes slots
+ *
+ * Weekly schedules and holiday calendars are compiled on the host (see
+ * scripts/sched_compile.py) into a flash-resident blob. A decision is then
+ * a fixed number of word reads, whatever the number of schedules or rules
+ * that were used to define them.
+ *
+ * Days are counted from 2000-01-01 (a Saturday), this is the format used
+ * by the time service.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "driver/crc.h"
+#include "driver/dma.h"
+#include "log.h"
+#include "sched.h"
+
+typedef struct sched_ctx
+{
+	u32  cal;       // Address of first calendar
+	u32  rec;       // Address of first schedule record
+	uint cal_words; // Size of one calendar (words)
+	uint calendars;
+	uint count;
+	u32  base_day;
+	u32  days;
+} sched_ctx;
+
+static sched_ctx ctx;
+
+/**
+ * @brief Load and check compiled schedules
+ *
+ * On error, no schedule is available and all checks are denied.
+ *
+ * @param addr Address of the blob (see SCHED_ADDR)
+ * @return SCHED_OK on success, or a negative SCHED_ERR_* value
+ */
+int sched_init(u32 addr)
+{
+	sched_hdr hdr;
+	uint cal_words, need;
+	u32  v;
+
+	ctx.count = 0;
+	dma_init();
+	crc_init();
+
+	// Read header from flash (LE words)
+	hdr.magic     = reg_rd(addr + 0x00);
+	v             = reg_rd(addr + 0x04);
+	hdr.version   = (u16)(v & 0xFFFF);
+	hdr.count     = (u16)(v >> 16);
+	v             = reg_rd(addr + 0x08);
+	hdr.calendars = (u16)(v & 0xFFFF);
+	hdr.days      = (u16)(v >> 16);
+	hdr.base_day  = reg_rd(addr + 0x0C);
+	hdr.size      = reg_rd(addr + 0x10);
+	hdr.crc       = reg_rd(addr + 0x14);
+	if ((hdr.magic != SCHED_MAGIC) || (hdr.version != SCHED_VERSION))
+		return(SCHED_ERR_HDR);
+
+	cal_words = ((uint)hdr.days + 31) / 32;
+	need  = (uint)hdr.calendars * cal_words;
+	need += (uint)hdr.count * SCHED_REC_WORDS;
+	if ((hdr.size != (4 * need)) || ((sizeof(hdr) + hdr.size) > SCHED_SIZE))
+		return(SCHED_ERR_SIZE);
+	if (crc_compute(addr + sizeof(hdr), hdr.size) != hdr.crc)
+		return(SCHED_ERR_CRC);
+
+	ctx.cal       = addr + sizeof(hdr);
+	ctx.rec       = ctx.cal + (4 * hdr.calendars * cal_words);
+	ctx.cal_words = cal_words;
+	ctx.calendars = hdr.calendars;
+	ctx.base_day  = hdr.base_day;
+	ctx.days      = hdr.days;
+	ctx.count     = hdr.count;
+
+	log_print(LOG_INF, "Sched: %d schedules, %d calendars\n", ctx.count, ctx.calendars);
+	return(SCHED_OK);
+}
+
+/**
+ * @brief Test if a schedule allows access at a given time
+ *
+ * The duration of this function does not depend on the number of
+ * schedules : at most three words are read from the compiled blob.
+ *
+ * @param id     Index of the schedule
+ * @param day    Day number (since 2000-01-01)
+ * @param minute Minute of the day (0 to 1439)
+ * @return True if access is allowed, False if denied (or unknown schedule)
+ */
+int sched_check(uint id, u32 day, uint minute)
+{
+	u32  rec, cal, offset;
+	uint row, bit;
+
+	if ((id >= ctx.count) || (minute >= (24 * 60)))
+		return(0);
+
+	rec = ctx.rec + (4 * SCHED_REC_WORDS * id);
+	// 2000-01-01 was a Saturday (row 5)
+	row = (uint)((day + 5) % 7);
+
+	// Holiday : use the dedicated row if the day is into calendar
+	cal    = reg_rd(rec) & 0xFF;
+	offset = day - ctx.base_day;
+	if ((cal < ctx.calendars) && (day >= ctx.base_day) && (offset < ctx.days))
+	{
+		cal = ctx.cal + (4 * ctx.cal_words * cal);
+		if (reg_rd(cal + (4 * (offset / 32))) & (1u << (offset % 32)))
+			row = SCHED_ROW_HOLIDAY;
+	}
+
+	bit = (row * SCHED_SLOTS) + (minute / 15);
+	return ((reg_rd(rec + 4 + (4 * (bit / 32))) >> (bit % 32)) & 1);
+}
+
+/**
+ * @brief Get the number of available schedules
+ *
+ * @return uint Number of schedules (0 if none loaded)
+ */
+uint sched_count(void)
+{
+	return(ctx.count);
+}
+/* EOF */
@@ -0,0 +1,69 @@
+/**
+ * @file  sched.h
+ * @brief Definitions and prototypes for the access schedules
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef SCHED_H
+#define SCHED_H
+#include "types.h"
+
+// Location of the compiled schedules (last sector of secure flash)
+#ifdef RUN_SEC
+#define SCHED_ADDR 0x0C00E000
+#else
+#define SCHED_ADDR 0x0800E000
+#endif
+#define SCHED_SIZE 0x2000
+
+#define SCHED_MAGIC   0x44484353 /* "SCHD" */
+#define SCHED_VERSION 1
+
+// Days are 96 slots of 15 minutes, rows 0-6 are Monday to Sunday
+#define SCHED_SLOTS       96
+#define SCHED_ROW_HOLIDAY 7
+#define SCHED_ROWS        8
+#define SCHED_REC_WORDS   (1 + ((SCHED_ROWS * SCHED_SLOTS) / 32))
+#define SCHED_NO_CALENDAR 0xFF
+
+/* Result of sched_init */
+#define SCHED_OK        0
+#define SCHED_ERR_HDR  -1
+#define SCHED_ERR_SIZE -2
+#define SCHED_ERR_CRC  -3
+
+/**
+ * @brief Header of the compiled schedules (see scripts/sched_compile.py)
+ *
+ * The header is followed by the holiday calendars (one bitset of "days"
+ * bits each, starting at base_day) then by the schedule records. A record
+ * is one word with the calendar index, then one bitmap of 96 slots for each
+ * day of week and one for holidays.
+ */
+typedef struct sched_hdr
+{
+	u32 magic;
+	u16 version;
+	u16 count;
+	u16 calendars;
+	u16 days;
+	u32 base_day;
+	u32 size;
+	u32 crc;
+	u32 reserved[2];
+} sched_hdr;
+
+int  sched_init (u32 addr);
+int  sched_check(uint id, u32 day, uint minute);
+uint sched_count(void);
+
+#endif
@@ -0,0 +1,346 @@
+/**
+ * @file  seq.c
+ * @brief Output sequencer : door strike, buzzer and LEDs driven by DMA
+ *
+ * Each door has one track : a timer (TIM3 or TIM4) and a GPDMA channel.
+ * The timer runs the PWM carrier of the buzzer (channel 1) and its update
+ * event paces the DMA, one word per period (SEQ_PERIOD_US). A waveform
+ * descriptor is compiled into a DMA linked list where each item writes the
+ * same word N times : a GPIO_BSRR value (state of the outputs) for a step
+ * of N periods, or a TIM_CCR1 value (buzzer duty). Once started, a
+ * sequence plays without any CPU time, up to its end or forever.
+ *
+ * A new sequence replaces the current one if its priority is the same or
+ * higher (a grant interrupts a deny blink, not the opposite).
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "seq.h"
+#include "systime.h"
+
+// Largest number of periods of one item (BNDT is 16 bits)
+#define SEQ_CHUNK (DMA_BLOCK_MAX / 4)
+#define SEQ_LINK  (DMA_LLI_UB1 | DMA_LLI_USA | DMA_LLI_UDA | DMA_LLI_ULL)
+
+/**
+ * @brief Hardware resources of a track
+ */
+typedef struct seq_track
+{
+	u32  tim;
+	u32  port;
+	u8   ch;    // GPDMA1 channel
+	u8   req;   // DMA request of the timer update
+	u8   pwm;   // Pin of the timer channel 1 (AF2)
+	seq_target target;
+} seq_track;
+
+static void _track_init(const seq_track *t);
+static u32  _pins(const seq_target *target, uint out);
+static int  _node(seq_node *nodes, uint max, uint *n, u32 base, u32 dst, u32 value, u32 count);
+static u32  _base(uint track);
+
+static const seq_track seq_tracks[SEQ_TRACKS] =
+{
+	// Door 0 : strike PB1, LEDs PB5/PB6, buzzer PB4 (TIM3_CH1)
+	{ TIM3, GPIOB, DMA_CH_SEQ0, DMA_REQ_TIM3_UP, 4,
+	  { GPIO_BSRR(GPIOB), TIM_CCR1(TIM3), { (1 << 1), (1 << 5), (1 << 6) },
+	    SEQ_PERIOD_US } },
+	// Door 1 : strike PD10, LEDs PD11/PD13, buzzer PD12 (TIM4_CH1)
+	{ TIM4, GPIOD, DMA_CH_SEQ1, DMA_REQ_TIM4_UP, 12,
+	  { GPIO_BSRR(GPIOD), TIM_CCR1(TIM4), { (1 << 10), (1 << 11), (1 << 13) },
+	    SEQ_PERIOD_US } },
+};
+
+// Items of a list must stay into one 64 KB segment (see dma_start_list)
+static seq_node seq_nodes[SEQ_TRACKS][SEQ_NODES] __attribute__((aligned(2048)));
+static const seq_desc *seq_current[SEQ_TRACKS];
+
+static const seq_step grant_steps[] =
+{
+	{  100, SEQ_OUT_STRIKE | SEQ_OUT_GREEN, 50 },
+	{  100, SEQ_OUT_STRIKE | SEQ_OUT_GREEN,  0 },
+	{  100, SEQ_OUT_STRIKE | SEQ_OUT_GREEN, 50 },
+	{ 2700, SEQ_OUT_STRIKE | SEQ_OUT_GREEN,  0 },
+};
+static const seq_step deny_steps[] =
+{
+	{ 200, SEQ_OUT_RED, 50 },
+	{ 200, 0,            0 },
+};
+static const seq_step alarm_steps[] =
+{
+	{ 500, SEQ_OUT_RED, 50 },
+	{ 500, 0,            0 },
+};
+
+const seq_desc seq_grant = { "grant", grant_steps, 4, 1,           SEQ_PRIO_GRANT };
+const seq_desc seq_deny  = { "deny",  deny_steps,  2, 3,           SEQ_PRIO_DENY  };
+const seq_desc seq_alarm = { "alarm", alarm_steps, 2, SEQ_FOREVER, SEQ_PRIO_ALARM };
+
+/**
+ * @brief Initialize the sequencer : outputs, timers and DMA
+ *
+ */
+void seq_init(void)
+{
+	uint i;
+
+	dma_init();
+	// Activate TIM3 and TIM4
+	reg_set(RCC_APB1LENR(RCC), (1 << 1) | (1 << 2));
+
+	for (i = 0; i < SEQ_TRACKS; i++)
+	{
+		seq_current[i] = 0;
+		_track_init(&seq_tracks[i]);
+	}
+}
+
+/**
+ * @brief Play a sequence on a track
+ *
+ * The sequence in progress (if any) is aborted and the outputs are set
+ * low before the new one starts, unless it has a higher priority.
+ *
+ * @param track Index of the track (door)
+ * @param desc  Pointer to the waveform descriptor (must stay allocated)
+ * @return integer Zero on success, -1 if rejected or invalid
+ */
+int seq_play(uint track, const seq_desc *desc)
+{
+	const seq_track *t;
+	int n;
+
+	if (track >= SEQ_TRACKS)
+		return(-1);
+	t = &seq_tracks[track];
+
+	if (seq_busy(track) && (seq_current[track]->prio > desc->prio))
+		return(-1);
+	seq_stop(track);
+
+	n = seq_compile(desc, &t->target, seq_nodes[track], SEQ_NODES, _base(track));
+	if (n < 0)
+		return(-1);
+	seq_current[track] = desc;
+	dma_start_list(t->ch, _base(track), &seq_nodes[track][0].lli, t->req);
+	return(0);
+}
+
+/**
+ * @brief Abort the sequence of a track, all outputs are set low
+ *
+ * @param track Index of the track (door)
+ */
+void seq_stop(uint track)
+{
+	const seq_track *t;
+
+	if (track >= SEQ_TRACKS)
+		return;
+	t = &seq_tracks[track];
+
+	dma_stop(t->ch);
+	reg_wr(t->target.bsrr, _pins(&t->target, 0xFF) << 16);
+	reg_wr(t->target.ccr, 0);
+	seq_current[track] = 0;
+}
+
+/**
+ * @brief Test if a sequence is in progress on a track
+ *
+ * @param track Index of the track (door)
+ * @return True if the track is playing
+ */
+int seq_busy(uint track)
+{
+	if ((track >= SEQ_TRACKS) || (seq_current[track] == 0))
+		return(0);
+	return ( ! dma_idle(seq_tracks[track].ch));
+}
+
+/**
+ * @brief Compile a waveform descriptor into DMA linked-list items
+ *
+ * Each step gives one item that writes the GPIO_BSRR word of its outputs
+ * once per period (split if longer than SEQ_CHUNK periods). When the duty
+ * changes, the first period of the step is used by an item that writes
+ * TIM_CCR1. Finite sequences are unrolled and end with the outputs low,
+ * the last item of an infinite one is linked to the first.
+ *
+ * @param desc   Pointer to the waveform descriptor
+ * @param target Pointer to the registers and pins of the track
+ * @param nodes  Pointer to the buffer of items
+ * @param max    Number of items of the buffer
+ * @param base   Bus address of the buffer (used for links)
+ * @return integer Number of items, or -1 if the sequence is empty or too long
+ */
+int seq_compile(const seq_desc *desc, const seq_target *target,
+                seq_node *nodes, uint max, u32 base)
+{
+	const seq_step *step;
+	u32  all, set, ticks, chunk, duty;
+	uint play, i, n = 0;
+	u32  prev = 0xFFFFFFFF;
+
+	if ((target->period == 0) || (desc->count == 0))
+		return(-1);
+	all = _pins(target, 0xFF);
+
+	for (play = 0; (play == 0) || (play < desc->repeat); play++)
+	{
+		for (i = 0; i < desc->count; i++)
+		{
+			step  = &desc->steps[i];
+			ticks = ((u32)step->ms * 1000) / target->period;
+			if (ticks == 0)
+				continue;
+			duty = (step->duty > 100) ? 100 : step->duty;
+			if (duty != prev)
+			{
+				prev = duty;
+				if (_node(nodes, max, &n, base, target->ccr,
+				          (duty * target->period) / 100, 1) < 0)
+					return(-1);
+				if (ticks > 1)
+					ticks--;
+			}
+			set = _pins(target, step->out);
+			for ( ; ticks; ticks -= chunk)
+			{
+				chunk = (ticks > SEQ_CHUNK) ? SEQ_CHUNK : ticks;
+				if (_node(nodes, max, &n, base, target->bsrr,
+				          set | ((all & ~set) << 16), chunk) < 0)
+					return(-1);
+			}
+		}
+	}
+	if (n == 0)
+		return(-1);
+
+	if (desc->repeat == SEQ_FOREVER)
+		nodes[n - 1].lli.llr = SEQ_LINK | (base & DMA_LLI_LA);
+	else
+	{
+		if ((_node(nodes, max, &n, base, target->ccr,  0, 1) < 0) ||
+		    (_node(nodes, max, &n, base, target->bsrr, all << 16, 1) < 0))
+			return(-1);
+		nodes[n - 1].lli.llr = 0;
+	}
+	return((int)n);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Configure the IOs and the timer of a track
+ *
+ * @param t Pointer to the track
+ */
+static void _track_init(const seq_track *t)
+{
+	u32  v, all;
+	uint pin;
+
+	// Outputs low, then general purpose output mode
+	all = _pins(&t->target, 0xFF);
+	reg_wr(t->target.bsrr, all << 16);
+	v = reg_rd(GPIO_MODER(t->port));
+	for (pin = 0; pin < 16; pin++)
+		if (all & (1u << pin))
+			v = (v & ~(3u << (pin * 2))) | (1u << (pin * 2));
+	reg_wr(GPIO_MODER(t->port), v);
+	// Buzzer pin : alternate function 2 (TIMx_CH1)
+	hw_gpio_af(t->port, (1u << t->pwm), 2);
+
+	// Timer : 1 MHz counter, PWM mode 1 on channel 1 with preload
+	reg_wr(TIM_PSC(t->tim), (SYSTIME_HZ / 1000000) - 1);
+	reg_wr(TIM_ARR(t->tim), (u32)t->target.period - 1);
+	reg_wr(TIM_CCMR1(t->tim), (6 << 4) | (1 << 3));
+	reg_wr(TIM_CCR1(t->tim), 0);
+	reg_wr(TIM_CCER(t->tim), (1 << 0));
+	// DMA request on update (UDE)
+	reg_wr(TIM_DIER(t->tim), (1 << 8));
+	reg_wr(TIM_EGR(t->tim), (1 << 0));
+	reg_wr(TIM_SR(t->tim), 0);
+	// Start, with ARR preload
+	reg_wr(TIM_CR1(t->tim), (1 << 7) | (1 << 0));
+}
+
+/**
+ * @brief Convert outputs of a track to a GPIO pin mask
+ *
+ * @param target Pointer to the registers and pins of the track
+ * @param out    Combination of SEQ_OUT_*
+ * @return u32 Mask of the pins
+ */
+static u32 _pins(const seq_target *target, uint out)
+{
+	u32  mask = 0;
+	uint i;
+
+	for (i = 0; i < SEQ_OUTS; i++)
+		if (out & (1u << i))
+			mask |= target->pins[i];
+	return(mask);
+}
+
+/**
+ * @brief Append an item to a list, linked to the next one
+ *
+ * @param nodes Pointer to the buffer of items
+ * @param max   Number of items of the buffer
+ * @param n     Pointer to the number of items (incremented)
+ * @param base  Bus address of the buffer
+ * @param dst   Register written by the item
+ * @param value Word written
+ * @param count Number of periods (writes)
+ * @return integer Zero on success, -1 if the buffer is full
+ */
+static int _node(seq_node *nodes, uint max, uint *n, u32 base, u32 dst, u32 value, u32 count)
+{
+	seq_node *node;
+	u32 addr;
+
+	if (*n >= max)
+		return(-1);
+	node = &nodes[*n];
+	addr = base + (*n * (u32)sizeof(seq_node));
+
+	node->lli.br1 = count * 4;
+	node->lli.sar = addr + (u32)sizeof(dma_lli); // Address of node->value
+	node->lli.dar = dst;
+	node->lli.llr = SEQ_LINK | ((addr + (u32)sizeof(seq_node)) & DMA_LLI_LA);
+	node->value   = value;
+	*n += 1;
+	return(0);
+}
+
+/**
+ * @brief Get the bus address of the items of a track
+ *
+ * @param track Index of the track
+ * @return u32 Address of the first item
+ */
+static u32 _base(uint track)
+{
+#ifdef HOST
+	return(sim_addr(seq_nodes[track], sizeof(seq_nodes[0])));
+#else
+	return((u32)&seq_nodes[track][0]);
+#endif
+}
+/* EOF */
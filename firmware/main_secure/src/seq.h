@@ -0,0 +1,95 @@
+/**
+ * @file  seq.h
+ * @brief Definitions and prototypes for the output sequencer
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef SEQ_H
+#define SEQ_H
+#include "driver/dma.h"
+#include "types.h"
+
+// One track per door (one timer and one DMA channel each)
+#define SEQ_TRACKS 2
+// Maximum number of compiled items of one track
+#define SEQ_NODES  48
+// Period of the PWM carrier, also the time step of sequences (4 kHz)
+#define SEQ_PERIOD_US 250
+
+/* Outputs of a track (bits of seq_step.out) */
+#define SEQ_OUT_STRIKE (1 << 0)
+#define SEQ_OUT_GREEN  (1 << 1)
+#define SEQ_OUT_RED    (1 << 2)
+#define SEQ_OUTS 3
+
+/* Priorities : a sequence can only be replaced by one of the same or higher */
+#define SEQ_PRIO_STATUS 1
+#define SEQ_PRIO_DENY   2
+#define SEQ_PRIO_GRANT  3
+#define SEQ_PRIO_ALARM  4
+
+#define SEQ_FOREVER 0
+
+/**
+ * @brief One step of a waveform : state of the outputs for a duration
+ */
+typedef struct seq_step
+{
+	u16 ms;   // Duration (rounded down to SEQ_PERIOD_US)
+	u8  out;  // Outputs driven high (SEQ_OUT_*), the others are low
+	u8  duty; // Duty cycle of the PWM output (buzzer), percent
+} seq_step;
+
+/**
+ * @brief Waveform descriptor
+ */
+typedef struct seq_desc
+{
+	const char     *name;
+	const seq_step *steps;
+	u8 count;  // Number of steps
+	u8 repeat; // Number of plays, or SEQ_FOREVER
+	u8 prio;   // SEQ_PRIO_*
+} seq_desc;
+
+/**
+ * @brief Registers driven by a track, used by the compiler
+ */
+typedef struct seq_target
+{
+	u32 bsrr;            // Address of GPIO_BSRR
+	u32 ccr;             // Address of TIM_CCR1 (PWM output)
+	u16 pins[SEQ_OUTS];  // GPIO pin mask of each output
+	u16 period;          // Timer period, in microseconds
+} seq_target;
+
+/**
+ * @brief Compiled item : a DMA linked-list item and the word it writes
+ */
+typedef struct seq_node
+{
+	dma_lli lli;
+	u32     value;
+} seq_node;
+
+extern const seq_desc seq_grant;
+extern const seq_desc seq_deny;
+extern const seq_desc seq_alarm;
+
+void seq_init   (void);
+int  seq_play   (uint track, const seq_desc *desc);
+void seq_stop   (uint track);
+int  seq_busy   (uint track);
+int  seq_compile(const seq_desc *desc, const seq_target *target,
+                 seq_node *nodes, uint max, u32 base);
+
+#endif
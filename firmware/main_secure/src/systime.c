@@ -0,0 +1,710 @@
+/**
+ * @file  systime.c
+ * @brief Monotonic and wall-clock time, based on TIM2 and the RTC
+ *
+ * TIM2 is a free-running 32 bits counter clocked at SYSTIME_HZ, extended to
+ * 64 bits by counting overflows in its interrupt. A timestamp is read
+ * without any lock : the overflow counter is read before and after the
+ * hardware counter, and a pending overflow (interrupts masked) is detected
+ * with the UIF flag.
+ *
+ * The RTC gives the wall-clock time (seconds since 2000-01-01). Its wakeup
+ * timer raises the secure interrupt each second, used to take an anchor
+ * (RTC time, timer value) and to measure the real frequency of the timer
+ * against the 32 kHz crystal. Between two anchors, the wall-clock time is
+ * interpolated with the timer. Anchors are published with a sequence
+ * counter (seqlock), so readers never block the interrupt.
+ *
+ * TIM2 does not count in STOP mode (see power.c). LPTIM1, clocked by the
+ * same 32 kHz oscillator as the RTC, measures the duration of the STOP
+ * period and the timer is advanced by this duration when the core wakes.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "irq.h"
+#include "power.h"
+#include "regs.h"
+#include "systime.h"
+
+#define TIM_CEN  (1 << 0)
+#define TIM_URS  (1 << 2)
+#define TIM_UIE  (1 << 0)
+#define TIM_UIF  (1 << 0)
+#define TIM_UG   (1 << 0)
+
+#define BDCR_LSEON   (1 << 0)
+#define BDCR_LSERDY  (1 << 1)
+#define BDCR_RTCSEL  (3 << 8)
+#define BDCR_RTCEN   (1 << 15)
+#define BDCR_LSION   (1 << 26)
+#define BDCR_LSIRDY  (1 << 27)
+
+#define RTC_WUTWF    (1 << 2)
+#define RTC_INITS    (1 << 4)
+#define RTC_INITF    (1 << 6)
+#define RTC_INIT     (1 << 7)
+#define RTC_WUCKSEL  (4 << 0)
+#define RTC_BYPSHAD  (1 << 5)
+#define RTC_WUTE     (1 << 10)
+#define RTC_WUTIE    (1 << 14)
+#define RTC_WUTSEC   (1 << 2)
+#define RTC_CALSEC   (1 << 13)
+#define RTC_INITSEC  (1 << 14)
+#define RTC_CWUTF    (1 << 2)
+
+#define LPTIM_ENABLE  (1 << 0)
+#define LPTIM_CNTSTRT (1 << 2)
+
+#define NS_PER_SEC 1000000000u
+
+/**
+ * @brief Anchor between the timer and the wall-clock time
+ *
+ * Written by the RTC interrupt, read by anybody. The sequence number is odd
+ * while an update is in progress.
+ */
+typedef struct systime_cal
+{
+	u32 seq;
+	u32 sec;   // Wall time of the anchor (seconds since 2000-01-01)
+	u32 frac;  // Sub-second part of the anchor (ns)
+	u64 ticks; // Timer value at the anchor
+	u32 rate;  // Measured timer ticks per RTC second
+	u32 mult;  // Nanoseconds per tick (fixed point, 24 bits fraction)
+} systime_cal;
+
+void RTC_S_Handler(void);
+void TIM2_Handler(void);
+
+static void _anchor(u64 ticks, u32 sec, u32 frac, u32 rate);
+static u64  _div64(u64 n, u32 d, u32 *rem);
+static u32  _mult(u32 rate);
+static void _rtc_init(void);
+static u32  _rtc_read(u32 *frac);
+static void _rtc_write(u32 sec);
+static void _lptim_init(void);
+static u32  _lptim_read(void);
+static int  _wait(u32 reg, u32 mask, u32 us);
+static u32  _wall(u32 *ns);
+
+static vu32 time_hi;
+static volatile systime_cal cal;
+static u64  last_wakeup;
+static u32  prediv_s;
+static u32  lp_hz;    // LPTIM1 clock (LSE or LSI)
+static u32  lp_stop;  // LPTIM1 counter when STOP mode was entered
+
+/**
+ * @brief Start the timer and the RTC
+ *
+ * The RTC is configured only on the first start of the backup domain, the
+ * calendar then runs across resets. Interrupt lines are enabled by the
+ * interrupt manager (see irq.c).
+ */
+void systime_init(void)
+{
+	u32 sec, frac;
+
+	time_hi = 0;
+	last_wakeup = 0;
+
+	// Free-running 32 bits counter, no prescaler
+	rcc_apb1lenr_modify(RCC, rcc_apb1lenr_tim2en(rcc_apb1lenr(), 1));
+	reg_wr(TIM_CR1(TIM2),  TIM_URS);
+	reg_wr(TIM_PSC(TIM2),  0);
+	reg_wr(TIM_ARR(TIM2),  0xFFFFFFFF);
+	reg_wr(TIM_EGR(TIM2),  TIM_UG);
+	reg_wr(TIM_SR(TIM2),   0);
+	reg_wr(TIM_DIER(TIM2), TIM_UIE);
+	reg_wr(TIM_CR1(TIM2),  TIM_URS | TIM_CEN);
+#ifdef HOST
+	sim_vector(SYSTIME_IRQ,     TIM2_Handler);
+	sim_vector(SYSTIME_RTC_IRQ, RTC_S_Handler);
+#endif
+
+	_rtc_init();
+	_lptim_init();
+
+	// Initial anchor, with the nominal frequency
+	sec = _rtc_read(&frac);
+	_anchor(systime_ticks(), sec, frac, SYSTIME_HZ);
+}
+
+/**
+ * @brief Read the 64 bits monotonic timer
+ *
+ * @return u64 Number of timer ticks (SYSTIME_HZ) since startup
+ */
+u64 systime_ticks(void)
+{
+	u32 hi, lo, sr;
+
+	do
+	{
+		hi = time_hi;
+		lo = reg_rd(TIM_CNT(TIM2));
+		sr = reg_rd(TIM_SR(TIM2));
+	} while (hi != time_hi);
+
+	// An overflow occured but was not handled yet (interrupts masked)
+	if ((sr & TIM_UIF) && (lo < 0x80000000))
+		hi++;
+
+	return(((u64)hi << 32) | lo);
+}
+
+/**
+ * @brief Get a monotonic timestamp
+ *
+ * @return u64 Number of nanoseconds since startup
+ */
+u64 systime_ns(void)
+{
+	// 1 tick = 31.25 ns
+	return((systime_ticks() * 125) >> 2);
+}
+
+/**
+ * @brief Get a monotonic timestamp for short intervals
+ *
+ * @return u32 Number of microseconds since startup (wraps after ~71 min)
+ */
+u32 systime_us(void)
+{
+	return (u32)(systime_ticks() / (SYSTIME_HZ / 1000000));
+}
+
+/**
+ * @brief Test if the wall-clock has been set
+ *
+ * @return integer True (1) if the RTC calendar is valid, False (0) if not
+ */
+int systime_valid(void)
+{
+	return (reg_rd(RTC_ICSR(RTC)) & RTC_INITS) ? 1 : 0;
+}
+
+/**
+ * @brief Get the wall-clock time
+ *
+ * @return u32 Number of seconds since 2000-01-01 00:00:00
+ */
+u32 systime_wall(void)
+{
+	u32 ns;
+
+	return _wall(&ns);
+}
+
+/**
+ * @brief Get the wall-clock time with a nanosecond resolution
+ *
+ * @return u64 Number of nanoseconds since 2000-01-01 00:00:00
+ */
+u64 systime_wall_ns(void)
+{
+	u32 sec, ns;
+
+	sec = _wall(&ns);
+	return(((u64)sec * NS_PER_SEC) + ns);
+}
+
+/**
+ * @brief Set the wall-clock time
+ *
+ * @param seconds Number of seconds since 2000-01-01 00:00:00
+ */
+void systime_set(u32 seconds)
+{
+	u32 lock, rate;
+
+	// Only the RTC interrupt must be held, the reader is still served
+	lock = irq_lock(IRQ_PRIO_TIME);
+	_rtc_write(seconds);
+	// Start a new calibration period from this point
+	rate = cal.rate;
+	last_wakeup = 0;
+	_anchor(systime_ticks(), seconds, 0, rate);
+	irq_unlock(lock);
+}
+
+/**
+ * @brief Get the current day and minute, in the format of the schedules
+ *
+ * @param day    Pointer to the day number (days since 2000-01-01)
+ * @param minute Pointer to the minute of the day (0 to 1439)
+ */
+void systime_date(u32 *day, uint *minute)
+{
+	u32 sec = systime_wall();
+
+	*day    = sec / 86400;
+	*minute = (uint)((sec % 86400) / 60);
+}
+
+/**
+ * @brief Save the state of the time base before STOP mode
+ *
+ * Called by the power manager with interrupts masked.
+ */
+void systime_suspend(void)
+{
+	lp_stop = _lptim_read();
+}
+
+/**
+ * @brief Advance the timer by the duration of the STOP period
+ *
+ * Called by the power manager with interrupts masked, after the wake. The
+ * LPTIM1 counter wraps after 2 seconds, the RTC wakeup timer limits STOP
+ * periods to one second.
+ */
+void systime_resume(void)
+{
+	u32 d, rate, ticks, cnt;
+
+	d = (_lptim_read() - lp_stop) & 0xFFFF;
+	if (d == 0)
+		return;
+	// ticks = d * rate / lp_hz, without 64 bits division
+	rate  = cal.rate;
+	ticks = (d * (rate / lp_hz)) + ((d * (rate % lp_hz)) / lp_hz);
+
+	cnt = reg_rd(TIM_CNT(TIM2));
+	reg_wr(TIM_CNT(TIM2), cnt + ticks);
+	if ((cnt + ticks) < cnt)
+		time_hi++;
+}
+
+/**
+ * @brief Active wait for a number of microseconds
+ *
+ * @param us Delay to wait (us)
+ */
+void delay_us(u32 us)
+{
+	u64 end;
+
+	end = systime_ticks() + ((u64)us * (SYSTIME_HZ / 1000000));
+	while (systime_ticks() < end)
+		;
+}
+
+/**
+ * @brief Active wait for a number of milliseconds
+ *
+ * @param ms Delay to wait (ms)
+ */
+void delay_ms(u32 ms)
+{
+	u64 end;
+
+	end = systime_ticks() + ((u64)ms * (SYSTIME_HZ / 1000));
+	while (systime_ticks() < end)
+		;
+}
+
+/**
+ * @brief Interrupt handler of the secure RTC (wakeup timer, each second)
+ *
+ */
+HOT_FCT void RTC_S_Handler(void)
+{
+	u64 now = systime_ticks();
+	u32 sec, frac, rate, d;
+
+	reg_wr(RTC_SCR(RTC), RTC_CWUTF);
+	power_mark(POWER_WAKE_RTC);
+
+	sec  = _rtc_read(&frac);
+	rate = cal.rate;
+	if (last_wakeup)
+	{
+		// Ticks of one RTC second, average over ~8 seconds
+		d = (u32)(now - last_wakeup);
+		if ((d > (SYSTIME_HZ - SYSTIME_CAL_TOL)) &&
+		    (d < (SYSTIME_HZ + SYSTIME_CAL_TOL)))
+			rate = rate - (rate >> 3) + (d >> 3);
+	}
+	last_wakeup = now;
+
+	_anchor(now, sec, frac, rate);
+}
+
+/**
+ * @brief Interrupt handler of TIM2 (counter overflow)
+ *
+ */
+HOT_FCT void TIM2_Handler(void)
+{
+	reg_wr(TIM_SR(TIM2), ~(u32)TIM_UIF);
+	time_hi++;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Publish a new anchor
+ *
+ * Interrupts are masked during the update (a few cycles) : a reader that
+ * preempts the writer would otherwise wait forever for an even sequence.
+ *
+ * @param ticks Timer value at the anchor
+ * @param sec   Wall-clock time at the anchor (seconds)
+ * @param frac  Sub-second part of the wall-clock (ns)
+ * @param rate  Number of timer ticks per second
+ */
+static void _anchor(u64 ticks, u32 sec, u32 frac, u32 rate)
+{
+	u32 mult = _mult(rate);
+	u32 irq;
+
+	irq = hw_irq_save();
+	cal.seq++;
+	cal.sec   = sec;
+	cal.frac  = frac;
+	cal.ticks = ticks;
+	cal.rate  = rate;
+	cal.mult  = mult;
+	cal.seq++;
+	hw_irq_restore(irq);
+}
+
+/**
+ * @brief Divide a 64 bits value by a 32 bits one (no runtime library)
+ *
+ * @param n   Dividend
+ * @param d   Divisor
+ * @param rem Pointer to the remainder
+ * @return u64 Quotient
+ */
+static u64 _div64(u64 n, u32 d, u32 *rem)
+{
+	u64 q = 0;
+	u64 r = 0;
+	uint i;
+
+	for (i = 0; i < 64; i++)
+	{
+		r = (r << 1) | (n >> 63);
+		n <<= 1;
+		q <<= 1;
+		if (r >= d)
+		{
+			r -= d;
+			q |= 1;
+		}
+	}
+	*rem = (u32)r;
+	return(q);
+}
+
+/**
+ * @brief Compute the duration of one tick
+ *
+ * @param rate Number of timer ticks per second
+ * @return u32 Nanoseconds per tick (fixed point, 24 bits fraction)
+ */
+static u32 _mult(u32 rate)
+{
+	u32 rem;
+
+	return (u32)_div64((u64)NS_PER_SEC << 24, rate, &rem);
+}
+
+/**
+ * @brief Convert a BCD byte
+ *
+ * @param v Value to convert (2 BCD digits)
+ * @return u32 Binary value
+ */
+static inline u32 _bcd(u32 v)
+{
+	return(((v >> 4) & 0xF) * 10 + (v & 0xF));
+}
+
+/**
+ * @brief Convert a binary value (0 to 99) to BCD
+ *
+ * @param v Value to convert
+ * @return u32 BCD value (2 digits)
+ */
+static inline u32 _tobcd(u32 v)
+{
+	return(((v / 10) << 4) | (v % 10));
+}
+
+/**
+ * @brief Get the number of days since 2000-01-01 for a date
+ *
+ * @param y Year (0 to 99 for 2000 to 2099)
+ * @param m Month (1 to 12)
+ * @param d Day of month (1 to 31)
+ * @return u32 Number of days
+ */
+static u32 _days(u32 y, u32 m, u32 d)
+{
+	static const u16 mdays[12] = {
+		0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+	u32 days;
+
+	if ((m < 1) || (m > 12))
+		m = 1;
+	days = (y * 365) + ((y + 3) / 4) + mdays[m - 1] + d - 1;
+	if ((m > 2) && ((y % 4) == 0))
+		days++;
+	return(days);
+}
+
+/**
+ * @brief Configure clock, prescalers and wakeup timer of the RTC
+ *
+ */
+static void _rtc_init(void)
+{
+	u32 bdcr, sel;
+
+	bdcr = reg_rd(RCC_BDCR(RCC));
+	if ((bdcr & BDCR_RTCEN) == 0)
+	{
+		// Use the 32.768kHz crystal, or LSI if it does not start
+		reg_wr(RCC_BDCR(RCC), bdcr | BDCR_LSEON);
+		if (_wait(RCC_BDCR(RCC), BDCR_LSERDY, 2000000) == 0)
+		{
+			sel = (1 << 8);
+			prediv_s = 255;
+		}
+		else
+		{
+			reg_clr(RCC_BDCR(RCC), BDCR_LSEON);
+			reg_set(RCC_BDCR(RCC), BDCR_LSION);
+			_wait(RCC_BDCR(RCC), BDCR_LSIRDY, 10000);
+			sel = (2 << 8);
+			prediv_s = 249;
+		}
+		bdcr = reg_rd(RCC_BDCR(RCC)) & ~(u32)BDCR_RTCSEL;
+		reg_wr(RCC_BDCR(RCC), bdcr | sel | BDCR_RTCEN);
+
+		// Prescalers (1 Hz calendar) and default date
+		reg_wr(RTC_WPR(RTC), 0xCA);
+		reg_wr(RTC_WPR(RTC), 0x53);
+		reg_set(RTC_ICSR(RTC), RTC_INIT);
+		_wait(RTC_ICSR(RTC), RTC_INITF, 10000);
+		reg_wr(RTC_PRER(RTC), prediv_s);
+		reg_wr(RTC_PRER(RTC), (127 << 16) | prediv_s);
+		reg_wr(RTC_TR(RTC), 0);
+		reg_wr(RTC_DR(RTC), (6 << 13) | (1 << 8) | 1);
+		reg_clr(RTC_ICSR(RTC), RTC_INIT);
+	}
+	else
+	{
+		reg_wr(RTC_WPR(RTC), 0xCA);
+		reg_wr(RTC_WPR(RTC), 0x53);
+	}
+	prediv_s = reg_rd(RTC_PRER(RTC)) & 0x7FFF;
+
+	// Wakeup each second (ck_spre) on the secure interrupt
+	reg_clr(RTC_CR(RTC), RTC_WUTE);
+	_wait(RTC_ICSR(RTC), RTC_WUTWF, 10000);
+	reg_wr(RTC_WUTR(RTC), 0);
+	reg_set(RTC_SECCFGR(RTC), RTC_WUTSEC | RTC_CALSEC | RTC_INITSEC);
+	reg_wr(RTC_SCR(RTC), RTC_CWUTF);
+	reg_set(RTC_CR(RTC), RTC_WUCKSEL | RTC_BYPSHAD | RTC_WUTIE | RTC_WUTE);
+	reg_wr(RTC_WPR(RTC), 0xFF);
+}
+
+/**
+ * @brief Start LPTIM1 as a free-running counter on the RTC oscillator
+ *
+ */
+static void _lptim_init(void)
+{
+	u32 sel;
+
+	// Same oscillator as the RTC : LSE (3) or LSI (4)
+	if ((reg_rd(RCC_BDCR(RCC)) & BDCR_RTCSEL) == (2 << 8))
+	{
+		sel   = 4;
+		lp_hz = 32000;
+	}
+	else
+	{
+		sel   = 3;
+		lp_hz = 32768;
+	}
+	reg_wr(RCC_CCIPR2(RCC), (reg_rd(RCC_CCIPR2(RCC)) & ~(7u << 8)) | (sel << 8));
+	reg_set(RCC_APB3ENR(RCC), (1 << 11));
+
+	reg_wr(LPTIM_CFGR(LPTIM1), 0);
+	reg_wr(LPTIM_CR(LPTIM1),   LPTIM_ENABLE);
+	reg_wr(LPTIM_ARR(LPTIM1),  0xFFFF);
+	reg_wr(LPTIM_CR(LPTIM1),   LPTIM_ENABLE | LPTIM_CNTSTRT);
+	lp_stop = 0;
+}
+
+/**
+ * @brief Read the LPTIM1 counter
+ *
+ * The counter is clocked asynchronously, it is read until two consecutive
+ * values are equal.
+ *
+ * @return u32 Counter value (16 bits)
+ */
+static u32 _lptim_read(void)
+{
+	u32 a, b;
+
+	b = reg_rd(LPTIM_CNT(LPTIM1));
+	do
+	{
+		a = b;
+		b = reg_rd(LPTIM_CNT(LPTIM1));
+	} while (a != b);
+	return(a & 0xFFFF);
+}
+
+/**
+ * @brief Read the RTC calendar
+ *
+ * Shadow registers are bypassed, so the read is repeated until the
+ * sub-second counter is stable.
+ *
+ * @param frac Pointer to the sub-second part (ns)
+ * @return u32 Number of seconds since 2000-01-01
+ */
+static u32 _rtc_read(u32 *frac)
+{
+	u32 ssr, tr, dr, sec;
+
+	do
+	{
+		ssr = reg_rd(RTC_SSR(RTC));
+		tr  = reg_rd(RTC_TR(RTC));
+		dr  = reg_rd(RTC_DR(RTC));
+	} while (ssr != reg_rd(RTC_SSR(RTC)));
+
+	if (ssr > prediv_s)
+		ssr = prediv_s;
+	*frac = (prediv_s - ssr) * (NS_PER_SEC / (prediv_s + 1));
+
+	sec  = _days(_bcd(dr >> 16), _bcd((dr >> 8) & 0x1F), _bcd(dr & 0x3F));
+	sec *= 86400;
+	sec += _bcd((tr >> 16) & 0x3F) * 3600;
+	sec += _bcd((tr >>  8) & 0x7F) * 60;
+	sec += _bcd(tr & 0x7F);
+	return(sec);
+}
+
+/**
+ * @brief Update the RTC calendar
+ *
+ * @param sec Number of seconds since 2000-01-01
+ */
+static void _rtc_write(u32 sec)
+{
+	u32 days, y, m, len;
+
+	days = sec / 86400;
+	sec  = sec % 86400;
+	for (y = 0; y < 99; y++)
+	{
+		len = (y % 4) ? 365 : 366;
+		if (days < len)
+			break;
+		days -= len;
+	}
+	for (m = 1; m < 12; m++)
+	{
+		len = _days(y, m + 1, 1) - _days(y, m, 1);
+		if (days < len)
+			break;
+		days -= len;
+	}
+
+	reg_wr(RTC_WPR(RTC), 0xCA);
+	reg_wr(RTC_WPR(RTC), 0x53);
+	reg_set(RTC_ICSR(RTC), RTC_INIT);
+	_wait(RTC_ICSR(RTC), RTC_INITF, 10000);
+	reg_wr(RTC_TR(RTC), (_tobcd(sec / 3600) << 16) |
+	                    (_tobcd((sec / 60) % 60) << 8) |
+	                     _tobcd(sec % 60));
+	// Weekday : 1 is Monday, 2000-01-01 was a Saturday
+	reg_wr(RTC_DR(RTC), (_tobcd(y) << 16) |
+	                    ((((_days(y, m, days + 1) + 5) % 7) + 1) << 13) |
+	                    (_tobcd(m) << 8) |
+	                     _tobcd(days + 1));
+	reg_clr(RTC_ICSR(RTC), RTC_INIT);
+	reg_wr(RTC_WPR(RTC), 0xFF);
+}
+
+/**
+ * @brief Wait until some bits of a register are set
+ *
+ * @param reg  Address of the register
+ * @param mask Mask of the bits to wait for
+ * @param us   Timeout (us)
+ * @return integer Zero on success, -1 on timeout
+ */
+static int _wait(u32 reg, u32 mask, u32 us)
+{
+	u32 start = systime_us();
+
+	while ((reg_rd(reg) & mask) != mask)
+	{
+		if ((systime_us() - start) > us)
+			return(-1);
+	}
+	return(0);
+}
+
+/**
+ * @brief Interpolate the wall-clock time from the last anchor
+ *
+ * @param ns Pointer to the sub-second part (ns)
+ * @return u32 Number of seconds since 2000-01-01
+ */
+static u32 _wall(u32 *ns)
+{
+	u32 seq, sec, frac, rate, mult, r;
+	u64 at, delta;
+
+	do
+	{
+		seq  = cal.seq;
+		sec  = cal.sec;
+		frac = cal.frac;
+		at   = cal.ticks;
+		rate = cal.rate;
+		mult = cal.mult;
+	} while ((seq & 1) || (seq != cal.seq));
+
+	delta = systime_ticks() - at;
+	if (delta >> 32)
+		sec += (u32)_div64(delta, rate, &r);
+	else
+	{
+		sec += (u32)delta / rate;
+		r    = (u32)delta % rate;
+	}
+	frac += (u32)(((u64)r * mult) >> 24);
+	if (frac >= NS_PER_SEC)
+	{
+		frac -= NS_PER_SEC;
+		sec++;
+	}
+	*ns = frac;
+	return(sec);
+}
+/* EOF */
@@ -0,0 +1,45 @@
+/**
+ * @file  systime.h
+ * @brief Definitions and prototypes for the monotonic and wall-clock time
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef SYSTIME_H
+#define SYSTIME_H
+#include "types.h"
+
+// TIM2 kernel clock (HSI, no APB1 prescaler)
+#define SYSTIME_HZ    32000000
+#define SYSTIME_IRQ   45
+// Secure RTC interrupt (wakeup timer, 1 Hz)
+#define SYSTIME_RTC_IRQ 3
+
+// Accepted deviation of the timer clock against the RTC (1/64, ~1.5%)
+#define SYSTIME_CAL_TOL (SYSTIME_HZ / 64)
+
+void systime_init(void);
+u64  systime_ticks(void);
+u64  systime_ns(void);
+u32  systime_us(void);
+int  systime_valid(void);
+u32  systime_wall(void);
+u64  systime_wall_ns(void);
+void systime_set(u32 seconds);
+void systime_date(u32 *day, uint *minute);
+void systime_suspend(void);
+void systime_resume(void);
+
+
+void delay_us(u32 us);
+void delay_ms(u32 ms);
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file  trace.c
+ * @brief Binary trace buffer (enter/exit/mark/counter events)
+ *
+ * Events are written by the inline functions of trace.h into a ring at a
+ * fixed address of SRAM3, without lock and without formatting. The ring is
+ * read by the debugger (scripts/trace.gdb) or saved by the host build
+ * (SIM_TRACE), then converted with scripts/trace2json.py.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "hardware.h"
+#include "systime.h"
+#include "trace.h"
+#ifdef HOST
+#include <time.h>
+
+trace_ring trace_ram;
+#endif
+
+static void _cfg_ram(void);
+
+/**
+ * @brief Initialize the trace buffer (empty) and start recording
+ *
+ */
+void trace_init(void)
+{
+	trace_ring *t = TRACE_RING;
+	uint i;
+
+	_cfg_ram();
+#ifndef HOST
+	// DEMCR : Set TRCENA to enable DWT, then start the cycle counter
+	reg_set(SCB_DEMCR, (1 << 24));
+	reg_set(DWT_CTRL, (1 << 0));
+	t->freq = SYSTIME_HZ;
+#else
+	t->freq = 1000000000;
+#endif
+	t->stop  = 1;
+	t->head  = 0;
+	t->size  = TRACE_SIZE;
+	for (i = 0; i < TRACE_SIZE; i++)
+	{
+		t->rec[i].time = 0;
+		t->rec[i].info = 0;
+	}
+	t->magic = TRACE_MAGIC;
+	t->stop  = 0;
+
+	trace_mark(TRACE_ID_BOOT, 0);
+}
+
+/**
+ * @brief Restart recording after trace_stop
+ *
+ */
+void trace_start(void)
+{
+	TRACE_RING->stop = 0;
+}
+
+/**
+ * @brief Freeze the trace buffer
+ *
+ * Events written after this call are ignored, the ring keeps the events
+ * that precede a problem until it is read by the debugger.
+ */
+void trace_stop(void)
+{
+	TRACE_RING->stop = 1;
+}
+
+#ifdef HOST
+/**
+ * @brief Read the time of host events
+ *
+ * @return u32 Monotonic time in nanoseconds (wraps)
+ */
+u32 trace_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u32)((u32)ts.tv_sec * 1000000000u + (u32)ts.tv_nsec);
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Give access to the trace buffer to the non-secure world
+ *
+ * The blocks of SRAM3 used by the ring are set non-secure into MPCBB3, the
+ * secure firmware accesses them with the non-secure alias (TRACE_ADDR).
+ */
+static void _cfg_ram(void)
+{
+#if defined(RUN_SEC) && !defined(HOST)
+	u32 first = ((TRACE_ADDR & 0xFFFFF) - 0x50000) / 512;
+	u32 blk;
+
+	for (blk = first; blk < (first + TRACE_BLOCKS); blk++)
+		reg_clr(MPCBB_SECCFGR(GTZC1_MPCBB3(GTZC1), blk / 32), (1u << (blk % 32)));
+#endif
+}
+/* EOF */
@@ -0,0 +1,170 @@
+/**
+ * @file  trace.h
+ * @brief Definitions and prototypes for the binary trace buffer
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ *
+ * This header is also used by the non-secure application : it only
+ * depends on types.h.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+#include "types.h"
+
+// Number of events kept (power of two), the oldest ones are overwritten
+#define TRACE_SIZE  1024
+#define TRACE_MAGIC 0x45435254 /* "TRCE" */
+/* The ring is at the end of SRAM3 (0x2200 bytes reserved by linker
+ * scripts). These blocks are non-secure, both worlds use the NS alias. */
+#define TRACE_ADDR   0x2009DE00
+#define TRACE_BLOCKS 17 /* Number of SRAM blocks (512 bytes) */
+#define TRACE_CYCCNT 0xE0001004
+
+/* Event types (2 upper bits of info) */
+#define TRACE_ENTER   0
+#define TRACE_EXIT    1
+#define TRACE_MARK    2
+#define TRACE_COUNT   3
+#define TRACE_NS      (1u << 29) /* Event of the non-secure world */
+#define TRACE_ID_MAX  0x1FFF
+
+/* Trace points (names are read from this file by trace2json.py) */
+#define TRACE_ID_BOOT         1
+#define TRACE_ID_FDCAN_IT0    2
+#define TRACE_ID_FDCAN_IT1    3
+#define TRACE_ID_CAN_QUEUE    4
+#define TRACE_ID_JOURNAL      5
+#define TRACE_ID_UPLINK_SEND  6
+#define TRACE_ID_BENCH        7
+#define TRACE_ID_PIPE         8
+#define TRACE_ID_PIPE_MISS    9
+/* Identifiers of the non-secure application */
+#define TRACE_ID_APP_START    0x100
+#define TRACE_ID_APP_NONCE    0x101
+
+#ifdef RUN_SEC
+#define TRACE_WORLD 0
+#else
+#define TRACE_WORLD TRACE_NS
+#endif
+
+/**
+ * @brief Event of the trace buffer
+ */
+typedef struct trace_rec
+{
+	u32 time; // Cycle counter (or host time)
+	u32 info; // Type (31-30), world (29), identifier (28-16), argument
+} trace_rec;
+
+/**
+ * @brief Trace buffer : header and ring of events
+ */
+typedef struct trace_ring
+{
+	u32 magic;  // TRACE_MAGIC when initialized
+	u32 head;   // Number of events written since trace_init
+	vu32 stop;  // Non-zero when the ring is frozen (trace_stop)
+	u32 freq;   // Frequency of the time counter (Hz)
+	u32 size;   // Number of events of the ring (TRACE_SIZE)
+	u32 rsv[3];
+	trace_rec rec[TRACE_SIZE];
+} trace_ring;
+
+#ifdef HOST
+extern trace_ring trace_ram;
+u32  trace_time(void);
+#define TRACE_RING (&trace_ram)
+#else
+#define TRACE_RING ((trace_ring *)TRACE_ADDR)
+#endif
+
+void trace_init (void);
+void trace_start(void);
+void trace_stop (void);
+
+/**
+ * @brief Write one event into the trace buffer
+ *
+ * This function can be called from any context (interrupts, secure or
+ * non-secure code) : the slot is reserved with an atomic increment. The
+ * event is written after the reservation, when an interrupt also writes
+ * events the ring order may differ from the time order (trace2json.py
+ * sorts events by time).
+ *
+ * @param info Event type, identifier and argument
+ */
+static inline void trace_event(u32 info)
+{
+#ifndef TRACE_OFF
+	trace_ring *t = TRACE_RING;
+	trace_rec  *r;
+	u32 n;
+
+	if (t->stop)
+		return;
+	n = __atomic_fetch_add(&t->head, 1, __ATOMIC_RELAXED);
+	r = &t->rec[n & (TRACE_SIZE - 1)];
+#ifdef HOST
+	r->time = trace_time();
+#else
+	r->time = *(volatile u32 *)TRACE_CYCCNT;
+#endif
+	r->info = info;
+#else
+	(void)info;
+#endif
+}
+
+/**
+ * @brief Mark the beginning of a duration (function, interrupt ...)
+ *
+ * @param id Identifier of the trace point (TRACE_ID_*)
+ */
+static inline void trace_enter(uint id)
+{
+	trace_event(((u32)TRACE_ENTER << 30) | TRACE_WORLD | ((u32)id << 16));
+}
+
+/**
+ * @brief Mark the end of a duration started by trace_enter
+ *
+ * @param id Identifier of the trace point (TRACE_ID_*)
+ */
+static inline void trace_exit(uint id)
+{
+	trace_event(((u32)TRACE_EXIT << 30) | TRACE_WORLD | ((u32)id << 16));
+}
+
+/**
+ * @brief Record an instant event, with an argument
+ *
+ * @param id  Identifier of the trace point (TRACE_ID_*)
+ * @param arg Value associated with the event (16 bits)
+ */
+static inline void trace_mark(uint id, uint arg)
+{
+	trace_event(((u32)TRACE_MARK << 30) | TRACE_WORLD | ((u32)id << 16) | (arg & 0xFFFF));
+}
+
+/**
+ * @brief Record the value of a counter (queue level, free blocks ...)
+ *
+ * @param id    Identifier of the counter (TRACE_ID_*)
+ * @param value New value of the counter (16 bits)
+ */
+static inline void trace_count(uint id, uint value)
+{
+	trace_event(((u32)TRACE_COUNT << 30) | TRACE_WORLD | ((u32)id << 16) | (value & 0xFFFF));
+}
+
+#endif
@@ -16,17 +16,38 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#ifdef HOST
+/* Host build (LP64) : long is 64 bits */
+typedef unsigned int   u32;
+typedef signed   int   s32;
+typedef volatile unsigned int   vu32;
+#else
 typedef unsigned long  u32;
+typedef signed   long  s32;
+typedef volatile unsigned long  vu32;
+#endif
+typedef unsigned long long u64;
+typedef signed   long long s64;
 typedef unsigned short u16;
 typedef unsigned char  u8;
 typedef signed   char  s8;
 typedef signed   short s16;
-typedef signed   long  s32;
-typedef volatile unsigned long  vu32;
 typedef volatile unsigned short vu16;
 typedef volatile unsigned char  vu8;
 typedef volatile signed   short vs16;
 
 typedef unsigned int uint;
+/* Integer with the size of a pointer */
+typedef unsigned long uptr;
+
+/* Hot functions : built with the optimization level of the "fast" and
+ * "release" profiles (PROFILE_HOT, see doc/build_profiles.md) */
+#if defined(PROFILE_HOT) && !defined(HOST)
+#define HOT_STR(x) #x
+#define HOT_OPT(x) HOT_STR(x)
+#define HOT_FCT __attribute__((optimize(HOT_OPT(PROFILE_HOT))))
+#else
+#define HOT_FCT
+#endif
 
 #endif
@@ -0,0 +1,470 @@
+/**
+ * @file  update.c
+ * @brief Dual-bank (A/B) firmware update engine
+ *
+ * A new firmware image is received over the framing channel and written
+ * into the inactive flash bank while it streams in : data are programmed
+ * quad-word by quad-word (sectors are erased when the first quad-word is
+ * written) and hashed on the fly, so the image is never buffered in SRAM.
+ * When the last byte has been received, the signed header sent by the
+ * host (same format as for secure boot) is checked against the computed
+ * digest. The banks are then swapped using the SWAP_BANK option byte.
+ *
+ * The first boots of the new bank are "trial" boots, tracked into a backup
+ * register. If the application is not confirmed after UPD_MAX_ATTEMPTS
+ * boots, or fails verification, banks are swapped back (rollback).
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "apb.h"
+#include "boot.h"
+#include "config.h"
+#include "cred.h"
+#include "driver/flash.h"
+#include "driver/hash.h"
+#include "driver/uart.h"
+#include "frame.h"
+#include "hardware.h"
+#include "log.h"
+#include "types.h"
+#include "update.h"
+
+/* States of the receive engine */
+#define ST_IDLE  0
+#define ST_RECV  1
+#define ST_READY 2
+
+/* States stored into backup register */
+#define BKP_MAGIC    0xA5000000
+#define BKP_NONE     0
+#define BKP_TRIAL    1
+#define BKP_ROLLBACK 2
+
+typedef struct update_ctx
+{
+	uint state;
+	u32  size;
+	u32  version;
+	u32  offset;
+	u32  qw[4];
+	uint qw_len;
+} update_ctx;
+
+static void _handler(u8 type, u8 seq, const u8 *data, uint len);
+static void _begin (u8 type, u8 seq, const u8 *data, uint len);
+static void _data  (u8 type, u8 seq, const u8 *data, uint len);
+static void _end   (u8 type, u8 seq, const u8 *data, uint len);
+static int  _program(void);
+static void _reply (u8 type, u8 seq, u8 status);
+static int  _swap  (void);
+static u32  _le32  (const u8 *p);
+static u32  _bkp_get(uint *attempts);
+static void _bkp_set(u32 state, uint attempts);
+
+static update_ctx ctx;
+
+/**
+ * @brief Initialize the update engine
+ *
+ */
+void update_init(void)
+{
+	ctx.state  = ST_IDLE;
+	ctx.offset = 0;
+	ctx.qw_len = 0;
+
+	flash_init();
+	hash_init();
+	frame_register(FRAME_CLASS_UPDATE, _handler);
+}
+
+/**
+ * @brief Check state of a previous update, called early on each boot
+ *
+ * When the current bank is on trial, the number of boot attempts is
+ * incremented and a rollback is made if too many attempts failed.
+ */
+void update_boot(void)
+{
+	uint attempts;
+	u32  state;
+
+	state = _bkp_get(&attempts);
+	if (state == BKP_ROLLBACK)
+	{
+		log_print(0, " -> %{WARNING%}: Update rolled back\n", LOG_YLW);
+		_bkp_set(BKP_NONE, 0);
+		return;
+	}
+	if (state != BKP_TRIAL)
+		return;
+
+	attempts++;
+	if (attempts > UPD_MAX_ATTEMPTS)
+	{
+		log_print(0, " -> %{ERROR%}: Update not confirmed, rollback\n", 1);
+		update_rollback();
+	}
+	_bkp_set(BKP_TRIAL, attempts);
+	log_print(0, " * Trial boot of new firmware (%d/%d)\n", attempts, UPD_MAX_ATTEMPTS);
+}
+
+/**
+ * @brief Test if the current bank is running on trial
+ *
+ * @return True if the current firmware has not been confirmed yet
+ */
+int update_pending(void)
+{
+	uint attempts;
+
+	return (_bkp_get(&attempts) == BKP_TRIAL);
+}
+
+/**
+ * @brief Confirm the current firmware (end of trial)
+ *
+ */
+void update_confirm(void)
+{
+	if ( ! update_pending())
+		return;
+	_bkp_set(BKP_NONE, 0);
+	log_print(LOG_INF, " * New firmware confirmed\n");
+}
+
+/**
+ * @brief Swap back to the previous bank and reset
+ *
+ */
+void update_rollback(void)
+{
+	_bkp_set(BKP_ROLLBACK, 0);
+	if (_swap() < 0)
+		return;
+	uart_flush();
+	hw_reset();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Handler of update frames
+ *
+ * @param type Type of the received frame
+ * @param seq  Sequence number
+ * @param data Pointer to the payload
+ * @param len  Length of the payload
+ */
+static void _handler(u8 type, u8 seq, const u8 *data, uint len)
+{
+	switch (type)
+	{
+		case UPD_BEGIN:
+			_begin(type, seq, data, len);
+			break;
+		case UPD_DATA:
+			_data(type, seq, data, len);
+			break;
+		case UPD_END:
+			_end(type, seq, data, len);
+			break;
+		case UPD_SWAP:
+			if (ctx.state != ST_READY)
+			{
+				_reply(type, seq, FRAME_ST_STATE);
+				break;
+			}
+			_bkp_set(BKP_TRIAL, 0);
+			boot_invalidate();
+			apb_handover();
+			cred_handover();
+			config_handover();
+			if (_swap() < 0)
+			{
+				// Banks not swapped : no trial, restart on this bank
+				_bkp_set(BKP_NONE, 0);
+				_reply(type, seq, FRAME_ST_ERR);
+			}
+			else
+				_reply(type, seq, FRAME_ST_OK);
+			// Services stopped by the handovers, restart them
+			uart_flush();
+			hw_reset();
+			break;
+		case UPD_ABORT:
+			ctx.state = ST_IDLE;
+			flash_lock();
+			_reply(type, seq, FRAME_ST_OK);
+			break;
+		case UPD_STATUS:
+			_reply(type, seq, (u8)ctx.state);
+			break;
+		default:
+			_reply(type, seq, FRAME_ST_UNKNOWN);
+			break;
+	}
+}
+
+/**
+ * @brief Start reception of a new image
+ *
+ * Payload : u32 size, u32 version
+ */
+static void _begin(u8 type, u8 seq, const u8 *data, uint len)
+{
+	u32 size;
+
+	if (len != 8)
+	{
+		_reply(type, seq, FRAME_ST_BADARG);
+		return;
+	}
+	size = _le32(data);
+	// End of the bank is kept for credentials and anti-passback (boot.h)
+	if ((size == 0) || (size > BOOT_IMAGE_END) || (size % FLASH_QW_SIZE))
+	{
+		_reply(type, seq, FRAME_ST_BADARG);
+		return;
+	}
+	if (flash_unlock() != FLASH_OK)
+	{
+		_reply(type, seq, FRAME_ST_ERR);
+		return;
+	}
+
+	ctx.size    = size;
+	ctx.version = _le32(data + 4);
+	ctx.offset  = 0;
+	ctx.qw_len  = 0;
+	ctx.state   = ST_RECV;
+	hash_begin();
+
+	log_print(LOG_INF, "Update: receive %d bytes (v%d)\n", ctx.size, ctx.version);
+	_reply(type, seq, FRAME_ST_OK);
+}
+
+/**
+ * @brief Receive a chunk of the image
+ *
+ * Payload : u32 offset, data. Chunks must be received in order, an already
+ * received chunk (retransmission) is acknowledged without being written.
+ * The reply always contains the offset of the next expected byte.
+ */
+static void _data(u8 type, u8 seq, const u8 *data, uint len)
+{
+	u32  off;
+	uint skip;
+
+	if (ctx.state != ST_RECV)
+	{
+		_reply(type, seq, FRAME_ST_STATE);
+		return;
+	}
+	if (len < 4)
+	{
+		_reply(type, seq, FRAME_ST_BADARG);
+		return;
+	}
+	off   = _le32(data);
+	data += 4;
+	len  -= 4;
+
+	// Skip the part that has already been received
+	if (off < ctx.offset)
+	{
+		skip = (uint)(ctx.offset - off);
+		if (skip >= len)
+		{
+			_reply(type, seq, FRAME_ST_OK);
+			return;
+		}
+		data += skip;
+		len  -= skip;
+		off   = ctx.offset;
+	}
+	if ((off != ctx.offset) || ((off + len) > ctx.size))
+	{
+		_reply(type, seq, FRAME_ST_BADARG);
+		return;
+	}
+
+	hash_update(data, len);
+	while (len)
+	{
+		((u8 *)ctx.qw)[ctx.qw_len++] = *data++;
+		ctx.offset++;
+		len--;
+		if (ctx.qw_len < FLASH_QW_SIZE)
+			continue;
+		if (_program() < 0)
+		{
+			log_print(0, "Update: %{flash error%} at %32x\n", 1, ctx.offset);
+			ctx.state = ST_IDLE;
+			flash_lock();
+			_reply(type, seq, FRAME_ST_ERR);
+			return;
+		}
+	}
+	_reply(type, seq, FRAME_ST_OK);
+}
+
+/**
+ * @brief End of image, check the signed header
+ *
+ * Payload : boot_hdr
+ */
+static void _end(u8 type, u8 seq, const u8 *data, uint len)
+{
+	u8  digest[HASH_SHA256_LEN];
+	boot_hdr hdr;
+	uint i;
+
+	if ((ctx.state != ST_RECV) || (ctx.offset != ctx.size))
+	{
+		_reply(type, seq, FRAME_ST_STATE);
+		return;
+	}
+	if (len != sizeof(boot_hdr))
+	{
+		_reply(type, seq, FRAME_ST_BADARG);
+		return;
+	}
+	for (i = 0; i < sizeof(boot_hdr); i++)
+		((u8 *)&hdr)[i] = data[i];
+
+	hash_final(digest);
+	flash_lock();
+	ctx.state = ST_IDLE;
+
+	if ((hdr.magic != BOOT_MAGIC) || (hdr.size != ctx.size) ||
+	    ( ! hash_equal(digest, hdr.digest, HASH_SHA256_LEN)) ||
+	    ( ! boot_auth(&hdr)) )
+	{
+		log_print(0, "Update: %{image rejected%}\n", 1);
+		_reply(type, seq, FRAME_ST_ERR);
+		return;
+	}
+	ctx.state = ST_READY;
+	log_print(LOG_INF, "Update: image verified, ready to swap\n");
+	_reply(type, seq, FRAME_ST_OK);
+}
+
+/**
+ * @brief Program the current quad-word into inactive bank
+ *
+ * @return 0 on success, -1 on error
+ */
+static int _program(void)
+{
+	u32 pos, addr;
+
+	pos  = ctx.offset - FLASH_QW_SIZE;
+	addr = flash_inactive(pos);
+	// First quad-word of a sector, erase it
+	if ((pos % FLASH_SECT_SIZE) == 0)
+		if (flash_erase(addr) != FLASH_OK)
+			return(-1);
+	if (flash_program(addr, ctx.qw) != FLASH_OK)
+		return(-1);
+	ctx.qw_len = 0;
+	return(0);
+}
+
+/**
+ * @brief Send a reply with a status and the next expected offset
+ *
+ * @param type   Type of the request frame
+ * @param seq    Sequence number of the request frame
+ * @param status Status code
+ */
+static void _reply(u8 type, u8 seq, u8 status)
+{
+	u8 buf[5];
+
+	buf[0] = status;
+	buf[1] = (u8)(ctx.offset >>  0);
+	buf[2] = (u8)(ctx.offset >>  8);
+	buf[3] = (u8)(ctx.offset >> 16);
+	buf[4] = (u8)(ctx.offset >> 24);
+	frame_send((u8)(type | FRAME_REPLY), seq, buf, 5);
+}
+
+/**
+ * @brief Toggle SWAP_BANK option byte (active at next reset)
+ *
+ * @return integer Zero on success, negative value on error
+ */
+static int _swap(void)
+{
+	u32 v;
+
+	log_print(LOG_INF, "Update: swap banks and reset\n");
+
+	if (flash_opt_unlock() != FLASH_OK)
+		return(-1);
+	v = reg_rd(FLASH_OPTSR_PRG(FLASH));
+	reg_wr(FLASH_OPTSR_PRG(FLASH), v ^ (1u << 31));
+	if (flash_opt_start() != FLASH_OK)
+	{
+		flash_opt_lock();
+		log_print(0, " -> %{ERROR%}: Bank swap failed\n", 1);
+		return(-1);
+	}
+	flash_opt_lock();
+	return(0);
+}
+
+/**
+ * @brief Decode a little-endian 32 bits word
+ *
+ * @param p Pointer to the first byte
+ * @return u32 Decoded value
+ */
+static u32 _le32(const u8 *p)
+{
+	return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+/**
+ * @brief Read update state from backup register
+ *
+ * @param attempts Pointer to a variable where to store attempts count
+ * @return u32 State (BKP_*)
+ */
+static u32 _bkp_get(uint *attempts)
+{
+	u32 v;
+
+	v = hw_bkp_read(UPD_BKP_REG);
+	if ((v & 0xFF000000) != BKP_MAGIC)
+	{
+		*attempts = 0;
+		return(BKP_NONE);
+	}
+	*attempts = (uint)(v & 0xFF);
+	return((v >> 8) & 0xFF);
+}
+
+/**
+ * @brief Write update state into backup register
+ *
+ * @param state    New state (BKP_*)
+ * @param attempts Number of boot attempts
+ */
+static void _bkp_set(u32 state, uint attempts)
+{
+	hw_bkp_write(UPD_BKP_REG, BKP_MAGIC | (state << 8) | (attempts & 0xFF));
+}
+/* EOF */
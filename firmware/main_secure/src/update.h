@@ -0,0 +1,38 @@
+/**
+ * @file  update.h
+ * @brief Definitions and prototypes for the dual-bank firmware update
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef UPDATE_H
+#define UPDATE_H
+#include "types.h"
+
+/* Frames of the update class */
+#define UPD_BEGIN  0x10
+#define UPD_DATA   0x11
+#define UPD_END    0x12
+#define UPD_SWAP   0x13
+#define UPD_ABORT  0x14
+#define UPD_STATUS 0x15
+
+/* Backup register used to track a trial boot */
+#define UPD_BKP_REG      0
+#define UPD_MAX_ATTEMPTS 3
+
+void update_init(void);
+void update_boot(void);
+int  update_pending(void);
+void update_confirm(void);
+void update_rollback(void);
+
+#endif
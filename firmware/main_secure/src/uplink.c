@@ -0,0 +1,555 @@
+/**
+ * @file  uplink.c
+ * @brief Uplink of journal events to the site controller (UDP)
+ *
+ * Journal records are grouped into datagrams up to the Ethernet MTU, with
+ * timestamps and credential identifiers encoded as deltas (see uplink.md).
+ * Up to a window of datagrams is sent without waiting : the collector
+ * acknowledges the offset of the next record it expects, which releases
+ * all the datagrams before it. When no acknowledgement arrives in time,
+ * records are sent again from the last acknowledged offset (go-back-N).
+ * After a few timeouts the collector is considered lost; its address is
+ * resolved again (ARP) and the transfer resumes from the same offset.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#include "driver/eth.h"
+#include "journal.h"
+#include "log.h"
+#include "systime.h"
+#include "trace.h"
+#include "uplink.h"
+
+// Headers of a datagram : Ethernet, IPv4 and UDP
+#define NET_HDR   42
+#define ETH_IPV4  0x0800
+#define ETH_ARP   0x0806
+
+/* States of the uplink */
+#define ST_ARP 0
+#define ST_RUN 1
+
+/**
+ * @brief Datagram of the window
+ *
+ * Headers and payload are sent as two segments. The slot can not be
+ * reused before its transmission is done (busy), even if acknowledged.
+ */
+typedef struct ul_slot
+{
+	u32 first;        // Offset of the first record
+	u32 end;          // Offset after the last record
+	u16 len;          // Length of the payload
+	volatile u8 busy; // Given to the MAC
+	u8  hdr[NET_HDR];
+	u8  data[UPLINK_PAYLOAD];
+} ul_slot;
+
+static void _send(ul_slot *s);
+static void _input(const eth_frame *f);
+static void _arp_input(const u8 *p, uint len);
+static void _arp_send(uint op, const u8 *mac, u32 ip);
+static void _ack(const u8 *p, uint len);
+static void _done(void *arg);
+static u8  *_varint(u8 *p, u32 v);
+static void _put16(u8 *p, u32 v);
+static void _put32(u8 *p, u32 v);
+static void _put16be(u8 *p, u32 v);
+static void _put32be(u8 *p, u32 v);
+static u32  _get32be(const u8 *p);
+
+static ul_slot slots[UPLINK_WINDOW];
+static uint slot_first; // Oldest datagram of the window
+static uint inflight;   // Datagrams sent and not acknowledged
+static u8   arp_buf[NET_HDR];
+static volatile u8 arp_busy;
+
+static int  state;
+static u8   mac[6];     // Our MAC address
+static u8   peer[6];    // MAC address of the collector
+static u32  ip_addr;    // Our IPv4 address
+static u32  ip_server;  // IPv4 address of the collector
+static u16  ip_id;
+static u32  session;    // Identifier of this run of the firmware
+static u32  acked;      // Next offset expected by the collector
+static u32  next;       // Next offset to send
+static uint window;     // Window granted by the collector
+static uint lost;       // Consecutive timeouts
+static u32  sent_us;    // Time of the last progress of the window
+static u32  wait_us;    // Time since records are waiting
+static u32  arp_us;     // Time of the last ARP request
+
+uplink_stats uplink_stat;
+
+/**
+ * @brief Initialize the uplink, with default addresses
+ *
+ */
+void uplink_init(void)
+{
+	uint i;
+
+	for (i = 0; i < UPLINK_WINDOW; i++)
+		slots[i].busy = 0;
+	arp_busy = 0;
+	eth_addr(mac);
+	// Differs between runs, lets the collector detect a restart
+	session = (u32)systime_ticks() ^ (systime_wall() << 8);
+	acked = next = journal_tail();
+	// 192.168.1.10, collector on 192.168.1.1
+	uplink_config(0xC0A8010A, 0xC0A80101);
+}
+
+/**
+ * @brief Set the addresses, the collector is resolved again
+ *
+ * @param ip     IPv4 address of this device
+ * @param server IPv4 address of the collector
+ */
+void uplink_config(u32 ip, u32 server)
+{
+	ip_addr   = ip;
+	ip_server = server;
+	state  = ST_ARP;
+	arp_us = systime_us() - UPLINK_ARP_US;
+}
+
+/**
+ * @brief Process received frames, send records, handle timeouts
+ *
+ * Called from the main loop, after eth_poll().
+ */
+void uplink_poll(void)
+{
+	eth_frame f;
+	ul_slot *s;
+	u32  now, head;
+
+	while (eth_recv(&f) == 0)
+	{
+		_input(&f);
+		eth_release(&f);
+	}
+
+	now = systime_us();
+	if (state == ST_ARP)
+	{
+		if ((now - arp_us) >= UPLINK_ARP_US)
+		{
+			arp_us = now;
+			_arp_send(1, 0, ip_server);
+		}
+		return;
+	}
+
+	// No acknowledgement in time : send the window again
+	if (inflight && ((now - sent_us) >= UPLINK_RTO_US))
+	{
+		uplink_stat.retrans++;
+		next = acked;
+		inflight = 0;
+		sent_us = now;
+		if (++lost >= UPLINK_LOST)
+		{
+			log_print(0, " * Uplink: collector lost\n");
+			uplink_config(ip_addr, ip_server);
+			return;
+		}
+	}
+
+	head = journal_head();
+	if (next == head)
+	{
+		wait_us = now;
+		return;
+	}
+	// Records overwritten before being sent
+	if ((s32)(journal_tail() - next) > 0)
+	{
+		uplink_stat.lost += journal_tail() - next;
+		next = journal_tail();
+		if ((s32)(next - acked) > 0)
+			acked = next;
+	}
+	// Small batches wait for more records (up to UPLINK_FLUSH_US)
+	if (((head - next) < ((UPLINK_PAYLOAD - UPLINK_HDR) / UPLINK_REC_MAX)) &&
+	    ((now - wait_us) < UPLINK_FLUSH_US))
+		return;
+
+	while ((inflight < window) && (next != head))
+	{
+		s = &slots[(slot_first + inflight) % UPLINK_WINDOW];
+		if (s->busy)
+			break;
+		s->first = next;
+		s->len   = (u16)uplink_pack(&next, head, s->data, UPLINK_PAYLOAD);
+		s->end   = next;
+		if (s->len == 0)
+			break;
+		_send(s);
+		if (inflight++ == 0)
+			sent_us = now;
+	}
+}
+
+/**
+ * @brief Get the offset of the next record expected by the collector
+ *
+ * All records before this offset have been received by the collector.
+ *
+ * @return u32 Journal offset
+ */
+u32 uplink_acked(void)
+{
+	return(acked);
+}
+
+/**
+ * @brief Encode journal records into a data datagram
+ *
+ * @param offset Pointer to the offset of the first record, updated to the
+ *               offset of the next record not encoded
+ * @param end    Offset after the last record to encode
+ * @param buf    Pointer to the datagram buffer
+ * @param max    Size of the buffer
+ * @return uint  Length of the datagram, 0 if no record has been encoded
+ */
+uint uplink_pack(u32 *offset, u32 end, u8 *buf, uint max)
+{
+	journal_rec rec;
+	u32  off = *offset;
+	u32  time, cred;
+	u8  *p = buf + UPLINK_HDR;
+	u8  *last = buf + max - UPLINK_REC_MAX;
+	uint count = 0;
+
+	if ((off == end) || journal_read(off, &rec) < 0)
+		return(0);
+	time = rec.time;
+	cred = rec.cred;
+	_put16(buf + 0, UPLINK_MAGIC);
+	buf[2] = UPLINK_VERSION;
+	buf[3] = UPLINK_DATA;
+	_put32(buf +  4, session);
+	_put32(buf +  8, off);
+	_put32(buf + 16, time);
+	_put32(buf + 20, cred);
+
+	do
+	{
+		// Zigzag deltas : small values, positive or negative, use one byte
+		p = _varint(p, ((rec.time - time) << 1) ^ (u32)((s32)(rec.time - time) >> 31));
+		p = _varint(p, ((rec.cred - cred) << 1) ^ (u32)((s32)(rec.cred - cred) >> 31));
+		*p++ = (u8)((rec.door << 4) | (rec.type & 0x0F));
+		p = _varint(p, rec.info);
+		time = rec.time;
+		cred = rec.cred;
+		count++;
+		off++;
+	} while ((off != end) && (p <= last) && (count < 0xFFFF) &&
+	         (journal_read(off, &rec) == 0));
+
+	_put16(buf + 12, count);
+	_put16(buf + 14, 0);
+	*offset = off;
+	return (uint)(p - buf);
+}
+
+/**
+ * @brief Print the counters of the uplink
+ *
+ */
+void uplink_dump(void)
+{
+	log_print(0, " * Uplink: %s, acked %u, sent %u datagrams %u records %u bytes,"
+	          " retrans %u, resume %u, lost %u\n",
+	          (state == ST_RUN) ? "run" : "arp", acked,
+	          uplink_stat.datagrams, uplink_stat.records, uplink_stat.bytes,
+	          uplink_stat.retrans, uplink_stat.resumes, uplink_stat.lost);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Private functions                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Add the network headers of a datagram and give it to the MAC
+ *
+ * @param s Pointer to the slot of the datagram
+ */
+static void _send(ul_slot *s)
+{
+	eth_seg seg[2];
+	u8 *h = s->hdr;
+	uint i;
+
+	trace_mark(TRACE_ID_UPLINK_SEND, s->len);
+	for (i = 0; i < 6; i++)
+	{
+		h[i]     = peer[i];
+		h[6 + i] = mac[i];
+	}
+	_put16be(h + 12, ETH_IPV4);
+	// IPv4 header, checksums are inserted by the MAC
+	h[14] = 0x45;
+	h[15] = 0;
+	_put16be(h + 16, 20u + 8u + s->len);
+	_put16be(h + 18, ip_id++);
+	_put16be(h + 20, 0x4000);
+	h[22] = 64;
+	h[23] = 17;
+	_put16be(h + 24, 0);
+	_put32be(h + 26, ip_addr);
+	_put32be(h + 30, ip_server);
+	// UDP header
+	_put16be(h + 34, UPLINK_PORT);
+	_put16be(h + 36, UPLINK_PORT);
+	_put16be(h + 38, 8u + s->len);
+	_put16be(h + 40, 0);
+
+	// Records before the window are acknowledged or lost (overwritten)
+	if (s->first == acked)
+		s->data[14] |= UPLINK_F_BASE;
+
+	seg[0].data = s->hdr;
+	seg[0].len  = NET_HDR;
+	seg[1].data = s->data;
+	seg[1].len  = s->len;
+	s->busy = 1;
+	if (eth_send(seg, 2, _done, (void *)&s->busy) < 0)
+	{
+		s->busy = 0;
+		return;
+	}
+	uplink_stat.datagrams++;
+	uplink_stat.records += s->end - s->first;
+	uplink_stat.bytes   += s->len;
+}
+
+/**
+ * @brief Process a received frame (ARP or acknowledgement)
+ *
+ * @param f Pointer to the received frame
+ */
+static void _input(const eth_frame *f)
+{
+	const u8 *ip = f->data + 14;
+	uint type, ihl, len;
+
+	if (f->len < 14)
+		return;
+	type = ((uint)f->data[12] << 8) | f->data[13];
+	if (type == ETH_ARP)
+	{
+		_arp_input(ip, f->len - 14u);
+		return;
+	}
+	if ((type != ETH_IPV4) || ((f->flags & ETH_RX_CSUM) == 0) || (f->len < 42))
+		return;
+	ihl = (uint)(ip[0] & 0x0F) * 4;
+	len = ((uint)ip[2] << 8) | ip[3];
+	if ((ip[9] != 17) || (ihl < 20) || (len < (ihl + 8)) || ((14 + len) > f->len))
+		return;
+	if ((_get32be(ip + 12) != ip_server) || (_get32be(ip + 16) != ip_addr))
+		return;
+	if ((((uint)ip[ihl + 2] << 8) | ip[ihl + 3]) != UPLINK_PORT)
+		return;
+	_ack(ip + ihl + 8, len - ihl - 8);
+}
+
+/**
+ * @brief Process a received ARP packet
+ *
+ * Requests for our address are answered, the address of the collector is
+ * learned from its replies (or requests).
+ *
+ * @param p   Pointer to the ARP packet
+ * @param len Length of the packet
+ */
+static void _arp_input(const u8 *p, uint len)
+{
+	uint op, i;
+
+	if ((len < 28) || (p[0] != 0) || (p[1] != 1) || (p[2] != 0x08) ||
+	    (p[3] != 0x00) || (p[4] != 6) || (p[5] != 4))
+		return;
+	op = ((uint)p[6] << 8) | p[7];
+
+	if ((_get32be(p + 14) == ip_server) && (_get32be(p + 24) == ip_addr))
+	{
+		for (i = 0; i < 6; i++)
+			peer[i] = p[8 + i];
+		if (state == ST_ARP)
+		{
+			log_print(0, " * Uplink: collector found, resume at %u\n", acked);
+			state    = ST_RUN;
+			next     = acked;
+			inflight = 0;
+			lost     = 0;
+			window   = 1;
+			wait_us  = systime_us() - UPLINK_FLUSH_US;
+			uplink_stat.resumes++;
+		}
+	}
+	if ((op == 1) && (_get32be(p + 24) == ip_addr))
+		_arp_send(2, p + 8, _get32be(p + 14));
+}
+
+/**
+ * @brief Send an ARP request or reply
+ *
+ * @param op  Operation, 1 for request and 2 for reply
+ * @param tha Hardware address of the target (reply only)
+ * @param tpa IPv4 address of the target
+ */
+static void _arp_send(uint op, const u8 *tha, u32 tpa)
+{
+	eth_seg seg;
+	u8 *h = arp_buf;
+	uint i;
+
+	// The previous packet is still in the ring
+	if (arp_busy)
+		return;
+	for (i = 0; i < 6; i++)
+	{
+		h[i]      = tha ? tha[i] : 0xFF;
+		h[6 + i]  = mac[i];
+		h[22 + i] = mac[i];
+		h[32 + i] = tha ? tha[i] : 0x00;
+	}
+	_put16be(h + 12, ETH_ARP);
+	_put16be(h + 14, 1);
+	_put16be(h + 16, ETH_IPV4);
+	h[18] = 6;
+	h[19] = 4;
+	_put16be(h + 20, op);
+	_put32be(h + 28, ip_addr);
+	_put32be(h + 38, tpa);
+
+	seg.data = arp_buf;
+	seg.len  = NET_HDR;
+	arp_busy = 1;
+	if (eth_send(&seg, 1, _done, (void *)&arp_busy) < 0)
+		arp_busy = 0;
+}
+
+/**
+ * @brief Process an acknowledgement of the collector
+ *
+ * @param p   Pointer to the UDP payload
+ * @param len Length of the payload
+ */
+static void _ack(const u8 *p, uint len)
+{
+	u32 off;
+	uint win;
+
+	if ((len < UPLINK_HDR) || (p[0] != (UPLINK_MAGIC & 0xFF)) ||
+	    (p[1] != (UPLINK_MAGIC >> 8)) || (p[2] != UPLINK_VERSION) || (p[3] != UPLINK_ACK))
+		return;
+	if (((u32)p[4] | ((u32)p[5] << 8) | ((u32)p[6] << 16) | ((u32)p[7] << 24)) != session)
+		return;
+	off = (u32)p[8] | ((u32)p[9] << 8) | ((u32)p[10] << 16) | ((u32)p[11] << 24);
+	win = (uint)p[14] | ((uint)p[15] << 8);
+	uplink_stat.acks++;
+
+	window = (win == 0) ? 1 : ((win > UPLINK_WINDOW) ? UPLINK_WINDOW : win);
+	// Only offsets between the acknowledged one and the next one are valid
+	if ((off == acked) || ((off - acked) > (next - acked)))
+		return;
+	acked = off;
+	lost  = 0;
+	sent_us = systime_us();
+	while (inflight && ((s32)(acked - slots[slot_first].end) >= 0))
+	{
+		slot_first = (slot_first + 1) % UPLINK_WINDOW;
+		inflight--;
+	}
+}
+
+/**
+ * @brief Transmission done, the buffer can be used again
+ *
+ * @param arg Pointer to the busy flag of the buffer
+ */
+static void _done(void *arg)
+{
+	*(volatile u8 *)arg = 0;
+}
+
+/**
+ * @brief Write a variable length integer (7 bits per byte, LSB first)
+ *
+ * @param p Pointer to the buffer
+ * @param v Value to write
+ * @return u8* Pointer after the written bytes
+ */
+static u8 *_varint(u8 *p, u32 v)
+{
+	while (v >= 0x80)
+	{
+		*p++ = (u8)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (u8)v;
+	return(p);
+}
+
+/**
+ * @brief Write a 16 bits value (little endian)
+ */
+static void _put16(u8 *p, u32 v)
+{
+	p[0] = (u8)(v >> 0);
+	p[1] = (u8)(v >> 8);
+}
+
+/**
+ * @brief Write a 32 bits value (little endian)
+ */
+static void _put32(u8 *p, u32 v)
+{
+	p[0] = (u8)(v >>  0);
+	p[1] = (u8)(v >>  8);
+	p[2] = (u8)(v >> 16);
+	p[3] = (u8)(v >> 24);
+}
+
+/**
+ * @brief Write a 16 bits value (network order)
+ */
+static void _put16be(u8 *p, u32 v)
+{
+	p[0] = (u8)(v >> 8);
+	p[1] = (u8)(v >> 0);
+}
+
+/**
+ * @brief Write a 32 bits value (network order)
+ */
+static void _put32be(u8 *p, u32 v)
+{
+	p[0] = (u8)(v >> 24);
+	p[1] = (u8)(v >> 16);
+	p[2] = (u8)(v >>  8);
+	p[3] = (u8)(v >>  0);
+}
+
+/**
+ * @brief Read a 32 bits value (network order)
+ */
+static u32 _get32be(const u8 *p)
+{
+	return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+/* EOF */
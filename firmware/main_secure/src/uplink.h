@@ -0,0 +1,73 @@
+/**
+ * @file  uplink.h
+ * @brief Definitions and prototypes for the event uplink (UDP)
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef UPLINK_H
+#define UPLINK_H
+#include "types.h"
+
+// UDP port, used on both sides
+#define UPLINK_PORT    4950
+#define UPLINK_MAGIC   0x4C55 /* "UL" */
+#define UPLINK_VERSION 1
+
+/* Datagram types */
+#define UPLINK_DATA 1
+#define UPLINK_ACK  2
+/* Flags of data datagrams */
+#define UPLINK_F_BASE (1 << 0) /* First record is the oldest one not acknowledged */
+
+// Length of the datagram header (see uplink.md)
+#define UPLINK_HDR     24
+// Largest datagram : Ethernet MTU without IPv4 and UDP headers
+#define UPLINK_MTU     1500
+#define UPLINK_PAYLOAD (UPLINK_MTU - 20 - 8)
+// Longest encoded record : 3 varints and the code byte
+#define UPLINK_REC_MAX 14
+
+// Datagrams sent without acknowledgement (upper bound of the window)
+#define UPLINK_WINDOW  4
+// Records wait up to this delay to be grouped into one datagram
+#define UPLINK_FLUSH_US 50000
+// Unacknowledged datagrams are sent again after this delay
+#define UPLINK_RTO_US  250000
+// Number of timeouts before the collector is considered lost
+#define UPLINK_LOST    4
+// Period of ARP requests while the collector is not found
+#define UPLINK_ARP_US  1000000
+
+/**
+ * @brief Counters of the uplink (see uplink_dump)
+ */
+typedef struct uplink_stats
+{
+	u32 datagrams; // Data datagrams sent, including retransmissions
+	u32 records;   // Records sent, including retransmissions
+	u32 bytes;     // UDP payload bytes sent
+	u32 retrans;   // Timeouts (window sent again)
+	u32 acks;      // Acknowledgements received
+	u32 resumes;   // Restarts from the last acknowledged offset
+	u32 lost;      // Records overwritten before being sent
+} uplink_stats;
+
+extern uplink_stats uplink_stat;
+
+void uplink_init  (void);
+void uplink_config(u32 ip, u32 server);
+void uplink_poll  (void);
+u32  uplink_acked (void);
+uint uplink_pack  (u32 *offset, u32 end, u8 *buf, uint max);
+void uplink_dump  (void);
+
+#endif
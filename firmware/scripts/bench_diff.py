@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/bench_diff.py
+ # @brief Compare benchmark results with a stored baseline
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# Results are the "BENCH,..." lines written on the console by the benchmark
+# firmware (main_secure/src/bench.c), other lines are ignored so a complete
+# console capture can be used. The exit code is 1 when at least one case is
+# slower than baseline by more than the threshold.
+#
+#   ./fw_secure_bench_host | python3 scripts/bench_diff.py baseline.csv -
+#   python3 scripts/bench_diff.py --update baseline.csv console.log
+#
+import argparse
+import sys
+
+METRICS = {'per_op': 5, 'bus': 6}
+
+def load(name):
+    """Read benchmark lines of a file, return a dict case -> fields"""
+    f = sys.stdin if name == '-' else open(name, 'r', errors='replace')
+    lines = []
+    results = {}
+    for line in f:
+        line = line.strip()
+        pos = line.find('BENCH,')
+        if pos < 0:
+            continue
+        fields = line[pos:].split(',')
+        if len(fields) < 7 or fields[1] == 'case':
+            continue
+        lines.append(','.join(fields))
+        results[fields[1]] = fields
+    if f is not sys.stdin:
+        f.close()
+    return results, lines
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare benchmark results with a baseline')
+    parser.add_argument('baseline', help='baseline CSV file')
+    parser.add_argument('results',  help='new results (console capture, "-" for stdin)')
+    parser.add_argument('-t', '--threshold', type=float, default=5.0, help='allowed regression in percent (default 5)')
+    parser.add_argument('-m', '--metric', choices=METRICS.keys(), default='per_op', help='column to compare')
+    parser.add_argument('-u', '--update', action='store_true', help='write results as new baseline')
+    args = parser.parse_args()
+
+    new, lines = load(args.results)
+    if not new:
+        sys.exit('Error: no benchmark result found')
+    if args.update:
+        with open(args.baseline, 'w') as f:
+            f.write('BENCH,case,iterations,unit,total,per_op,bus_per_op\n')
+            f.write('\n'.join(lines) + '\n')
+        print('Baseline %s updated (%d cases)' % (args.baseline, len(lines)))
+        return
+
+    base, _ = load(args.baseline)
+    col = METRICS[args.metric]
+    failed = 0
+    print('%-16s %12s %12s %8s' % ('case', 'baseline', 'current', 'delta'))
+    for name, fields in new.items():
+        cur = float(fields[col])
+        if name not in base:
+            print('%-16s %12s %12.2f %8s' % (name, '-', cur, 'new'))
+            continue
+        if (args.metric == 'per_op') and (base[name][3] != fields[3]):
+            print('%-16s unit differs (%s / %s)' % (name, base[name][3], fields[3]))
+            continue
+        ref = float(base[name][col])
+        if ref == 0:
+            delta = 0.0 if cur == 0 else 100.0
+        else:
+            delta = (cur - ref) * 100.0 / ref
+        flag = ''
+        if delta > args.threshold:
+            flag = '  REGRESSION'
+            failed += 1
+        print('%-16s %12.2f %12.2f %+7.1f%%%s' % (name, ref, cur, delta, flag))
+    for name in base:
+        if name not in new:
+            print('%-16s missing from results' % name)
+    if failed:
+        print('%d regression(s) above %.1f%%' % (failed, args.threshold))
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,288 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/collector.py
+ # @brief Stand-in of the site controller for the event uplink
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# Receives the journal records sent by the uplink (main_secure/src/uplink.c,
+# see doc/uplink.md) and acknowledges them.
+#
+#   collector.py --listen 192.168.1.1
+#       UDP server for a board
+#   collector.py --sim main_secure/fw_secure_host --events 20000
+#       runs the host build, connected with pcap pipes (SIM_ETH_RX/TX),
+#       injects test events into its journal (SIM_EVENTS), then reports the
+#       throughput (events per second, bytes per event)
+#
+import argparse
+import os
+import random
+import select
+import socket
+import struct
+import sys
+import tempfile
+import time
+
+from frame import Channel, SimPort
+
+PORT     = 4950
+MAGIC    = 0x4C55
+VERSION  = 1
+T_DATA   = 1
+T_ACK    = 2
+F_BASE   = 0x01
+HDR      = struct.Struct('<HBBIIHHII')
+WINDOW   = 4
+
+def varint(data, pos):
+    """Read a variable length integer, return (value, next position)"""
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if b < 0x80:
+            return value, pos
+
+def zigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+def decode(payload):
+    """Decode a data datagram, return (header fields, list of records)"""
+    magic, ver, typ, session, offset, count, flags, t, cred = HDR.unpack_from(payload)
+    records = []
+    pos = HDR.size
+    for _ in range(count):
+        dt, pos = varint(payload, pos)
+        dc, pos = varint(payload, pos)
+        code = payload[pos]
+        pos += 1
+        info, pos = varint(payload, pos)
+        t    = (t + zigzag(dt)) & 0xFFFFFFFF
+        cred = (cred + zigzag(dc)) & 0xFFFFFFFF
+        records.append((t, cred, code >> 4, code & 0x0F, info))
+    return (session, offset, count, flags), records
+
+class Collector:
+    """Receive side of the protocol : one expected offset per session"""
+    def __init__(self, verbose=False):
+        self.expected = {}
+        self.records  = []
+        self.verbose  = verbose
+        self.datagrams = 0
+        self.dup   = 0
+        self.lost  = 0
+        self.bytes = 0
+
+    def handle(self, payload):
+        """Process a datagram, return the acknowledgement (or None)"""
+        if len(payload) < HDR.size:
+            return None
+        magic, ver, typ = struct.unpack_from('<HBB', payload)
+        if magic != MAGIC or ver != VERSION or typ != T_DATA:
+            return None
+        (session, offset, count, flags), records = decode(payload)
+        self.datagrams += 1
+        self.bytes += len(payload)
+        exp = self.expected.get(session)
+        if exp is None:
+            # New session (board restart) : start from its first datagram
+            exp = offset
+        elif offset > exp and (flags & F_BASE):
+            # Records overwritten into the journal before being sent
+            self.lost += offset - exp
+            exp = offset
+        if offset <= exp < offset + count:
+            self.records += records[exp - offset:]
+            if self.verbose:
+                print('  [%08X] %6d +%-4d %4d bytes' % (session, exp, offset + count - exp, len(payload)))
+            exp = offset + count
+        else:
+            self.dup += 1
+        self.expected[session] = exp
+        return HDR.pack(MAGIC, VERSION, T_ACK, session, exp, 0, WINDOW, 0, 0)
+
+    def acked(self):
+        return max(self.expected.values()) if self.expected else 0
+
+def csum(data, init=0):
+    if len(data) & 1:
+        data += b'\0'
+    s = init + sum(struct.unpack('!%dH' % (len(data) // 2), data))
+    while s >> 16:
+        s = (s & 0xFFFF) + (s >> 16)
+    return ~s & 0xFFFF
+
+class SimNet:
+    """Ethernet side of the collector, with the pcap files of the host build"""
+    MAC = bytes([0x02, 0, 0, 0, 0, 0x01])
+    IP  = bytes([192, 168, 1, 1])
+
+    def __init__(self, tx_name, rx_name):
+        # Opened by the host build after the output file
+        self.rx = open(rx_name, 'wb', buffering=0)
+        self.tx = open(tx_name, 'rb')
+        self.rx.write(struct.pack('<IHHiIII', 0xA1B2C3D4, 2, 4, 0, 0, 65535, 1))
+        self.buf = b''
+        self.hdr = False
+        self.ip_id = 0
+
+    def recv(self):
+        """Return the frames sent by the board since last call"""
+        self.buf += self.tx.read()
+        if not self.hdr:
+            if len(self.buf) < 24:
+                return []
+            self.buf = self.buf[24:]
+            self.hdr = True
+        frames = []
+        while len(self.buf) >= 16:
+            length = struct.unpack_from('<I', self.buf, 8)[0]
+            if len(self.buf) < 16 + length:
+                break
+            frames.append(self.buf[16:16 + length])
+            self.buf = self.buf[16 + length:]
+        return frames
+
+    def send(self, frame):
+        t = time.time()
+        self.rx.write(struct.pack('<IIII', int(t), int((t % 1) * 1e6), len(frame), len(frame)) + frame)
+
+    def input(self, frame):
+        """Process a frame of the board, return (ip, UDP payload) of data datagrams"""
+        etype = struct.unpack_from('!H', frame, 12)[0]
+        if etype == 0x0806 and frame[38:42] == self.IP and frame[21] == 1:
+            # ARP request for the collector
+            arp = struct.pack('!HHBBH', 1, 0x0800, 6, 4, 2) + self.MAC + self.IP + frame[22:32]
+            self.send(frame[6:12] + self.MAC + b'\x08\x06' + arp)
+            return None
+        if etype != 0x0800 or frame[23] != 17 or frame[30:34] != self.IP:
+            return None
+        ihl = (frame[14] & 0x0F) * 4
+        udp = 14 + ihl
+        if struct.unpack_from('!H', frame, udp + 2)[0] != PORT:
+            return None
+        length = struct.unpack_from('!H', frame, udp + 4)[0]
+        return frame[6:12], frame[26:30], frame[udp + 8:udp + length]
+
+    def reply(self, mac, ip, payload):
+        """Send a UDP datagram to the board"""
+        udp = struct.pack('!HHHH', PORT, PORT, 8 + len(payload), 0) + payload
+        pseudo = self.IP + ip + struct.pack('!BBH', 0, 17, len(udp))
+        udp = udp[:6] + struct.pack('!H', csum(pseudo + udp) or 0xFFFF) + udp[8:]
+        self.ip_id = (self.ip_id + 1) & 0xFFFF
+        hdr = struct.pack('!BBHHHBBH', 0x45, 0, 20 + len(udp), self.ip_id, 0x4000, 64, 17, 0) + self.IP + ip
+        hdr = hdr[:10] + struct.pack('!H', csum(hdr)) + hdr[12:]
+        self.send(mac + self.MAC + b'\x08\x00' + hdr + udp)
+
+def listen(args):
+    col = Collector(args.verbose)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.listen, PORT))
+    print('Listening on %s:%d' % (args.listen, PORT))
+    start = last = time.time()
+    while True:
+        if select.select([sock], [], [], 1.0)[0]:
+            payload, addr = sock.recvfrom(2048)
+            ack = col.handle(payload)
+            if ack and random.random() >= args.drop:
+                sock.sendto(ack, addr)
+        if time.time() - last >= 10:
+            last = time.time()
+            report(col, last - start)
+
+def sim(args):
+    tmp = tempfile.mkdtemp()
+    rx_name = os.path.join(tmp, 'rx.pcap')
+    tx_name = os.path.join(tmp, 'tx.pcap')
+    ev_name = os.path.join(tmp, 'events.bin')
+    os.mkfifo(rx_name)
+
+    # Test events : a population of badges, mostly granted. The host build
+    # appends them to its journal, paced by the acknowledgements
+    rnd = random.Random(args.seed)
+    badges = [rnd.randrange(1, 1 << 26) for _ in range(200)]
+    events = []
+    for _ in range(args.events):
+        typ = 1 if rnd.random() < 0.9 else 2
+        events.append((rnd.randrange(4), typ, rnd.choice(badges), 0 if typ == 1 else rnd.randrange(1, 8)))
+    with open(ev_name, 'wb') as f:
+        f.write(b''.join(struct.pack('<BBIH', *e) for e in events))
+
+    port = SimPort([args.sim], {'SIM_ETH_RX': rx_name, 'SIM_ETH_TX': tx_name, 'SIM_EVENTS': ev_name})
+    # Console of the firmware is shown with --verbose
+    ch  = Channel(port, (lambda t: print(t.decode(errors='replace').rstrip())) if args.verbose else None)
+    net = SimNet(tx_name, rx_name)
+    col = Collector(args.verbose)
+
+    # Records other than the boot ones (type 0)
+    got = 0
+    start = time.time()
+    while got < len(events):
+        if time.time() - start > args.timeout:
+            sys.exit('Error: timeout, %d events received' % got)
+        for frame in net.recv():
+            data = net.input(frame)
+            if data is None:
+                continue
+            n = len(col.records)
+            ack = col.handle(data[2])
+            if ack and rnd.random() >= args.drop:
+                net.reply(data[0], data[1], ack)
+            got += sum(1 for r in col.records[n:] if r[3] != 0)
+        ch.recv(0.001)
+    elapsed = time.time() - start
+    port.close()
+
+    got = [(r[2], r[3], r[1], r[4]) for r in col.records if r[3] != 0]
+    if got[-len(events):] != events:
+        sys.exit('Error: records received differ from injected events')
+    report(col, elapsed)
+
+def report(col, elapsed):
+    n = len(col.records)
+    if n == 0:
+        print('No record received')
+        return
+    print('  Records    : %d (lost %d)' % (n, col.lost))
+    print('  Datagrams  : %d (%d duplicated)' % (col.datagrams, col.dup))
+    print('  Bytes/event: %.2f payload, %.2f on the wire' %
+          (col.bytes / n, (col.bytes + col.datagrams * (42 + 24)) / n))
+    print('  Throughput : %.0f events/s (%.1f s)' % (n / elapsed, elapsed))
+
+def main():
+    parser = argparse.ArgumentParser(description='Collector of the event uplink')
+    parser.add_argument('--listen', metavar='ADDR', help='receive datagrams of a board on this address')
+    parser.add_argument('--sim', metavar='EXE', help='run and feed the host build (fw_secure_host)')
+    parser.add_argument('-n', '--events', type=int, default=10000, help='number of test events (--sim)')
+    parser.add_argument('--drop', type=float, default=0.0, help='fraction of acknowledgements dropped')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--timeout', type=float, default=120.0)
+    parser.add_argument('-v', '--verbose', action='store_true')
+    args = parser.parse_args()
+
+    if args.sim:
+        sim(args)
+    elif args.listen:
+        try:
+            listen(args)
+        except KeyboardInterrupt:
+            pass
+    else:
+        parser.error('--listen or --sim is required')
+
+if __name__ == '__main__':
+    main()
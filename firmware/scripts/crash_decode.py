@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/crash_decode.py
+ # @brief Decode the crash record saved by the fault handlers
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# The record is read from the backup SRAM by the debugger (scripts/crash.gdb)
+# or written by the host build (SIM_CRASH). Layout is crash_rec of
+# main_secure/src/crash.h. With an ELF file, code addresses are converted to
+# function and line by addr2line.
+#
+#   python3 scripts/crash_decode.py crash.bin
+#   python3 scripts/crash_decode.py crash.bin --elf main_secure/fw_secure.elf
+#
+import argparse
+import os
+import struct
+import subprocess
+import sys
+
+from trace2json import TYPES, WORLD, load_ids
+
+MAGIC   = 0x48535243
+VERSION = 1
+HDR     = '<IHH5I13I4I6I2I'
+REGIONS = 8
+STACK   = 64
+TRACE   = 32
+
+EXC = {3: 'HardFault', 4: 'MemManage', 5: 'BusFault', 6: 'UsageFault',
+       7: 'SecureFault', 0xFF: 'signal (host build)'}
+
+# Bits of the fault status registers (PM0264)
+MMFSR = ((0, 'IACCVIOL', 'instruction access violation'),
+         (1, 'DACCVIOL', 'data access violation'),
+         (3, 'MUNSTKERR', 'MemManage fault on unstacking'),
+         (4, 'MSTKERR', 'MemManage fault on stacking'),
+         (5, 'MLSPERR', 'MemManage fault on FP lazy state preservation'),
+         (7, 'MMARVALID', 'MMFAR holds the faulting address'))
+BFSR  = ((8, 'IBUSERR', 'instruction bus error'),
+         (9, 'PRECISERR', 'precise data bus error'),
+         (10, 'IMPRECISERR', 'imprecise data bus error'),
+         (11, 'UNSTKERR', 'BusFault on unstacking'),
+         (12, 'STKERR', 'BusFault on stacking'),
+         (13, 'LSPERR', 'BusFault on FP lazy state preservation'),
+         (15, 'BFARVALID', 'BFAR holds the faulting address'))
+UFSR  = ((16, 'UNDEFINSTR', 'undefined instruction'),
+         (17, 'INVSTATE', 'invalid state (EPSR.T or IT)'),
+         (18, 'INVPC', 'invalid PC load (EXC_RETURN)'),
+         (19, 'NOCP', 'no coprocessor'),
+         (20, 'STKOF', 'stack overflow (stack limit)'),
+         (24, 'UNALIGNED', 'unaligned access'),
+         (25, 'DIVBYZERO', 'division by zero'))
+HFSR  = ((1, 'VECTTBL', 'bus fault on vector table read'),
+         (30, 'FORCED', 'escalated from a configurable fault'),
+         (31, 'DEBUGEVT', 'debug event'))
+SFSR  = ((0, 'INVEP', 'invalid entry point (not an SG)'),
+         (1, 'INVIS', 'invalid integrity signature'),
+         (2, 'INVER', 'invalid exception return'),
+         (3, 'AUVIOL', 'attribution unit violation'),
+         (4, 'INVTRAN', 'invalid transition'),
+         (5, 'LSPERR', 'lazy state preservation error'),
+         (6, 'SFARVALID', 'SFAR holds the faulting address'),
+         (7, 'LSERR', 'lazy state error'))
+
+def checksum(data):
+    """FNV-1a over words (same as _sum of crash.c)"""
+    h = 0x811C9DC5
+    for (w,) in struct.iter_unpack('<I', data):
+        h = ((h ^ w) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+def load(name):
+    """Read a record, return a dictionary of its fields"""
+    data = open(name, 'rb').read()
+    size = struct.calcsize(HDR) + (REGIONS * 16) + (STACK * 4) + (TRACE * 8) + 4
+    if len(data) < size:
+        raise ValueError('file too short')
+    v = struct.unpack_from(HDR, data)
+    if v[0] != MAGIC:
+        raise ValueError('bad magic (no crash record ?)')
+    if v[1] != VERSION or v[2] != size:
+        raise ValueError('version %d, size %d not supported' % (v[1], v[2]))
+    rec = {'count': v[3], 'burst': v[4], 'pending': v[5], 'exc': v[6],
+           'exc_return': v[7], 'r': list(v[8:21])}
+    (rec['sp'], rec['lr'], rec['pc'], rec['xpsr'], rec['cfsr'], rec['hfsr'],
+     rec['mmfar'], rec['bfar'], rec['sfsr'], rec['sfar'], rec['time'],
+     rec['nstack']) = v[21:33]
+    off = struct.calcsize(HDR)
+    rec['regions'] = [struct.unpack_from('<4I', data, off + (i * 16)) for i in range(REGIONS)]
+    off += REGIONS * 16
+    rec['stack'] = list(struct.unpack_from('<%dI' % STACK, data, off))[:min(rec['nstack'], STACK)]
+    off += STACK * 4
+    rec['trace'] = [struct.unpack_from('<2I', data, off + (i * 8)) for i in range(TRACE)]
+    off += TRACE * 8
+    rec['check'] = struct.unpack_from('<I', data, off)[0]
+    rec['valid'] = (rec['check'] == checksum(data[:off]))
+    return rec
+
+def bits(value, table):
+    """List the names of the bits set into a status register"""
+    return ['%s (%s)' % (name, text) for bit, name, text in table if value & (1 << bit)]
+
+def symbols(elf, addrs):
+    """Convert code addresses to 'function at file:line' with addr2line"""
+    result = {}
+    if not elf or not addrs:
+        return result
+    tool = os.environ.get('ADDR2LINE', 'arm-none-eabi-addr2line')
+    addrs = sorted(set(addrs))
+    try:
+        out = subprocess.run([tool, '-f', '-C', '-e', elf] + ['0x%x' % a for a in addrs],
+                             capture_output=True, text=True, check=True).stdout.split('\n')
+    except (OSError, subprocess.CalledProcessError) as e:
+        print('Warning: %s : %s' % (tool, e), file=sys.stderr)
+        return result
+    for i, addr in enumerate(addrs):
+        if (2 * i) + 1 < len(out) and out[2 * i] != '??':
+            result[addr] = '%s at %s' % (out[2 * i], os.path.basename(out[(2 * i) + 1]))
+    return result
+
+def is_code(addr):
+    """Test if a value looks like an address of the firmware (flash)"""
+    return 0x08000000 <= (addr & ~1) < 0x08200000 or 0x0C000000 <= (addr & ~1) < 0x0C200000
+
+def show(rec, ids, elf):
+    """Print a decoded record"""
+    if rec['count'] == 0:
+        print('No fault recorded')
+        return
+    code = [rec['pc'], rec['lr']] + [w & ~1 for w in rec['stack'] if is_code(w)]
+    sym = symbols(elf, [a & ~1 for a in code])
+    def name(addr):
+        s = sym.get(addr & ~1)
+        return '  <%s>' % s if s else ''
+
+    print('Fault     : %s (exception %d)%s' % (EXC.get(rec['exc'], 'unknown'), rec['exc'],
+          '' if rec['valid'] else '  [record checksum error]'))
+    print('Count     : %d fault(s), %d in a row, restart %s' % (rec['count'], rec['burst'],
+          'pending' if rec['pending'] else 'done'))
+    print('Time      : %u (counter of the trace)' % rec['time'])
+    er = rec['exc_return']
+    if er:
+        print('EXC_RETURN: %08x (%s stack, %s, %s frame)' % (er,
+              'secure' if er & 0x40 else 'non-secure',
+              'process' if er & 0x04 else 'main',
+              'basic' if er & 0x10 else 'FP'))
+    print('')
+    for i in range(0, 13, 4):
+        print('  ' + '  '.join('r%-2d %08x' % (j, rec['r'][j]) for j in range(i, min(i + 4, 13))))
+    print('  sp  %08x  lr  %08x%s' % (rec['sp'], rec['lr'], name(rec['lr'])))
+    print('  pc  %08x  xpsr %08x%s' % (rec['pc'], rec['xpsr'], name(rec['pc'])))
+    print('')
+    for reg, value, table in (('CFSR', rec['cfsr'], MMFSR + BFSR + UFSR),
+                              ('HFSR', rec['hfsr'], HFSR), ('SFSR', rec['sfsr'], SFSR)):
+        print('%-5s %08x  %s' % (reg, value, ', '.join(bits(value, table)) or '-'))
+    if rec['cfsr'] & (1 << 7):
+        print('MMFAR %08x' % rec['mmfar'])
+    if rec['cfsr'] & (1 << 15):
+        print('BFAR  %08x' % rec['bfar'])
+    if rec['sfsr'] & (1 << 6):
+        print('SFAR  %08x' % rec['sfar'])
+
+    print('\nRetained structures')
+    for i, (addr, length, s, valid) in enumerate(rec['regions']):
+        if length:
+            print('  %d  %08x  %6d bytes  sum %08x  %s' % (i, addr, length, s,
+                  'consistent' if valid else 'being modified'))
+
+    if rec['stack']:
+        print('\nStack (%d words from sp)' % len(rec['stack']))
+        for i, w in enumerate(rec['stack']):
+            print('  %08x  %08x%s' % (rec['sp'] + (i * 4), w, name(w) if is_code(w) else ''))
+
+    events = [(t, info) for t, info in rec['trace'] if info]
+    if events:
+        print('\nLast trace events (time relative to the fault)')
+        for t, info in events:
+            ident = (info >> 16) & 0x1FFF
+            delta = (t - rec['time']) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            print('  %12d  %-5s %-10s %-20s %d' % (delta, TYPES[(info >> 30) & 3],
+                  WORLD[(info >> 29) & 1], ids.get(ident, 'id_%d' % ident), info & 0xFFFF))
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode a crash record')
+    parser.add_argument('dump', help='crash record (crash.gdb or SIM_CRASH)')
+    parser.add_argument('-e', '--elf', help='firmware ELF file, for symbols (addr2line)')
+    parser.add_argument('-i', '--ids', help='header with TRACE_ID_* definitions')
+    args = parser.parse_args()
+
+    ids_file = args.ids
+    if ids_file is None:
+        ids_file = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'main_secure', 'src', 'trace.h')
+    try:
+        rec = load(args.dump)
+    except (OSError, ValueError) as e:
+        print('Error: %s : %s' % (args.dump, e), file=sys.stderr)
+        sys.exit(1)
+    show(rec, load_ids(ids_file), args.elf)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/cred_image.py
+ # @brief Build an area of the credential store (compressed base)
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# The database (CSV : id,attr) is coded as the firmware does it (blocks of
+# 256 bytes, differences and profiles bit-packed), with an area header. The
+# image is programmed at the start of the store into the inactive bank, or
+# written into a flash file of the host build (--flash). See
+# doc/credentials.md.
+#
+import argparse
+import csv
+import os
+import struct
+import sys
+
+CRED_OFFSET   = 0x30000
+AREA_SIZE     = 14 * 0x2000
+HDR_SIZE      = 32
+LOG_MIN       = 0x4000
+BLK_SIZE      = 256
+BLK_BITS      = (BLK_SIZE - 8) * 8
+BLK_RECS      = 255
+BLK_MAX       = (AREA_SIZE - HDR_SIZE - LOG_MIN) // BLK_SIZE
+MAGIC         = 0x44524331
+BANK_SIZE     = 0x100000
+FLASH_SIZE    = 2 * BANK_SIZE
+SWAP_BANK     = 0x80000000
+
+def crc32(data):
+    """CRC-32 of the CRC unit (words MSB first, no reversal)"""
+    crc = 0xFFFFFFFF
+    for (w,) in struct.iter_unpack('<I', data):
+        crc ^= w
+        for _ in range(32):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else (crc << 1)
+            crc &= 0xFFFFFFFF
+    return crc
+
+def encode(recs):
+    """Code one block, recs is a list of (id, attr)"""
+    dw = max([(i - p - 1).bit_length() for (p, _), (i, _) in zip(recs, recs[1:])] + [0])
+    aw = max(a.bit_length() for _, a in recs)
+    bits, pos, prev = 0, 0, recs[0][0] - 1
+    for i, a in recs:
+        bits |= (i - prev - 1) << pos
+        pos  += dw
+        bits |= a << pos
+        pos  += aw
+        prev  = i
+    blk = struct.pack('<II', recs[0][0], len(recs) | (dw << 8) | (aw << 16))
+    blk += bits.to_bytes(BLK_SIZE - 8, 'little')
+    return blk
+
+def build(db):
+    """Split the records into blocks, same rule as the firmware"""
+    blocks, cur, dw, aw = [], [], 0, 0
+    for i, a in db:
+        if cur:
+            ndw = max(dw, (i - cur[-1][0] - 1).bit_length())
+            naw = max(aw, a.bit_length())
+            if len(cur) >= BLK_RECS or (len(cur) + 1) * (ndw + naw) > BLK_BITS:
+                blocks.append(encode(cur))
+                cur = []
+            else:
+                dw, aw = ndw, naw
+        if not cur:
+            dw, aw = 0, a.bit_length()
+        cur.append((i, a))
+    if cur:
+        blocks.append(encode(cur))
+    return blocks
+
+def load_db(name):
+    db = {}
+    with open(name) as f:
+        for row in csv.reader(f):
+            if not row or row[0].startswith('#'):
+                continue
+            i, a = int(row[0], 0), int(row[1], 0)
+            if i == 0 or i > 0xFFFFFFFE or a > 0xFFFFFFFF:
+                sys.exit('Error: invalid record %s' % ','.join(row))
+            if a:
+                db[i] = a
+    return sorted(db.items())
+
+def write_flash(name, area):
+    """Write the area into a flash file of the host build (inactive bank)"""
+    if os.path.exists(name):
+        with open(name, 'rb') as f:
+            mem = bytearray(f.read())
+    else:
+        mem = bytearray(b'\xFF' * FLASH_SIZE)
+    # OPTSR_CUR is saved after the flash content
+    swap = len(mem) >= FLASH_SIZE + 4 and struct.unpack_from('<I', mem, FLASH_SIZE)[0] & SWAP_BANK
+    base = (0 if swap else BANK_SIZE) + CRED_OFFSET
+    mem[base:base + (2 * AREA_SIZE)] = b'\xFF' * (2 * AREA_SIZE)
+    mem[base:base + len(area)] = area
+    with open(name, 'wb') as f:
+        f.write(mem)
+
+def main():
+    parser = argparse.ArgumentParser(description='Credential store image builder')
+    parser.add_argument('db', help='database (CSV : id,attr)')
+    parser.add_argument('-o', '--output', help='area image (binary)')
+    parser.add_argument('-v', '--version', type=lambda x: int(x, 0), default=1, help='version of the store')
+    parser.add_argument('--flash', metavar='FILE', help='write into a flash file of the host build (SIM_FLASH)')
+    args = parser.parse_args()
+
+    db = load_db(args.db)
+    blocks = build(db)
+    if len(blocks) > BLK_MAX:
+        sys.exit('Error: %d blocks, the store holds %d' % (len(blocks), BLK_MAX))
+    base = b''.join(blocks)
+    hdr  = struct.pack('<IIII', MAGIC, 1, 0xFFFFFFFE, args.version)
+    hdr += struct.pack('<IIII', len(db), crc32(base), len(blocks), 0)
+    area = hdr + base
+
+    size = len(base)
+    print('  %d credentials, %d blocks (%d max), %d bytes' % (len(db), len(blocks), BLK_MAX, size))
+    if db:
+        print('  %.2f bytes/credential, %.1f records/block' % (size / len(db), len(db) / len(blocks)))
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(area)
+    if args.flash:
+        write_flash(args.flash, area)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/cred_sync.py
+ # @brief Synchronize the credential store of a panel (delta batches, ranges)
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# With --batch, the changes (add/modify/revoke,id,attr) are sent as batches
+# based on the version of the panel. Otherwise (or when a batch is refused
+# with a gap or a conflict) the panel is compared with the database by
+# digests of ranges, and only the ranges that differ are sent again. Batches
+# and range frames are signed with the OBK key (HMAC-SHA256), the same key
+# file as sign_app.py. See doc/credentials.md.
+#
+import argparse
+import csv
+import hashlib
+import hmac
+import struct
+import sys
+import time
+
+from frame import Channel, SimPort
+
+CRED_STATUS      = 0x20
+CRED_BATCH       = 0x21
+CRED_DIGEST      = 0x22
+CRED_RANGE_BEGIN = 0x23
+CRED_RANGE_DATA  = 0x24
+CRED_RANGE_END   = 0x25
+CRED_RANGE_ABORT = 0x26
+
+OPS = {'add': 1, 'modify': 2, 'revoke': 3}
+ST_GAP      = 0x10
+ST_CONFLICT = 0x11
+ST_BUSY     = 0x12
+ST_FULL     = 0x13
+ST_AUTH     = 0x14
+
+KEY_LEN = 32
+BATCH_MAX = 110
+RANGE_CHUNK = 120
+# Ranges with fewer records are sent again instead of being split
+LEAF = 256
+ID_MAX = 0xFFFFFFFE
+
+def mix(x):
+    x ^= x >> 16
+    x = (x * 0x7FEB352D) & 0xFFFFFFFF
+    x ^= x >> 15
+    x = (x * 0x846CA68B) & 0xFFFFFFFF
+    x ^= x >> 16
+    return x
+
+def digest(recs):
+    return sum(mix(i ^ mix(a)) for i, a in recs) & 0xFFFFFFFF
+
+def sign(key, tag, data):
+    return hmac.new(key, tag + data, hashlib.sha256).digest()
+
+def reply(data):
+    st, version, info = struct.unpack_from('<BII', data)
+    return st, version, info
+
+def request(ch, ftype, payload=b''):
+    """Send a request, wait while the panel is busy (new area written)"""
+    while True:
+        st, version, info = reply(ch.request(ftype, payload, timeout=2.0))
+        if st != ST_BUSY:
+            return st, version, info
+        time.sleep(0.05)
+
+def wait_idle(ch):
+    return request(ch, CRED_STATUS)
+
+def load_db(name):
+    db = {}
+    with open(name) as f:
+        for row in csv.reader(f):
+            if not row or row[0].startswith('#'):
+                continue
+            db[int(row[0], 0)] = int(row[1], 0)
+    return sorted(db.items())
+
+def send_batches(ch, key, changes, version):
+    """Send changes as batches, return the new version or None if refused"""
+    for pos in range(0, len(changes), BATCH_MAX):
+        ops = b''.join(struct.pack('<BII', OPS[op], i, a) for op, i, a in changes[pos:pos + BATCH_MAX])
+        data = struct.pack('<II', version, version + 1) + ops
+        st, cur, info = request(ch, CRED_BATCH, data + sign(key, b'CRDB', data))
+        if st == ST_AUTH:
+            sys.exit('Error: batch refused, bad key')
+        if st == ST_GAP:
+            print('  Gap : panel at version %u, expected %u' % (cur, version))
+            return None
+        if st == ST_CONFLICT:
+            print('  Conflict on credential %u' % info)
+            return None
+        if st:
+            sys.exit('Error: batch refused (%02X)' % st)
+        version = cur
+    return version
+
+def send_range(ch, key, recs, lo, hi, version):
+    """Replace the content of a range, return the new version"""
+    data = struct.pack('<III', lo, hi, version)
+    # Each frame of the range is signed with the MAC of the previous one
+    chain = sign(key, b'CRRB', data)
+    st, _, _ = request(ch, CRED_RANGE_BEGIN, data + chain)
+    if st:
+        sys.exit('Error: range %u-%u refused (%02X)' % (lo, hi, st))
+    pos = 0
+    while pos < len(recs):
+        data = b''.join(struct.pack('<II', i, a) for i, a in recs[pos:pos + RANGE_CHUNK])
+        mac = sign(key, b'CRRD', chain + data)
+        st, _, last = request(ch, CRED_RANGE_DATA, data + mac)
+        if st:
+            # Stop the range, the abort is signed over the current chain
+            request(ch, CRED_RANGE_ABORT, sign(key, b'CRRA', chain))
+            sys.exit('Error: range data refused (%02X)' % st)
+        chain = mac
+        # Resume after the last record received by the panel
+        while pos < len(recs) and recs[pos][0] <= last:
+            pos += 1
+    data = struct.pack('<I', version + 1)
+    st, _, _ = request(ch, CRED_RANGE_END, data + sign(key, b'CRRE', chain + data))
+    if st:
+        sys.exit('Error: range end refused (%02X)' % st)
+    st, version, count = wait_idle(ch)
+    print('  Range %u-%u : %d records, version %u' % (lo, hi, len(recs), version))
+    return version
+
+def resync(ch, key, db, version):
+    """Compare ranges by digest, send again the ones that differ"""
+    ids = [i for i, _ in db]
+    todo = [(1, ID_MAX, 0, len(db))]
+    while todo:
+        lo, hi, a, b = todo.pop()
+        recs = db[a:b]
+        _, _, count, dig = struct.unpack('<BIII', ch.request(CRED_DIGEST, struct.pack('<II', lo, hi)))
+        if count == len(recs) and dig == digest(recs):
+            continue
+        # Small range, or nothing into the panel : no need to split it
+        if len(recs) <= LEAF or count == 0:
+            version = send_range(ch, key, recs, lo, hi, version)
+            continue
+        # Split the range into 8 parts of the same number of records
+        bounds = [lo] + [ids[a + (k * (b - a)) // 8] for k in range(1, 8)] + [hi + 1]
+        for k in range(8):
+            if bounds[k] < bounds[k + 1]:
+                todo.append((bounds[k], bounds[k + 1] - 1,
+                             a + (k * (b - a)) // 8, a + ((k + 1) * (b - a)) // 8))
+    return version
+
+def main():
+    parser = argparse.ArgumentParser(description='Credential store synchronization')
+    parser.add_argument('db', nargs='?', help='database (CSV : id,attr)')
+    parser.add_argument('-p', '--port', default='/dev/ttyACM0')
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('--batch', metavar='CSV', help='changes to send (CSV : add|modify|revoke,id,attr)')
+    parser.add_argument('-k', '--key', required=True, help='raw key file (32 bytes)')
+    parser.add_argument('--sim', metavar='EXE', help='use the host build (fw_secure_host) instead of a target')
+    args = parser.parse_args()
+    if not args.db and not args.batch:
+        parser.error('a database or a batch is required')
+    with open(args.key, 'rb') as f:
+        key = f.read()
+    if len(key) != KEY_LEN:
+        sys.exit('Error: key must be %d bytes long' % KEY_LEN)
+
+    if args.sim:
+        port = SimPort([args.sim], {'SIM_KEY': args.key})
+    else:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.05)
+    ch = Channel(port)
+
+    st, version, count = wait_idle(ch)
+    print('  Panel : %u credentials, version %u' % (count, version))
+    new = None
+    if args.batch:
+        with open(args.batch) as f:
+            changes = [(r[0], int(r[1], 0), int(r[2], 0) if len(r) > 2 else 0)
+                       for r in csv.reader(f) if r and not r[0].startswith('#')]
+        new = send_batches(ch, key, changes, version)
+        if new is None and not args.db:
+            sys.exit('Error: batch refused, a database is needed to resync')
+    if new is None:
+        new = resync(ch, key, load_db(args.db), version)
+    st, version, count = wait_idle(ch)
+    print('  Panel : %u credentials, version %u' % (count, version))
+    port.close()
+
+if __name__ == '__main__':
+    main()
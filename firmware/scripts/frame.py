@@ -0,0 +1,130 @@
+##
+ # @file  scripts/frame.py
+ # @brief Host side of the UART framing channel (see main_secure/src/frame.c)
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+import struct
+import os
+import select
+import subprocess
+import time
+
+SLIP_END     = 0xC0
+SLIP_ESC     = 0xDB
+SLIP_ESC_END = 0xDC
+SLIP_ESC_ESC = 0xDD
+
+REPLY = 0x80
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+def encode(ftype, seq, payload=b''):
+    raw = struct.pack('<BBH', ftype, seq & 0xFF, len(payload)) + payload
+    raw += struct.pack('<H', crc16(raw))
+    out = bytearray([SLIP_END])
+    for b in raw:
+        if b == SLIP_END:
+            out += bytes([SLIP_ESC, SLIP_ESC_END])
+        elif b == SLIP_ESC:
+            out += bytes([SLIP_ESC, SLIP_ESC_ESC])
+        else:
+            out.append(b)
+    out.append(SLIP_END)
+    return bytes(out)
+
+def decode(raw):
+    """Decode an unstuffed frame, return (type, seq, payload) or None"""
+    if len(raw) < 6:
+        return None
+    ftype, seq, length = struct.unpack_from('<BBH', raw)
+    if len(raw) != length + 6:
+        return None
+    if struct.unpack_from('<H', raw, 4 + length)[0] != crc16(raw[:4 + length]):
+        return None
+    return (ftype, seq, bytes(raw[4:4 + length]))
+
+class SimPort:
+    """Serial-like port connected to the host build of the firmware"""
+    def __init__(self, cmd, env=None):
+        self.proc = subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                     env=dict(os.environ, **(env or {})))
+
+    def write(self, data):
+        self.proc.stdin.write(data)
+        self.proc.stdin.flush()
+
+    def read(self, size=1):
+        fd = self.proc.stdout.fileno()
+        if not select.select([fd], [], [], 0.05)[0]:
+            return b''
+        return os.read(fd, size)
+
+    def close(self):
+        self.proc.stdin.close()
+        self.proc.wait()
+
+class Channel:
+    """Framing channel over a serial port (pyserial object)"""
+    def __init__(self, port, log=None):
+        self.port = port
+        self.seq  = 0
+        self.log  = log
+        self.buf  = bytearray()
+        self.esc  = False
+
+    def send(self, ftype, payload=b''):
+        self.seq = (self.seq + 1) & 0xFF
+        self.port.write(encode(ftype, self.seq, payload))
+        return self.seq
+
+    def recv(self, timeout=1.0):
+        """Wait next valid frame, other bytes (log text) go to log callback"""
+        end = time.time() + timeout
+        while time.time() < end:
+            data = self.port.read(1)
+            if not data:
+                continue
+            c = data[0]
+            if c == SLIP_END:
+                frame = decode(self.buf)
+                if frame is None and self.log and self.buf:
+                    self.log(bytes(self.buf))
+                self.buf = bytearray()
+                self.esc = False
+                if frame:
+                    return frame
+            elif c == SLIP_ESC:
+                self.esc = True
+            else:
+                if self.esc:
+                    c = {SLIP_ESC_END: SLIP_END, SLIP_ESC_ESC: SLIP_ESC}.get(c, c)
+                    self.esc = False
+                self.buf.append(c)
+        return None
+
+    def request(self, ftype, payload=b'', timeout=1.0, retry=3):
+        """Send a request and wait the matching reply payload"""
+        for _ in range(retry):
+            seq = self.send(ftype, payload)
+            end = time.time() + timeout
+            while time.time() < end:
+                frame = self.recv(end - time.time())
+                if frame and frame[0] == (ftype | REPLY) and frame[1] == seq:
+                    return frame[2]
+        raise TimeoutError('No reply for frame %02X' % ftype)
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/fw_update.py
+ # @brief Send a firmware image to the dual-bank update engine
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# The image is a complete flash bank (secure and application parts), signed
+# with "sign_app.py --detached" : the header is sent at the end, it is not
+# written into flash.
+#
+import argparse
+import struct
+import sys
+
+from frame import Channel, SimPort
+
+UPD_BEGIN = 0x10
+UPD_DATA  = 0x11
+UPD_END   = 0x12
+UPD_SWAP  = 0x13
+
+CHUNK = 1024
+
+def status(reply):
+    st = reply[0]
+    offset = struct.unpack_from('<I', reply, 1)[0] if len(reply) >= 5 else 0
+    return st, offset
+
+def main():
+    parser = argparse.ArgumentParser(description='Firmware update over UART')
+    parser.add_argument('image',  help='bank image (padded to 16 bytes)')
+    parser.add_argument('header', help='detached header created by sign_app.py')
+    parser.add_argument('-p', '--port', default='/dev/ttyACM0')
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('-v', '--version', type=int, default=1)
+    parser.add_argument('--no-swap', action='store_true', help='do not activate new bank')
+    parser.add_argument('--sim', metavar='EXE', help='update the host build (fw_secure_host) instead of a target')
+    args = parser.parse_args()
+
+    image  = open(args.image, 'rb').read()
+    header = open(args.header, 'rb').read()
+    if len(image) % 16:
+        sys.exit('Error: image size must be a multiple of 16')
+
+    if args.sim:
+        port = SimPort([args.sim])
+    else:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.05)
+    ch = Channel(port)
+
+    st, _ = status(ch.request(UPD_BEGIN, struct.pack('<II', len(image), args.version)))
+    if st:
+        sys.exit('Error: begin rejected (%d)' % st)
+
+    offset = 0
+    while offset < len(image):
+        chunk = image[offset:offset + CHUNK]
+        reply = ch.request(UPD_DATA, struct.pack('<I', offset) + chunk, timeout=2.0)
+        st, nxt = status(reply)
+        if st and nxt == offset:
+            sys.exit('Error: data rejected at %08X (%d)' % (offset, st))
+        # Resume from the offset expected by the target
+        offset = nxt
+        print('\r  %3d%%' % (offset * 100 // len(image)), end='', flush=True)
+    print('')
+
+    st, _ = status(ch.request(UPD_END, header, timeout=5.0))
+    if st:
+        sys.exit('Error: image rejected by target (%d)' % st)
+    print('  Image verified by target')
+    if not args.no_swap:
+        # Reply sent once the handovers are written and the banks swapped
+        st, _ = status(ch.request(UPD_SWAP, timeout=30.0, retry=1))
+        if st:
+            sys.exit('Error: banks not swapped, target reset (%d)' % st)
+        print('  Banks swapped, target reset')
+    port.close()
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/mem_check.py
+ # @brief Place object files into the memory regions of a linker script
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# Estimate of the usage of each memory region when no cross toolchain is
+# available. The sections of the objects (size -A) are assigned to output
+# sections with the input patterns of the linker script, the output sections
+# to regions with ">REGION" and "AT> REGION". The heap and stack reserved by
+# the script (_Min_Heap_Size, _Min_Stack_Size) are added to their region.
+# `make mem_check` builds the objects with the host compiler in ILP32 mode
+# (-m32, same size of types as the target) :
+#
+#   python3 scripts/mem_check.py main_secure/src/linker_s.ld build_mem/*.o
+#
+# Unused functions are counted (no --gc-sections) : the flash figure is an
+# upper bound of the real link for the same code size. The exit code is 1
+# when a region overflows or when the free flash is below --margin percent.
+#
+import argparse
+import fnmatch
+import re
+import subprocess
+import sys
+
+RE_REGION = re.compile(r'^\s*(\w+)\s*\([rwx]+\)\s*:\s*ORIGIN\s*=\s*([^,]+),\s*LENGTH\s*=\s*([^/\n]+)', re.M)
+RE_SECTION = re.compile(r'^\s*(\.[\w.]+|/DISCARD/)\s*(?:\(NOLOAD\))?\s*(?:0\s*)?:\s*\{(.*?)\}\s*(?:>\s*(\w+))?(?:\s*AT>\s*(\w+))?', re.M | re.S)
+RE_INPUT = re.compile(r'\*\s*\(\s*(?:SORT\s*\()?([^()]*)')
+RE_SYMBOL = re.compile(r'^\s*(\w+)\s*=\s*(0x[0-9a-fA-F]+|\d+)\s*;', re.M)
+
+def value(expr):
+    """Value of a constant expression of the script (K and M suffixes)"""
+    expr = re.sub(r'(\d+)\s*K\b', r'(\1*1024)', expr)
+    expr = re.sub(r'(\d+)\s*M\b', r'(\1*1048576)', expr)
+    return int(eval(expr, {'__builtins__': {}}))
+
+class Script:
+    """Memory regions and output sections of a linker script"""
+    def __init__(self, path):
+        text = re.sub(r'/\*.*?\*/', '', open(path).read(), flags=re.S)
+        self.regions = {}
+        for name, origin, length in RE_REGION.findall(text):
+            self.regions[name] = (value(origin), value(length))
+        symbols = {n: int(v, 0) for n, v in RE_SYMBOL.findall(text)}
+        # Output sections in script order : (patterns, region, load region)
+        self.sections = []
+        self.reserved = {}
+        for name, body, vma, lma in RE_SECTION.findall(text):
+            patterns = []
+            for group in RE_INPUT.findall(body):
+                patterns += group.split()
+            self.sections.append((name, patterns, vma, lma))
+            for sym, val in symbols.items():
+                if vma and re.search(r'\.\s*=\s*\.\s*\+\s*' + sym + r'\b', body):
+                    self.reserved[vma] = self.reserved.get(vma, 0) + val
+
+    def place(self, section):
+        """Regions used by an input section (the first matching pattern wins)"""
+        for name, patterns, vma, lma in self.sections:
+            for pat in patterns:
+                if fnmatch.fnmatchcase(section, pat):
+                    if name == '/DISCARD/':
+                        return []
+                    return [r for r in (vma, lma) if r]
+        return None
+
+def sections(objects):
+    """Allocated sections of the objects as (object, section, size)"""
+    out = subprocess.run(['size', '-A'] + objects, check=True,
+                         capture_output=True, text=True).stdout
+    obj = None
+    for line in out.splitlines():
+        m = re.match(r'^(\S+)\s*:$', line)
+        if m:
+            obj = m.group(1)
+            continue
+        f = line.split()
+        if len(f) == 3 and f[0].startswith('.') and f[1].isdigit():
+            if f[0].startswith(('.debug', '.comment', '.note', '.eh_frame', '.group')):
+                continue
+            yield obj, f[0], int(f[1])
+
+def main():
+    parser = argparse.ArgumentParser(description='Memory usage estimate')
+    parser.add_argument('script', help='linker script')
+    parser.add_argument('objects', nargs='+', help='object files')
+    parser.add_argument('--margin', type=int, default=5, help='free flash required (percent)')
+    parser.add_argument('--top', type=int, default=0, help='largest sections listed per region')
+    args = parser.parse_args()
+
+    ld = Script(args.script)
+    used = dict(ld.reserved)
+    items = {}
+    for obj, sect, size in sections(args.objects):
+        if size == 0:
+            continue
+        regions = ld.place(sect)
+        if regions is None:
+            print('  warning: %s %s not placed by the script' % (obj, sect))
+            continue
+        for r in regions:
+            used[r] = used.get(r, 0) + size
+            items.setdefault(r, []).append((size, sect, obj))
+
+    err = 0
+    print('  Memory region    Used Size  Region Size  %age Used')
+    for name, (origin, length) in ld.regions.items():
+        n = used.get(name, 0)
+        full = 0
+        print('  %12s: %10u B %10u B %9.2f%%' % (name, n, length, 100.0 * n / length))
+        if n > length:
+            print('    error: %s overflowed by %u bytes' % (name, n - length))
+            full = 1
+        elif name == 'FLASH' and (length - n) * 100 < length * args.margin:
+            print('    error: less than %u%% of FLASH left' % args.margin)
+            full = 1
+        if full or args.top:
+            for size, sect, obj in sorted(items.get(name, []), reverse=True)[:args.top or 8]:
+                print('    %8u  %-28s %s' % (size, sect, obj.split('/')[-1]))
+        err |= full
+    sys.exit(err)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/panel_config.py
+ # @brief Read or modify the configuration of a panel (option bytes, site)
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# Without option, the current configuration is printed. The changes given
+# on the command line are staged into the panel, then applied together
+# (one commit, one option bytes modification). Stage and commit frames are
+# signed with the OBK key (HMAC-SHA256), the same key file as sign_app.py.
+# A new product state can not be undone : it needs --confirm. See
+# doc/config.md.
+#
+import argparse
+import hashlib
+import hmac
+import socket
+import struct
+import sys
+
+from frame import Channel, SimPort
+
+CONFIG_STATUS = 0x30
+CONFIG_READ   = 0x31
+CONFIG_STAGE  = 0x32
+CONFIG_COMMIT = 0x33
+CONFIG_ABORT  = 0x34
+
+F_RESET   = 0x01
+F_CONFIRM = 0x02
+STATUS = {0x01: 'error', 0x02: 'bad argument', 0x03: 'bad state', 0x04: 'unknown',
+          0x10: 'generation changed', 0x11: 'value refused', 0x12: 'nothing staged',
+          0x13: 'bad MAC, wrong key', 0x14: 'product state not confirmed'}
+
+KEY_LEN = 32
+
+# Items : tag, type (wm, bool, state, u32, text, ip)
+ITEMS = {
+    'wm1':    (0x01, 'wm'),
+    'wm2':    (0x02, 'wm'),
+    'tz':     (0x03, 'bool'),
+    'state':  (0x04, 'state'),
+    'site':   (0x10, 'u32'),
+    'panel':  (0x11, 'u32'),
+    'name':   (0x12, 'text'),
+    'ip':     (0x13, 'ip'),
+    'server': (0x14, 'ip'),
+}
+STATES = {'open': 0xED, 'prov': 0x17, 'irot': 0x2E, 'tz-closed': 0xC6, 'closed': 0x72}
+
+def encode(name, text):
+    """Encode an item given as text, an empty text removes a site item"""
+    tag, kind = ITEMS[name]
+    if text == '':
+        val = b''
+    elif kind == 'wm':
+        first, last = text.split(',')
+        val = bytes([int(first, 0), int(last, 0)])
+    elif kind == 'bool':
+        val = bytes([1 if text in ('1', 'on', 'yes') else 0])
+    elif kind == 'state':
+        val = bytes([STATES[text] if text in STATES else int(text, 0)])
+    elif kind == 'u32':
+        val = struct.pack('<I', int(text, 0))
+    elif kind == 'ip':
+        val = struct.pack('<I', struct.unpack('>I', socket.inet_aton(text))[0])
+    else:
+        val = text.encode('ascii')
+    return bytes([tag, len(val)]) + val
+
+def decode(tag, val):
+    """Item as (name, text)"""
+    for name, (t, kind) in ITEMS.items():
+        if t != tag:
+            continue
+        if not val:
+            return name, '(not set)'
+        if kind == 'wm':
+            return name, '%u,%u' % (val[0], val[1])
+        if kind == 'bool':
+            return name, 'on' if val[0] else 'off'
+        if kind == 'state':
+            names = [n for n, v in STATES.items() if v == val[0]]
+            return name, names[0] if names else '0x%02X' % val[0]
+        if kind == 'u32':
+            return name, '%u' % struct.unpack('<I', val)[0]
+        if kind == 'ip':
+            return name, socket.inet_ntoa(struct.pack('>I', struct.unpack('<I', val)[0]))
+        return name, val.decode('ascii', 'replace')
+    return '0x%02X' % tag, val.hex()
+
+def sign(key, tag, gen, chain, data):
+    return hmac.new(key, tag + struct.pack('<I', gen) + chain + data, hashlib.sha256).digest()
+
+def request(ch, ftype, payload=b''):
+    data = ch.request(ftype, payload, timeout=2.0)
+    st, gen, info = struct.unpack_from('<BII', data)
+    return st, gen, info, data[9:]
+
+def show(ch):
+    st, gen, staged, items = request(ch, CONFIG_READ)
+    print('  Panel : generation %u, %u items staged' % (gen, staged))
+    pos = 0
+    while pos + 2 <= len(items):
+        tag, n = items[pos], items[pos + 1]
+        name, text = decode(tag, items[pos + 2:pos + 2 + n])
+        print('    %-7s %s' % (name, text))
+        pos += 2 + n
+    return gen
+
+def main():
+    parser = argparse.ArgumentParser(description='Panel configuration')
+    parser.add_argument('-p', '--port', default='/dev/ttyACM0')
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('--set', metavar='ITEM=VALUE', action='append', default=[],
+                        help='site item (%s), empty value to remove it' %
+                             ', '.join(n for n, (t, _) in ITEMS.items() if t >= 0x10))
+    parser.add_argument('--wm1', metavar='FIRST,LAST', help='secure sectors of bank 1')
+    parser.add_argument('--wm2', metavar='FIRST,LAST', help='secure sectors of bank 2')
+    parser.add_argument('--tz', choices=['on', 'off'], help='TrustZone (TZEN)')
+    parser.add_argument('--state', choices=list(STATES), help='product state (no way back, needs --confirm)')
+    parser.add_argument('--confirm', action='store_true', help='confirm the change of the product state')
+    parser.add_argument('--reset', action='store_true', help='reset the panel after the commit')
+    parser.add_argument('-k', '--key', help='raw key file (32 bytes), needed for the changes')
+    parser.add_argument('--sim', metavar='EXE', help='use the host build (fw_secure_host) instead of a target')
+    args = parser.parse_args()
+
+    tlv = b''
+    try:
+        for item in args.set:
+            name, _, text = item.partition('=')
+            if name not in ITEMS or ITEMS[name][0] < 0x10:
+                parser.error('unknown site item "%s"' % name)
+            tlv += encode(name, text)
+        for name in ('wm1', 'wm2', 'tz', 'state'):
+            if getattr(args, name) is not None:
+                tlv += encode(name, getattr(args, name))
+    except (ValueError, OSError):
+        parser.error('bad value')
+    if tlv and not args.key:
+        parser.error('a key is required to modify the panel')
+    if args.state and not args.confirm:
+        parser.error('the product state can not be set back, add --confirm')
+    key = None
+    if args.key:
+        with open(args.key, 'rb') as f:
+            key = f.read()
+        if len(key) != KEY_LEN:
+            sys.exit('Error: key must be %d bytes long' % KEY_LEN)
+
+    if args.sim:
+        port = SimPort([args.sim], {'SIM_KEY': args.key} if args.key else None)
+    else:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.05)
+    ch = Channel(port)
+
+    gen = show(ch)
+    if tlv:
+        # Restart the chain of the stages (left by another tool)
+        request(ch, CONFIG_ABORT)
+        mac = sign(key, b'CFGS', gen, bytes(32), tlv)
+        st, gen, info, _ = request(ch, CONFIG_STAGE, tlv + mac)
+        if st:
+            request(ch, CONFIG_ABORT)
+            sys.exit('Error: %s (item 0x%02X)' % (STATUS.get(st, '%02X' % st), info))
+        flags = (F_RESET if args.reset else 0) | (F_CONFIRM if args.confirm else 0)
+        st, gen, info, _ = request(ch, CONFIG_COMMIT, struct.pack('<IB', gen, flags) +
+                                   sign(key, b'CFGC', gen, mac, bytes([flags])))
+        if st:
+            request(ch, CONFIG_ABORT)
+            sys.exit('Error: commit refused (%s)' % STATUS.get(st, '%02X' % st))
+        print('  Committed, generation %u' % gen)
+        if not args.reset:
+            show(ch)
+    port.close()
+
+if __name__ == '__main__':
+    main()
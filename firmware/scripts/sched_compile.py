@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/sched_compile.py
+ # @brief Compile access schedules into the binary blob used by the firmware
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# Input is a JSON file :
+#
+#   {
+#     "base": "2024-01-01", "days": 731,
+#     "calendars": { "fr": ["2024-05-01", {"from": "2024-08-05", "to": "2024-08-16"}] },
+#     "schedules": [
+#       { "name": "office", "calendar": "fr",
+#         "week": { "mon-fri": ["08:00-12:30", "13:30-18:00"], "sat": ["09:00-12:00"] },
+#         "holiday": [] }
+#     ]
+#   }
+#
+# Times must be aligned on 15 minutes, "24:00" is the end of the day. The
+# index of a schedule (used by credentials) is its position into the list.
+# See main_secure/src/sched.h for the binary format.
+#
+import argparse
+import datetime
+import json
+import struct
+import sys
+
+MAGIC    = 0x44484353
+VERSION  = 1
+SLOTS    = 96
+ROWS     = 8
+REC_SIZE = 4 + (ROWS * SLOTS // 8)
+MAX_SIZE = 0x2000
+EPOCH    = datetime.date(2000, 1, 1)
+DAYS     = ['mon', 'tue', 'wed', 'thu', 'fri', 'sat', 'sun']
+
+def crc32_stm(data):
+    """CRC-32 computed like the STM32 CRC unit (32 bits words, MSB first)"""
+    crc = 0xFFFFFFFF
+    for (w,) in struct.iter_unpack('<I', data):
+        crc ^= w
+        for _ in range(32):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else (crc << 1)
+            crc &= 0xFFFFFFFF
+    return crc
+
+def day_number(text):
+    return (datetime.date.fromisoformat(text) - EPOCH).days
+
+def slot(text, end=False):
+    hh, mm = [int(x) for x in text.split(':')]
+    minutes = hh * 60 + mm
+    if (minutes % 15) or minutes > 1440 or (minutes == 1440 and not end):
+        raise ValueError('time %s is not aligned on 15 minutes' % text)
+    return minutes // 15
+
+def day_rows(spec):
+    """Convert "mon-fri" or "sat,sun" into a list of rows"""
+    rows = []
+    for part in spec.split(','):
+        part = part.strip().lower()
+        if part == 'all':
+            rows += range(7)
+        elif '-' in part:
+            a, b = part.split('-')
+            rows += range(DAYS.index(a), DAYS.index(b) + 1)
+        else:
+            rows.append(DAYS.index(part))
+    return rows
+
+def fill(bits, row, ranges):
+    for r in ranges:
+        start, end = r.split('-')
+        for s in range(slot(start), slot(end, True)):
+            bits[row * SLOTS + s] = 1
+
+def pack_bits(bits):
+    words = []
+    for i in range(0, len(bits), 32):
+        w = 0
+        for j, b in enumerate(bits[i:i + 32]):
+            w |= b << j
+        words.append(w)
+    return struct.pack('<%dI' % len(words), *words)
+
+def compile_sched(cfg):
+    base = day_number(cfg['base'])
+    days = int(cfg['days'])
+    cal_names = list(cfg.get('calendars', {}).keys())
+
+    blob = b''
+    for name in cal_names:
+        bits = [0] * (((days + 31) // 32) * 32)
+        for entry in cfg['calendars'][name]:
+            if isinstance(entry, dict):
+                first, last = day_number(entry['from']), day_number(entry['to'])
+            else:
+                first = last = day_number(entry)
+            for d in range(first, last + 1):
+                if 0 <= d - base < days:
+                    bits[d - base] = 1
+        blob += pack_bits(bits)
+
+    ids = []
+    for sched in cfg['schedules']:
+        cal = sched.get('calendar')
+        index = cal_names.index(cal) if cal else 0xFF
+        bits = [0] * (ROWS * SLOTS)
+        for spec, ranges in sched.get('week', {}).items():
+            for row in day_rows(spec):
+                fill(bits, row, ranges)
+        fill(bits, 7, sched.get('holiday', []))
+        blob += struct.pack('<I', index) + pack_bits(bits)
+        ids.append(sched['name'])
+
+    hdr = struct.pack('<IHHHHIII8x', MAGIC, VERSION, len(ids), len(cal_names),
+                      days, base, len(blob), crc32_stm(blob))
+    return hdr + blob, ids
+
+def main():
+    parser = argparse.ArgumentParser(description='Compile access schedules')
+    parser.add_argument('input', help='schedules description (JSON)')
+    parser.add_argument('-o', '--output', required=True, help='output blob (binary)')
+    args = parser.parse_args()
+
+    with open(args.input) as f:
+        cfg = json.load(f)
+    try:
+        blob, ids = compile_sched(cfg)
+    except (ValueError, KeyError) as e:
+        sys.exit('Error: %s' % e)
+    if len(blob) > MAX_SIZE:
+        sys.exit('Error: %d bytes, does not fit into flash sector' % len(blob))
+    with open(args.output, 'wb') as f:
+        f.write(blob)
+    for i, name in enumerate(ids):
+        print('  %3d %s' % (i, name))
+    print('  [SCHED] %s (%d bytes)' % (args.output, len(blob)))
+
+if __name__ == '__main__':
+    main()
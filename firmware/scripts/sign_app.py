@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/sign_app.py
+ # @brief Append a signed header to the non-secure application image
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# The image is padded to a multiple of 16 bytes (flash quad-word) and the
+# final size is written into a reserved entry of the vector table (offset
+# 0x20). The header (see main_secure/src/boot.h) is then appended :
+#
+#   u32 magic    "CKAC"
+#   u32 version
+#   u32 size     size of the image, without header
+#   u32 flags
+#   u8  digest   SHA-256 of the image
+#   u8  mac      HMAC-SHA256 of the 48 previous bytes, using the OBK key
+#
+# With --detached, the image is not modified (except padding) and the header
+# is written into a separate file, this is used for full bank images sent
+# to the update engine (see fw_update.py).
+#
+import argparse
+import hashlib
+import hmac
+import struct
+import sys
+
+MAGIC      = 0x43414B43
+SIZE_OFFS  = 0x20
+KEY_LEN    = 32
+
+def pad(image):
+    # Pad to flash quad-word
+    if len(image) % 16:
+        image += b'\xFF' * (16 - (len(image) % 16))
+    return bytearray(image)
+
+def header(image, key, version, flags=0):
+    digest = hashlib.sha256(image).digest()
+    hdr = struct.pack('<IIII', MAGIC, version, len(image), flags) + digest
+    mac = hmac.new(key, hdr, hashlib.sha256).digest()
+    return hdr + mac
+
+def sign(image, key, version, flags=0):
+    image = pad(image)
+    struct.pack_into('<I', image, SIZE_OFFS, len(image))
+    return bytes(image) + header(image, key, version, flags)
+
+def main():
+    parser = argparse.ArgumentParser(description='Sign the non-secure application image')
+    parser.add_argument('image',  help='input binary (fw_app.bin)')
+    parser.add_argument('-k', '--key', required=True, help='raw key file (32 bytes)')
+    parser.add_argument('-o', '--output', help='output file (default: overwrite input)')
+    parser.add_argument('-v', '--version', type=int, default=1, help='image version')
+    parser.add_argument('-d', '--detached', metavar='HDR', help='write header into a separate file')
+    args = parser.parse_args()
+
+    with open(args.key, 'rb') as f:
+        key = f.read()
+    if len(key) != KEY_LEN:
+        sys.exit('Error: key must be %d bytes long' % KEY_LEN)
+    with open(args.image, 'rb') as f:
+        image = f.read()
+    if len(image) < 0x100:
+        sys.exit('Error: image too small')
+
+    if args.detached:
+        image = pad(image)
+        with open(args.output or args.image, 'wb') as f:
+            f.write(image)
+        with open(args.detached, 'wb') as f:
+            f.write(header(image, key, args.version))
+        print('  [SIGN] %s (detached header %s)' % (args.output or args.image, args.detached))
+        return
+
+    signed = sign(image, key, args.version)
+    with open(args.output or args.image, 'wb') as f:
+        f.write(signed)
+    print('  [SIGN] %s (%d bytes + header)' % (args.output or args.image, len(signed) - 80))
+
+if __name__ == '__main__':
+    main()
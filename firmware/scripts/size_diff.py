@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/size_diff.py
+ # @brief Compare the size of functions and objects between two builds
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# Sizes are read from the map files written by the linker (-Wl,-Map). With
+# -ffunction-sections each function is an input section (.text.<name>), so
+# the report is per function; other sections (.data, .bss, .rodata) are
+# reported per object file. The Makefiles keep the map of the previous
+# link (<target>.prev.map) and call this script after each link.
+#
+#   python3 scripts/size_diff.py fw_secure.prev.map fw_secure.map
+#   python3 scripts/size_diff.py --limit 512 old.map new.map
+#
+# Sections are counted as flash or RAM with the memory regions of the map
+# (regions without write access are flash, initialized data uses both).
+# The exit code is 1 when flash usage grows by more than --limit.
+#
+import argparse
+import os
+import re
+import sys
+
+# Output sections not loaded into the target
+SKIP = ('.debug', '.comment', '.ARM.attributes', '.note', '.stab', '.gnu')
+# Input section names that do not name a function or an object
+GENERIC = ('.text', '.data', '.bss', '.rodata', 'COMMON', '.glue_7', '.glue_7t',
+           '.vfp11_veneer', '.v4_bx', '.iplt', '.rel.iplt', '.igot.plt')
+
+RE_MEM = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(\S*)$')
+RE_OUT = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?')
+RE_LMA = re.compile(r'load address 0x([0-9a-fA-F]+)')
+RE_IN  = re.compile(r'^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$')
+RE_IN1 = re.compile(r'^ (\S+)$')
+RE_IN2 = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$')
+
+def objname(path):
+    """Short name of an object file : archive member, or 'lto' for LTO units"""
+    path = path.strip()
+    if 'ltrans' in path:
+        return 'lto'
+    m = re.match(r'.*\((.+)\)$', path)
+    if m:
+        return m.group(1)
+    return os.path.basename(path)
+
+class Map:
+    """Content of a map file : memory regions, output sections, symbols"""
+    def __init__(self, name):
+        self.regions  = [] # (origin, end, is_flash)
+        self.sections = {} # name -> (size, flash bytes, ram bytes)
+        self.symbols  = {} # name -> size
+        self.load(name)
+
+    def region(self, addr):
+        for origin, end, flash in self.regions:
+            if origin <= addr < end:
+                return 'flash' if flash else 'ram'
+        return None
+
+    def section(self, name, vma, size, lma):
+        """Record an output section, with the memory it uses"""
+        if name.startswith(SKIP) or vma == 0:
+            return False
+        flash = ram = 0
+        if not self.regions:
+            flash = size
+        else:
+            if self.region(vma) == 'flash':
+                flash = size
+            elif self.region(vma) == 'ram':
+                ram = size
+            # Initialized data : copied from flash at startup
+            if (lma is not None) and self.region(lma) == 'flash':
+                flash = size
+        self.sections[name] = (size, flash, ram)
+        return True
+
+    def load(self, name):
+        symbols = self.symbols
+        out = None
+        out_pending = None
+        pending = None
+        started = False
+        memory = False
+        f = open(name, 'r', errors='replace')
+        for line in f:
+            line = line.rstrip('\n')
+            if not started:
+                if line.startswith('Memory Configuration'):
+                    memory = True
+                m = RE_MEM.match(line)
+                if memory and m and m.group(1) != '*default*':
+                    origin = int(m.group(2), 16)
+                    self.regions.append((origin, origin + int(m.group(3), 16),
+                                         'w' not in m.group(4)))
+                started = line.startswith('Linker script and memory map')
+                continue
+            m = RE_OUT.match(line)
+            if m:
+                out = m.group(1)
+                lma = int(m.group(4), 16) if m.group(4) else None
+                if not self.section(out, int(m.group(2), 16), int(m.group(3), 16), lma):
+                    out = None
+                out_pending = None
+                pending = None
+                continue
+            if line and not line[0].isspace():
+                # Output section with a long name (address on next line),
+                # or the end of the memory map
+                out = None
+                out_pending = line.split()[0] if line.startswith('.') else None
+                pending = None
+                continue
+            if out_pending:
+                m = RE_IN2.match(line)
+                if m:
+                    lma = RE_LMA.search(m.group(3))
+                    lma = int(lma.group(1), 16) if lma else None
+                    if self.section(out_pending, int(m.group(1), 16), int(m.group(2), 16), lma):
+                        out = out_pending
+                out_pending = None
+                continue
+            if out is None:
+                continue
+            m = RE_IN.match(line)
+            if m:
+                sect, size, obj = m.group(1), int(m.group(3), 16), m.group(4)
+            else:
+                # Long input section names are alone on their line
+                m = RE_IN1.match(line)
+                if m and not m.group(1).startswith('*'):
+                    pending = m.group(1)
+                    continue
+                m = RE_IN2.match(line)
+                if not (m and pending):
+                    pending = None
+                    continue
+                sect, size, obj = pending, int(m.group(2), 16), m.group(3)
+                pending = None
+            if sect.startswith('*') or size == 0:
+                continue
+            if sect in GENERIC:
+                key = '%s (%s)' % (sect, objname(obj))
+            else:
+                key = sect
+            symbols[key] = symbols.get(key, 0) + size
+        f.close()
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare sizes of two linker map files')
+    parser.add_argument('old', help='map file of the previous build')
+    parser.add_argument('new', help='map file of the current build')
+    parser.add_argument('-n', '--count', type=int, default=20, help='number of changes listed (default 20)')
+    parser.add_argument('-a', '--all', action='store_true', help='list all changes')
+    parser.add_argument('-l', '--limit', type=int, help='maximum growth allowed (bytes)')
+    args = parser.parse_args()
+
+    old = Map(args.old)
+    new = Map(args.new)
+
+    print('Size diff : %s -> %s' % (args.old, args.new))
+    print('  %-28s %8s %8s %8s' % ('section', 'before', 'after', 'delta'))
+    flash = [0, 0]
+    ram   = [0, 0]
+    for name in sorted(set(old.sections) | set(new.sections)):
+        a = old.sections.get(name, (0, 0, 0))
+        b = new.sections.get(name, (0, 0, 0))
+        for i, m in enumerate((a, b)):
+            flash[i] += m[1]
+            ram[i]   += m[2]
+        if (a[0] != b[0]) or (args.all and b[0]):
+            print('  %-28s %8d %8d %+8d' % (name, a[0], b[0], b[0] - a[0]))
+
+    changes = []
+    for name in set(old.symbols) | set(new.symbols):
+        a = old.symbols.get(name, 0)
+        b = new.symbols.get(name, 0)
+        if a != b:
+            changes.append((abs(b - a), name, a, b))
+    changes.sort(key=lambda c: (-c[0], c[1]))
+    if changes:
+        print('  %-28s %8s %8s %8s' % ('symbol', 'before', 'after', 'delta'))
+        shown = changes if args.all else changes[:args.count]
+        for _, name, a, b in shown:
+            if len(name) > 28:
+                name = name[:27] + '~'
+            print('  %-28s %8d %8d %+8d' % (name, a, b, b - a))
+        if len(shown) < len(changes):
+            print('  ... %d more (--all)' % (len(changes) - len(shown)))
+    print('  %d symbols changed, flash %d -> %d (%+d), ram %d -> %d (%+d)' %
+          (len(changes), flash[0], flash[1], flash[1] - flash[0], ram[0], ram[1], ram[1] - ram[0]))
+
+    if (args.limit is not None) and (flash[1] - flash[0] > args.limit):
+        print('Error: flash grows by %d bytes (limit %d)' % (flash[1] - flash[0], args.limit))
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/svd_gen.py
+ # @brief Generate register field accessors from a CMSIS-SVD description
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# For each register a value type is generated, it holds the bits to write
+# (v) and the mask of modified fields (m). Field setters can be chained and
+# are folded by the compiler, so a single write (or a single read-modify-write)
+# is done for any number of fields :
+#
+#   spi_cfg1_t r = spi_cfg1_mbr(spi_cfg1_dsize(spi_cfg1(), 7), 7);
+#   spi_cfg1_wr(SPI4, r);      // write the whole register
+#   spi_cfg1_modify(SPI4, r);  // only update MBR and DSIZE
+#
+# Each register has its own type, so a value can not be written into
+# another register by mistake.
+#
+#   python3 scripts/svd_gen.py scripts/svd/STM32H563_subset.svd \
+#           -p SPI4 -p USART3 -p GPIOA -p RCC -o main_secure/src/regs.h
+#
+import argparse
+import sys
+import xml.etree.ElementTree as ET
+
+HEADER = '''/**
+ * @file  regs.h
+ * @brief Register field accessors (generated by scripts/svd_gen.py)
+ *
+ * This file is generated from %s, do not edit.
+ *
+ * @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ * @copyright Agilack (c) 2023
+ *
+ * @page License
+ * Cowkeyr-AC firmware is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 3 as published by the Free Software Foundation. You should have
+ * received a copy of the GNU Lesser General Public License along with this
+ * program, see LICENSE.md file for more details.
+ * This program is distributed WITHOUT ANY WARRANTY.
+ */
+#ifndef REGS_H
+#define REGS_H
+#include "hardware.h"
+#include "types.h"
+'''
+
+def text(node, tag, default=None):
+    child = node.find(tag)
+    if child is None or child.text is None:
+        return default
+    return ' '.join(child.text.split())
+
+def number(value):
+    return int(value, 0)
+
+def field_range(f):
+    """Return (offset, width) of a field, whatever the SVD notation"""
+    if f.find('bitOffset') is not None:
+        return number(text(f, 'bitOffset')), number(text(f, 'bitWidth', '1'))
+    if f.find('lsb') is not None:
+        lsb = number(text(f, 'lsb'))
+        return lsb, number(text(f, 'msb')) - lsb + 1
+    msb, lsb = text(f, 'bitRange').strip('[]').split(':')
+    return int(lsb), int(msb) - int(lsb) + 1
+
+def find_periph(root, name):
+    """Find a peripheral, follow derivedFrom to get its registers"""
+    for p in root.iter('peripheral'):
+        if text(p, 'name') == name:
+            if p.get('derivedFrom'):
+                return find_periph(root, p.get('derivedFrom'))
+            return p
+    sys.exit('Error: peripheral %s not found' % name)
+
+def gen_register(out, prefix, reg):
+    name  = text(reg, 'name')
+    t     = '%s_%s' % (prefix, name.lower())
+    up    = t.upper()
+    off   = number(text(reg, 'addressOffset'))
+    desc  = text(reg, 'description', '')
+    out.append('')
+    out.append('/* %s : %s */' % (name, desc))
+    out.append('typedef struct { u32 v; u32 m; } %s_t;' % t)
+    out.append('static inline %s_t %s(void) { %s_t r = { 0, 0 }; return r; }' % (t, t, t))
+    out.append('static inline %s_t %s_rd(u32 base) { %s_t r = { reg_rd(base + 0x%02X), 0 }; return r; }' % (t, t, t, off))
+    out.append('static inline void %s_wr(u32 base, %s_t r) { reg_wr(base + 0x%02X, r.v); }' % (t, t, off))
+    out.append('static inline void %s_modify(u32 base, %s_t r) { reg_wr(base + 0x%02X, (reg_rd(base + 0x%02X) & ~r.m) | r.v); }' % (t, t, off, off))
+    fields = reg.find('fields')
+    if fields is None:
+        return
+    for f in fields.iter('field'):
+        fname = text(f, 'name')
+        pos, width = field_range(f)
+        mask = ((1 << width) - 1) << pos
+        fn = '%s_%s' % (t, fname.lower())
+        out.append('#define %s_%s_Pos %d' % (up, fname, pos))
+        out.append('#define %s_%s_Msk 0x%08Xu' % (up, fname, mask))
+        out.append('static inline %s_t %s(%s_t r, u32 v) { r.v = (r.v & ~0x%08Xu) | ((v << %d) & 0x%08Xu); r.m |= 0x%08Xu; return r; }'
+                   % (t, fn, t, mask, pos, mask, mask))
+        out.append('static inline u32 %s_get(%s_t r) { return (r.v & 0x%08Xu) >> %d; }' % (fn, t, mask, pos))
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate register field accessors from SVD')
+    parser.add_argument('svd', help='CMSIS-SVD file')
+    parser.add_argument('-p', '--periph', action='append', required=True,
+                        help='peripheral to export, optionally with a list of registers (SPI4:CR1,SR)')
+    parser.add_argument('-o', '--output', help='output header (default: stdout)')
+    args = parser.parse_args()
+
+    root = ET.parse(args.svd).getroot()
+    out = [HEADER % args.svd.split('/')[-1]]
+    for spec in args.periph:
+        name, _, regs = spec.partition(':')
+        p = find_periph(root, name)
+        prefix = (text(p, 'groupName') or text(p, 'name')).lower()
+        out.append('/* ' + '-' * 74 + ' */')
+        out.append('/* %-74s */' % ('%s : %s' % (prefix.upper(), text(p, 'description', ''))))
+        out.append('/* ' + '-' * 74 + ' */')
+        wanted = regs.split(',') if regs else None
+        for reg in p.find('registers').iter('register'):
+            if wanted and text(reg, 'name') not in wanted:
+                continue
+            gen_register(out, prefix, reg)
+        out.append('')
+    out.append('#endif')
+
+    data = '\n'.join(out) + '\n'
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(data)
+    else:
+        sys.stdout.write(data)
+
+if __name__ == '__main__':
+    main()
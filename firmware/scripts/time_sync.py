@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/time_sync.py
+ # @brief Read or set the wall-clock of the target (RTC)
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# The target counts seconds since 2000-01-01 00:00:00 UTC (system frame
+# 0x02, see main_secure/src/frame.c). Without --set, the clock of the
+# target is only read and compared with the host one. A set is signed with
+# the OBK key (HMAC-SHA256 over "TIME", the challenge given by the last read
+# and the time), the same key file as sign_app.py.
+#
+import argparse
+import datetime
+import hashlib
+import hmac
+import struct
+import sys
+import time
+
+from frame import Channel, SimPort
+
+SYS_TIME   = 0x02
+EPOCH_2000 = 946684800
+KEY_LEN    = 32
+STATUS = {0x01: 'bad signature', 0x02: 'bad argument', 0x03: 'no challenge'}
+
+def read(ch, payload=b''):
+    """Request the clock : status, seconds, valid, challenge"""
+    reply = ch.request(SYS_TIME, payload)
+    if len(reply) < 10:
+        sys.exit('Error: request rejected')
+    return struct.unpack_from('<BIBI', reply)
+
+def main():
+    parser = argparse.ArgumentParser(description='Read or set the target clock')
+    parser.add_argument('-p', '--port', default='/dev/ttyACM0')
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('-s', '--set', action='store_true', help='set target clock to host time (UTC)')
+    parser.add_argument('-k', '--key', help='raw key file (32 bytes), needed by --set')
+    parser.add_argument('--sim', metavar='EXE', help='use the host build (fw_secure_host) instead of a target')
+    args = parser.parse_args()
+
+    key = None
+    if args.set:
+        if not args.key:
+            parser.error('--set needs the key (--key)')
+        with open(args.key, 'rb') as f:
+            key = f.read()
+        if len(key) != KEY_LEN:
+            sys.exit('Error: key must be %d bytes long' % KEY_LEN)
+
+    if args.sim:
+        port = SimPort([args.sim], {'SIM_KEY': args.key} if args.key else None)
+    else:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.05)
+    ch = Channel(port)
+
+    st, sec, valid, challenge = read(ch)
+    if args.set:
+        now = struct.pack('<I', int(time.time()) - EPOCH_2000)
+        mac = hmac.new(key, b'TIME' + struct.pack('<I', challenge) + now, hashlib.sha256).digest()
+        st, sec, valid, challenge = read(ch, now + mac)
+        if st:
+            sys.exit('Error: %s' % STATUS.get(st, 'status %02X' % st))
+    date = datetime.datetime.fromtimestamp(sec + EPOCH_2000, datetime.timezone.utc)
+    print('  Target: %s%s' % (date.strftime('%Y-%m-%d %H:%M:%S'), '' if valid else ' (not set)'))
+    print('  Drift : %+d s' % (sec + EPOCH_2000 - int(time.time())))
+    port.close()
+
+if __name__ == '__main__':
+    main()
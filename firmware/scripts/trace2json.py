@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+##
+ # @file  scripts/trace2json.py
+ # @brief Convert a dump of the trace buffer to Chrome/Perfetto trace JSON
+ #
+ # @author Saint-Genest Gwenael <gwen@cowlab.fr>
+ # @copyright Agilack (c) 2023
+ #
+ # @page License
+ # Cowkeyr-ac firmware is free software: you can redistribute it and/or
+ # modify it under the terms of the GNU Lesser General Public License
+ # version 3 as published by the Free Software Foundation. You should have
+ # received a copy of the GNU Lesser General Public License along with this
+ # program, see LICENSE.md file for more details.
+ # This program is distributed WITHOUT ANY WARRANTY.
+##
+#
+# The dump is written by the debugger (scripts/trace.gdb) or by the host
+# build (SIM_TRACE). The output can be opened with ui.perfetto.dev or
+# chrome://tracing. Names of the trace points are read from the TRACE_ID_*
+# definitions of main_secure/src/trace.h.
+#
+#   python3 scripts/trace2json.py trace.bin -o trace.json
+#   python3 scripts/trace2json.py --text trace.bin
+#
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+MAGIC = 0x45435254
+HDR   = '<8I'
+TYPES = ('enter', 'exit', 'mark', 'count')
+WORLD = ('secure', 'non-secure')
+
+def load_ids(name):
+    """Read names of trace points from trace.h : id -> name"""
+    ids = {}
+    try:
+        f = open(name, 'r')
+    except OSError:
+        return ids
+    for line in f:
+        m = re.match(r'#define\s+TRACE_ID_(\w+)\s+(0x[0-9a-fA-F]+|\d+)', line)
+        if m and m.group(1) != 'MAX':
+            ids[int(m.group(2), 0)] = m.group(1).lower()
+    f.close()
+    return ids
+
+def load(name):
+    """Read a dump, return (frequency, events) with events in ring order"""
+    data = open(name, 'rb').read()
+    if len(data) < struct.calcsize(HDR):
+        raise ValueError('file too short')
+    magic, head, stop, freq, size = struct.unpack_from(HDR, data)[:5]
+    if magic != MAGIC:
+        raise ValueError('bad magic (trace buffer not initialized ?)')
+    if len(data) < 32 + (size * 8):
+        raise ValueError('file too short for %d events' % size)
+    first = head - size if head > size else 0
+    events = []
+    for n in range(first, head):
+        time, info = struct.unpack_from('<2I', data, 32 + ((n % size) * 8))
+        events.append((time, info))
+    return freq, events
+
+def unwrap(events):
+    """Extend the 32 bits timestamps, events may be slightly out of order"""
+    result = []
+    prev = None
+    base = 0
+    for time, info in events:
+        if prev is not None:
+            delta = (time - prev) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            base += delta
+        prev = time
+        result.append((base, info))
+    return result
+
+def convert(freq, events, ids):
+    """Build the list of Chrome trace events"""
+    out = []
+    for world in range(2):
+        out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': world,
+                    'args': {'name': WORLD[world]}})
+    depth = [{}, {}]
+    for time, info in sorted(unwrap(events), key=lambda e: e[0]):
+        kind  = (info >> 30) & 3
+        world = (info >> 29) & 1
+        ident = (info >> 16) & 0x1FFF
+        arg   = info & 0xFFFF
+        name  = ids.get(ident, 'id_%d' % ident)
+        ev = {'name': name, 'pid': 0, 'tid': world, 'ts': time * 1000000.0 / freq}
+        if kind == 0:
+            depth[world][ident] = depth[world].get(ident, 0) + 1
+            ev['ph'] = 'B'
+        elif kind == 1:
+            # Beginning overwritten by newer events
+            if depth[world].get(ident, 0) == 0:
+                continue
+            depth[world][ident] -= 1
+            ev['ph'] = 'E'
+        elif kind == 2:
+            ev['ph'] = 'i'
+            ev['s']  = 't'
+            ev['args'] = {'arg': arg}
+        else:
+            ev['ph'] = 'C'
+            ev['args'] = {name: arg}
+        out.append(ev)
+    return out
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert a trace buffer dump to trace JSON')
+    parser.add_argument('dump', help='dump of the trace buffer (trace.gdb or SIM_TRACE)')
+    parser.add_argument('-o', '--output', help='JSON file (default stdout)')
+    parser.add_argument('-i', '--ids', help='header with TRACE_ID_* definitions')
+    parser.add_argument('-f', '--freq', type=int, help='frequency of the counter (Hz), overrides the dump')
+    parser.add_argument('-t', '--text', action='store_true', help='list events as text')
+    args = parser.parse_args()
+
+    ids_file = args.ids
+    if ids_file is None:
+        ids_file = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'main_secure', 'src', 'trace.h')
+    ids = load_ids(ids_file)
+    try:
+        freq, events = load(args.dump)
+    except (OSError, ValueError) as e:
+        print('Error: %s : %s' % (args.dump, e), file=sys.stderr)
+        sys.exit(1)
+    if args.freq:
+        freq = args.freq
+    if freq == 0:
+        print('Error: unknown counter frequency, use --freq', file=sys.stderr)
+        sys.exit(1)
+
+    if args.text:
+        for time, info in unwrap(events):
+            print('%12.3f us  %-5s %-10s %-20s %d' % (time * 1000000.0 / freq,
+                  TYPES[(info >> 30) & 3], WORLD[(info >> 29) & 1],
+                  ids.get((info >> 16) & 0x1FFF, 'id_%d' % ((info >> 16) & 0x1FFF)),
+                  info & 0xFFFF))
+        return
+
+    result = {'traceEvents': convert(freq, events, ids), 'displayTimeUnit': 'ns'}
+    if args.output:
+        f = open(args.output, 'w')
+        json.dump(result, f)
+        f.close()
+        print('%d events written to %s' % (len(events), args.output))
+    else:
+        json.dump(result, sys.stdout)
+
+if __name__ == '__main__':
+    main()